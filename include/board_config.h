@@ -32,6 +32,15 @@
     #define dbg(...) (void)0
 #endif
 
+// Hot-path tracing (src/stats/trace.h): cycle-count timestamps along the
+// job and share paths, dumped as histograms by the "trace" serial command
+#ifndef HOT_PATH_TRACE
+    #define HOT_PATH_TRACE 0
+#endif
+#ifndef TRACE_RING_SIZE
+    #define TRACE_RING_SIZE 256     // Events kept per core (power of two)
+#endif
+
 // ============================================================
 // ESP32-2432S028R - Cheap Yellow Display 2.8"
 // ============================================================
@@ -77,6 +86,22 @@
     #endif
     #define BUTTON_ACTIVE_LOW 1
 
+    // Power sensor on the CN1 connector (GPIO 21 drives the backlight)
+    #ifndef POWER_SDA_PIN
+        #define POWER_SDA_PIN 27
+        #define POWER_SCL_PIN 22
+    #endif
+
+    // Governor: usually in a closed case behind the panel; backlight in the draw
+    #ifndef GOVERNOR_TEMP_HOT_C
+        #define GOVERNOR_TEMP_HOT_C 70
+    #endif
+    #ifndef GOVERNOR_MW_80
+        #define GOVERNOR_MW_80  400
+        #define GOVERNOR_MW_160 450
+        #define GOVERNOR_MW_240 530
+    #endif
+
     // SHA Implementation: Defined in platformio.ini (USE_HARDWARE_SHA=1)
 
 // ============================================================
@@ -248,6 +273,11 @@
     #endif
     #define BUTTON_ACTIVE_LOW 1
 
+    // Governor: farm boards run for hashes per joule
+    #ifndef GOVERNOR_MODE
+        #define GOVERNOR_MODE GOVERNOR_MAX_EFFICIENCY
+    #endif
+
     // SHA Implementation: Defined in platformio.ini (USE_HARDWARE_SHA=1)
 
 // ============================================================
@@ -375,7 +405,9 @@
 // Miner on Core 0 (lower priority, yields to other tasks)
 #define MINER_0_CORE        CORE_0
 #define MINER_0_PRIORITY    1
-#define MINER_0_STACK       8000    // Increased for SHA stack usage
+#ifndef MINER_0_STACK
+    #define MINER_0_STACK 8000    // Increased for SHA stack usage
+#endif
 
 // Core 0 mining yield configuration
 // Higher = more hashes per yield, but UI/WiFi may lag
@@ -385,27 +417,181 @@
     #define CORE_0_YIELD_COUNT 256
 #endif
 
+// Adaptive yield bounds: CORE_0_YIELD_MIN while other tasks are asking for
+// CPU (pool traffic, buttons, WiFi events), CORE_0_YIELD_COUNT normally and
+// CORE_0_YIELD_MAX once everything has been quiet for YIELD_IDLE_MS
+#ifndef CORE_0_YIELD_MIN
+    #define CORE_0_YIELD_MIN 128
+#endif
+#ifndef CORE_0_YIELD_MAX
+    #define CORE_0_YIELD_MAX (CORE_0_YIELD_COUNT * 4)
+#endif
+
+// Nonces per ESP32-C3 kernel call. The C3 has one core, so its hardware
+// kernel returns every batch to let the yield scheduler run (~30 ms)
+#ifndef C3_KERNEL_BATCH
+    #define C3_KERNEL_BATCH 8192
+#endif
+
+// Core 1 yield interval in kernel returns (~65k hashes each, one
+// C3_KERNEL_BATCH on single-core chips)
+#if !defined(CORE_1_YIELD_MIN) && defined(CONFIG_IDF_TARGET_ESP32C3)
+    #define CORE_1_YIELD_MIN 1
+    #define CORE_1_YIELD_COUNT 2
+    #define CORE_1_YIELD_MAX 4
+#endif
+#ifndef CORE_1_YIELD_MIN
+    #define CORE_1_YIELD_MIN 4
+#endif
+#ifndef CORE_1_YIELD_COUNT
+    #define CORE_1_YIELD_COUNT 16
+#endif
+#ifndef CORE_1_YIELD_MAX
+    #define CORE_1_YIELD_MAX 64
+#endif
+
+// Demand windows for the yield scheduler (ms since last activity)
+#ifndef YIELD_BUSY_MS
+    #define YIELD_BUSY_MS 500
+#endif
+#ifndef YIELD_IDLE_MS
+    #define YIELD_IDLE_MS 5000
+#endif
+
+// Core 0 software kernel batch (nonces per call, max 32)
+// Keep CORE_0_YIELD_COUNT a multiple of this so yields fall on batch edges
+#ifndef CORE_0_BATCH_SIZE
+    #define CORE_0_BATCH_SIZE 32
+#endif
+
+// Core 1 kernel auto-tune: timed window per candidate kernel at boot (ms).
+// The choice is cached in NVS; define KERNEL_AUTOTUNE_FORCE to re-tune every boot
+#ifndef KERNEL_TUNE_MS
+    #define KERNEL_TUNE_MS 200
+#endif
+
 // Miner on Core 1 (highest priority, dedicated)
 #define MINER_1_CORE        CORE_1
 #define MINER_1_PRIORITY    19      // Near-max priority (FreeRTOS max is 24)
-#define MINER_1_STACK       8000    // Increased for SHA stack usage
+#ifndef MINER_1_STACK
+    #define MINER_1_STACK 8000    // Increased for SHA stack usage
+#endif
+
+// Share verify task - verifies and submits candidates from both mining cores.
+// Above Miner0 so the candidate rings drain between its batches.
+#define VERIFY_CORE         CORE_0
+#define VERIFY_PRIORITY     2
+#ifndef VERIFY_STACK
+    #define VERIFY_STACK 6144
+#endif
+
+// Candidate ring entries per mining core (power of two). Core 1 finds a
+// 16-bit candidate about every 65k hashes, so a few entries cover even a
+// verify task held up by a slow share submission.
+#ifndef CANDIDATE_RING_SIZE
+    #define CANDIDATE_RING_SIZE 8
+#endif
 
 // Stratum task
 #define STRATUM_CORE        CORE_0
 #define STRATUM_PRIORITY    2
-#define STRATUM_STACK       12288
+#ifndef STRATUM_STACK
+    #define STRATUM_STACK 12288
+#endif
+
+// LAN stratum proxy: serve Stratum V1 to other miners on the LAN through
+// this board's pool connection (see src/stratum/stratum_proxy.h). Off by
+// default; best on an S3, which has the heap for a full set of miners.
+#ifndef USE_STRATUM_PROXY
+    #define USE_STRATUM_PROXY 0
+#endif
+#ifndef STRATUM_PROXY_PORT
+    #define STRATUM_PROXY_PORT  3333
+#endif
+#ifndef STRATUM_PROXY_CLIENTS
+    #define STRATUM_PROXY_CLIENTS 8     // Downstream miners (at most 255)
+#endif
+#define STRATUM_PROXY_MIN_EN2   3       // Pool extranonce2 bytes needed to split one off
+#define PROXY_CORE          CORE_0
+#define PROXY_PRIORITY      2
+#ifndef PROXY_STACK
+    #define PROXY_STACK 6144
+#endif
 
 // Monitor/Display task
 // NOTE: Needs large stack for HTTPClient + JSON parsing + TFT rendering
 #define MONITOR_CORE        CORE_0
 #define MONITOR_PRIORITY    1
-#define MONITOR_STACK       10000
+#ifndef MONITOR_STACK
+    #define MONITOR_STACK 10000
+#endif
+
+// TFT widget pushes over SPI DMA (double-buffered tiles of DISPLAY_DMA_ROWS
+// rows across the panel's long side). Parallel panels have no SPI DMA.
+#ifndef USE_DISPLAY_DMA
+    #if USE_DISPLAY && !defined(TFT_PARALLEL_8_BIT)
+        #define USE_DISPLAY_DMA 1
+    #else
+        #define USE_DISPLAY_DMA 0
+    #endif
+#endif
+#define DISPLAY_DMA_ROWS    16      // 2 x 320 x 16 x 2 bytes = 20 KB on a 320px panel
+
+// E-ink refresh task: renders the newest data and steps the panel through
+// each refresh on BUSY edges, so no other task waits on the panel
+#define EINK_CORE           CORE_0
+#define EINK_PRIORITY       1
+#define EINK_STACK          4096
+#ifndef EINK_MIN_REFRESH_MS
+    #define EINK_MIN_REFRESH_MS 3000        // Updates in between are coalesced into the next refresh
+#endif
+#ifndef EINK_FULL_REFRESH_EVERY
+    #define EINK_FULL_REFRESH_EVERY 30      // Partial refreshes before a full one clears ghosting
+#endif
+
+// Button task: needs 4 KB+ for NVS writes (rotation save) and display updates
+// in the click handlers; above Miner0, below Miner1
+#define BUTTON_CORE         CORE_0
+#define BUTTON_PRIORITY     5
+#ifndef BUTTON_STACK
+    #define BUTTON_STACK 4096
+#endif
 
 // Stats API task
 // NOTE: Needs large stack for WiFiClientSecure SSL context (~10-15KB)
 #define STATS_CORE          CORE_0
 #define STATS_PRIORITY      1
-#define STATS_STACK         12000
+#ifndef STATS_STACK
+    #define STATS_STACK 12000
+#endif
+
+// Metrics server: Prometheus text format on http://<ip>:METRICS_PORT/metrics
+#ifndef USE_METRICS_SERVER
+    #define USE_METRICS_SERVER 1
+#endif
+#ifndef METRICS_PORT
+    #define METRICS_PORT    9100
+#endif
+#define METRICS_CORE        CORE_0
+#define METRICS_PRIORITY    1
+#ifndef METRICS_STACK
+    #define METRICS_STACK 4096
+#endif
+
+// Fleet stats sharing: one board fetches live stats and multicasts them,
+// the rest listen (see src/stats/stats_share.h)
+#ifndef USE_STATS_SHARE
+    #define USE_STATS_SHARE 1
+#endif
+#ifndef STATS_SHARE_GROUP
+    #define STATS_SHARE_GROUP   "239.255.77.77"
+#endif
+#ifndef STATS_SHARE_PORT
+    #define STATS_SHARE_PORT    47777
+#endif
+#define STATS_SHARE_INTERVAL_MS     30000   // Leader broadcast period
+#define STATS_LEADER_TIMEOUT_MS     90000   // No snapshot for this long: fetch directly
+#define STATS_SHARE_JITTER_MS       20000   // Random extra listen time at boot
 
 // ============================================================
 // Network Configuration
@@ -414,8 +600,28 @@
 #define AP_PASSWORD         "minebitcoin"
 
 #define WIFI_RECONNECT_MS   10000
+
+// WiFi outages: the miners keep hashing the last job and found shares stay
+// queued for this long before the pool session is given up. Reconnects are
+// driven by the WiFi events and rejoin the cached access point first.
+#define WIFI_OUTAGE_GRACE_MS 60000
 #define NTP_UPDATE_MS       600000  // 10 minutes
 
+// Fast boot: join the last access point by BSSID and channel (cached in NVS)
+// instead of scanning, skip the serial console wait once the board has been
+// online, and connect to the pool while the display is still initializing
+#ifndef FAST_BOOT
+    #define FAST_BOOT 1
+#endif
+#define FAST_BOOT_JOIN_MS   3000    // Cached AP silent this long: full scan
+
+// Reuse the last DHCP lease after a software reset (OTA, crash, watchdog)
+// instead of asking DHCP. Off by default: that lease is never renewed, so
+// only enable it where the router reserves the address
+#ifndef FAST_BOOT_REUSE_IP
+    #define FAST_BOOT_REUSE_IP 0
+#endif
+
 // ============================================================
 // Pool Configuration
 // ============================================================
@@ -428,7 +634,240 @@
 
 #define POOL_TIMEOUT_MS     60000   // 60s inactivity
 #define POOL_KEEPALIVE_MS   30000   // 30s keepalive
-#define POOL_FAILOVER_MS    30000   // 30s before failover
+#define POOL_PROBE_MS       60000   // One latency probe per interval, round robin over the pool list
+#define POOL_MAX_FAILURES   3       // Failed connects/probes before a pool counts as down
+#define POOL_SWITCH_MARGIN_MS 20    // Round-trip gain (and 20%) needed to move to a faster pool
+#define POOL_STANDBY_RETRY_MS 30000 // Hot standby reconnect interval
+#define POOL_STANDBY_CONNECT_MS 3000 // Hot standby connect timeout (blocks the stratum task)
+#define STRATUM_TLS_MIN_HEAP 40000  // Contiguous heap needed to start a stratum+ssl handshake
+
+// Hot standby: keep the next pool in line (the best-ranked other pool, or
+// the backup) subscribed in parallel with its newest job decoded, so
+// failover, failback and latency switches swap jobs without a reconnect
+// Offer the previous extranonce1 as the session id on re-subscribe: pools
+// that resume sessions (ckpool and its derivatives) hand it back, and the
+// running job and queued shares stay valid across the reconnect
+#ifndef STRATUM_SESSION_RESUME
+#define STRATUM_SESSION_RESUME 1
+#endif
+
+#ifndef STRATUM_HOT_STANDBY
+#define STRATUM_HOT_STANDBY 0
+#endif
+
+// Suggested difficulty follows the measured hashrate so shares arrive about
+// once per STRATUM_SHARE_INTERVAL_S (0 = always suggest the configured
+// difficulty). The configured difficulty stays the floor; a new suggestion
+// goes out when the target moves by more than STRATUM_RESUGGEST_RATIO.
+#ifndef STRATUM_SHARE_INTERVAL_S
+#define STRATUM_SHARE_INTERVAL_S 30
+#endif
+#define STRATUM_RESUGGEST_RATIO 2.0
+#define STRATUM_HASHRATE_WINDOW_MS 60000   // Hashrate measurement window
+
+// ============================================================
+// CPU Frequency Governor
+// ============================================================
+// Steps the CPU clock at runtime (80/160/240 MHz; APB stays at 80 MHz) on
+// the on-chip temperature and the measured hashrate (see
+// src/mining/freq_governor.h). Boards override the limits, the thermal
+// thresholds, the mode and the draw model in their section above.
+#define GOVERNOR_MAX_HASHRATE   0       // Highest step the temperature allows
+#define GOVERNOR_MAX_EFFICIENCY 1       // Best measured hashes per joule
+
+#ifndef USE_FREQ_GOVERNOR
+    #define USE_FREQ_GOVERNOR 1
+#endif
+#ifndef GOVERNOR_MODE
+    #define GOVERNOR_MODE GOVERNOR_MAX_HASHRATE
+#endif
+#ifndef GOVERNOR_MIN_MHZ
+    #define GOVERNOR_MIN_MHZ 80
+#endif
+#ifndef GOVERNOR_MAX_MHZ
+    #if defined(CONFIG_IDF_TARGET_ESP32C3)
+        #define GOVERNOR_MAX_MHZ 160
+    #else
+        #define GOVERNOR_MAX_MHZ 240
+    #endif
+#endif
+#ifndef GOVERNOR_TEMP_HOT_C
+    #define GOVERNOR_TEMP_HOT_C 75      // Step down one per period at or above
+#endif
+#ifndef GOVERNOR_TEMP_CRIT_C
+    #define GOVERNOR_TEMP_CRIT_C 85     // Straight to GOVERNOR_MIN_MHZ
+#endif
+#ifndef GOVERNOR_TEMP_HYST_C
+    #define GOVERNOR_TEMP_HYST_C 10     // Step back up below HOT minus this
+#endif
+// Whole-board draw at each step in mW, for hashes per joule (radio and
+// regulator included; the 240 MHz step also runs the core at a higher voltage)
+#ifndef GOVERNOR_MW_80
+    #if defined(CONFIG_IDF_TARGET_ESP32C3)
+        #define GOVERNOR_MW_80  230
+        #define GOVERNOR_MW_160 280
+        #define GOVERNOR_MW_240 280
+    #elif defined(CONFIG_IDF_TARGET_ESP32S3)
+        #define GOVERNOR_MW_80  270
+        #define GOVERNOR_MW_160 330
+        #define GOVERNOR_MW_240 410
+    #else
+        #define GOVERNOR_MW_80  300
+        #define GOVERNOR_MW_160 350
+        #define GOVERNOR_MW_240 430
+    #endif
+#endif
+#define GOVERNOR_PERIOD_MS      10000   // Sample interval
+#define GOVERNOR_DWELL_MS       60000   // Shortest stay at a step before a step up or a mode move
+#define GOVERNOR_EXPLORE_MS     (6UL * 3600 * 1000)     // Re-measure the other steps this often
+
+// ============================================================
+// Power Monitoring
+// ============================================================
+// Board draw for the hashes-per-joule stats (see src/stats/power.h): an
+// INA219/INA226 on I2C with USE_POWER_SENSOR=1, otherwise the GOVERNOR_MW_*
+// model above at the current clock
+#ifndef USE_POWER_SENSOR
+    #define USE_POWER_SENSOR 0
+#endif
+#ifndef POWER_SDA_PIN
+    #if defined(OLED_SDA_PIN)
+        #define POWER_SDA_PIN OLED_SDA_PIN      // Same bus as the OLED
+        #define POWER_SCL_PIN OLED_SCL_PIN
+    #elif defined(CONFIG_IDF_TARGET_ESP32C3)
+        #define POWER_SDA_PIN 5
+        #define POWER_SCL_PIN 6
+    #elif defined(CONFIG_IDF_TARGET_ESP32S3)
+        #define POWER_SDA_PIN 8
+        #define POWER_SCL_PIN 9
+    #else
+        #define POWER_SDA_PIN 21
+        #define POWER_SCL_PIN 22
+    #endif
+#endif
+#ifndef POWER_I2C_ADDR
+    #define POWER_I2C_ADDR 0x40         // A0/A1 to ground
+#endif
+#ifndef POWER_SHUNT_MOHM
+    #define POWER_SHUNT_MOHM 100        // R100 on the common breakout boards
+#endif
+#define POWER_I2C_CLOCK     400000
+#define POWER_SAMPLE_MS     1000
+#define POWER_WINDOW_MS     60000       // Efficiency window
+
+// ============================================================
+// External ASIC (BM13xx over UART)
+// ============================================================
+// With USE_ASIC_BM13XX=1 the hardware miner slot drives a Bitmain BM1397
+// or BM1366 chain on a UART (src/mining/engine_bm13xx.h) instead of the
+// SHA peripheral; the ESP32 only builds work and checks results. Falls
+// back to the built-in engine when no chip answers.
+#ifndef USE_ASIC_BM13XX
+    #define USE_ASIC_BM13XX 0
+#endif
+#define ASIC_BM1397 1397
+#define ASIC_BM1366 1366
+#ifndef ASIC_MODEL
+    #define ASIC_MODEL ASIC_BM1366
+#endif
+#ifndef ASIC_UART_NUM
+    #define ASIC_UART_NUM 1
+#endif
+#ifndef ASIC_TX_PIN
+    #if defined(CONFIG_IDF_TARGET_ESP32C3)
+        #define ASIC_TX_PIN 7
+        #define ASIC_RX_PIN 10
+    #elif defined(CONFIG_IDF_TARGET_ESP32S3)
+        #define ASIC_TX_PIN 17          // Bitaxe wiring
+        #define ASIC_RX_PIN 18
+    #else
+        #define ASIC_TX_PIN 17
+        #define ASIC_RX_PIN 16
+    #endif
+#endif
+#ifndef ASIC_RESET_PIN
+    #define ASIC_RESET_PIN -1           // Chain reset (active low), -1 = none
+#endif
+#ifndef ASIC_CHIPS
+    #define ASIC_CHIPS 1                // Expected; the chain is counted at boot
+#endif
+#ifndef ASIC_FREQ_MHZ
+    #if ASIC_MODEL == ASIC_BM1397
+        #define ASIC_FREQ_MHZ 425
+    #else
+        #define ASIC_FREQ_MHZ 485
+    #endif
+#endif
+#ifndef ASIC_TICKET_DIFF
+    #define ASIC_TICKET_DIFF 256        // Highest ticket difficulty, lowered to the pool's
+#endif
+#ifndef ASIC_FAST_BAUD
+    #define ASIC_FAST_BAUD 1            // Switch to the chip's top UART rate after init
+#endif
+#define ASIC_INIT_BAUD      115200
+#define ASIC_RX_BUFFER      1024
+#define ASIC_POLL_MS        20          // Longest a poll waits for a result
+#define ASIC_WORK_MAX_MS    1000        // Fresh work at least this often
+#define ASIC_FREQ_STEP_MHZ  25          // PLL ramp step at init
+
+// ============================================================
+// Memory Budget
+// ============================================================
+// Task stacks are static (src/stats/mem_budget.h). Size the *_STACK defines
+// above from the report's peaks, keeping at least MEM_STACK_MARGIN spare.
+#define MEM_STACK_MARGIN    1024        // Flag stacks with less spare than this
+#define MEM_REPORT_AFTER_MS 600000      // Second report once the stacks have seen real work
+
+// ============================================================
+// Stats Persistence
+// ============================================================
+// Lifetime stats are appended to a checksummed journal in the "journal"
+// data partition (huge_app.csv) instead of rewriting an NVS blob. Boards
+// whose partition table has no journal keep using NVS.
+#ifndef USE_STATS_JOURNAL
+    #define USE_STATS_JOURNAL 1
+#endif
+#define JOURNAL_PARTITION       "journal"
+#define JOURNAL_SD_EVERY        24      // Rewrite the SD backup every Nth record
+#define STATS_SAVE_ALIGN_MS     60000   // Longest a save waits for a job switch
+
+// ============================================================
+// SD Card Logging
+// ============================================================
+// Share results and per-minute hashrate as CSV on the SD card (boards with
+// an SD slot only; see src/stats/sd_log.h)
+#ifndef USE_SD_LOG
+    #define USE_SD_LOG 1
+#endif
+#define SD_LOG_DIR          "/logs"
+#define SD_LOG_QUEUE        32          // Share rows in flight (power of two)
+#define SD_LOG_BLOCK        4096        // Card write size, one FAT cluster on most cards
+#define SD_LOG_FLUSH_MS     60000       // Longest a partial block waits in RAM
+#define SD_LOG_MAX_BYTES    (1024UL * 1024)     // Rotate past this
+#define SD_LOG_FILES        4           // Rotated files kept
+#define SD_LOG_CORE         CORE_0
+#define SD_LOG_PRIORITY     1
+#define SD_LOG_STACK        4096
+
+// ============================================================
+// Stratum Capture and Replay
+// ============================================================
+// Record the pool's raw lines ("capture sd" / "capture serial") and replay
+// them without a network ("replay [speed]") to benchmark job switching
+// (see src/stratum/stratum_capture.h). Replay needs an SD slot.
+#ifndef USE_STRATUM_CAPTURE
+    #define USE_STRATUM_CAPTURE 0
+#endif
+#define CAPTURE_PATH        SD_LOG_DIR "/stratum.txt"
+#ifndef CAPTURE_QUEUE_BYTES
+    #define CAPTURE_QUEUE_BYTES 12288   // Lines in flight between the stratum and capture tasks
+#endif
+#define CAPTURE_BLOCK       4096        // Card write size
+#define CAPTURE_FLUSH_MS    10000       // Longest a partial block waits in RAM
+#define CAPTURE_POLL_MS     20          // Capture task drain and read-ahead interval
+#define CAPTURE_CORE        CORE_0
+#define CAPTURE_PRIORITY    1
+#define CAPTURE_STACK       4096
 
 // ============================================================
 // String Limits
@@ -436,6 +875,7 @@
 #define MAX_SSID_LENGTH     63  // Note: ESP-IDF uses MAX_SSID_LEN=32
 #define MAX_PASSWORD_LEN    64
 #define MAX_POOL_URL_LEN    80
+#define MAX_EXTRA_POOLS     4       // Pool endpoints beyond primary/backup (config.json "pools")
 #define MAX_WALLET_LEN      120
 #define MAX_JOB_ID_LEN      64
 
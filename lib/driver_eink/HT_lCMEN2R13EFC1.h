@@ -120,6 +120,29 @@ public:
 		WaitUntilIdle();
 	}
 
+	// Non-blocking refresh steps, for callers that watch BUSY themselves:
+	// powerOn(), startRefresh() and powerOff() each keep the controller busy
+	// until BUSY goes high again (as display() waits for in sequence)
+	bool isBusy()
+	{
+		return !digitalRead(_busy); // LOW while the controller is working
+	}
+
+	void powerOn()
+	{
+		sendCommand(0x04);
+	}
+
+	void startRefresh()
+	{
+		sendCommand(0x12);
+	}
+
+	void powerOff()
+	{
+		sendCommand(0x02);
+	}
+
 	void setInverted(bool inverted)
 	{
 		this->inverted = inverted;
@@ -10,6 +10,7 @@
 #include <ArduinoJson.h>
 #include <board_config.h>
 #include "nvs_config.h"
+#include "stats_journal.h"
 #include "../stratum/stratum_types.h"
 
 // SD card support - use SD_MMC for ESP32-S3 CYD, SPI SD for others
@@ -40,6 +41,7 @@
 #define CONFIG_MAGIC 0x5350524B  // "SPRK"
 
 static Preferences s_prefs;
+static pool_list_t s_poolList = {0};
 static miner_config_t s_config;
 static bool s_initialized = false;
 
@@ -239,10 +241,27 @@ static bool loadConfigFromFile(miner_config_t *config) {
         safeStrCpy(config->backupPoolPassword, doc["backup_pool_password"], sizeof(config->backupPoolPassword));
     }
 
+    // Extra pool endpoints (optional): [{"url": "...", "port": 3333}, ...]
+    JsonArray pools = doc["pools"];
+    if (!pools.isNull()) {
+        memset(&s_poolList, 0, sizeof(s_poolList));
+        for (JsonObject pool : pools) {
+            if (s_poolList.count >= MAX_EXTRA_POOLS) break;
+            if (!pool.containsKey("url")) continue;
+            pool_endpoint_t *endpoint = &s_poolList.pools[s_poolList.count++];
+            safeStrCpy(endpoint->url, pool["url"], sizeof(endpoint->url));
+            endpoint->port = pool["port"] | DEFAULT_POOL_PORT;
+        }
+        Serial.printf("[CONFIG] Loaded %d extra pool(s)\n", s_poolList.count);
+    }
+
     // Display settings (optional)
     if (doc.containsKey("brightness")) {
         config->brightness = doc["brightness"];
     }
+    if (doc.containsKey("screen_timeout")) {
+        config->screenTimeout = doc["screen_timeout"];  // Minutes, 0 = never
+    }
     if (doc.containsKey("invert_colors")) {
         config->invertColors = doc["invert_colors"];
     }
@@ -281,6 +300,14 @@ static bool loadConfigFromFile(miner_config_t *config) {
 #endif  // HAS_SD_CARD
 }
 
+// SD card shared by the stats backup and the SD logger: one mount, one
+// user at a time. The logger keeps it mounted between its writes.
+#if HAS_SD_CARD
+static SemaphoreHandle_t s_sdLock = NULL;
+static bool s_sdMounted = false;
+static bool s_sdKeep = false;
+#endif
+
 /**
  * Initialize SD card for file operations
  * Returns true if SD card is ready
@@ -309,6 +336,36 @@ static bool initSD() {
 #endif
 }
 
+fs::FS *nvs_sd_lock() {
+#if !HAS_SD_CARD
+    return NULL;
+#else
+    if (!s_sdLock) return NULL;  // Before nvs_config_init()
+    xSemaphoreTake(s_sdLock, portMAX_DELAY);
+    if (!s_sdMounted && !(s_sdMounted = initSD())) {
+        xSemaphoreGive(s_sdLock);
+        return NULL;
+    }
+    return &SD_FS;
+#endif
+}
+
+void nvs_sd_unlock() {
+#if HAS_SD_CARD
+    if (s_sdMounted && !s_sdKeep) {
+        SD_FS.end();
+        s_sdMounted = false;
+    }
+    xSemaphoreGive(s_sdLock);
+#endif
+}
+
+void nvs_sd_keep_mounted(bool keep) {
+#if HAS_SD_CARD
+    s_sdKeep = keep;
+#endif
+}
+
 /**
  * Save mining stats to SD card as JSON backup
  * Called alongside NVS save - survives firmware updates and factory resets
@@ -317,7 +374,8 @@ static bool saveStatsToSD(const mining_persistence_t *stats) {
 #if !HAS_SD_CARD
     return false;
 #else
-    if (!initSD()) {
+    fs::FS *sd = nvs_sd_lock();
+    if (!sd) {
         // SD card not available - silently skip (not an error)
         return false;
     }
@@ -335,16 +393,16 @@ static bool saveStatsToSD(const mining_persistence_t *stats) {
     doc["magic"] = STATS_MAGIC;
 
     // Write to file
-    File file = SD_FS.open(STATS_FILE_PATH, "w");
+    File file = sd->open(STATS_FILE_PATH, "w");
     if (!file) {
         Serial.println("[SD-STATS] Failed to open stats.json for writing");
-        SD_FS.end();
+        nvs_sd_unlock();
         return false;
     }
 
     size_t written = serializeJson(doc, file);
     file.close();
-    SD_FS.end();
+    nvs_sd_unlock();
 
     if (written == 0) {
         Serial.println("[SD-STATS] Failed to write stats.json");
@@ -365,26 +423,27 @@ static bool loadStatsFromSD(mining_persistence_t *stats) {
 #if !HAS_SD_CARD
     return false;
 #else
-    if (!initSD()) {
+    fs::FS *sd = nvs_sd_lock();
+    if (!sd) {
         return false;
     }
 
-    if (!SD_FS.exists(STATS_FILE_PATH)) {
-        SD_FS.end();
+    if (!sd->exists(STATS_FILE_PATH)) {
+        nvs_sd_unlock();
         return false;
     }
 
-    File file = SD_FS.open(STATS_FILE_PATH, "r");
+    File file = sd->open(STATS_FILE_PATH, "r");
     if (!file) {
         Serial.println("[SD-STATS] Failed to open stats.json");
-        SD_FS.end();
+        nvs_sd_unlock();
         return false;
     }
 
     StaticJsonDocument<512> doc;
     DeserializationError err = deserializeJson(doc, file);
     file.close();
-    SD_FS.end();
+    nvs_sd_unlock();
 
     if (err) {
         Serial.printf("[SD-STATS] JSON parse error: %s\n", err.c_str());
@@ -414,6 +473,29 @@ static bool loadStatsFromSD(mining_persistence_t *stats) {
 #endif
 }
 
+#define NVS_KEY_POOLS "pools"
+
+static bool loadPoolList(pool_list_t *list) {
+    if (!s_prefs.begin(NVS_NAMESPACE, true)) {  // Read-only
+        return false;
+    }
+
+    size_t len = s_prefs.getBytesLength(NVS_KEY_POOLS);
+    size_t read = (len == sizeof(pool_list_t)) ? s_prefs.getBytes(NVS_KEY_POOLS, list, sizeof(pool_list_t)) : 0;
+    s_prefs.end();
+
+    if (read != sizeof(pool_list_t) || list->magic != POOL_LIST_MAGIC || list->count > MAX_EXTRA_POOLS) {
+        memset(list, 0, sizeof(pool_list_t));
+        return false;
+    }
+
+    for (int i = 0; i < list->count; i++) {
+        list->pools[i].url[MAX_POOL_URL_LEN] = '\0';
+    }
+    Serial.printf("[NVS] %d extra pool(s) loaded\n", list->count);
+    return true;
+}
+
 // ============================================================
 // Public API
 // ============================================================
@@ -421,6 +503,10 @@ static bool loadStatsFromSD(mining_persistence_t *stats) {
 void nvs_config_init() {
     if (s_initialized) return;
 
+#if HAS_SD_CARD
+    if (!s_sdLock) s_sdLock = xSemaphoreCreateMutex();
+#endif
+
     // Brief delay to ensure flash controller is stable after boot/flash
     delay(100);
 
@@ -435,6 +521,7 @@ void nvs_config_init() {
     if (nvs_config_load(&s_config)) {
         Serial.println("[NVS] Configuration loaded from NVS");
         loadedFromNvs = true;
+        loadPoolList(&s_poolList);
     }
 
     // 2. If no valid NVS config, try SD card (initial setup only)
@@ -446,6 +533,7 @@ void nvs_config_init() {
             loadedFromSd = true;
             // Save to NVS for persistence
             Serial.println("[NVS] Saving config to NVS for persistence...");
+            nvs_pools_save(&s_poolList);
             if (nvs_config_save(&s_config)) {
                 Serial.println("[NVS] Config saved to NVS successfully - SD card can now be removed");
             } else {
@@ -681,6 +769,22 @@ bool nvs_stats_save(const mining_persistence_t *stats) {
     statsCopy.magic = STATS_MAGIC;
     statsCopy.checksum = calculateStatsChecksum(&statsCopy);
 
+    // Journal partition present: one record write instead of an NVS rewrite,
+    // and the SD backup only on the first and every JOURNAL_SD_EVERY-th save
+    if (stats_journal_init()) {
+        static uint32_t journalSaves = 0;
+        if (!stats_journal_append(&statsCopy)) {
+            return false;
+        }
+        memcpy(&s_persistentStats, &statsCopy, sizeof(mining_persistence_t));
+        Serial.printf("[NVS-STATS] Journaled: %llu lifetime hashes, %lu shares\n",
+                      statsCopy.lifetimeHashes, statsCopy.lifetimeShares);
+        if (journalSaves++ % JOURNAL_SD_EVERY == 0) {
+            saveStatsToSD(&statsCopy);
+        }
+        return true;
+    }
+
     if (!s_prefs.begin(NVS_NAMESPACE, false)) {  // Read-write
         Serial.println("[NVS-STATS] Failed to open namespace for writing");
         return false;
@@ -710,8 +814,10 @@ mining_persistence_t* nvs_stats_get() {
     if (!s_statsInitialized) {
         bool loaded = false;
 
-        // 1. Try to load from NVS first (primary storage)
-        if (nvs_stats_load(&s_persistentStats)) {
+        // 1. Newest journal record, then NVS (older firmware, no journal partition)
+        if (stats_journal_init() && stats_journal_load(&s_persistentStats)) {
+            loaded = true;
+        } else if (nvs_stats_load(&s_persistentStats)) {
             loaded = true;
         }
 
@@ -720,8 +826,8 @@ mining_persistence_t* nvs_stats_get() {
             Serial.println("[NVS-STATS] No NVS stats, checking SD card backup...");
             if (loadStatsFromSD(&s_persistentStats)) {
                 loaded = true;
-                // Save recovered stats to NVS for faster access next boot
-                Serial.println("[NVS-STATS] Restoring stats from SD card to NVS...");
+                // Save recovered stats (journal or NVS) for faster access next boot
+                Serial.println("[NVS-STATS] Restoring stats from SD card...");
                 nvs_stats_save(&s_persistentStats);
             }
         }
@@ -762,3 +868,137 @@ void nvs_stats_update(uint64_t currentHashes, uint32_t currentShares,
     // Save to NVS
     nvs_stats_save(stats);
 }
+
+// ============================================================
+// Kernel Tuning Cache Implementation
+// ============================================================
+
+#define NVS_KEY_KERNEL "kernel"
+
+bool nvs_kernel_load(kernel_tune_t *tune) {
+    // Local handle - runs on the mining core while s_prefs may be in use
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {  // Read-only
+        return false;
+    }
+
+    size_t len = prefs.getBytesLength(NVS_KEY_KERNEL);
+    if (len != sizeof(kernel_tune_t)) {
+        prefs.end();
+        return false;
+    }
+
+    size_t read = prefs.getBytes(NVS_KEY_KERNEL, tune, sizeof(kernel_tune_t));
+    prefs.end();
+
+    if (read != sizeof(kernel_tune_t) || tune->magic != KERNEL_TUNE_MAGIC) {
+        memset(tune, 0, sizeof(kernel_tune_t));
+        return false;
+    }
+
+    tune->kernel[sizeof(tune->kernel) - 1] = '\0';
+    return true;
+}
+
+bool nvs_kernel_save(const kernel_tune_t *tune) {
+    kernel_tune_t tuneCopy;
+    memset(&tuneCopy, 0, sizeof(kernel_tune_t));
+    tuneCopy.key = tune->key;
+    safeStrCpy(tuneCopy.kernel, tune->kernel, sizeof(tuneCopy.kernel));
+    tuneCopy.hashRate = tune->hashRate;
+    tuneCopy.magic = KERNEL_TUNE_MAGIC;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {  // Read-write
+        Serial.println("[NVS] Failed to open namespace for kernel cache");
+        return false;
+    }
+
+    size_t written = prefs.putBytes(NVS_KEY_KERNEL, &tuneCopy, sizeof(kernel_tune_t));
+    prefs.end();
+
+    if (written != sizeof(kernel_tune_t)) {
+        Serial.println("[NVS] Failed to write kernel cache");
+        return false;
+    }
+    return true;
+}
+
+// ============================================================
+// WiFi Fast-Reconnect Cache Implementation
+// ============================================================
+
+#define NVS_KEY_WIFI_CACHE "wifiAp"
+
+bool nvs_wifi_cache_load(wifi_cache_t *cache) {
+    // Local handle - read before nvs_config_init() to decide on a fast boot
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {  // Read-only
+        return false;
+    }
+
+    size_t read = 0;
+    if (prefs.getBytesLength(NVS_KEY_WIFI_CACHE) == sizeof(wifi_cache_t)) {
+        read = prefs.getBytes(NVS_KEY_WIFI_CACHE, cache, sizeof(wifi_cache_t));
+    }
+    prefs.end();
+
+    if (read != sizeof(wifi_cache_t) || cache->magic != WIFI_CACHE_MAGIC || cache->channel == 0) {
+        memset(cache, 0, sizeof(wifi_cache_t));
+        return false;
+    }
+    return true;
+}
+
+bool nvs_wifi_cache_save(const wifi_cache_t *cache) {
+    wifi_cache_t cacheCopy;
+    memcpy(&cacheCopy, cache, sizeof(wifi_cache_t));
+    cacheCopy.reserved = 0;
+    cacheCopy.magic = WIFI_CACHE_MAGIC;
+
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {  // Read-write
+        Serial.println("[NVS] Failed to open namespace for WiFi cache");
+        return false;
+    }
+
+    size_t written = prefs.putBytes(NVS_KEY_WIFI_CACHE, &cacheCopy, sizeof(wifi_cache_t));
+    prefs.end();
+
+    if (written != sizeof(wifi_cache_t)) {
+        Serial.println("[NVS] Failed to write WiFi cache");
+        return false;
+    }
+    return true;
+}
+
+// ============================================================
+// Extra Pool List Implementation
+// ============================================================
+
+pool_list_t* nvs_pools_get() {
+    if (!s_initialized) {
+        nvs_config_init();
+    }
+    return &s_poolList;
+}
+
+bool nvs_pools_save(const pool_list_t *list) {
+    pool_list_t listCopy;
+    memcpy(&listCopy, list, sizeof(pool_list_t));
+    listCopy.magic = POOL_LIST_MAGIC;
+
+    if (!s_prefs.begin(NVS_NAMESPACE, false)) {  // Read-write
+        Serial.println("[NVS] Failed to open namespace for pool list");
+        return false;
+    }
+
+    size_t written = s_prefs.putBytes(NVS_KEY_POOLS, &listCopy, sizeof(pool_list_t));
+    s_prefs.end();
+
+    if (written != sizeof(pool_list_t)) {
+        Serial.println("[NVS] Failed to write pool list");
+        return false;
+    }
+    return true;
+}
@@ -9,6 +9,7 @@
 #define NVS_CONFIG_H
 
 #include <Arduino.h>
+#include <FS.h>
 #include <board_config.h>
 
 /**
@@ -125,7 +126,7 @@ bool nvs_config_is_valid();
 bool nvs_stats_load(mining_persistence_t *stats);
 
 /**
- * Save persistent stats to NVS
+ * Save persistent stats to the stats journal, or NVS without one
  * Call sparingly (every 1 hour) to avoid flash wear
  * @param stats Pointer to stats structure to save
  * @return true if saved successfully
@@ -153,4 +154,125 @@ void nvs_stats_update(uint64_t currentHashes, uint32_t currentShares,
                       uint32_t currentBlocks, uint32_t sessionSeconds,
                       double bestDiff);
 
+// ============================================================
+// Kernel Tuning Cache API
+// ============================================================
+
+/**
+ * Cached Core 1 kernel selection
+ * Keyed on chip model/revision and CPU frequency so a board swap or
+ * clock change forces a re-tune
+ */
+#define KERNEL_TUNE_MAGIC 0x4B524E4C  // "KRNL"
+
+typedef struct __attribute__((packed)) {
+    uint32_t key;               // Chip model << 24 | revision << 16 | CPU MHz
+    char kernel[16];            // Selected kernel name
+    uint32_t hashRate;          // Measured rate at selection (H/s)
+    uint32_t magic;             // Magic value for validation
+} kernel_tune_t;
+
+/**
+ * Load cached kernel selection from NVS
+ * Safe to call from the mining task (uses its own Preferences handle)
+ * @param tune Pointer to structure to fill
+ * @return true if a valid entry was found
+ */
+bool nvs_kernel_load(kernel_tune_t *tune);
+
+/**
+ * Save kernel selection to NVS
+ * Only called after a re-tune, so flash wear is negligible
+ * @param tune Selection to save
+ * @return true if saved successfully
+ */
+bool nvs_kernel_save(const kernel_tune_t *tune);
+
+// ============================================================
+// WiFi Fast-Reconnect Cache API
+// ============================================================
+
+/**
+ * Access point of the last successful connection
+ * Lets the next boot join by BSSID and channel without a scan.
+ * Keyed on the SSID so a changed network ignores it.
+ */
+#define WIFI_CACHE_MAGIC 0x57464332  // "WFC2"
+
+typedef struct __attribute__((packed)) {
+    uint32_t ssidHash;          // FNV-1a of the SSID it was learned on
+    uint8_t bssid[6];
+    uint8_t channel;
+    uint8_t reserved;
+    uint32_t magic;             // Magic value for validation
+} wifi_cache_t;
+
+/**
+ * Load the cached access point from NVS
+ * @return true if a valid entry was found
+ */
+bool nvs_wifi_cache_load(wifi_cache_t *cache);
+
+/**
+ * Save the access point to NVS
+ * Callers only save when it changed, so a normal boot writes nothing
+ */
+bool nvs_wifi_cache_save(const wifi_cache_t *cache);
+
+// ============================================================
+// SD Card Access API
+// ============================================================
+
+/**
+ * Mount the SD card (if needed) and take it for exclusive use
+ * Blocks while another task holds it; never call from the mining or
+ * stratum tasks.
+ * @return the card's filesystem, or NULL if there is no card (not locked)
+ */
+fs::FS *nvs_sd_lock();
+
+/**
+ * Give the card back; unmounts it unless nvs_sd_keep_mounted() is set
+ */
+void nvs_sd_unlock();
+
+/**
+ * Keep the card mounted between locks (saves a remount per write)
+ */
+void nvs_sd_keep_mounted(bool keep);
+
+// ============================================================
+// Extra Pool List API
+// ============================================================
+
+/**
+ * Pool endpoints beyond primary/backup, mining for the primary wallet
+ * Kept outside miner_config_t so adding it leaves stored configs intact
+ */
+#define POOL_LIST_MAGIC 0x504F4F4C  // "POOL"
+
+typedef struct __attribute__((packed)) {
+    char url[MAX_POOL_URL_LEN + 1];
+    uint16_t port;
+} pool_endpoint_t;
+
+typedef struct __attribute__((packed)) {
+    uint8_t count;
+    pool_endpoint_t pools[MAX_EXTRA_POOLS];
+    uint32_t magic;             // Magic value for validation
+} pool_list_t;
+
+/**
+ * Get the extra pool list (from config.json "pools" on SD setup, else NVS)
+ * @return Pointer to the list (count 0 if none)
+ */
+pool_list_t* nvs_pools_get();
+
+/**
+ * Save the extra pool list to NVS
+ * @param list List to save
+ * @return true if saved successfully
+ */
+bool nvs_pools_save(const pool_list_t *list);
+
 #endif // NVS_CONFIG_H
@@ -0,0 +1,211 @@
+/*
+ * SparkMiner - Stats Journal Implementation
+ * See stats_journal.h.
+ */
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_rom_crc.h>
+#include <board_config.h>
+#include "stats_journal.h"
+
+// Records must tile the sectors exactly and stay word-aligned for flash writes
+static_assert(sizeof(journal_record_t) == 64, "journal_record_t size changed");
+
+static const esp_partition_t *s_part = NULL;
+static uint32_t s_slots = 0;            // Records the partition holds
+static uint32_t s_nextSlot = 0;         // Where the next record goes
+static journal_record_t s_last;         // Newest valid record
+static bool s_haveLast = false;
+static bool s_initDone = false;
+static stats_journal_stats_t s_stats = {0};
+
+// ============================================================
+// Helpers
+// ============================================================
+
+static uint32_t recordCrc(const journal_record_t *r) {
+    return esp_rom_crc32_le(0, (const uint8_t *)r, offsetof(journal_record_t, crc));
+}
+
+static bool readSlot(uint32_t slot, journal_record_t *r) {
+    return esp_partition_read(s_part, slot * sizeof(*r), r, sizeof(*r)) == ESP_OK;
+}
+
+static bool recordValid(const journal_record_t *r) {
+    return r->magic == JOURNAL_MAGIC && r->crc == recordCrc(r);
+}
+
+static bool recordErased(const journal_record_t *r) {
+    const uint32_t *w = (const uint32_t *)r;
+    for (size_t i = 0; i < sizeof(*r) / sizeof(uint32_t); i++) {
+        if (w[i] != 0xFFFFFFFF) return false;
+    }
+    return true;
+}
+
+// Newer in sequence order (survives the counter wrapping)
+static bool seqNewer(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) > 0;
+}
+
+// First valid record of a sector; usually slot 0, later ones if that write tore
+static bool firstValid(uint32_t sector, journal_record_t *r) {
+    for (uint32_t i = 0; i < JOURNAL_PER_SECTOR; i++) {
+        if (!readSlot(sector * JOURNAL_PER_SECTOR + i, r) || recordErased(r)) return false;
+        if (recordValid(r)) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// Replay
+// ============================================================
+
+static void replay() {
+    uint32_t sectors = s_slots / JOURNAL_PER_SECTOR;
+    journal_record_t r;
+
+    // Newest sector: the one whose first record is newest
+    int32_t newest = -1;
+    uint32_t newestSeq = 0;
+    for (uint32_t s = 0; s < sectors; s++) {
+        if (firstValid(s, &r) && (newest < 0 || seqNewer(r.seq, newestSeq))) {
+            newest = s;
+            newestSeq = r.seq;
+        }
+    }
+    if (newest < 0) {
+        s_nextSlot = 0;
+        return;
+    }
+
+    // Walk it to the first erased slot; bad records are skipped, not fatal
+    uint32_t first = newest * JOURNAL_PER_SECTOR;
+    s_nextSlot = (first + JOURNAL_PER_SECTOR) % s_slots;
+    for (uint32_t slot = first; slot < first + JOURNAL_PER_SECTOR; slot++) {
+        if (!readSlot(slot, &r)) break;
+        if (recordErased(&r)) {
+            s_nextSlot = slot;
+            break;
+        }
+        if (!recordValid(&r)) {
+            s_stats.corrupt++;
+            continue;
+        }
+        if (!s_haveLast || seqNewer(r.seq, s_last.seq)) {
+            s_last = r;
+            s_haveLast = true;
+        }
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+bool stats_journal_init() {
+#if !USE_STATS_JOURNAL
+    return false;
+#else
+    if (s_initDone) return s_part != NULL;
+    s_initDone = true;
+
+    s_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                      (esp_partition_subtype_t)JOURNAL_SUBTYPE, JOURNAL_PARTITION);
+    if (!s_part || s_part->size < 2 * JOURNAL_SECTOR_SIZE) {
+        s_part = NULL;
+        Serial.println("[JOURNAL] No journal partition - stats stay in NVS");
+        return false;
+    }
+    s_slots = (s_part->size / JOURNAL_SECTOR_SIZE) * JOURNAL_PER_SECTOR;
+
+    uint32_t start = micros();
+    replay();
+    s_stats.replayUs = micros() - start;
+    s_stats.present = true;
+    s_stats.sectors = s_part->size / JOURNAL_SECTOR_SIZE;
+    s_stats.seq = s_haveLast ? s_last.seq : 0;
+
+    Serial.printf("[JOURNAL] %lu sectors, record %lu at slot %lu, replay %lu us (%lu bad)\n",
+                  s_stats.sectors, s_stats.seq, s_nextSlot, s_stats.replayUs, s_stats.corrupt);
+    return true;
+#endif
+}
+
+bool stats_journal_load(mining_persistence_t *stats) {
+    if (!s_part || !s_haveLast) return false;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->lifetimeHashes = s_last.lifetimeHashes;
+    stats->lifetimeShares = s_last.lifetimeShares;
+    stats->lifetimeAccepted = s_last.lifetimeAccepted;
+    stats->lifetimeRejected = s_last.lifetimeRejected;
+    stats->lifetimeBlocks = s_last.lifetimeBlocks;
+    stats->totalUptimeSeconds = s_last.totalUptimeSeconds;
+    stats->bestDifficultyEver = s_last.bestDifficultyEver;
+    stats->sessionCount = s_last.sessionCount;
+    stats->magic = STATS_MAGIC;
+    return true;
+}
+
+bool stats_journal_append(const mining_persistence_t *stats) {
+    if (!s_part) return false;
+
+    journal_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.magic = JOURNAL_MAGIC;
+    r.seq = s_haveLast ? s_last.seq + 1 : 1;
+    r.lifetimeHashes = stats->lifetimeHashes;
+    r.lifetimeShares = stats->lifetimeShares;
+    r.lifetimeAccepted = stats->lifetimeAccepted;
+    r.lifetimeRejected = stats->lifetimeRejected;
+    r.lifetimeBlocks = stats->lifetimeBlocks;
+    r.totalUptimeSeconds = stats->totalUptimeSeconds;
+    r.bestDifficultyEver = stats->bestDifficultyEver;
+    r.sessionCount = stats->sessionCount;
+    r.crc = recordCrc(&r);
+
+    uint32_t start = micros();
+    uint32_t slot = s_nextSlot;
+
+    // Entering a sector: erase it (the oldest records once the log wraps)
+    if (slot % JOURNAL_PER_SECTOR == 0) {
+        if (esp_partition_erase_range(s_part, slot * sizeof(r), JOURNAL_SECTOR_SIZE) != ESP_OK) {
+            Serial.println("[JOURNAL] Sector erase failed");
+            return false;
+        }
+        s_stats.erases++;
+    }
+
+    // The slot is used even if the write fails: it may hold a partial record
+    esp_err_t err = esp_partition_write(s_part, slot * sizeof(r), &r, sizeof(r));
+    s_nextSlot = (slot + 1) % s_slots;
+    s_stats.lastWriteUs = micros() - start;
+    if (err != ESP_OK) {
+        Serial.printf("[JOURNAL] Write failed at slot %lu\n", slot);
+        return false;
+    }
+
+    s_last = r;
+    s_haveLast = true;
+    s_stats.seq = r.seq;
+    s_stats.appends++;
+    return true;
+}
+
+bool stats_journal_erase() {
+    if (!stats_journal_init()) return false;
+    if (esp_partition_erase_range(s_part, 0, s_part->size) != ESP_OK) {
+        Serial.println("[JOURNAL] Erase failed");
+        return false;
+    }
+    s_nextSlot = 0;
+    s_haveLast = false;
+    s_stats.seq = 0;
+    return true;
+}
+
+void stats_journal_get_stats(stats_journal_stats_t *out) {
+    memcpy(out, &s_stats, sizeof(*out));
+}
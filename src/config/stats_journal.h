@@ -0,0 +1,91 @@
+/*
+ * SparkMiner - Stats Journal
+ * Append-only log of the lifetime stats in its own flash partition, so a
+ * save is one 64-byte write instead of an NVS blob rewrite (and the page
+ * copies NVS does behind it).
+ *
+ * Each record holds the full totals: the counter deltas gathered in RAM
+ * since the last save, added to the previous record. A torn or corrupt
+ * record fails its CRC and is skipped, which costs one save, never the
+ * totals. Records fill the partition's 4 KB sectors in order, and the
+ * oldest sector is erased when the log wraps.
+ *
+ * Boot replay reads the first record of each sector to find the newest one,
+ * then scans that sector: at most JOURNAL_SECTORS + JOURNAL_PER_SECTOR reads.
+ *
+ * Built in with USE_STATS_JOURNAL=1; needs a data partition named
+ * JOURNAL_PARTITION (subtype 0x40), otherwise stats stay in NVS.
+ */
+
+#ifndef STATS_JOURNAL_H
+#define STATS_JOURNAL_H
+
+#include <Arduino.h>
+#include "nvs_config.h"
+
+#define JOURNAL_MAGIC       0x4A524E4C  // "JRNL"
+#define JOURNAL_SUBTYPE     0x40        // Custom data partition subtype
+#define JOURNAL_SECTOR_SIZE 4096
+#define JOURNAL_PER_SECTOR  (JOURNAL_SECTOR_SIZE / sizeof(journal_record_t))
+
+/**
+ * One journal record (flash-aligned, 64 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint32_t magic;             // JOURNAL_MAGIC (erased flash reads 0xFFFFFFFF)
+    uint32_t seq;               // Record number, increasing
+    uint64_t lifetimeHashes;
+    uint32_t lifetimeShares;
+    uint32_t lifetimeAccepted;
+    uint32_t lifetimeRejected;
+    uint32_t lifetimeBlocks;
+    uint32_t totalUptimeSeconds;
+    double bestDifficultyEver;
+    uint32_t sessionCount;
+    uint8_t reserved[12];       // Zero; keeps records on 64-byte boundaries
+    uint32_t crc;               // CRC32 of everything above
+} journal_record_t;
+
+/**
+ * Journal counters since boot
+ */
+typedef struct {
+    bool present;               // Partition found
+    uint32_t sectors;
+    uint32_t seq;               // Newest record
+    uint32_t appends;
+    uint32_t erases;            // Sectors erased on wrap
+    uint32_t corrupt;           // Records skipped at replay (bad CRC)
+    uint32_t replayUs;          // Boot replay time
+    uint32_t lastWriteUs;       // Last append, erase included
+} stats_journal_stats_t;
+
+/**
+ * Find the partition and replay it
+ * @return true if the journal is available
+ */
+bool stats_journal_init();
+
+/**
+ * Newest record replayed at init
+ * @return false if the journal is missing or empty
+ */
+bool stats_journal_load(mining_persistence_t *stats);
+
+/**
+ * Append the totals as a new record
+ * Call from one task only (the monitor task saves stats).
+ */
+bool stats_journal_append(const mining_persistence_t *stats);
+
+/**
+ * Erase the whole journal (factory reset)
+ */
+bool stats_journal_erase();
+
+/**
+ * Copy the journal counters
+ */
+void stats_journal_get_stats(stats_journal_stats_t *out);
+
+#endif // STATS_JOURNAL_H
@@ -5,10 +5,12 @@
 
 #include <Arduino.h>
 #include <WiFiManager.h>
+#include <esp_system.h>
 #include <board_config.h>
 #include "wifi_manager.h"
 #include "nvs_config.h"
 #include "../stratum/stratum.h"
+#include "../mining/miner.h"
 #include "../display/display.h"
 
 // WiFiManager instance
@@ -54,6 +56,23 @@ static char s_httpsStatsHtml[512];
 static char s_bufPoolPort[8];
 static char s_bufBackupPort[8];
 
+// Fast boot: connection timing and the cached access point in use
+static bool s_begun = false;
+static bool s_fastJoin = false;         // Joining by cached BSSID/channel
+static uint32_t s_beginMs = 0;
+static uint32_t s_connectMs = 0;        // Boot to first connection (0 = not yet)
+
+#if FAST_BOOT_REUSE_IP
+// Lease of the running session; RTC memory keeps it across software resets only
+#define WIFI_LEASE_MAGIC 0x4C454153  // "LEAS"
+typedef struct {
+    uint32_t magic;
+    uint32_t ssidHash;
+    uint32_t ip, gateway, mask, dns;
+} wifi_lease_t;
+static RTC_NOINIT_ATTR wifi_lease_t s_lease;
+#endif
+
 // ============================================================ 
 // Callbacks
 // ============================================================ 
@@ -145,6 +164,7 @@ static void saveParamsCallback() {
         // Update stratum
         stratum_set_pool(config->poolUrl, config->poolPort,
                         config->wallet, config->poolPassword, config->workerName);
+        stratum_set_difficulty(config->targetDifficulty);
         stratum_reconnect();
     } else {
         Serial.println("[WIFI] Failed to save configuration");
@@ -166,10 +186,118 @@ static void configModeCallback(WiFiManager *wm) {
     #endif
 }
 
+// Any WiFi event (connect, disconnect, got IP, scan) means the network
+// stack is about to be busy - let the mining cores yield more often
+static void wifiEventCallback(WiFiEvent_t event) {
+    miner_yield_hint();
+}
+
 // ============================================================ 
 // Public API
 // ============================================================ 
 
+// ============================================================
+// Fast Reconnect
+// ============================================================
+
+static uint32_t ssidHash(const char *ssid) {
+    uint32_t hash = 2166136261u;
+    while (ssid && *ssid) {
+        hash ^= (uint8_t)*ssid++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#if FAST_BOOT_REUSE_IP
+// Soft resets only: after a power loss the lease may have gone to someone else
+static bool leaseUsable(uint32_t hash) {
+    esp_reset_reason_t reason = esp_reset_reason();
+    bool softReset = (reason == ESP_RST_SW || reason == ESP_RST_PANIC ||
+                      reason == ESP_RST_INT_WDT || reason == ESP_RST_TASK_WDT ||
+                      reason == ESP_RST_WDT);
+    return softReset && s_lease.magic == WIFI_LEASE_MAGIC && s_lease.ssidHash == hash && s_lease.ip;
+}
+#endif
+
+// Cache the access point (NVS, only when it changed) and the lease (RTC)
+static void rememberConnection(const miner_config_t *config) {
+    if (!s_connectMs) {
+        s_connectMs = millis();
+        Serial.printf("[WIFI] Connected %lu ms after boot (%lu ms to join%s)\n", s_connectMs,
+                      s_connectMs - s_beginMs, s_fastJoin ? ", cached AP" : "");
+    }
+
+#if FAST_BOOT
+    wifi_cache_t cache, stored;
+    memset(&cache, 0, sizeof(cache));
+    cache.ssidHash = ssidHash(config->ssid);
+    memcpy(cache.bssid, WiFi.BSSID(), sizeof(cache.bssid));
+    cache.channel = WiFi.channel();
+    cache.magic = WIFI_CACHE_MAGIC;
+    if (!nvs_wifi_cache_load(&stored) || memcmp(&stored, &cache, sizeof(cache)) != 0) {
+        nvs_wifi_cache_save(&cache);
+    }
+#endif
+
+#if FAST_BOOT_REUSE_IP
+    s_lease.magic = WIFI_LEASE_MAGIC;
+    s_lease.ssidHash = ssidHash(config->ssid);
+    s_lease.ip = (uint32_t)WiFi.localIP();
+    s_lease.gateway = (uint32_t)WiFi.gatewayIP();
+    s_lease.mask = (uint32_t)WiFi.subnetMask();
+    s_lease.dns = (uint32_t)WiFi.dnsIP();
+#endif
+}
+
+void wifi_manager_begin() {
+    miner_config_t *config = nvs_config_get();
+    if (s_begun || !config->ssid[0]) return;
+    s_begun = true;
+    s_beginMs = millis();
+
+#if FAST_BOOT_REUSE_IP
+    if (leaseUsable(ssidHash(config->ssid))) {
+        WiFi.config(IPAddress(s_lease.ip), IPAddress(s_lease.gateway),
+                    IPAddress(s_lease.mask), IPAddress(s_lease.dns));
+        Serial.printf("[WIFI] Reusing lease %s\n", IPAddress(s_lease.ip).toString().c_str());
+    }
+#endif
+
+#if FAST_BOOT
+    wifi_cache_t cache;
+    if (nvs_wifi_cache_load(&cache) && cache.ssidHash == ssidHash(config->ssid)) {
+        Serial.printf("[WIFI] Joining %s on channel %u (%02X:%02X:%02X:%02X:%02X:%02X)\n",
+                      config->ssid, cache.channel, cache.bssid[0], cache.bssid[1], cache.bssid[2],
+                      cache.bssid[3], cache.bssid[4], cache.bssid[5]);
+        WiFi.begin(config->ssid, config->wifiPassword, cache.channel, cache.bssid);
+        s_fastJoin = true;
+        return;
+    }
+#endif
+
+    WiFi.begin(config->ssid, config->wifiPassword);
+}
+
+void wifi_manager_reconnect(bool scan) {
+    miner_config_t *config = nvs_config_get();
+    if (!config->ssid[0]) return;
+
+#if FAST_BOOT
+    wifi_cache_t cache;
+    if (!scan && nvs_wifi_cache_load(&cache) && cache.ssidHash == ssidHash(config->ssid)) {
+        WiFi.begin(config->ssid, config->wifiPassword, cache.channel, cache.bssid);
+        return;
+    }
+#endif
+
+    WiFi.begin(config->ssid, config->wifiPassword);
+}
+
+uint32_t wifi_manager_connect_ms() {
+    return s_connectMs;
+}
+
 void wifi_manager_init() {
     if (s_initialized) return;
 
@@ -421,6 +549,8 @@ void wifi_manager_init() {
     s_wm.addParameter(s_paramStatsProxy);
     s_wm.addParameter(s_paramHttpsStats);
 
+    WiFi.onEvent(wifiEventCallback);
+
     s_initialized = true;
     Serial.println("[WIFI] Manager initialized");
 }
@@ -461,6 +591,7 @@ void wifi_manager_blocking() {
         config->ssid[MAX_SSID_LENGTH] = '\0';
         strncpy(config->wifiPassword, WiFi.psk().c_str(), MAX_PASSWORD_LEN);
         config->wifiPassword[MAX_PASSWORD_LEN] = '\0';
+        rememberConnection(config);
 
         // Configure NTP
         long gmtOffset = config->timezoneOffset * 3600L;
@@ -509,20 +640,24 @@ void wifi_manager_start() {
     // If we have stored credentials, try to connect directly
     if (config->ssid[0] != '\0') {
         Serial.printf("[WIFI] Connecting to %s...\n", config->ssid);
-        WiFi.begin(config->ssid, config->wifiPassword);
-
-        // Wait up to 10 seconds
-        int attempts = 0;
-        while (WiFi.status() != WL_CONNECTED && attempts < 20) {
-            delay(500);
-            Serial.print(".");
-            attempts++;
+        wifi_manager_begin();  // Usually already joining since early setup
+
+        // Wait up to 10 seconds; a cached AP that doesn't answer gets a full scan
+        while (WiFi.status() != WL_CONNECTED && millis() - s_beginMs < 10000) {
+            if (s_fastJoin && millis() - s_beginMs >= FAST_BOOT_JOIN_MS) {
+                Serial.println("[WIFI] Cached AP not answering - scanning");
+                s_fastJoin = false;
+                s_beginMs = millis();
+                WiFi.disconnect();
+                WiFi.begin(config->ssid, config->wifiPassword);
+            }
+            delay(50);
         }
-        Serial.println();
 
         if (WiFi.status() == WL_CONNECTED) {
             Serial.printf("[WIFI] Connected! IP: %s\n", WiFi.localIP().toString().c_str());
             strncpy(s_ipAddress, WiFi.localIP().toString().c_str(), sizeof(s_ipAddress));
+            rememberConnection(config);
             
             // Configure NTP
             long gmtOffset = config->timezoneOffset * 3600L;
@@ -24,6 +24,25 @@ void wifi_manager_init();
  */
 void wifi_manager_blocking();
 
+/**
+ * Start joining the stored network without waiting
+ * Joins the cached access point by BSSID and channel when FAST_BOOT has
+ * one for this SSID. wifi_manager_start() waits for the result.
+ */
+void wifi_manager_begin();
+
+/**
+ * Rejoin the stored network after the link dropped (no waiting)
+ * @param scan  false: the cached access point by BSSID and channel (if
+ *              there is one), true: a full scan
+ */
+void wifi_manager_reconnect(bool scan);
+
+/**
+ * Boot to first WiFi connection (ms), 0 until connected
+ */
+uint32_t wifi_manager_connect_ms();
+
 /**
  * Start WiFi manager in non-blocking mode
  * Returns immediately, check wifi_manager_is_connected()
@@ -87,7 +87,6 @@
 // ============================================================
 
 static TFT_eSPI s_tft = TFT_eSPI();
-static TFT_eSprite s_sprite = TFT_eSprite(&s_tft);
 
 // Touch controller disabled - see memory bank for implementation issues
 // #if defined(ESP32_2432S028)
@@ -99,7 +98,95 @@ static uint8_t s_currentScreen = SCREEN_MINING;
 static uint8_t s_brightness = 100;
 static uint8_t s_rotation = 1;  // Current rotation (0-3)
 static bool s_needsRedraw = true;
-static display_data_t s_lastData;
+static bool s_clockHadTime = false;     // Clock screen layout depends on SNTP time
+static struct tm s_clockTime;
+
+// ============================================================
+// Retained Widgets
+// ============================================================
+
+// Every value on screen is a widget that remembers what it last drew.
+// Static chrome (panels, labels, logo) is only drawn on a full redraw;
+// after that a frame re-rasterizes just the widgets whose text or color
+// changed, each clipped to its own box. Slots are reused by every screen
+// and all invalidated by a full redraw, so positions never go stale.
+
+#define WIDGET_MAX      24
+#define WIDGET_TEXT     32
+#define CHAR_W          6       // GLCD font cell width at text size 1
+#define CHAR_H          8
+
+typedef struct {
+    char text[WIDGET_TEXT];
+    uint16_t color;
+    bool valid;
+} widget_t;
+
+// Shared by all screens: header (landscape) or bottom bar (portrait)
+enum {
+    W_TEMP,
+    W_WAN,
+    W_POOL,
+    W_SCREEN_FIRST
+};
+
+// Mining screen
+enum {
+    W_M_HASHRATE = W_SCREEN_FIRST,
+    W_M_SHARES,
+    W_M_GRID,                   // 6 grid cells
+    W_M_POOLNAME = W_M_GRID + 6,
+    W_M_WORKERS,
+    W_M_DIFF,
+    W_M_FEE,
+    W_M_POOLHR,
+    W_M_BLOCK,
+    W_M_LAN
+};
+
+// Stats screen
+enum {
+    W_S_PRICE = W_SCREEN_FIRST,
+    W_S_BLOCK,
+    W_S_NETHR,
+    W_S_FEE,
+    W_S_NETDIFF,
+    W_S_WORKERS,
+    W_S_RATE,
+    W_S_EFF,
+    W_S_BEST,
+    W_S_SHARES
+};
+
+// Clock screen
+enum {
+    W_C_TIME = W_SCREEN_FIRST,
+    W_C_DATE,
+    W_C_HASH,
+    W_C_PRICE,
+    W_C_SHARES,
+    W_C_BLOCK
+};
+
+static widget_t s_widgets[WIDGET_MAX];
+static display_frame_stats_t s_frameStats;
+static uint32_t s_frameWidgets = 0;     // Current frame's counters
+static uint32_t s_framePixels = 0;
+
+#if USE_DISPLAY_DMA
+// Double-buffered DMA tiles: a widget is rasterized into one tile while
+// the other is still streaming to the panel, and the monitor task sleeps
+// in the SPI driver instead of spinning on the FIFO. Widgets taller than
+// DISPLAY_DMA_ROWS go out in bands.
+static TFT_eSprite s_tileA = TFT_eSprite(&s_tft);
+static TFT_eSprite s_tileB = TFT_eSprite(&s_tft);
+static TFT_eSprite *s_tiles[2] = { &s_tileA, &s_tileB };
+static uint8_t s_tileNext = 0;
+static int s_tileW = 0;
+static bool s_dmaReady = false;         // Tiles allocated and DMA channel up
+static bool s_dmaFrame = false;         // This frame may push by DMA
+static bool s_dmaOpen = false;          // startWrite() held for queued pushes
+#endif
 
 // ============================================================
 // Helper Functions
@@ -122,61 +209,86 @@ static void setBacklight(uint8_t percent) {
     ledcWrite(LEDC_CHANNEL, duty);
 }
 
-static String formatHashrate(double hashrate) {
+static const char *formatHashrate(char *buf, size_t len, double hashrate) {
     if (hashrate >= 1e9) {
-        return String(hashrate / 1e9, 2) + " GH/s";
+        snprintf(buf, len, "%.2f GH/s", hashrate / 1e9);
     } else if (hashrate >= 1e6) {
-        return String(hashrate / 1e6, 2) + " MH/s";
+        snprintf(buf, len, "%.2f MH/s", hashrate / 1e6);
     } else if (hashrate >= 1e3) {
-        return String(hashrate / 1e3, 2) + " KH/s";
+        snprintf(buf, len, "%.2f KH/s", hashrate / 1e3);
+    } else {
+        snprintf(buf, len, "%.1f H/s", hashrate);
+    }
+    return buf;
+}
+
+static const char *formatEfficiency(char *buf, size_t len, double hashesPerJoule, bool measured) {
+    const char *approx = measured ? "" : "~";
+    if (hashesPerJoule <= 0) {
+        snprintf(buf, len, "---");
+    } else if (hashesPerJoule >= 1e6) {
+        snprintf(buf, len, "%s%.2fMH/W", approx, hashesPerJoule / 1e6);
+    } else if (hashesPerJoule >= 1e3) {
+        snprintf(buf, len, "%s%.1fKH/W", approx, hashesPerJoule / 1e3);
     } else {
-        return String(hashrate, 1) + " H/s";
+        snprintf(buf, len, "%s%.0fH/W", approx, hashesPerJoule);
     }
+    return buf;
 }
 
-static String formatNumber(uint64_t num) {
+static const char *formatNumber(char *buf, size_t len, uint64_t num) {
     if (num >= 1e12) {
-        return String((double)num / 1e12, 2) + "T";
+        snprintf(buf, len, "%.2fT", (double)num / 1e12);
     } else if (num >= 1e9) {
-        return String((double)num / 1e9, 2) + "G";
+        snprintf(buf, len, "%.2fG", (double)num / 1e9);
     } else if (num >= 1e6) {
-        return String((double)num / 1e6, 2) + "M";
+        snprintf(buf, len, "%.2fM", (double)num / 1e6);
     } else if (num >= 1e3) {
-        return String((double)num / 1e3, 2) + "K";
+        snprintf(buf, len, "%.2fK", (double)num / 1e3);
     } else {
-        return String((uint32_t)num);
+        snprintf(buf, len, "%lu", (uint32_t)num);
     }
+    return buf;
 }
 
-static String formatUptime(uint32_t seconds) {
+static const char *formatUptime(char *buf, size_t len, uint32_t seconds) {
     uint32_t days = seconds / 86400;
     uint32_t hours = (seconds % 86400) / 3600;
     uint32_t mins = (seconds % 3600) / 60;
     uint32_t secs = seconds % 60;
 
     if (days > 0) {
-        return String(days) + "d " + String(hours) + "h";
+        snprintf(buf, len, "%lud %luh", days, hours);
     } else if (hours > 0) {
-        return String(hours) + "h " + String(mins) + "m";
+        snprintf(buf, len, "%luh %lum", hours, mins);
     } else {
-        return String(mins) + "m " + String(secs) + "s";
+        snprintf(buf, len, "%lum %lus", mins, secs);
     }
+    return buf;
 }
 
-static String formatDifficulty(double diff) {
+static const char *formatDifficulty(char *buf, size_t len, double diff) {
     if (diff >= 1e15) {
-        return String(diff / 1e15, 2) + "P";
+        snprintf(buf, len, "%.2fP", diff / 1e15);
     } else if (diff >= 1e12) {
-        return String(diff / 1e12, 2) + "T";
+        snprintf(buf, len, "%.2fT", diff / 1e12);
     } else if (diff >= 1e9) {
-        return String(diff / 1e9, 2) + "G";
+        snprintf(buf, len, "%.2fG", diff / 1e9);
     } else if (diff >= 1e6) {
-        return String(diff / 1e6, 2) + "M";
+        snprintf(buf, len, "%.2fM", diff / 1e6);
     } else if (diff >= 1e3) {
-        return String(diff / 1e3, 2) + "K";
+        snprintf(buf, len, "%.2fK", diff / 1e3);
     } else {
-        return String(diff, 4);
+        snprintf(buf, len, "%.4f", diff);
     }
+    return buf;
+}
+
+// "---" for values the APIs haven't delivered yet
+static const char *formatCount(char *buf, size_t len, uint32_t value, const char *suffix = "") {
+    if (value == 0) return "---";
+    snprintf(buf, len, "%lu%s", value, suffix);
+    return buf;
 }
 
 // Color coding helpers for status indicators
@@ -201,6 +313,165 @@ static uint16_t getWifiColor(int rssi) {
     return COLOR_ERROR;                           // Bad: <-75dBm
 }
 
+static void invalidateWidgets() {
+    for (int i = 0; i < WIDGET_MAX; i++) s_widgets[i].valid = false;
+}
+
+// Record text/color for a widget; false if it already shows exactly that
+static bool widgetChanged(uint8_t id, const char *text, uint16_t color) {
+    widget_t *wg = &s_widgets[id];
+    if (wg->valid && wg->color == color && strcmp(wg->text, text) == 0) return false;
+    strncpy(wg->text, text, WIDGET_TEXT - 1);
+    wg->text[WIDGET_TEXT - 1] = '\0';
+    wg->color = color;
+    wg->valid = true;
+    return true;
+}
+
+static void framePushed(int w, int h) {
+    s_frameWidgets++;
+    s_framePixels += (uint32_t)w * h;
+}
+
+#if USE_DISPLAY_DMA
+static void dmaInit() {
+    // Tiles span the long side so they fit every rotation
+    s_tileW = max(s_tft.width(), s_tft.height());
+    for (int i = 0; i < 2; i++) {
+        s_tiles[i]->setColorDepth(16);
+        if (!s_tiles[i]->createSprite(s_tileW, DISPLAY_DMA_ROWS)) {
+            s_tileA.deleteSprite();
+            s_tileB.deleteSprite();
+            Serial.println("[DISPLAY] No RAM for DMA tiles, using blocking pushes");
+            return;
+        }
+    }
+    if (!s_tft.initDMA()) {
+        s_tileA.deleteSprite();
+        s_tileB.deleteSprite();
+        Serial.println("[DISPLAY] DMA unavailable, using blocking pushes");
+        return;
+    }
+    s_dmaReady = true;
+    Serial.printf("[DISPLAY] DMA pushes enabled (2 x %dx%d tiles)\n", s_tileW, DISPLAY_DMA_ROWS);
+}
+
+// Wait for queued pushes before drawing through the blocking path (or
+// handing the bus to anyone else)
+static void dmaFlush() {
+    if (!s_dmaOpen) return;
+    s_tft.dmaWait();
+    s_tft.endWrite();
+    s_dmaOpen = false;
+}
+
+/**
+ * Queue a text widget by DMA, one band of rows at a time
+ * pushImageDMA() waits for the transfer in flight before queuing the next,
+ * so the tile being filled here is never the one still streaming.
+ */
+static void pushFieldDma(int x, int y, int w, int h, uint8_t size,
+                         uint16_t color, uint16_t bg, const char *text, int textX) {
+    if (!s_dmaOpen) {
+        s_tft.startWrite();
+        s_dmaOpen = true;
+    }
+
+    for (int band = 0; band < h; band += DISPLAY_DMA_ROWS) {
+        int rows = min(DISPLAY_DMA_ROWS, h - band);
+        TFT_eSprite *tile = s_tiles[s_tileNext];
+        s_tileNext ^= 1;
+
+        tile->fillRect(0, 0, w, rows, bg);
+        tile->setTextSize(size);
+        tile->setTextColor(color, bg);
+        tile->setCursor(textX - x, -band);
+        tile->print(text);
+
+        // Pack rows to the widget's width: the DMA window is w pixels wide
+        uint16_t *buf = (uint16_t *)tile->getPointer();
+        for (int r = 1; r < rows; r++) {
+            memmove(buf + r * w, buf + r * s_tileW, w * sizeof(uint16_t));
+        }
+        s_tft.pushImageDMA(x, y + band, w, rows, buf);
+    }
+}
+#endif
+
+/**
+ * Draw a text widget into its box (x, y, w, one text line high)
+ * Glyph cells are drawn with the background color and the rest of the box
+ * is filled, so the old value is overwritten in one pass without a sprite
+ * or a clear-then-draw flicker. Text too wide for the box ends in "..".
+ */
+static void drawField(uint8_t id, int x, int y, int w, uint8_t size,
+                      uint16_t color, uint16_t bg, const char *text, bool center = false) {
+    if (w <= 0 || !widgetChanged(id, text, color)) return;
+
+    char clipped[WIDGET_TEXT];
+    int maxChars = w / (CHAR_W * size);
+    int len = strlen(text);
+    if (len > maxChars && maxChars >= 3) {
+        memcpy(clipped, text, maxChars - 2);
+        clipped[maxChars - 2] = '.';
+        clipped[maxChars - 1] = '.';
+        clipped[maxChars] = '\0';
+        text = clipped;
+        len = maxChars;
+    }
+
+    int h = CHAR_H * size;
+    int tw = len * CHAR_W * size;
+    int tx = center ? x + (w - tw) / 2 : x;
+    framePushed(w, h);
+
+#if USE_DISPLAY_DMA
+    if (s_dmaFrame && w <= s_tileW) {
+        pushFieldDma(x, y, w, h, size, color, bg, text, tx);
+        return;
+    }
+    dmaFlush();
+#endif
+
+    if (tx > x) s_tft.fillRect(x, y, tx - x, h, bg);
+    s_tft.setTextSize(size);
+    s_tft.setTextColor(color, bg);
+    s_tft.setCursor(tx, y);
+    s_tft.print(text);
+    if (tx + tw < x + w) s_tft.fillRect(tx + tw, y, x + w - tx - tw, h, bg);
+}
+
+/**
+ * Draw a status dot with its reading to the right (e.g. RSSI, ping)
+ * The box covers both; the dot color is part of the retained state.
+ */
+static void drawIndicator(uint8_t id, int x, int y, int w, int h, int r,
+                          int textX, int textY, uint16_t color, const char *text) {
+    if (!widgetChanged(id, text, color)) return;
+
+#if USE_DISPLAY_DMA
+    dmaFlush();
+#endif
+    s_tft.fillRect(x, y, w, h, COLOR_PANEL);
+    s_tft.fillCircle(x + r, y + h / 2, r, color);
+    s_tft.setTextSize(1);
+    s_tft.setTextColor(color);
+    s_tft.setCursor(textX, textY);
+    s_tft.print(text);
+    framePushed(w, h);
+}
+
+// Width of a literal label at text size 1 (its value widget starts after it)
+#define LABEL_W(label)  ((int)(sizeof(label) - 1) * CHAR_W)
+
+// Static label, drawn with the chrome
+static void drawLabel(int x, int y, uint16_t color, const char *label) {
+    s_tft.setTextSize(1);
+    s_tft.setTextColor(color);
+    s_tft.setCursor(x, y);
+    s_tft.print(label);
+}
+
 // ============================================================
 // Spark Logo Drawing
 // ============================================================
@@ -266,88 +537,74 @@ static int getMajorVersion() {
 // Screen Drawing Functions
 // ============================================================
 
-static void drawHeader(const display_data_t *data) {
+static void drawHeader(const display_data_t *data, bool full) {
     int w = display_get_width();
     bool isPortrait = display_is_portrait();
-    
-    // Dark header with accent line
-    s_tft.fillRect(0, 0, w, HEADER_HEIGHT, COLOR_PANEL);
-    s_tft.drawFastHLine(0, HEADER_HEIGHT - 1, w, COLOR_ACCENT);
+    int rightEdge = w - MARGIN;
+    int poolX = rightEdge - 40;
+    int wanX = poolX - 45;
 
-    // Spark logo
-    drawSparkLogo(8, 5, 30);
+    if (full) {
+        // Dark header with accent line
+        s_tft.fillRect(0, 0, w, HEADER_HEIGHT, COLOR_PANEL);
+        s_tft.drawFastHLine(0, HEADER_HEIGHT - 1, w, COLOR_ACCENT);
 
-    // Title with spark gradient effect
-    s_tft.setTextColor(COLOR_ACCENT);
-    s_tft.setTextSize(2);
-    s_tft.setCursor(42, 12);
-    s_tft.print("Spark");
-    s_tft.setTextColor(COLOR_SPARK1);
-    s_tft.print("Miner");
+        // Spark logo
+        drawSparkLogo(8, 5, 30);
 
-    // Major version badge
-    s_tft.setTextSize(1);
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(162, 16);
-    s_tft.print("V");
-    s_tft.print(getMajorVersion());
-
-    if (!isPortrait) {
-        // Status indicators (right side) - compact layout with color coding
-        // Layout: Temp | WAN | POOL (right to left from right edge)
-        s_tft.setTextSize(1);
-        int rightEdge = w - MARGIN;
+        // Title with spark gradient effect
+        s_tft.setTextColor(COLOR_ACCENT);
+        s_tft.setTextSize(2);
+        s_tft.setCursor(42, 12);
+        s_tft.print("Spark");
+        s_tft.setTextColor(COLOR_SPARK1);
+        s_tft.print("Miner");
 
-        // POOL status - rightmost (color coded by ping)
-        int poolX = rightEdge - 40;
+        // Major version badge
+        s_tft.setTextSize(1);
         s_tft.setTextColor(COLOR_DIM);
-        s_tft.setCursor(poolX, 6);
-        s_tft.print("POOL");
-        uint16_t pingColor = data->poolConnected ? getPingColor(data->avgLatency) : COLOR_ERROR;
-        if (data->poolConnected && data->poolFailovers > 0) pingColor = COLOR_WARNING;
-        s_tft.fillCircle(poolX + 6, 26, 5, pingColor);
-        if (data->poolConnected && data->avgLatency > 0) {
-            s_tft.setTextColor(pingColor);
-            s_tft.setCursor(poolX + 15, 22);
-            s_tft.print(data->avgLatency);
-        }
+        s_tft.setCursor(162, 16);
+        s_tft.print("V");
+        s_tft.print(getMajorVersion());
 
-        // WAN status - middle (color coded by signal strength)
-        int wanX = poolX - 45;
-        s_tft.setTextColor(COLOR_DIM);
-        s_tft.setCursor(wanX, 6);
-        s_tft.print("WAN");
-        uint16_t wifiColor = data->wifiConnected ? getWifiColor(data->wifiRssi) : COLOR_ERROR;
-        s_tft.fillCircle(wanX + 6, 26, 5, wifiColor);
-        if (data->wifiConnected) {
-            s_tft.setTextColor(wifiColor);
-            s_tft.setCursor(wanX + 15, 22);
-            s_tft.print(data->wifiRssi);
+        if (!isPortrait) {
+            drawLabel(poolX, 6, COLOR_DIM, "POOL");
+            drawLabel(wanX, 6, COLOR_DIM, "WAN");
         }
-
-        // Temperature - compact with color coding
-        float temp = temperatureRead();
-        uint16_t tempColor = getTempColor(temp);
-        s_tft.setTextColor(tempColor);
-        s_tft.setCursor(wanX - 28, 16);
-        s_tft.print((int)temp);
-        s_tft.print("C");
     }
+
+    if (isPortrait) return;
+
+    // Status indicators (right side) - compact layout with color coding
+    // Layout: Temp | WAN | POOL (right to left from right edge)
+    char buf[12];
+
+    // POOL status - rightmost (color coded by ping)
+    uint16_t pingColor = data->poolConnected ? getPingColor(data->avgLatency) : COLOR_ERROR;
+    if (data->poolConnected && data->poolFailovers > 0) pingColor = COLOR_WARNING;
+    buf[0] = '\0';
+    if (data->poolConnected && data->avgLatency > 0) snprintf(buf, sizeof(buf), "%lu", data->avgLatency);
+    drawIndicator(W_POOL, poolX + 1, 20, 39, 12, 5, poolX + 15, 22, pingColor, buf);
+
+    // WAN status - middle (color coded by signal strength)
+    uint16_t wifiColor = data->wifiConnected ? getWifiColor(data->wifiRssi) : COLOR_ERROR;
+    buf[0] = '\0';
+    if (data->wifiConnected) snprintf(buf, sizeof(buf), "%d", data->wifiRssi);
+    drawIndicator(W_WAN, wanX + 1, 20, 40, 12, 5, wanX + 15, 22, wifiColor, buf);
+
+    // Temperature - compact with color coding
+    float temp = temperatureRead();
+    snprintf(buf, sizeof(buf), "%dC", (int)temp);
+    drawField(W_TEMP, wanX - 28, 16, 24, 1, getTempColor(temp), COLOR_PANEL, buf);
 }
 
-static void drawBottomStatusBar(const display_data_t *data) {
+static void drawBottomStatusBar(const display_data_t *data, bool full) {
     if (!display_is_portrait()) return;
 
     int w = display_get_width();
     int h = display_get_height();
     int barHeight = 32;  // Taller for labels + values
     int y = h - barHeight;
-
-    // Draw panel background and border
-    s_tft.fillRect(0, y, w, barHeight, COLOR_PANEL);
-    s_tft.drawFastHLine(0, y, w, COLOR_SPARK2);
-
-    s_tft.setTextSize(1);
     int centerY = y + (barHeight / 2) - 4;
 
     // Layout: evenly space 3 sections across width
@@ -355,82 +612,65 @@ static void drawBottomStatusBar(const display_data_t *data) {
     // Section 2 (center): WAN + indicator (color coded by signal)
     // Section 3 (right): POOL + indicator (color coded by ping)
     int sectionW = w / 3;
+    int wanX = sectionW;
+    int poolX = sectionW * 2;
+
+    if (full) {
+        // Draw panel background and border
+        s_tft.fillRect(0, y, w, barHeight, COLOR_PANEL);
+        s_tft.drawFastHLine(0, y, w, COLOR_SPARK2);
+
+        drawLabel(MARGIN, centerY - 6, COLOR_DIM, "TEMP");
+        drawLabel(wanX, centerY - 6, COLOR_DIM, "WAN");
+        drawLabel(poolX, centerY - 6, COLOR_DIM, "POOL");
+    }
 
-    // Temperature on left - color coded with label
+    char buf[12];
+
+    // Temperature on left - color coded
     float temp = temperatureRead();
-    uint16_t tempColor = getTempColor(temp);
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN, centerY - 6);
-    s_tft.print("TEMP");
-    s_tft.setTextColor(tempColor);
-    s_tft.setCursor(MARGIN, centerY + 6);
-    s_tft.print((int)temp);
-    s_tft.print("C");
+    snprintf(buf, sizeof(buf), "%dC", (int)temp);
+    drawField(W_TEMP, MARGIN, centerY + 6, sectionW - MARGIN - 4, 1, getTempColor(temp), COLOR_PANEL, buf);
 
     // WAN Status - center section (color coded by signal strength)
-    int wanX = sectionW;
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(wanX, centerY - 6);
-    s_tft.print("WAN");
     uint16_t wifiColor = data->wifiConnected ? getWifiColor(data->wifiRssi) : COLOR_ERROR;
-    s_tft.fillCircle(wanX + 4, centerY + 8, 4, wifiColor);
-    if (data->wifiConnected) {
-        s_tft.setTextColor(wifiColor);
-        s_tft.setCursor(wanX + 12, centerY + 4);
-        s_tft.print(data->wifiRssi);
-    }
+    buf[0] = '\0';
+    if (data->wifiConnected) snprintf(buf, sizeof(buf), "%d", data->wifiRssi);
+    drawIndicator(W_WAN, wanX, centerY + 3, sectionW - 4, 10, 4, wanX + 12, centerY + 4, wifiColor, buf);
 
     // POOL Status - right section (color coded by ping)
-    int poolX = sectionW * 2;
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(poolX, centerY - 6);
-    s_tft.print("POOL");
     uint16_t pingColor = data->poolConnected ? getPingColor(data->avgLatency) : COLOR_ERROR;
     if (data->poolConnected && data->poolFailovers > 0) pingColor = COLOR_WARNING;
-    s_tft.fillCircle(poolX + 4, centerY + 8, 4, pingColor);
-    if (data->poolConnected && data->avgLatency > 0) {
-        s_tft.setTextColor(pingColor);
-        s_tft.setCursor(poolX + 14, centerY + 4);
-        s_tft.print(data->avgLatency);
-    }
+    buf[0] = '\0';
+    if (data->poolConnected && data->avgLatency > 0) snprintf(buf, sizeof(buf), "%lu", data->avgLatency);
+    drawIndicator(W_POOL, poolX, centerY + 3, w - poolX - 4, 10, 4, poolX + 14, centerY + 4, pingColor, buf);
 }
 
-static void drawMiningScreen(const display_data_t *data) {
+static void drawMiningScreen(const display_data_t *data, bool full) {
     int w = display_get_width();
     int y = HEADER_HEIGHT + 8;
     bool isPortrait = display_is_portrait();
-
-    // Hashrate panel with glow effect
-    s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_ACCENT);
-
-    // Sprite buffered hashrate
-    int hrWidth = 160;
-    int hrHeight = 24;
-    s_sprite.createSprite(hrWidth, hrHeight);
-    s_sprite.fillSprite(COLOR_PANEL);
-    s_sprite.setTextColor(COLOR_ACCENT, COLOR_PANEL);
-    s_sprite.setTextSize(2);
-    s_sprite.setCursor(0, 4);
-    s_sprite.print(formatHashrate(data->hashRate));
-    s_sprite.pushSprite(MARGIN + 4, y + 6);
-    s_sprite.deleteSprite();
+    char buf[WIDGET_TEXT];
 
     // Shares on right side of hashrate panel
     // Portrait: shift toward center to fit 5+ digit share counts (e.g., "12345/12345")
     int sharesX = isPortrait ? (w - 75) : (w - 100);
-    s_tft.setTextSize(1);
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(sharesX, y + 4);
-    s_tft.print("Shares");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.setCursor(sharesX, y + 16);
-    String shares = String(data->sharesAccepted) + "/" + String(data->sharesAccepted + data->sharesRejected);
-    s_tft.print(shares);
 
-    y += 44;
+    if (full) {
+        // Hashrate panel with glow effect
+        s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_ACCENT);
+        drawLabel(sharesX, y + 4, COLOR_DIM, "Shares");
+    }
 
-    s_tft.setTextSize(1);
+    int hrWidth = min(160, sharesX - MARGIN - 8);
+    drawField(W_M_HASHRATE, MARGIN + 4, y + 10, hrWidth, 2, COLOR_ACCENT, COLOR_PANEL,
+              formatHashrate(buf, sizeof(buf), data->hashRate));
+
+    snprintf(buf, sizeof(buf), "%lu/%lu", data->sharesAccepted, data->sharesAccepted + data->sharesRejected);
+    drawField(W_M_SHARES, sharesX, y + 16, w - MARGIN - sharesX, 1, COLOR_FG, COLOR_PANEL, buf);
+
+    y += 44;
 
     // Stats grid with panels
     // Landscape: 3 cols x 2 rows
@@ -438,13 +678,17 @@ static void drawMiningScreen(const display_data_t *data) {
     int cols = isPortrait ? 2 : 3;
     int boxW = (w - (cols + 1) * MARGIN) / cols;
 
-    struct { const char *label; String value; uint16_t color; } stats[] = {
-        {"Best",     formatDifficulty(data->bestDifficulty), COLOR_SPARK1},
-        {"Hashes",   formatNumber(data->totalHashes), COLOR_FG},
-        {"Uptime",   formatUptime(data->uptimeSeconds), COLOR_FG},
-        {"Jobs",     String(data->templates), COLOR_FG},
-        {"Blocks",   String(data->blocksFound), COLOR_SUCCESS},
-        {"Swarm HR", (strlen(data->workerHashrate) > 0) ? String(data->workerHashrate) : "---", COLOR_SPARK1},
+    char best[16], hashes[16], uptime[16], jobs[12], blocks[12];
+    snprintf(jobs, sizeof(jobs), "%lu", data->templates);
+    snprintf(blocks, sizeof(blocks), "%lu", data->blocksFound);
+
+    struct { const char *label; const char *value; uint16_t color; } stats[] = {
+        {"Best",     formatDifficulty(best, sizeof(best), data->bestDifficulty), COLOR_SPARK1},
+        {"Hashes",   formatNumber(hashes, sizeof(hashes), data->totalHashes), COLOR_FG},
+        {"Uptime",   formatUptime(uptime, sizeof(uptime), data->uptimeSeconds), COLOR_FG},
+        {"Jobs",     jobs, COLOR_FG},
+        {"Blocks",   blocks, COLOR_SUCCESS},
+        {"Swarm HR", (strlen(data->workerHashrate) > 0) ? data->workerHashrate : "---", COLOR_SPARK1},
     };
 
     for (int i = 0; i < 6; i++) {
@@ -453,293 +697,260 @@ static void drawMiningScreen(const display_data_t *data) {
         int x = MARGIN + col * (boxW + MARGIN);
         int ly = y + row * (LINE_HEIGHT + 12);
 
-        // Mini panel
-        s_tft.fillRoundRect(x - 2, ly - 2, boxW, LINE_HEIGHT + 8, 3, COLOR_PANEL);
-
-        s_tft.setTextColor(COLOR_DIM);
-        s_tft.setCursor(x + 2, ly);
-        s_tft.print(stats[i].label);
+        if (full) {
+            // Mini panel
+            s_tft.fillRoundRect(x - 2, ly - 2, boxW, LINE_HEIGHT + 8, 3, COLOR_PANEL);
+            drawLabel(x + 2, ly, COLOR_DIM, stats[i].label);
+        }
 
-        s_tft.setTextColor(stats[i].color);
-        s_tft.setCursor(x + 2, ly + 11);
-        s_tft.print(stats[i].value);
+        drawField(W_M_GRID + i, x + 2, ly + 11, boxW - 6, 1, stats[i].color, COLOR_PANEL, stats[i].value);
     }
 
     int gridRows = isPortrait ? 3 : 2;
     y += gridRows * (LINE_HEIGHT + 12) + 8;
 
-    // Pool info panel
-    s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_SPARK2);
+    // Pool info panel: left column values stop short of the right column
+    int leftX = MARGIN + 2;
+    int rightX = w - 90;
+    int rightEnd = w - MARGIN;
+    int leftW = rightX - 4;
+
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_SPARK2);
+        drawLabel(leftX, y + 6, COLOR_DIM, "Pool: ");
+        drawLabel(leftX, y + 20, COLOR_DIM, "Diff: ");
+        drawLabel(rightX, y + 20, COLOR_DIM, "Fee: ");
+        drawLabel(leftX, y + 34, COLOR_DIM, "Pool: ");
+        drawLabel(rightX, y + 34, COLOR_DIM, "Block: ");
+    }
 
     y += 6;
 
     // Pool name and status
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Pool: ");
-    
     // Status color: Green if connected, Warning if failover active, Red if disconnected
     uint16_t statusColor = COLOR_ERROR;
     if (data->poolConnected) {
         statusColor = (data->poolFailovers > 0) ? COLOR_WARNING : COLOR_SUCCESS;
     }
-    s_tft.setTextColor(statusColor);
-    
-    // Truncate pool name if needed
-    String poolName = data->poolName ? data->poolName : "Disconnected";
-    if (isPortrait && poolName.length() > 12) poolName = poolName.substring(0, 10) + "..";
-    s_tft.print(poolName);
+    int vx = leftX + LABEL_W("Pool: ");
+    drawField(W_M_POOLNAME, vx, y, leftW - vx, 1, statusColor, COLOR_PANEL,
+              data->poolName ? data->poolName : "Disconnected");
 
     // Pool workers on right
-    if (data->poolWorkersTotal > 0) {
-        s_tft.setTextColor(COLOR_SPARK1);
-        s_tft.setCursor(w - 90, y);
-        s_tft.print(String(data->poolWorkersTotal) + " miners");
-    }
+    buf[0] = '\0';
+    if (data->poolWorkersTotal > 0) snprintf(buf, sizeof(buf), "%d miners", data->poolWorkersTotal);
+    drawField(W_M_WORKERS, rightX, y, rightEnd - rightX, 1, COLOR_SPARK1, COLOR_PANEL, buf);
 
     y += 14;
 
-    // Pool difficulty
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Diff: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(formatDifficulty(data->poolDifficulty));
+    // Pool difficulty, fee rate on the right
+    vx = leftX + LABEL_W("Diff: ");
+    drawField(W_M_DIFF, vx, y, leftW - vx, 1, COLOR_FG, COLOR_PANEL,
+              formatDifficulty(buf, sizeof(buf), data->poolDifficulty));
 
-    // Fee rate on right side of Diff line
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(w - 90, y);
-    s_tft.print("Fee: ");
-    s_tft.setTextColor(COLOR_SPARK2);
-    s_tft.print(data->halfHourFee > 0 ? String(data->halfHourFee) + " sat" : "---");
+    vx = rightX + LABEL_W("Fee: ");
+    drawField(W_M_FEE, vx, y, rightEnd - vx, 1, COLOR_SPARK2, COLOR_PANEL,
+              formatCount(buf, sizeof(buf), data->halfHourFee > 0 ? data->halfHourFee : 0, " sat"));
 
     y += 14;
 
     // Pool hashrate (left) and block height (right)
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Pool: ");
-    s_tft.setTextColor(COLOR_SPARK1);
-    s_tft.print((strlen(data->poolHashrate) > 0) ? data->poolHashrate : "---");
-
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(w - 90, y);
-    s_tft.print("Block: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(data->blockHeight > 0 ? String(data->blockHeight) : "---");
+    vx = leftX + LABEL_W("Pool: ");
+    drawField(W_M_POOLHR, vx, y, leftW - vx, 1, COLOR_SPARK1, COLOR_PANEL,
+              (strlen(data->poolHashrate) > 0) ? data->poolHashrate : "---");
+
+    vx = rightX + LABEL_W("Block: ");
+    drawField(W_M_BLOCK, vx, y, rightEnd - vx, 1, COLOR_FG, COLOR_PANEL,
+              formatCount(buf, sizeof(buf), data->blockHeight));
 
     y += 22;
 
     // LAN Info panel
-    s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 24, 4, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 24, 4, COLOR_SPARK2);
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 24, 4, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 24, 4, COLOR_SPARK2);
+        drawLabel(leftX, y + 5, COLOR_DIM, "LAN: ");
+    }
 
     y += 5;
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("LAN: ");
-    s_tft.setTextColor(COLOR_FG);
-    const char *ip = data->ipAddress ? data->ipAddress : "---";
-    s_tft.print(ip);
+    vx = leftX + LABEL_W("LAN: ");
+    drawField(W_M_LAN, vx, y, rightEnd - vx, 1, COLOR_FG, COLOR_PANEL,
+              data->ipAddress ? data->ipAddress : "---");
 
-    drawBottomStatusBar(data);
+    drawBottomStatusBar(data, full);
 }
 
-static void drawStatsScreen(const display_data_t *data) {
+static void drawStatsScreen(const display_data_t *data, bool full) {
     int w = display_get_width();
     int y = HEADER_HEIGHT + 8;
+    char buf[WIDGET_TEXT];
+
+    int leftX = MARGIN + 2;
+    int rightX = w - 90;
+    int rightEnd = w - MARGIN;
+    int leftW = rightX - 4;
+
+    // BTC Price panel, block height on the right
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_SPARK1);
+        drawLabel(w - 100, y + 4, COLOR_DIM, "Block");
+    }
 
-    // BTC Price panel
-    s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 38, 4, COLOR_SPARK1);
-
-    s_tft.setTextSize(2);
-    s_tft.setCursor(MARGIN + 4, y + 6);
-    s_tft.setTextColor(COLOR_SPARK1);
     if (data->btcPrice > 0) {
-        s_tft.print("$");
-        s_tft.print(String(data->btcPrice, 0));
+        snprintf(buf, sizeof(buf), "$%.0f", data->btcPrice);
+        drawField(W_S_PRICE, MARGIN + 4, y + 6, w - 104 - MARGIN - 4, 2, COLOR_SPARK1, COLOR_PANEL, buf);
     } else {
-        s_tft.setTextColor(COLOR_DIM);
-        s_tft.print("Loading...");
+        drawField(W_S_PRICE, MARGIN + 4, y + 6, w - 104 - MARGIN - 4, 2, COLOR_DIM, COLOR_PANEL, "Loading...");
     }
 
-    // Block height on right
-    s_tft.setTextSize(1);
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(w - 100, y + 4);
-    s_tft.print("Block");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.setCursor(w - 100, y + 16);
-    s_tft.print(data->blockHeight > 0 ? String(data->blockHeight) : "---");
+    drawField(W_S_BLOCK, w - 100, y + 16, 100 - MARGIN, 1, COLOR_FG, COLOR_PANEL,
+              formatCount(buf, sizeof(buf), data->blockHeight));
 
     y += 44;
 
     // Network stats panel
-    s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 60, 4, COLOR_PANEL);
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 60, 4, COLOR_PANEL);
+        drawLabel(leftX, y + 6, COLOR_DIM, "Network: ");
+        drawLabel(rightX, y + 6, COLOR_DIM, "Fee: ");
+        drawLabel(leftX, y + 22, COLOR_DIM, "Difficulty: ");
+    }
 
     y += 6;
-    s_tft.setTextSize(1);
 
-    // Network hashrate
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Network: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(strlen(data->networkHashrate) > 0 ? data->networkHashrate : "---");
+    // Network hashrate, fee on right
+    int vx = leftX + LABEL_W("Network: ");
+    drawField(W_S_NETHR, vx, y, leftW - vx, 1, COLOR_FG, COLOR_PANEL,
+              strlen(data->networkHashrate) > 0 ? data->networkHashrate : "---");
 
-    // Fee on right
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(w - 90, y);
-    s_tft.print("Fee: ");
-    s_tft.setTextColor(COLOR_SPARK2);
-    s_tft.print(data->halfHourFee > 0 ? String(data->halfHourFee) + " sat" : "---");
+    vx = rightX + LABEL_W("Fee: ");
+    drawField(W_S_FEE, vx, y, rightEnd - vx, 1, COLOR_SPARK2, COLOR_PANEL,
+              formatCount(buf, sizeof(buf), data->halfHourFee > 0 ? data->halfHourFee : 0, " sat"));
 
     y += 16;
 
     // Difficulty
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Difficulty: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(strlen(data->networkDifficulty) > 0 ? data->networkDifficulty : "---");
+    vx = leftX + LABEL_W("Difficulty: ");
+    drawField(W_S_NETDIFF, vx, y, rightEnd - vx, 1, COLOR_FG, COLOR_PANEL,
+              strlen(data->networkDifficulty) > 0 ? data->networkDifficulty : "---");
 
     y += 32;
 
     // Your mining panel
-    s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 55, 4, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 55, 4, COLOR_ACCENT);
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 55, 4, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 55, 4, COLOR_ACCENT);
+        drawLabel(leftX, y + 6, COLOR_ACCENT, "Your Mining");
+        drawLabel(leftX, y + 20, COLOR_DIM, "Rate: ");
+        drawLabel(rightX, y + 20, COLOR_DIM, "Eff: ");
+        drawLabel(leftX, y + 34, COLOR_DIM, "Best: ");
+        drawLabel(rightX, y + 34, COLOR_DIM, "Shares: ");
+    }
 
     y += 6;
 
-    s_tft.setTextColor(COLOR_ACCENT);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Your Mining");
-
     // Pool workers
-    if (data->poolWorkersTotal > 0) {
-        s_tft.setTextColor(COLOR_SPARK1);
-        s_tft.setCursor(w - 90, y);
-        s_tft.print(String(data->poolWorkersTotal) + " on pool");
-    }
+    buf[0] = '\0';
+    if (data->poolWorkersTotal > 0) snprintf(buf, sizeof(buf), "%d on pool", data->poolWorkersTotal);
+    drawField(W_S_WORKERS, rightX, y, rightEnd - rightX, 1, COLOR_SPARK1, COLOR_PANEL, buf);
 
     y += 14;
 
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Rate: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(formatHashrate(data->hashRate));
+    vx = leftX + LABEL_W("Rate: ");
+    drawField(W_S_RATE, vx, y, leftW - vx, 1, COLOR_FG, COLOR_PANEL,
+              formatHashrate(buf, sizeof(buf), data->hashRate));
+
+    // Hashes per watt; "~" when estimated from the board model
+    vx = rightX + LABEL_W("Eff: ");
+    drawField(W_S_EFF, vx, y, rightEnd - vx, 1, COLOR_SPARK2, COLOR_PANEL,
+              formatEfficiency(buf, sizeof(buf), data->hashesPerJoule, data->powerMeasured));
 
     y += 14;
 
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Best: ");
-    s_tft.setTextColor(COLOR_SPARK1);
-    s_tft.print(formatDifficulty(data->bestDifficulty));
+    vx = leftX + LABEL_W("Best: ");
+    drawField(W_S_BEST, vx, y, leftW - vx, 1, COLOR_SPARK1, COLOR_PANEL,
+              formatDifficulty(buf, sizeof(buf), data->bestDifficulty));
 
     // Shares on right
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(w - 90, y);
-    s_tft.print("Shares: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(String(data->sharesAccepted));
+    snprintf(buf, sizeof(buf), "%lu", data->sharesAccepted);
+    vx = rightX + LABEL_W("Shares: ");
+    drawField(W_S_SHARES, vx, y, rightEnd - vx, 1, COLOR_FG, COLOR_PANEL, buf);
 
-    drawBottomStatusBar(data);
+    drawBottomStatusBar(data, full);
 }
 
-static void drawClockScreen(const display_data_t *data) {
+static void drawClockScreen(const display_data_t *data, bool full) {
     int w = display_get_width();
     int h = display_get_height();
+    char buf[WIDGET_TEXT];
 
-    // Get current time
-    struct tm timeinfo;
-    if (!getLocalTime(&timeinfo)) {
-        s_tft.setTextColor(COLOR_DIM);
-        s_tft.setTextSize(2);
-        s_tft.setCursor(w / 2 - 60, h / 2 - 10);
-        s_tft.print("No Time");
+    // No SNTP time yet: display_update() forces a full redraw once it arrives
+    if (!s_clockHadTime) {
+        if (full) {
+            s_tft.setTextColor(COLOR_DIM);
+            s_tft.setTextSize(2);
+            s_tft.setCursor(w / 2 - 60, h / 2 - 10);
+            s_tft.print("No Time");
+        }
         return;
     }
 
     // Time panel
     int y = HEADER_HEIGHT + 20;
-    s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 60, 6, COLOR_PANEL);
-    s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 60, 6, COLOR_ACCENT);
-
-    // Large time display
-    char timeStr[16];
-    strftime(timeStr, sizeof(timeStr), "%H:%M:%S", &timeinfo);
-
-    int timeW = 220;
-    int timeH = 36;
-    s_sprite.createSprite(timeW, timeH);
-    s_sprite.fillSprite(COLOR_PANEL);
-    s_sprite.setTextColor(COLOR_ACCENT, COLOR_PANEL);
-    s_sprite.setTextSize(4);
-    // Center text in sprite
-    int textW = s_sprite.textWidth(timeStr);
-    s_sprite.setCursor((timeW - textW) / 2, 4);
-    s_sprite.print(timeStr);
-    
-    // Push centered on screen
-    s_sprite.pushSprite(w / 2 - timeW / 2, y + 6);
-    s_sprite.deleteSprite();
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 60, 6, COLOR_PANEL);
+        s_tft.drawRoundRect(MARGIN - 4, y - 4, w - 2*MARGIN + 8, 60, 6, COLOR_ACCENT);
+    }
+
+    // Large time display, centered
+    strftime(buf, sizeof(buf), "%H:%M:%S", &s_clockTime);
+    drawField(W_C_TIME, w / 2 - 110, y + 10, 220, 4, COLOR_ACCENT, COLOR_PANEL, buf, true);
 
     y += 70;
 
     // Date
-    char dateStr[32];
-    strftime(dateStr, sizeof(dateStr), "%a, %b %d %Y", &timeinfo);
-
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.setTextSize(2);
-    s_tft.setCursor(w / 2 - 90, y);
-    s_tft.print(dateStr);
+    strftime(buf, sizeof(buf), "%a, %b %d %Y", &s_clockTime);
+    drawField(W_C_DATE, MARGIN, y, w - 2*MARGIN, 2, COLOR_FG, COLOR_BG, buf, true);
 
     // Mining summary panel at bottom
     y = h - (display_is_portrait() ? 90 : 55);
-    s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_PANEL);
+    int leftX = MARGIN + 2;
+    int rightX = w - 85;
+    int rightEnd = w - MARGIN;
+    int leftW = rightX - 4;
+
+    if (full) {
+        s_tft.fillRoundRect(MARGIN - 4, y, w - 2*MARGIN + 8, 50, 4, COLOR_PANEL);
+        drawLabel(leftX, y + 8, COLOR_DIM, "Hash: ");
+        drawLabel(leftX, y + 24, COLOR_DIM, "Shares: ");
+        drawLabel(rightX, y + 24, COLOR_DIM, "Blk ");
+    }
 
     y += 8;
-    s_tft.setTextSize(1);
 
-    // Hashrate
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Hash: ");
-    s_tft.setTextColor(COLOR_ACCENT);
-    s_tft.print(formatHashrate(data->hashRate));
+    // Hashrate, BTC price on right
+    int vx = leftX + LABEL_W("Hash: ");
+    drawField(W_C_HASH, vx, y, leftW - vx, 1, COLOR_ACCENT, COLOR_PANEL,
+              formatHashrate(buf, sizeof(buf), data->hashRate));
 
-    // BTC price on right
-    if (data->btcPrice > 0) {
-        s_tft.setTextColor(COLOR_SPARK1);
-        s_tft.setCursor(w - 85, y);
-        s_tft.print("$");
-        s_tft.print(String(data->btcPrice, 0));
-    }
+    buf[0] = '\0';
+    if (data->btcPrice > 0) snprintf(buf, sizeof(buf), "$%.0f", data->btcPrice);
+    drawField(W_C_PRICE, rightX, y, rightEnd - rightX, 1, COLOR_SPARK1, COLOR_PANEL, buf);
 
     y += 16;
 
-    // Shares
-    s_tft.setTextColor(COLOR_DIM);
-    s_tft.setCursor(MARGIN + 2, y);
-    s_tft.print("Shares: ");
-    s_tft.setTextColor(COLOR_FG);
-    s_tft.print(String(data->sharesAccepted));
+    // Shares, block height on right
+    snprintf(buf, sizeof(buf), "%lu", data->sharesAccepted);
+    vx = leftX + LABEL_W("Shares: ");
+    drawField(W_C_SHARES, vx, y, leftW - vx, 1, COLOR_FG, COLOR_PANEL, buf);
 
-    // Block height on right
-    if (data->blockHeight > 0) {
-        s_tft.setTextColor(COLOR_DIM);
-        s_tft.setCursor(w - 85, y);
-        s_tft.print("Blk ");
-        s_tft.setTextColor(COLOR_FG);
-        s_tft.print(String(data->blockHeight));
-    }
+    vx = rightX + LABEL_W("Blk ");
+    drawField(W_C_BLOCK, vx, y, rightEnd - vx, 1, COLOR_FG, COLOR_PANEL,
+              formatCount(buf, sizeof(buf), data->blockHeight));
 
-    drawBottomStatusBar(data);
+    drawBottomStatusBar(data, full);
 }
 
 // ============================================================
@@ -762,6 +973,10 @@ void display_init(uint8_t rotation, uint8_t brightness) {
     s_tft.setRotation(rotation);
     s_tft.fillScreen(COLOR_BG);
 
+    #if USE_DISPLAY_DMA
+        dmaInit();
+    #endif
+
     // Touch controller disabled - see memory bank for implementation issues
     // #if defined(ESP32_2432S028)
     //     s_touchSpi.begin(TOUCH_CLK_PIN, TOUCH_MISO_PIN, TOUCH_MOSI_PIN);
@@ -862,46 +1077,67 @@ void display_init(uint8_t rotation, uint8_t brightness) {
 void display_update(const display_data_t *data) {
     if (!data) return;
 
-    // Check if anything changed
-    bool dataChanged = (data->totalHashes != s_lastData.totalHashes) ||
-        (abs(data->hashRate - s_lastData.hashRate) > 100) ||
-        (data->sharesAccepted != s_lastData.sharesAccepted);
-
-    bool statusChanged = (data->poolConnected != s_lastData.poolConnected) ||
-        (data->wifiConnected != s_lastData.wifiConnected);
+    uint32_t start = micros();
+    s_frameWidgets = 0;
+    s_framePixels = 0;
 
-    if (!s_needsRedraw && !dataChanged && !statusChanged) return;
+    // The clock screen has a different layout until SNTP has set the time
+    if (s_currentScreen == SCREEN_CLOCK) {
+        bool haveTime = getLocalTime(&s_clockTime, 0);
+        if (haveTime != s_clockHadTime) {
+            s_clockHadTime = haveTime;
+            s_needsRedraw = true;
+        }
+    }
 
-    // Full screen clear only on screen change
-    if (s_needsRedraw) {
+    // Full redraw (screen clear + chrome) only on screen/rotation change;
+    // otherwise each widget pushes itself only if its value changed
+    bool full = s_needsRedraw;
+#if USE_DISPLAY_DMA
+    // Full redraws interleave chrome with widgets, so they stay blocking
+    s_dmaFrame = s_dmaReady && !full;
+#endif
+    if (full) {
         s_tft.fillScreen(COLOR_BG);
+        invalidateWidgets();
+        s_framePixels += (uint32_t)display_get_width() * display_get_height();
     }
 
-    // Header: redraw on screen change or status change
-    if (s_needsRedraw || statusChanged) {
-        drawHeader(data);
-    }
+    drawHeader(data, full);
 
-    // Content: redraw on any change
-    // Each screen's panels use fillRoundRect to clear their areas
     switch (s_currentScreen) {
-        case SCREEN_MINING:
-            drawMiningScreen(data);
-            break;
         case SCREEN_STATS:
-            drawStatsScreen(data);
+            drawStatsScreen(data, full);
             break;
         case SCREEN_CLOCK:
-            drawClockScreen(data);
+            drawClockScreen(data, full);
             break;
+        case SCREEN_MINING:
         default:
-            drawMiningScreen(data);
+            drawMiningScreen(data, full);
             break;
     }
 
-    // Save last data
-    memcpy(&s_lastData, data, sizeof(display_data_t));
     s_needsRedraw = false;
+
+#if USE_DISPLAY_DMA
+    // Never leave a transfer running past the frame: other screens, the
+    // reset/AP screens and SD access on a shared bus all expect it idle
+    dmaFlush();
+#endif
+
+    uint32_t us = micros() - start;
+    s_frameStats.frames++;
+    if (full) s_frameStats.fullRedraws++;
+    s_frameStats.lastUs = us;
+    if (us > s_frameStats.maxUs) s_frameStats.maxUs = us;
+    s_frameStats.lastWidgets = s_frameWidgets;
+    s_frameStats.lastPixels = s_framePixels;
+    s_frameStats.totalPixels += s_framePixels;
+}
+
+void display_get_frame_stats(display_frame_stats_t *out) {
+    memcpy(out, &s_frameStats, sizeof(*out));
 }
 
 void display_set_brightness(uint8_t brightness) {
@@ -909,6 +1145,12 @@ void display_set_brightness(uint8_t brightness) {
     setBacklight(s_brightness);
 }
 
+void display_set_sleep(bool sleep) {
+    // Panel keeps its RAM; only the backlight (most of the power) goes off
+    setBacklight(sleep ? 0 : s_brightness);
+    if (!sleep) s_needsRedraw = true;
+}
+
 void display_set_screen(uint8_t screen) {
     if (screen != s_currentScreen) {
         s_currentScreen = screen;
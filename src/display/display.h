@@ -36,6 +36,9 @@ struct display_data_s {
     uint32_t uptimeSeconds;
     uint32_t avgLatency;        // Average pool latency in ms
     uint32_t cpuMhz;            // CPU frequency in MHz
+    float powerMw;              // Board draw, last power window
+    double hashesPerJoule;      // Same as H/W; 0 until a window with mining
+    bool powerMeasured;         // From a power sensor, not the board model
 
     // Pool info
     bool poolConnected;
@@ -70,6 +73,22 @@ struct display_data_s {
 
 #if USE_DISPLAY
 
+/**
+ * TFT render cost counters
+ * A frame is one display_update() call. Full redraws count the whole
+ * screen clear as pushed pixels; other frames only count the widgets
+ * that changed.
+ */
+typedef struct {
+    uint32_t frames;            // display_update() calls since boot
+    uint32_t fullRedraws;       // Frames that cleared the screen and redrew the chrome
+    uint32_t lastUs;            // Time spent in the last frame (including DMA waits, when the task sleeps)
+    uint32_t maxUs;             // Slowest frame since boot
+    uint32_t lastWidgets;       // Widgets re-rasterized in the last frame
+    uint32_t lastPixels;        // Pixels pushed in the last frame
+    uint64_t totalPixels;       // Pixels pushed since boot
+} display_frame_stats_t;
+
 /**
  * Initialize display hardware
  * @param rotation Screen rotation (0-3)
@@ -89,6 +108,17 @@ void display_update(const display_data_t *data);
  */
 void display_set_brightness(uint8_t brightness);
 
+/**
+ * Turn the screen off (backlight or panel power) or back on
+ * Waking forces a full redraw at the next update.
+ */
+void display_set_sleep(bool sleep);
+
+/**
+ * Copy the render cost counters (see display_frame_stats_t)
+ */
+void display_get_frame_stats(display_frame_stats_t *out);
+
 /**
  * Set current screen
  * @param screen SCREEN_* constant
@@ -179,6 +209,7 @@ void display_show_reset_complete();
 void display_init(uint8_t rotation, uint8_t brightness);
 void display_update(const display_data_t *data);
 void display_set_brightness(uint8_t brightness);
+void display_set_sleep(bool sleep);
 void display_set_screen(uint8_t screen);
 uint8_t display_get_screen();
 void display_next_screen();
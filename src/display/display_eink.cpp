@@ -8,6 +8,7 @@
 #include <Arduino.h>
 #include <board_config.h>
 #include "display/display_eink.h"
+#include "../stats/mem_budget.h"
 
 #if USE_EINK_DISPLAY
 
@@ -100,6 +101,32 @@ static uint8_t s_fontHeight = 0;
 static bool s_needsRedraw = true;
 static bool s_inverted = false;
 
+// Refresh scheduler: eink_display_update() only posts the newest data; the
+// eink task renders it and walks the panel through power on, refresh and
+// power off, sleeping between steps until BUSY goes idle
+typedef enum {
+    EINK_IDLE,
+    EINK_POWER_ON,
+    EINK_REFRESHING,
+    EINK_POWER_OFF
+} eink_state_t;
+
+#define EINK_POLL_MS        50      // BUSY poll while a refresh runs (backs up the edge interrupt)
+#define EINK_SETTLE_MS      10      // BUSY takes a moment to assert after a command
+
+static TaskHandle_t s_task = NULL;
+STATIC_TASK(s_einkTask, EINK_STACK);
+static SemaphoreHandle_t s_panelMutex = NULL;  // Held for a whole refresh cycle
+static portMUX_TYPE s_dataMux = portMUX_INITIALIZER_UNLOCKED;
+static display_data_t s_latest;                 // Newest data, guarded by s_dataMux
+static bool s_dataPending = false;
+static bool s_fullPending = true;
+static eink_state_t s_state = EINK_IDLE;
+static bool s_refreshFull = false;
+static uint32_t s_stepAt = 0;                   // When the current command was sent
+static uint32_t s_lastRefresh = 0;
+static uint32_t s_partialCount = 0;
+
 // ============================================================
 // Helper Functions
 // ============================================================
@@ -165,8 +192,9 @@ void clearFullScreen() {
     htDisplay.display();
 }
 
+// Screen renderers draw into the local buffer only; the scheduler sends it
+
 static void drawMainScreen(const display_data_t *data) {
-    clearScreen();
 
     uint16_t w;
 
@@ -214,13 +242,9 @@ static void drawMainScreen(const display_data_t *data) {
     String best = "Best Difficulty:" + formatDiffCompact(data->bestDifficulty);
     w = htDisplay.getStringWidth(best.c_str());
     htDisplay.drawString((EINK_WIDTH - w), (EINK_HEIGHT - s_fontHeight), best.c_str());
-    
-    printScreen();
 }
 
 static void drawStatsScreen(const display_data_t *data) {
-    clearScreen();
-
     // Title
     htDisplay.drawString(0, 0, "STATS");
     htDisplay.drawHorizontalLine(0, (s_fontHeight + 2), EINK_WIDTH);
@@ -248,8 +272,119 @@ static void drawStatsScreen(const display_data_t *data) {
         rssiLine += "---";
     }
     htDisplay.drawString(0, ((s_fontHeight * 5) + 8), rssiLine.c_str());
+}
 
-    printScreen();
+// ============================================================
+// Refresh Scheduler
+// ============================================================
+
+// Direct screens (AP config, reset) draw synchronously; wait out a refresh
+static void panelLock() {
+    if (s_panelMutex) xSemaphoreTake(s_panelMutex, portMAX_DELAY);
+}
+
+static void panelUnlock() {
+    if (s_panelMutex) xSemaphoreGive(s_panelMutex);
+}
+
+static void IRAM_ATTR busyIsr() {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+static bool panelReady() {
+    return (millis() - s_stepAt >= EINK_SETTLE_MS) && !htDisplay.isBusy();
+}
+
+static void sendStep(eink_state_t next) {
+    s_state = next;
+    s_stepAt = millis();
+}
+
+// Render the newest data and start a refresh; false if there is nothing to do yet
+static bool startRefresh() {
+    if (!s_dataPending) return false;
+    if (millis() - s_lastRefresh < EINK_MIN_REFRESH_MS) return false;
+    if (xSemaphoreTake(s_panelMutex, 0) != pdTRUE) return false;
+
+    display_data_t data;
+    portENTER_CRITICAL(&s_dataMux);
+    memcpy(&data, &s_latest, sizeof(data));
+    bool full = s_fullPending || s_partialCount >= EINK_FULL_REFRESH_EVERY;
+    s_dataPending = false;
+    s_fullPending = false;
+    portEXIT_CRITICAL(&s_dataMux);
+
+    htDisplay.clear();
+    switch (s_currentScreen) {
+        case EINK_SCREEN_STATS:
+            drawStatsScreen(&data);
+            break;
+        case EINK_SCREEN_MAIN:
+        default:
+            drawMainScreen(&data);
+            break;
+    }
+    htDisplay.update(BLACK_BUFFER);     // New image; the panel still holds the old one
+
+    s_refreshFull = full;
+    if (full) htDisplay.setFull();
+    htDisplay.powerOn();
+    sendStep(EINK_POWER_ON);
+    return true;
+}
+
+static void refreshStep() {
+    switch (s_state) {
+        case EINK_IDLE:
+            startRefresh();
+            break;
+
+        case EINK_POWER_ON:
+            if (!panelReady()) break;
+            htDisplay.startRefresh();
+            sendStep(EINK_REFRESHING);
+            break;
+
+        case EINK_REFRESHING:
+            if (!panelReady()) break;
+            htDisplay.powerOff();
+            sendStep(EINK_POWER_OFF);
+            break;
+
+        case EINK_POWER_OFF:
+            if (!panelReady()) break;
+            // What is on the panel now is the next partial refresh's old image
+            htDisplay.updateData(0x10);
+            if (s_refreshFull) {
+                htDisplay.setPartial();
+                s_partialCount = 0;
+            } else {
+                s_partialCount++;
+            }
+            s_lastRefresh = millis();
+            s_state = EINK_IDLE;
+            xSemaphoreGive(s_panelMutex);
+            break;
+    }
+}
+
+static void eink_task(void *param) {
+    while (true) {
+        TickType_t wait = portMAX_DELAY;
+        if (s_state != EINK_IDLE) {
+            wait = pdMS_TO_TICKS(EINK_POLL_MS);
+        } else if (s_dataPending) {
+            // Coalesce: sleep out the rest of the interval, newer data replaces older
+            uint32_t since = millis() - s_lastRefresh;
+            wait = pdMS_TO_TICKS(since < EINK_MIN_REFRESH_MS ? EINK_MIN_REFRESH_MS - since : EINK_POLL_MS);
+        }
+
+        // Woken by new data or by BUSY going idle
+        ulTaskNotifyTake(pdTRUE, wait);
+        refreshStep();
+    }
 }
 
 // ============================================================
@@ -287,22 +422,27 @@ void eink_display_init(uint8_t rotation, uint8_t brightness) {
 
     htDisplay.setPartial();
 
+    // Refresh scheduler
+    s_panelMutex = xSemaphoreCreateMutex();
+    s_task = mem_task_create(eink_task, "eink", NULL, EINK_PRIORITY, EINK_CORE, "display",
+                             STATIC_TASK_MEM(s_einkTask));
+    attachInterrupt(digitalPinToInterrupt(EINK_BUSY_PIN), busyIsr, RISING);
+
     Serial.println("[EINK] Display initialized");
 }
 
 void eink_display_update(const display_data_t *data) {
-    switch (s_currentScreen) {
-        case EINK_SCREEN_MAIN:
-            drawMainScreen(data);
-            break;
-        case EINK_SCREEN_STATS:
-            drawStatsScreen(data);
-            break;
-        default:
-            drawMainScreen(data);
-            break;
-    }
+    if (!data) return;
+
+    // Post the data and return; the eink task refreshes when the panel can
+    portENTER_CRITICAL(&s_dataMux);
+    memcpy(&s_latest, data, sizeof(s_latest));
+    s_dataPending = true;
+    if (s_needsRedraw) s_fullPending = true;   // Screen change: full refresh
     s_needsRedraw = false;
+    portEXIT_CRITICAL(&s_dataMux);
+
+    if (s_task) xTaskNotifyGive(s_task);
 }
 
 void eink_display_set_brightness(uint8_t brightness) {
@@ -316,6 +456,7 @@ void eink_display_next_screen() {
 }
 
 void eink_display_show_ap_config(const char *ssid, const char *password, const char *ip) {
+    panelLock();
     clearScreen();
 
     // Center WiFi AP stats
@@ -329,6 +470,7 @@ void eink_display_show_ap_config(const char *ssid, const char *password, const c
     htDisplay.drawString(0, (6 + (4 * s_fontHeight)), ip_text.c_str());
 
     printScreen();
+    panelUnlock();
 }
 
 void eink_display_show_boot() {
@@ -354,6 +496,7 @@ void eink_display_show_boot() {
 }
 
 void eink_display_show_reset_countdown(int seconds) {
+    panelLock();
     clearScreen();
 
     // Does not work, due to other screens being drawn anyway and the fact that eink has long refresh rate
@@ -368,9 +511,11 @@ void eink_display_show_reset_countdown(int seconds) {
     htDisplay.drawString(((EINK_WIDTH - w) / 2), ((EINK_HEIGHT - s_fontHeight) / 2), countdown.c_str());
 
     printScreen();
+    panelUnlock();
 }
 
 void eink_display_show_reset_complete() {
+    panelLock();
     clearScreen();
 
     // Does not work, due to other screens being drawn anyway and the fact that eink has long refresh rate
@@ -380,6 +525,7 @@ void eink_display_show_reset_complete() {
     htDisplay.drawString(((EINK_WIDTH - w) / 2), ((EINK_HEIGHT - s_fontHeight) / 2), text);
     
     printScreen();
+    panelUnlock();
 }
 
 void eink_display_redraw() {
@@ -486,6 +632,11 @@ void display_set_brightness(uint8_t brightness) {
     // No brightness for E-INK
 }
 
+void display_set_sleep(bool sleep) {
+    // The panel holds its image unpowered; just refresh it fully on wake
+    if (!sleep) eink_display_redraw();
+}
+
 void display_set_screen(uint8_t screen) {
     eink_display_set_screen(screen);
 }
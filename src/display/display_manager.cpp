@@ -69,6 +69,10 @@ void display_set_brightness(uint8_t brightness) {
     // Could adjust LED brightness here
 }
 
+void display_set_sleep(bool sleep) {
+    // No screen to turn off
+}
+
 void display_set_screen(uint8_t screen) {
     // No screens in LED mode
 }
@@ -142,6 +146,7 @@ void display_update(const display_data_t *data) {
 }
 
 void display_set_brightness(uint8_t brightness) {}
+void display_set_sleep(bool sleep) {}
 void display_set_screen(uint8_t screen) {}
 uint8_t display_get_screen() { return 0; }
 void display_next_screen() {}
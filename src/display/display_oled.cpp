@@ -40,6 +40,16 @@
     #define OLED_HEIGHT 64
 #endif
 
+// I2C clock: 400 kHz is the SSD1306 fast-mode limit; many modules run fine
+// at 800 kHz-1 MHz if the board's pull-ups are strong enough
+#ifndef OLED_I2C_CLOCK
+    #define OLED_I2C_CLOCK 400000
+#endif
+
+// Clean tiles between two dirty runs that are sent anyway: 8 data bytes are
+// cheaper than a new page/column address setup
+#define OLED_TILE_GAP 1
+
 // Screen cycling (OLED has limited space, fewer screens)
 #define OLED_SCREEN_MAIN    0
 #define OLED_SCREEN_STATS   1
@@ -71,6 +81,12 @@ static uint8_t s_rotation = 0;
 static bool s_needsRedraw = true;
 static bool s_inverted = false;
 
+// What the panel RAM holds (same page layout as the U8g2 buffer: one byte
+// is 8 vertical pixels, one page is 8 rows), so a frame only sends the
+// 8x8 tiles that changed
+static uint8_t s_shadow[OLED_WIDTH * OLED_HEIGHT / 8];
+static bool s_shadowValid = false;
+
 // ============================================================
 // Helper Functions
 // ============================================================
@@ -115,6 +131,58 @@ static String formatDiffCompact(double diff) {
     }
 }
 
+// ============================================================
+// Page-Diffed Transfer
+// ============================================================
+
+static bool tileDirty(const uint8_t *frame, const uint8_t *shown, int tx) {
+    return memcmp(frame + tx * 8, shown + tx * 8, 8) != 0;
+}
+
+/**
+ * Send the U8g2 buffer, but only the tile runs that differ from the panel
+ * Each run is one page/column address setup plus its data, so an update
+ * that changes a few digits costs tens of bytes instead of the whole 1 KB
+ * frame. After a redraw request the whole frame is sent to resync.
+ */
+static void sendFrame() {
+    uint8_t *frame = s_u8g2.getBufferPtr();
+    int tilesW = s_u8g2.getBufferTileWidth();
+    int tilesH = s_u8g2.getBufferTileHeight();
+    int pageBytes = tilesW * 8;
+
+    if (!s_shadowValid || s_needsRedraw) {
+        s_u8g2.sendBuffer();
+        memcpy(s_shadow, frame, sizeof(s_shadow));
+        s_shadowValid = true;
+        return;
+    }
+
+    for (int page = 0; page < tilesH; page++) {
+        const uint8_t *row = frame + page * pageBytes;
+        uint8_t *shown = s_shadow + page * pageBytes;
+        int tx = 0;
+
+        while (tx < tilesW) {
+            if (!tileDirty(row, shown, tx)) {
+                tx++;
+                continue;
+            }
+
+            // Extend the run over dirty tiles and short clean gaps
+            int start = tx;
+            int end = tx + 1;
+            for (int next = end; next < tilesW && next <= end + OLED_TILE_GAP; next++) {
+                if (tileDirty(row, shown, next)) end = next + 1;
+            }
+
+            s_u8g2.updateDisplayArea(start, page, end - start, 1);
+            memcpy(shown + start * 8, row + start * 8, (end - start) * 8);
+            tx = end;
+        }
+    }
+}
+
 // ============================================================
 // Screen Drawing Functions
 // ============================================================
@@ -171,7 +239,7 @@ static void drawMainScreen(const display_data_t *data) {
         s_u8g2.drawStr(OLED_WIDTH - bestWidth, 60, best.c_str());
     #endif
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 static void drawStatsScreen(const display_data_t *data) {
@@ -195,6 +263,13 @@ static void drawStatsScreen(const display_data_t *data) {
     String templLine = "Tmpl: " + String(data->templates);
     s_u8g2.drawStr(0, 46, templLine.c_str());
 
+    // Hashes per watt (right); "~" when estimated from the board model
+    if (data->hashesPerJoule > 0) {
+        String eff = data->powerMeasured ? "" : "~";
+        eff += formatHashrateCompact(data->hashesPerJoule) + "H/W";
+        s_u8g2.drawStr(OLED_WIDTH - s_u8g2.getStrWidth(eff.c_str()), 46, eff.c_str());
+    }
+
     #if (OLED_HEIGHT == 64)
         // WiFi signal
         String rssiLine = "RSSI: ";
@@ -206,7 +281,7 @@ static void drawStatsScreen(const display_data_t *data) {
         s_u8g2.drawStr(0, 58, rssiLine.c_str());
     #endif
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 // ============================================================
@@ -219,7 +294,8 @@ void oled_display_init(uint8_t rotation, uint8_t brightness) {
     // Initialize I2C with custom pins
     Wire.begin(OLED_SDA_PIN, OLED_SCL_PIN);
 
-    // Initialize U8g2
+    // Initialize U8g2 (bus clock must be set before begin)
+    s_u8g2.setBusClock(OLED_I2C_CLOCK);
     s_u8g2.begin();
 
     // Set rotation
@@ -283,7 +359,7 @@ void oled_display_show_ap_config(const char *ssid, const char *password, const c
         s_u8g2.drawStr(0, 64, ip);
     #endif
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 void oled_display_show_boot() {
@@ -305,7 +381,7 @@ void oled_display_show_boot() {
         s_u8g2.drawStr((OLED_WIDTH - 60) / 2, 58, "Initializing...");
     #endif
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 void oled_display_show_reset_countdown(int seconds) {
@@ -320,7 +396,7 @@ void oled_display_show_reset_countdown(int seconds) {
     int w = s_u8g2.getStrWidth(countdown.c_str());
     s_u8g2.drawStr((OLED_WIDTH - w) / 2, 58, countdown.c_str());
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 void oled_display_show_reset_complete() {
@@ -330,7 +406,7 @@ void oled_display_show_reset_complete() {
     s_u8g2.drawStr(28, 28, "RESET");
     s_u8g2.drawStr(16, 46, "COMPLETE");
 
-    s_u8g2.sendBuffer();
+    sendFrame();
 }
 
 void oled_display_redraw() {
@@ -437,6 +513,12 @@ void display_set_brightness(uint8_t brightness) {
     oled_display_set_brightness(brightness);
 }
 
+void display_set_sleep(bool sleep) {
+    // Contrast 0 still glows: power the panel down instead
+    s_u8g2.setPowerSave(sleep ? 1 : 0);
+    if (!sleep) s_needsRedraw = true;
+}
+
 void display_set_screen(uint8_t screen) {
     oled_display_set_screen(screen);
 }
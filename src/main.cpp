@@ -28,11 +28,20 @@ extern "C" {
 
 #include <board_config.h>
 #include "mining/miner.h"
+#include "mining/miner_kernels.h"
+#include "mining/freq_governor.h"
 #include "stratum/stratum_types.h"
 #include "stratum/stratum.h"
+#include "stratum/stratum_capture.h"
 #include "config/nvs_config.h"
+#include "config/stats_journal.h"
 #include "config/wifi_manager.h"
 #include "stats/monitor.h"
+#include "stats/trace.h"
+#include "stats/metrics.h"
+#include "stats/mem_budget.h"
+#include "stats/sd_log.h"
+#include "stratum/stratum_proxy.h"
 #include "display/display.h"
 
 // Task handles
@@ -42,6 +51,18 @@ TaskHandle_t stratumTask = NULL;
 TaskHandle_t monitorTask = NULL;
 TaskHandle_t buttonTask = NULL;
 
+// Static stacks (see stats/mem_budget.h)
+STATIC_TASK(s_stratumTask, STRATUM_STACK);
+STATIC_TASK(s_monitorTask, MONITOR_STACK);
+STATIC_TASK(s_verifyTask, VERIFY_STACK);
+STATIC_TASK(s_miner0Task, MINER_0_STACK);
+#if (SOC_CPU_CORES_NUM >= 2)
+STATIC_TASK(s_miner1Task, MINER_1_STACK);
+#endif
+#if defined(BUTTON_PIN) && (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
+STATIC_TASK(s_buttonTask, BUTTON_STACK);
+#endif
+
 // Global state
 volatile bool systemReady = false;
 
@@ -65,10 +86,13 @@ void onButtonDoubleClick() {
     Serial.printf("[BUTTON] New rotation saved: %d\n", newRotation);
 }
 
-// Triple click: toggle color inversion
+// Triple click: toggle color inversion, quadruple click: run benchmark
 void onButtonMultiClick() {
     int clicks = button.getNumberClicks();
-    if (clicks == 3) {
+    if (clicks == 4) {
+        Serial.println("[BUTTON] Quadruple-click detected - running benchmark");
+        monitor_request_benchmark();
+    } else if (clicks == 3) {
         Serial.println("[BUTTON] Triple-click detected - toggling color theme");
         miner_config_t *config = nvs_config_get();
         config->invertColors = !config->invertColors;
@@ -108,6 +132,7 @@ void onButtonLongPressStart() {
         prefs.end();
         Serial.println("[RESET] NVS cleared");
     }
+    stats_journal_erase();
 
     // Clear WiFi settings
     WiFi.disconnect(true, true);
@@ -120,6 +145,35 @@ void onButtonLongPressStart() {
 #endif
 
 #if defined(BUTTON_PIN) && (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
+// Screen off: the button task sleeps until the pin goes low
+static void IRAM_ATTR buttonIsr() {
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(buttonTask, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+/**
+ * Block until the button is pressed, then wake the screen
+ * The press that wakes the screen is swallowed, so it doesn't also
+ * change screens.
+ */
+static void buttonWaitForPress() {
+    attachInterrupt(digitalPinToInterrupt(BUTTON_PIN), buttonIsr, FALLING);
+    // Pressed before the interrupt was armed: don't wait for the next edge
+    if (digitalRead(BUTTON_PIN) == HIGH) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+    detachInterrupt(digitalPinToInterrupt(BUTTON_PIN));
+
+    if (monitor_wake()) {
+        Serial.println("[BUTTON] Screen woken");
+        while (digitalRead(BUTTON_PIN) == LOW) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+        button.reset();
+    }
+}
+
 /**
  * Dedicated button handling task
  * Runs at higher priority than mining to ensure responsive UI
@@ -127,7 +181,15 @@ void onButtonLongPressStart() {
 void button_task(void *param) {
     Serial.println("[BUTTON] Task started on core 0");
     for (;;) {
+        if (button.isIdle() && monitor_is_asleep()) {
+            buttonWaitForPress();
+            continue;
+        }
         button.tick();
+        if (!button.isIdle()) {
+            miner_yield_hint();  // Press in progress - UI work is coming
+            monitor_wake();      // Restart the screen timeout
+        }
         vTaskDelay(pdMS_TO_TICKS(10));  // 10ms polling = responsive buttons
     }
 }
@@ -135,6 +197,7 @@ void button_task(void *param) {
 
 // Forward declarations
 void setupPowerManagement();
+void startStratumTask();
 void setupTasks();
 void printBanner();
 void checkFactoryReset();
@@ -236,6 +299,7 @@ void checkFactoryReset() {
                     prefs.clear();
                     prefs.end();
                 }
+                stats_journal_erase();
 
                 // Also reset WiFiManager settings
                 WiFi.disconnect(true, true);
@@ -260,10 +324,21 @@ void checkFactoryReset() {
  */
 void setup() {
     Serial.begin(115200);
-    
+
+    // Fast boot once the board has been online: nobody is watching a rack
+    // come back from a power blip, so don't hold it for a serial console
+    #if FAST_BOOT
+        wifi_cache_t wifiCache;
+        bool fastBoot = nvs_wifi_cache_load(&wifiCache);
+    #else
+        bool fastBoot = false;
+    #endif
+
     // Wait for USB CDC to be ready
-    delay(3000);
-    while (!Serial) { delay(10); }  // Extra wait for USB enumeration
+    if (!fastBoot) {
+        delay(3000);
+        while (!Serial) { delay(10); }  // Extra wait for USB enumeration
+    }
     Serial.flush();
     
     // Debug output  
@@ -286,6 +361,8 @@ void setup() {
     // NOTE: ESP32 overclocking via PLL manipulation causes boot loops
     // This ESP32-D0WD-V3 chip cannot exceed 240MHz
     // NMMiner's 1000 KH/s must come from SHA optimization, not overclocking
+    // The governor steps the clock at runtime within the board's limits
+    freq_governor_init();
     Serial.printf("[INIT] Running at %u MHz\n", getCpuFrequencyMhz());
 
     // Initialize NVS configuration
@@ -302,6 +379,19 @@ void setup() {
     stratum_set_pool(config->poolUrl, config->poolPort, config->wallet, config->poolPassword, config->workerName);
     stratum_set_backup_pool(config->backupPoolUrl, config->backupPoolPort,
                            config->backupWallet, config->backupPoolPassword, config->workerName);
+    pool_list_t *pools = nvs_pools_get();
+    for (int i = 0; i < pools->count; i++) {
+        stratum_add_pool(pools->pools[i].url, pools->pools[i].port);
+    }
+    stratum_set_difficulty(config->targetDifficulty);
+
+    // Join WiFi and start the pool connection now, so both come up while
+    // the display initializes; setup still waits for WiFi further down
+    if (fastBoot && nvs_config_is_valid()) {
+        Serial.println("[BOOT] Fast boot: joining WiFi during display init");
+        wifi_manager_begin();
+        startStratumTask();
+    }
 
     // Initialize display early (needed for WiFi setup screen)
     #if (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
@@ -316,9 +406,9 @@ void setup() {
         button.setDebounceMs(50);        // Debounce time (ms)
         button.attachClick(onButtonClick);
         button.attachDoubleClick(onButtonDoubleClick);
-        button.attachMultiClick(onButtonMultiClick);          // Triple-click for inversion
+        button.attachMultiClick(onButtonMultiClick);          // Triple-click inversion, 4x benchmark
         button.attachLongPressStart(onButtonLongPressStart);  // Factory reset handler
-        Serial.println("[INIT] Button handlers registered (click/double/triple/long-press)");
+        Serial.println("[INIT] Button handlers registered (click/double/triple/quad/long-press)");
     #endif
 
     // Initialize WiFiManager and connect
@@ -357,6 +447,9 @@ void setup() {
     #endif
     Serial.println();
 
+    // Fixed memory per subsystem; again once the stacks have seen real work
+    mem_budget_report("boot");
+
     systemReady = true;
 }
 
@@ -366,6 +459,41 @@ void setup() {
  */
 void loop() {
     // Button handling moved to dedicated FreeRTOS task for responsiveness during mining
+    // Serial console commands (one per line)
+    static char cmd[24];
+    static uint8_t cmdLen = 0;
+    while (Serial.available()) {
+        char c = Serial.read();
+        if (c == '\r' || c == '\n') {
+            cmd[cmdLen] = '\0';
+            if (strcmp(cmd, "bench") == 0) {
+                monitor_request_benchmark();
+            } else if (strcmp(cmd, "trace") == 0) {
+                trace_dump();
+            } else if (strcmp(cmd, "trace clear") == 0) {
+                trace_clear();
+            } else if (strcmp(cmd, "mem") == 0) {
+                mem_budget_report("command");
+            } else if (strcmp(cmd, "capture sd") == 0 || strcmp(cmd, "capture serial") == 0) {
+                if (!stratum_capture_start(strcmp(cmd, "capture serial") == 0)) {
+                    Serial.println("[CMD] Capture not available (USE_STRATUM_CAPTURE=1, SD slot for sd, not while replaying)");
+                }
+            } else if (strcmp(cmd, "capture off") == 0) {
+                stratum_capture_stop();
+            } else if (strcmp(cmd, "replay stop") == 0) {
+                stratum_replay_stop();
+            } else if (strncmp(cmd, "replay", 6) == 0 && (cmd[6] == '\0' || cmd[6] == ' ')) {
+                stratum_replay(cmd[6] ? strtoul(cmd + 7, NULL, 10) : 1);
+            } else if (cmdLen > 0) {
+                Serial.printf("[CMD] Unknown command: %s (try: bench, trace, trace clear, mem, "
+                              "capture sd|serial|off, replay [speed]|stop)\n", cmd);
+            }
+            cmdLen = 0;
+        } else if (cmdLen < sizeof(cmd) - 1) {
+            cmd[cmdLen++] = c;
+        }
+    }
+
     // Yield to FreeRTOS tasks
     vTaskDelay(pdMS_TO_TICKS(100));  // Main loop can sleep longer now
 }
@@ -389,6 +517,29 @@ void setupPowerManagement() {
     #endif
 }
 
+/**
+ * Create the stratum task (and LAN proxy)
+ * Fast boot calls this before the display is up; setupTasks() skips it then
+ */
+void startStratumTask() {
+    if (stratumTask) return;
+
+    stratumTask = mem_task_create(
+        stratum_task,
+        "Stratum",
+        NULL,
+        STRATUM_PRIORITY,
+        STRATUM_CORE,
+        "stratum",
+        STATIC_TASK_MEM(s_stratumTask)
+    );
+
+    // LAN stratum proxy for the miners around this board
+    #if USE_STRATUM_PROXY
+        stratum_proxy_init();
+    #endif
+}
+
 /**
  * Create FreeRTOS tasks for mining and pool communication
  * Miner tasks are only created if wallet is configured
@@ -400,80 +551,111 @@ void setupTasks() {
 
     // Stratum task (pool communication) - only if configured
     if (hasValidConfig) {
-        xTaskCreatePinnedToCore(
-            stratum_task,
-            "Stratum",
-            STRATUM_STACK,
-            NULL,
-            STRATUM_PRIORITY,
-            &stratumTask,
-            STRATUM_CORE
-        );
+        startStratumTask();
     }
 
     // Monitor task (display + stats) - always runs for UI
-    xTaskCreatePinnedToCore(
+    monitorTask = mem_task_create(
         monitor_task,
         "Monitor",
-        MONITOR_STACK,
         NULL,
         MONITOR_PRIORITY,
-        &monitorTask,
-        MONITOR_CORE
+        MONITOR_CORE,
+        "monitor",
+        STATIC_TASK_MEM(s_monitorTask)
     );
 
+    // Metrics endpoint for scraping (own low-priority task on Core 0)
+    #if USE_METRICS_SERVER
+        metrics_init();
+    #endif
+
+    // Share and hashrate log on the SD card (own low-priority task on Core 0)
+    #if USE_SD_LOG
+        sd_log_init();
+    #endif
+
+    // Stratum line capture and replay (own low-priority task on Core 0)
+    #if USE_STRATUM_CAPTURE
+        stratum_capture_init();
+    #endif
+
     // Button task (responsive UI during mining)
-    // Needs 4KB+ stack for NVS writes (rotation save) and display updates
     #if defined(BUTTON_PIN) && (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
-        xTaskCreatePinnedToCore(
+        buttonTask = mem_task_create(
             button_task,
             "Button",
-            4096,           // 4KB stack for NVS/flash operations in handlers
             NULL,
-            5,              // Priority 5: above miner0 (1), below miner1 (19)
-            &buttonTask,
-            0               // Core 0 with other UI tasks
+            BUTTON_PRIORITY,
+            BUTTON_CORE,
+            "ui",
+            STATIC_TASK_MEM(s_buttonTask)
         );
     #endif
 
     // Only create miner tasks if wallet is configured
     if (hasValidConfig) {
+        // Share verify task first, so the miners' first candidates find it
+        mem_task_create(
+            miner_task_verify,
+            "Verify",
+            NULL,
+            VERIFY_PRIORITY,
+            VERIFY_CORE,
+            "miner",
+            STATIC_TASK_MEM(s_verifyTask)
+        );
+
         #if (SOC_CPU_CORES_NUM >= 2)
             // Dual-core: Run miners on both cores
             // Miner on Core 1 (high priority, dedicated core)
-            xTaskCreatePinnedToCore(
+            miner1Task = mem_task_create(
                 miner_task_core1,
                 "Miner1",
-                MINER_1_STACK,
                 NULL,
                 MINER_1_PRIORITY,
-                &miner1Task,
-                MINER_1_CORE
+                MINER_1_CORE,
+                "miner",
+                STATIC_TASK_MEM(s_miner1Task)
             );
 
             // Miner on Core 0 (lower priority, yields to WiFi/Stratum/Display)
-            xTaskCreatePinnedToCore(
+            miner0Task = mem_task_create(
                 miner_task_core0,
                 "Miner0",
-                MINER_0_STACK,
                 NULL,
                 MINER_0_PRIORITY,
-                &miner0Task,
-                MINER_0_CORE
+                MINER_0_CORE,
+                "miner",
+                STATIC_TASK_MEM(s_miner0Task)
             );
 
             Serial.println("[INIT] All tasks created (dual-core mining)");
         #else
             // Single-core (C3, S2): Run only one miner task, not pinned
             // Must yield frequently to let WiFi/Stratum work
-            xTaskCreate(
-                miner_task_core0,
-                "Miner",
-                MINER_0_STACK,
-                NULL,
-                MINER_0_PRIORITY,
-                &miner0Task
-            );
+            #if MINER_HAS_HW_KERNELS
+                // C3: hardware kernel task at Miner0's priority (software fallback built in)
+                miner1Task = mem_task_create(
+                    miner_task_core1,
+                    "Miner",
+                    NULL,
+                    MINER_0_PRIORITY,
+                    tskNO_AFFINITY,
+                    "miner",
+                    STATIC_TASK_MEM(s_miner0Task)
+                );
+            #else
+                miner0Task = mem_task_create(
+                    miner_task_core0,
+                    "Miner",
+                    NULL,
+                    MINER_0_PRIORITY,
+                    tskNO_AFFINITY,
+                    "miner",
+                    STATIC_TASK_MEM(s_miner0Task)
+                );
+            #endif
 
             Serial.println("[INIT] All tasks created (single-core mining)");
         #endif
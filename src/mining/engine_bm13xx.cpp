@@ -0,0 +1,491 @@
+/*
+ * SparkMiner - BM13xx ASIC Engine Implementation
+ * See engine_bm13xx.h.
+ */
+
+#include <Arduino.h>
+#include "engine_bm13xx.h"
+
+static bm13xx_stats_t s_stats = {0};
+
+#if USE_ASIC_BM13XX
+
+// Frame header: commands carry a CRC5, work frames a CRC16
+#define BM_TYPE_JOB         0x20
+#define BM_TYPE_CMD         0x40
+#define BM_GROUP_SINGLE     0x00
+#define BM_GROUP_ALL        0x10
+#define BM_CMD_SETADDRESS   0x00
+#define BM_CMD_WRITE        0x01
+#define BM_CMD_READ         0x02
+#define BM_CMD_INACTIVE     0x03
+
+// Registers
+#define BM_REG_CHIP_ID      0x00
+#define BM_REG_PLL0         0x08
+#define BM_REG_HASH_COUNT   0x10
+#define BM_REG_TICKET_MASK  0x14
+#define BM_REG_MISC_CONTROL 0x18
+#define BM_REG_ORDERED_CLK  0x20
+#define BM_REG_FAST_UART    0x28
+#define BM_REG_CORE_CONTROL 0x3C
+#define BM_REG_ANALOG_MUX   0x54
+#define BM_REG_IO_DRIVER    0x58
+#define BM_REG_PLL3         0x68
+#define BM_REG_PLL0_DIVIDER 0x70
+#define BM_REG_CLK_ORDER0   0x80
+#define BM_REG_CLK_ORDER1   0x84
+#define BM_REG_VERSION_ROLL 0xA4
+#define BM_REG_A8           0xA8
+
+#define BM_FRAME_MAX        96
+#define BM_ID_TIMEOUT_MS    500     // Replies to the chip id broadcast
+#define BM_CHIP_MAX         64
+
+// Per model: chip id, response length, small cores (hashes per clock) and
+// the register write that selects the fast UART rate
+#if ASIC_MODEL == ASIC_BM1397
+    #define BM_NAME         "bm1397"
+    #define BM_CHIP_ID      0x1397
+    #define BM_RESULT_LEN   9       // AA 55, nonce, midstate, job id, crc
+    #define BM_SMALL_CORES  672
+    #define BM_TAG_SHIFT    2       // Job ids step by 4 (low bits: midstate index)
+    #define BM_FAST_REG     BM_REG_MISC_CONTROL
+    #define BM_FAST_VALUE   0x00006031
+    #define BM_FAST_BAUD    3125000
+#elif ASIC_MODEL == ASIC_BM1366
+    #define BM_NAME         "bm1366"
+    #define BM_CHIP_ID      0x1366
+    #define BM_RESULT_LEN   11      // AA 55, nonce, midstate, job id, version, crc
+    #define BM_SMALL_CORES  894
+    #define BM_TAG_SHIFT    3       // Job ids step by 8 (low bits: small core)
+    #define BM_FAST_REG     BM_REG_FAST_UART
+    #define BM_FAST_VALUE   0x11300200
+    #define BM_FAST_BAUD    1000000
+    #define BM_ROLL_MASK    0x1fffe000  // Version bits the chip can roll
+#else
+    #error "ASIC_MODEL must be ASIC_BM1397 or ASIC_BM1366"
+#endif
+
+#if (ASIC_TICKET_DIFF & (ASIC_TICKET_DIFF - 1)) != 0
+    #error "ASIC_TICKET_DIFF must be a power of two"
+#endif
+
+static HardwareSerial s_uart(ASIC_UART_NUM);
+static uint32_t s_workMs = 0;           // millis() the current work went out
+
+// What each tag was sent with, for the results that come back on it
+static uint32_t s_tagTicket[ENGINE_TAGS];
+static uint32_t s_tagVersion[ENGINE_TAGS];
+static uint32_t s_tagMask[ENGINE_TAGS];
+
+// Last result, chips sometimes report a nonce twice
+static uint32_t s_lastNonce = 0;
+static uint8_t s_lastTag = 0xFF;
+
+// ============================================================
+// Framing
+// ============================================================
+
+// CRC-5 (x^5 + x^2 + 1, init 0x1f) of a command after the preamble
+static uint8_t crc5(const uint8_t *data, size_t len) {
+    uint8_t crc = 0x1F;
+    for (size_t i = 0; i < len; i++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            uint8_t feedback = ((crc >> 4) ^ (data[i] >> bit)) & 1;
+            crc = (crc << 1) & 0x1F;
+            if (feedback) crc ^= 0x05;
+        }
+    }
+    return crc;
+}
+
+// CRC-16/CCITT-FALSE of a work frame after the preamble
+static uint16_t crc16(const uint8_t *data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static void sendFrame(uint8_t header, const uint8_t *data, uint8_t len) {
+    uint8_t buf[BM_FRAME_MAX];
+    bool job = header & BM_TYPE_JOB;
+
+    buf[0] = 0x55;
+    buf[1] = 0xAA;
+    buf[2] = header;
+    buf[3] = len + (job ? 4 : 3);   // Header, length and CRC bytes included
+    memcpy(&buf[4], data, len);
+
+    size_t total = len + 4;
+    if (job) {
+        uint16_t crc = crc16(&buf[2], len + 2);
+        buf[total++] = crc >> 8;
+        buf[total++] = crc & 0xFF;
+    } else {
+        buf[total] = crc5(&buf[2], len + 2);
+        total++;
+    }
+    s_uart.write(buf, total);
+}
+
+static void sendCmd(uint8_t header, uint8_t b0, uint8_t b1) {
+    uint8_t data[2] = {b0, b1};
+    sendFrame(BM_TYPE_CMD | header, data, sizeof(data));
+}
+
+// Write a register on one chip, or on every chip when all is set
+static void writeReg(uint8_t chip, bool all, uint8_t reg, uint32_t value) {
+    uint8_t data[6] = {chip, reg,
+                       (uint8_t)(value >> 24), (uint8_t)(value >> 16),
+                       (uint8_t)(value >> 8), (uint8_t)value};
+    sendFrame(BM_TYPE_CMD | (all ? BM_GROUP_ALL : BM_GROUP_SINGLE) | BM_CMD_WRITE, data, sizeof(data));
+}
+
+static void writeAll(uint8_t reg, uint32_t value) {
+    writeReg(0x00, true, reg, value);
+}
+
+// One response frame, resynchronising on the AA 55 preamble
+static bool readFrame(uint8_t *frame) {
+    while (s_uart.available() >= BM_RESULT_LEN) {
+        if (s_uart.peek() != 0xAA) {
+            s_uart.read();
+            s_stats.resyncs++;
+            continue;
+        }
+        s_uart.readBytes(frame, BM_RESULT_LEN);
+        if (frame[1] == 0x55) return true;
+        s_stats.resyncs += BM_RESULT_LEN;
+    }
+    return false;
+}
+
+static void drain() {
+    while (s_uart.available()) s_uart.read();
+}
+
+// ============================================================
+// Chain Setup
+// ============================================================
+
+// Every chip answers a broadcast chip id read
+static uint8_t countChips() {
+    uint8_t frame[BM_RESULT_LEN];
+    uint8_t chips = 0;
+
+    drain();
+    sendCmd(BM_GROUP_ALL | BM_CMD_READ, 0x00, BM_REG_CHIP_ID);
+    uint32_t start = millis();
+    while (millis() - start < BM_ID_TIMEOUT_MS) {
+        if (!readFrame(frame)) {
+            delay(1);
+            continue;
+        }
+        if (((frame[2] << 8) | frame[3]) == BM_CHIP_ID && chips < BM_CHIP_MAX) chips++;
+    }
+    return chips;
+}
+
+// Stop the chips forwarding commands, then hand out addresses along the
+// chain; evenly spaced, since the address also splits the nonce space
+static void assignAddresses(uint8_t chips) {
+    sendCmd(BM_GROUP_ALL | BM_CMD_INACTIVE, 0x00, 0x00);
+    delay(10);
+    for (uint8_t i = 0; i < chips; i++) {
+        sendCmd(BM_GROUP_SINGLE | BM_CMD_SETADDRESS, i * (256 / chips), 0x00);
+        delay(10);
+    }
+}
+
+static uint8_t reverseBits(uint8_t b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    b = (b & 0xAA) >> 1 | (b & 0x55) << 1;
+    return b;
+}
+
+// Chips return nonces whose hash meets diff (a power of two)
+static void setTicketDiff(uint32_t diff) {
+    uint32_t bits = diff - 1;
+    uint32_t mask = 0;
+    for (int i = 0; i < 4; i++) {
+        mask |= (uint32_t)reverseBits((bits >> (8 * i)) & 0xFF) << (8 * i);
+    }
+    writeAll(BM_REG_TICKET_MASK, mask);
+    s_stats.ticketDiff = diff;
+}
+
+// Highest power of two at or below both the pool difficulty and ASIC_TICKET_DIFF,
+// so no share the pool would take is filtered out on the chip
+static uint32_t ticketFor(double shareDifficulty) {
+    uint32_t diff = ASIC_TICKET_DIFF;
+    while (diff > 1 && diff > shareDifficulty) diff >>= 1;
+    return diff;
+}
+
+// PLL0 = 25 MHz x fb / (refdiv x postdiv1 x postdiv2), closest setting to mhz
+static uint32_t setFrequency(uint32_t mhz) {
+    uint32_t best = 0, bestValue = 0;
+    float bestErr = 1e9;
+
+    for (uint32_t refdiv = 2; refdiv >= 1; refdiv--) {
+        for (uint32_t post1 = 7; post1 >= 1; post1--) {
+            for (uint32_t post2 = post1; post2 >= 1; post2--) {
+                uint32_t div = refdiv * post1 * post2;
+                uint32_t fb = (mhz * div + 12) / 25;
+                if (fb < 0xA0 || fb > 0xEF) continue;
+                float f = 25.0f * fb / div;
+                float err = fabsf(f - mhz);
+                if (err < bestErr) {
+                    bestErr = err;
+                    best = (uint32_t)f;
+                    uint32_t vco = 25 * fb / refdiv;
+                    bestValue = (uint32_t)(vco >= 2400 ? 0x50 : 0x40) << 24 | fb << 16 |
+                                refdiv << 8 | (post1 - 1) << 4 | (post2 - 1);
+                }
+            }
+        }
+    }
+    if (!best) return 0;
+
+#if ASIC_MODEL == ASIC_BM1397
+    writeAll(BM_REG_PLL0_DIVIDER, 0x0F0F0F00);
+    delay(10);
+#endif
+    writeAll(BM_REG_PLL0, bestValue);
+    delay(10);
+    return best;
+}
+
+// Walk the clock up, a jump straight to full speed can brown out the supply
+static uint32_t rampFrequency(uint32_t target) {
+    uint32_t mhz = 0;
+    for (uint32_t f = 50; f < target; f += ASIC_FREQ_STEP_MHZ) {
+        mhz = setFrequency(f);
+        delay(20);
+    }
+    uint32_t reached = setFrequency(target);
+    return reached ? reached : mhz;
+}
+
+static void configureChain(uint8_t chips) {
+#if ASIC_MODEL == ASIC_BM1397
+    assignAddresses(chips);
+    writeAll(BM_REG_CLK_ORDER0, 0x00000000);
+    writeAll(BM_REG_CLK_ORDER1, 0x00000000);
+    writeAll(BM_REG_ORDERED_CLK, 0x00000001);
+    writeAll(BM_REG_CORE_CONTROL, 0x80008074);
+    setTicketDiff(ASIC_TICKET_DIFF);
+    writeAll(BM_REG_PLL3, 0xC0700111);
+    writeAll(BM_REG_FAST_UART, 0x0600000F);
+    writeAll(BM_REG_MISC_CONTROL, 0x00007A31);     // Init baud rate
+#else
+    writeAll(BM_REG_VERSION_ROLL, 0x90000000);     // No rolling until a pool grants a mask
+    writeAll(BM_REG_A8, 0x00070000);
+    writeAll(BM_REG_MISC_CONTROL, 0xFF0FC100);
+    assignAddresses(chips);
+    writeAll(BM_REG_CORE_CONTROL, 0x80008540);
+    writeAll(BM_REG_CORE_CONTROL, 0x80008020);
+    setTicketDiff(ASIC_TICKET_DIFF);
+    writeAll(BM_REG_ANALOG_MUX, 0x00000003);
+    writeAll(BM_REG_IO_DRIVER, 0x02111111);
+    for (uint8_t i = 0; i < chips; i++) {
+        uint8_t addr = i * (256 / chips);
+        writeReg(addr, false, BM_REG_A8, 0x000701F0);
+        writeReg(addr, false, BM_REG_MISC_CONTROL, 0xF000C100);
+        writeReg(addr, false, BM_REG_CORE_CONTROL, 0x80008540);
+        writeReg(addr, false, BM_REG_CORE_CONTROL, 0x80008020);
+        writeReg(addr, false, BM_REG_CORE_CONTROL, 0x800082AA);
+    }
+    writeAll(BM_REG_HASH_COUNT, 0x0000151C);
+#endif
+    delay(10);
+}
+
+// Time for the chain to cover one work frame's nonce (and rolled version) space
+static void updateWorkInterval() {
+    double space = 4294967296.0 * (double)(1UL << __builtin_popcount(s_stats.versionMask));
+    double ms = space / s_stats.expectedHashRate * 1000.0 * 0.75;
+    s_stats.workMs = ms > ASIC_WORK_MAX_MS ? ASIC_WORK_MAX_MS : (ms < 1 ? 1 : (uint32_t)ms);
+}
+
+// ============================================================
+// Engine
+// ============================================================
+
+#if ASIC_MODEL == ASIC_BM1397
+// Midstate, merkle tail, ntime and nbits; the midstate goes last word first,
+// each word little-endian
+static void sendWork(const miner_engine_job_t *job) {
+    uint8_t w[50] = {0};
+    const block_header_t *h = &job->header;
+
+    w[0] = job->tag << BM_TAG_SHIFT;
+    w[1] = 1;                                   // Midstates
+    // w[2..5]: starting nonce 0, the chip address splits the space
+    memcpy(&w[6], &h->difficulty, 4);
+    memcpy(&w[10], &h->timestamp, 4);
+    memcpy(&w[14], &h->merkle_root[28], 4);
+    for (int i = 0; i < 8; i++) {
+        uint32_t word = job->midstate.hash[7 - i];
+        memcpy(&w[18 + i * 4], &word, 4);
+    }
+    sendFrame(BM_TYPE_JOB | BM_GROUP_SINGLE | BM_CMD_WRITE, w, sizeof(w));
+}
+#else
+// The whole header; the 256-bit fields go last word first
+static void sendWork(const miner_engine_job_t *job) {
+    uint8_t w[82] = {0};
+    const block_header_t *h = &job->header;
+
+    w[0] = job->tag << BM_TAG_SHIFT;
+    w[1] = 1;
+    memcpy(&w[6], &h->difficulty, 4);
+    memcpy(&w[10], &h->timestamp, 4);
+    for (int i = 0; i < 8; i++) {
+        memcpy(&w[14 + i * 4], &h->merkle_root[(7 - i) * 4], 4);
+        memcpy(&w[46 + i * 4], &h->prev_hash[(7 - i) * 4], 4);
+    }
+    memcpy(&w[78], &h->version, 4);
+    sendFrame(BM_TYPE_JOB | BM_GROUP_SINGLE | BM_CMD_WRITE, w, sizeof(w));
+}
+#endif
+
+static const char *bmInit() {
+#if ASIC_RESET_PIN >= 0
+    pinMode(ASIC_RESET_PIN, OUTPUT);
+    digitalWrite(ASIC_RESET_PIN, LOW);
+    delay(100);
+    digitalWrite(ASIC_RESET_PIN, HIGH);
+    delay(100);
+#endif
+
+    s_uart.setRxBufferSize(ASIC_RX_BUFFER);
+    s_uart.begin(ASIC_INIT_BAUD, SERIAL_8N1, ASIC_RX_PIN, ASIC_TX_PIN);
+    s_stats.baud = ASIC_INIT_BAUD;
+
+    uint8_t chips = countChips();
+    if (!chips) {
+        Serial.printf("[ASIC] No %s answered on UART%d (rx %d, tx %d)\n",
+                      BM_NAME, ASIC_UART_NUM, ASIC_RX_PIN, ASIC_TX_PIN);
+        s_uart.end();
+        return NULL;
+    }
+    if (chips != ASIC_CHIPS) {
+        Serial.printf("[ASIC] Found %u chips, expected %u\n", chips, ASIC_CHIPS);
+    }
+    s_stats.chips = chips;
+
+    configureChain(chips);
+    s_stats.mhz = rampFrequency(ASIC_FREQ_MHZ);
+
+#if ASIC_FAST_BAUD
+    writeAll(BM_FAST_REG, BM_FAST_VALUE);
+    s_uart.flush();
+    delay(10);
+    s_uart.updateBaudRate(BM_FAST_BAUD);
+    s_stats.baud = BM_FAST_BAUD;
+#endif
+    drain();
+
+    s_stats.expectedHashRate = (double)chips * BM_SMALL_CORES * s_stats.mhz * 1e6;
+    updateWorkInterval();
+    s_stats.active = true;
+
+    Serial.printf("[ASIC] %u x %s at %lu MHz, %lu baud, ~%.1f GH/s\n",
+                  chips, BM_NAME, s_stats.mhz, s_stats.baud, s_stats.expectedHashRate / 1e9);
+    return BM_NAME;
+}
+
+static void bmStart(miner_engine_job_t *job) {
+    uint32_t ticket = ticketFor(job->shareDifficulty);
+    if (ticket != s_stats.ticketDiff) {
+        setTicketDiff(ticket);
+    }
+
+#if ASIC_MODEL == ASIC_BM1366
+    uint32_t mask = job->versionMask & BM_ROLL_MASK;
+    if (mask != s_stats.versionMask) {
+        writeAll(BM_REG_VERSION_ROLL, 0x90000000 | (mask >> 13));
+        s_stats.versionMask = mask;
+        updateWorkInterval();
+    }
+#endif
+
+    uint8_t tag = job->tag % ENGINE_TAGS;
+    s_tagTicket[tag] = ticket;
+    s_tagVersion[tag] = job->header.version;
+    s_tagMask[tag] = s_stats.versionMask;
+
+    // New work replaces the chips' current work straight away
+    sendWork(job);
+    s_workMs = millis();
+    s_stats.jobs++;
+}
+
+static uint32_t bmPoll(miner_engine_job_t *job, miner_engine_result_t *out, uint32_t max,
+                       miner_engine_poll_t *status, volatile bool *run) {
+    uint8_t frame[BM_RESULT_LEN];
+    uint32_t found = 0;
+    uint32_t start = millis();
+
+    status->hashes = 0;
+    while (found < max && *run) {
+        if (!readFrame(frame)) {
+            if (millis() - start >= ASIC_POLL_MS) break;
+            vTaskDelay(1);  // The chips hash on; Core 1 is free meanwhile
+            continue;
+        }
+
+        // Bit 7 of the last byte marks a nonce; anything else is a register reply
+        if (!(frame[BM_RESULT_LEN - 1] & 0x80)) continue;
+
+        uint32_t nonce;
+        memcpy(&nonce, &frame[2], 4);   // Header byte order
+        uint8_t tag = (frame[7] >> BM_TAG_SHIFT) & (ENGINE_TAGS - 1);
+        if (nonce == s_lastNonce && tag == s_lastTag) {
+            s_stats.duplicates++;
+            continue;
+        }
+        s_lastNonce = nonce;
+        s_lastTag = tag;
+        s_stats.results++;
+
+        out[found].nonce = nonce;
+        out[found].tag = tag;
+        out[found].version = 0;
+#if ASIC_MODEL == ASIC_BM1366
+        if (s_tagMask[tag]) {
+            uint32_t bits = (uint32_t)((frame[8] << 8) | frame[9]) << 13;
+            out[found].version = (s_tagVersion[tag] & ~s_tagMask[tag]) | (bits & s_tagMask[tag]);
+        }
+#endif
+        // Each ticket stands for ticketDiff x 2^32 hashes on average
+        status->hashes += (uint64_t)s_tagTicket[tag] << 32;
+        found++;
+    }
+
+    status->exhausted = millis() - s_workMs >= s_stats.workMs;
+    return found;
+}
+
+// The chips keep hashing their last work; its results wait in the UART
+// buffer and come back against their tag on the next poll
+static void bmStop() {
+}
+
+const miner_engine_t bm13xx_engine = {
+    BM_NAME, true, bmInit, bmStart, bmPoll, bmStop
+};
+
+#endif  // USE_ASIC_BM13XX
+
+void bm13xx_get_stats(bm13xx_stats_t *out) {
+    memcpy(out, &s_stats, sizeof(*out));
+}
@@ -0,0 +1,68 @@
+/*
+ * SparkMiner - BM13xx ASIC Engine
+ * Drives a chain of Bitmain BM1397 or BM1366 chips on a UART (the Bitaxe
+ * family of boards) as the hardware miner slot's engine, so the ESP32 only
+ * builds work, rolls headers and checks results; stratum, stats and the
+ * display are unchanged.
+ *
+ * At boot the chain is reset (ASIC_RESET_PIN), counted by a broadcast chip
+ * id read, given evenly spaced addresses, clocked up to ASIC_FREQ_MHZ and
+ * switched to the chip's fast UART rate. ASIC_MODEL picks the frame layout:
+ *   BM1397  midstate, merkle tail, ntime and nbits (one midstate, no
+ *           on-chip version rolling)
+ *   BM1366  the whole header; the chips roll the BIP310 version bits the
+ *           pool granted (0x1fffe000 at most) themselves
+ *
+ * Each start sends a work frame tagged with the job's engine tag, so late
+ * nonces map back to the header they were found on. The chips return
+ * tickets at a difficulty no higher than the pool's (ASIC_TICKET_DIFF at
+ * most), and every ticket goes through the verify task's software check
+ * before submission, so a framing mistake shows up as invalid candidates,
+ * never as bad shares. The hash count is estimated from the tickets
+ * (ticket difficulty x 2^32 each). New work goes out when the chain has
+ * covered the work's nonce (and rolled version) space, or every
+ * ASIC_WORK_MAX_MS.
+ *
+ * Core voltage comes from the board's regulator, which must be up before
+ * the chips are clocked; this engine only talks to the chips.
+ *
+ * Built in with USE_ASIC_BM13XX=1. Without an answering chain the board
+ * falls back to its built-in engine.
+ */
+
+#ifndef ENGINE_BM13XX_H
+#define ENGINE_BM13XX_H
+
+#include <Arduino.h>
+#include <board_config.h>
+#include "miner_engine.h"
+
+/**
+ * Chain state and counters since boot
+ */
+typedef struct {
+    bool active;                // A chain answered at boot
+    uint8_t chips;              // Chips counted on the chain
+    uint32_t mhz;               // PLL setting reached
+    uint32_t baud;              // UART rate in use
+    uint32_t ticketDiff;        // Ticket difficulty in force
+    uint32_t versionMask;       // Version bits rolled on chip (BM1366)
+    uint32_t workMs;            // Interval between work frames on one header roll
+    double expectedHashRate;    // Chips x small cores x clock (H/s)
+    uint32_t jobs;              // Work frames sent
+    uint32_t results;           // Nonces returned
+    uint32_t duplicates;        // Repeated nonces dropped
+    uint32_t resyncs;           // Bytes skipped looking for a frame preamble
+} bm13xx_stats_t;
+
+/**
+ * The engine (only usable with USE_ASIC_BM13XX=1)
+ */
+extern const miner_engine_t bm13xx_engine;
+
+/**
+ * Copy the chain state (inactive unless built in and a chain answered)
+ */
+void bm13xx_get_stats(bm13xx_stats_t *out);
+
+#endif // ENGINE_BM13XX_H
@@ -0,0 +1,236 @@
+/*
+ * SparkMiner - CPU Frequency Governor Implementation
+ * See freq_governor.h.
+ */
+
+#include <Arduino.h>
+#include "freq_governor.h"
+#include "miner.h"
+#include "../stats/power.h"
+
+#define GOVERNOR_SAMPLES    3       // Samples before a step counts as measured
+#define GOVERNOR_RATE_ALPHA 0.3f
+#define GOVERNOR_TEMP_ALPHA 0.3f
+
+static freq_governor_stats_t s_stats = {0};
+
+#if USE_FREQ_GOVERNOR
+
+static const uint32_t STEP_MHZ[GOVERNOR_STEPS] = {80, 160, 240};
+static const uint32_t STEP_MW[GOVERNOR_STEPS] = {GOVERNOR_MW_80, GOVERNOR_MW_160, GOVERNOR_MW_240};
+
+static uint8_t s_steps = 0;             // Allowed steps, slowest first
+static uint8_t s_step = 0;              // Current step
+static uint8_t s_cap = 0;               // Highest step the temperature allows
+static uint8_t s_samples[GOVERNOR_STEPS] = {0};
+static uint8_t s_mwIndex[GOVERNOR_STEPS] = {0};
+static bool s_tempValid = false;
+static bool s_settling = false;         // Next sample spans a switch
+static uint32_t s_lastSample = 0;
+static uint64_t s_lastHashes = 0;
+static double s_lastJoules = 0;
+static float s_stepMw[GOVERNOR_STEPS] = {0};    // Measured draw per step, 0 = model
+static uint32_t s_lastChange = 0;       // Last switch
+static uint32_t s_lastRise = 0;         // Last ceiling rise
+static uint32_t s_lastExplore = 0;
+
+// ============================================================
+// Helpers
+// ============================================================
+
+static void sampleTemperature() {
+    float t = temperatureRead();
+    if (isnan(t) || t < -40.0f || t > 125.0f) return;   // Sensor not ready
+    s_stats.temperature = s_tempValid
+        ? s_stats.temperature + GOVERNOR_TEMP_ALPHA * (t - s_stats.temperature)
+        : t;
+    s_tempValid = true;
+}
+
+static void sampleHashRate(uint32_t now) {
+    uint64_t hashes = miner_get_stats()->hashes;
+    uint32_t elapsed = now - s_lastSample;
+    uint64_t delta = hashes - s_lastHashes;
+    s_lastHashes = hashes;
+    power_stats_t power;
+    power_get_stats(&power);
+    double joules = power.joules - s_lastJoules;
+    s_lastJoules = power.joules;
+
+    // Periods with a switch in them or with the miners idle measure nothing
+    bool running = miner_is_running();
+    bool skip = s_settling || !running || !delta || !elapsed;
+    s_settling = !running;
+    if (skip) return;
+
+    float rate = (float)delta * 1000.0f / elapsed;
+    float *avg = &s_stats.stepHashRate[s_step];
+    *avg = s_samples[s_step] ? *avg + GOVERNOR_RATE_ALPHA * (rate - *avg) : rate;
+
+    // A power sensor replaces the board model for this step
+    if (power.measured) {
+        float mw = joules * 1e6 / elapsed;
+        float *avgMw = &s_stepMw[s_step];
+        *avgMw = (s_samples[s_step] && *avgMw > 0) ? *avgMw + GOVERNOR_RATE_ALPHA * (mw - *avgMw) : mw;
+    }
+    if (s_samples[s_step] < GOVERNOR_SAMPLES) s_samples[s_step]++;
+}
+
+// Ceiling from the temperature; rises need the chip to have stayed cool for a dwell
+static void updateCap(uint32_t now) {
+    if (!s_tempValid) return;
+    float t = s_stats.temperature;
+
+    if (t >= GOVERNOR_TEMP_CRIT_C) {
+        if (s_cap > 0) s_stats.throttles++;
+        s_cap = 0;
+    } else if (t >= GOVERNOR_TEMP_HOT_C) {
+        // One step below where it heated up; a drop already under way counts
+        uint8_t cap = s_step > 0 ? s_step - 1 : 0;
+        if (cap < s_cap) {
+            s_cap = cap;
+            s_stats.throttles++;
+        }
+    } else if (t <= GOVERNOR_TEMP_HOT_C - GOVERNOR_TEMP_HYST_C && s_cap < s_steps - 1 &&
+               now - s_lastChange >= GOVERNOR_DWELL_MS && now - s_lastRise >= GOVERNOR_DWELL_MS) {
+        s_cap++;
+        s_lastRise = now;
+    }
+}
+
+// Best hashes per joule under the ceiling; unmeasured steps first, fastest first
+static uint8_t efficientStep() {
+    for (int i = s_cap; i >= 0; i--) {
+        if (s_samples[i] < GOVERNOR_SAMPLES) return i;
+    }
+    uint8_t best = s_step <= s_cap ? s_step : s_cap;
+    float bestPerMw = 0;
+    for (uint8_t i = 0; i <= s_cap; i++) {
+        float mw = s_stepMw[i] > 0 ? s_stepMw[i] : STEP_MW[s_mwIndex[i]];
+        float perMw = s_stats.stepHashRate[i] / mw;
+        if (perMw > bestPerMw) {
+            bestPerMw = perMw;
+            best = i;
+        }
+    }
+    return best;
+}
+
+static bool applyStep(uint8_t step, const char *why) {
+    uint32_t from = STEP_MHZ[s_mwIndex[s_step]];
+    uint32_t to = STEP_MHZ[s_mwIndex[step]];
+    uint32_t start = millis();
+
+    // Not under a running benchmark: it owns the cores and times at this
+    // clock. The next pass tries again.
+    if (miner_is_benchmarking()) return false;
+
+    // Both cores off the SHA peripheral before the clock moves under it
+    bool paused = miner_pause();
+    bool ok = paused && setCpuFrequencyMhz(to);
+    if (paused) miner_resume();
+
+    s_stats.lastPauseMs = millis() - start;
+    s_lastChange = millis();
+    s_settling = true;
+    if (!ok) {
+        s_stats.failures++;
+        Serial.printf("[GOV] Switch %lu -> %lu MHz failed (%s)\n", from, to,
+                      paused ? why : "miners did not stop");
+        return paused;
+    }
+
+    s_step = step;
+    s_stats.mhz = to;
+    s_stats.changes++;
+    Serial.printf("[GOV] %lu -> %lu MHz (%.1f C, %s, %lu ms paused)\n",
+                  from, to, s_stats.temperature, why, s_stats.lastPauseMs);
+    return true;
+}
+
+#endif  // USE_FREQ_GOVERNOR
+
+// ============================================================
+// Public API
+// ============================================================
+
+void freq_governor_init() {
+#if USE_FREQ_GOVERNOR
+    s_steps = 0;
+    for (uint8_t i = 0; i < GOVERNOR_STEPS; i++) {
+        if (STEP_MHZ[i] < GOVERNOR_MIN_MHZ || STEP_MHZ[i] > GOVERNOR_MAX_MHZ) continue;
+        s_mwIndex[s_steps] = i;
+        s_stats.stepMhz[s_steps] = STEP_MHZ[i];
+        s_steps++;
+    }
+    if (!s_steps) {
+        Serial.println("[GOV] No step within GOVERNOR_MIN_MHZ..GOVERNOR_MAX_MHZ - governor off");
+        return;
+    }
+
+    // Start at the fastest allowed step; the miners are not running yet
+    s_step = s_steps - 1;
+    s_cap = s_step;
+    uint32_t mhz = STEP_MHZ[s_mwIndex[s_step]];
+    if (getCpuFrequencyMhz() != mhz) setCpuFrequencyMhz(mhz);
+
+    s_stats.mode = GOVERNOR_MODE;
+    s_stats.mhz = getCpuFrequencyMhz();
+    s_stats.capMhz = mhz;
+    s_stats.active = s_steps > 1;
+    s_lastSample = millis();
+    s_lastChange = s_lastSample;
+    s_lastRise = s_lastSample;
+    s_settling = true;
+    s_lastExplore = s_lastSample;
+    sampleTemperature();
+
+    Serial.printf("[GOV] %lu..%lu MHz, %s, hot %d C, critical %d C\n",
+                  s_stats.stepMhz[0], s_stats.stepMhz[s_steps - 1],
+                  GOVERNOR_MODE == GOVERNOR_MAX_EFFICIENCY ? "max hashes/J" : "max hashrate",
+                  GOVERNOR_TEMP_HOT_C, GOVERNOR_TEMP_CRIT_C);
+#endif
+}
+
+bool freq_governor_update() {
+#if !USE_FREQ_GOVERNOR
+    return false;
+#else
+    if (!s_stats.active) return false;
+    uint32_t now = millis();
+    if (now - s_lastSample < GOVERNOR_PERIOD_MS) return false;
+
+    sampleTemperature();
+    sampleHashRate(now);
+    s_lastSample = now;
+    updateCap(now);
+    s_stats.capMhz = s_stats.stepMhz[s_cap];
+
+    // Over the ceiling: down now, whatever the dwell
+    if (s_step > s_cap) {
+        return applyStep(s_cap, "hot");
+    }
+    if (!miner_is_running()) return false;
+
+    uint8_t want = s_cap;
+    const char *why = "cool";
+    if (GOVERNOR_MODE == GOVERNOR_MAX_EFFICIENCY) {
+        // Forget the other steps now and then: the board's temperature moves them
+        if (now - s_lastExplore >= GOVERNOR_EXPLORE_MS) {
+            s_lastExplore = now;
+            for (uint8_t i = 0; i < s_steps; i++) {
+                if (i != s_step) s_samples[i] = 0;
+            }
+        }
+        want = efficientStep();
+        why = s_samples[want] < GOVERNOR_SAMPLES ? "measuring" : "efficiency";
+    }
+
+    if (want == s_step || now - s_lastChange < GOVERNOR_DWELL_MS) return false;
+    return applyStep(want, why);
+#endif
+}
+
+void freq_governor_get_stats(freq_governor_stats_t *out) {
+    memcpy(out, &s_stats, sizeof(*out));
+}
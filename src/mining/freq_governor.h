@@ -0,0 +1,74 @@
+/*
+ * SparkMiner - CPU Frequency Governor
+ * Steps the CPU clock between 80, 160 and 240 MHz (within the board's
+ * GOVERNOR_MIN_MHZ..GOVERNOR_MAX_MHZ) while mining, so a board that
+ * heat-soaks in its case slows down instead of going unstable.
+ *
+ * Every GOVERNOR_PERIOD_MS the on-chip temperature sensor (the one behind
+ * the display temperature) and the hashrate since the last sample are
+ * read. At GOVERNOR_TEMP_HOT_C the ceiling drops one step per period, at
+ * GOVERNOR_TEMP_CRIT_C straight to the lowest step; it rises again one
+ * step per GOVERNOR_DWELL_MS once the chip is GOVERNOR_TEMP_HYST_C below
+ * the hot threshold.
+ *
+ * Under the ceiling, GOVERNOR_MODE picks the step:
+ *   GOVERNOR_MAX_HASHRATE    the ceiling itself
+ *   GOVERNOR_MAX_EFFICIENCY  the best measured hashrate per mW of the
+ *                            board's draw (measured with a power sensor,
+ *                            see power.h, else GOVERNOR_MW_*); steps not
+ *                            measured yet are tried first, and the others
+ *                            are measured again every GOVERNOR_EXPLORE_MS
+ *
+ * A change pauses both miners (miner_pause), so the SHA peripheral is
+ * released and its clock gated before the switch; the cores re-acquire it
+ * and re-prepare their midstate at the new clock. APB stays at 80 MHz,
+ * so UART, WiFi and the timers are unaffected.
+ *
+ * Built in with USE_FREQ_GOVERNOR=1.
+ */
+
+#ifndef FREQ_GOVERNOR_H
+#define FREQ_GOVERNOR_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+#define GOVERNOR_STEPS 3    // 80, 160, 240 MHz
+
+/**
+ * Governor state and counters since boot
+ */
+typedef struct {
+    bool active;                // Built in and more than one step allowed
+    uint8_t mode;               // GOVERNOR_MODE
+    uint32_t mhz;               // Current CPU clock
+    uint32_t capMhz;            // Thermal ceiling
+    float temperature;          // Smoothed chip temperature (C)
+    uint32_t changes;           // Clock switches
+    uint32_t throttles;         // Ceiling drops for heat
+    uint32_t failures;          // Pauses or switches that did not complete
+    uint32_t lastPauseMs;       // Mining time lost to the last switch
+    uint32_t stepMhz[GOVERNOR_STEPS];       // 0 past the allowed steps
+    float stepHashRate[GOVERNOR_STEPS];     // Measured H/s, 0 = not yet
+} freq_governor_stats_t;
+
+/**
+ * Work out the allowed steps and move into them if the boot clock is outside
+ * Call once at boot, before the mining tasks start.
+ */
+void freq_governor_init();
+
+/**
+ * Sample and step if due (cheap otherwise)
+ * Call from the monitor task loop.
+ *
+ * @return true if the miners were paused for a switch
+ */
+bool freq_governor_update();
+
+/**
+ * Copy the governor state
+ */
+void freq_governor_get_stats(freq_governor_stats_t *out);
+
+#endif // FREQ_GOVERNOR_H
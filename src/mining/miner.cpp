@@ -15,6 +15,8 @@
 #if defined(CONFIG_IDF_TARGET_ESP32)
 #include <soc/dport_reg.h>
 #include <soc/hwcrypto_reg.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32S3) || defined(CONFIG_IDF_TARGET_ESP32C3)
+#include <sha/sha_dma.h>  // For esp_sha_acquire/release_hardware
 #endif
 
 #include "miner.h"
@@ -22,11 +24,17 @@
 #include "sha256_hw.h"  // Hardware SHA-256 wrapper
 #include "sha256_ll.h"  // Low-level hardware SHA register access
 #include "sha256_s3.h"  // S3-specific SHA (proven working with self-test)
-#include "sha256_s3_dma.h"  // DMA-based SHA test
+#include "sha256_s3_dma.h"  // DMA job-build hashing - ESP32-S3
 #include "sha256_asm.h"  // Pipelined assembly mining (Core 1) - ESP32
 #include "sha256_pipelined_s3.h"  // Pipelined assembly mining (Core 1) - ESP32-S3
 #include "miner_sha256.h"  // BitsyMiner software SHA-256 (verification + Core 0)
+#include "miner_kernels.h"  // Core 1 kernel registry + boot-time auto-tune
+#include "miner_engine.h"  // Core 1 hash engine interface
+#include "engine_bm13xx.h"  // External BM13xx ASIC chain (USE_ASIC_BM13XX)
+#include "miner_work.h"  // Coinbase/merkle builders and target math
 #include "../stratum/stratum.h"
+#include "../stats/trace.h"
+#include "../stats/mem_budget.h"
 #include "board_config.h"
 
 // ============================================================
@@ -34,261 +42,277 @@
 // ============================================================
 #define MAX_DIFFICULTY 0x1d00ffff
 
+// Nonce ranges are counted in SHA message-word order (the byte-swapped header
+// nonce), which is what the hardware kernels increment.
+#define NONCE_RANGE_SPLIT   0x80000000  // Initial per-core share of a job's nonce space
+#define NONCE_RANGE_FULL    0xFFFFFFFF  // Rolled extranonce2 ranges belong to one core
+#define NONCE_ROLL_GUARD    0x00100000  // HW kernels only return on candidates (~65k hashes)
+
+// ntime rolling: never run ahead of the job's ntime by more than the real
+// time elapsed since the job arrived plus this margin (seconds)
+#define NTIME_ROLL_AHEAD    60
+
+#if CORE_0_BATCH_SIZE > MINER_SHA256_BATCH_MAX
+    #error "CORE_0_BATCH_SIZE exceeds MINER_SHA256_BATCH_MAX"
+#endif
+
+#if (CANDIDATE_RING_SIZE & (CANDIDATE_RING_SIZE - 1)) != 0
+    #error "CANDIDATE_RING_SIZE must be a power of two"
+#endif
+
 // ============================================================
 // Globals
 // ============================================================
 
 // Mining state
 static volatile bool s_miningActive = false;
+static volatile bool s_benchActive = false;   // Cores paused: a benchmark or a clock change owns the hardware
+static volatile bool s_benchResume = false;   // Resume mining when the last pause ends
+static volatile bool s_benchRunning = false;  // miner_benchmark() in progress
+static uint8_t s_pauseDepth = 0;              // Nested benchPause() calls (under s_benchLock)
+static portMUX_TYPE s_benchLock = portMUX_INITIALIZER_UNLOCKED;
 static volatile bool s_core0Mining = false;
 static volatile bool s_core1Mining = false;
 
+// Per-core run flags, passed to the mining kernels as their stop flag.
+// miner_start_job() clears them after publishing so each core drops out
+// of its kernel loop and picks up the new job slot.
+static volatile bool s_coreRun[2] = {false, false};
+
 // Hardware SHA mutex for dual-core sharing
 // Core 1 holds this during pipelined mining bursts
 // Core 0 can grab it during Core 1's yield periods
 static SemaphoreHandle_t s_shaMutex = NULL;
 static volatile bool s_core1HasSha = false;  // Fast check to avoid mutex overhead
 
-// Current job
-static block_header_t s_pendingBlock;
-static char s_currentJobId[MAX_JOB_ID_LEN];
-static SemaphoreHandle_t s_jobMutex = NULL;
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+// Job builds borrow the SHA peripheral from Core 1 to hash on the DMA engine.
+// While s_shaWanted is set Core 1 stays off the peripheral; it is cleared
+// once the new job is published, so Core 1 goes straight onto it.
+static bool s_dmaJobs = false;               // DMA path passed its self-test
+static bool s_dmaTested = false;             // Self-test runs after the first job
+static volatile bool s_shaWanted = false;    // A job build owns (or is taking) the peripheral
+static TaskHandle_t s_core1Task = NULL;      // Woken when s_shaWanted clears
+#endif
+
+// Job slot - everything a core needs to mine one job
+typedef struct {
+    block_header_t header;              // Unswapped block header (nonce = 0)
+    char jobId[MAX_JOB_ID_LEN];         // Pool job ID
+    char extraNonce2[20];               // ExtraNonce2 hex for submission
+    uint32_t startNonce[2];             // Nonce start point for each core (SHA word order)
+    uint32_t jobVersion;                // Version from mining.notify (before rolling)
+    uint32_t versionMask;               // BIP310 rolling mask granted by the pool (0 = off)
+    uint32_t jobNtime;                  // ntime from mining.notify (before rolling)
+    bool headerOnly;                    // Stratum V2 job: no coinbase, extranonce2 cannot roll
+    uint32_t publishTime;               // micros() when the slot was published
+    uint32_t publishMs;                 // millis() when the slot was published (ntime limit)
+} miner_job_t;
+
+// Double-buffered job slots (seqlock-style)
+// The stratum task is the only writer: it fills the slot the cores are NOT
+// reading, then bumps s_jobSeq. Readers copy slot[seq & 1] and retry if the
+// sequence moved underneath them. Neither side ever blocks or sleeps.
+static miner_job_t s_jobSlots[2];
+static volatile uint32_t s_jobSeq = 0;
+
+// Binary coinbase + merkle branches, one per job slot (same seq & 1 index).
+// Only read when a core needs a new extranonce2 range.
+static miner_coinbase_t s_coinbase[2];
+
+// Extranonce2 roll, prepared ahead of time by Core 0
+typedef struct {
+    uint32_t jobSeq;                    // Job the roll was built for
+    uint32_t extraNonce2;               // Extranonce2 value for this range
+    uint8_t merkleRoot[32];             // Matching merkle root
+} miner_roll_t;
+
+static miner_roll_t s_rollReady;
+static bool s_rollReadyValid = false;
+static portMUX_TYPE s_rollLock = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t s_rollCounter = 0;  // Extranonce2 offsets handed out for the current job
+
+// Version rolling (BIP310)
+static uint32_t s_versionMask = 0;                // Mask negotiated via mining.configure
+static volatile uint32_t s_versionCounter = 0;    // Version offsets handed out for the current job
+
+// ntime rolling
+static volatile uint32_t s_ntimeCounter = 0;      // ntime offsets handed out for the current job
+
+// Yield scheduling
+static volatile uint32_t s_lastDemandMs = 0;      // Last miner_yield_hint() (millis)
 
 // Extra nonce
 static char s_extraNonce1[32] = {0};
 static int s_extraNonce2Size = 4;
-static unsigned long s_extraNonce2 = 1;
 
 // Targets
-static uint8_t s_blockTarget[32];
+// Share tiers are classified on the leading 64 bits of the hash (words 7-6),
+// precomputed here whenever a target changes; see tierCompare()
 static uint8_t s_poolTarget[32];
+static uint64_t s_poolLead = 0;                   // Leading bits of s_poolTarget
+static portMUX_TYPE s_targetLock = portMUX_INITIALIZER_UNLOCKED;
 static double s_poolDifficulty = 1.0;
 
+// Verify task only
+static uint32_t s_blockBits = 0;                  // nbits the block tier was built for
+static uint8_t s_blockTarget[32];
+static uint64_t s_blockLead = 0;
+static uint64_t s_bestLead = UINT64_MAX;          // Leading bits of the best hash so far
+
 // Statistics
 static mining_stats_t s_stats = {0};
 
-// DEBUG: Per-core hash counters to verify counting (non-static for extern access)
-volatile uint64_t s_core0Hashes = 0;
-volatile uint64_t s_core1Hashes = 0;
-
-// Nonce ranges for dual-core
-static unsigned long s_startNonce[2] = {0, 0x80000000};
+// Per-core hash counts. Each core counts locally and publishes into its own
+// slot (only that core ever writes it); miner_get_stats() sums them on read.
+static volatile uint64_t s_coreHashes[2] = {0, 0};
+static const char *s_hwKernelName = NULL;        // Kernel the hardware miner settled on
+
+// Share candidate handed from a mining loop to the verify task.
+// Carries the rolled header itself: the job slot may be rebuilt and the
+// core may have moved to another extranonce2 by the time it is verified.
+typedef struct {
+    block_header_t header;              // Unswapped header with the candidate nonce
+    char jobId[MAX_JOB_ID_LEN];         // Pool job ID
+    char extraNonce2[20];               // ExtraNonce2 hex of the range the nonce came from
+    uint32_t versionMask;               // BIP310 rolling mask of the job (0 = off)
+} miner_candidate_t;
+
+// Lock-free single-producer ring, one per mining core. The owning core only
+// writes head and drops; miner_task_verify() is the only reader and only
+// writes tail. Free-running indices, masked on access.
+typedef struct {
+    miner_candidate_t entries[CANDIDATE_RING_SIZE];
+    volatile uint32_t head;             // Next entry to fill (producer)
+    volatile uint32_t tail;             // Next entry to verify (consumer)
+    volatile uint32_t drops;            // Candidates lost to a full ring (producer)
+} miner_candidate_ring_t;
+
+static miner_candidate_ring_t s_candidates[2];
+static TaskHandle_t s_verifyTask = NULL;
+
+// Core 1 engine jobs by tag: the header each result was hashed against
+static miner_job_t s_engineJobs[ENGINE_TAGS];
 
 // ============================================================
-// Utility Functions
+// Target Functions
 // ============================================================
 
-static uint8_t decodeHexChar(char c) {
-    if (c >= '0' && c <= '9') return c - '0';
-    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
-    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
-    return 0;
-}
-
-static void hexToBytes(uint8_t *out, const char *in, size_t len) {
-    for (size_t i = 0; i < len; i += 2) {
-        out[i/2] = (decodeHexChar(in[i]) << 4) | decodeHexChar(in[i + 1]);
-    }
-}
-
-static void encodeExtraNonce(char *dest, size_t len, unsigned long en) {
-    static const char *tbl = "0123456789ABCDEF";
-    dest += len * 2;
-    *dest-- = '\0';
-    while (len--) {
-        *dest-- = tbl[en & 0x0f];
-        *dest-- = tbl[(en >> 4) & 0x0f];
-        en >>= 8;
-    }
+// Leading 64 bits of a 256-bit little-endian number (words 7 and 6).
+// memcpy because the byte-array targets carry no word alignment.
+static inline uint64_t leadingBits(const uint8_t *le256) {
+    uint64_t lead;
+    memcpy(&lead, le256 + 24, 8);
+    return lead;
 }
 
-static void swapBytesInWords(uint8_t *buf, size_t len) {
-    for (size_t i = 0; i < len; i += 4) {
-        uint8_t temp = buf[i];
-        buf[i] = buf[i + 3];
-        buf[i + 3] = temp;
-        temp = buf[i + 1];
-        buf[i + 1] = buf[i + 2];
-        buf[i + 2] = temp;
-    }
-}
-
-// ============================================================
-// Target Functions
-// ============================================================
-
-static void bits_to_target(uint32_t nBits, uint8_t *target) {
-    uint32_t exponent = nBits >> 24;
-    uint32_t mantissa = nBits & 0x007fffff;
-    if (nBits & 0x00800000) {
-        mantissa |= 0x00800000;
-    }
-    memset(target, 0, 32);
-    if (exponent <= 3) {
-        mantissa >>= 8 * (3 - exponent);
-        memcpy(target, &mantissa, 4);
-    } else {
-        int shift = (exponent - 3);
-        uint32_t *target_ptr = (uint32_t *)(target + shift);
-        *target_ptr = mantissa;
-    }
-}
-
-static void divide_256bit_by_double(uint64_t *target, double divisor) {
-    uint64_t result[4] = {0};
-    double remainder = 0.0;
-    
-    // Iterate from MSB (target[3]) to LSB (target[0])
-    for (int i = 3; i >= 0; i--) {
-        // Add carried remainder from upper word (scaled by 2^64)
-        double val = (double)target[i] + remainder * 18446744073709551616.0;
-        
-        double res = val / divisor;
-        
-        // Clamp to prevent overflow (shouldn't happen with diff >= 1)
-        if (res >= 18446744073709551615.0) {
-            result[i] = 0xFFFFFFFFFFFFFFFFULL;
-        } else {
-            result[i] = (uint64_t)res;
-        }
-        
-        remainder = val - ((double)result[i] * divisor);
-    }
-    
-    memcpy(target, result, sizeof(result));
-}
-
-static void adjust_target_for_difficulty(uint8_t *pt, uint8_t *bt, double difficulty) {
-    uint64_t target_parts[4];
-    for (int i = 0; i < 4; i++) {
-        target_parts[i] = ((uint64_t)bt[i * 8 + 0]) |
-                          ((uint64_t)bt[i * 8 + 1] << 8) |
-                          ((uint64_t)bt[i * 8 + 2] << 16) |
-                          ((uint64_t)bt[i * 8 + 3] << 24) |
-                          ((uint64_t)bt[i * 8 + 4] << 32) |
-                          ((uint64_t)bt[i * 8 + 5] << 40) |
-                          ((uint64_t)bt[i * 8 + 6] << 48) |
-                          ((uint64_t)bt[i * 8 + 7] << 56);
-    }
-    divide_256bit_by_double(target_parts, difficulty);
-    for (int i = 0; i < 4; i++) {
-        pt[i * 8 + 0] = target_parts[i] & 0xff;
-        pt[i * 8 + 1] = (target_parts[i] >> 8) & 0xff;
-        pt[i * 8 + 2] = (target_parts[i] >> 16) & 0xff;
-        pt[i * 8 + 3] = (target_parts[i] >> 24) & 0xff;
-        pt[i * 8 + 4] = (target_parts[i] >> 32) & 0xff;
-        pt[i * 8 + 5] = (target_parts[i] >> 40) & 0xff;
-        pt[i * 8 + 6] = (target_parts[i] >> 48) & 0xff;
-        pt[i * 8 + 7] = (target_parts[i] >> 56) & 0xff;
-    }
+// Classify a hash against one tier with a single 64-bit compare (two 32-bit
+// compares on these cores). Only equal leading bits need the full 256 bits.
+static inline bool tierCompare(uint64_t hashLead, uint64_t tierLead,
+                               const sha256_hash_t *ctx, const uint8_t *target) {
+    if (hashLead != tierLead) return hashLead < tierLead;
+    return check_target(ctx->bytes, target);
 }
 
 static void setPoolTarget() {
     uint8_t maxDifficulty[32];
+    uint8_t target[32];
     bits_to_target(MAX_DIFFICULTY, maxDifficulty);
-    adjust_target_for_difficulty(s_poolTarget, maxDifficulty, s_poolDifficulty);
+    adjust_target_for_difficulty(target, maxDifficulty, s_poolDifficulty);
+
+    portENTER_CRITICAL(&s_targetLock);
+    memcpy(s_poolTarget, target, 32);
+    s_poolLead = leadingBits(target);
+    portEXIT_CRITICAL(&s_targetLock);
 }
 
-// Check if hash meets target (little-endian comparison from high bytes)
-static int check_target(const uint8_t *hash, const uint8_t *target) {
-    for (int i = 31; i >= 0; i--) {
-        if (hash[i] < target[i]) return 1;  // Valid
-        if (hash[i] > target[i]) return 0;  // Invalid
-    }
-    return 1;  // Equal is valid
+// Block tier for a candidate's nbits (verify task; rebuilt only when nbits changes)
+static void setBlockTarget(uint32_t nbits) {
+    if (nbits == s_blockBits) return;
+    bits_to_target(nbits, s_blockTarget);
+    s_blockLead = leadingBits(s_blockTarget);
+    s_blockBits = nbits;
 }
 
 // ============================================================
-// Merkle Root Calculation
+// Difficulty Calculation
 // ============================================================
 
-static void double_sha256_merkle(uint8_t *dest, uint8_t *buf64) {
-    sha256_hash_t ctx, ctx1;
-    sha256(&ctx, buf64, 64);
-    sha256(&ctx1, ctx.bytes, 32);
-    memcpy(dest, ctx1.bytes, 32);
-}
-
-static void calculateMerkleRoot(uint8_t *root, uint8_t *coinbaseHash, const stratum_job_t *job) {
-    uint8_t merklePair[64];
-    memcpy(merklePair, coinbaseHash, 32);
-
-    for (int i = 0; i < job->merkleBranchCount; i++) {
-        hexToBytes(&merklePair[32], job->merkleBranches[i], 64);
-        // NerdMiner does NOT reverse merkle branches
-
-        double_sha256_merkle(merklePair, merklePair);
-        // NerdMiner does NOT reverse intermediate merkle results
+// Only called for hashes at or below the best tier's leading bits, so the
+// floating-point difficulty is computed once per improvement, not per candidate
+static void compareBestDifficulty(sha256_hash_t *ctx, uint64_t hashLead) {
+    double difficulty = getDifficulty(ctx);
+    if (!isnan(difficulty) && !isinf(difficulty) &&
+        (isnan(s_stats.bestDifficulty) || isinf(s_stats.bestDifficulty) ||
+         difficulty >= s_stats.bestDifficulty)) {
+        s_stats.bestDifficulty = difficulty;
+        s_bestLead = hashLead;
     }
-    memcpy(root, merklePair, 32);
-}
-
-static void createCoinbaseHash(uint8_t *hash, const stratum_job_t *job) {
-    uint8_t coinbase[512];
-    size_t cbLen = 0;
-
-    // Coinbase1 (now char array)
-    size_t cb1Len = strlen(job->coinBase1);
-    hexToBytes(coinbase, job->coinBase1, cb1Len);
-    cbLen += cb1Len / 2;
-
-    // ExtraNonce1 (from job struct now)
-    size_t en1Len = strlen(job->extraNonce1);
-    hexToBytes(&coinbase[cbLen], job->extraNonce1, en1Len);
-    cbLen += en1Len / 2;
-
-    // ExtraNonce2
-    char en2Hex[17];
-    encodeExtraNonce(en2Hex, s_extraNonce2Size, s_extraNonce2);
-    hexToBytes(&coinbase[cbLen], en2Hex, s_extraNonce2Size * 2);
-    cbLen += s_extraNonce2Size;
-
-    // Coinbase2 (now char array)
-    size_t cb2Len = strlen(job->coinBase2);
-    hexToBytes(&coinbase[cbLen], job->coinBase2, cb2Len);
-    cbLen += cb2Len / 2;
-
-    // Double SHA256
-    sha256_hash_t ctx, ctx1;
-    sha256(&ctx, coinbase, cbLen);
-    sha256(&ctx1, ctx.bytes, 32);
-    memcpy(hash, ctx1.bytes, 32);
-    // NerdMiner does NOT reverse coinbase hash
 }
 
 // ============================================================
-// Difficulty Calculation
+// Candidate Ring
 // ============================================================
 
-static double getDifficulty(sha256_hash_t *ctx) {
-    static const double maxTarget = 26959535291011309493156476344723991336010898738574164086137773096960.0;
-    double hashValue = 0.0;
-    for (int i = 0, j = 31; i < 32; i++, j--) {
-        hashValue = hashValue * 256 + ctx->bytes[j];
+// Queue a 16-bit candidate for verification and wake the verify task.
+// Called from the mining loops; never blocks, a full ring drops the candidate.
+static void pushCandidate(uint32_t minerId, const miner_job_t *job, uint32_t nonce) {
+    miner_candidate_ring_t *ring = &s_candidates[minerId];
+    uint32_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= CANDIDATE_RING_SIZE) {
+        ring->drops++;
+        return;
     }
-    double difficulty = maxTarget / hashValue;
-    if (isnan(difficulty) || isinf(difficulty)) {
-        difficulty = 0.0;
+
+    miner_candidate_t *cand = &ring->entries[head & (CANDIDATE_RING_SIZE - 1)];
+    memcpy(&cand->header, &job->header, sizeof(block_header_t));
+    cand->header.nonce = nonce;
+    memcpy(cand->jobId, job->jobId, sizeof(cand->jobId));
+    memcpy(cand->extraNonce2, job->extraNonce2, sizeof(cand->extraNonce2));
+    cand->versionMask = job->versionMask;
+
+    // Entry contents must be visible before the new head
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+    TRACE_POINT(TRACE_CANDIDATE, nonce);
+
+    if (s_verifyTask) {
+        xTaskNotifyGive(s_verifyTask);
     }
-    return difficulty;
 }
 
-static void compareBestDifficulty(sha256_hash_t *ctx) {
-    double difficulty = getDifficulty(ctx);
-    if (!isnan(difficulty) && !isinf(difficulty) &&
-        (isnan(s_stats.bestDifficulty) || isinf(s_stats.bestDifficulty) ||
-         difficulty >= s_stats.bestDifficulty)) {
-        s_stats.bestDifficulty = difficulty;
+// Take the oldest candidate off a ring (verify task only)
+static bool popCandidate(miner_candidate_ring_t *ring, miner_candidate_t *out) {
+    uint32_t tail = ring->tail;
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return false;
     }
+    memcpy(out, &ring->entries[tail & (CANDIDATE_RING_SIZE - 1)], sizeof(miner_candidate_t));
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
 }
 
 // ============================================================
 // Share Validation & Submission
 // ============================================================
 
-static void hashCheck(const char *jobId, sha256_hash_t *ctx, uint32_t timestamp, uint32_t nonce) {
+static void hashCheck(const miner_candidate_t *cand, sha256_hash_t *ctx) {
+    const block_header_t *hb = &cand->header;
+    uint64_t hashLead = leadingBits(ctx->bytes);
+
+    // Best-difficulty tier: ties fall through to the exact double compare
+    bool bestHit = hashLead <= s_bestLead;
+
+    // Pool tier (the target is copied only for a tie on the leading bits)
+    uint8_t poolTarget[32];
+    portENTER_CRITICAL(&s_targetLock);
+    uint64_t poolLead = s_poolLead;
+    bool poolTie = hashLead == poolLead;
+    if (poolTie) memcpy(poolTarget, s_poolTarget, 32);
+    portEXIT_CRITICAL(&s_targetLock);
+    bool poolHit = poolTie ? check_target(ctx->bytes, poolTarget) : hashLead < poolLead;
+
     // Compare against pool target
-    if (check_target(ctx->bytes, s_poolTarget)) {
+    if (poolHit) {
         uint32_t flags = 0;
 
         // Check for 32-bit difficulty
@@ -299,32 +323,36 @@ static void hashCheck(const char *jobId, sha256_hash_t *ctx, uint32_t timestamp,
         }
 
         // Check against block target (lottery win!)
-        if (check_target(ctx->bytes, s_blockTarget)) {
+        setBlockTarget(hb->difficulty);
+        if (tierCompare(hashLead, s_blockLead, ctx, s_blockTarget)) {
             Serial.println("[MINER] *** BLOCK SOLUTION FOUND! ***");
             flags |= SUBMIT_FLAG_BLOCK;
             s_stats.blocks++;
         }
 
         double shareDiff = getDifficulty(ctx);
-        Serial.printf("[MINER] Share found! Diff: %.4f (pool: %.4f) Nonce: %08x\n", shareDiff, s_poolDifficulty, nonce);
+        Serial.printf("[MINER] Share found! Diff: %.4f (pool: %.4f) Nonce: %08x\n", shareDiff, s_poolDifficulty, hb->nonce);
 
         // Debug logging for share validation (Issue #5 investigation)
         #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(DEBUG_SHARE_VALIDATION)
-        Serial.printf("[SHARE] job=%s time=%08x nonce=%08x\n", jobId, timestamp, nonce);
+        Serial.printf("[SHARE] job=%s time=%08x nonce=%08x\n", cand->jobId, hb->timestamp, hb->nonce);
         Serial.printf("[SHARE] hash[28-31]=%02x%02x%02x%02x (should have leading zeros)\n",
                       ctx->bytes[28], ctx->bytes[29], ctx->bytes[30], ctx->bytes[31]);
-        char en2Hex[17];
-        encodeExtraNonce(en2Hex, s_extraNonce2Size, s_extraNonce2);
-        Serial.printf("[SHARE] extraNonce2=%s\n", en2Hex);
+        Serial.printf("[SHARE] extraNonce2=%s\n", cand->extraNonce2);
         #endif
 
         // Submit share
         submit_entry_t submission;
         memset(&submission, 0, sizeof(submission));
-        strncpy(submission.jobId, jobId, MAX_JOB_ID_LEN - 1);
-        encodeExtraNonce(submission.extraNonce2, s_extraNonce2Size, s_extraNonce2);
-        submission.timestamp = timestamp;
-        submission.nonce = nonce;
+        strncpy(submission.jobId, cand->jobId, MAX_JOB_ID_LEN - 1);
+        strncpy(submission.extraNonce2, cand->extraNonce2, sizeof(submission.extraNonce2) - 1);
+        submission.timestamp = hb->timestamp;
+        submission.nonce = hb->nonce;
+        submission.version = hb->version;
+        if (cand->versionMask) {
+            submission.versionBits = hb->version & cand->versionMask;
+            flags |= SUBMIT_FLAG_VERSION;
+        }
         submission.flags = flags;
         submission.difficulty = shareDiff;
 
@@ -333,137 +361,445 @@ static void hashCheck(const char *jobId, sha256_hash_t *ctx, uint32_t timestamp,
     }
 
     // Always track best difficulty for stats
-    compareBestDifficulty(ctx);
+    if (bestHit) {
+        compareBestDifficulty(ctx, hashLead);
+    }
 }
 
 // ============================================================
-// Public API
+// Job Handoff
 // ============================================================
 
-#ifdef BENCHMARK_SHA_VERSIONS
-void run_sha_benchmark() {
-    Serial.println("[BENCHMARK] Starting SHA-256 version benchmark...");
-    volatile uint32_t *sha_base = (volatile uint32_t *)0x3FF03000;
-    uint32_t header[20] = {0}; // Dummy header
-    uint32_t midstate[8] = {0};
-    uint32_t tail[3] = {0};
-    uint32_t nonce = 0;
-    uint64_t hashes = 0;
-    bool active = true;
+// Copy the current job slot into a core-local buffer.
+// Called with the core's run flag already set, so a publish that races with
+// this copy always clears the flag and sends the core around again.
+static uint32_t loadJob(miner_job_t *job) {
+    uint32_t seq;
+    do {
+        seq = __atomic_load_n(&s_jobSeq, __ATOMIC_ACQUIRE);
+        memcpy(job, &s_jobSlots[seq & 1], sizeof(miner_job_t));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while (seq != __atomic_load_n(&s_jobSeq, __ATOMIC_RELAXED));
+
+    // Publish-to-pickup latency. The slower core writes last, so lastSwitchUs
+    // ends up as the time until both cores were on the new job.
+    uint32_t switchUs = micros() - job->publishTime;
+    if (!s_stats.firstHashMs) {
+        s_stats.firstHashMs = millis();
+    }
+    s_stats.lastSwitchUs = switchUs;
+    if (switchUs > s_stats.maxSwitchUs) {
+        s_stats.maxSwitchUs = switchUs;
+    }
+    return seq;
+}
 
-    // Prep v4 data
-    sha256_compute_midstate_v4(midstate, header);
-    tail[0] = header[16]; tail[1] = header[17]; tail[2] = header[18];
+// True while this core should keep hashing its current job copy
+static inline bool keepMining(uint32_t minerId) {
+    return s_miningActive && s_coreRun[minerId];
+}
 
-    Serial.println("[BENCHMARK] Running v3 (100k hashes)...");
-    uint32_t t0 = micros();
-    hashes = 0;
-    active = true;
-    while(hashes < 100000) {
-        sha256_pipelined_mine_v3(sha_base, header, &nonce, &hashes, &active);
-    }
-    uint32_t t1 = micros();
-    Serial.printf("[BENCHMARK] v3: %u us for %llu hashes (%.2f kH/s)\n", 
-        t1-t0, hashes, (double)hashes*1000.0/(t1-t0));
-
-    Serial.println("[BENCHMARK] Running v4 (100k hashes)...");
-    hashes = 0;
-    active = true;
-    t0 = micros();
-    while(hashes < 100000) {
-         sha256_pipelined_mine_v4(sha_base, midstate, tail, &nonce, &hashes, &active);
+// Byte-swap all 20 header words into SHA message-word order for the hardware
+static inline void swapHeader(uint32_t *out, const block_header_t *hb) {
+    const uint32_t *words = (const uint32_t *)hb;
+    for (int i = 0; i < 20; i++) {
+        out[i] = __builtin_bswap32(words[i]);
+    }
+}
+
+// True once a core has used its nonce range (minus the kernel overshoot guard)
+static inline bool rangeExhausted(uint32_t nonce, uint32_t rangeStart, uint32_t rangeSize) {
+    return (uint32_t)(nonce - rangeStart) >= rangeSize - NONCE_ROLL_GUARD;
+}
+
+// ============================================================
+// Hash Counters
+// ============================================================
+
+// Add a core's locally counted hashes to its published slot
+static inline void publishHashes(uint32_t minerId, uint64_t hashes) {
+    s_coreHashes[minerId] += hashes;
+}
+
+// Read a slot from any task. The 64-bit value is two 32-bit stores on
+// Xtensa, so re-read until a torn carry can't have slipped in between.
+static uint64_t readHashes(uint32_t minerId) {
+    uint64_t a, b;
+    do {
+        a = s_coreHashes[minerId];
+        b = s_coreHashes[minerId];
+    } while (a != b);
+    return a;
+}
+
+// ============================================================
+// Yield Scheduling
+// ============================================================
+
+typedef enum {
+    YIELD_BUSY = 0,     // Something asked for CPU within YIELD_BUSY_MS
+    YIELD_NORMAL,
+    YIELD_IDLE          // Quiet for longer than YIELD_IDLE_MS
+} yield_level_t;
+
+// Per-level yield intervals: Core 0 in hashes, Core 1 in kernel returns
+static const uint32_t s_yieldEvery[2][3] = {
+    { CORE_0_YIELD_MIN, CORE_0_YIELD_COUNT, CORE_0_YIELD_MAX },
+    { CORE_1_YIELD_MIN, CORE_1_YIELD_COUNT, CORE_1_YIELD_MAX }
+};
+
+// Pick this core's next yield interval from recent demand.
+// Evaluated once per yield, so a hint takes effect after the current interval.
+static uint32_t yieldInterval(uint32_t minerId) {
+    uint32_t quiet = millis() - s_lastDemandMs;
+    yield_level_t level = YIELD_NORMAL;
+    if (quiet < YIELD_BUSY_MS) {
+        level = YIELD_BUSY;
+    } else if (quiet > YIELD_IDLE_MS) {
+        level = YIELD_IDLE;
+    }
+    uint32_t interval = s_yieldEvery[minerId][level];
+    s_stats.yieldInterval[minerId] = interval;
+    return interval;
+}
+
+// Give up the CPU for one tick and account the hashing time lost
+static void yieldCore(uint32_t minerId) {
+    uint32_t start = micros();
+    vTaskDelay(1);  // Must use vTaskDelay(1), not taskYIELD()
+    s_stats.yieldUs[minerId] += micros() - start;
+}
+
+// ============================================================
+// Extranonce2 Rolling
+// ============================================================
+
+// Build the merkle root for the job's next unused extranonce2.
+// Returns false if the job was replaced while building (result is stale).
+static bool buildRoll(miner_roll_t *roll, uint32_t jobSeq) {
+    const miner_coinbase_t *cb = &s_coinbase[jobSeq & 1];
+    uint8_t coinbaseHash[32];
+
+    roll->jobSeq = jobSeq;
+    roll->extraNonce2 = cb->extraNonce2Base + __atomic_add_fetch(&s_rollCounter, 1, __ATOMIC_RELAXED);
+    createCoinbaseHash(coinbaseHash, cb, roll->extraNonce2);
+    calculateMerkleRoot(roll->merkleRoot, coinbaseHash, cb);
+
+    return __atomic_load_n(&s_jobSeq, __ATOMIC_ACQUIRE) == jobSeq;
+}
+
+// Core 0 background work: keep one roll ready for the current job
+static void prepareRoll(uint32_t jobSeq) {
+    portENTER_CRITICAL(&s_rollLock);
+    bool haveRoll = s_rollReadyValid && s_rollReady.jobSeq == jobSeq;
+    portEXIT_CRITICAL(&s_rollLock);
+    if (haveRoll) return;
+
+    miner_roll_t roll;
+    if (!buildRoll(&roll, jobSeq)) return;
+
+    portENTER_CRITICAL(&s_rollLock);
+    s_rollReady = roll;
+    s_rollReadyValid = true;
+    portEXIT_CRITICAL(&s_rollLock);
+}
+
+// Move a core's job copy onto a fresh extranonce2 once its nonce range runs out.
+// Takes Core 0's prepared roll when there is one, otherwise builds it inline.
+static void rollExtraNonce(miner_job_t *job, uint32_t jobSeq) {
+    miner_roll_t roll;
+    bool ready = false;
+
+    portENTER_CRITICAL(&s_rollLock);
+    if (s_rollReadyValid && s_rollReady.jobSeq == jobSeq) {
+        roll = s_rollReady;
+        s_rollReadyValid = false;
+        ready = true;
+    }
+    portEXIT_CRITICAL(&s_rollLock);
+
+    if (!ready) {
+        // Job replaced while building - the core is about to reload anyway
+        if (!buildRoll(&roll, jobSeq)) return;
+        s_stats.rollStalls++;
+    }
+
+    memcpy(job->header.merkle_root, roll.merkleRoot, 32);
+    encodeExtraNonce(job->extraNonce2, s_coinbase[jobSeq & 1].extraNonce2Size, roll.extraNonce2);
+    s_stats.extraNonceRolls++;
+
+    dbg("[MINER] Nonce range used up, rolled to en2=%s (%s)\n",
+        job->extraNonce2, ready ? "prepared" : "inline");
+}
+
+// Spread the low bits of n across the set bits of mask (software PDEP)
+static uint32_t depositBits(uint32_t n, uint32_t mask) {
+    uint32_t out = 0;
+    while (mask && n) {
+        uint32_t lowest = mask & (0 - mask);
+        if (n & 1) out |= lowest;
+        n >>= 1;
+        mask &= mask - 1;
     }
-    t1 = micros();
-    Serial.printf("[BENCHMARK] v4: %u us for %llu hashes (%.2f kH/s)\n", 
-        t1-t0, hashes, (double)hashes*1000.0/(t1-t0));
+    return out;
 }
+
+// Move a core's job copy onto an unused version within the pool's rolling
+// mask. Only the version word changes, so no coinbase or merkle work.
+// Returns false when rolling is off or the job's version space is used up.
+static bool rollVersion(miner_job_t *job) {
+    if (!job->versionMask) return false;
+
+    int bits = __builtin_popcount(job->versionMask);
+    uint32_t n = __atomic_add_fetch(&s_versionCounter, 1, __ATOMIC_RELAXED);
+    if (bits < 32 && n >= (1u << bits)) return false;
+
+    // XOR keeps offset 0 == the pool's version and every offset distinct
+    job->header.version = job->jobVersion ^ depositBits(n, job->versionMask);
+    s_stats.versionRolls++;
+
+    dbg("[MINER] Nonce range used up, rolled to version=%08x\n", job->header.version);
+    return true;
+}
+
+// Move a core's job copy onto an unused ntime. The timestamp lives in block 2,
+// so the cached midstates stay valid. Returns false when the next ntime would
+// run further ahead of real time than NTIME_ROLL_AHEAD allows.
+static bool rollNtime(miner_job_t *job) {
+    uint32_t allowed = (millis() - job->publishMs) / 1000 + NTIME_ROLL_AHEAD;
+    uint32_t n = __atomic_load_n(&s_ntimeCounter, __ATOMIC_RELAXED);
+    do {
+        if (n >= allowed) return false;
+    } while (!__atomic_compare_exchange_n(&s_ntimeCounter, &n, n + 1, true,
+                                          __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    job->header.timestamp = job->jobNtime + n + 1;
+    s_stats.ntimeRolls++;
+
+    dbg("[MINER] Nonce range used up, rolled to ntime=%08x\n", job->header.timestamp);
+    return true;
+}
+
+// Give a core fresh work once its nonce range runs out, cheapest first:
+// ntime (block 2 only), version bits (midstate recompute), then extranonce2.
+// Every roll takes a value no other range has used, so the new range is
+// exclusive to the calling core. Header-only jobs stop at version bits; the
+// ntime allowance grows by a second per second, far faster than a core
+// spends a range, so in practice they never run dry.
+// Returns true if block 1 changed and the midstate must be recomputed.
+static bool rollNonceRange(miner_job_t *job, uint32_t jobSeq) {
+    if (rollNtime(job)) return false;
+    if (!rollVersion(job) && !job->headerOnly) {
+        rollExtraNonce(job, jobSeq);
+    }
+    return true;
+}
+
+// ============================================================
+// Job Build Hashing
+// ============================================================
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+// Job builder: kick Core 1 out of its kernel and take the peripheral.
+// The kernel checks its run flag every nonce, so the wait is one kernel exit.
+static void claimSha() {
+    s_shaWanted = true;
+    s_coreRun[1] = false;
+    esp_sha_acquire_hardware();
+}
+
+// Job builder: let Core 1 back on once the job it parked for is published
+static void unparkCore1() {
+    if (!s_shaWanted) return;
+    s_shaWanted = false;
+    if (s_core1Task) xTaskNotifyGive(s_core1Task);
+}
+
+// Core 1: take the peripheral, letting a job build that wants it go first.
+// Re-checked after acquiring: a build that started meanwhile is queued on the
+// lock, so hand it straight over instead of preparing a job about to be replaced.
+static void acquireCore1Sha() {
+    while (true) {
+        while (s_shaWanted) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(10));
+        }
+        esp_sha_acquire_hardware();
+        if (!s_shaWanted) return;
+        esp_sha_release_hardware();
+    }
+}
+#endif
+
+// Coinbase hash and merkle root of a new job. On the S3 both run on the
+// SHA DMA engine; everything before this (hex decoding, padding) overlaps
+// with Core 1 still hashing the previous job.
+static void hashJob(uint8_t *merkleRoot, miner_coinbase_t *cb, uint32_t extraNonce2) {
+    uint8_t coinbaseHash[32];
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    size_t paddedLen = s_dmaJobs ? padCoinbase(cb, extraNonce2) : 0;
+    if (paddedLen) {
+        claimSha();
+        bool ok = sha256_s3_dma_double(coinbaseHash, cb->coinbase, paddedLen) &&
+                  sha256_s3_dma_merkle_root(merkleRoot, coinbaseHash, cb->branches, cb->branchCount);
+        esp_sha_release_hardware();
+        if (ok) return;
+        // Core 1 stays parked until the publish either way
+    }
 #endif
 
+    createCoinbaseHash(coinbaseHash, cb, extraNonce2);
+    calculateMerkleRoot(merkleRoot, coinbaseHash, cb);
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
 void miner_init() {
-    s_jobMutex = xSemaphoreCreateMutex();
     s_shaMutex = xSemaphoreCreateMutex();  // For dual-core hardware SHA sharing
     s_stats.startTime = millis();
+    mem_budget_add("miner", "job slots", sizeof(s_jobSlots) + sizeof(s_coinbase));
+    mem_budget_add("miner", "candidate rings", sizeof(s_candidates));
+    mem_budget_add("miner", "engine jobs", sizeof(s_engineJobs));
 
     // Initialize hardware SHA-256 peripheral
     sha256_hw_init();
 
-    // Run DMA-based SHA test at startup
-    sha256_s3_dma_test();
-
     Serial.println("[MINER] Initialized (Hardware SHA-256 via direct register access)");
     Serial.println("[MINER] Dual-core hardware SHA sharing enabled");
-
-#ifdef BENCHMARK_SHA_VERSIONS
-    run_sha_benchmark();
-#endif
 }
 
-void miner_start_job(const stratum_job_t *job) {
-    if (!job) return;
+// Build a complete job slot and its coinbase from a decoded mining.notify,
+// or just the header for a header-only (Stratum V2) job
+static void buildJob(miner_job_t *slot, miner_coinbase_t *cb, const mining_job_bin_t *job) {
+    block_header_t *header = &slot->header;
+
+    // Build block header (fields were decoded by the stratum parser)
+    header->version = job->version;
+    slot->jobVersion = header->version;
+    slot->versionMask = s_versionMask;
+    slot->headerOnly = job->headerOnly;
+    memcpy(header->prev_hash, job->prevHash, 32);
+
+    if (job->headerOnly) {
+        // Merkle root comes from the pool - no coinbase or merkle hashing
+        slot->extraNonce2[0] = '\0';
+        memcpy(header->merkle_root, job->merkleRoot, 32);
+    } else {
+        // Random ExtraNonce2 - rolled ranges count up from here
+        uint32_t extraNonce2 = esp_random();
+        encodeExtraNonce(slot->extraNonce2, job->extraNonce2Size, extraNonce2);
 
-    // Wait for any active mining to stop
-    s_miningActive = false;
-    while (s_core0Mining || s_core1Mining) {
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+        // Create coinbase hash and merkle root
+        buildCoinbase(cb, job, extraNonce2);
+        hashJob(header->merkle_root, cb, extraNonce2);
     }
 
-    xSemaphoreTake(s_jobMutex, portMAX_DELAY);
-
-    // Random ExtraNonce2
-    s_extraNonce2 = esp_random();
+    header->timestamp = job->ntime;
+    slot->jobNtime = header->timestamp;
+    header->difficulty = job->nbits;
+    header->nonce = 0;
 
-    // Build block header (using char arrays now - no heap allocation)
-    s_pendingBlock.version = strtoul(job->version, NULL, 16);
-    hexToBytes(s_pendingBlock.prev_hash, job->prevHash, 64);
-    swapBytesInWords(s_pendingBlock.prev_hash, 32); // Swap bytes within each 4-byte word (NerdMiner does this)
+    memset(slot->jobId, 0, sizeof(slot->jobId));
+    strncpy(slot->jobId, job->jobId, MAX_JOB_ID_LEN - 1);
 
-    // Create coinbase hash and merkle root
-    uint8_t coinbaseHash[32];
-    createCoinbaseHash(coinbaseHash, job);
-
-    calculateMerkleRoot(s_pendingBlock.merkle_root, coinbaseHash, job);
+    // Random nonce start points for each core
+    slot->startNonce[0] = esp_random();
+    slot->startNonce[1] = slot->startNonce[0] + NONCE_RANGE_SPLIT;
+}
 
-    s_pendingBlock.timestamp = strtoul(job->ntime, NULL, 16);
-    s_pendingBlock.difficulty = strtoul(job->nbits, NULL, 16);
-    s_pendingBlock.nonce = 0;
+void miner_start_job(const mining_job_bin_t *job) {
+    if (!job) return;
 
-    strncpy(s_currentJobId, job->jobId, MAX_JOB_ID_LEN - 1);
+    uint32_t buildStart = micros();
+    TRACE_POINT(TRACE_JOB_START, 0);
 
-    // Debug: print header bytes
-    char en2Hex[17];
-    encodeExtraNonce(en2Hex, s_extraNonce2Size, s_extraNonce2);
-    Serial.printf("[MINER] New job: %s, diff=%08x\n", s_currentJobId, s_pendingBlock.difficulty);
-    Serial.printf("[MINER] en2=%s, ntime=%s, version=%s\n", en2Hex, job->ntime, job->version);
-    Serial.printf("[MINER] Header bytes 0-7: %02x%02x%02x%02x %02x%02x%02x%02x\n",
-        ((uint8_t*)&s_pendingBlock)[0], ((uint8_t*)&s_pendingBlock)[1],
-        ((uint8_t*)&s_pendingBlock)[2], ((uint8_t*)&s_pendingBlock)[3],
-        ((uint8_t*)&s_pendingBlock)[4], ((uint8_t*)&s_pendingBlock)[5],
-        ((uint8_t*)&s_pendingBlock)[6], ((uint8_t*)&s_pendingBlock)[7]);
+    // Build into the slot the cores are not reading. The stratum task is the
+    // only publisher, so nothing else can touch the inactive slot.
+    uint32_t seq = __atomic_load_n(&s_jobSeq, __ATOMIC_RELAXED);
+    miner_job_t *slot = &s_jobSlots[(seq + 1) & 1];
+    buildJob(slot, &s_coinbase[(seq + 1) & 1], job);
+    block_header_t *header = &slot->header;
+    TRACE_POINT(TRACE_JOB_HASHED, 0);
 
-    // Set block target
-    bits_to_target(s_pendingBlock.difficulty, s_blockTarget);
     setPoolTarget();
 
-    // Random nonce start points for each core
-    s_startNonce[0] = esp_random();
-    s_startNonce[1] = s_startNonce[0] + 0x80000000;
-
     s_stats.templates++;
+    s_stats.lastBuildUs = micros() - buildStart;
+    if (!s_stats.firstJobMs) {
+        s_stats.firstJobMs = millis();
+    }
 
-    xSemaphoreGive(s_jobMutex);
+    // Publish: slot contents must be visible before the new sequence number
+    s_rollCounter = 0;
+    s_versionCounter = 0;
+    s_ntimeCounter = 0;
+    slot->publishTime = micros();
+    slot->publishMs = millis();
+    __atomic_store_n(&s_jobSeq, seq + 1, __ATOMIC_RELEASE);
+    TRACE_POINT(TRACE_JOB_PUBLISHED, 0);
+
+    // Kick both cores out of their kernels - they reload at the next return
+    s_coreRun[0] = false;
+    s_coreRun[1] = false;
+    portENTER_CRITICAL(&s_benchLock);
+    if (s_benchActive) {
+        s_benchResume = true;  // Picked up when the benchmark hands the cores back
+    } else {
+        s_miningActive = true;
+    }
+    portEXIT_CRITICAL(&s_benchLock);
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    // Core 1 was parked for the DMA hashing - it picks up the new slot now
+    unparkCore1();
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    // DMA self-test once the first job is out, so it doesn't hold up the
+    // first hash. Core 1 parks for it like for a job build; until it
+    // passes, builds use software SHA.
+    if (!s_dmaTested) {
+        s_dmaTested = true;
+        s_shaWanted = true;
+        s_coreRun[1] = false;
+        s_dmaJobs = sha256_s3_dma_init();
+        unparkCore1();
+    }
+#endif
 
-    s_miningActive = true;
+    // Debug: print header bytes (after the publish, the UART is slow)
+    Serial.printf("[MINER] New job: %s, diff=%08x\n", slot->jobId, header->difficulty);
+    Serial.printf("[MINER] en2=%s, ntime=%08x, version=%08x\n", slot->extraNonce2, job->ntime, job->version);
+    Serial.printf("[MINER] Header bytes 0-7: %02x%02x%02x%02x %02x%02x%02x%02x\n",
+        ((uint8_t*)header)[0], ((uint8_t*)header)[1],
+        ((uint8_t*)header)[2], ((uint8_t*)header)[3],
+        ((uint8_t*)header)[4], ((uint8_t*)header)[5],
+        ((uint8_t*)header)[6], ((uint8_t*)header)[7]);
 }
 
 void miner_stop() {
     s_miningActive = false;
+    s_benchResume = false;
+    s_coreRun[0] = false;
+    s_coreRun[1] = false;
 }
 
 bool miner_is_running() {
     return s_miningActive;
 }
 
+const char *miner_get_kernel_name(uint8_t slot) {
+    if (slot == 0) return "sw";
+    return (slot == 1) ? s_hwKernelName : NULL;
+}
+
 mining_stats_t *miner_get_stats() {
+    s_stats.coreHashes[0] = readHashes(0);
+    s_stats.coreHashes[1] = readHashes(1);
+    s_stats.hashes = s_stats.coreHashes[0] + s_stats.coreHashes[1];
+    s_stats.candidateDrops = s_candidates[0].drops + s_candidates[1].drops;
     return &s_stats;
 }
 
@@ -479,6 +815,17 @@ double miner_get_difficulty() {
     return s_poolDifficulty;
 }
 
+void miner_set_version_mask(uint32_t mask) {
+    s_versionMask = mask;
+    if (mask) {
+        Serial.printf("[MINER] Version rolling enabled, mask=%08x\n", mask);
+    }
+}
+
+void miner_yield_hint() {
+    s_lastDemandMs = millis();
+}
+
 void miner_set_extranonce(const char *extraNonce1, int extraNonce2Size) {
     strncpy(s_extraNonce1, extraNonce1, sizeof(s_extraNonce1) - 1);
     s_extraNonce2Size = extraNonce2Size > 8 ? 8 : extraNonce2Size;
@@ -490,12 +837,13 @@ void miner_set_extranonce(const char *extraNonce1, int extraNonce2Size) {
 
 void miner_task_core0(void *param) {
     block_header_t hb;
-    sha256_hash_t ctx;
     sha256_hash_t sw_midstate;  // Software midstate for fallback
+    miner_sha256_bake_t bake;   // Per-job nonce-independent SHA work
     uint32_t hw_midstate[8];    // Hardware midstate for opportunistic HW SHA
-    char jobId[MAX_JOB_ID_LEN];
+    miner_job_t job;
     uint32_t minerId = 0;
     uint32_t yieldCounter = 0;
+    uint32_t yieldEvery = CORE_0_YIELD_COUNT;  // Set by the yield scheduler after each yield
     uint32_t hwHashes = 0;  // Track hardware SHA usage
     uint32_t swHashes = 0;  // Track software SHA usage
 
@@ -504,7 +852,7 @@ void miner_task_core0(void *param) {
 
     // Wait for first job
     while (!s_miningActive) {
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        vTaskDelay(10 / portTICK_PERIOD_MS);
     }
     Serial.println("[MINER0] Got first job, starting hybrid mining (HW when Core 1 yields)");
 
@@ -517,22 +865,24 @@ void miner_task_core0(void *param) {
 
         s_core0Mining = true;
 
-        // Copy job data under mutex
-        xSemaphoreTake(s_jobMutex, portMAX_DELAY);
-        memcpy(&hb, &s_pendingBlock, sizeof(block_header_t));
-        strncpy(jobId, s_currentJobId, MAX_JOB_ID_LEN);
-        hb.nonce = s_startNonce[minerId];
-        xSemaphoreGive(s_jobMutex);
+        // Pick up the latest published job (run flag first, see loadJob)
+        s_coreRun[minerId] = true;
+        uint32_t jobSeq = loadJob(&job);
+        TRACE_POINT(TRACE_JOB_PICKUP, minerId);
+        memcpy(&hb, &job.header, sizeof(block_header_t));
+
+        // Nonce counter in SHA word order, same as the hardware kernels
+        uint32_t nonce = job.startNonce[minerId];
+        uint32_t rangeStart = nonce;
+        uint32_t rangeSize = NONCE_RANGE_SPLIT;
 
         // Always compute SOFTWARE midstate (for fallback and verification)
         miner_sha256_midstate(&sw_midstate, &hb);
+        miner_sha256_bake(&bake, &sw_midstate, &hb);
 
         // Prepare byte-swapped header for hardware SHA
         uint32_t header_swapped[20];
-        uint32_t *header_words = (uint32_t *)&hb;
-        for (int i = 0; i < 20; i++) {
-            header_swapped[i] = __builtin_bswap32(header_words[i]);
-        }
+        swapHeader(header_swapped, &hb);
 
         // Try to compute hardware midstate if we can grab the mutex
         bool hasHwMidstate = false;
@@ -544,427 +894,654 @@ void miner_task_core0(void *param) {
             hasHwMidstate = true;
         }
 
-        while (s_miningActive) {
+        TRACE_POINT(TRACE_HASHING, minerId);
+        while (keepMining(minerId)) {
             // Pure software SHA - no hardware contention with Core 1
-            if (miner_sha256_header(&sw_midstate, &ctx, &hb)) {
-                hashCheck(jobId, &ctx, hb.timestamp, hb.nonce);
+            // One batch call, bookkeeping paid once per CORE_0_BATCH_SIZE nonces
+            // Candidates go to the verify task, which computes the full digest
+            uint32_t hits = miner_sha256_header_batch(&bake, nonce, CORE_0_BATCH_SIZE);
+            while (hits) {
+                uint32_t candidate = nonce + __builtin_ctz(hits);
+                hits &= hits - 1;
+                pushCandidate(minerId, &job, __builtin_bswap32(candidate));
             }
-            hb.nonce++;
-            s_stats.hashes++;
-            s_core0Hashes++;  // DEBUG: Track Core 0 contribution
-            yieldCounter++;
+            nonce += CORE_0_BATCH_SIZE;
+            yieldCounter += CORE_0_BATCH_SIZE;
 
-            // Yield every 256 hashes to let monitor/WiFi tasks run
-            if (yieldCounter >= CORE_0_YIELD_COUNT) {
+            // Yield to let monitor/WiFi tasks run (interval follows their demand)
+            if (yieldCounter >= yieldEvery) {
+                // yieldCounter doubles as the hash count since the last publish
+                publishHashes(minerId, yieldCounter);
                 yieldCounter = 0;
-                vTaskDelay(1);  // Must use vTaskDelay(1), not taskYIELD()
+
+                // Own range used up: move to a fresh ntime, version bits or extranonce2
+                if (rangeExhausted(nonce, rangeStart, rangeSize)) {
+                    bool newMidstate = rollNonceRange(&job, jobSeq);
+                    memcpy(&hb, &job.header, sizeof(block_header_t));
+                    if (newMidstate) {
+                        miner_sha256_midstate(&sw_midstate, &hb);
+                    }
+                    // ntime lives in block 2, so re-bake on every roll
+                    miner_sha256_bake(&bake, &sw_midstate, &hb);
+                    rangeStart = nonce;
+                    rangeSize = NONCE_RANGE_FULL;
+                }
+
+                // Keep the next extranonce2 roll ready for whichever core runs out
+                // (with version rolling the version space lasts far longer)
+                if (!job.versionMask && !job.headerOnly) {
+                    prepareRoll(jobSeq);
+                }
+
+                yieldCore(minerId);
+                yieldEvery = yieldInterval(minerId);
             }
         }
+        publishHashes(minerId, yieldCounter);
+        yieldCounter = 0;
+        // Fall through to reload: either a new job was published or mining stopped
+    }
+}
+
+// ============================================================
+// Verify Task - Core 0 (share verification and submission)
+// ============================================================
+
+void miner_task_verify(void *param) {
+    miner_candidate_t cand;
+    sha256_hash_t midstate;
+    sha256_hash_t ctx;
+
+    s_verifyTask = xTaskGetCurrentTaskHandle();
+    Serial.printf("[VERIFY] Started on core %d (priority %d)\n",
+                  xPortGetCoreID(), uxTaskPriorityGet(NULL));
+
+    while (true) {
+        // Woken by pushCandidate(); the count is only a wakeup, the rings say how many
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        for (uint32_t minerId = 0; minerId < 2; minerId++) {
+            while (popCandidate(&s_candidates[minerId], &cand)) {
+                // BitsyMiner CRITICAL pattern: verify with SOFTWARE SHA on the
+                // UNSWAPPED header - this is what the pool computes
+                miner_sha256_midstate(&midstate, &cand.header);
+                bool swVerified = miner_sha256_header(&midstate, &ctx, &cand.header);
+                TRACE_POINT(TRACE_VERIFIED, cand.header.nonce);
+
+                // Debug logging for S3 share validation investigation (Issue #5)
+                #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(DEBUG_SHARE_VALIDATION)
+                Serial.printf("[S3-DBG] Candidate core=%u nonce=%08x SW verify=%s hash[28-31]=%02x%02x%02x%02x\n",
+                              minerId, cand.header.nonce, swVerified ? "PASS" : "FAIL",
+                              ctx.bytes[28], ctx.bytes[29], ctx.bytes[30], ctx.bytes[31]);
+                #endif
 
-        s_core0Mining = false;
-        vTaskDelay(20 / portTICK_PERIOD_MS);
+                if (swVerified) {
+                    hashCheck(&cand, &ctx);
+                } else {
+                    s_stats.invalidCandidates++;
+                }
+            }
+        }
     }
 }
 
 // ============================================================
-// Mining Task - Core 1 (Dedicated, high priority, pipelined ASM)
+// Core 1 Engines
 // ============================================================
 
+#if MINER_HAS_HW_KERNELS
+// The kernel picked at boot. Each target owns the SHA peripheral its own way:
+// the ESP32 shares it with Core 0's midstate through s_shaMutex, the S3 lets
+// job builds borrow it for DMA hashing, the C3 takes the IDF lock.
+
+static const miner_kernel_t *s_kernel = NULL;
+static miner_kernel_job_t s_kjob;       // Kernel view of the job (midstate, block 2 template)
+static bool s_kernelOwnsSha = false;
+
+static void kernelClaimSha() {
 #if defined(CONFIG_IDF_TARGET_ESP32)
-// Pipelined assembly mining for standard ESP32 (Xtensa LX6)
-
-// Software double SHA-256 for share verification (matches BitsyMiner pattern)
-// Uses original un-swapped header - mbedtls does its own internal byte-swapping
-// Output format matches ll_read_digest_if: word-wise byte swap, not byte reversal
-static bool IRAM_ATTR verify_share_software(block_header_t *hdr, uint32_t nonce, sha256_hash_t *hash_out) {
-    sha256_hash_t first_hash, second_hash;
-
-    // Set the candidate nonce in the header
-    hdr->nonce = nonce;
-
-    // First SHA-256 of 80-byte header
-    sha256(&first_hash, (const uint8_t *)hdr, 80);
-
-    // Second SHA-256 of first hash (double SHA)
-    sha256(&second_hash, first_hash.bytes, 32);
-
-    // Format output to match ll_read_digest_if:
-    // ESP32 hardware stores hash in reverse word order (H0 at index 7, H7 at index 0)
-    // Each word is byte-swapped from big-endian (SHA output) to little-endian (CPU native)
-    uint32_t *words = (uint32_t *)second_hash.bytes;
-    uint32_t *out = (uint32_t *)hash_out->bytes;
-    // Reverse word order AND byte-swap each word
-    out[7] = __builtin_bswap32(words[0]);  // H0 -> out[7]
-    out[6] = __builtin_bswap32(words[1]);  // H1 -> out[6]
-    out[5] = __builtin_bswap32(words[2]);  // H2 -> out[5]
-    out[4] = __builtin_bswap32(words[3]);  // H3 -> out[4]
-    out[3] = __builtin_bswap32(words[4]);  // H4 -> out[3]
-    out[2] = __builtin_bswap32(words[5]);  // H5 -> out[2]
-    out[1] = __builtin_bswap32(words[6]);  // H6 -> out[1]
-    out[0] = __builtin_bswap32(words[7]);  // H7 -> out[0]
-
-    // Early check matches ll_read_digest_if: check upper bytes of out[7] (which is H0)
-    // For valid share, H0's upper bytes (hash[31], hash[30]) should be zero
-    return (hash_out->bytes[31] == 0 && hash_out->bytes[30] == 0);
+    xSemaphoreTake(s_shaMutex, portMAX_DELAY);
+    s_core1HasSha = true;
+    // Only re-init if SHA was actually disabled
+    if (!(DPORT_REG_READ(DPORT_PERI_CLK_EN_REG) & DPORT_PERI_EN_SHA)) {
+        DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
+        DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
+    }
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    // Waits out a job build hashing on the DMA engine
+    acquireCore1Sha();
+#else
+    esp_sha_acquire_hardware();
+#endif
 }
 
-void miner_task_core1(void *param) {
-    block_header_t hb;
-    block_header_t hbVerify;  // BitsyMiner pattern: keep UNSWAPPED copy for verification
-    sha256_hash_t ctx;
-    sha256_hash_t midstate;
-    char jobId[MAX_JOB_ID_LEN];
-    uint32_t minerId = 1;
-
-    Serial.printf("[MINER1] Started on core %d (PIPELINED ASM v3, priority %d)\n",
-                  xPortGetCoreID(), uxTaskPriorityGet(NULL));
+static void kernelReleaseSha() {
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    s_core1HasSha = false;
+    xSemaphoreGive(s_shaMutex);
+#else
+    esp_sha_release_hardware();
+#endif
+}
 
+static const char *kernelInit() {
+#if defined(CONFIG_IDF_TARGET_ESP32)
     // Enable SHA peripheral clock and clear reset
     DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
     DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+    s_core1Task = xTaskGetCurrentTaskHandle();
+    sha256_pipelined_s3_init();
+#endif
 
-    // Wait for first job
-    while (!s_miningActive) {
-        vTaskDelay(100 / portTICK_PERIOD_MS);
-    }
-    Serial.println("[MINER1] Got first job, starting pipelined mining v3");
+    // Pick the fastest kernel that passes the KAT (cached in NVS after first boot)
+    kernelClaimSha();
+    s_kernel = miner_kernel_select();
+    kernelReleaseSha();
+    return s_kernel ? s_kernel->name : NULL;
+}
 
-    // SHA peripheral base address
-    volatile uint32_t *sha_base = (volatile uint32_t *)0x3FF03000;  // SHA_TEXT_BASE
+static void kernelStart(miner_engine_job_t *job) {
+    if (!s_kernelOwnsSha) {
+        kernelClaimSha();
+        s_kernelOwnsSha = true;
+    }
+    // Midstate, block 2 template (words 16-18; word 19 is the nonce) and
+    // persistent zeros. Redone after a yield: another task may have used
+    // the peripheral meanwhile.
+    miner_kernel_load(s_kernel, &s_kjob, job->header_swapped);
+}
 
-    while (true) {
-        if (!s_miningActive) {
-            s_core1HasSha = false;  // Release SHA indicator when not mining
-            vTaskDelay(100 / portTICK_PERIOD_MS);
-            continue;
-        }
+static uint32_t kernelPoll(miner_engine_job_t *job, miner_engine_result_t *out, uint32_t max,
+                           miner_engine_poll_t *status, volatile bool *run) {
+    // Returns on a 16-bit candidate (~65k hashes), a C3 batch or a cleared flag, with the candidates listed
+    miner_kernel_batch_t batch;
+    batch.nonce = job->nonce;
+    batch.count = 0;
+    batch.max = max < KERNEL_CANDIDATES ? max : KERNEL_CANDIDATES;
+    volatile uint64_t hashes = 0;
+    uint32_t found = s_kernel->mine(&s_kjob, &batch, &hashes, run);
+    job->nonce = batch.nonce;
+    status->hashes = hashes;
+    status->exhausted = rangeExhausted(job->nonce, job->nonceStart, job->nonceCount);
+
+    for (uint32_t i = 0; i < found; i++) {
+        out[i].nonce = __builtin_bswap32(batch.nonces[i]);
+        out[i].version = 0;
+        out[i].tag = job->tag;
+    }
+    return found;
+}
 
-        s_core1Mining = true;
+static void kernelStop() {
+    if (!s_kernelOwnsSha) return;
+    kernelReleaseSha();
+    s_kernelOwnsSha = false;
+}
 
-        // Copy job data
-        xSemaphoreTake(s_jobMutex, portMAX_DELAY);
-        memcpy(&hb, &s_pendingBlock, sizeof(block_header_t));
-        memcpy(&hbVerify, &s_pendingBlock, sizeof(block_header_t));  // Keep UNSWAPPED for verification!
-        strncpy(jobId, s_currentJobId, MAX_JOB_ID_LEN);
-        xSemaphoreGive(s_jobMutex);
+static const miner_engine_t s_builtinEngine = {
+    "kernel", false, kernelInit, kernelStart, kernelPoll, kernelStop
+};
 
-        // BitsyMiner pattern: Compute SOFTWARE midstate on UNSWAPPED header (for verification)
-        miner_sha256_midstate(&midstate, &hbVerify);
+#else
+// ESP32-S2: sequential sha256_ll loop with the midstate computed once per header
 
-        // Create byte-swapped header for hardware SHA (pipelined mining)
-        uint32_t header_swapped[20];
-        uint32_t *header_words = (uint32_t *)&hb;
-        for (int i = 0; i < 20; i++) {
-            header_swapped[i] = __builtin_bswap32(header_words[i]);
-        }
+static uint32_t s_llMidstate[8];
+static bool s_llOwnsSha = false;
 
-        // Set starting nonce (in swapped format for hardware)
-        uint32_t nonce_swapped = __builtin_bswap32(s_startNonce[minerId]);
+static const char *llInit() {
+    return "ll";
+}
 
-        // Acquire SHA mutex and set fast-check flag
-        xSemaphoreTake(s_shaMutex, portMAX_DELAY);
-        s_core1HasSha = true;
+static void llStart(miner_engine_job_t *job) {
+    if (!s_llOwnsSha) {
+        sha256_ll_acquire();
+        s_llOwnsSha = true;
+    }
+    // Recomputed after a yield too, in case the hardware state was lost
+    sha256_ll_midstate(s_llMidstate, (const uint8_t *)job->header_swapped);
+}
 
-        // Re-initialize SHA hardware before loop
-        // Only re-init if SHA was actually disabled
-        if (!(DPORT_REG_READ(DPORT_PERI_CLK_EN_REG) & DPORT_PERI_EN_SHA)) {
-            DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
-            DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
+static uint32_t llPoll(miner_engine_job_t *job, miner_engine_result_t *out, uint32_t max,
+                       miner_engine_poll_t *status, volatile bool *run) {
+    // header_swapped[16] is the start of the 2nd chunk (tail)
+    const uint8_t *tail = (const uint8_t *)&job->header_swapped[16];
+    uint8_t hash[32];
+    uint32_t start = job->nonce;
+    uint32_t found = 0;
+
+    // Up to 64k nonces per poll (one ASM kernel return's worth)
+    do {
+        uint32_t nonce = __builtin_bswap32(job->nonce);
+        if (sha256_ll_double_hash(s_llMidstate, tail, nonce, hash)) {
+            out[found].nonce = nonce;
+            out[found].version = 0;
+            out[found].tag = job->tag;
+            found++;
         }
+        job->nonce++;
+    } while ((job->nonce & 0xFFFF) && found < max && *run);
 
-        while (s_miningActive) {
-            // Track hash count before v3 call for per-core stats
-            uint64_t hashBefore = s_stats.hashes;
-
-            // Run pipelined assembly mining loop v3 (working version)
-            // NOTE: v4 midstate injection does NOT work on ESP32 - SHA_LOAD copies
-            // FROM internal state TO SHA_TEXT, there's no way to restore a midstate
-            bool candidate = sha256_pipelined_mine_v3(
-                sha_base,
-                header_swapped,
-                &nonce_swapped,
-                &s_stats.hashes,
-                &s_miningActive
-            );
-
-            // Track Core 1 hash contribution
-            s_core1Hashes += (s_stats.hashes - hashBefore);
-
-            if (!s_miningActive) break;
-
-            if (candidate) {
-                // BitsyMiner pattern: The assembly incremented nonce BEFORE exiting, so use nonce-1
-                uint32_t candidate_nonce_swapped = nonce_swapped - 1;
-                uint32_t candidate_nonce_native = __builtin_bswap32(candidate_nonce_swapped);
-
-                // BitsyMiner CRITICAL pattern: Verify with SOFTWARE SHA on UNSWAPPED header
-                // This is what the pool computes, so hashes MUST match!
-                hbVerify.nonce = candidate_nonce_native;
-                if (miner_sha256_header(&midstate, &ctx, &hbVerify)) {
-                    // SOFTWARE verified share - submit it
-                    hashCheck(jobId, &ctx, hbVerify.timestamp, candidate_nonce_native);
-                }
+    status->hashes = job->nonce - start;
+    status->exhausted = rangeExhausted(job->nonce, job->nonceStart, job->nonceCount);
+    return found;
+}
 
-                // Re-init pipelined SHA hardware
-                DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
-                DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
-            }
+static void llStop() {
+    if (!s_llOwnsSha) return;
+    sha256_ll_release();
+    s_llOwnsSha = false;
+}
 
-            // Yield periodically to prevent WDT
-            // The ASM function returns every ~65k hashes (on partial match),
-            // so we yield every 16 iterations (approx 1M hashes)
-            static uint32_t loop_iter = 0;
-            if (++loop_iter >= 16) {
-                loop_iter = 0;
-                vTaskDelay(1);
-                // Re-init after yield
-                // Only re-init if SHA was actually disabled
-                if (!(DPORT_REG_READ(DPORT_PERI_CLK_EN_REG) & DPORT_PERI_EN_SHA)) {
-                    DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
-                    DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
-                }
-            }
-        }
+static const miner_engine_t s_builtinEngine = {
+    "ll", false, llInit, llStart, llPoll, llStop
+};
+
+#endif // MINER_HAS_HW_KERNELS
 
-        // Release SHA mutex when done
-        s_core1HasSha = false;
-        xSemaphoreGive(s_shaMutex);
+// ============================================================
+// Mining Task - Core 1 (Dedicated, high priority, hash engine)
+// ============================================================
 
-        s_core1Mining = false;
-        vTaskDelay(20 / portTICK_PERIOD_MS);
+// Fill an engine job from the header of a core-local job copy
+static void engineLoad(miner_engine_job_t *ejob, miner_job_t *job, uint8_t tag, bool newMidstate) {
+    memcpy(&ejob->header, &job->header, sizeof(block_header_t));
+    swapHeader(ejob->header_swapped, &ejob->header);
+    if (newMidstate) {
+        miner_sha256_midstate(&ejob->midstate, &ejob->header);
     }
+    ejob->versionMask = job->versionMask;
+    ejob->shareDifficulty = s_poolDifficulty;
+    ejob->tag = tag;
 }
 
-#elif defined(CONFIG_IDF_TARGET_ESP32S3)
-#include <sha/sha_dma.h>  // For esp_sha_acquire/release_hardware
-// ESP32-S3: Optimized pipelined assembly mining with MIDSTATE CACHING (v2)
-// Key optimizations:
-// 1. Hardware midstate computed ONCE per job (not per nonce!)
-// 2. Block 2 template prepared once, only nonce changes
-// 3. Double-hash padding leverages zeros from block 2
+// Queue an engine result against the job its tag was started with
+static void pushResult(uint32_t minerId, const miner_engine_result_t *res) {
+    const miner_job_t *job = &s_engineJobs[res->tag % ENGINE_TAGS];
+    if (!res->version || res->version == job->header.version) {
+        pushCandidate(minerId, job, res->nonce);
+        return;
+    }
+
+    // Version bits rolled on the chip
+    miner_job_t rolled;
+    memcpy(&rolled, job, sizeof(miner_job_t));
+    rolled.header.version = res->version;
+    pushCandidate(minerId, &rolled, res->nonce);
+}
+
+// Bring up the hardware miner's engine: an ASIC chain when one is built in
+// and answers, else the target's own
+static const miner_engine_t *selectEngine(const char **name) {
+#if USE_ASIC_BM13XX
+    *name = bm13xx_engine.init();
+    if (*name) return &bm13xx_engine;
+    Serial.println("[MINER1] No ASIC chain answered - using the built-in engine");
+#endif
+    *name = s_builtinEngine.init();
+    return &s_builtinEngine;
+}
 
 void miner_task_core1(void *param) {
-    block_header_t hb;
-    block_header_t hbVerify;  // BitsyMiner pattern: keep UNSWAPPED copy for verification
-    sha256_hash_t ctx;
-    sha256_hash_t sw_midstate;  // SOFTWARE midstate for verification
-    uint32_t hw_midstate[8];    // HARDWARE midstate for mining (NEW!)
-    char jobId[MAX_JOB_ID_LEN];
+    miner_engine_job_t ejob;
+    miner_engine_result_t results[ENGINE_RESULTS];
     uint32_t minerId = 1;
+    uint32_t yieldCounter = 0;
+    uint32_t yieldEvery = CORE_1_YIELD_COUNT;  // Polls between yields, set by the scheduler
+    uint8_t tag = 0;
 
-    Serial.printf("[MINER1] Started on core %d (S3 Optimized ASM v2 + Midstate Cache, priority %d)\n",
+    Serial.printf("[MINER1] Started on core %d (priority %d)\n",
                   xPortGetCoreID(), uxTaskPriorityGet(NULL));
 
-    // Initialize S3 pipelined SHA hardware
-    sha256_pipelined_s3_init();
+    const char *name;
+    const miner_engine_t *engine = selectEngine(&name);
+    if (!name) {
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+        // Single core: this task is the only miner
+        Serial.println("[MINER1] No working hardware kernel - using software SHA");
+        miner_task_core0(param);  // Never returns
+#else
+        Serial.println("[MINER1] No working hardware kernel - Core 1 mining disabled");
+        // Parked, not deleted: the stack is static anyway, and the memory
+        // budget still reads this task's stack peak
+        vTaskSuspend(NULL);
+#endif
+    }
+    s_hwKernelName = name;
 
     // Wait for first job
     while (!s_miningActive) {
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        vTaskDelay(10 / portTICK_PERIOD_MS);
     }
-    Serial.println("[MINER1] Got first job, starting S3 optimized assembly mining (v2 with midstate)");
+    Serial.printf("[MINER1] Got first job, starting %s engine (%s)\n", engine->name, name);
 
     while (true) {
         if (!s_miningActive) {
+            s_core1Mining = false;
             vTaskDelay(100 / portTICK_PERIOD_MS);
             continue;
         }
 
         s_core1Mining = true;
 
-        // Copy job data
-        xSemaphoreTake(s_jobMutex, portMAX_DELAY);
-        memcpy(&hb, &s_pendingBlock, sizeof(block_header_t));
-        memcpy(&hbVerify, &s_pendingBlock, sizeof(block_header_t));  // Keep UNSWAPPED for verification!
-        strncpy(jobId, s_currentJobId, MAX_JOB_ID_LEN);
-        xSemaphoreGive(s_jobMutex);
-
-        // BitsyMiner pattern: Compute SOFTWARE midstate on UNSWAPPED header (for verification)
-        miner_sha256_midstate(&sw_midstate, &hbVerify);
-
-        // ========================================
-        // BYTESWAP32 all 20 words of header for hardware SHA
-        // ========================================
-        uint32_t header_swapped[20];
-        uint32_t *header_words = (uint32_t *)&hb;
-        for (int i = 0; i < 20; i++) {
-            header_swapped[i] = __builtin_bswap32(header_words[i]);
-        }
+        // Pick up the latest published job (run flag first, see loadJob)
+        s_coreRun[minerId] = true;
+        miner_job_t *job = &s_engineJobs[tag];
+        uint32_t jobSeq = loadJob(job);
+        TRACE_POINT(TRACE_JOB_PICKUP, minerId);
+        engineLoad(&ejob, job, tag, true);
+        ejob.nonce = job->startNonce[minerId];
+        ejob.nonceStart = ejob.nonce;
+        ejob.nonceCount = NONCE_RANGE_SPLIT;
+        engine->start(&ejob);
+
+        TRACE_POINT(TRACE_HASHING, minerId);
+        while (keepMining(minerId)) {
+            miner_engine_poll_t status;
+            uint32_t found = engine->poll(&ejob, results, ENGINE_RESULTS, &status, &s_coreRun[minerId]);
+            publishHashes(minerId, status.hashes);
+
+            if (!keepMining(minerId)) break;
+
+            // Software verification (what the pool computes) and submission
+            // run on the verify task, so go straight back to hashing
+            for (uint32_t i = 0; i < found; i++) {
+                pushResult(minerId, &results[i]);
+            }
 
-        // ========================================
-        // OPTIMIZATION v3: Compute hardware midstate ONCE per job!
-        // Also initialize persistent zeros in SHA_TEXT
-        // ========================================
-        esp_sha_acquire_hardware();
-        sha256_s3_compute_midstate(header_swapped, hw_midstate);
-        sha256_s3_init_zeros();  // Set persistent zeros for block 2 padding
-
-        // Prepare block 2 template (words 16-18: last 4 bytes merkle, timestamp, nbits)
-        // Word 19 (nonce) will be set per iteration
-        uint32_t block2_template[3];
-        block2_template[0] = header_swapped[16];  // merkle_root tail (swapped)
-        block2_template[1] = header_swapped[17];  // timestamp (swapped)
-        block2_template[2] = header_swapped[18];  // nbits (swapped)
-
-        // Nonce in big-endian format for hardware SHA
-        uint32_t nonce_swapped = __builtin_bswap32(s_startNonce[minerId]);
-
-        #ifdef DEBUG_MINING
-        Serial.printf("[S3-V3] Midstate cached, zeros persistent, starting batched-copy loop\n");
-        static uint32_t s3_call_count = 0;
-        uint64_t hashes_before = s_stats.hashes;
-        #endif
+            // Range used up: roll ntime, version bits or swap to Core 0's prepared
+            // extranonce2. The rolled header gets the next tag, so late results
+            // for the previous one still find their header.
+            if (status.exhausted) {
+                miner_job_t *prev = job;
+                tag = (tag + 1) % ENGINE_TAGS;
+                job = &s_engineJobs[tag];
+                memcpy(job, prev, sizeof(miner_job_t));
+                bool newMidstate = rollNonceRange(job, jobSeq);
+                engineLoad(&ejob, job, tag, newMidstate);
+                ejob.nonceStart = ejob.nonce;
+                ejob.nonceCount = NONCE_RANGE_FULL;
+                engine->start(&ejob);
+            }
 
-        while (s_miningActive) {
-            // Run ULTRA-OPTIMIZED pipelined assembly mining loop (v3)
-            // - Midstate restore (same as v2)
-            // - Batched register loads for SHA_H copy (pipeline memory)
-            // - Persistent zeros (skip writing 10 zeros per iteration)
-            #ifdef DEBUG_MINING
-            s3_call_count++;
-            #endif
-
-            bool candidate = sha256_pipelined_mine_s3_v3(
-                hw_midstate,
-                block2_template,
-                &nonce_swapped,
-                &s_stats.hashes,
-                &s_miningActive
-            );
-
-            #ifdef DEBUG_MINING
-            if ((s3_call_count & 0x7FFFF) == 0) {  // Every ~512K calls
-                uint64_t hashes_now = s_stats.hashes;
-                Serial.printf("[S3-V3] calls=%u, hashes=%llu\n", s3_call_count, hashes_now);
+            // Yield periodically to prevent WDT. CPU engines return every ~65k
+            // hashes, so the interval counts polls (CORE_1_YIELD_COUNT = approx
+            // 1M hashes); engines that wait on their hardware yield in poll()
+            if (!engine->waits && ++yieldCounter >= yieldEvery) {
+                yieldCounter = 0;
+                engine->stop();
+                yieldCore(minerId);
+                engine->start(&ejob);
+                yieldEvery = yieldInterval(minerId);
             }
-            #endif
+        }
 
-            if (!s_miningActive) break;
+        engine->stop();
+        tag = (tag + 1) % ENGINE_TAGS;
+        // Fall through to reload: either a new job was published or mining stopped
+    }
+}
 
-            if (candidate) {
-                // BitsyMiner pattern: The assembly incremented nonce BEFORE exiting
-                uint32_t candidate_nonce_swapped = nonce_swapped - 1;
-                uint32_t candidate_nonce_native = __builtin_bswap32(candidate_nonce_swapped);
+// ============================================================
+// Benchmark
+// ============================================================
 
-                // Debug logging for S3 share validation investigation (Issue #5)
-                #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(DEBUG_SHARE_VALIDATION)
-                Serial.printf("[S3-DBG] Candidate found! nonce_swapped=%08x native=%08x\n",
-                              candidate_nonce_swapped, candidate_nonce_native);
-                #endif
+#define BENCH_KERNEL_MS     1000    // Timed window per hardware kernel
+#define BENCH_SW_MS         1000    // Timed window for the Core 0 software kernel
+#define BENCH_ITERATIONS    1000    // Repeats for the per-call timings
+#define BENCH_JOB_BUILDS    20      // Job builds averaged
+#define BENCH_MERKLE_DEPTH  12      // Branches for a ~3000-transaction block
+#define BENCH_COINB1_BYTES  106     // Typical pool coinbase split around extranonce
+#define BENCH_COINB2_BYTES  180
+
+typedef struct {
+    uint32_t rates[4];              // H/s per registered kernel (0 = failed KAT)
+    SemaphoreHandle_t done;
+} bench_kernels_t;
+
+// Hex fields of a benchmark mining.notify
+typedef struct {
+    char prevHash[65];
+    char coinb1[BENCH_COINB1_BYTES * 2 + 1];
+    char coinb2[BENCH_COINB2_BYTES * 2 + 1];
+    char extraNonce1[9];
+    char branches[BENCH_MERKLE_DEPTH][65];
+} bench_notify_t;
+
+// Pseudo-random hex so the job builder hashes realistic data
+static void benchHex(char *out, size_t bytes, uint32_t seed) {
+    static const char *tbl = "0123456789abcdef";
+    for (size_t i = 0; i < bytes * 2; i++) {
+        seed = seed * 1103515245 + 12345;
+        out[i] = tbl[(seed >> 16) & 0x0f];
+    }
+    out[bytes * 2] = '\0';
+}
 
-                // BitsyMiner CRITICAL: Verify with SOFTWARE SHA on UNSWAPPED header
-                hbVerify.nonce = candidate_nonce_native;
-                bool swVerified = miner_sha256_header(&sw_midstate, &ctx, &hbVerify);
+// Take both cores off their jobs and wait until they have let go of the SHA
+// hardware. Pauses nest: only the first records whether mining was on, only
+// the last benchResume() hands the cores back. A pause that times out is
+// undone here, so a false return takes no benchResume().
+static void benchResume();
+
+static bool benchPause() {
+    portENTER_CRITICAL(&s_benchLock);
+    if (s_pauseDepth++ == 0) {
+        s_benchResume = s_miningActive;
+        s_benchActive = true;
+        s_miningActive = false;
+    }
+    portEXIT_CRITICAL(&s_benchLock);
+    s_coreRun[0] = false;
+    s_coreRun[1] = false;
+
+    uint32_t start = millis();
+    while (s_core0Mining || s_core1Mining || s_core1HasSha) {
+        if (millis() - start > 2000) {
+            benchResume();
+            return false;
+        }
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+    }
+    return true;
+}
 
-                // Debug logging for S3 share validation investigation (Issue #5)
-                #if defined(CONFIG_IDF_TARGET_ESP32S3) || defined(DEBUG_SHARE_VALIDATION)
-                Serial.printf("[S3-DBG] SW verify=%s hash[28-31]=%02x%02x%02x%02x\n",
-                              swVerified ? "PASS" : "FAIL",
-                              ctx.bytes[28], ctx.bytes[29], ctx.bytes[30], ctx.bytes[31]);
-                #endif
+static void benchResume() {
+    portENTER_CRITICAL(&s_benchLock);
+    bool last = s_pauseDepth && --s_pauseDepth == 0;
+    if (last) {
+        s_benchActive = false;
+        if (s_benchResume) {
+            s_miningActive = true;  // Cores reload the current (or newer) job slot
+        }
+    }
+    portEXIT_CRITICAL(&s_benchLock);
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    if (last) unparkCore1();  // Benchmark job builds park Core 1 like real ones
+#endif
+}
 
-                if (swVerified) {
-                    hashCheck(jobId, &ctx, hbVerify.timestamp, candidate_nonce_native);
-                }
-            }
+bool miner_pause() {
+    return benchPause();
+}
 
-            // Yield periodically to prevent WDT
-            // The ASM function returns every ~65k hashes (on partial match),
-            // so we yield every 16 iterations (approx 1M hashes)
-            static uint32_t loop_iter = 0;
-            if (++loop_iter >= 16) {
-                loop_iter = 0;
-                esp_sha_release_hardware();
-                vTaskDelay(1);
-                esp_sha_acquire_hardware();
-            }
-        }
+void miner_resume() {
+    benchResume();
+}
 
-        esp_sha_release_hardware();
-        s_core1Mining = false;
-        vTaskDelay(20 / portTICK_PERIOD_MS);
-    }
+bool miner_is_benchmarking() {
+    return s_benchRunning;
 }
 
+#if MINER_HAS_HW_KERNELS
+// Hardware kernels are measured where they normally run: Core 1 at mining
+// priority (the only core at Miner0's priority on the C3), owning the peripheral
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+    #define BENCH_KERNEL_CORE       CORE_0
+    #define BENCH_KERNEL_PRIORITY   MINER_0_PRIORITY
 #else
-// Fallback for ESP32-C3/S2: Use sequential HAL-based mining with Midstate Optimization
+    #define BENCH_KERNEL_CORE       MINER_1_CORE
+    #define BENCH_KERNEL_PRIORITY   MINER_1_PRIORITY
+#endif
 
-void miner_task_core1(void *param) {
-    block_header_t hb;
-    sha256_hash_t ctx;
-    char jobId[MAX_JOB_ID_LEN];
-    uint32_t minerId = 1;
+static void benchKernelTask(void *param) {
+    bench_kernels_t *bench = (bench_kernels_t *)param;
 
-    Serial.printf("[MINER1] Started on core %d (Hardware SHA Midstate, priority %d)\n",
-                  xPortGetCoreID(), uxTaskPriorityGet(NULL));
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    xSemaphoreTake(s_shaMutex, portMAX_DELAY);
+    s_core1HasSha = true;
+    DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
+    DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
+#else
+    esp_sha_acquire_hardware();
+#endif
 
-    // Wait for first job
-    while (!s_miningActive) {
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+    for (size_t i = 0; i < miner_kernel_count() && i < 4; i++) {
+        bench->rates[i] = miner_kernel_measure(miner_kernel_get(i), BENCH_KERNEL_MS);
     }
-    Serial.println("[MINER1] Got first job, starting mining loop");
-
-    while (true) {
-        if (!s_miningActive) {
-            vTaskDelay(100 / portTICK_PERIOD_MS);
-            continue;
-        }
 
-        s_core1Mining = true;
+#if defined(CONFIG_IDF_TARGET_ESP32)
+    s_core1HasSha = false;
+    xSemaphoreGive(s_shaMutex);
+#else
+    esp_sha_release_hardware();
+#endif
 
-        // Copy job data
-        xSemaphoreTake(s_jobMutex, portMAX_DELAY);
-        memcpy(&hb, &s_pendingBlock, sizeof(block_header_t));
-        strncpy(jobId, s_currentJobId, MAX_JOB_ID_LEN);
-        xSemaphoreGive(s_jobMutex);
+    xSemaphoreGive(bench->done);
+    vTaskDelete(NULL);
+}
+#endif
 
-        // Create swapped header for hardware SHA
-        uint32_t header_swapped[20];
-        uint32_t *header_words = (uint32_t *)&hb;
-        for (int i = 0; i < 20; i++) {
-            header_swapped[i] = __builtin_bswap32(header_words[i]);
+bool miner_benchmark(JsonObject out) {
+    if (!benchPause()) {
+        Serial.println("[BENCH] Mining cores did not stop, benchmark aborted");
+        return false;
+    }
+    s_benchRunning = true;
+
+    out["mhz"] = getCpuFrequencyMhz();
+    JsonObject kernels = out.createNestedObject("kernels");
+
+    // Hardware kernels on the mining core
+#if MINER_HAS_HW_KERNELS
+    bench_kernels_t bench;
+    memset(&bench, 0, sizeof(bench));
+    bench.done = xSemaphoreCreateBinary();
+    if (bench.done && xTaskCreatePinnedToCore(benchKernelTask, "Bench", 4096, &bench,
+                                              BENCH_KERNEL_PRIORITY, NULL, BENCH_KERNEL_CORE) == pdPASS) {
+        xSemaphoreTake(bench.done, portMAX_DELAY);
+        for (size_t i = 0; i < miner_kernel_count() && i < 4; i++) {
+            kernels[miner_kernel_get(i)->name] = bench.rates[i];
         }
+    }
+    if (bench.done) vSemaphoreDelete(bench.done);
+#endif
 
-        // Set starting nonce for this core
-        hb.nonce = s_startNonce[minerId];
-
-        // Prepare midstate variables
-        uint32_t midstate[8];
-        uint8_t *header_bytes = (uint8_t *)header_swapped;
+    // Job build: realistic coinbase and merkle depth, into scratch buffers
+    bench_notify_t *hex = (bench_notify_t *)malloc(sizeof(bench_notify_t));
+    mining_job_bin_t *bin = (mining_job_bin_t *)malloc(sizeof(mining_job_bin_t));
+    miner_job_t *slot = (miner_job_t *)malloc(sizeof(miner_job_t));
+    miner_coinbase_t *cb = (miner_coinbase_t *)malloc(sizeof(miner_coinbase_t));
+    if (!hex || !bin || !slot || !cb) {
+        free(hex);
+        free(bin);
+        free(slot);
+        free(cb);
+        s_benchRunning = false;
+        benchResume();
+        return false;
+    }
 
-        // Acquire hardware SHA lock for this mining burst
-        sha256_ll_acquire();
+    benchHex(hex->prevHash, 32, 1);
+    benchHex(hex->coinb1, BENCH_COINB1_BYTES, 2);
+    benchHex(hex->coinb2, BENCH_COINB2_BYTES, 3);
+    benchHex(hex->extraNonce1, 4, 4);
+    for (int i = 0; i < BENCH_MERKLE_DEPTH; i++) {
+        benchHex(hex->branches[i], 32, 100 + i);
+    }
 
-        // Compute midstate once for the block
-        sha256_ll_midstate(midstate, header_bytes);
+    // Notify decode, as parseMiningNotify() does once per job
+    uint32_t t0 = micros();
+    for (int i = 0; i < BENCH_JOB_BUILDS; i++) {
+        memset(bin, 0, sizeof(mining_job_bin_t));
+        strcpy(bin->jobId, "bench");
+        decodeJobPrevHash(bin, hex->prevHash);
+        decodeJobCoinbase(bin, hex->coinb1, hex->extraNonce1, s_extraNonce2Size, hex->coinb2);
+        for (int b = 0; b < BENCH_MERKLE_DEPTH; b++) {
+            decodeJobBranch(bin, hex->branches[b]);
+        }
+        bin->version = strtoul("20000000", NULL, 16);
+        bin->nbits = strtoul("17034219", NULL, 16);
+        bin->ntime = strtoul("66f1e4a0", NULL, 16);
+    }
+    out["job_decode_us"] = (float)(micros() - t0) / BENCH_JOB_BUILDS;
 
-        while (s_miningActive) {
-            // Optimized midstate mining
-            // Uses pre-computed midstate and only hashes the tail (last 16 bytes + padding)
-            // header_bytes[64] is the start of the 2nd chunk (tail)
-            if (sha256_ll_double_hash(midstate, &header_bytes[64], hb.nonce, ctx.bytes)) {
-                hashCheck(jobId, &ctx, hb.timestamp, hb.nonce);
-            }
+    t0 = micros();
+    for (int i = 0; i < BENCH_JOB_BUILDS; i++) {
+        buildJob(slot, cb, bin);
+    }
+    out["job_build_us"] = (float)(micros() - t0) / BENCH_JOB_BUILDS;
+#if defined(CONFIG_IDF_TARGET_ESP32S3)
+    out["job_build_dma"] = s_dmaJobs;
+#endif
+    out["merkle_depth"] = BENCH_MERKLE_DEPTH;
+    out["coinbase_bytes"] = cb->coinbaseLen;
 
-            hb.nonce++;
-            s_stats.hashes++;
+    block_header_t hb;
+    memcpy(&hb, &slot->header, sizeof(block_header_t));
+    free(hex);
+    free(bin);
+    free(slot);
+    free(cb);
 
-            // Yield periodically to prevent WDT (every ~1M nonces)
-            if ((hb.nonce & 0xFFFFF) == 0) {
-                sha256_ll_release();
-                vTaskDelay(1);
-                sha256_ll_acquire();
-                // Recompute midstate after yield just in case hardware state was lost (unlikely but safe)
-                sha256_ll_midstate(midstate, header_bytes);
-            }
-        }
+    // Midstate: software (every job and roll) vs hardware peripheral
+    sha256_hash_t midstate;
+    JsonObject mid = out.createNestedObject("midstate_us");
+    t0 = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        hb.version++;
+        miner_sha256_midstate(&midstate, &hb);
+    }
+    mid["sw"] = (float)(micros() - t0) / BENCH_ITERATIONS;
 
-        // Release hardware SHA lock
-        sha256_ll_release();
+    uint32_t header_swapped[20];
+    uint32_t hw_midstate[8];
+    swapHeader(header_swapped, &hb);
+    xSemaphoreTake(s_shaMutex, portMAX_DELAY);
+    sha256_ll_acquire();
+    t0 = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        header_swapped[0]++;
+        sha256_ll_midstate(hw_midstate, (const uint8_t *)header_swapped);
+    }
+    mid["hw"] = (float)(micros() - t0) / BENCH_ITERATIONS;
+    sha256_ll_release();
+    xSemaphoreGive(s_shaMutex);
 
-        s_core1Mining = false;
-        vTaskDelay(20 / portTICK_PERIOD_MS);
+    // Share verification: full software double hash of a candidate
+    sha256_hash_t ctx;
+    miner_sha256_midstate(&midstate, &hb);
+    t0 = micros();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        hb.nonce = i;
+        miner_sha256_header(&midstate, &ctx, &hb);
     }
-}
+    out["verify_us"] = (float)(micros() - t0) / BENCH_ITERATIONS;
 
-#endif // CONFIG_IDF_TARGET_ESP32
+    // Core 0 software kernel, on this (Core 0) task
+    miner_sha256_bake_t bake;
+    miner_sha256_bake(&bake, &midstate, &hb);
+    uint32_t nonce = 0;
+    t0 = micros();
+    uint32_t elapsed;
+    do {
+        miner_sha256_header_batch(&bake, nonce, CORE_0_BATCH_SIZE);
+        nonce += CORE_0_BATCH_SIZE;
+        elapsed = micros() - t0;
+    } while (elapsed < BENCH_SW_MS * 1000);
+    kernels["sw"] = (uint32_t)((uint64_t)nonce * 1000000ULL / elapsed);
+
+    s_benchRunning = false;
+    benchResume();
+    return true;
+}
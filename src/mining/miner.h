@@ -29,10 +29,13 @@ void miner_init();
 /**
  * Start mining with new job
  * Called when pool sends mining.notify
+ * Non-blocking: builds the job into the idle slot of a double buffer and
+ * publishes it; each core switches over at its next kernel return.
+ * Must only be called from one task (the stratum task).
  *
- * @param job Stratum job from pool
+ * @param job Decoded stratum job from pool (only read during the call)
  */
-void miner_start_job(const stratum_job_t *job);
+void miner_start_job(const mining_job_bin_t *job);
 
 /**
  * Stop mining
@@ -50,6 +53,14 @@ bool miner_is_running();
  */
 mining_stats_t* miner_get_stats();
 
+/**
+ * Name of the kernel a mining slot runs
+ * Slot 0 is the Core 0 software miner ("sw"), slot 1 the hardware miner
+ * (the selected kernel, "ll" on S2, or the ASIC model with USE_ASIC_BM13XX).
+ * NULL until it has started.
+ */
+const char *miner_get_kernel_name(uint8_t slot);
+
 /**
  * Mining task for Core 0 (software SHA, lower priority)
  * Yields periodically to allow WiFi/Stratum/Display tasks
@@ -58,10 +69,18 @@ void miner_task_core0(void *param);
 
 /**
  * Mining task for Core 1 (dedicated, high priority)
- * Uses pipelined SHA for maximum throughput
+ * Runs the hash engine (miner_engine.h): pipelined SHA for maximum
+ * throughput, or an external ASIC chain
  */
 void miner_task_core1(void *param);
 
+/**
+ * Share verify task
+ * Drains the mining cores' candidate rings: software verification, share
+ * classification, logging and submission. Start before the miner tasks.
+ */
+void miner_task_verify(void *param);
+
 /**
  * Set pool difficulty for share validation
  */
@@ -72,6 +91,54 @@ void miner_set_difficulty(double poolDifficulty);
  */
 double miner_get_difficulty();
 
+/**
+ * Set BIP310 version rolling mask granted by mining.configure
+ * Applies from the next job. 0 disables version rolling.
+ */
+void miner_set_version_mask(uint32_t mask);
+
+/**
+ * Note that another task needs CPU time soon
+ * Mining cores yield more often for YIELD_BUSY_MS after each hint.
+ * Cheap and safe to call from any task or event callback.
+ */
+void miner_yield_hint();
+
+/**
+ * Run the mining benchmarks and add the results to a JSON object
+ * Pauses both mining cores for a few seconds, then resumes the current job.
+ * Fields: mhz, kernels (H/s per kernel, "sw" = Core 0), job_build_us,
+ * merkle_depth, coinbase_bytes, midstate_us (sw/hw), verify_us.
+ * Call from a Core 0 task.
+ *
+ * @param out Object to fill
+ * @return false if the cores could not be paused or memory ran out
+ */
+bool miner_benchmark(JsonObject out);
+
+/**
+ * Hold both mining cores off their jobs (CPU clock changes)
+ * Returns once both have left their kernels and released the SHA
+ * peripheral; they re-acquire it and re-prepare the current (or newer)
+ * job on miner_resume(). Jobs that arrive meanwhile are kept.
+ * Pauses nest with each other and with miner_benchmark(): mining resumes
+ * when the last one ends.
+ *
+ * @return false if the cores did not stop within 2 s (already undone:
+ *         do not call miner_resume())
+ */
+bool miner_pause();
+
+/**
+ * Hand the cores back after a miner_pause() that returned true
+ */
+void miner_resume();
+
+/**
+ * True while miner_benchmark() runs (its timings assume a fixed clock)
+ */
+bool miner_is_benchmarking();
+
 /**
  * Set extra nonce from pool subscription
  */
@@ -0,0 +1,93 @@
+/*
+ * SparkMiner - Hash Engines
+ * The hardware miner slot (Core 1, or the only miner task on the C3) runs
+ * one engine through four operations: init, start a job, poll for
+ * candidates and stop. The slot's loop owns everything else - job pickup,
+ * nonce range rolling, yielding, candidate verification and submission -
+ * so an engine only has to hash.
+ *
+ * Engines per target:
+ *   ESP32, S3, C3: the selected pipelined kernel (miner_kernels.h)
+ *   S2:            the sequential sha256_ll loop
+ *   Any target:    an external BM13xx ASIC chain with USE_ASIC_BM13XX=1
+ *                  (engine_bm13xx.h), falling back to the above when no
+ *                  chip answers
+ */
+
+#ifndef MINER_ENGINE_H
+#define MINER_ENGINE_H
+
+#include <Arduino.h>
+#include <board_config.h>
+#include "sha256_types.h"
+
+#define ENGINE_TAGS         16      // Jobs told apart in flight (ASIC chains return results late)
+#define ENGINE_RESULTS      8       // Results taken per poll
+
+/**
+ * Work for an engine, filled by the slot's loop
+ * An engine reads the form it needs; nonce is its position.
+ */
+typedef struct {
+    block_header_t header;          // Unswapped header (nonce ignored)
+    uint32_t header_swapped[20];    // Whole header in SHA message-word order
+    sha256_hash_t midstate;         // Software midstate of block 1
+    uint32_t nonce;                 // Next nonce, SHA word order (CPU engines advance it)
+    uint32_t nonceStart;            // Range start, SHA word order
+    uint32_t nonceCount;            // Range size
+    uint32_t versionMask;           // Version bits the engine may roll itself (0 = none)
+    double shareDifficulty;         // Pool difficulty: lowest result worth returning
+    uint8_t tag;                    // Echoed in results (0..ENGINE_TAGS-1)
+} miner_engine_job_t;
+
+/**
+ * One candidate nonce, verified in software before submission
+ */
+typedef struct {
+    uint32_t nonce;                 // Header byte order, as submitted
+    uint32_t version;               // Header version it was found with (rolled on chip), 0 = the job's
+    uint8_t tag;                    // Job it belongs to
+} miner_engine_result_t;
+
+/**
+ * What a poll did besides returning results
+ */
+typedef struct {
+    uint64_t hashes;                // Hashes done (estimated for ASICs) since the last poll
+    bool exhausted;                 // Range used up: roll the header and start again
+} miner_engine_poll_t;
+
+/**
+ * Registered engine
+ */
+typedef struct {
+    const char *name;               // Engine family ("kernel", "ll", "bm1366", ...)
+    bool waits;                     // poll() blocks on the hardware, so the loop never yields
+
+    /**
+     * Bring the engine up, once from the mining task
+     * @return Name reported for the slot (the kernel or chip), NULL if unavailable
+     */
+    const char *(*init)();
+
+    /**
+     * Take the hardware and hash job, replacing any work in progress
+     * Called for every new job and range roll, and after each yield.
+     */
+    void (*start)(miner_engine_job_t *job);
+
+    /**
+     * Hash or collect results until a candidate, the end of a batch or the
+     * run flag clears
+     * @return Results written to out (at most max)
+     */
+    uint32_t (*poll)(miner_engine_job_t *job, miner_engine_result_t *out, uint32_t max,
+                     miner_engine_poll_t *status, volatile bool *run);
+
+    /**
+     * Release the hardware (yield, job switch, mining stopped)
+     */
+    void (*stop)();
+} miner_engine_t;
+
+#endif // MINER_ENGINE_H
@@ -0,0 +1,410 @@
+/*
+ * SparkMiner - Hardware Mining Kernel Registry
+ * Boot-time selection of the fastest correct Core 1 kernel
+ */
+
+#include "miner_kernels.h"
+
+#if MINER_HAS_HW_KERNELS
+
+#include <esp_timer.h>
+#include <esp_chip_info.h>
+
+#include "sha256_types.h"
+#include "miner_sha256.h"
+#include "../config/nvs_config.h"
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
+#include <soc/dport_reg.h>
+#include "sha256_asm.h"
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+#include "sha256_pipelined_s3.h"
+#else
+#include "sha256_pipelined_c3.h"
+#include "sha256_ll.h"
+#endif
+
+// ============================================================
+// Kernel Adapters
+// ============================================================
+
+// Kernels that return on a candidate leave the nonce just past it
+static inline uint32_t listCandidate(miner_kernel_batch_t *batch, bool candidate) {
+    if (candidate) batch->nonces[batch->count++] = batch->nonce - 1;
+    return batch->count;
+}
+
+#if defined(CONFIG_IDF_TARGET_ESP32)
+
+#define SHA_TEXT_BASE ((volatile uint32_t *)0x3FF03000)
+
+typedef bool (*esp32_kernel_fn)(volatile uint32_t *, const uint32_t *, uint32_t *,
+                                volatile uint64_t *, volatile bool *);
+
+// ESP32 kernels reload all of block 1 per nonce, nothing to prepare
+static void prepare_none(miner_kernel_job_t *job) {
+    (void)job;
+}
+
+// Candidate exit leaves the peripheral mid-operation; re-init before the next run
+static inline uint32_t esp32_run(esp32_kernel_fn fn, const miner_kernel_job_t *job,
+                                 miner_kernel_batch_t *batch, volatile uint64_t *hashes,
+                                 volatile bool *flag) {
+    bool candidate = fn(SHA_TEXT_BASE, job->header_swapped, &batch->nonce, hashes, flag);
+    if (candidate) {
+        DPORT_REG_SET_BIT(DPORT_PERI_CLK_EN_REG, DPORT_PERI_EN_SHA);
+        DPORT_REG_CLR_BIT(DPORT_PERI_RST_EN_REG, DPORT_PERI_EN_SHA | DPORT_PERI_EN_SECUREBOOT);
+    }
+    return listCandidate(batch, candidate);
+}
+
+static uint32_t mine_v1(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                        volatile uint64_t *hashes, volatile bool *flag) {
+    return esp32_run(sha256_pipelined_mine, job, batch, hashes, flag);
+}
+
+static uint32_t mine_v2(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                        volatile uint64_t *hashes, volatile bool *flag) {
+    return esp32_run(sha256_pipelined_mine_v2, job, batch, hashes, flag);
+}
+
+static uint32_t mine_v3(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                        volatile uint64_t *hashes, volatile bool *flag) {
+    return esp32_run(sha256_pipelined_mine_v3, job, batch, hashes, flag);
+}
+
+// v4 (midstate injection) is left out: SHA_LOAD cannot restore a midstate on ESP32
+static const miner_kernel_t s_kernels[] = {
+    { "v3", prepare_none, mine_v3 },  // Listed first: the default before tuning existed
+    { "v2", prepare_none, mine_v2 },
+    { "v1", prepare_none, mine_v1 },
+};
+
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+
+static void prepare_block2(miner_kernel_job_t *job) {
+    job->block2[0] = job->header_swapped[16];  // merkle_root tail
+    job->block2[1] = job->header_swapped[17];  // timestamp
+    job->block2[2] = job->header_swapped[18];  // nbits
+}
+
+static void prepare_s3v1(miner_kernel_job_t *job) {
+    prepare_block2(job);
+}
+
+static void prepare_s3v2(miner_kernel_job_t *job) {
+    prepare_block2(job);
+    sha256_s3_compute_midstate(job->header_swapped, job->midstate);
+}
+
+// v3 also relies on block 2 padding zeros left in SHA_TEXT, so this must be
+// re-run whenever something else may have used the peripheral
+static void prepare_s3v3(miner_kernel_job_t *job) {
+    prepare_s3v2(job);
+    sha256_s3_init_zeros();
+}
+
+static uint32_t mine_s3v1(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                          volatile uint64_t *hashes, volatile bool *flag) {
+    return listCandidate(batch, sha256_pipelined_mine_s3(job->header_swapped, &batch->nonce, hashes, flag));
+}
+
+static uint32_t mine_s3v2(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                          volatile uint64_t *hashes, volatile bool *flag) {
+    return listCandidate(batch, sha256_pipelined_mine_s3_v2(job->midstate, job->block2, &batch->nonce, hashes, flag));
+}
+
+static uint32_t mine_s3v3(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                          volatile uint64_t *hashes, volatile bool *flag) {
+    return listCandidate(batch, sha256_pipelined_mine_s3_v3(job->midstate, job->block2, &batch->nonce, hashes, flag));
+}
+
+static const miner_kernel_t s_kernels[] = {
+    { "s3v3", prepare_s3v3, mine_s3v3 },  // Listed first: the default before tuning existed
+    { "s3v2", prepare_s3v2, mine_s3v2 },
+    { "s3v1", prepare_s3v1, mine_s3v1 },
+};
+
+#else // CONFIG_IDF_TARGET_ESP32C3
+
+// Relies on padding zeros left in SHA_TEXT, so this must be re-run
+// whenever something else may have used the peripheral
+static void prepare_c3v1(miner_kernel_job_t *job) {
+    job->block2[0] = job->header_swapped[16];  // merkle_root tail
+    job->block2[1] = job->header_swapped[17];  // timestamp
+    job->block2[2] = job->header_swapped[18];  // nbits
+    sha256_c3_compute_midstate(job->header_swapped, job->midstate);
+    sha256_c3_init_zeros();
+}
+
+static uint32_t mine_c3v1(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                          volatile uint64_t *hashes, volatile bool *flag) {
+    return listCandidate(batch, sha256_pipelined_mine_c3(job->midstate, job->block2, &batch->nonce, hashes, flag));
+}
+
+static void prepare_c3ll(miner_kernel_job_t *job) {
+    sha256_ll_midstate(job->midstate, (const uint8_t *)job->header_swapped);
+}
+
+// The sequential sha256_ll path behind the kernel interface, as a baseline
+static uint32_t mine_c3ll(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                          volatile uint64_t *hashes, volatile bool *flag) {
+    const uint8_t *tail = (const uint8_t *)&job->header_swapped[16];
+    uint8_t digest[32];
+    uint32_t n = batch->nonce;
+    uint32_t count = 0;
+    bool candidate = false;
+    while (count < C3_KERNEL_BATCH && *flag) {
+        candidate = sha256_ll_double_hash(job->midstate, tail, __builtin_bswap32(n), digest);
+        n++;
+        count++;
+        if (candidate) break;
+    }
+    batch->nonce = n;
+    *hashes += count;
+    return listCandidate(batch, candidate);
+}
+
+static const miner_kernel_t s_kernels[] = {
+    { "c3v1", prepare_c3v1, mine_c3v1 },
+    { "c3ll", prepare_c3ll, mine_c3ll },
+};
+
+#endif
+
+#define KERNEL_COUNT (sizeof(s_kernels) / sizeof(s_kernels[0]))
+
+// ============================================================
+// Known-Answer Test
+// ============================================================
+
+// Bitcoin genesis block header (80 bytes, wire order)
+static const uint8_t s_genesisHeader[80] = {
+    0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x3b, 0xa3, 0xed, 0xfd, 0x7a, 0x7b, 0x12, 0xb2, 0x7a, 0xc7, 0x2c, 0x3e,
+    0x67, 0x76, 0x8f, 0x61, 0x7f, 0xc8, 0x1b, 0xc3, 0x88, 0x8a, 0x51, 0x32, 0x3a, 0x9f, 0xb8, 0xaa,
+    0x4b, 0x1e, 0x5e, 0x4a, 0x29, 0xab, 0x5f, 0x49, 0xff, 0xff, 0x00, 0x1d, 0x1d, 0xac, 0x2b, 0x7c,
+};
+
+// Genesis nonce in the kernels' SHA word order counter. The nearest 16-bit
+// candidate below it is 0x1dab3e4f, so a run started KAT_LEAD nonces early
+// must list exactly this one first.
+#define KAT_NONCE       0x1dac2b7cU
+#define KAT_LEAD        4096
+#define KAT_TIMEOUT_MS  200     // Slack for the slower C3 kernels
+
+static block_header_t s_katHeader;
+static sha256_hash_t s_katMidstate;
+static bool s_katReady = false;
+
+// KAT job: genesis header plus its software midstate for candidate checks
+static void katJob(miner_kernel_job_t *job) {
+    if (!s_katReady) {
+        memcpy(&s_katHeader, s_genesisHeader, sizeof(block_header_t));
+        miner_sha256_midstate(&s_katMidstate, &s_katHeader);
+        s_katReady = true;
+    }
+    const uint32_t *words = (const uint32_t *)s_genesisHeader;
+    for (int i = 0; i < 20; i++) {
+        job->header_swapped[i] = __builtin_bswap32(words[i]);
+    }
+}
+
+static void tuneTimerCallback(void *arg) {
+    *(volatile bool *)arg = false;
+}
+
+// Run a kernel until its first candidate or timeoutMs, whichever comes first
+static bool runTimed(const miner_kernel_t *kernel, const miner_kernel_job_t *job,
+                     uint32_t *nonce, volatile uint64_t *hashes, uint32_t timeoutMs,
+                     bool stopAtCandidate, uint32_t *firstCandidate, uint32_t *badCandidates) {
+    volatile bool run = true;
+    esp_timer_handle_t timer;
+    esp_timer_create_args_t args = {};
+    args.callback = tuneTimerCallback;
+    args.arg = (void *)&run;
+    args.name = "ktune";
+    if (esp_timer_create(&args, &timer) != ESP_OK) {
+        return false;
+    }
+    esp_timer_start_once(timer, (uint64_t)timeoutMs * 1000);
+
+    miner_kernel_batch_t batch;
+    batch.nonce = *nonce;
+    batch.max = KERNEL_CANDIDATES;
+    bool found = false;
+    while (run) {
+        batch.count = 0;
+        uint32_t listed = kernel->mine(job, &batch, hashes, &run);
+
+        // Every candidate must pass the software reference
+        for (uint32_t i = 0; i < listed; i++) {
+            block_header_t hb;
+            sha256_hash_t ctx;
+            memcpy(&hb, &s_katHeader, sizeof(block_header_t));
+            hb.nonce = __builtin_bswap32(batch.nonces[i]);
+            if (!miner_sha256_header(&s_katMidstate, &ctx, &hb)) {
+                (*badCandidates)++;
+            }
+            if (!found) *firstCandidate = batch.nonces[i];
+            found = true;
+        }
+        if (found && stopAtCandidate) break;
+    }
+    *nonce = batch.nonce;
+
+    esp_timer_stop(timer);
+    esp_timer_delete(timer);
+    return found;
+}
+
+static bool kernelKat(const miner_kernel_t *kernel, miner_kernel_job_t *job) {
+    miner_kernel_load(kernel, job, job->header_swapped);
+
+    uint32_t nonce = KAT_NONCE - KAT_LEAD;
+    volatile uint64_t hashes = 0;
+    uint32_t first = 0, bad = 0;
+    if (!runTimed(kernel, job, &nonce, &hashes, KAT_TIMEOUT_MS, true, &first, &bad)) {
+        Serial.printf("[KERNEL] %s: KAT timed out at %08x\n", kernel->name, nonce);
+        return false;
+    }
+    if (bad || first != KAT_NONCE) {
+        Serial.printf("[KERNEL] %s: KAT FAILED (candidate %08x, expected %08x)\n",
+                      kernel->name, first, KAT_NONCE);
+        return false;
+    }
+    return true;
+}
+
+// Hashes per second over one timed window, 0 if any candidate is wrong
+static uint32_t kernelRate(const miner_kernel_t *kernel, miner_kernel_job_t *job, uint32_t ms) {
+    uint32_t nonce = esp_random();
+    volatile uint64_t hashes = 0;
+    uint32_t first, bad = 0;
+
+    uint32_t start = micros();
+    runTimed(kernel, job, &nonce, &hashes, ms, false, &first, &bad);
+    uint32_t elapsed = micros() - start;
+
+    if (bad) {
+        Serial.printf("[KERNEL] %s: %u bad candidates, disqualified\n", kernel->name, bad);
+        return 0;
+    }
+    return elapsed ? (uint32_t)(hashes * 1000000ULL / elapsed) : 0;
+}
+
+// Chip model, revision and clock - any change invalidates the cached choice
+static uint32_t tuneKey() {
+    esp_chip_info_t info;
+    esp_chip_info(&info);
+    return ((uint32_t)info.model << 24) | (((uint32_t)info.revision & 0xFF) << 16) |
+           (getCpuFrequencyMhz() & 0xFFFF);
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void miner_kernel_load(const miner_kernel_t *kernel, miner_kernel_job_t *job,
+                       const uint32_t *header_swapped) {
+    if (job->header_swapped != header_swapped) {
+        memcpy(job->header_swapped, header_swapped, sizeof(job->header_swapped));
+    }
+    kernel->prepare(job);
+}
+
+size_t miner_kernel_count() {
+    return KERNEL_COUNT;
+}
+
+const miner_kernel_t *miner_kernel_get(size_t index) {
+    return index < KERNEL_COUNT ? &s_kernels[index] : NULL;
+}
+
+uint32_t miner_kernel_measure(const miner_kernel_t *kernel, uint32_t ms) {
+    miner_kernel_job_t job;
+    katJob(&job);
+    if (!kernelKat(kernel, &job)) return 0;
+    return kernelRate(kernel, &job, ms);
+}
+
+const miner_kernel_t *miner_kernel_select() {
+    miner_kernel_job_t job;
+    katJob(&job);
+
+    uint32_t key = tuneKey();
+    kernel_tune_t tune;
+
+#ifndef KERNEL_AUTOTUNE_FORCE
+    // Cached choice: trust it only after it passes the KAT again
+    if (nvs_kernel_load(&tune) && tune.key == key) {
+        for (size_t i = 0; i < KERNEL_COUNT; i++) {
+            if (strcmp(s_kernels[i].name, tune.kernel) != 0) continue;
+            if (kernelKat(&s_kernels[i], &job)) {
+                Serial.printf("[KERNEL] Using cached kernel %s (%u H/s at tune)\n",
+                              tune.kernel, tune.hashRate);
+                return &s_kernels[i];
+            }
+            break;
+        }
+        Serial.printf("[KERNEL] Cached kernel %s unusable, re-tuning\n", tune.kernel);
+    }
+#endif
+
+    Serial.printf("[KERNEL] Tuning %u kernels (%u ms each)...\n", (unsigned)KERNEL_COUNT, KERNEL_TUNE_MS);
+
+    const miner_kernel_t *best = NULL;
+    uint32_t bestRate = 0;
+    for (size_t i = 0; i < KERNEL_COUNT; i++) {
+        const miner_kernel_t *kernel = &s_kernels[i];
+        if (!kernelKat(kernel, &job)) continue;
+
+        uint32_t rate = kernelRate(kernel, &job, KERNEL_TUNE_MS);
+        Serial.printf("[KERNEL] %s: %u H/s\n", kernel->name, rate);
+        if (rate > bestRate) {
+            bestRate = rate;
+            best = kernel;
+        }
+    }
+
+    if (!best) {
+        Serial.println("[KERNEL] ERROR: No hardware kernel passed the KAT");
+        return NULL;
+    }
+
+    memset(&tune, 0, sizeof(tune));
+    tune.key = key;
+    strncpy(tune.kernel, best->name, sizeof(tune.kernel) - 1);
+    tune.hashRate = bestRate;
+    nvs_kernel_save(&tune);
+
+    Serial.printf("[KERNEL] Selected %s (%u H/s)\n", best->name, bestRate);
+    return best;
+}
+
+#else // !MINER_HAS_HW_KERNELS
+
+size_t miner_kernel_count() {
+    return 0;
+}
+
+const miner_kernel_t *miner_kernel_get(size_t index) {
+    return NULL;
+}
+
+uint32_t miner_kernel_measure(const miner_kernel_t *kernel, uint32_t ms) {
+    return 0;
+}
+
+const miner_kernel_t *miner_kernel_select() {
+    return NULL;
+}
+
+void miner_kernel_load(const miner_kernel_t *kernel, miner_kernel_job_t *job,
+                       const uint32_t *header_swapped) {
+    memcpy(job->header_swapped, header_swapped, sizeof(job->header_swapped));
+    if (kernel) kernel->prepare(job);
+}
+
+#endif // MINER_HAS_HW_KERNELS
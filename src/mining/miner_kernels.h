@@ -0,0 +1,113 @@
+/*
+ * SparkMiner - Hardware Mining Kernel Registry
+ * Uniform interface over the Core 1 pipelined SHA kernels, with
+ * boot-time auto-tuning and an NVS cache of the selected kernel
+ *
+ * Kernels available per target:
+ *   ESP32:    v1, v2, v3 (sha256_pipelined_mine*)
+ *   ESP32-S3: s3v1, s3v2, s3v3 (sha256_pipelined_mine_s3*)
+ *   ESP32-C3: c3v1 (sha256_pipelined_mine_c3), c3ll (sha256_ll reference loop)
+ *   S2:       none - uses the sequential sha256_ll path
+ */
+
+#ifndef MINER_KERNELS_H
+#define MINER_KERNELS_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+// Hardware kernels: the Xtensa targets, plus the C3 (whose only core runs them)
+#if defined(CONFIG_IDF_TARGET_ESP32) || defined(CONFIG_IDF_TARGET_ESP32S3) || \
+    defined(CONFIG_IDF_TARGET_ESP32C3)
+    #define MINER_HAS_HW_KERNELS 1
+#else
+    #define MINER_HAS_HW_KERNELS 0
+#endif
+
+#define KERNEL_NAME_LEN 16
+#define KERNEL_CANDIDATES   8   // Candidates a kernel may list per run
+
+/**
+ * Job as seen by a hardware kernel
+ * header_swapped is filled by the caller; prepare() derives the rest
+ */
+typedef struct {
+    uint32_t header_swapped[20];    // Whole header in SHA message-word order
+    uint32_t midstate[8];           // Hardware midstate (midstate kernels only)
+    uint32_t block2[3];             // Block 2 words 0-2 (merkle tail, ntime, nbits)
+} miner_kernel_job_t;
+
+/**
+ * One kernel run: where it starts and the 16-bit candidates it found
+ */
+typedef struct {
+    uint32_t nonce;                         // Next nonce, SHA word order (advanced by the kernel)
+    uint32_t count;                         // Candidates listed (reset by the caller)
+    uint32_t max;                           // Capacity, 1..KERNEL_CANDIDATES
+    uint32_t nonces[KERNEL_CANDIDATES];     // Candidate nonces, SHA word order
+} miner_kernel_batch_t;
+
+/**
+ * Registered hardware kernel
+ * All kernels count nonces in SHA message-word order. The caller must own
+ * the SHA peripheral for both hooks.
+ */
+typedef struct {
+    const char *name;
+
+    /**
+     * Per-job setup, call after header_swapped changes
+     * (midstate, persistent padding words)
+     */
+    void (*prepare)(miner_kernel_job_t *job);
+
+    /**
+     * Hash from batch->nonce, listing 16-bit candidates, until the flag
+     * clears or the kernel's run ends: the first candidate, or
+     * C3_KERNEL_BATCH nonces on the C3
+     * @return Candidates listed (batch->count)
+     */
+    uint32_t (*mine)(const miner_kernel_job_t *job, miner_kernel_batch_t *batch,
+                     volatile uint64_t *hashes, volatile bool *flag);
+} miner_kernel_t;
+
+/**
+ * Select the Core 1 kernel
+ * Uses the NVS cached choice when it was made on this chip revision and
+ * CPU frequency and still passes the known-answer test; otherwise runs
+ * every kernel for KERNEL_TUNE_MS, drops any that disagree with the
+ * software reference and caches the fastest.
+ * Call from the Core 1 mining task with the SHA peripheral owned.
+ *
+ * @return Selected kernel, or NULL if no kernel passed (or none exist)
+ */
+const miner_kernel_t *miner_kernel_select();
+
+/**
+ * Number of kernels registered for this target (0 on S2)
+ */
+size_t miner_kernel_count();
+
+/**
+ * Registered kernel by index, NULL if out of range
+ */
+const miner_kernel_t *miner_kernel_get(size_t index);
+
+/**
+ * Known-answer test plus one timed run, same as auto-tuning does
+ * Caller must own the SHA peripheral.
+ *
+ * @param kernel Kernel to measure
+ * @param ms     Length of the timed window
+ * @return Hashes per second, 0 if the kernel failed the KAT or returned a
+ *         candidate the software reference rejects
+ */
+uint32_t miner_kernel_measure(const miner_kernel_t *kernel, uint32_t ms);
+
+/**
+ * Fill a kernel job from a byte-swapped header and run the kernel's prepare
+ */
+void miner_kernel_load(const miner_kernel_t *kernel, miner_kernel_job_t *job,
+                       const uint32_t *header_swapped);
+
+#endif // MINER_KERNELS_H
@@ -7,7 +7,6 @@
  * the Free Software Foundation, either version 3 of the License, or
  * (at your option) any later version.
  */
-#include <Arduino.h>
 #include <string.h>
 #include "miner_sha256.h"
 
@@ -36,6 +35,14 @@
 #define CM(a, b, c, d, e, f, g, h, i) \
         temp1=WA[h]+S1_1(e)+CH_1(e,f,g)+k[i]+w[i];temp2=S0_1(a)+MAJ_1(a,b,c);WA[d]=WA[d]+temp1;WA[h]=temp1+temp2
 
+// Round with a known message word (rounds where w[i] is padding or zero)
+#define CMW(a, b, c, d, e, f, g, h, i, wv) \
+        temp1=WA[h]+S1_1(e)+CH_1(e,f,g)+k[i]+(wv);temp2=S0_1(a)+MAJ_1(a,b,c);WA[d]=WA[d]+temp1;WA[h]=temp1+temp2
+
+// Message schedule sigma functions
+#define SIG0(x) (RROT((x),7) ^ RROT((x),18) ^ ((x) >> 3))
+#define SIG1(x) (RROT((x),17) ^ RROT((x),19) ^ ((x) >> 10))
+
 #define GET_DATA(v,i) (((uint32_t)(v[i]) << 24) | ((uint32_t)(v[i + 1]) << 16) | ((uint32_t)(v[i + 2]) << 8) | ((uint32_t)(v[i + 3])))
 
 // SHA-256 initial hash values
@@ -509,3 +516,530 @@ bool miner_sha256_header(sha256_hash_t *midpoint, sha256_hash_t *ctx, block_head
 
     return true;
 }
+
+// ============================================================
+// Baked Header Hash (per-job precompute)
+// ============================================================
+
+// Second hash round 0 from the fixed initial state, minus the data word:
+// h3 + T1' and T1' + T2 where T1' = h7 + S1(h4) + CH(h4,h5,h6) + k[0]
+#define DBL_R0_E    0x98c7e2a2
+#define DBL_R0_A    0xfc08884d
+
+void miner_sha256_bake(miner_sha256_bake_t *bake, const sha256_hash_t *midstate, const block_header_t *hb) {
+    WORD temp1, temp2;
+    uint8_t *data = (uint8_t *)hb;
+    WORD WA[8];
+    WORD w[64];
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        bake->midstate[i] = WA[i] = midstate->hash[i];
+    }
+
+    w[0] = bake->w[0] = GET_DATA(data, 64);
+    w[1] = bake->w[1] = GET_DATA(data, 68);
+    w[2] = bake->w[2] = GET_DATA(data, 72);
+
+    // Rounds 0-2 only see the nonce-free words
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 0);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 1);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 2);
+
+    // Round 3 without w[3]: the nonce is added to both outputs later
+    temp1 = WA[4] + S1_1(1) + CH_1(1, 2, 3) + k[3];
+    temp2 = S0_1(5) + MAJ_1(5, 6, 7);
+    WA[0] = WA[0] + temp1;
+    WA[4] = temp1 + temp2;
+
+    for (i = 0; i < 8; i++) {
+        bake->state[i] = WA[i];
+    }
+
+    // w[16] = w[0] + s0(w[1]) + w[9] + s1(w[14]), w[9] = w[14] = 0
+    // w[17] = w[1] + s0(w[2]) + w[10] + s1(w[15]), w[15] = 0x280
+    // w[18] = w[2] + s0(nonce) + w[11] + s1(w[16])
+    // w[19] = nonce + s0(w[4]) + w[12] + s1(w[17]), w[4] = 0x80000000
+    bake->w16 = w[0] + SIG0(w[1]);
+    bake->w17 = w[1] + SIG0(w[2]) + SIG1(0x00000280u);
+    bake->w18 = w[2] + SIG1(bake->w16);
+    bake->w19 = SIG0(0x80000000u) + SIG1(bake->w17);
+}
+
+// Block 2 schedule words 16-63 from a bake
+static inline __attribute__((always_inline)) void baked_schedule(const miner_sha256_bake_t *bake, uint32_t nonce, WORD *w) {
+    // Words 16-31 with the zero padding words dropped
+    w[16] = bake->w16;
+    w[17] = bake->w17;
+    w[18] = bake->w18 + SIG0(nonce);
+    w[19] = bake->w19 + nonce;
+    w[20] = 0x80000000 + SIG1(w[18]);
+    w[21] = SIG1(w[19]);
+    w[22] = 0x00000280 + SIG1(w[20]);
+    w[23] = w[16] + SIG1(w[21]);
+    w[24] = w[17] + SIG1(w[22]);
+    R1_c(25); R1_c(26); R1_c(27); R1_c(28); R1_c(29);
+    w[30] = SIG0(0x00000280u) + w[23] + SIG1(w[28]);
+    w[31] = 0x00000280 + SIG0(w[16]) + w[24] + SIG1(w[29]);
+    R1(32); R1(33); R1(34); R1(35);
+    R1(36); R1(37); R1(38); R1(39); R1(40); R1(41); R1(42); R1(43); R1(44); R1(45);
+    R1(46); R1(47); R1(48); R1(49); R1(50); R1(51); R1(52); R1(53); R1(54); R1(55);
+    R1(56); R1(57); R1(58); R1(59); R1(60); R1(61); R1(62); R1(63);
+}
+
+// Block 2 of the first hash from a bake; leaves the second hash input in w[0..7]
+static inline __attribute__((always_inline)) void baked_first_hash(const miner_sha256_bake_t *bake, uint32_t nonce, WORD *w) {
+    WORD temp1, temp2;
+
+    WORD WA[8] = {
+        bake->state[0] + nonce,
+        bake->state[1],
+        bake->state[2],
+        bake->state[3],
+        bake->state[4] + nonce,
+        bake->state[5],
+        bake->state[6],
+        bake->state[7]
+    };
+
+    // Rounds 4-15 use padding words: w[4] = 0x80000000, w[15] = 0x280
+    CMW(4, 5, 6, 7, 0, 1, 2, 3, 4, 0x80000000);
+    CMW(3, 4, 5, 6, 7, 0, 1, 2, 5, 0);
+    CMW(2, 3, 4, 5, 6, 7, 0, 1, 6, 0);
+    CMW(1, 2, 3, 4, 5, 6, 7, 0, 7, 0);
+
+    CMW(0, 1, 2, 3, 4, 5, 6, 7, 8, 0);
+    CMW(7, 0, 1, 2, 3, 4, 5, 6, 9, 0);
+    CMW(6, 7, 0, 1, 2, 3, 4, 5, 10, 0);
+    CMW(5, 6, 7, 0, 1, 2, 3, 4, 11, 0);
+    CMW(4, 5, 6, 7, 0, 1, 2, 3, 12, 0);
+    CMW(3, 4, 5, 6, 7, 0, 1, 2, 13, 0);
+    CMW(2, 3, 4, 5, 6, 7, 0, 1, 14, 0);
+    CMW(1, 2, 3, 4, 5, 6, 7, 0, 15, 0x00000280);
+
+    baked_schedule(bake, nonce, w);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 16);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 17);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 18);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 19);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 20);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 21);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 22);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 23);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 24);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 25);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 26);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 27);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 28);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 29);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 30);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 31);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 32);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 33);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 34);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 35);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 36);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 37);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 38);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 39);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 40);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 41);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 42);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 43);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 44);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 45);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 46);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 47);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 48);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 49);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 50);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 51);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 52);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 53);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 54);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 55);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 56);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 57);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 58);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 59);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 60);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 61);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 62);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 63);
+
+    // First hash is the second hash input; on little-endian the
+    // BYTESWAP32 + GET_DATA pair cancels, so use the words directly
+    w[0] = WA[0] + bake->midstate[0];
+    w[1] = WA[1] + bake->midstate[1];
+    w[2] = WA[2] + bake->midstate[2];
+    w[3] = WA[3] + bake->midstate[3];
+    w[4] = WA[4] + bake->midstate[4];
+    w[5] = WA[5] + bake->midstate[5];
+    w[6] = WA[6] + bake->midstate[6];
+    w[7] = WA[7] + bake->midstate[7];
+}
+
+// Second hash schedule words 16-60 (61-63 only matter for the full digest)
+static inline __attribute__((always_inline)) void dbl_schedule(WORD *w) {
+    // Schedule with the padding folded in: w[8] = 0x80000000, w[9..14] = 0, w[15] = 0x100
+    w[16] = w[0] + SIG0(w[1]);
+    w[17] = w[1] + SIG0(w[2]) + SIG1(0x00000100u);
+    w[18] = w[2] + SIG0(w[3]) + SIG1(w[16]);
+    w[19] = w[3] + SIG0(w[4]) + SIG1(w[17]);
+    w[20] = w[4] + SIG0(w[5]) + SIG1(w[18]);
+    w[21] = w[5] + SIG0(w[6]) + SIG1(w[19]);
+    w[22] = w[6] + SIG0(w[7]) + 0x00000100 + SIG1(w[20]);
+    w[23] = w[7] + SIG0(0x80000000u) + w[16] + SIG1(w[21]);
+    w[24] = 0x80000000 + w[17] + SIG1(w[22]);
+    R1_c(25); R1_c(26); R1_c(27); R1_c(28); R1_c(29);
+    w[30] = SIG0(0x00000100u) + w[23] + SIG1(w[28]);
+    w[31] = 0x00000100 + SIG0(w[16]) + w[24] + SIG1(w[29]);
+    R1(32); R1(33); R1(34); R1(35);
+    R1(36); R1(37); R1(38); R1(39); R1(40); R1(41); R1(42); R1(43); R1(44); R1(45);
+    R1(46); R1(47); R1(48); R1(49); R1(50); R1(51); R1(52); R1(53); R1(54); R1(55);
+    R1(56); R1(57); R1(58); R1(59); R1(60);
+}
+
+bool miner_sha256_header_baked(const miner_sha256_bake_t *bake, sha256_hash_t *ctx, uint32_t nonce) {
+    WORD temp1, temp2;
+    WORD w[64];
+    WORD WA[8];
+
+    baked_first_hash(bake, nonce, w);
+
+    // Round 0 from the fixed initial state is constant apart from w[0]
+    WA[0] = h0;
+    WA[1] = h1;
+    WA[2] = h2;
+    WA[3] = DBL_R0_E + w[0];
+    WA[4] = h4;
+    WA[5] = h5;
+    WA[6] = h6;
+    WA[7] = DBL_R0_A + w[0];
+
+    dbl_schedule(w);
+    R1(61); R1(62); R1(63);
+
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 1);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 2);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 3);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 4);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 5);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 6);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 7);
+
+    CMW(0, 1, 2, 3, 4, 5, 6, 7, 8, 0x80000000);
+    CMW(7, 0, 1, 2, 3, 4, 5, 6, 9, 0);
+    CMW(6, 7, 0, 1, 2, 3, 4, 5, 10, 0);
+    CMW(5, 6, 7, 0, 1, 2, 3, 4, 11, 0);
+    CMW(4, 5, 6, 7, 0, 1, 2, 3, 12, 0);
+    CMW(3, 4, 5, 6, 7, 0, 1, 2, 13, 0);
+    CMW(2, 3, 4, 5, 6, 7, 0, 1, 14, 0);
+    CMW(1, 2, 3, 4, 5, 6, 7, 0, 15, 0x00000100);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 16);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 17);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 18);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 19);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 20);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 21);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 22);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 23);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 24);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 25);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 26);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 27);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 28);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 29);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 30);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 31);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 32);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 33);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 34);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 35);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 36);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 37);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 38);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 39);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 40);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 41);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 42);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 43);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 44);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 45);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 46);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 47);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 48);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 49);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 50);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 51);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 52);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 53);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 54);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 55);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 56);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 57);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 58);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 59);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 60);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 61);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 62);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 63);
+
+    // Early 16-bit reject - no need to continue if we don't have a good hash
+    ctx->hash[7] = WA[7] + h7;
+    if (ctx->hash[7] & 0xffff) return false;
+
+    // Complete the output hash with byte-swap
+    ctx->hash[0] = BYTESWAP32(WA[0] + h0);
+    ctx->hash[1] = BYTESWAP32(WA[1] + h1);
+    ctx->hash[2] = BYTESWAP32(WA[2] + h2);
+    ctx->hash[3] = BYTESWAP32(WA[3] + h3);
+    ctx->hash[4] = BYTESWAP32(WA[4] + h4);
+    ctx->hash[5] = BYTESWAP32(WA[5] + h5);
+    ctx->hash[6] = BYTESWAP32(WA[6] + h6);
+    ctx->hash[7] = BYTESWAP32(ctx->hash[7]);
+
+    return true;
+}
+
+// Reject-fast check of one nonce: true if it passes the 16-bit check
+static inline __attribute__((always_inline)) bool fast_single(const miner_sha256_bake_t *bake, uint32_t nonce) {
+    WORD temp1, temp2;
+    WORD w[64];
+    WORD WA[8];
+
+    baked_first_hash(bake, nonce, w);
+
+    // Round 0 from the fixed initial state is constant apart from w[0]
+    WA[0] = h0;
+    WA[1] = h1;
+    WA[2] = h2;
+    WA[3] = DBL_R0_E + w[0];
+    WA[4] = h4;
+    WA[5] = h5;
+    WA[6] = h6;
+    WA[7] = DBL_R0_A + w[0];
+
+    dbl_schedule(w);
+
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 1);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 2);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 3);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 4);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 5);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 6);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 7);
+
+    CMW(0, 1, 2, 3, 4, 5, 6, 7, 8, 0x80000000);
+    CMW(7, 0, 1, 2, 3, 4, 5, 6, 9, 0);
+    CMW(6, 7, 0, 1, 2, 3, 4, 5, 10, 0);
+    CMW(5, 6, 7, 0, 1, 2, 3, 4, 11, 0);
+    CMW(4, 5, 6, 7, 0, 1, 2, 3, 12, 0);
+    CMW(3, 4, 5, 6, 7, 0, 1, 2, 13, 0);
+    CMW(2, 3, 4, 5, 6, 7, 0, 1, 14, 0);
+    CMW(1, 2, 3, 4, 5, 6, 7, 0, 15, 0x00000100);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 16);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 17);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 18);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 19);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 20);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 21);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 22);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 23);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 24);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 25);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 26);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 27);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 28);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 29);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 30);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 31);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 32);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 33);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 34);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 35);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 36);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 37);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 38);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 39);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 40);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 41);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 42);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 43);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 44);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 45);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 46);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 47);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 48);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 49);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 50);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 51);
+    CM(4, 5, 6, 7, 0, 1, 2, 3, 52);
+    CM(3, 4, 5, 6, 7, 0, 1, 2, 53);
+    CM(2, 3, 4, 5, 6, 7, 0, 1, 54);
+    CM(1, 2, 3, 4, 5, 6, 7, 0, 55);
+
+    CM(0, 1, 2, 3, 4, 5, 6, 7, 56);
+    CM(7, 0, 1, 2, 3, 4, 5, 6, 57);
+    CM(6, 7, 0, 1, 2, 3, 4, 5, 58);
+    CM(5, 6, 7, 0, 1, 2, 3, 4, 59);
+    // Final word H7 = h7 + e after round 60; rounds 61-63 never touch it,
+    // so only the T1 half of round 60 is needed
+    temp1 = WA[3] + S1_1(0) + CH_1(0, 1, 2) + k[60] + w[60];
+    return !((WA[7] + temp1 + h7) & 0xffff);
+}
+
+bool miner_sha256_header_fast(const miner_sha256_bake_t *bake, sha256_hash_t *ctx, uint32_t nonce) {
+    if (!fast_single(bake, nonce)) return false;
+
+    // Survivor (1 in 65536) - recompute the full digest
+    return miner_sha256_header_baked(bake, ctx, nonce);
+}
+
+// ============================================================
+// Batched Header Hash (2-way interleaved)
+// ============================================================
+
+#if MINER_SHA256_LANES == 2
+
+// Lane-parameterised round helpers; X is the working state array
+#define MAJ_X(X,a,b,c) ((X[a] & X[b]) | (X[c] & (X[a] | X[b])))
+#define CH_X(X,e,f,g) (X[g] ^ (X[e] & (X[f] ^ X[g])))
+#define S1_X(X,e) (RROT(X[e], 6) ^ RROT(X[e],11) ^ RROT(X[e], 25))
+#define S0_X(X,a) (RROT(X[a], 2) ^ RROT(X[a],13) ^ RROT(X[a], 22))
+
+// One round on both lanes; the k[i] load is shared and the two
+// dependency chains are independent, so one lane fills the other's stalls
+#define CM2K(a, b, c, d, e, f, g, h, kwa, kwb) \
+        t1a=WA[h]+S1_X(WA,e)+CH_X(WA,e,f,g)+(kwa);t1b=WB[h]+S1_X(WB,e)+CH_X(WB,e,f,g)+(kwb); \
+        t2a=S0_X(WA,a)+MAJ_X(WA,a,b,c);t2b=S0_X(WB,a)+MAJ_X(WB,a,b,c); \
+        WA[d]=WA[d]+t1a;WB[d]=WB[d]+t1b;WA[h]=t1a+t2a;WB[h]=t1b+t2b
+#define CM2(a, b, c, d, e, f, g, h, i) \
+        kw=k[i];CM2K(a, b, c, d, e, f, g, h, kw+wa[i], kw+wb[i])
+#define CM2W(a, b, c, d, e, f, g, h, i, wv) \
+        kw=k[i]+(wv);CM2K(a, b, c, d, e, f, g, h, kw, kw)
+
+// Eight rounds starting at i (i must be a multiple of 8)
+#define CM2_8(i) \
+        CM2(0, 1, 2, 3, 4, 5, 6, 7, (i)); CM2(7, 0, 1, 2, 3, 4, 5, 6, (i)+1); \
+        CM2(6, 7, 0, 1, 2, 3, 4, 5, (i)+2); CM2(5, 6, 7, 0, 1, 2, 3, 4, (i)+3); \
+        CM2(4, 5, 6, 7, 0, 1, 2, 3, (i)+4); CM2(3, 4, 5, 6, 7, 0, 1, 2, (i)+5); \
+        CM2(2, 3, 4, 5, 6, 7, 0, 1, (i)+6); CM2(1, 2, 3, 4, 5, 6, 7, 0, (i)+7)
+
+// Reject-fast check for nonces n and n + 1, returns a 2-bit candidate mask
+static inline __attribute__((always_inline)) uint32_t fast_pair(const miner_sha256_bake_t *bake, uint32_t n) {
+    WORD t1a, t1b, t2a, t2b, kw;
+    WORD wa[64], wb[64];
+    uint32_t mask = 0;
+    int i;
+
+    baked_schedule(bake, n, wa);
+    baked_schedule(bake, n + 1, wb);
+
+    WORD WA[8], WB[8];
+    for (i = 0; i < 8; i++) {
+        WA[i] = WB[i] = bake->state[i];
+    }
+    WA[0] += n;     WB[0] += n + 1;
+    WA[4] += n;     WB[4] += n + 1;
+
+    // First hash, block 2 rounds 4-63
+    CM2W(4, 5, 6, 7, 0, 1, 2, 3, 4, 0x80000000);
+    CM2W(3, 4, 5, 6, 7, 0, 1, 2, 5, 0);
+    CM2W(2, 3, 4, 5, 6, 7, 0, 1, 6, 0);
+    CM2W(1, 2, 3, 4, 5, 6, 7, 0, 7, 0);
+    CM2W(0, 1, 2, 3, 4, 5, 6, 7, 8, 0);
+    CM2W(7, 0, 1, 2, 3, 4, 5, 6, 9, 0);
+    CM2W(6, 7, 0, 1, 2, 3, 4, 5, 10, 0);
+    CM2W(5, 6, 7, 0, 1, 2, 3, 4, 11, 0);
+    CM2W(4, 5, 6, 7, 0, 1, 2, 3, 12, 0);
+    CM2W(3, 4, 5, 6, 7, 0, 1, 2, 13, 0);
+    CM2W(2, 3, 4, 5, 6, 7, 0, 1, 14, 0);
+    CM2W(1, 2, 3, 4, 5, 6, 7, 0, 15, 0x00000280);
+    CM2_8(16); CM2_8(24); CM2_8(32); CM2_8(40); CM2_8(48); CM2_8(56);
+
+    for (i = 0; i < 8; i++) {
+        wa[i] = WA[i] + bake->midstate[i];
+        wb[i] = WB[i] + bake->midstate[i];
+    }
+    dbl_schedule(wa);
+    dbl_schedule(wb);
+
+    // Second hash, round 0 folded as in miner_sha256_header_baked()
+    WA[0] = WB[0] = h0;
+    WA[1] = WB[1] = h1;
+    WA[2] = WB[2] = h2;
+    WA[3] = DBL_R0_E + wa[0];   WB[3] = DBL_R0_E + wb[0];
+    WA[4] = WB[4] = h4;
+    WA[5] = WB[5] = h5;
+    WA[6] = WB[6] = h6;
+    WA[7] = DBL_R0_A + wa[0];   WB[7] = DBL_R0_A + wb[0];
+
+    CM2(7, 0, 1, 2, 3, 4, 5, 6, 1);
+    CM2(6, 7, 0, 1, 2, 3, 4, 5, 2);
+    CM2(5, 6, 7, 0, 1, 2, 3, 4, 3);
+    CM2(4, 5, 6, 7, 0, 1, 2, 3, 4);
+    CM2(3, 4, 5, 6, 7, 0, 1, 2, 5);
+    CM2(2, 3, 4, 5, 6, 7, 0, 1, 6);
+    CM2(1, 2, 3, 4, 5, 6, 7, 0, 7);
+    CM2W(0, 1, 2, 3, 4, 5, 6, 7, 8, 0x80000000);
+    CM2W(7, 0, 1, 2, 3, 4, 5, 6, 9, 0);
+    CM2W(6, 7, 0, 1, 2, 3, 4, 5, 10, 0);
+    CM2W(5, 6, 7, 0, 1, 2, 3, 4, 11, 0);
+    CM2W(4, 5, 6, 7, 0, 1, 2, 3, 12, 0);
+    CM2W(3, 4, 5, 6, 7, 0, 1, 2, 13, 0);
+    CM2W(2, 3, 4, 5, 6, 7, 0, 1, 14, 0);
+    CM2W(1, 2, 3, 4, 5, 6, 7, 0, 15, 0x00000100);
+    CM2_8(16); CM2_8(24); CM2_8(32); CM2_8(40); CM2_8(48);
+    CM2(0, 1, 2, 3, 4, 5, 6, 7, 56);
+    CM2(7, 0, 1, 2, 3, 4, 5, 6, 57);
+    CM2(6, 7, 0, 1, 2, 3, 4, 5, 58);
+    CM2(5, 6, 7, 0, 1, 2, 3, 4, 59);
+
+    // T1 half of round 60 gives the final H7 (see miner_sha256_header_fast)
+    kw = k[60];
+    t1a = WA[3] + S1_X(WA, 0) + CH_X(WA, 0, 1, 2) + kw + wa[60];
+    t1b = WB[3] + S1_X(WB, 0) + CH_X(WB, 0, 1, 2) + kw + wb[60];
+    if (!((WA[7] + t1a + h7) & 0xffff)) mask |= 1;
+    if (!((WB[7] + t1b + h7) & 0xffff)) mask |= 2;
+
+    return mask;
+}
+
+#endif // MINER_SHA256_LANES == 2
+
+uint32_t miner_sha256_header_batch(const miner_sha256_bake_t *bake, uint32_t nonce, uint32_t count) {
+    uint32_t bitmap = 0;
+    uint32_t i = 0;
+
+    if (count > MINER_SHA256_BATCH_MAX) count = MINER_SHA256_BATCH_MAX;
+
+#if MINER_SHA256_LANES == 2
+    for (; i + 1 < count; i += 2) {
+        bitmap |= fast_pair(bake, nonce + i) << i;
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (fast_single(bake, nonce + i)) bitmap |= 1UL << i;
+    }
+
+    return bitmap;
+}
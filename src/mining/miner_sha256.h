@@ -18,6 +18,32 @@
 extern "C" {
 #endif
 
+// Most nonces one miner_sha256_header_batch() call can check (bitmap width)
+#define MINER_SHA256_BATCH_MAX 32
+
+// Nonces hashed side by side inside a batch (1 or 2)
+// 2 interleaves the rounds of two nonces; faster only where the core has
+// the registers to hold both states, so it is opt-in
+#ifndef MINER_SHA256_LANES
+    #define MINER_SHA256_LANES 1
+#endif
+
+/**
+ * Per-job "bake" for the software double SHA-256
+ * Everything in the second block that does not depend on the nonce:
+ * rounds 0-2, the nonce-free part of round 3, and the constant parts
+ * of message schedule words 16-19.
+ */
+typedef struct {
+    uint32_t midstate[8];   // State after block 1 (added back after block 2)
+    uint32_t state[8];      // Working state after round 3, nonce term not yet added
+    uint32_t w[3];          // Block 2 words 0-2 (merkle tail, ntime, nbits)
+    uint32_t w16;           // Schedule word 16 (constant)
+    uint32_t w17;           // Schedule word 17 (constant)
+    uint32_t w18;           // Schedule word 18 without sigma0(nonce)
+    uint32_t w19;           // Schedule word 19 without nonce
+} miner_sha256_bake_t;
+
 /**
  * Standard SHA-256 hash
  * Output is byte-swapped for little-endian comparison
@@ -49,6 +75,53 @@ void miner_sha256_midstate(sha256_hash_t *ctx, block_header_t *hb);
  */
 bool miner_sha256_header(sha256_hash_t *midpoint, sha256_hash_t *ctx, block_header_t *hb);
 
+/**
+ * Bake the nonce-independent part of the second block for a job
+ * Call after miner_sha256_midstate() and again whenever ntime changes
+ *
+ * @param bake Output baked constants
+ * @param midstate Midstate from miner_sha256_midstate()
+ * @param hb Block header (nonce ignored)
+ */
+void miner_sha256_bake(miner_sha256_bake_t *bake, const sha256_hash_t *midstate, const block_header_t *hb);
+
+/**
+ * Complete double SHA-256 from a baked job
+ * Same result and early 16-bit reject as miner_sha256_header()
+ *
+ * @param bake Baked constants from miner_sha256_bake()
+ * @param ctx Output final hash result
+ * @param nonce Nonce as SHA message word (byte-swapped header nonce)
+ * @return true if hash passes 16-bit check (potential share), false otherwise
+ */
+bool miner_sha256_header_baked(const miner_sha256_bake_t *bake, sha256_hash_t *ctx, uint32_t nonce);
+
+/**
+ * Reject-fast variant of miner_sha256_header_baked()
+ * Stops the second hash after round 60, where the word used by the
+ * 16-bit check is final, and only computes the full digest for survivors
+ *
+ * @param bake Baked constants from miner_sha256_bake()
+ * @param ctx Output final hash result (only written when returning true)
+ * @param nonce Nonce as SHA message word (byte-swapped header nonce)
+ * @return true if hash passes 16-bit check (potential share), false otherwise
+ */
+bool miner_sha256_header_fast(const miner_sha256_bake_t *bake, sha256_hash_t *ctx, uint32_t nonce);
+
+/**
+ * Reject-fast check of up to MINER_SHA256_BATCH_MAX consecutive nonces
+ * Each nonce gets the miner_sha256_header_fast() check, stopping after
+ * round 60; no digest is kept. With MINER_SHA256_LANES 2 (default 1) pairs
+ * of nonces share interleaved rounds. A candidate's digest comes from
+ * hashing it again (Core 0 leaves that to the verify task).
+ *
+ * @param bake Baked constants from miner_sha256_bake()
+ * @param nonce First nonce as SHA message word (byte-swapped header nonce)
+ * @param count Number of nonces (clamped to MINER_SHA256_BATCH_MAX)
+ * @return Bitmap, bit i set if nonce + i passes the 16-bit check
+ */
+uint32_t miner_sha256_header_batch(const miner_sha256_bake_t *bake, uint32_t nonce, uint32_t count);
+
 #ifdef __cplusplus
 }
 #endif
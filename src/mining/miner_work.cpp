@@ -0,0 +1,277 @@
+/*
+ * SparkMiner - Job Building and Target Math
+ * Coinbase/merkle builders, nbits and difficulty conversions
+ *
+ * Based on BitsyMiner by Justin Williams (GPL v3)
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "miner_work.h"
+#include "miner_sha256.h"
+
+// ============================================================
+// Utility Functions
+// ============================================================
+
+static uint8_t decodeHexChar(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 0;
+}
+
+void hexToBytes(uint8_t *out, const char *in, size_t len) {
+    for (size_t i = 0; i < len; i += 2) {
+        out[i/2] = (decodeHexChar(in[i]) << 4) | decodeHexChar(in[i + 1]);
+    }
+}
+
+void encodeExtraNonce(char *dest, size_t len, unsigned long en) {
+    static const char *tbl = "0123456789ABCDEF";
+    dest += len * 2;
+    *dest-- = '\0';
+    while (len--) {
+        *dest-- = tbl[en & 0x0f];
+        *dest-- = tbl[(en >> 4) & 0x0f];
+        en >>= 8;
+    }
+}
+
+void swapBytesInWords(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i += 4) {
+        uint8_t temp = buf[i];
+        buf[i] = buf[i + 3];
+        buf[i + 3] = temp;
+        temp = buf[i + 1];
+        buf[i + 1] = buf[i + 2];
+        buf[i + 2] = temp;
+    }
+}
+
+// ============================================================
+// Notify Decoding
+// ============================================================
+
+// Append a hex field to the coinbase; false if it is odd or does not fit
+static bool appendHex(mining_job_bin_t *job, size_t *len, const char *hex) {
+    size_t hexLen = strlen(hex);
+    if ((hexLen & 1) || *len + hexLen / 2 > sizeof(job->coinbase)) return false;
+    hexToBytes(&job->coinbase[*len], hex, hexLen);
+    *len += hexLen / 2;
+    return true;
+}
+
+bool decodeJobCoinbase(mining_job_bin_t *job, const char *coinb1, const char *extraNonce1,
+                       int extraNonce2Size, const char *coinb2) {
+    size_t len = 0;
+    if (!appendHex(job, &len, coinb1)) return false;
+    if (!appendHex(job, &len, extraNonce1)) return false;
+
+    // ExtraNonce2 - placeholder, filled in per range by createCoinbaseHash()
+    // At most 8 bytes: submissions carry it as hex in a 20-char field
+    if (extraNonce2Size < 0 || extraNonce2Size > 8 ||
+        len + extraNonce2Size > sizeof(job->coinbase)) return false;
+    job->extraNonce2Offset = len;
+    job->extraNonce2Size = extraNonce2Size;
+    memset(&job->coinbase[len], 0, extraNonce2Size);
+    len += extraNonce2Size;
+
+    if (!appendHex(job, &len, coinb2)) return false;
+    job->coinbaseLen = len;
+    return true;
+}
+
+bool decodeJobBranch(mining_job_bin_t *job, const char *hex) {
+    if (job->merkleBranchCount >= STRATUM_MAX_MERKLE || strlen(hex) != 64) return false;
+    // NerdMiner does NOT reverse merkle branches
+    hexToBytes(job->merkleBranches[job->merkleBranchCount++], hex, 64);
+    return true;
+}
+
+bool decodeJobPrevHash(mining_job_bin_t *job, const char *hex) {
+    if (strlen(hex) != 64) return false;
+    hexToBytes(job->prevHash, hex, 64);
+    swapBytesInWords(job->prevHash, 32); // Swap bytes within each 4-byte word (NerdMiner does this)
+    return true;
+}
+
+// ============================================================
+// Target Functions
+// ============================================================
+
+void bits_to_target(uint32_t nBits, uint8_t *target) {
+    uint32_t exponent = nBits >> 24;
+    uint32_t mantissa = nBits & 0x007fffff;
+    if (nBits & 0x00800000) {
+        mantissa |= 0x00800000;
+    }
+    memset(target, 0, 32);
+    if (exponent <= 3) {
+        mantissa >>= 8 * (3 - exponent);
+        memcpy(target, &mantissa, 4);
+    } else {
+        int shift = (exponent - 3);
+        uint32_t *target_ptr = (uint32_t *)(target + shift);
+        *target_ptr = mantissa;
+    }
+}
+
+void divide_256bit_by_double(uint64_t *target, double divisor) {
+    uint64_t result[4] = {0};
+    double remainder = 0.0;
+    
+    // Iterate from MSB (target[3]) to LSB (target[0])
+    for (int i = 3; i >= 0; i--) {
+        // Add carried remainder from upper word (scaled by 2^64)
+        double val = (double)target[i] + remainder * 18446744073709551616.0;
+        
+        double res = val / divisor;
+        
+        // Clamp to prevent overflow (shouldn't happen with diff >= 1)
+        if (res >= 18446744073709551615.0) {
+            result[i] = 0xFFFFFFFFFFFFFFFFULL;
+        } else {
+            result[i] = (uint64_t)res;
+        }
+        
+        remainder = val - ((double)result[i] * divisor);
+    }
+    
+    memcpy(target, result, sizeof(result));
+}
+
+void adjust_target_for_difficulty(uint8_t *pt, uint8_t *bt, double difficulty) {
+    uint64_t target_parts[4];
+    for (int i = 0; i < 4; i++) {
+        target_parts[i] = ((uint64_t)bt[i * 8 + 0]) |
+                          ((uint64_t)bt[i * 8 + 1] << 8) |
+                          ((uint64_t)bt[i * 8 + 2] << 16) |
+                          ((uint64_t)bt[i * 8 + 3] << 24) |
+                          ((uint64_t)bt[i * 8 + 4] << 32) |
+                          ((uint64_t)bt[i * 8 + 5] << 40) |
+                          ((uint64_t)bt[i * 8 + 6] << 48) |
+                          ((uint64_t)bt[i * 8 + 7] << 56);
+    }
+    divide_256bit_by_double(target_parts, difficulty);
+    for (int i = 0; i < 4; i++) {
+        pt[i * 8 + 0] = target_parts[i] & 0xff;
+        pt[i * 8 + 1] = (target_parts[i] >> 8) & 0xff;
+        pt[i * 8 + 2] = (target_parts[i] >> 16) & 0xff;
+        pt[i * 8 + 3] = (target_parts[i] >> 24) & 0xff;
+        pt[i * 8 + 4] = (target_parts[i] >> 32) & 0xff;
+        pt[i * 8 + 5] = (target_parts[i] >> 40) & 0xff;
+        pt[i * 8 + 6] = (target_parts[i] >> 48) & 0xff;
+        pt[i * 8 + 7] = (target_parts[i] >> 56) & 0xff;
+    }
+}
+
+// Check if hash meets target (little-endian comparison from high bytes)
+int check_target(const uint8_t *hash, const uint8_t *target) {
+    for (int i = 31; i >= 0; i--) {
+        if (hash[i] < target[i]) return 1;  // Valid
+        if (hash[i] > target[i]) return 0;  // Invalid
+    }
+    return 1;  // Equal is valid
+}
+
+// ============================================================
+// Merkle Root Calculation
+// ============================================================
+
+// All job-building hashes use the software SHA-256: Core 1 drives the SHA
+// peripheral directly while these run, so the hardware is never ours here.
+static void double_sha256_merkle(uint8_t *dest, uint8_t *buf64) {
+    sha256_hash_t ctx, ctx1;
+    miner_sha256(&ctx, buf64, 64);
+    miner_sha256(&ctx1, ctx.bytes, 32);
+    memcpy(dest, ctx1.bytes, 32);
+}
+
+void calculateMerkleRoot(uint8_t *root, uint8_t *coinbaseHash, const miner_coinbase_t *cb) {
+    uint8_t merklePair[64];
+    memcpy(merklePair, coinbaseHash, 32);
+
+    for (int i = 0; i < cb->branchCount; i++) {
+        memcpy(&merklePair[32], cb->branches[i], 32);
+        // NerdMiner does NOT reverse merkle branches
+
+        double_sha256_merkle(merklePair, merklePair);
+        // NerdMiner does NOT reverse intermediate merkle results
+    }
+    memcpy(root, merklePair, 32);
+}
+
+// Copy what the roll path needs out of the decoded job
+void buildCoinbase(miner_coinbase_t *cb, const mining_job_bin_t *job, uint32_t extraNonce2) {
+    memcpy(cb->coinbase, job->coinbase, job->coinbaseLen);
+    cb->coinbaseLen = job->coinbaseLen;
+    cb->extraNonce2Offset = job->extraNonce2Offset;
+    cb->extraNonce2Size = job->extraNonce2Size;
+    cb->extraNonce2Base = extraNonce2;
+
+    cb->branchCount = job->merkleBranchCount;
+    memcpy(cb->branches, job->merkleBranches, job->merkleBranchCount * 32);
+}
+
+// ExtraNonce2 is big-endian in the coinbase (same order as its hex string)
+static void writeExtraNonce2(uint8_t *coinbase, const miner_coinbase_t *cb, uint32_t extraNonce2) {
+    uint8_t *en2 = &coinbase[cb->extraNonce2Offset + cb->extraNonce2Size];
+    unsigned long en = extraNonce2;
+    for (int i = 0; i < cb->extraNonce2Size; i++) {
+        *--en2 = en & 0xff;
+        en >>= 8;
+    }
+}
+
+void createCoinbaseHash(uint8_t *hash, const miner_coinbase_t *cb, uint32_t extraNonce2) {
+    uint8_t coinbase[STRATUM_COINBASE_LEN];
+    memcpy(coinbase, cb->coinbase, cb->coinbaseLen);
+    writeExtraNonce2(coinbase, cb, extraNonce2);
+
+    // Double SHA256
+    sha256_hash_t ctx, ctx1;
+    miner_sha256(&ctx, coinbase, cb->coinbaseLen);
+    miner_sha256(&ctx1, ctx.bytes, 32);
+    memcpy(hash, ctx1.bytes, 32);
+    // NerdMiner does NOT reverse coinbase hash
+}
+
+size_t padCoinbase(miner_coinbase_t *cb, uint32_t extraNonce2) {
+    // 0x80 marker + 8-byte length, rounded up to whole blocks
+    size_t paddedLen = (cb->coinbaseLen + 9 + 63) & ~(size_t)63;
+    if (paddedLen > sizeof(cb->coinbase)) return 0;
+
+    writeExtraNonce2(cb->coinbase, cb, extraNonce2);
+
+    uint8_t *pad = &cb->coinbase[cb->coinbaseLen];
+    memset(pad, 0, paddedLen - cb->coinbaseLen);
+    pad[0] = 0x80;
+
+    // Message length in bits, big-endian in the last 8 bytes
+    uint64_t bits = (uint64_t)cb->coinbaseLen * 8;
+    for (int i = 0; i < 8; i++) {
+        cb->coinbase[paddedLen - 1 - i] = bits & 0xff;
+        bits >>= 8;
+    }
+    return paddedLen;
+}
+
+// ============================================================
+// Difficulty Calculation
+// ============================================================
+
+double getDifficulty(sha256_hash_t *ctx) {
+    static const double maxTarget = 26959535291011309493156476344723991336010898738574164086137773096960.0;
+    double hashValue = 0.0;
+    for (int i = 0, j = 31; i < 32; i++, j--) {
+        hashValue = hashValue * 256 + ctx->bytes[j];
+    }
+    double difficulty = maxTarget / hashValue;
+    if (isnan(difficulty) || isinf(difficulty)) {
+        difficulty = 0.0;
+    }
+    return difficulty;
+}
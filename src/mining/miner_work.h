@@ -0,0 +1,141 @@
+/*
+ * SparkMiner - Job Building and Target Math
+ * Internal to the mining module, plus field-level notify decoders (the
+ * benchmarks' decoder and the reference for stratum_parse_line()): miner.cpp
+ * builds every job with these, and the native test build checks them
+ * against known blocks
+ *
+ * Based on BitsyMiner by Justin Williams (GPL v3)
+ */
+
+#ifndef MINER_WORK_H
+#define MINER_WORK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sha256_types.h"
+#include "../stratum/stratum_types.h"
+
+/**
+ * Binary coinbase + merkle branches for one job
+ * Copied from the decoded job once; extranonce2 is patched in per range
+ */
+typedef struct {
+    uint8_t coinbase[STRATUM_COINBASE_LEN]; // coinb1 + extranonce1 + extranonce2 + coinb2
+    uint16_t coinbaseLen;               // Total coinbase length in bytes
+    uint16_t extraNonce2Offset;         // Where extranonce2 sits in coinbase[]
+    uint8_t extraNonce2Size;            // Extranonce2 length in bytes
+    uint8_t branchCount;                // Number of merkle branches
+    uint8_t branches[STRATUM_MAX_MERKLE][32];
+    uint32_t extraNonce2Base;           // Random extranonce2 the job started with
+} miner_coinbase_t;
+
+// ============================================================
+// Hex Helpers
+// ============================================================
+
+/**
+ * Decode hex into bytes
+ * @param len Number of hex characters (2 per output byte)
+ */
+void hexToBytes(uint8_t *out, const char *in, size_t len);
+
+/**
+ * Encode an extranonce2 value as uppercase big-endian hex
+ * @param dest Output, at least len * 2 + 1 chars
+ * @param len  Extranonce2 size in bytes
+ */
+void encodeExtraNonce(char *dest, size_t len, unsigned long en);
+
+/**
+ * Reverse the bytes of each 32-bit word in place
+ */
+void swapBytesInWords(uint8_t *buf, size_t len);
+
+// ============================================================
+// Notify Decoding
+// ============================================================
+
+/**
+ * Decode the coinbase parts of a mining.notify into a binary job
+ * Lays out coinb1 | extranonce1 | zeroed extranonce2 | coinb2
+ * @return false if a part has odd length, they do not fit job->coinbase
+ *         or extranonce2 is over 8 bytes
+ */
+bool decodeJobCoinbase(mining_job_bin_t *job, const char *coinb1, const char *extraNonce1,
+                       int extraNonce2Size, const char *coinb2);
+
+/**
+ * Append one merkle branch (64 hex chars) to a binary job
+ * @return false if the branch is malformed or STRATUM_MAX_MERKLE are held
+ */
+bool decodeJobBranch(mining_job_bin_t *job, const char *hex);
+
+/**
+ * Decode the previous block hash into header byte order
+ * @return false unless hex is 64 chars
+ */
+bool decodeJobPrevHash(mining_job_bin_t *job, const char *hex);
+
+// ============================================================
+// Target Math
+// ============================================================
+
+/**
+ * Expand compact nbits into a 256-bit little-endian target
+ */
+void bits_to_target(uint32_t nBits, uint8_t *target);
+
+/**
+ * Divide a 256-bit number (4 little-endian 64-bit limbs) by a double
+ */
+void divide_256bit_by_double(uint64_t *target, double divisor);
+
+/**
+ * Scale a base target by 1/difficulty
+ * @param pt Output target
+ * @param bt Base (difficulty 1) target
+ */
+void adjust_target_for_difficulty(uint8_t *pt, uint8_t *bt, double difficulty);
+
+/**
+ * Compare a hash with a target, both little-endian
+ * @return 1 if hash <= target
+ */
+int check_target(const uint8_t *hash, const uint8_t *target);
+
+/**
+ * Share difficulty of a hash (difficulty 1 = 0x1d00ffff target)
+ * @return Difficulty, 0 for an all-zero hash
+ */
+double getDifficulty(sha256_hash_t *ctx);
+
+// ============================================================
+// Coinbase and Merkle Root
+// ============================================================
+
+/**
+ * Take the job's coinbase and merkle branches from the decoded notify
+ * The extranonce2 bytes are left as a zero placeholder.
+ */
+void buildCoinbase(miner_coinbase_t *cb, const mining_job_bin_t *job, uint32_t extraNonce2);
+
+/**
+ * Double SHA-256 of the coinbase with extranonce2 filled in
+ */
+void createCoinbaseHash(uint8_t *hash, const miner_coinbase_t *cb, uint32_t extraNonce2);
+
+/**
+ * Fill in extranonce2 and append SHA-256 padding in place, so a DMA engine
+ * can hash coinbase[] as is. createCoinbaseHash() still works afterwards:
+ * it patches extranonce2 into its own copy and stops at coinbaseLen.
+ * @return Padded length (multiple of 64), 0 if the padding does not fit
+ */
+size_t padCoinbase(miner_coinbase_t *cb, uint32_t extraNonce2);
+
+/**
+ * Fold the coinbase hash up the merkle branches
+ */
+void calculateMerkleRoot(uint8_t *root, uint8_t *coinbaseHash, const miner_coinbase_t *cb);
+
+#endif // MINER_WORK_H
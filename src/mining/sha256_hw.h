@@ -23,7 +23,8 @@ typedef struct {
     uint8_t buffer[80];     // Full block header (80 bytes)
 } sha256_hw_ctx_t;
 
-// Pre-computed "bake" for a job (unused with hardware SHA, kept for API compat)
+// Pre-computed "bake" for a job (unused with hardware SHA, kept for API compat;
+// the software path bakes with miner_sha256_bake() in miner_sha256.h)
 typedef struct {
     uint32_t data[15];      // Baked constants (unused)
 } sha256_bake_t;
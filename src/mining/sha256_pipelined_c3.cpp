@@ -0,0 +1,160 @@
+/*
+ * SparkMiner - Pipelined Register-Level SHA-256 for ESP32-C3
+ *
+ * Same approach as sha256_pipelined_mine_s3_v3, written in C for RISC-V:
+ * 1. Midstate computed once per job, restored to SHA_H per nonce
+ * 2. Job words cached in CPU registers, not reloaded from RAM per nonce
+ * 3. Padding zeros shared by both hashes (words 9-14) written once per job
+ * 4. Batched SHA_H -> SHA_TEXT copy (all loads, then all stores)
+ * 5. Hash count kept in a register, published once per call
+ *
+ * The C3 SHA peripheral takes message words and returns digest words in
+ * memory byte order (as the IDF HAL writes them), so SHA word order values
+ * are byte-swapped on the way in; the padding and length words below are
+ * already in that order.
+ */
+
+#include <Arduino.h>
+#include <board_config.h>
+#include "sha256_pipelined_c3.h"
+
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+
+// ESP32-C3 SHA Register Addresses
+#define C3_SHA_BASE         0x6003B000
+#define SHA_MODE_REG        (C3_SHA_BASE + 0x00)
+#define SHA_START_REG       (C3_SHA_BASE + 0x10)
+#define SHA_CONTINUE_REG    (C3_SHA_BASE + 0x14)
+#define SHA_BUSY_REG        (C3_SHA_BASE + 0x18)
+#define SHA_H_BASE          (C3_SHA_BASE + 0x40)
+#define SHA_TEXT_BASE       (C3_SHA_BASE + 0x80)
+
+#define SHA2_256_MODE       2
+
+// Padding words in memory byte order
+#define PAD_BYTE            0x00000080  // 0x80 terminator byte
+#define LEN_HEADER          0x80020000  // 640 bits (80-byte header)
+#define LEN_DIGEST          0x00010000  // 256 bits (32-byte first hash)
+
+#define REG32(addr)         (*(volatile uint32_t *)(addr))
+
+static inline void IRAM_ATTR wait_idle(void) {
+    while (REG32(SHA_BUSY_REG)) {
+    }
+}
+
+void IRAM_ATTR sha256_c3_compute_midstate(const uint32_t *block1_swapped, uint32_t *midstate_out) {
+    volatile uint32_t *sha_text = (volatile uint32_t *)SHA_TEXT_BASE;
+    volatile uint32_t *sha_h = (volatile uint32_t *)SHA_H_BASE;
+
+    for (int i = 0; i < 16; i++) {
+        sha_text[i] = __builtin_bswap32(block1_swapped[i]);
+    }
+    REG32(SHA_MODE_REG) = SHA2_256_MODE;
+    REG32(SHA_START_REG) = 1;
+    wait_idle();
+
+    for (int i = 0; i < 8; i++) {
+        midstate_out[i] = sha_h[i];
+    }
+}
+
+void IRAM_ATTR sha256_c3_init_zeros(void) {
+    volatile uint32_t *sha_text = (volatile uint32_t *)SHA_TEXT_BASE;
+    // Block 2 needs words 5-14 zero; the second hash needs 9-14 zero and
+    // overwrites 5-8 with digest words and its 0x80 byte. Only 9-14 can stay.
+    for (int i = 9; i < 15; i++) {
+        sha_text[i] = 0;
+    }
+}
+
+bool IRAM_ATTR sha256_pipelined_mine_c3(
+    const uint32_t *midstate,
+    const uint32_t *block2_words,
+    uint32_t *nonce_ptr,
+    volatile uint64_t *hash_count_ptr,
+    volatile bool *mining_flag
+) {
+    volatile uint32_t *sha_text = (volatile uint32_t *)SHA_TEXT_BASE;
+    volatile uint32_t *sha_h = (volatile uint32_t *)SHA_H_BASE;
+
+    // Job words in registers for the whole batch
+    const uint32_t m0 = midstate[0], m1 = midstate[1], m2 = midstate[2], m3 = midstate[3];
+    const uint32_t m4 = midstate[4], m5 = midstate[5], m6 = midstate[6], m7 = midstate[7];
+    const uint32_t t0 = __builtin_bswap32(block2_words[0]);
+    const uint32_t t1 = __builtin_bswap32(block2_words[1]);
+    const uint32_t t2 = __builtin_bswap32(block2_words[2]);
+
+    uint32_t nonce = *nonce_ptr;
+    uint32_t count = 0;
+    bool candidate = false;
+
+    REG32(SHA_MODE_REG) = SHA2_256_MODE;
+
+    while (count < C3_KERNEL_BATCH) {
+        // ===== Block 2: midstate + tail + nonce =====
+        sha_h[0] = m0;
+        sha_h[1] = m1;
+        sha_h[2] = m2;
+        sha_h[3] = m3;
+        sha_h[4] = m4;
+        sha_h[5] = m5;
+        sha_h[6] = m6;
+        sha_h[7] = m7;
+
+        sha_text[0] = t0;
+        sha_text[1] = t1;
+        sha_text[2] = t2;
+        sha_text[3] = __builtin_bswap32(nonce);
+        sha_text[4] = PAD_BYTE;
+        sha_text[5] = 0;
+        sha_text[6] = 0;
+        sha_text[7] = 0;
+        sha_text[8] = 0;
+        // Words 9-14: persistent zeros from sha256_c3_init_zeros()
+        sha_text[15] = LEN_HEADER;
+
+        REG32(SHA_CONTINUE_REG) = 1;
+        wait_idle();
+
+        // ===== Second hash: batched digest copy =====
+        uint32_t h0 = sha_h[0];
+        uint32_t h1 = sha_h[1];
+        uint32_t h2 = sha_h[2];
+        uint32_t h3 = sha_h[3];
+        uint32_t h4 = sha_h[4];
+        uint32_t h5 = sha_h[5];
+        uint32_t h6 = sha_h[6];
+        uint32_t h7 = sha_h[7];
+        sha_text[0] = h0;
+        sha_text[1] = h1;
+        sha_text[2] = h2;
+        sha_text[3] = h3;
+        sha_text[4] = h4;
+        sha_text[5] = h5;
+        sha_text[6] = h6;
+        sha_text[7] = h7;
+        sha_text[8] = PAD_BYTE;
+        sha_text[15] = LEN_DIGEST;
+
+        REG32(SHA_START_REG) = 1;
+
+        // Bookkeeping overlaps the second hash
+        nonce++;
+        count++;
+        wait_idle();
+
+        // ===== Early reject: digest bytes 30-31 (hash MSBs) must be zero =====
+        if ((sha_h[7] >> 16) == 0) {
+            candidate = true;
+            break;
+        }
+        if (!*mining_flag) break;
+    }
+
+    *nonce_ptr = nonce;
+    *hash_count_ptr += count;
+    return candidate;
+}
+
+#endif // CONFIG_IDF_TARGET_ESP32C3
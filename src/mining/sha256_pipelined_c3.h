@@ -0,0 +1,64 @@
+/*
+ * SparkMiner - Pipelined Register-Level SHA-256 for ESP32-C3
+ */
+#ifndef SHA256_PIPELINED_C3_H
+#define SHA256_PIPELINED_C3_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(CONFIG_IDF_TARGET_ESP32C3)
+
+/**
+ * Compute midstate from block 1 (first 64 bytes of header).
+ * Call this ONCE per job (and after every block-1 roll).
+ *
+ * @param block1_swapped First 16 words of header (byte-swapped, SHA word order)
+ * @param midstate_out   Output: 8 words, in SHA_H register format
+ */
+void sha256_c3_compute_midstate(
+    const uint32_t *block1_swapped,
+    uint32_t *midstate_out
+);
+
+/**
+ * Initialize the SHA_TEXT padding words both hashes leave at zero (9-14).
+ * Call once per job and whenever something else may have used the peripheral.
+ */
+void sha256_c3_init_zeros(void);
+
+/**
+ * Pipelined mining loop for the ESP32-C3 SHA peripheral.
+ * - Midstate and block 2 template held in registers for the whole batch
+ * - Padding words 9-14 persistent (see sha256_c3_init_zeros)
+ * - SHA_H -> SHA_TEXT copy batched: eight loads, then eight stores
+ * - 16-bit early reject on the final digest inside the loop
+ * Returns after at most C3_KERNEL_BATCH nonces so the single core can yield.
+ *
+ * @param midstate       Midstate from sha256_c3_compute_midstate
+ * @param block2_words   Block 2 words 0-2 (merkle tail, timestamp, nbits), SHA word order
+ * @param nonce_ptr      Nonce in SHA word order (updated on return, past any candidate)
+ * @param hash_count_ptr Hash counter (added to once on return)
+ * @param mining_flag    Mining active flag
+ *
+ * @return true if potential share found (16-bit early reject passed)
+ */
+bool sha256_pipelined_mine_c3(
+    const uint32_t *midstate,
+    const uint32_t *block2_words,
+    uint32_t *nonce_ptr,
+    volatile uint64_t *hash_count_ptr,
+    volatile bool *mining_flag
+);
+
+#endif // CONFIG_IDF_TARGET_ESP32C3
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SHA256_PIPELINED_C3_H
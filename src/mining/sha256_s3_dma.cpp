@@ -1,65 +1,115 @@
 #include <Arduino.h>
 #include "sha256_s3_dma.h"
-#include <mbedtls/sha256.h>
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
+
+#include <sha/sha_dma.h>
 #include <string.h>
+#include "miner_work.h"
 
-void sha256_s3_dma_test() {
-    Serial.println("[SHA-DMA] Starting Self-Test (mbedtls)...");
-
-    const char *inputs[] = { "", "abc" };
-    // SHA-256("")
-    const char *expected_0 = "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855";
-    // SHA-256("abc")
-    const char *expected_1 = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
-
-    const char *expected[] = { expected_0, expected_1 };
-
-    for (int i = 0; i < 2; i++) {
-        unsigned char output[32];
-        mbedtls_sha256_context ctx;
-        mbedtls_sha256_init(&ctx);
-        
-        // Use _ret variants for better error handling and compatibility with newer IDF
-        int ret = 0;
-        if ((ret = mbedtls_sha256_starts_ret(&ctx, 0)) != 0) {
-             Serial.printf("[SHA-DMA] mbedtls_sha256_starts_ret failed: -0x%04x\n", -ret);
-             mbedtls_sha256_free(&ctx);
-             continue;
-        }
-        
-        if ((ret = mbedtls_sha256_update_ret(&ctx, (const unsigned char*)inputs[i], strlen(inputs[i]))) != 0) {
-             Serial.printf("[SHA-DMA] mbedtls_sha256_update_ret failed: -0x%04x\n", -ret);
-             mbedtls_sha256_free(&ctx);
-             continue;
-        }
-        
-        if ((ret = mbedtls_sha256_finish_ret(&ctx, output)) != 0) {
-             Serial.printf("[SHA-DMA] mbedtls_sha256_finish_ret failed: -0x%04x\n", -ret);
-             mbedtls_sha256_free(&ctx);
-             continue;
-        }
-        
-        mbedtls_sha256_free(&ctx);
+// Second hash of a double SHA-256: the 32-byte digest plus its fixed
+// padding, one block the engine reads straight after the digest lands
+static void initDigestBlock(uint8_t *block) {
+    memset(block + 32, 0, 32);
+    block[32] = 0x80;
+    block[62] = 0x01;   // 256-bit message
+}
+
+// One DMA pass from the initial hash values; digest left in SHA_H
+static inline bool dmaHash(const void *padded, size_t len) {
+    return esp_sha_dma(SHA2_256, padded, len, NULL, 0, true) == 0;
+}
+
+bool sha256_s3_dma_double(uint8_t *hash, const uint8_t *padded, size_t len) {
+    uint32_t second[16];
+    initDigestBlock((uint8_t *)second);
+
+    if (!dmaHash(padded, len)) return false;
+    esp_sha_read_digest_state(SHA2_256, second);
+    if (!dmaHash(second, 64)) return false;
+    esp_sha_read_digest_state(SHA2_256, second);
+
+    memcpy(hash, second, 32);
+    return true;
+}
+
+bool sha256_s3_dma_merkle_root(uint8_t *root, const uint8_t *coinbaseHash,
+                               const uint8_t (*branches)[32], int count) {
+    // Left | right | padding block of a 64-byte message
+    uint32_t pair[32];
+    uint32_t second[16];
+    uint8_t *pairBytes = (uint8_t *)pair;
+
+    memcpy(pairBytes, coinbaseHash, 32);
+    memset(pairBytes + 64, 0, 64);
+    pairBytes[64] = 0x80;
+    pairBytes[126] = 0x02;  // 512-bit message
+    initDigestBlock((uint8_t *)second);
+
+    for (int i = 0; i < count; i++) {
+        memcpy(pairBytes + 32, branches[i], 32);
+        if (!dmaHash(pair, 128)) return false;
+        esp_sha_read_digest_state(SHA2_256, second);
+        if (!dmaHash(second, 64)) return false;
+        // Digest becomes the left half of the next level
+        esp_sha_read_digest_state(SHA2_256, pair);
+    }
 
-        Serial.printf("[SHA-DMA] Test '%s': ", inputs[i]);
-        bool match = true;
-        char buf[65];
+    memcpy(root, pair, 32);
+    return true;
+}
+
+// ============================================================
+// Self-Test
+// ============================================================
+
+// A coinbase that spans a few blocks and a realistic merkle depth
+#define DMA_TEST_COINBASE_LEN   300
+#define DMA_TEST_BRANCHES       12
+
+bool sha256_s3_dma_init(void) {
+    static miner_coinbase_t cb;
+    uint32_t seed = 0x5eed1234;
+
+    memset(&cb, 0, sizeof(cb));
+    for (int i = 0; i < DMA_TEST_COINBASE_LEN; i++) {
+        seed = seed * 1103515245 + 12345;
+        cb.coinbase[i] = seed >> 16;
+    }
+    cb.coinbaseLen = DMA_TEST_COINBASE_LEN;
+    cb.extraNonce2Offset = 120;
+    cb.extraNonce2Size = 4;
+    cb.branchCount = DMA_TEST_BRANCHES;
+    for (int i = 0; i < DMA_TEST_BRANCHES; i++) {
         for (int j = 0; j < 32; j++) {
-            sprintf(buf + j*2, "%02x", output[j]);
-        }
-        
-        if (strcmp(buf, expected[i]) != 0) {
-             match = false;
-        }
-        
-        Serial.printf("%s %s\n", buf, match ? "PASS" : "FAIL");
-        if (!match) {
-            Serial.printf("Expected: %s\n", expected[i]);
+            seed = seed * 1103515245 + 12345;
+            cb.branches[i][j] = seed >> 16;
         }
     }
-}
 
-void sha256_s3_dma_init() {
-    Serial.println("[SHA-DMA] Initializing...");
-    sha256_s3_dma_test();
+    // Software reference first: padCoinbase() writes past coinbaseLen only
+    uint8_t swHash[32], swRoot[32];
+    createCoinbaseHash(swHash, &cb, 0xdeadbeef);
+    calculateMerkleRoot(swRoot, swHash, &cb);
+
+    uint8_t dmaHashOut[32], dmaRoot[32];
+    size_t paddedLen = padCoinbase(&cb, 0xdeadbeef);
+    esp_sha_acquire_hardware();
+    bool ok = sha256_s3_dma_double(dmaHashOut, cb.coinbase, paddedLen) &&
+              sha256_s3_dma_merkle_root(dmaRoot, dmaHashOut, cb.branches, cb.branchCount);
+    esp_sha_release_hardware();
+
+    if (!ok) {
+        Serial.println("[SHA-DMA] DMA engine error - job builds use software SHA");
+        return false;
+    }
+    if (memcmp(swHash, dmaHashOut, 32) != 0 || memcmp(swRoot, dmaRoot, 32) != 0) {
+        Serial.println("[SHA-DMA] Self-test FAIL - job builds use software SHA");
+        return false;
+    }
+
+    Serial.println("[SHA-DMA] Self-test PASS - coinbase and merkle hashing on the DMA engine");
+    return true;
 }
+
+#endif // CONFIG_IDF_TARGET_ESP32S3
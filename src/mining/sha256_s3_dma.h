@@ -1,17 +1,44 @@
 #pragma once
 #include <stdint.h>
 #include <stddef.h>
+#include <stdbool.h>
+
+#ifdef CONFIG_IDF_TARGET_ESP32S3
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-// Initialize and test the DMA-based SHA-256 implementation
-void sha256_s3_dma_init(void);
+// Job-build hashing on the S3 SHA DMA engine: the peripheral reads whole
+// padded messages from RAM instead of the CPU feeding SHA_TEXT block by block.
+// All calls except sha256_s3_dma_init() must hold esp_sha_acquire_hardware().
+
+/**
+ * Check the DMA path against the software SHA-256 (coinbase and merkle)
+ * Acquires the peripheral itself; call before the mining tasks start
+ * @return true if job builds can use the DMA engine
+ */
+bool sha256_s3_dma_init(void);
 
-// Run self-tests with known test vectors
-void sha256_s3_dma_test(void);
+/**
+ * Double SHA-256 of an already padded message (see padCoinbase())
+ * @param hash   Output, 32 bytes
+ * @param padded Message with SHA-256 padding, in internal RAM
+ * @param len    Padded length, a multiple of 64
+ * @return false if the DMA engine reported an error (hash not written)
+ */
+bool sha256_s3_dma_double(uint8_t *hash, const uint8_t *padded, size_t len);
+
+/**
+ * Fold a coinbase hash up the merkle branches, two DMA passes per level
+ * Same result as calculateMerkleRoot()
+ * @return false if the DMA engine reported an error (root not written)
+ */
+bool sha256_s3_dma_merkle_root(uint8_t *root, const uint8_t *coinbaseHash,
+                               const uint8_t (*branches)[32], int count);
 
 #ifdef __cplusplus
 }
 #endif
+
+#endif // CONFIG_IDF_TARGET_ESP32S3
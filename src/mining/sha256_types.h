@@ -10,7 +10,14 @@
 
 #include <stdint.h>
 #include <stddef.h>
+
+#ifdef ARDUINO
 #include <Arduino.h>
+#else
+// Native (host) build: ESP-IDF memory placement attributes are no-ops
+#define DRAM_ATTR
+#define IRAM_ATTR
+#endif
 
 // SHA-256 hash result (256 bits = 32 bytes = 8 x 32-bit words)
 typedef union {
@@ -0,0 +1,387 @@
+/*
+ * SparkMiner - Keep-Alive HTTP Client
+ * See http_client.h.
+ */
+
+#include <ctype.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include "http_client.h"
+
+#define HTTP_LINE_MAX       256     // Status/header line kept (longer lines are cut)
+#define HTTP_DRAIN_MAX      2048    // Unread body skipped to keep a connection; more and it is closed
+
+// ============================================================
+// Connections
+// ============================================================
+
+typedef struct {
+    WiFiClient *client;
+    bool tls;
+    char host[64];                  // Connected host ("" = slot free)
+    uint16_t port;
+    uint32_t lastUsed;
+} http_conn_t;
+
+// Plain slots serve the proxy and the HTTP APIs; the single TLS slot is
+// only used for direct HTTPS (enable_https_stats) and holds its mbedtls
+// buffers while kept alive
+static WiFiClient s_plainClients[HTTP_PLAIN_CONNS];
+static WiFiClientSecure s_tlsClient;
+static http_conn_t s_conns[HTTP_PLAIN_CONNS + 1];
+static bool s_connsReady = false;
+static uint32_t s_reused = 0;
+
+static void connsInit() {
+    if (s_connsReady) return;
+    for (int i = 0; i < HTTP_PLAIN_CONNS; i++) {
+        s_conns[i].client = &s_plainClients[i];
+    }
+    s_conns[HTTP_PLAIN_CONNS].client = &s_tlsClient;
+    s_conns[HTTP_PLAIN_CONNS].tls = true;
+    s_tlsClient.setInsecure();
+    s_connsReady = true;
+}
+
+static void connClose(http_conn_t *conn) {
+    conn->client->stop();
+    conn->host[0] = '\0';
+}
+
+// Connection to host:port: a kept-alive one if still open, else a new one
+// in a free or the least recently used slot
+static http_conn_t *connOpen(const char *host, uint16_t port, bool tls, bool *reused) {
+    connsInit();
+    uint32_t now = millis();
+    http_conn_t *pick = NULL;
+
+    for (int i = 0; i <= HTTP_PLAIN_CONNS; i++) {
+        http_conn_t *conn = &s_conns[i];
+        if (conn->tls != tls) continue;
+        if (conn->host[0] && conn->port == port && strcmp(conn->host, host) == 0) {
+            if (conn->client->connected()) {
+                *reused = true;
+                return conn;
+            }
+            pick = conn;
+            break;
+        }
+        if (!pick || !conn->host[0] || (pick->host[0] && now - conn->lastUsed > now - pick->lastUsed)) {
+            pick = conn;
+        }
+    }
+
+    *reused = false;
+    connClose(pick);
+    vTaskDelay(1);  // Yield before a connect (and SSL handshake)
+
+    // connect() is not virtual: call the TLS client's own
+    int ok = tls ? s_tlsClient.connect(host, port, HTTP_TIMEOUT_MS)
+                 : pick->client->connect(host, port, HTTP_TIMEOUT_MS);
+    if (!ok) return NULL;
+
+    strncpy(pick->host, host, sizeof(pick->host) - 1);
+    pick->host[sizeof(pick->host) - 1] = '\0';
+    pick->port = port;
+    pick->lastUsed = now;
+    return pick;
+}
+
+// ============================================================
+// Response Parsing
+// ============================================================
+
+// Next byte, waiting until deadline; -1 on timeout or close
+static int waitByte(Client *client, uint32_t deadline) {
+    while (!client->available()) {
+        if (!client->connected() || (int32_t)(millis() - deadline) >= 0) return -1;
+        vTaskDelay(1);
+    }
+    return client->read();
+}
+
+// One CRLF-terminated line, cut to cap; returns its length or -1
+static int readLine(Client *client, char *buf, size_t cap, uint32_t deadline) {
+    size_t len = 0;
+    while (true) {
+        int c = waitByte(client, deadline);
+        if (c < 0) return -1;
+        if (c == '\n') break;
+        if (c != '\r' && len + 1 < cap) buf[len++] = (char)c;
+    }
+    buf[len] = '\0';
+    return (int)len;
+}
+
+typedef struct {
+    int status;
+    int32_t length;                 // Content-Length (-1 = not given)
+    bool chunked;
+    bool keepAlive;
+} http_response_t;
+
+static bool readHeaders(Client *client, http_response_t *resp) {
+    uint32_t deadline = millis() + HTTP_TIMEOUT_MS;
+    char line[HTTP_LINE_MAX];
+
+    // "HTTP/1.1 200 OK"
+    if (readLine(client, line, sizeof(line), deadline) < 9 || strncmp(line, "HTTP/1.", 7) != 0) return false;
+    resp->status = atoi(line + 9);
+    resp->keepAlive = line[7] == '1';
+    resp->length = -1;
+    resp->chunked = false;
+
+    int n;
+    while ((n = readLine(client, line, sizeof(line), deadline)) > 0) {
+        for (char *p = line; *p; p++) *p = tolower((unsigned char)*p);
+        if (strncmp(line, "content-length:", 15) == 0) {
+            resp->length = atol(line + 15);
+        } else if (strncmp(line, "transfer-encoding:", 18) == 0) {
+            resp->chunked = strstr(line + 18, "chunked") != NULL;
+        } else if (strncmp(line, "connection:", 11) == 0) {
+            if (strstr(line + 11, "close")) resp->keepAlive = false;
+            else if (strstr(line + 11, "keep-alive")) resp->keepAlive = true;
+        }
+    }
+    if (resp->status == 204 || resp->status == 304) resp->length = 0;
+    return n == 0;
+}
+
+// Response body as a Stream (Content-Length, chunked or until close), so
+// ArduinoJson can parse it in place and the connection can be reused after
+class HttpBody : public Stream {
+public:
+    HttpBody(Client *client, const http_response_t *resp)
+        : _client(client), _remaining(resp->chunked ? 0 : resp->length), _chunked(resp->chunked),
+          _first(true), _done(!resp->chunked && resp->length == 0), _peeked(-1),
+          _deadline(millis() + HTTP_TIMEOUT_MS) {}
+
+    int available() override {
+        if (_peeked >= 0) return 1;
+        if (_done) return 0;
+        int avail = _client->available();
+        return (_remaining > 0 && avail > _remaining) ? _remaining : avail;
+    }
+
+    int read() override {
+        if (_peeked >= 0) {
+            int c = _peeked;
+            _peeked = -1;
+            return c;
+        }
+        if (_done) return -1;
+        if (_remaining == 0) {
+            if (!_chunked) {
+                _done = true;
+                return -1;
+            }
+            if (!nextChunk()) return -1;
+        }
+        int c = waitByte(_client, _deadline);
+        if (c < 0) {
+            if (_remaining < 0) _done = true;   // Until-close body ended
+            return -1;
+        }
+        if (_remaining > 0) _remaining--;
+        return c;
+    }
+
+    int peek() override {
+        if (_peeked < 0) _peeked = read();
+        return _peeked;
+    }
+
+    size_t write(uint8_t) override { return 0; }
+
+    // Skip up to max unread bytes; true if the body ended cleanly
+    bool finish(size_t max) {
+        while (!_done && max-- > 0) {
+            if (read() < 0 && !_done) return false;
+        }
+        return _done;
+    }
+
+private:
+    bool nextChunk() {
+        char line[24];
+        if (!_first && readLine(_client, line, sizeof(line), _deadline) != 0) return false;  // CRLF after data
+        _first = false;
+        if (readLine(_client, line, sizeof(line), _deadline) < 0) return false;
+
+        long size = strtol(line, NULL, 16);
+        if (size > 0) {
+            _remaining = size;
+            return true;
+        }
+
+        // Last chunk: skip trailers up to the blank line
+        int n;
+        while ((n = readLine(_client, line, sizeof(line), _deadline)) > 0) {}
+        _done = n == 0;
+        return false;
+    }
+
+    Client *_client;
+    int32_t _remaining;             // Left in the body or current chunk (-1 = until close)
+    bool _chunked;
+    bool _first;                    // No chunk read yet
+    bool _done;
+    int _peeked;
+    uint32_t _deadline;
+};
+
+// ============================================================
+// Requests
+// ============================================================
+
+typedef struct {
+    bool tls;
+    char host[64];
+    uint16_t port;
+    const char *path;               // Points into the URL
+} http_url_t;
+
+static bool parseUrl(const char *url, http_url_t *out) {
+    const char *p;
+    if (strncmp(url, "http://", 7) == 0) {
+        out->tls = false;
+        out->port = 80;
+        p = url + 7;
+    } else if (strncmp(url, "https://", 8) == 0) {
+        out->tls = true;
+        out->port = 443;
+        p = url + 8;
+    } else {
+        return false;
+    }
+
+    const char *end = p + strcspn(p, ":/");
+    size_t len = end - p;
+    if (len == 0 || len >= sizeof(out->host)) return false;
+    memcpy(out->host, p, len);
+    out->host[len] = '\0';
+
+    if (*end == ':') {
+        out->port = atoi(end + 1);
+        end += strcspn(end, "/");
+    }
+    out->path = *end ? end : "/";
+    return out->port > 0;
+}
+
+// Send a GET and read the response headers; the returned connection is
+// positioned at the body. A kept-alive connection the server has closed
+// in the meantime is retried once on a fresh one.
+static http_conn_t *sendRequest(const char *url, const http_proxy_t *proxy, http_response_t *resp) {
+    http_url_t target;
+    if (!parseUrl(url, &target)) {
+        resp->status = HTTP_ERR_URL;
+        return NULL;
+    }
+
+    char hostHeader[72];
+    bool defaultPort = target.port == (target.tls ? 443 : 80);
+    snprintf(hostHeader, sizeof(hostHeader), defaultPort ? "%s" : "%s:%u", target.host, target.port);
+
+    bool auth = proxy && proxy->auth && proxy->auth[0];
+    char req[512];
+    int len = snprintf(req, sizeof(req),
+        "GET %s HTTP/1.1\r\n"
+        "Host: %s\r\n"
+        "%s%s%s"
+        "User-Agent: SparkMiner/1.0 ESP32\r\n"
+        "Accept: application/json\r\n"
+        "Connection: keep-alive\r\n\r\n",
+        proxy ? url : target.path, hostHeader,
+        auth ? "Proxy-Authorization: Basic " : "", auth ? proxy->auth : "", auth ? "\r\n" : "");
+    if (len < 0 || len >= (int)sizeof(req)) {
+        resp->status = HTTP_ERR_URL;
+        return NULL;
+    }
+
+    const char *host = proxy ? proxy->host : target.host;
+    uint16_t port = proxy ? proxy->port : target.port;
+    bool tls = proxy ? false : target.tls;
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        bool reused;
+        http_conn_t *conn = connOpen(host, port, tls, &reused);
+        if (!conn) {
+            resp->status = HTTP_ERR_CONNECT;
+            return NULL;
+        }
+        if (conn->client->write((const uint8_t *)req, len) == (size_t)len &&
+            readHeaders(conn->client, resp)) {
+            if (reused) s_reused++;
+            return conn;
+        }
+        connClose(conn);
+        if (!reused) break;
+    }
+    resp->status = HTTP_ERR_RESPONSE;
+    return NULL;
+}
+
+// Keep the connection for the next request only if the body was consumed
+static void finishResponse(http_conn_t *conn, HttpBody &body, const http_response_t *resp) {
+    conn->lastUsed = millis();
+    bool delimited = resp->chunked || resp->length >= 0;
+    if (!resp->keepAlive || !delimited || !body.finish(HTTP_DRAIN_MAX)) {
+        connClose(conn);
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+int http_get_json(const char *url, const http_proxy_t *proxy, JsonDocument &doc, JsonDocument *filter) {
+    http_response_t resp;
+    http_conn_t *conn = sendRequest(url, proxy, &resp);
+    if (!conn) return resp.status;
+
+    HttpBody body(conn->client, &resp);
+    int status = resp.status;
+    if (status == 200) {
+        DeserializationError err = filter
+            ? deserializeJson(doc, body, DeserializationOption::Filter(*filter))
+            : deserializeJson(doc, body);
+        if (err) status = HTTP_ERR_BODY;
+    }
+    finishResponse(conn, body, &resp);
+    return status;
+}
+
+int http_get_text(const char *url, const http_proxy_t *proxy, char *out, size_t cap) {
+    http_response_t resp;
+    out[0] = '\0';
+    http_conn_t *conn = sendRequest(url, proxy, &resp);
+    if (!conn) return resp.status;
+
+    HttpBody body(conn->client, &resp);
+    size_t len = 0;
+    int c;
+    while (len + 1 < cap && (c = body.read()) >= 0) {
+        out[len++] = (char)c;
+    }
+    out[len] = '\0';
+    finishResponse(conn, body, &resp);
+    return resp.status;
+}
+
+void http_close_idle() {
+    if (!s_connsReady) return;
+    uint32_t now = millis();
+    for (int i = 0; i <= HTTP_PLAIN_CONNS; i++) {
+        http_conn_t *conn = &s_conns[i];
+        if (!conn->host[0]) continue;
+        uint32_t idle = conn->tls ? HTTP_TLS_IDLE_MS : HTTP_IDLE_MS;
+        if (now - conn->lastUsed > idle || !conn->client->connected()) {
+            connClose(conn);
+        }
+    }
+}
+
+uint32_t http_reused_count() {
+    return s_reused;
+}
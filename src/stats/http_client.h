@@ -0,0 +1,63 @@
+/*
+ * SparkMiner - Keep-Alive HTTP Client
+ * Minimal HTTP/1.1 GET client for the live stats task. Connections are
+ * kept open per host (or per proxy, which then serves every HTTPS API), so
+ * a refresh costs a request round trip instead of a TCP connect - or, for
+ * direct HTTPS, a TLS handshake on Core 0.
+ *
+ * Not thread-safe: only the stats task uses it.
+ */
+
+#ifndef HTTP_CLIENT_H
+#define HTTP_CLIENT_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#define HTTP_PLAIN_CONNS    3       // Kept-alive plain connections (proxy, HTTP APIs)
+#define HTTP_IDLE_MS        150000  // Close kept-alive connections unused this long (outlives the 2-minute refreshes)
+#define HTTP_TLS_IDLE_MS    30000   // Same for direct HTTPS, whose kept connection holds ~40 KB of TLS buffers
+#define HTTP_TIMEOUT_MS     8000    // Connect / response deadline
+
+// Errors returned instead of a status code
+#define HTTP_ERR_URL        -1      // Not an http:// or https:// URL
+#define HTTP_ERR_CONNECT    -2
+#define HTTP_ERR_RESPONSE   -3      // No or malformed response
+#define HTTP_ERR_BODY       -4      // Body did not parse / arrive in time
+
+/**
+ * HTTP proxy for https:// URLs (GET with an absolute URL; the proxy
+ * fetches the target itself, e.g. with SSL bumping)
+ */
+typedef struct {
+    const char *host;
+    uint16_t port;
+    const char *auth;       // Base64 user:pass for Proxy-Authorization, or ""
+} http_proxy_t;
+
+/**
+ * GET a URL and deserialize its JSON body
+ * @param proxy  Route through this proxy (NULL = connect to the URL's host)
+ * @param filter ArduinoJson filter for large responses (NULL = whole body)
+ * @return HTTP status (body parsed only for 200) or an HTTP_ERR_ code
+ */
+int http_get_json(const char *url, const http_proxy_t *proxy, JsonDocument &doc,
+                  JsonDocument *filter = NULL);
+
+/**
+ * GET a URL into a NUL-terminated buffer (cut to cap)
+ * @return HTTP status or an HTTP_ERR_ code
+ */
+int http_get_text(const char *url, const http_proxy_t *proxy, char *out, size_t cap);
+
+/**
+ * Close connections idle for HTTP_IDLE_MS / HTTP_TLS_IDLE_MS (call periodically)
+ */
+void http_close_idle();
+
+/**
+ * Requests sent on an already open connection since boot
+ */
+uint32_t http_reused_count();
+
+#endif // HTTP_CLIENT_H
@@ -6,17 +6,24 @@
  * - HTTP proxy for HTTPS APIs (avoids SSL on ESP32)
  * - Supports authenticated proxies (user:pass@host:port)
  * - Health monitoring with auto-disable/re-enable
+ *
+ * Requests go through http_client (kept-alive connections per host and
+ * per proxy) and are spread out to stay inside STATS_FETCH_BUDGET_MS of
+ * fetch time per second.
+ *
+ * With USE_STATS_SHARE, boards on one LAN elect a leader that fetches and
+ * multicasts its snapshot (stats_share.h); the others only listen.
  */
 
 #include <Arduino.h>
 #include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
-#include <base64.h>
 #include "live_stats.h"
+#include "http_client.h"
+#include "stats_share.h"
 #include "board_config.h"
 #include "../config/nvs_config.h"
+#include "mem_budget.h"
 
 // ============================================================
 // Globals
@@ -32,6 +39,7 @@ static uint32_t s_lastBlockUpdate = 0;
 static uint32_t s_lastFeesUpdate = 0;
 static uint32_t s_lastPoolUpdate = 0;
 static uint32_t s_lastNetworkUpdate = 0;
+static uint32_t s_lastDifficultyUpdate = 0;
 
 // Proxy state
 static bool s_proxyHealthy = true;
@@ -50,14 +58,52 @@ static bool s_statsEnabled = true;       // Master enable/disable
 static char s_customApiUrl[128] = {0};   // Custom unified stats API endpoint
 static uint32_t s_lastCustomApiUpdate = 0;
 
+// Task and pause state (see live_stats_set_paused)
+static TaskHandle_t s_task = NULL;
+STATIC_TASK(s_statsTask, STATS_STACK);
+static volatile bool s_paused = false;
+
 // Error rate limiting
 static uint32_t s_lastErrorLog = 0;
 static uint32_t s_errorCount = 0;
 
+// Fleet sharing
+#if USE_STATS_SHARE
+static uint32_t s_walletHash = 0;
+static uint32_t s_leaderId = 0;             // Board whose snapshots we apply (0: none yet)
+static uint32_t s_leaderHeard = 0;
+static bool s_leaderPoolMatch = false;      // Leader mines to our wallet
+static bool s_leading = false;
+static uint32_t s_lastShareSent = 0;
+static uint32_t s_leaderTimeout = STATS_LEADER_TIMEOUT_MS;  // Plus per-board jitter
+static uint32_t s_listenUntil = 0;          // Boot: wait for a leader before fetching
+#endif
+
 // ============================================================
 // Proxy URL Parser
 // ============================================================
 
+/**
+ * Base64 "user:pass" into s_proxyAuth for the Proxy-Authorization header
+ */
+static void encodeProxyAuth(const char *userPass) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    const uint8_t *in = (const uint8_t *)userPass;
+    size_t len = strlen(userPass);
+    size_t out = 0;
+
+    for (size_t i = 0; i < len && out + 5 <= sizeof(s_proxyAuth); i += 3) {
+        uint32_t v = (uint32_t)in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        s_proxyAuth[out++] = ALPHABET[(v >> 18) & 0x3f];
+        s_proxyAuth[out++] = ALPHABET[(v >> 12) & 0x3f];
+        s_proxyAuth[out++] = i + 1 < len ? ALPHABET[(v >> 6) & 0x3f] : '=';
+        s_proxyAuth[out++] = i + 2 < len ? ALPHABET[v & 0x3f] : '=';
+    }
+    s_proxyAuth[out] = '\0';
+}
+
 /**
  * Parse proxy configuration in multiple formats:
  *   1. URL format: http://[user:pass@]host:port
@@ -88,9 +134,7 @@ static bool parseProxyUrl(const char *url) {
             authPart[authLen] = '\0';
 
             // Base64 encode for Proxy-Authorization header
-            String encoded = base64::encode((uint8_t*)authPart, strlen(authPart));
-            strncpy(s_proxyAuth, encoded.c_str(), sizeof(s_proxyAuth) - 1);
-            s_proxyAuth[sizeof(s_proxyAuth) - 1] = '\0';
+            encodeProxyAuth(authPart);
 
             hostStart = atSign + 1;
         }
@@ -152,9 +196,7 @@ static bool parseProxyUrl(const char *url) {
             // Build auth string "user:pass" and base64 encode
             char authPart[96];
             snprintf(authPart, sizeof(authPart), "%s:%s", user, pass);
-            String encoded = base64::encode((uint8_t*)authPart, strlen(authPart));
-            strncpy(s_proxyAuth, encoded.c_str(), sizeof(s_proxyAuth) - 1);
-            s_proxyAuth[sizeof(s_proxyAuth) - 1] = '\0';
+            encodeProxyAuth(authPart);
         }
     }
 
@@ -170,11 +212,59 @@ static bool parseProxyUrl(const char *url) {
     return true;
 }
 
+// ============================================================
+// Response Filters
+// ============================================================
+
+// Only these keys survive parsing; everything else is skipped as it streams
+// past, so a refresh needs the same few hundred bytes however large the
+// upstream reply grows (the hashrate API alone sends ~400 KB)
+static const char *const CUSTOM_API_KEYS[] = {
+    "btc_price_usd", "block_height", "network_hashrate", "network_difficulty",
+    "fee_half_hour", "fee_fastest", "fee_hour", "workers", "failovers", "pool_name",
+    "difficulty_progress", "difficulty_change", "difficulty_retarget_blocks",
+    "pool_hashrate", "worker_hashrate", "address_best_diff"
+};
+static const char *const FEES_KEYS[] = { "fastestFee", "halfHourFee", "hourFee" };
+static const char *const POOL_KEYS[] = { "workersCount", "hashrate", "bestDifficulty" };
+static const char *const HASHRATE_KEYS[] = { "currentHashrate", "currentDifficulty" };
+static const char *const DIFFICULTY_KEYS[] = { "progressPercent", "difficultyChange", "remainingBlocks" };
+static const char *const PING_KEYS[] = { "gecko_says" };
+
+#define KEY_COUNT(keys) (sizeof(keys) / sizeof(keys[0]))
+
+// Built once; keys are literals, so each filter is just its object slots
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(CUSTOM_API_KEYS))> s_customFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(FEES_KEYS))> s_feesFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(POOL_KEYS))> s_poolFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(HASHRATE_KEYS))> s_hashrateFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(DIFFICULTY_KEYS))> s_difficultyFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(KEY_COUNT(PING_KEYS))> s_pingFilter;
+static StaticJsonDocument<JSON_OBJECT_SIZE(1) * 2> s_priceFilter;   // {"bitcoin":{"usd":true}}
+
+static void allowKeys(JsonDocument &filter, const char *const *keys, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        filter[keys[i]] = true;
+    }
+}
+
+static void buildFilters() {
+    allowKeys(s_customFilter, CUSTOM_API_KEYS, KEY_COUNT(CUSTOM_API_KEYS));
+    allowKeys(s_feesFilter, FEES_KEYS, KEY_COUNT(FEES_KEYS));
+    allowKeys(s_poolFilter, POOL_KEYS, KEY_COUNT(POOL_KEYS));
+    allowKeys(s_hashrateFilter, HASHRATE_KEYS, KEY_COUNT(HASHRATE_KEYS));
+    allowKeys(s_difficultyFilter, DIFFICULTY_KEYS, KEY_COUNT(DIFFICULTY_KEYS));
+    allowKeys(s_pingFilter, PING_KEYS, KEY_COUNT(PING_KEYS));
+    s_priceFilter["bitcoin"]["usd"] = true;
+}
+
 // ============================================================
 // HTTP Fetch Functions
 // ============================================================
 
-static StaticJsonDocument<2048> s_jsonDoc;
+// Sized for the largest filtered reply (custom API: 16 members with their
+// key and value strings, which are copied out of the stream)
+static StaticJsonDocument<1024> s_jsonDoc;
 
 static void logError(const char *context, int code) {
     s_errorCount++;
@@ -186,39 +276,7 @@ static void logError(const char *context, int code) {
     }
 }
 
-/**
- * Extract hostname from URL (e.g., "https://api.coingecko.com/path" -> "api.coingecko.com")
- */
-static String extractHostFromUrl(const char *url) {
-    const char *start = strstr(url, "://");
-    if (!start) return "";
-    start += 3;  // Skip "://"
-
-    const char *end = strchr(start, '/');
-    if (!end) end = start + strlen(start);
-
-    // Check for port in host
-    const char *colon = strchr(start, ':');
-    if (colon && colon < end) end = colon;
-
-    return String(start).substring(0, end - start);
-}
-
-/**
- * Extract path from URL (e.g., "https://api.coingecko.com/api/v3/..." -> "/api/v3/...")
- */
-static String extractPathFromUrl(const char *url) {
-    const char *start = strstr(url, "://");
-    if (!start) return "/";
-    start += 3;  // Skip "://"
-
-    const char *path = strchr(start, '/');
-    if (!path) return "/";
-
-    return String(path);
-}
-
-// Proxy method preference: 0=auto, 1=GET (SSL bump), 2=CONNECT (tunnel)
+// Proxy method preference: 0=auto, 1=GET (SSL bumping), 2=CONNECT (tunnel)
 static uint8_t s_proxyMethod = 0;
 
 /**
@@ -226,135 +284,17 @@ static uint8_t s_proxyMethod = 0;
  * Request format: GET https://target.com/path HTTP/1.1
  * Requires proxy with SSL bumping (decrypts/re-encrypts HTTPS)
  */
-static bool fetchViaProxyGet(const char *targetUrl, JsonDocument &doc) {
-    WiFiClient client;
-    client.setTimeout(8000);
-
-    if (!client.connect(s_proxyHost, s_proxyPort)) {
-        return false;
-    }
-
-    String targetHost = extractHostFromUrl(targetUrl);
-
-    // Build HTTP request - full URL in request line for SSL bumping proxy
-    String request = "GET ";
-    request += targetUrl;
-    request += " HTTP/1.1\r\n";
-    request += "Host: ";
-    request += targetHost;
-    request += "\r\n";
-
-    if (s_proxyAuth[0]) {
-        request += "Proxy-Authorization: Basic ";
-        request += s_proxyAuth;
-        request += "\r\n";
-    }
-
-    request += "User-Agent: SparkMiner/1.0 ESP32\r\n";
-    request += "Accept: application/json\r\n";
-    request += "Connection: close\r\n\r\n";
-
-    client.print(request);
+static bool fetchViaProxyGet(const char *targetUrl, JsonDocument &doc, JsonDocument *filter) {
+    http_proxy_t proxy = { s_proxyHost, s_proxyPort, s_proxyAuth };
+    int status = http_get_json(targetUrl, &proxy, doc, filter);
+    if (status == 200) return true;
 
-    // Wait for response
-    uint32_t timeout = millis() + 8000;
-    while (client.connected() && !client.available() && millis() < timeout) {
-        vTaskDelay(10 / portTICK_PERIOD_MS);
+    if (status == HTTP_ERR_BODY) {
+        logError("Proxy JSON", status);
+    } else if (status > 0) {
+        Serial.printf("[STATS] Proxy error: %d\n", status);
     }
-
-    if (!client.available()) {
-        client.stop();
-        return false;
-    }
-
-    // Read status line
-    String statusLine = client.readStringUntil('\n');
-    statusLine.trim();
-
-    int statusCode = 0;
-    if (statusLine.startsWith("HTTP/")) {
-        int spaceIdx = statusLine.indexOf(' ');
-        if (spaceIdx > 0) {
-            statusCode = statusLine.substring(spaceIdx + 1).toInt();
-        }
-    }
-
-    if (statusCode != 200) {
-        Serial.printf("[STATS] Proxy error: %d\n", statusCode);
-        client.stop();
-        return false;
-    }
-
-    // Skip headers, look for Content-Length and Transfer-Encoding
-    int contentLength = -1;
-    bool chunked = false;
-    while (client.connected() || client.available()) {
-        if (!client.available()) {
-            vTaskDelay(10 / portTICK_PERIOD_MS);
-            continue;
-        }
-        String line = client.readStringUntil('\n');
-        line.trim();
-        if (line.startsWith("Content-Length:")) {
-            contentLength = line.substring(15).toInt();
-        }
-        if (line.indexOf("chunked") >= 0) {
-            chunked = true;
-        }
-        if (line.length() == 0) break;
-    }
-
-    // Read body with size limit to prevent OOM
-    const int MAX_BODY = 4096;
-    String body;
-    body.reserve(MAX_BODY);
-
-    // Read body - continue while connected OR data available in buffer
-    uint32_t readTimeout = millis() + 5000;
-    while ((client.connected() || client.available()) && (int)body.length() < MAX_BODY && millis() < readTimeout) {
-        if (client.available()) {
-            char c = client.read();
-            body += c;
-        } else {
-            vTaskDelay(1);
-        }
-    }
-    client.stop();
-
-    // Handle chunked transfer encoding
-    if (chunked && body.length() > 0) {
-        String decoded;
-        decoded.reserve(body.length());
-        int pos = 0;
-        while (pos < (int)body.length()) {
-            // Read chunk size (hex)
-            int lineEnd = body.indexOf('\n', pos);
-            if (lineEnd < 0) break;
-            String sizeLine = body.substring(pos, lineEnd);
-            sizeLine.trim();
-            int chunkSize = strtol(sizeLine.c_str(), NULL, 16);
-            if (chunkSize == 0) break;  // End of chunks
-            pos = lineEnd + 1;
-            // Read chunk data
-            if (pos + chunkSize <= (int)body.length()) {
-                decoded += body.substring(pos, pos + chunkSize);
-            }
-            pos += chunkSize + 2;  // Skip data + \r\n
-        }
-        body = decoded;
-    }
-
-    if (body.length() == 0) {
-        Serial.println("[STATS] Proxy: empty response");
-        return false;
-    }
-
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) {
-        logError("Proxy JSON", err.code());
-        return false;
-    }
-    return true;
+    return false;
 }
 
 /**
@@ -380,7 +320,7 @@ static bool fetchViaProxyConnect(const char *targetUrl, JsonDocument &doc) {
  * 1. GET method (SSL bumping) - simpler, lower memory
  * 2. CONNECT method (tunneling) - works without SSL bumping
  */
-static bool fetchViaProxy(const char *targetUrl, JsonDocument &doc) {
+static bool fetchViaProxy(const char *targetUrl, JsonDocument &doc, JsonDocument *filter = NULL) {
     if (!s_proxyConfigured || !s_proxyHealthy) return false;
 
     bool success = false;
@@ -388,7 +328,7 @@ static bool fetchViaProxy(const char *targetUrl, JsonDocument &doc) {
     // Try preferred method first, or auto-detect
     if (s_proxyMethod == 0 || s_proxyMethod == 1) {
         // Try GET method (SSL bumping)
-        success = fetchViaProxyGet(targetUrl, doc);
+        success = fetchViaProxyGet(targetUrl, doc, filter);
         if (success) {
             if (s_proxyMethod == 0) s_proxyMethod = 1;
             s_proxyFailCount = 0;
@@ -413,63 +353,21 @@ static bool fetchViaProxy(const char *targetUrl, JsonDocument &doc) {
 
 /**
  * Fetch URL directly via HTTPS (CPU intensive, may cause issues)
+ * The connection is kept alive, so only the first request pays the handshake
  */
-static bool fetchHttpsDirect(const char *url, JsonDocument &doc) {
-    WiFiClientSecure secureClient;
-    secureClient.setInsecure();
-    secureClient.setTimeout(5000);
-
-    HTTPClient http;
-    http.setUserAgent("SparkMiner/1.0 ESP32");
-    http.setTimeout(5000);
-
-    vTaskDelay(1);  // Yield before SSL handshake
-
-    if (!http.begin(secureClient, url)) {
-        logError("HTTPS connect", -1);
-        return false;
-    }
-
-    int httpCode = http.GET();
+static bool fetchHttpsDirect(const char *url, JsonDocument &doc, JsonDocument *filter) {
+    int status = http_get_json(url, NULL, doc, filter);
+    if (status == 200) return true;
 
-    if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
-        http.end();
-        DeserializationError err = deserializeJson(doc, payload);
-        return !err;
-    }
-
-    logError("HTTPS request", httpCode);
-    http.end();
+    logError("HTTPS request", status);
     return false;
 }
 
 /**
  * Fetch URL via HTTP (no SSL)
  */
-static bool fetchHttp(const char *url, JsonDocument &doc) {
-    WiFiClient client;
-    client.setTimeout(5000);
-
-    HTTPClient http;
-    http.setUserAgent("SparkMiner/1.0 ESP32");
-    http.setTimeout(5000);
-
-    if (!http.begin(client, url)) {
-        return false;
-    }
-
-    int httpCode = http.GET();
-
-    if (httpCode == HTTP_CODE_OK) {
-        String payload = http.getString();
-        http.end();
-        DeserializationError err = deserializeJson(doc, payload);
-        return !err;
-    }
-
-    http.end();
-    return false;
+static bool fetchHttp(const char *url, JsonDocument &doc, JsonDocument *filter = NULL) {
+    return http_get_json(url, NULL, doc, filter) == 200;
 }
 
 /**
@@ -477,21 +375,21 @@ static bool fetchHttp(const char *url, JsonDocument &doc) {
  * For HTTPS URLs: proxy -> direct HTTPS (if enabled) -> skip
  * For HTTP URLs: direct HTTP
  */
-static bool fetchJson(const char *url, JsonDocument &doc) {
+static bool fetchJson(const char *url, JsonDocument &doc, JsonDocument *filter = NULL) {
     bool isHttps = strncmp(url, "https://", 8) == 0;
 
     if (!isHttps) {
         // HTTP - always fetch directly
-        return fetchHttp(url, doc);
+        return fetchHttp(url, doc, filter);
     }
 
     // HTTPS URL - need proxy or enableHttpsStats
     if (s_proxyConfigured && s_proxyHealthy) {
-        return fetchViaProxy(url, doc);
+        return fetchViaProxy(url, doc, filter);
     }
 
     if (s_httpsEnabled) {
-        return fetchHttpsDirect(url, doc);
+        return fetchHttpsDirect(url, doc, filter);
     }
 
     // HTTPS not available - skip silently
@@ -524,7 +422,7 @@ static void checkProxyHealth() {
             s_jsonDoc.clear();
 
             // Use CoinGecko ping endpoint - lightweight HTTPS test
-            if (fetchViaProxy("https://api.coingecko.com/api/v3/ping", s_jsonDoc)) {
+            if (fetchViaProxy("https://api.coingecko.com/api/v3/ping", s_jsonDoc, &s_pingFilter)) {
                 Serial.println("[STATS] Proxy health check passed");
                 s_proxyFailCount = 0;
             } else {
@@ -559,7 +457,7 @@ static bool fetchFromCustomApi() {
     if (s_customApiUrl[0] == '\0') return false;
 
     s_jsonDoc.clear();
-    if (!fetchHttp(s_customApiUrl, s_jsonDoc)) {
+    if (!fetchHttp(s_customApiUrl, s_jsonDoc, &s_customFilter)) {
         logError("Custom API", -1);
         return false;
     }
@@ -692,7 +590,7 @@ static void updatePrice() {
     if (s_proxyConfigured && !s_proxyHealthy) return;
 
     s_jsonDoc.clear();
-    if (fetchJson(API_BTC_PRICE, s_jsonDoc)) {
+    if (fetchJson(API_BTC_PRICE, s_jsonDoc, &s_priceFilter)) {
         if (s_jsonDoc.containsKey("bitcoin")) {
             xSemaphoreTake(s_statsMutex, portMAX_DELAY);
             s_stats.btcPriceUsd = s_jsonDoc["bitcoin"]["usd"];
@@ -706,36 +604,24 @@ static void updatePrice() {
 
 static void updateBlockHeight() {
     // HTTP API - always works
-    WiFiClient client;
-    client.setTimeout(5000);
-
-    HTTPClient http;
-    http.setUserAgent("SparkMiner/1.0");
-    http.setTimeout(5000);
-
-    if (http.begin(client, API_BLOCK_HEIGHT)) {
-        int httpCode = http.GET();
-
-        if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
-            uint32_t height = payload.toInt();
-
-            if (height > 0) {
-                xSemaphoreTake(s_statsMutex, portMAX_DELAY);
-                s_stats.blockHeight = height;
-                s_stats.blockTimestamp = millis();
-                s_stats.blockValid = true;
-                xSemaphoreGive(s_statsMutex);
-            }
+    char payload[16];
+    if (http_get_text(API_BLOCK_HEIGHT, NULL, payload, sizeof(payload)) == 200) {
+        uint32_t height = strtoul(payload, NULL, 10);
+
+        if (height > 0) {
+            xSemaphoreTake(s_statsMutex, portMAX_DELAY);
+            s_stats.blockHeight = height;
+            s_stats.blockTimestamp = millis();
+            s_stats.blockValid = true;
+            xSemaphoreGive(s_statsMutex);
         }
-        http.end();
     }
 }
 
 static void updateFees() {
     // HTTP API - always works
     s_jsonDoc.clear();
-    if (fetchHttp(API_FEES, s_jsonDoc)) {
+    if (fetchHttp(API_FEES, s_jsonDoc, &s_feesFilter)) {
         xSemaphoreTake(s_statsMutex, portMAX_DELAY);
         s_stats.fastestFee = s_jsonDoc["fastestFee"];
         s_stats.halfHourFee = s_jsonDoc["halfHourFee"];
@@ -759,7 +645,7 @@ static void updatePoolStats() {
     snprintf(url, sizeof(url), "%s%s", API_PUBLIC_POOL, s_wallet);
 
     s_jsonDoc.clear();
-    if (fetchJson(url, s_jsonDoc)) {
+    if (fetchJson(url, s_jsonDoc, &s_poolFilter)) {
         xSemaphoreTake(s_statsMutex, portMAX_DELAY);
         s_stats.poolWorkersCount = s_jsonDoc["workersCount"];
         const char *hashrate = s_jsonDoc["hashrate"];
@@ -783,60 +669,9 @@ static void updateNetworkHashrate() {
     if (!s_proxyConfigured && !s_httpsEnabled) return;
     if (s_proxyConfigured && !s_proxyHealthy) return;
 
-    // The hashrate API returns ~400KB response with historical data.
-    // We use a filter to extract only the fields we need, ignoring the "hashrates" array.
-    StaticJsonDocument<128> filter;
-    filter["currentHashrate"] = true;
-    filter["currentDifficulty"] = true;
-
-    WiFiClient client;
-    client.setTimeout(8000);
-
-    if (!client.connect(s_proxyHost, s_proxyPort)) {
-        return;
-    }
-
-    String targetHost = extractHostFromUrl(API_HASHRATE);
-
-    // Build request
-    String request = "GET ";
-    request += API_HASHRATE;
-    request += " HTTP/1.1\r\nHost: ";
-    request += targetHost;
-    request += "\r\n";
-    if (s_proxyAuth[0]) {
-        request += "Proxy-Authorization: Basic ";
-        request += s_proxyAuth;
-        request += "\r\n";
-    }
-    request += "Connection: close\r\n\r\n";
-    client.print(request);
-
-    // Wait for response
-    uint32_t timeout = millis() + 10000;
-    while (client.connected() && !client.available() && millis() < timeout) {
-        vTaskDelay(10 / portTICK_PERIOD_MS);
-    }
-
-    if (!client.available()) {
-        client.stop();
-        return;
-    }
-
-    // Skip HTTP headers
-    while (client.connected() || client.available()) {
-        String line = client.readStringUntil('\n');
-        line.trim();
-        if (line.length() == 0) break;
-    }
-
-    // Parse JSON with filter (ignores hashrates array, saves memory)
+    // ~400KB response with historical data; the filter skips the "hashrates" array
     s_jsonDoc.clear();
-    DeserializationError err = deserializeJson(s_jsonDoc, client, DeserializationOption::Filter(filter));
-    client.stop();
-
-    if (err) {
-        Serial.printf("[STATS] Hashrate parse error: %s\n", err.c_str());
+    if (!fetchJson(API_HASHRATE, s_jsonDoc, &s_hashrateFilter)) {
         return;
     }
 
@@ -875,7 +710,7 @@ static void updateNetworkDifficulty() {
     if (s_proxyConfigured && !s_proxyHealthy) return;
 
     s_jsonDoc.clear();
-    if (fetchJson(API_DIFFICULTY, s_jsonDoc)) {
+    if (fetchJson(API_DIFFICULTY, s_jsonDoc, &s_difficultyFilter)) {
         xSemaphoreTake(s_statsMutex, portMAX_DELAY);
         s_stats.difficultyProgress = s_jsonDoc["progressPercent"];
         s_stats.difficultyChange = s_jsonDoc["difficultyChange"];
@@ -892,6 +727,10 @@ static void updateNetworkDifficulty() {
 
 void live_stats_init() {
     s_statsMutex = xSemaphoreCreateMutex();
+    mem_budget_add("livestats", "JSON + filters", sizeof(s_jsonDoc) + sizeof(s_customFilter) +
+                   sizeof(s_feesFilter) + sizeof(s_poolFilter) + sizeof(s_hashrateFilter) +
+                   sizeof(s_difficultyFilter) + sizeof(s_pingFilter) + sizeof(s_priceFilter));
+    buildFilters();
 
     // Load stats config
     miner_config_t *config = nvs_config_get();
@@ -930,14 +769,14 @@ void live_stats_init() {
     }
 
     // Start background task
-    xTaskCreatePinnedToCore(
+    s_task = mem_task_create(
         live_stats_task,
         "StatsTask",
-        STATS_STACK,
         NULL,
         STATS_PRIORITY,
-        NULL,
-        STATS_CORE
+        STATS_CORE,
+        "livestats",
+        STATIC_TASK_MEM(s_statsTask)
     );
 }
 
@@ -955,9 +794,17 @@ void live_stats_get_copy(live_stats_t *dest) {
 void live_stats_set_wallet(const char *wallet) {
     if (wallet) {
         strncpy(s_wallet, wallet, sizeof(s_wallet) - 1);
+#if USE_STATS_SHARE
+        s_walletHash = stats_share_wallet_hash(s_wallet);
+#endif
     }
 }
 
+void live_stats_set_paused(bool paused) {
+    s_paused = paused;
+    if (!paused && s_task) xTaskNotifyGive(s_task);
+}
+
 void live_stats_update() {
     // Triggered manually - task handles autonomous updates
 }
@@ -968,6 +815,132 @@ void live_stats_force_update() {
     s_lastFeesUpdate = 0;
     s_lastPoolUpdate = 0;
     s_lastNetworkUpdate = 0;
+    s_lastDifficultyUpdate = 0;
+}
+
+// ============================================================
+// Fleet Sharing
+// ============================================================
+
+#if USE_STATS_SHARE
+static bool leaderFresh(uint32_t now) {
+    return s_leaderId && now - s_leaderHeard < s_leaderTimeout;
+}
+
+// The jitter spreads takeovers out, so when a leader goes quiet one board
+// starts fetching and the rest hear it before their own timeout
+static void shareStart(uint32_t now) {
+    uint32_t jitter = esp_random() % STATS_SHARE_JITTER_MS;
+    s_leaderTimeout = STATS_LEADER_TIMEOUT_MS + jitter;
+    s_listenUntil = now + STATS_SHARE_INTERVAL_MS + jitter;
+}
+
+static void shareReceive(uint32_t now) {
+    stats_share_packet_t pkt;
+    while (stats_share_receive(&pkt)) {
+        // Of two leaders the lower id stays; followers keep the lowest one heard
+        if (s_leading && pkt.leaderId > stats_share_id()) continue;
+        if (leaderFresh(now) && pkt.leaderId > s_leaderId) continue;
+
+        if (s_leading) {
+            Serial.printf("[SHARE] Leader %08lx heard, stepping down\n", pkt.leaderId);
+            s_leading = false;
+        } else if (pkt.leaderId != s_leaderId || !leaderFresh(now)) {
+            Serial.printf("[SHARE] Following leader %08lx\n", pkt.leaderId);
+        }
+        s_leaderId = pkt.leaderId;
+        s_leaderHeard = now;
+        s_leaderPoolMatch = (pkt.walletHash == s_walletHash);
+
+        xSemaphoreTake(s_statsMutex, portMAX_DELAY);
+        stats_share_apply(&pkt, &s_stats, s_leaderPoolMatch);
+        xSemaphoreGive(s_statsMutex);
+    }
+}
+
+// After each fetch and every STATS_SHARE_INTERVAL_MS while leading. A board
+// that fetches with no leader around becomes one.
+static void shareBroadcast(uint32_t now, bool fetched) {
+    if (fetched && !s_leading && !leaderFresh(now)) {
+        Serial.println("[SHARE] No leader heard, sharing our stats");
+        s_leading = true;
+    }
+    if (!s_leading) return;
+    if (!fetched && now - s_lastShareSent < STATS_SHARE_INTERVAL_MS) return;
+
+    stats_share_packet_t pkt;
+    xSemaphoreTake(s_statsMutex, portMAX_DELAY);
+    stats_share_pack(&s_stats, s_walletHash, &pkt);
+    xSemaphoreGive(s_statsMutex);
+
+    if (pkt.flags) stats_share_send(&pkt);
+    s_lastShareSent = now;
+}
+#endif // USE_STATS_SHARE
+
+// ============================================================
+// Fetch Scheduling
+// ============================================================
+
+// One periodic fetch. At most one runs per pass, and the pause after it
+// scales with the time it took, so fetching averages no more than
+// STATS_FETCH_BUDGET_MS per second of Core 0 instead of arriving in bursts.
+typedef struct {
+    void (*run)();
+    uint32_t *last;
+    uint32_t intervalMs;
+    bool https;                     // Needs the proxy or direct HTTPS
+    bool perWallet;                 // Only shared between boards on one wallet
+} stats_fetch_t;
+
+static const stats_fetch_t s_fetches[] = {
+    { updateBlockHeight,       &s_lastBlockUpdate,      UPDATE_BLOCK_MS,   false, false },
+    { updateFees,              &s_lastFeesUpdate,       UPDATE_FEES_MS,    false, false },
+    { updatePrice,             &s_lastPriceUpdate,      UPDATE_PRICE_MS,   true,  false },
+    { updatePoolStats,         &s_lastPoolUpdate,       UPDATE_POOL_MS,    true,  true },
+    { updateNetworkHashrate,   &s_lastNetworkUpdate,    UPDATE_NETWORK_MS, true,  false },
+    { updateNetworkDifficulty, &s_lastDifficultyUpdate, UPDATE_NETWORK_MS, true,  false },
+};
+
+static void runCustomApi() {
+    fetchFromCustomApi();
+}
+
+static const stats_fetch_t s_customFetch = { runCustomApi, &s_lastCustomApiUpdate, UPDATE_PRICE_MS, false, true };
+
+// Most overdue fetch, or NULL if none is due
+static const stats_fetch_t *nextFetch(uint32_t now) {
+    // While a leader is heard, only what it can't share for us is fetched
+#if USE_STATS_SHARE
+    if ((int32_t)(now - s_listenUntil) < 0) return NULL;
+    bool follow = leaderFresh(now);
+    bool followWallet = follow && s_leaderPoolMatch;
+#else
+    bool follow = false;
+    bool followWallet = false;
+#endif
+
+    // Custom API provides everything (difficulty adjustment included) in one call
+    if (s_customApiUrl[0]) {
+        if (followWallet) return NULL;
+        return (now - s_lastCustomApiUpdate > UPDATE_PRICE_MS) ? &s_customFetch : NULL;
+    }
+
+    const stats_fetch_t *next = NULL;
+    uint32_t nextLate = 0;
+    bool https = s_proxyConfigured || s_httpsEnabled;
+    for (size_t i = 0; i < sizeof(s_fetches) / sizeof(s_fetches[0]); i++) {
+        const stats_fetch_t *fetch = &s_fetches[i];
+        if (fetch->https && !https) continue;
+        if (fetch->perWallet ? followWallet : follow) continue;
+        uint32_t age = now - *fetch->last;
+        if (age <= fetch->intervalMs) continue;
+        if (!next || age - fetch->intervalMs > nextLate) {
+            next = fetch;
+            nextLate = age - fetch->intervalMs;
+        }
+    }
+    return next;
 }
 
 void live_stats_task(void *param) {
@@ -981,68 +954,60 @@ void live_stats_task(void *param) {
     s_lastPriceUpdate = bootTime - UPDATE_PRICE_MS - 3000;
     s_lastPoolUpdate = bootTime - UPDATE_POOL_MS - 4000;
     s_lastNetworkUpdate = bootTime - UPDATE_NETWORK_MS - 5000;
+    s_lastDifficultyUpdate = bootTime - UPDATE_NETWORK_MS - 6000;
     s_lastCustomApiUpdate = bootTime - UPDATE_PRICE_MS - 1000;
+#if USE_STATS_SHARE
+    shareStart(bootTime);
+#endif
 
     Serial.println("[STATS] Task started");
 
     while (true) {
+#if USE_STATS_SHARE
+        // A leader keeps fetching for the fleet with its own screen off
+        bool pause = s_paused && !s_leading;
+#else
+        bool pause = s_paused;
+#endif
+        if (pause) {
+            // Screen is off: drop idle connections and block until resumed
+            http_close_idle();
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+
+        uint32_t pauseMs = 100;
+#if USE_STATS_SHARE
+        bool sharing = stats_share_open();  // Left while WiFi is down, rejoined after
+#endif
+
         if (WiFi.status() == WL_CONNECTED) {
-            uint32_t now = millis();
-
-            // Priority 1: Custom API endpoint (fetches all stats in one call)
-            if (s_customApiUrl[0]) {
-                if (now - s_lastCustomApiUpdate > UPDATE_PRICE_MS) {
-                    fetchFromCustomApi();
-                    s_lastCustomApiUpdate = millis();
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                }
-                // Custom API now provides difficulty adjustment from proxy
-                // No need for separate HTTPS fetch
-            } else {
-                // Priority 2/3/4: Use individual APIs
-
-                // Check proxy health periodically
-                checkProxyHealth();
-
-                // HTTP APIs (always available - no SSL)
-                if (now - s_lastBlockUpdate > UPDATE_BLOCK_MS) {
-                    updateBlockHeight();
-                    s_lastBlockUpdate = millis();
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                }
-
-                if (now - s_lastFeesUpdate > UPDATE_FEES_MS) {
-                    updateFees();
-                    s_lastFeesUpdate = millis();
-                    vTaskDelay(500 / portTICK_PERIOD_MS);
-                }
-
-                // HTTPS APIs (only if proxy or direct HTTPS enabled)
-                if (s_proxyConfigured || s_httpsEnabled) {
-                    if (now - s_lastPriceUpdate > UPDATE_PRICE_MS) {
-                        updatePrice();
-                        s_lastPriceUpdate = millis();
-                        vTaskDelay(500 / portTICK_PERIOD_MS);
-                    }
-
-                    if (now - s_lastPoolUpdate > UPDATE_POOL_MS) {
-                        updatePoolStats();
-                        s_lastPoolUpdate = millis();
-                        vTaskDelay(500 / portTICK_PERIOD_MS);
-                    }
-
-                    if (now - s_lastNetworkUpdate > UPDATE_NETWORK_MS) {
-                        updateNetworkHashrate();
-                        vTaskDelay(500 / portTICK_PERIOD_MS);
-                        updateNetworkDifficulty();
-                        s_lastNetworkUpdate = millis();
-                        vTaskDelay(500 / portTICK_PERIOD_MS);
-                    }
-                }
+            // Check proxy health periodically (individual APIs only)
+            if (!s_customApiUrl[0]) checkProxyHealth();
+
+#if USE_STATS_SHARE
+            if (sharing) shareReceive(millis());
+#endif
+
+            const stats_fetch_t *fetch = nextFetch(millis());
+            if (fetch) {
+                uint32_t start = millis();
+                fetch->run();
+                *fetch->last = millis();
+
+                // Spent ms at budget B per second: pause spent * (1000 - B) / B
+                uint32_t spent = millis() - start;
+                uint32_t pause = spent * (1000 - STATS_FETCH_BUDGET_MS) / STATS_FETCH_BUDGET_MS;
+                if (pause > pauseMs) pauseMs = pause;
             }
+
+#if USE_STATS_SHARE
+            shareBroadcast(millis(), fetch != NULL);
+#endif
+            http_close_idle();
         }
 
         // Yield to let other tasks run
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        vTaskDelay(pauseMs / portTICK_PERIOD_MS);
     }
 }
@@ -42,6 +42,12 @@
 #define UPDATE_FEES_MS      300000  // 5 minutes
 #define UPDATE_POOL_MS      120000  // 2 minutes
 
+// Fetch time allowed per second (ms): after each fetch the task pauses so
+// the average stays under it (a 300 ms handshake waits 2.7 s at 100)
+#ifndef STATS_FETCH_BUDGET_MS
+#define STATS_FETCH_BUDGET_MS  100
+#endif
+
 // Proxy health check interval (when unhealthy)
 #define PROXY_HEALTH_CHECK_MS  300000  // 5 minutes
 #define PROXY_MAX_FAILURES     3       // Failures before marking unhealthy
@@ -123,6 +129,14 @@ void live_stats_get_copy(live_stats_t *dest);
  */
 void live_stats_set_wallet(const char *wallet);
 
+/**
+ * Pause or resume fetching (the screen is off, nobody is looking)
+ * While paused the task blocks without polling; on resume anything that
+ * fell due is fetched at once. A fleet leader (USE_STATS_SHARE) is not
+ * paused: the other boards rely on its broadcasts. Safe to call from any task.
+ */
+void live_stats_set_paused(bool paused);
+
 /**
  * FreeRTOS task for background updates
  */
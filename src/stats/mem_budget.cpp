@@ -0,0 +1,97 @@
+/*
+ * SparkMiner - Memory Budget Implementation
+ * See mem_budget.h.
+ */
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include "mem_budget.h"
+
+static mem_budget_entry_t s_entries[MEM_BUDGET_ENTRIES];
+static uint8_t s_count = 0;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================
+// Helpers
+// ============================================================
+
+static void add(const char *subsystem, const char *what, uint32_t bytes, TaskHandle_t task) {
+    portENTER_CRITICAL(&s_lock);
+    if (s_count < MEM_BUDGET_ENTRIES) {
+        s_entries[s_count++] = {subsystem, what, bytes, task};
+    }
+    portEXIT_CRITICAL(&s_lock);
+}
+
+static bool seenBefore(uint8_t i) {
+    for (uint8_t j = 0; j < i; j++) {
+        if (strcmp(s_entries[j].subsystem, s_entries[i].subsystem) == 0) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+TaskHandle_t mem_task_create(TaskFunction_t fn, const char *name, void *param,
+                             UBaseType_t priority, BaseType_t core, const char *subsystem,
+                             StackType_t *stack, uint32_t stackBytes, StaticTask_t *tcb) {
+    // ESP-IDF counts stack depth in bytes
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(fn, name, stackBytes, param, priority,
+                                                      stack, tcb, core);
+    add(subsystem, name, stackBytes, task);
+    return task;
+}
+
+void mem_budget_add(const char *subsystem, const char *what, uint32_t bytes) {
+    add(subsystem, what, bytes, NULL);
+}
+
+uint32_t mem_budget_stack_peak(const mem_budget_entry_t *entry) {
+    if (!entry->task) return 0;
+    return entry->bytes - uxTaskGetStackHighWaterMark(entry->task);
+}
+
+uint8_t mem_budget_get(const mem_budget_entry_t **entries) {
+    *entries = s_entries;
+    return s_count;
+}
+
+void mem_budget_report(const char *why) {
+    uint32_t stacks = 0, buffers = 0;
+
+    Serial.printf("[MEM] Memory budget (%s)\n", why);
+    for (uint8_t i = 0; i < s_count; i++) {
+        if (seenBefore(i)) continue;
+        const char *subsystem = s_entries[i].subsystem;
+
+        uint32_t total = 0;
+        for (uint8_t j = i; j < s_count; j++) {
+            if (strcmp(s_entries[j].subsystem, subsystem) == 0) total += s_entries[j].bytes;
+        }
+        Serial.printf("[MEM] %-10s %6lu bytes\n", subsystem, total);
+
+        for (uint8_t j = i; j < s_count; j++) {
+            const mem_budget_entry_t *e = &s_entries[j];
+            if (strcmp(e->subsystem, subsystem) != 0) continue;
+            if (!e->task) {
+                Serial.printf("[MEM]   %-16s %6lu\n", e->what, e->bytes);
+                buffers += e->bytes;
+                continue;
+            }
+            uint32_t peak = mem_budget_stack_peak(e);
+            uint32_t spare = e->bytes - peak;
+            Serial.printf("[MEM]   %-16s %6lu stack, peak %lu (%lu%%), %lu spare%s\n",
+                          e->what, e->bytes, peak, peak * 100 / e->bytes, spare,
+                          spare < MEM_STACK_MARGIN ? " - LOW" : "");
+            stacks += e->bytes;
+        }
+    }
+
+    Serial.printf("[MEM] Static stacks %lu, buffers %lu bytes\n", stacks, buffers);
+    Serial.printf("[MEM] Heap: %lu free, %lu lowest, %lu largest block (internal %lu free, %lu largest)\n",
+                  ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap(),
+                  (uint32_t)heap_caps_get_free_size(MALLOC_CAP_INTERNAL),
+                  (uint32_t)heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL));
+}
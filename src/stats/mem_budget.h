@@ -0,0 +1,78 @@
+/*
+ * SparkMiner - Memory Budget
+ * Long-lived tasks run on static stacks (STATIC_TASK + mem_task_create),
+ * so their stacks and control blocks are placed at link time instead of
+ * being carved out of the heap at boot. The heap left over stays in one
+ * piece for TLS sessions, standby pools and job rings.
+ *
+ * Subsystems register their tasks and their large fixed buffers here. The
+ * report lists each subsystem's share, every stack's peak use (from its
+ * high-water mark) and the heap: at boot, MEM_REPORT_AFTER_MS later once
+ * the stacks have seen real work, on the "mem" serial command, and on the
+ * metrics endpoint. A stack with less than MEM_STACK_MARGIN spare is
+ * flagged; trim or grow the *_STACK defines in board_config.h from the
+ * peaks.
+ */
+
+#ifndef MEM_BUDGET_H
+#define MEM_BUDGET_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+#define MEM_BUDGET_ENTRIES  40
+
+/**
+ * Declare the stack (bytes) and control block of a static task
+ */
+#define STATIC_TASK(id, bytes) \
+    static StackType_t id##_stack[bytes]; \
+    static StaticTask_t id##_tcb
+
+/**
+ * The stack arguments of mem_task_create for a STATIC_TASK
+ */
+#define STATIC_TASK_MEM(id) id##_stack, sizeof(id##_stack), &id##_tcb
+
+/**
+ * One budget line: a task stack or a fixed buffer
+ */
+typedef struct {
+    const char *subsystem;
+    const char *what;           // Task name or buffer
+    uint32_t bytes;
+    TaskHandle_t task;          // NULL for buffers
+} mem_budget_entry_t;
+
+/**
+ * Create a task on a static stack and add it to the budget
+ * @param core  Core to pin to, or tskNO_AFFINITY
+ * @return The task handle (never NULL: static creation cannot fail)
+ */
+TaskHandle_t mem_task_create(TaskFunction_t fn, const char *name, void *param,
+                             UBaseType_t priority, BaseType_t core, const char *subsystem,
+                             StackType_t *stack, uint32_t stackBytes, StaticTask_t *tcb);
+
+/**
+ * Add a fixed buffer to the budget (call once, from the owner's init)
+ */
+void mem_budget_add(const char *subsystem, const char *what, uint32_t bytes);
+
+/**
+ * Peak stack use of a budgeted task so far (0 for buffers)
+ */
+uint32_t mem_budget_stack_peak(const mem_budget_entry_t *entry);
+
+/**
+ * Budget lines registered so far
+ * @return Count; *entries points at the table
+ */
+uint8_t mem_budget_get(const mem_budget_entry_t **entries);
+
+/**
+ * Print the budget per subsystem and the heap over serial
+ * @param why Shown in the header ("boot", "settled", "command")
+ */
+void mem_budget_report(const char *why);
+
+#endif // MEM_BUDGET_H
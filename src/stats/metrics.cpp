@@ -0,0 +1,485 @@
+/*
+ * SparkMiner - Metrics Endpoint Implementation
+ * See metrics.h.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <stdarg.h>
+#include <lwip/sockets.h>
+#include <board_config.h>
+#include "metrics.h"
+#include "timeseries.h"
+#include "monitor.h"
+#include "sd_log.h"
+#include "power.h"
+#include "mem_budget.h"
+#include "../config/stats_journal.h"
+#include "../config/wifi_manager.h"
+#include "../mining/miner.h"
+#include "../mining/freq_governor.h"
+#include "../mining/engine_bm13xx.h"
+#include "../stratum/stratum.h"
+#include "../stratum/stratum_proxy.h"
+#include "../display/display.h"
+
+#define METRICS_REQUEST_MAX 512     // Only the request line is looked at
+#define METRICS_RETRY_MS    5000    // Listen socket setup retry
+
+static char s_request[METRICS_REQUEST_MAX];
+static char s_out[METRICS_CHUNK];
+static size_t s_outLen = 0;
+static int s_outFd = -1;
+static bool s_outOk = false;
+static uint32_t s_scrapes = 0;
+
+// ============================================================
+// Output
+// ============================================================
+
+static void outFlush() {
+    size_t sent = 0;
+    while (s_outOk && sent < s_outLen) {
+        int n = send(s_outFd, s_out + sent, s_outLen - sent, 0);
+        if (n <= 0) {
+            s_outOk = false;    // Scraper gone or stalled past SO_SNDTIMEO
+        } else {
+            sent += n;
+        }
+    }
+    s_outLen = 0;
+}
+
+// Append to the chunk, sending it first when the text would not fit.
+// Integer and string conversions only: newlib's float formatting can
+// allocate, so fractions go through fixedPoint().
+static void outPrintf(const char *fmt, ...) {
+    for (int attempt = 0; attempt < 2; attempt++) {
+        size_t room = sizeof(s_out) - s_outLen;
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(s_out + s_outLen, room, fmt, args);
+        va_end(args);
+        if (n < 0) return;
+        if ((size_t)n < room) {
+            s_outLen += n;
+            return;
+        }
+        outFlush();     // Retry on an empty chunk; longer lines are cut
+    }
+    s_outLen = sizeof(s_out) - 1;
+}
+
+// Decimal with three fraction digits, without the float printf path
+static const char *fixedPoint(char *buf, size_t cap, double v) {
+    if (isnan(v) || isinf(v)) {
+        snprintf(buf, cap, "NaN");
+        return buf;
+    }
+    bool negative = v < 0;
+    if (negative) v = -v;
+    if (v > 1e18) v = 1e18;
+
+    uint64_t scaled = (uint64_t)(v * 1000.0 + 0.5);
+    snprintf(buf, cap, "%s%llu.%03u", negative ? "-" : "",
+             (unsigned long long)(scaled / 1000), (unsigned)(scaled % 1000));
+    return buf;
+}
+
+static void typeLine(const char *name, const char *type) {
+    outPrintf("# TYPE sparkminer_%s %s\n", name, type);
+}
+
+static void valueU64(const char *name, const char *labels, uint64_t v) {
+    outPrintf("sparkminer_%s%s %llu\n", name, labels, (unsigned long long)v);
+}
+
+static void valueFixed(const char *name, const char *labels, double v) {
+    char num[32];
+    outPrintf("sparkminer_%s%s %s\n", name, labels, fixedPoint(num, sizeof(num), v));
+}
+
+// One unlabelled sample with its TYPE line
+static void counter(const char *name, uint64_t v) {
+    typeLine(name, "counter");
+    valueU64(name, "", v);
+}
+
+static void gauge(const char *name, double v) {
+    typeLine(name, "gauge");
+    valueFixed(name, "", v);
+}
+
+// Label values are firmware and pool strings: drop what would need escaping
+static const char *labelSafe(char *buf, size_t cap, const char *s) {
+    size_t n = 0;
+    for (; s && *s && n + 1 < cap; s++) {
+        if (*s != '"' && *s != '\\' && *s != '\n') buf[n++] = *s;
+    }
+    buf[n] = '\0';
+    return buf;
+}
+
+// ============================================================
+// Metrics
+// ============================================================
+
+static void writeMetrics() {
+    mining_stats_t *mstats = miner_get_stats();
+    stratum_counters_t conn;
+    stratum_get_counters(&conn);
+    char labels[160], pool[MAX_POOL_URL_LEN];
+
+    typeLine("info", "gauge");
+    snprintf(labels, sizeof(labels), "{board=\"%s\",version=\"%s\",chip=\"%s\"}",
+             BOARD_NAME, AUTO_VERSION, ESP.getChipModel());
+    valueU64("info", labels, 1);
+    gauge("uptime_seconds", millis() / 1000);
+
+    // Hashing
+    counter("hashes_total", mstats->hashes);
+    typeLine("core_hashes_total", "counter");
+    for (uint8_t c = 0; c < 2; c++) {
+        const char *kernel = miner_get_kernel_name(c);
+        snprintf(labels, sizeof(labels), "{core=\"%u\",kernel=\"%s\"}", c, kernel ? kernel : "none");
+        valueU64("core_hashes_total", labels, mstats->coreHashes[c]);
+    }
+
+    typeLine("hashrate", "gauge");
+    ts_window_stats_t win[TS_WINDOW_COUNT];
+    bool have[TS_WINDOW_COUNT];
+    for (int w = 0; w < TS_WINDOW_COUNT; w++) {
+        have[w] = timeseries_get((ts_window_t)w, &win[w]);
+        if (!have[w]) continue;
+        snprintf(labels, sizeof(labels), "{window=\"%s\"}", timeseries_window_name((ts_window_t)w));
+        valueFixed("hashrate", labels, win[w].hashRate);
+    }
+    typeLine("core_hashrate", "gauge");
+    for (int w = 0; w < TS_WINDOW_COUNT; w++) {
+        if (!have[w]) continue;
+        for (uint8_t c = 0; c < 2; c++) {
+            snprintf(labels, sizeof(labels), "{core=\"%u\",window=\"%s\"}", c, timeseries_window_name((ts_window_t)w));
+            valueFixed("core_hashrate", labels, win[w].coreHashRate[c]);
+        }
+    }
+    typeLine("shares_per_minute", "gauge");
+    for (int w = TS_WINDOW_15M; w < TS_WINDOW_COUNT; w++) {
+        if (!have[w]) continue;
+        snprintf(labels, sizeof(labels), "{window=\"%s\"}", timeseries_window_name((ts_window_t)w));
+        valueFixed("shares_per_minute", labels, win[w].sharesPerMin);
+    }
+    typeLine("reject_percent", "gauge");
+    for (int w = TS_WINDOW_15M; w < TS_WINDOW_COUNT; w++) {
+        if (!have[w]) continue;
+        snprintf(labels, sizeof(labels), "{window=\"%s\"}", timeseries_window_name((ts_window_t)w));
+        valueFixed("reject_percent", labels, win[w].rejectPercent);
+    }
+
+    // Shares and jobs
+    counter("shares_submitted_total", mstats->shares);
+    counter("shares_accepted_total", mstats->accepted);
+    counter("shares_rejected_total", mstats->rejected);
+    counter("share_timeouts_total", mstats->shareTimeouts);
+    counter("late_responses_total", mstats->lateResponses);
+    counter("stale_shares_dropped_total", mstats->staleDropped);
+    counter("candidate_drops_total", mstats->candidateDrops);
+    counter("candidates_invalid_total", mstats->invalidCandidates);
+    counter("matches_32bit_total", mstats->matches32);
+    counter("blocks_found_total", mstats->blocks);
+    counter("jobs_total", mstats->templates);
+    counter("jobs_deferred_total", mstats->deferredJobs);
+    gauge("best_difficulty", mstats->bestDifficulty);
+    gauge("pool_difficulty", miner_get_difficulty());
+
+    // Latency
+    gauge("share_latency_avg_ms", mstats->avgLatency);
+    gauge("share_latency_p50_ms", mstats->latencyP50);
+    gauge("share_latency_p95_ms", mstats->latencyP95);
+    gauge("control_latency_ms", mstats->controlLatency);
+    gauge("job_build_us", mstats->lastBuildUs);
+    gauge("job_switch_us", mstats->lastSwitchUs);
+    gauge("job_switch_max_us", mstats->maxSwitchUs);
+
+    // Device
+    gauge("heap_free_bytes", ESP.getFreeHeap());
+    gauge("heap_min_free_bytes", ESP.getMinFreeHeap());
+    gauge("heap_max_alloc_bytes", ESP.getMaxAllocHeap());
+    gauge("temperature_celsius", temperatureRead());
+    gauge("cpu_mhz", getCpuFrequencyMhz());
+    gauge("wifi_rssi_dbm", WiFi.RSSI());
+
+    // Pool
+    gauge("pool_connected", stratum_is_connected() ? 1 : 0);
+    gauge("pool_backup", stratum_is_backup() ? 1 : 0);
+    typeLine("pool_info", "gauge");
+    snprintf(labels, sizeof(labels), "{url=\"%s\"}", labelSafe(pool, sizeof(pool), stratum_get_pool()));
+    valueU64("pool_info", labels, 1);
+    counter("pool_connects_total", conn.connects);
+    counter("pool_connect_failures_total", conn.connectFailures);
+    counter("pool_disconnects_total", conn.disconnects);
+    counter("pool_switches_total", conn.poolSwitches);
+    counter("pool_sessions_kept_total", conn.sessionsKept);
+    counter("pool_sessions_resumed_total", conn.sessionsResumed);
+    counter("wifi_outages_total", conn.wifiOutages);
+    counter("wifi_outage_ms_total", conn.outageMsTotal);
+    gauge("wifi_outage_last_ms", conn.lastOutageMs);
+    gauge("wifi_outage_max_ms", conn.maxOutageMs);
+
+#if USE_DISPLAY
+    // TFT rendering
+    display_frame_stats_t frame;
+    display_get_frame_stats(&frame);
+    counter("display_frames_total", frame.frames);
+    counter("display_full_redraws_total", frame.fullRedraws);
+    counter("display_pixels_total", frame.totalPixels);
+    gauge("display_frame_us", frame.lastUs);
+    gauge("display_frame_max_us", frame.maxUs);
+    gauge("display_frame_widgets", frame.lastWidgets);
+    gauge("display_frame_pixels", frame.lastPixels);
+#endif
+
+    // Boot timing (0 until reached)
+    gauge("boot_wifi_ms", wifi_manager_connect_ms());
+    gauge("boot_first_job_ms", mstats->firstJobMs);
+    gauge("boot_first_hash_ms", mstats->firstHashMs);
+
+    // Core 0 with the screen on and off (screen_timeout)
+    monitor_sleep_stats_t sleep;
+    monitor_get_sleep_stats(&sleep);
+    gauge("screen_off", sleep.asleep ? 1 : 0);
+    counter("screen_sleeps_total", sleep.sleeps);
+    counter("screen_off_seconds_total", sleep.asleepSeconds);
+    gauge("core0_hashrate_screen_on", sleep.core0Awake);
+    gauge("core0_hashrate_screen_off", sleep.core0Asleep);
+
+    // Stats journal
+    stats_journal_stats_t journal;
+    stats_journal_get_stats(&journal);
+    if (journal.present) {
+        counter("journal_appends_total", journal.appends);
+        counter("journal_erases_total", journal.erases);
+        gauge("journal_seq", journal.seq);
+        gauge("journal_write_us", journal.lastWriteUs);
+        gauge("journal_replay_us", journal.replayUs);
+    }
+
+    // Power and efficiency (labels say what the window ran: compare kernels,
+    // clocks and Core 0 on/off across scrapes)
+    power_stats_t power;
+    power_get_stats(&power);
+    gauge("power_milliwatts", power.avgMilliwatts);
+    gauge("power_measured", power.measured ? 1 : 0);
+    counter("energy_joules_total", (uint64_t)power.joules);
+    if (power.measured) {
+        gauge("power_bus_volts", power.busVolts);
+        gauge("power_milliamps", power.milliamps);
+        counter("power_sensor_errors_total", power.errors);
+    }
+    if (power.hashesPerJoule > 0) {
+        const char *kernel = miner_get_kernel_name(1);
+        snprintf(labels, sizeof(labels), "{kernel=\"%s\",mhz=\"%lu\",core0=\"%s\",source=\"%s\"}",
+                 kernel ? kernel : "none", power.windowMhz, power.windowCore0 ? "on" : "off",
+                 power_source_name(power.source));
+        typeLine("hashes_per_joule", "gauge");
+        valueFixed("hashes_per_joule", labels, power.hashesPerJoule);
+        typeLine("joules_per_gigahash", "gauge");
+        valueFixed("joules_per_gigahash", labels, power.joulesPerGh);
+    }
+
+    // Memory budget: fixed allocations per subsystem, stack peaks per task
+    const mem_budget_entry_t *budget;
+    uint8_t budgetCount = mem_budget_get(&budget);
+    typeLine("memory_budget_bytes", "gauge");
+    for (uint8_t i = 0; i < budgetCount; i++) {
+        snprintf(labels, sizeof(labels), "{subsystem=\"%s\",what=\"%s\",kind=\"%s\"}",
+                 budget[i].subsystem, budget[i].what, budget[i].task ? "stack" : "buffer");
+        valueU64("memory_budget_bytes", labels, budget[i].bytes);
+    }
+    typeLine("task_stack_peak_bytes", "gauge");
+    for (uint8_t i = 0; i < budgetCount; i++) {
+        if (!budget[i].task) continue;
+        snprintf(labels, sizeof(labels), "{task=\"%s\"}", budget[i].what);
+        valueU64("task_stack_peak_bytes", labels, mem_budget_stack_peak(&budget[i]));
+    }
+
+    // Frequency governor
+    freq_governor_stats_t gov;
+    freq_governor_get_stats(&gov);
+    if (gov.active) {
+        gauge("governor_mode", gov.mode);
+        gauge("governor_cap_mhz", gov.capMhz);
+        gauge("governor_temperature_celsius", gov.temperature);
+        counter("governor_changes_total", gov.changes);
+        counter("governor_throttles_total", gov.throttles);
+        counter("governor_failures_total", gov.failures);
+        gauge("governor_pause_ms", gov.lastPauseMs);
+        typeLine("governor_step_hashrate", "gauge");
+        for (uint8_t i = 0; i < GOVERNOR_STEPS && gov.stepMhz[i]; i++) {
+            snprintf(labels, sizeof(labels), "{mhz=\"%lu\"}", gov.stepMhz[i]);
+            valueFixed("governor_step_hashrate", labels, gov.stepHashRate[i]);
+        }
+    }
+
+    // External ASIC chain
+    bm13xx_stats_t asic;
+    bm13xx_get_stats(&asic);
+    if (asic.active) {
+        gauge("asic_chips", asic.chips);
+        gauge("asic_mhz", asic.mhz);
+        gauge("asic_ticket_difficulty", asic.ticketDiff);
+        gauge("asic_work_interval_ms", asic.workMs);
+        gauge("asic_expected_hashrate", asic.expectedHashRate);
+        counter("asic_jobs_total", asic.jobs);
+        counter("asic_results_total", asic.results);
+        counter("asic_duplicates_total", asic.duplicates);
+        counter("asic_resyncs_total", asic.resyncs);
+    }
+
+    // SD logger
+    sd_log_stats_t sdlog;
+    sd_log_get_stats(&sdlog);
+    if (sdlog.active) {
+        counter("sdlog_records_total", sdlog.records);
+        counter("sdlog_dropped_total", sdlog.dropped);
+        counter("sdlog_writes_total", sdlog.writes);
+        counter("sdlog_bytes_total", sdlog.bytes);
+        counter("sdlog_errors_total", sdlog.errors);
+        counter("sdlog_rotations_total", sdlog.rotations);
+        gauge("sdlog_write_us", sdlog.lastWriteUs);
+        gauge("sdlog_write_max_us", sdlog.maxWriteUs);
+    }
+
+#if USE_STRATUM_PROXY
+    // LAN proxy
+    stratum_proxy_stats_t proxy;
+    stratum_proxy_get_stats(&proxy);
+    gauge("proxy_miners", proxy.clients);
+    counter("proxy_connects_total", proxy.connects);
+    counter("proxy_shares_forwarded_total", proxy.forwarded);
+    counter("proxy_shares_accepted_total", proxy.accepted);
+    counter("proxy_shares_rejected_total", proxy.rejected);
+    counter("proxy_submits_malformed_total", proxy.malformed);
+    counter("proxy_shares_stale_total", proxy.stale);
+    counter("proxy_shares_low_difficulty_total", proxy.lowDifficulty);
+    counter("proxy_miners_kicked_total", proxy.kicked);
+#endif
+    counter("metrics_scrapes_total", s_scrapes);
+}
+
+// ============================================================
+// Server
+// ============================================================
+
+static int openListener() {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(METRICS_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 2) != 0) {
+        close(fd);
+        return -1;
+    }
+    IPAddress ip = WiFi.localIP();
+    Serial.printf("[METRICS] Serving http://%u.%u.%u.%u:%d/metrics\n", ip[0], ip[1], ip[2], ip[3], METRICS_PORT);
+    return fd;
+}
+
+// Read up to the end of the request headers (or as much as fits)
+static bool readRequest(int fd) {
+    size_t len = 0;
+    while (len < sizeof(s_request) - 1) {
+        int n = recv(fd, s_request + len, sizeof(s_request) - 1 - len, 0);
+        if (n <= 0) break;
+        len += n;
+        s_request[len] = '\0';
+        if (strstr(s_request, "\r\n\r\n")) return true;
+    }
+    s_request[len] = '\0';
+    return len > 0;
+}
+
+static bool isMetricsPath(const char *request) {
+    const char *path = "GET /metrics";
+    size_t n = strlen(path);
+    return strncmp(request, path, n) == 0 && (request[n] == ' ' || request[n] == '?');
+}
+
+static void serveClient(int fd) {
+    struct timeval tv;
+    tv.tv_sec = METRICS_IO_MS / 1000;
+    tv.tv_usec = (METRICS_IO_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+    if (!readRequest(fd)) return;
+
+    s_outFd = fd;
+    s_outOk = true;
+    s_outLen = 0;
+    if (isMetricsPath(s_request)) {
+        s_scrapes++;
+        outPrintf("HTTP/1.1 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nConnection: close\r\n\r\n");
+        writeMetrics();
+    } else {
+        outPrintf("HTTP/1.1 404 Not Found\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\nTry /metrics\n");
+    }
+    outFlush();
+    shutdown(fd, SHUT_WR);
+}
+
+static void metrics_task(void *param) {
+    int listenFd = -1;
+
+    while (true) {
+        if (WiFi.status() != WL_CONNECTED) {
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            continue;
+        }
+        if (listenFd < 0) {
+            listenFd = openListener();
+            if (listenFd < 0) {
+                Serial.println("[METRICS] Could not open the listen socket, retrying");
+                vTaskDelay(METRICS_RETRY_MS / portTICK_PERIOD_MS);
+                continue;
+            }
+        }
+
+        // One scraper at a time; the wait keeps this task off the CPU
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listenFd, &readable);
+        struct timeval tv = {1, 0};
+        if (select(listenFd + 1, &readable, NULL, NULL, &tv) <= 0) continue;
+
+        int fd = accept(listenFd, NULL, NULL);
+        if (fd < 0) continue;
+        serveClient(fd);
+        close(fd);
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+STATIC_TASK(s_metricsTask, METRICS_STACK);
+
+void metrics_init() {
+    mem_budget_add("metrics", "request + chunk", sizeof(s_request) + sizeof(s_out));
+    mem_task_create(
+        metrics_task,
+        "Metrics",
+        NULL,
+        METRICS_PRIORITY,
+        METRICS_CORE,
+        "metrics",
+        STATIC_TASK_MEM(s_metricsTask)
+    );
+}
@@ -0,0 +1,25 @@
+/*
+ * SparkMiner - Metrics Endpoint
+ * Serves GET /metrics in Prometheus text format on METRICS_PORT, for
+ * scraping headless boards: mining counters, windowed hashrates, share
+ * latency, heap, temperature and pool connection state.
+ *
+ * One low-priority Core 0 task with its own socket: a scrape only reads
+ * existing state, streams it out of a fixed buffer (no heap allocation)
+ * and never waits on the stratum task.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+#define METRICS_CHUNK       1024    // Response buffer, sent whenever it fills
+#define METRICS_IO_MS       2000    // Socket read/write timeout per scrape
+
+/**
+ * Start the metrics server task (listens once WiFi is up)
+ */
+void metrics_init();
+
+#endif // METRICS_H
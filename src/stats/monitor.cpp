@@ -5,12 +5,17 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include <ArduinoJson.h>
 #include <board_config.h>
 #include "monitor.h"
 #include "live_stats.h"
+#include "timeseries.h"
+#include "power.h"
+#include "mem_budget.h"
 #include "../display/display.h"
 #include "../display/led_status.h"
 #include "../mining/miner.h"
+#include "../mining/freq_governor.h"
 #include "../stratum/stratum.h"
 #include "../config/nvs_config.h"
 #include "../config/wifi_manager.h"
@@ -22,6 +27,13 @@
 #define EARLY_SAVE_MS       300000  // 5 minutes - initial save interval before first hourly
 #define LED_UPDATE_MS       50      // 50ms for smooth LED animations
 
+// Screen sleep needs a display to turn off and a button to wake it
+#if defined(BUTTON_PIN) && (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
+    #define SCREEN_SLEEP 1
+#else
+    #define SCREEN_SLEEP 0
+#endif
+
 static bool s_initialized = false;
 static uint32_t s_lastDisplayUpdate = 0;
 static uint32_t s_lastStatsUpdate = 0;
@@ -31,6 +43,25 @@ static uint32_t s_startTime = 0;
 static bool s_earlySaveDone = false;      // Track if we've done the early save
 static uint32_t s_lastAcceptedCount = 0;  // Track shares for first-share save
 static uint32_t s_lastLedShareCount = 0;  // Track shares for LED flash
+static uint32_t s_lastYieldUs[2] = {0, 0}; // Yield time at last stats print (per-second rate)
+static uint32_t s_lastYieldMs = 0;
+static volatile bool s_benchRequested = false;
+
+// Screen timeout: with the screen off this task only samples once a second
+// and the stats fetcher and button poller block, leaving Core 0 to Miner0
+static TaskHandle_t s_task = NULL;
+static volatile bool s_asleep = false;
+static volatile bool s_wakeRequested = false;
+static volatile uint32_t s_lastActivity = 0;
+static uint32_t s_sleepStart = 0;
+static uint32_t s_sleeps = 0;
+
+// Core 0 hashes and time, [0] with the screen on and [1] with it off
+static portMUX_TYPE s_sleepMux = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_core0Hashes[2] = {0, 0};
+static uint64_t s_core0Ms[2] = {0, 0};
+static uint64_t s_core0LastHashes = 0;
+static uint32_t s_core0LastMs = 0;      // 0 = rebase at the next pass
 
 // Track session start values to calculate deltas for persistence
 static uint64_t s_sessionStartHashes = 0;
@@ -38,6 +69,13 @@ static uint32_t s_sessionStartShares = 0;
 static uint32_t s_sessionStartAccepted = 0;
 static uint32_t s_sessionStartRejected = 0;
 static uint32_t s_sessionStartBlocks = 0;
+static uint32_t s_sessionStartSeconds = 0;
+
+// A due save waits for the next job switch (or STATS_SAVE_ALIGN_MS)
+static bool s_savePending = false;
+static const char *s_saveReason = nullptr;
+static uint32_t s_savePendingSince = 0;
+static uint32_t s_savePendingJobs = 0;
 
 // ============================================================
 // Helper Functions
@@ -65,35 +103,20 @@ static void updateDisplayData(display_data_t *data) {
     data->blocks32 = mstats->matches32;
     data->uptimeSeconds = (millis() - s_startTime) / 1000;
     data->avgLatency = mstats->avgLatency;
-
-    // Calculate hashrate with EMA smoothing
-    static uint64_t lastHashes = 0;
-    static uint32_t lastHashTime = 0;
-    static double smoothedHashRate = 0.0;
-    static bool firstSample = true;
-
-    uint32_t now = millis();
-    uint32_t elapsed = now - lastHashTime;
-
-    if (elapsed >= 1000) {
-        uint64_t deltaHashes = mstats->hashes - lastHashes;
-        double instantRate = (double)deltaHashes * 1000.0 / elapsed;
-
-        // Exponential moving average (alpha=0.15 for smooth but responsive updates)
-        // Lower alpha = smoother but slower to respond
-        // Higher alpha = more responsive but jumpier
-        const double alpha = 0.15;
-
-        if (firstSample) {
-            smoothedHashRate = instantRate;
-            firstSample = false;
-        } else {
-            smoothedHashRate = alpha * instantRate + (1.0 - alpha) * smoothedHashRate;
-        }
-
-        data->hashRate = smoothedHashRate;
-        lastHashes = mstats->hashes;
-        lastHashTime = now;
+    data->cpuMhz = getCpuFrequencyMhz();
+
+    // Efficiency over the last power window
+    power_stats_t power;
+    power_get_stats(&power);
+    data->powerMw = power.avgMilliwatts;
+    data->hashesPerJoule = power.hashesPerJoule;
+    data->powerMeasured = power.measured;
+
+    // Hashrate over the last 10 seconds of samples: steady, but a dip
+    // shows within a few seconds
+    ts_window_stats_t recent;
+    if (timeseries_get(TS_WINDOW_10S, &recent)) {
+        data->hashRate = recent.hashRate;
     }
 
     // Pool info
@@ -164,15 +187,156 @@ static void updateDisplayData(display_data_t *data) {
     }
 }
 
+// Hashes done on Core 0 (the only core on single-core chips)
+static uint64_t core0Hashes() {
+    mining_stats_t *mstats = miner_get_stats();
+    #if (SOC_CPU_CORES_NUM >= 2)
+        return mstats->coreHashes[0];
+    #else
+        return mstats->hashes;
+    #endif
+}
+
+// Charge Core 0's hashes since the last pass to the current screen state
+static void accountCore0(uint32_t now) {
+    uint64_t hashes = core0Hashes();
+    if (s_core0LastMs) {
+        int state = s_asleep ? 1 : 0;
+        portENTER_CRITICAL(&s_sleepMux);
+        s_core0Hashes[state] += hashes - s_core0LastHashes;
+        s_core0Ms[state] += now - s_core0LastMs;
+        portEXIT_CRITICAL(&s_sleepMux);
+    }
+    s_core0LastHashes = hashes;
+    s_core0LastMs = now;
+}
+
+// Percent Core 0 gains with the screen off (0 until both states were seen)
+static float core0Gain(const monitor_sleep_stats_t *st) {
+    if (st->core0Awake <= 0 || st->core0Asleep <= 0) return 0;
+    return (st->core0Asleep / st->core0Awake - 1.0f) * 100.0f;
+}
+
+#if SCREEN_SLEEP
+static void screenSleep(uint32_t now) {
+    accountCore0(now);
+    s_asleep = true;
+    s_sleepStart = now;
+    s_sleeps++;
+    live_stats_set_paused(true);
+    display_set_sleep(true);
+    Serial.printf("[MONITOR] Screen off after %u min idle\n", nvs_config_get()->screenTimeout);
+}
+
+static void screenWake(uint32_t now) {
+    accountCore0(now);
+    s_asleep = false;
+    s_lastActivity = now;
+    live_stats_set_paused(false);
+    display_set_sleep(false);  // Next update is a full redraw
+
+    monitor_sleep_stats_t st;
+    monitor_get_sleep_stats(&st);
+    Serial.printf("[MONITOR] Screen on after %lu s | Core0 %.0f H/s on, %.0f H/s off (%+.1f%%)\n",
+        (now - s_sleepStart) / 1000, st.core0Awake, st.core0Asleep, core0Gain(&st));
+}
+#endif
+
+// Benchmark results: one JSON line so fleet tooling can grep for it
+static void runBenchmark(display_data_t *data) {
+    Serial.println("[BENCH] Running benchmark (mining paused)...");
+    uint32_t start = millis();
+
+    StaticJsonDocument<1024> doc;
+    doc["bench"] = 1;  // Record format version
+    doc["fw"] = AUTO_VERSION;
+    doc["board"] = BOARD_NAME;
+    doc["chip"] = ESP.getChipModel();
+    doc["rev"] = ESP.getChipRevision();
+
+    if (!miner_benchmark(doc.createNestedObject("mining"))) {
+        doc["error"] = "mining";
+    }
+
+    // Display cost per screen: full redraw after a screen change, then one
+    // data-driven update. Runs here because only this task may draw.
+    #if (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
+        static const char *screenNames[] = {"mining", "stats", "clock"};
+        JsonObject disp = doc.createNestedObject("display_us");
+        uint8_t screen = display_get_screen();
+        updateDisplayData(data);
+        for (uint8_t i = 0; i < 3; i++) {
+            display_set_screen(i);
+            display_redraw();
+            uint32_t t0 = micros();
+            display_update(data);
+            uint32_t fullUs = micros() - t0;
+
+            data->totalHashes++;  // Force a changed-data update
+            t0 = micros();
+            display_update(data);
+            uint32_t updateUs = micros() - t0;
+
+            JsonObject s = disp.createNestedObject(screenNames[i]);
+            s["full"] = fullUs;
+            s["update"] = updateUs;
+            #if USE_DISPLAY
+                display_frame_stats_t frame;
+                display_get_frame_stats(&frame);
+                s["update_widgets"] = frame.lastWidgets;
+                s["update_pixels"] = frame.lastPixels;
+            #endif
+        }
+        display_set_screen(screen);
+        display_redraw();
+    #endif
+
+    serializeJson(doc, Serial);
+    Serial.println();
+    Serial.printf("[BENCH] Done in %lu ms\n", millis() - start);
+}
+
 // ============================================================
 // Public API
 // ============================================================
 
+void monitor_request_benchmark() {
+    s_benchRequested = true;
+}
+
+bool monitor_wake() {
+    s_lastActivity = millis();
+    if (!s_asleep) return false;
+    s_wakeRequested = true;
+    if (s_task) xTaskNotifyGive(s_task);
+    return true;
+}
+
+bool monitor_is_asleep() {
+    return s_asleep;
+}
+
+void monitor_get_sleep_stats(monitor_sleep_stats_t *out) {
+    uint64_t hashes[2], ms[2];
+    portENTER_CRITICAL(&s_sleepMux);
+    memcpy(hashes, s_core0Hashes, sizeof(hashes));
+    memcpy(ms, s_core0Ms, sizeof(ms));
+    portEXIT_CRITICAL(&s_sleepMux);
+
+    out->asleep = s_asleep;
+    out->sleeps = s_sleeps;
+    out->asleepSeconds = (uint32_t)(ms[1] / 1000);
+    out->core0Awake = ms[0] ? (float)(hashes[0] * 1000.0 / ms[0]) : 0;
+    out->core0Asleep = ms[1] ? (float)(hashes[1] * 1000.0 / ms[1]) : 0;
+}
+
 void monitor_init() {
     if (s_initialized) return;
 
     // Initialize live stats
     live_stats_init();
+    timeseries_init();
+    power_init();
 
     // Initialize LED status driver (for headless builds with RGB LED)
     #ifdef USE_LED_STATUS
@@ -196,6 +360,7 @@ void monitor_init() {
 
     s_startTime = millis();
     s_lastPersistSave = millis();
+    s_lastActivity = millis();
     s_initialized = true;
 
     Serial.println("[MONITOR] Initialized");
@@ -208,12 +373,49 @@ void monitor_task(void *param) {
         monitor_init();
     }
 
+    s_task = xTaskGetCurrentTaskHandle();
+
     display_data_t displayData;
     memset(&displayData, 0, sizeof(displayData));
 
     while (true) {
+        if (s_benchRequested) {
+            s_benchRequested = false;
+            runBenchmark(&displayData);
+            s_core0LastMs = 0;  // Mining was paused: keep it out of the on/off rates
+        }
+
+        power_sample();
+
+        // Stack peaks mean more once WiFi, the pool and the display have all run
+        static bool memReported = false;
+        if (!memReported && millis() >= MEM_REPORT_AFTER_MS) {
+            memReported = true;
+            mem_budget_report("settled");
+        }
+
+        // Clock steps pause the miners here, never during a benchmark
+        if (freq_governor_update()) {
+            s_core0LastMs = 0;
+        }
+
         uint32_t now = millis();
 
+        #if SCREEN_SLEEP
+            // Timeout in minutes, 0 = never; the AP setup screen stays up
+            uint32_t timeoutMs = nvs_config_get()->screenTimeout * 60000UL;
+            if (s_wakeRequested) {
+                s_wakeRequested = false;
+                if (s_asleep) {
+                    screenWake(now);
+                    s_lastDisplayUpdate = now - DISPLAY_UPDATE_MS;
+                }
+            } else if (!s_asleep && timeoutMs && !(WiFi.getMode() & WIFI_AP) &&
+                       (int32_t)(now - s_lastActivity) >= (int32_t)timeoutMs) {
+                screenSleep(now);
+            }
+        #endif
+
         // Update live stats periodically
         if (now - s_lastStatsUpdate >= STATS_UPDATE_MS) {
             live_stats_update();
@@ -222,20 +424,31 @@ void monitor_task(void *param) {
 
         // Update display
         if (now - s_lastDisplayUpdate >= DISPLAY_UPDATE_MS) {
-            updateDisplayData(&displayData);
+            timeseries_sample();
+            accountCore0(now);
 
-            #if (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
-                display_update(&displayData);
+            // With the screen off the data is only gathered for the serial print
+            static uint32_t lastSerialPrint = 0;
+            bool printDue = (now - lastSerialPrint >= 10000);
+            if (!s_asleep || printDue) {
+                updateDisplayData(&displayData);
+            }
 
-                // Check for touch input
-                if (display_touched()) {
-                    display_handle_touch();
+            #if (USE_DISPLAY || USE_OLED_DISPLAY || USE_EINK_DISPLAY)
+                if (!s_asleep) {
+                    display_update(&displayData);
+
+                    // Check for touch input
+                    if (display_touched()) {
+                        miner_yield_hint();
+                        s_lastActivity = now;
+                        display_handle_touch();
+                    }
                 }
             #endif
 
             // Also print to serial for headless/debug
-            static uint32_t lastSerialPrint = 0;
-            if (now - lastSerialPrint >= 10000) {
+            if (printDue) {
                 Serial.printf("[STATS] Hashrate: %.2f H/s | Shares: %u/%u | Ping: %u ms | Best: %.4f\n",
                     displayData.hashRate,
                     displayData.sharesAccepted,
@@ -257,10 +470,81 @@ void monitor_task(void *param) {
                         displayData.halfHourFee);
                 }
 
-                // DEBUG: Per-core hash contribution
-                extern volatile uint64_t s_core0Hashes;
-                extern volatile uint64_t s_core1Hashes;
-                Serial.printf("[STATS] Core0: %llu hashes, Core1: %llu hashes\n", s_core0Hashes, s_core1Hashes);
+                // Per-core hash contribution
+                mining_stats_t *mstats = miner_get_stats();
+                Serial.printf("[STATS] Core0: %llu hashes, Core1: %llu hashes\n",
+                    mstats->coreHashes[0], mstats->coreHashes[1]);
+
+                // Windowed rates: a core or window falling behind the longer
+                // ones points at throttling; rejects or stalled jobs at the pool
+                ts_window_stats_t win[TS_WINDOW_COUNT];
+                for (int w = 0; w < TS_WINDOW_COUNT; w++) {
+                    timeseries_get((ts_window_t)w, &win[w]);
+                }
+                Serial.printf("[STATS] Hashrate 1m/15m/1h/24h: %.0f / %.0f / %.0f / %.0f H/s\n",
+                    win[TS_WINDOW_1M].hashRate, win[TS_WINDOW_15M].hashRate,
+                    win[TS_WINDOW_1H].hashRate, win[TS_WINDOW_24H].hashRate);
+                for (uint8_t c = 0; c < 2; c++) {
+                    const char *kernel = miner_get_kernel_name(c);
+                    if (!kernel || win[TS_WINDOW_24H].coreHashRate[c] == 0) continue;
+                    Serial.printf("[STATS] Core%u (%s) 1m/15m/1h: %.0f / %.0f / %.0f H/s\n",
+                        c, kernel, win[TS_WINDOW_1M].coreHashRate[c],
+                        win[TS_WINDOW_15M].coreHashRate[c], win[TS_WINDOW_1H].coreHashRate[c]);
+                }
+                Serial.printf("[STATS] Shares/min 15m/1h/24h: %.2f / %.2f / %.2f | Rejects 1h: %.1f%% | Jobs 15m: %u\n",
+                    win[TS_WINDOW_15M].sharesPerMin, win[TS_WINDOW_1H].sharesPerMin,
+                    win[TS_WINDOW_24H].sharesPerMin, win[TS_WINDOW_1H].rejectPercent,
+                    win[TS_WINDOW_15M].jobSwitches);
+
+                // Efficiency: compare kernels, clocks and Core 0 on/off by these
+                power_stats_t power;
+                power_get_stats(&power);
+                if (power.hashesPerJoule > 0) {
+                    Serial.printf("[STATS] Power: %.0f mW (%s) | %.0f H/J | %.1f J/GH | %lu MHz\n",
+                        power.avgMilliwatts, power_source_name(power.source),
+                        power.hashesPerJoule, power.joulesPerGh, getCpuFrequencyMhz());
+                }
+
+                // Job handoff timing (build on stratum task, pickup on mining cores)
+                Serial.printf("[STATS] Job build: %u us | Switch: %u us (max %u us)\n",
+                    mstats->lastBuildUs, mstats->lastSwitchUs, mstats->maxSwitchUs);
+                if (mstats->shares > 0) {
+                    Serial.printf("[STATS] Submit queue: %u us (max %u us)\n",
+                        mstats->lastSubmitQueueUs, mstats->maxSubmitQueueUs);
+                    Serial.printf("[STATS] Share RTT: p50 %u ms, p95 %u ms | Timeouts: %u | Late: %u | Keepalive: %u ms (%u lost)\n",
+                        mstats->latencyP50, mstats->latencyP95, mstats->shareTimeouts,
+                        mstats->lateResponses, mstats->controlLatency, mstats->controlTimeouts);
+                }
+                if (mstats->staleDropped > 0 || mstats->deferredJobs > 0) {
+                    Serial.printf("[STATS] Stale shares dropped: %u | Notifies deferred: %u\n",
+                        mstats->staleDropped, mstats->deferredJobs);
+                }
+                // Hashing time lost to yields since the last print, per core
+                uint32_t nowMs = millis();
+                uint32_t spanMs = nowMs - s_lastYieldMs;
+                if (s_lastYieldMs && spanMs > 0) {
+                    uint32_t c0 = (uint32_t)((uint64_t)(mstats->yieldUs[0] - s_lastYieldUs[0]) * 1000 / spanMs);
+                    uint32_t c1 = (uint32_t)((uint64_t)(mstats->yieldUs[1] - s_lastYieldUs[1]) * 1000 / spanMs);
+                    Serial.printf("[STATS] Yield: Core0 %u us/s (every %u hashes) | Core1 %u us/s (every %u returns)\n",
+                        c0, mstats->yieldInterval[0], c1, mstats->yieldInterval[1]);
+                }
+                s_lastYieldUs[0] = mstats->yieldUs[0];
+                s_lastYieldUs[1] = mstats->yieldUs[1];
+                s_lastYieldMs = nowMs;
+                if (mstats->ntimeRolls > 0 || mstats->versionRolls > 0 || mstats->extraNonceRolls > 0) {
+                    Serial.printf("[STATS] Rolls: ntime %u | version %u | extranonce2 %u (%u built inline)\n",
+                        mstats->ntimeRolls, mstats->versionRolls, mstats->extraNonceRolls, mstats->rollStalls);
+                }
+                if (mstats->candidateDrops > 0) {
+                    Serial.printf("[STATS] Verify ring full: %u candidates dropped\n", mstats->candidateDrops);
+                }
+                if (s_sleeps > 0) {
+                    monitor_sleep_stats_t st;
+                    monitor_get_sleep_stats(&st);
+                    Serial.printf("[STATS] Screen %s: Core0 %.0f H/s on, %.0f H/s off (%+.1f%%) over %lu s off\n",
+                        st.asleep ? "off" : "on", st.core0Awake, st.core0Asleep, core0Gain(&st),
+                        st.asleepSeconds);
+                }
 
                 // Heap monitoring - track memory usage over time
                 uint32_t freeHeap = ESP.getFreeHeap();
@@ -323,6 +607,15 @@ void monitor_task(void *param) {
         }
         #endif
 
+        // Boot -> first hash, once (fast boot tuning)
+        static bool bootLogged = false;
+        if (!bootLogged && miner_get_stats()->firstHashMs) {
+            bootLogged = true;
+            mining_stats_t *bstats = miner_get_stats();
+            Serial.printf("[BOOT] First hash %lu ms after boot (WiFi %lu ms, first job %lu ms)\n",
+                bstats->firstHashMs, wifi_manager_connect_ms(), bstats->firstJobMs);
+        }
+
         // Persistence save logic with early save for new sessions
         // - Save on first accepted share (immediate feedback)
         // - Save every 5 minutes until first hourly save
@@ -340,7 +633,7 @@ void monitor_task(void *param) {
 
         // Check for periodic save (early interval or standard interval)
         uint32_t saveInterval = s_earlySaveDone ? PERSIST_STATS_MS : EARLY_SAVE_MS;
-        if (now - s_lastPersistSave >= saveInterval) {
+        if (!s_savePending && now - s_lastPersistSave >= saveInterval) {
             shouldSave = true;
             saveReason = s_earlySaveDone ? "hourly" : "early";
             if (!s_earlySaveDone) {
@@ -348,8 +641,22 @@ void monitor_task(void *param) {
             }
         }
 
-        if (shouldSave) {
-            uint32_t sessionSeconds = (now - s_startTime) / 1000;
+        if (shouldSave && !s_savePending) {
+            s_savePending = true;
+            s_saveReason = saveReason;
+            s_savePendingSince = now;
+            s_savePendingJobs = mstats->templates;
+        }
+
+        // A flash write stalls everything outside IRAM on both cores: do it
+        // as a new job comes in, when the miners restart their ranges anyway
+        if (s_savePending && (mstats->templates != s_savePendingJobs ||
+                              now - s_savePendingSince >= STATS_SAVE_ALIGN_MS)) {
+            s_savePending = false;
+            saveReason = s_saveReason;
+
+            // Uptime since the last save (the totals already hold the rest)
+            uint32_t sessionSeconds = (now - s_startTime) / 1000 - s_sessionStartSeconds;
 
             // Calculate session deltas (hashes added since last save)
             uint64_t sessionHashes = mstats->hashes - s_sessionStartHashes;
@@ -369,11 +676,17 @@ void monitor_task(void *param) {
             s_sessionStartAccepted = mstats->accepted;
             s_sessionStartRejected = mstats->rejected;
             s_sessionStartBlocks = mstats->blocks;
+            s_sessionStartSeconds += sessionSeconds;
 
-            Serial.printf("[MONITOR] Stats saved to NVS (%s)\n", saveReason);
+            Serial.printf("[MONITOR] Stats saved (%s)\n", saveReason);
             s_lastPersistSave = now;
         }
 
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        if (s_asleep) {
+            // Nothing to draw: wait for the next sample or a button press
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISPLAY_UPDATE_MS));
+        } else {
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+        }
     }
 }
@@ -19,4 +19,41 @@ void monitor_init();
  */
 void monitor_task(void *param);
 
+/**
+ * Request a benchmark run
+ * The monitor task runs it at its next pass (mining pauses for a few
+ * seconds) and prints the results as a single JSON line on serial.
+ * Safe to call from any task.
+ */
+void monitor_request_benchmark();
+
+/**
+ * Core 0 hashrate with the screen on and off (see screen_timeout)
+ * Rates are averaged over all the time spent in each state since boot.
+ */
+typedef struct {
+    bool asleep;                // Screen is off now
+    uint32_t sleeps;            // Times the screen timed out
+    uint32_t asleepSeconds;     // Total time spent with the screen off
+    float core0Awake;           // Core 0 H/s with the screen on
+    float core0Asleep;          // Core 0 H/s with the screen off (0 until it has slept)
+} monitor_sleep_stats_t;
+
+/**
+ * Restart the screen timeout, waking the screen if it is off
+ * Safe to call from any task; the monitor task does the redraw.
+ * @return true if the screen was off
+ */
+bool monitor_wake();
+
+/**
+ * True while the screen is off after screen_timeout
+ */
+bool monitor_is_asleep();
+
+/**
+ * Copy the screen-on/off hashrate counters
+ */
+void monitor_get_sleep_stats(monitor_sleep_stats_t *out);
+
 #endif // MONITOR_H
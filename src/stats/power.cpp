@@ -0,0 +1,200 @@
+/*
+ * SparkMiner - Power Monitoring Implementation
+ * See power.h.
+ */
+
+#include <Arduino.h>
+#include "power.h"
+#include "../mining/miner.h"
+
+#if USE_POWER_SENSOR
+#include <Wire.h>
+
+// Shared registers; the INA226 adds the id registers
+#define INA_REG_CONFIG      0x00
+#define INA_REG_SHUNT       0x01
+#define INA_REG_BUS         0x02
+#define INA226_REG_MFR_ID   0xFE
+#define INA226_MFR_TI       0x5449
+
+// Continuous shunt and bus conversions, averaged in the sensor:
+// INA219 32 V range, +-320 mV shunt, 128 samples (68 ms per result)
+// INA226 16 samples of 1.1 ms each
+#define INA219_CONFIG       0x3FFF
+#define INA226_CONFIG       0x4527
+#endif
+
+static power_stats_t s_stats = {0};
+static uint32_t s_lastSample = 0;
+
+// Current window
+static uint32_t s_windowStart = 0;
+static double s_windowJoules = 0;
+static uint64_t s_windowHashes = 0;
+static uint64_t s_windowCore0 = 0;
+static uint32_t s_windowMhz = 0;      // 0 once the clock moved
+
+// ============================================================
+// Sensor
+// ============================================================
+
+#if USE_POWER_SENSOR
+
+static bool readReg(uint8_t reg, uint16_t *out) {
+    Wire.beginTransmission(POWER_I2C_ADDR);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) return false;
+    if (Wire.requestFrom((uint8_t)POWER_I2C_ADDR, (uint8_t)2) != 2) return false;
+    uint16_t hi = Wire.read();
+    uint16_t lo = Wire.read();
+    *out = (hi << 8) | lo;
+    return true;
+}
+
+static bool writeReg(uint8_t reg, uint16_t value) {
+    Wire.beginTransmission(POWER_I2C_ADDR);
+    Wire.write(reg);
+    Wire.write(value >> 8);
+    Wire.write(value & 0xFF);
+    return Wire.endTransmission() == 0;
+}
+
+static uint8_t probeSensor() {
+    Wire.begin(POWER_SDA_PIN, POWER_SCL_PIN);   // No-op if the OLED started the bus
+    Wire.setClock(POWER_I2C_CLOCK);
+
+    uint16_t id;
+    if (readReg(INA226_REG_MFR_ID, &id) && id == INA226_MFR_TI) {
+        return writeReg(INA_REG_CONFIG, INA226_CONFIG) ? POWER_SOURCE_INA226 : POWER_SOURCE_MODEL;
+    }
+    if (readReg(INA_REG_CONFIG, &id)) {
+        return writeReg(INA_REG_CONFIG, INA219_CONFIG) ? POWER_SOURCE_INA219 : POWER_SOURCE_MODEL;
+    }
+    return POWER_SOURCE_MODEL;
+}
+
+// Latest averaged conversion; never waits for one
+static bool readSensor() {
+    uint16_t shunt, bus;
+    if (!readReg(INA_REG_SHUNT, &shunt) || !readReg(INA_REG_BUS, &bus)) {
+        s_stats.errors++;
+        return false;
+    }
+
+    float shuntUv, busMv;
+    if (s_stats.source == POWER_SOURCE_INA226) {
+        shuntUv = (int16_t)shunt * 2.5f;
+        busMv = bus * 1.25f;
+    } else {
+        shuntUv = (int16_t)shunt * 10.0f;
+        busMv = (bus >> 3) * 4.0f;
+    }
+    // uV over mOhm is mA
+    s_stats.milliamps = shuntUv / POWER_SHUNT_MOHM;
+    s_stats.busVolts = busMv / 1000.0f;
+    s_stats.milliwatts = s_stats.busVolts * s_stats.milliamps;
+    if (s_stats.milliwatts < 0) s_stats.milliwatts = -s_stats.milliwatts;  // Shunt wired backwards
+    return true;
+}
+
+#endif  // USE_POWER_SENSOR
+
+// ============================================================
+// Helpers
+// ============================================================
+
+// Board model at the nearest governor step
+static float modelMw(uint32_t mhz) {
+    if (mhz <= 80) return GOVERNOR_MW_80;
+    if (mhz <= 160) return GOVERNOR_MW_160;
+    return GOVERNOR_MW_240;
+}
+
+static void windowStart(uint32_t now, const mining_stats_t *mstats) {
+    s_windowStart = now;
+    s_windowJoules = 0;
+    s_windowHashes = mstats->hashes;
+    s_windowCore0 = mstats->coreHashes[0];
+    s_windowMhz = getCpuFrequencyMhz();
+}
+
+static void windowEnd(uint32_t now, const mining_stats_t *mstats) {
+    uint64_t hashes = mstats->hashes - s_windowHashes;
+    uint32_t ms = now - s_windowStart;
+
+    s_stats.avgMilliwatts = ms ? s_windowJoules * 1e6 / ms : 0;
+    s_stats.windowMhz = s_windowMhz;
+    s_stats.windowCore0 = mstats->coreHashes[0] != s_windowCore0;
+    if (hashes && s_windowJoules > 0) {
+        s_stats.hashesPerJoule = hashes / s_windowJoules;
+        s_stats.joulesPerGh = s_windowJoules * 1e9 / hashes;
+    } else {
+        s_stats.hashesPerJoule = 0;
+        s_stats.joulesPerGh = 0;
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void power_init() {
+#if USE_POWER_SENSOR
+    s_stats.source = probeSensor();
+    s_stats.measured = s_stats.source != POWER_SOURCE_MODEL;
+    if (s_stats.measured) {
+        Serial.printf("[POWER] %s at 0x%02x, %u mOhm shunt\n",
+                      power_source_name(s_stats.source), POWER_I2C_ADDR, POWER_SHUNT_MOHM);
+    } else {
+        Serial.printf("[POWER] No sensor at 0x%02x - using the board model\n", POWER_I2C_ADDR);
+    }
+#else
+    s_stats.source = POWER_SOURCE_MODEL;
+#endif
+
+    uint32_t now = millis();
+    s_lastSample = now;
+    windowStart(now, miner_get_stats());
+}
+
+void power_sample() {
+    uint32_t now = millis();
+    uint32_t dt = now - s_lastSample;
+    if (dt < POWER_SAMPLE_MS) return;
+    s_lastSample = now;
+
+    uint32_t mhz = getCpuFrequencyMhz();
+    if (mhz != s_windowMhz) s_windowMhz = 0;
+
+    bool fromSensor = false;
+#if USE_POWER_SENSOR
+    if (s_stats.measured) fromSensor = readSensor();
+#endif
+    if (!fromSensor) {
+        s_stats.milliwatts = modelMw(mhz);
+    }
+
+    // The draw held since the last sample
+    double joules = s_stats.milliwatts * dt / 1e6;
+    s_stats.joules += joules;
+    s_windowJoules += joules;
+    s_stats.samples++;
+
+    if (now - s_windowStart >= POWER_WINDOW_MS) {
+        mining_stats_t *mstats = miner_get_stats();
+        windowEnd(now, mstats);
+        windowStart(now, mstats);
+    }
+}
+
+const char *power_source_name(uint8_t source) {
+    switch (source) {
+        case POWER_SOURCE_INA219: return "ina219";
+        case POWER_SOURCE_INA226: return "ina226";
+        default:                  return "model";
+    }
+}
+
+void power_get_stats(power_stats_t *out) {
+    memcpy(out, &s_stats, sizeof(*out));
+}
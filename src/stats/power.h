@@ -0,0 +1,74 @@
+/*
+ * SparkMiner - Power Monitoring
+ * Board draw and mining efficiency (hashes per joule, joules per GH) for
+ * comparing kernels, clocks and Core 0 software mining on efficiency
+ * rather than peak rate.
+ *
+ * With USE_POWER_SENSOR=1 the draw comes from an INA219 or INA226 on I2C
+ * (told apart by the INA226's manufacturer id), left in continuous,
+ * averaged conversion mode so a sample is two short register reads and
+ * never waits for a conversion. The sensor shares Wire with an OLED;
+ * both are only touched from the monitor task. Without a sensor, or when
+ * it stops answering, the draw is the board's GOVERNOR_MW_* model at the
+ * current CPU clock.
+ *
+ * Efficiency is hashes over energy across POWER_WINDOW_MS, both counted
+ * over the same window, so dips and clock switches weigh in correctly.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+/**
+ * Where the draw comes from
+ */
+typedef enum {
+    POWER_SOURCE_MODEL = 0,     // Per-board estimate
+    POWER_SOURCE_INA219,
+    POWER_SOURCE_INA226
+} power_source_t;
+
+/**
+ * Power readings and efficiency
+ */
+typedef struct {
+    uint8_t source;             // power_source_t
+    bool measured;              // A sensor supplies the draw
+    float busVolts;             // Sensor only
+    float milliamps;            // Sensor only
+    float milliwatts;           // Last sample
+    float avgMilliwatts;        // Last window
+    double joules;              // Energy since boot
+    double hashesPerJoule;      // Last window (the same as H/W); 0 = not mining
+    double joulesPerGh;         // Last window
+    uint32_t windowMhz;         // CPU clock through the last window, 0 if it changed
+    bool windowCore0;           // Core 0 hashed during the last window
+    uint32_t samples;
+    uint32_t errors;            // Failed sensor reads
+} power_stats_t;
+
+/**
+ * Probe the sensor (if built in) and start the energy count
+ */
+void power_init();
+
+/**
+ * Take a sample if one is due (cheap otherwise)
+ * Call from the monitor task loop.
+ */
+void power_sample();
+
+/**
+ * Source name for logs and metric labels ("model", "ina219", "ina226")
+ */
+const char *power_source_name(uint8_t source);
+
+/**
+ * Copy the power readings
+ */
+void power_get_stats(power_stats_t *out);
+
+#endif // POWER_H
@@ -0,0 +1,332 @@
+/*
+ * SparkMiner - SD Card Logger Implementation
+ * See sd_log.h.
+ */
+
+#include <Arduino.h>
+#include <time.h>
+#include "sd_log.h"
+#include "timeseries.h"
+#include "mem_budget.h"
+#include "../config/nvs_config.h"
+#include "../mining/miner.h"
+
+#if USE_SD_LOG && (defined(USE_SD_MMC) || defined(SD_CS_PIN))
+    #define SD_LOG_ENABLED 1
+#else
+    #define SD_LOG_ENABLED 0
+#endif
+
+static sd_log_stats_t s_stats = {0};
+
+#if SD_LOG_ENABLED
+
+#if (SD_LOG_QUEUE & (SD_LOG_QUEUE - 1)) != 0
+    #error "SD_LOG_QUEUE must be a power of two"
+#endif
+
+#define SD_LOG_PATH     SD_LOG_DIR "/mining.csv"
+#define SD_LOG_LINE_MAX 160     // Longest formatted row
+#define SD_LOG_POLL_MS  1000    // Ring drain interval
+#define SD_LOG_RATE_MS  60000   // Hashrate row interval
+
+static const char HEADER[] =
+    "# S,ms,epoch,job,nonce,difficulty,latency_ms,flags,result,reason\n"
+    "# H,ms,epoch,hashrate,core0,core1,accepted,rejected,pool_difficulty\n";
+
+typedef struct {
+    uint32_t ms;
+    uint32_t epoch;
+    uint32_t nonce;
+    uint32_t latencyMs;
+    uint32_t flags;
+    double difficulty;
+    bool accepted;
+    char jobId[32];             // Truncated; pool job ids are short hex
+    char reason[24];
+} sd_log_share_t;
+
+// Bounded multi-producer ring: a slot's sequence number says whether it is
+// free for the producer at that position or filled for the consumer
+typedef struct {
+    volatile uint32_t seq;
+    sd_log_share_t rec;
+} sd_log_cell_t;
+
+static sd_log_cell_t s_ring[SD_LOG_QUEUE];
+static uint32_t s_enqueuePos = 0;
+static uint32_t s_dequeuePos = 0;       // Logger task only
+
+// Rows waiting for the card; the tail past one block waits for the next write
+static char s_buf[SD_LOG_BLOCK + SD_LOG_LINE_MAX + sizeof(HEADER)] __attribute__((aligned(4)));
+static size_t s_fill = 0;
+static uint32_t s_fileSize = 0;
+static uint32_t s_lastFlush = 0;
+
+STATIC_TASK(s_sdLogTask, SD_LOG_STACK);
+
+// ============================================================
+// Ring
+// ============================================================
+
+static bool ringPush(const sd_log_share_t *rec) {
+    uint32_t pos = __atomic_load_n(&s_enqueuePos, __ATOMIC_RELAXED);
+    sd_log_cell_t *cell;
+    while (true) {
+        cell = &s_ring[pos & (SD_LOG_QUEUE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&s_enqueuePos, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;   // Full
+        } else {
+            pos = __atomic_load_n(&s_enqueuePos, __ATOMIC_RELAXED);
+        }
+    }
+    cell->rec = *rec;
+    __atomic_store_n(&cell->seq, pos + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+static bool ringPop(sd_log_share_t *rec) {
+    sd_log_cell_t *cell = &s_ring[s_dequeuePos & (SD_LOG_QUEUE - 1)];
+    if ((int32_t)(__atomic_load_n(&cell->seq, __ATOMIC_ACQUIRE) - (s_dequeuePos + 1)) < 0) {
+        return false;       // Empty
+    }
+    *rec = cell->rec;
+    __atomic_store_n(&cell->seq, s_dequeuePos + SD_LOG_QUEUE, __ATOMIC_RELEASE);
+    s_dequeuePos++;
+    return true;
+}
+
+// ============================================================
+// Files
+// ============================================================
+
+static uint32_t epochNow() {
+    time_t t = time(NULL);
+    return t > 1600000000 ? (uint32_t)t : 0;    // Not set over NTP yet
+}
+
+static void rotatedPath(char *out, size_t len, uint32_t n) {
+    snprintf(out, len, SD_LOG_DIR "/mining.%lu.csv", n);
+}
+
+// mining.csv -> mining.1.csv, dropping the oldest (card held by the caller)
+static void rotate(fs::FS *sd) {
+    char from[40], to[40];
+    rotatedPath(to, sizeof(to), SD_LOG_FILES);
+    sd->remove(to);
+    for (uint32_t n = SD_LOG_FILES - 1; n >= 1; n--) {
+        rotatedPath(from, sizeof(from), n);
+        rotatedPath(to, sizeof(to), n + 1);
+        if (sd->exists(from)) sd->rename(from, to);
+    }
+    rotatedPath(to, sizeof(to), 1);
+    sd->rename(SD_LOG_PATH, to);
+    s_fileSize = 0;
+    s_stats.rotations++;
+}
+
+// Append the first len buffered bytes. A failed write drops them: a card
+// that went away must not back the ring up.
+static void writeOut(size_t len) {
+    if (!len) return;
+
+    uint32_t start = micros();
+    fs::FS *sd = nvs_sd_lock();
+    size_t written = 0;
+    bool rotated = false;
+    if (sd) {
+        File file = sd->open(SD_LOG_PATH, FILE_APPEND);
+        if (file) {
+            written = file.write((const uint8_t *)s_buf, len);
+            file.close();
+        }
+        if (written == len) {
+            s_fileSize += len;
+            if (s_fileSize >= SD_LOG_MAX_BYTES) {
+                rotate(sd);
+                rotated = true;
+            }
+        }
+        nvs_sd_unlock();
+    }
+
+    uint32_t us = micros() - start;
+    s_stats.lastWriteUs = us;
+    if (us > s_stats.maxWriteUs) s_stats.maxWriteUs = us;
+    s_stats.writes++;
+    s_stats.bytes += written;
+    if (written != len) {
+        s_stats.errors++;
+        __atomic_fetch_add(&s_stats.dropped, 1, __ATOMIC_RELAXED);
+        Serial.printf("[SDLOG] Write failed, %u bytes dropped\n", (unsigned)len);
+    }
+
+    memmove(s_buf, s_buf + len, s_fill - len);
+    s_fill -= len;
+    s_lastFlush = millis();
+
+    // Every file starts with the column header
+    if (rotated) {
+        memmove(s_buf + sizeof(HEADER) - 1, s_buf, s_fill);
+        memcpy(s_buf, HEADER, sizeof(HEADER) - 1);
+        s_fill += sizeof(HEADER) - 1;
+    }
+}
+
+static void appendRow(const char *row, int len) {
+    if (len <= 0 || len >= SD_LOG_LINE_MAX) return;
+    memcpy(s_buf + s_fill, row, len);
+    s_fill += len;
+    s_stats.records++;
+
+    // Full block: write up to the file's next block boundary
+    uint32_t toBoundary = SD_LOG_BLOCK - (s_fileSize % SD_LOG_BLOCK);
+    if (s_fill >= toBoundary) {
+        writeOut(toBoundary);
+    }
+}
+
+// ============================================================
+// Rows
+// ============================================================
+
+static void shareRow(const sd_log_share_t *r) {
+    char row[SD_LOG_LINE_MAX];
+    int len = snprintf(row, sizeof(row), "S,%lu,%lu,%s,%08lx,%.4f,%lu,%lx,%s,%s\n",
+                       r->ms, r->epoch, r->jobId, r->nonce, r->difficulty, r->latencyMs,
+                       r->flags, r->accepted ? "accepted" : "rejected", r->reason);
+    appendRow(row, len);
+}
+
+static void hashrateRow() {
+    ts_window_stats_t win;
+    if (!timeseries_get(TS_WINDOW_1M, &win)) return;
+
+    char row[SD_LOG_LINE_MAX];
+    int len = snprintf(row, sizeof(row), "H,%lu,%lu,%.0f,%.0f,%.0f,%lu,%lu,%.4f\n",
+                       millis(), epochNow(), win.hashRate, win.coreHashRate[0],
+                       win.coreHashRate[1], win.accepted, win.rejected, miner_get_difficulty());
+    appendRow(row, len);
+}
+
+// ============================================================
+// Task
+// ============================================================
+
+static void sd_log_task(void *param) {
+    uint32_t lastRate = millis();
+    sd_log_share_t rec;
+
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(SD_LOG_POLL_MS));
+
+        while (ringPop(&rec)) {
+            shareRow(&rec);
+        }
+
+        uint32_t now = millis();
+        if (now - lastRate >= SD_LOG_RATE_MS) {
+            lastRate = now;
+            hashrateRow();
+        }
+
+        // Partial block: only once it has waited long enough
+        if (s_fill && now - s_lastFlush >= SD_LOG_FLUSH_MS) {
+            writeOut(s_fill);
+        }
+    }
+}
+
+#endif  // SD_LOG_ENABLED
+
+// ============================================================
+// Public API
+// ============================================================
+
+bool sd_log_init() {
+#if !SD_LOG_ENABLED
+    return false;
+#else
+    if (s_stats.active) return true;
+
+    fs::FS *sd = nvs_sd_lock();
+    if (!sd) {
+        Serial.println("[SDLOG] No SD card - logging disabled");
+        return false;
+    }
+    if (!sd->exists(SD_LOG_DIR)) sd->mkdir(SD_LOG_DIR);
+    File file = sd->open(SD_LOG_PATH, FILE_APPEND);
+    bool ok = file;
+    if (file) {
+        s_fileSize = file.size();
+        file.close();
+    }
+    nvs_sd_keep_mounted(ok);
+    nvs_sd_unlock();
+    if (!ok) {
+        Serial.println("[SDLOG] Cannot open " SD_LOG_PATH " - logging disabled");
+        return false;
+    }
+
+    for (uint32_t i = 0; i < SD_LOG_QUEUE; i++) {
+        s_ring[i].seq = i;
+    }
+    if (s_fileSize == 0) {
+        memcpy(s_buf, HEADER, sizeof(HEADER) - 1);
+        s_fill = sizeof(HEADER) - 1;
+    }
+    s_lastFlush = millis();
+    s_stats.active = true;
+
+    mem_budget_add("sdlog", "ring + block buffer", sizeof(s_ring) + sizeof(s_buf));
+    mem_task_create(
+        sd_log_task,
+        "SDLog",
+        NULL,
+        SD_LOG_PRIORITY,
+        SD_LOG_CORE,
+        "sdlog",
+        STATIC_TASK_MEM(s_sdLogTask)
+    );
+
+    Serial.printf("[SDLOG] Logging to " SD_LOG_PATH " (%lu bytes so far)\n", s_fileSize);
+    return true;
+#endif
+}
+
+void sd_log_share(const submit_entry_t *entry, bool accepted, const char *reason, uint32_t latencyMs) {
+#if SD_LOG_ENABLED
+    if (!s_stats.active) return;
+
+    sd_log_share_t rec;
+    rec.ms = millis();
+    rec.epoch = epochNow();
+    rec.nonce = entry->nonce;
+    rec.latencyMs = latencyMs;
+    rec.flags = entry->flags;
+    rec.difficulty = entry->difficulty;
+    rec.accepted = accepted;
+    strncpy(rec.jobId, entry->jobId, sizeof(rec.jobId) - 1);
+    rec.jobId[sizeof(rec.jobId) - 1] = '\0';
+    // Commas would split the CSV column
+    size_t i = 0;
+    for (; reason && reason[i] && i < sizeof(rec.reason) - 1; i++) {
+        rec.reason[i] = reason[i] == ',' ? ';' : reason[i];
+    }
+    rec.reason[i] = '\0';
+
+    if (!ringPush(&rec)) {
+        __atomic_fetch_add(&s_stats.dropped, 1, __ATOMIC_RELAXED);
+    }
+#endif
+}
+
+void sd_log_get_stats(sd_log_stats_t *out) {
+    memcpy(out, &s_stats, sizeof(*out));
+}
@@ -0,0 +1,64 @@
+/*
+ * SparkMiner - SD Card Logger
+ * CSV record of every share result and of the hashrate once a minute, on
+ * the SD card, for analysis off the board.
+ *
+ * Producers only copy a fixed-size record into a lock-free ring: a full
+ * ring drops the record (counted), so the stratum task never waits on the
+ * card. A low-priority Core 0 task drains the ring into a RAM buffer and
+ * writes it out in SD_LOG_BLOCK pieces that end on block boundaries of the
+ * file, or whatever is buffered every SD_LOG_FLUSH_MS.
+ *
+ * Files: SD_LOG_DIR/mining.csv, rotated to mining.1.csv .. mining.N.csv
+ * past SD_LOG_MAX_BYTES. Rows start with their type:
+ *   S,ms,epoch,job,nonce,difficulty,latency_ms,flags,result,reason
+ *   H,ms,epoch,hashrate,core0,core1,accepted,rejected,pool_difficulty
+ * (ms since boot; epoch is 0 until the clock is set over NTP)
+ *
+ * Built in with USE_SD_LOG=1 on boards with an SD slot; the card must be
+ * in at boot.
+ */
+
+#ifndef SD_LOG_H
+#define SD_LOG_H
+
+#include <Arduino.h>
+#include <board_config.h>
+#include "../stratum/stratum_types.h"
+
+/**
+ * Logger counters since boot
+ */
+typedef struct {
+    bool active;                // Card found, task running
+    uint32_t records;           // Rows written to the buffer
+    uint32_t dropped;           // Rows lost to a full ring or a failed write
+    uint32_t writes;            // Card writes
+    uint64_t bytes;             // Bytes written
+    uint32_t errors;            // Failed opens or short writes
+    uint32_t rotations;
+    uint32_t lastWriteUs;       // Last card write, open and close included
+    uint32_t maxWriteUs;
+} sd_log_stats_t;
+
+/**
+ * Mount the card and start the logger task
+ * @return false if the build or the board has no card
+ */
+bool sd_log_init();
+
+/**
+ * Queue a share result (never blocks; any task)
+ * @param entry     The submitted share (jobId, nonce, difficulty, flags)
+ * @param accepted  Pool verdict
+ * @param reason    Rejection reason, "timeout", or NULL
+ * @param latencyMs Submit to result
+ */
+void sd_log_share(const submit_entry_t *entry, bool accepted, const char *reason, uint32_t latencyMs);
+
+/**
+ * Copy the logger counters
+ */
+void sd_log_get_stats(sd_log_stats_t *out);
+
+#endif // SD_LOG_H
@@ -0,0 +1,225 @@
+/*
+ * SparkMiner - Fleet Stats Sharing Implementation
+ * See stats_share.h.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <board_config.h>
+#include "stats_share.h"
+
+// Wire format is fixed: bump STATS_SHARE_VERSION when changing the packet
+static_assert(sizeof(stats_share_packet_t) == 232, "stats_share_packet_t wire size changed");
+
+static int s_fd = -1;
+static uint32_t s_ifAddr = 0;       // Interface the group was joined on
+static uint32_t s_groupAddr = 0;
+static uint32_t s_id = 0;
+
+// ============================================================
+// Helpers
+// ============================================================
+
+uint32_t stats_share_id() {
+    if (!s_id) {
+        s_id = (uint32_t)ESP.getEfuseMac();
+        if (!s_id) s_id = 1;
+    }
+    return s_id;
+}
+
+uint32_t stats_share_wallet_hash(const char *wallet) {
+    uint32_t hash = 2166136261u;
+    while (wallet && *wallet) {
+        hash ^= (uint8_t)*wallet++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Strings off the wire are not trusted to be terminated
+static void copyField(char *dst, const char *src, size_t size) {
+    memcpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+// ============================================================
+// Socket
+// ============================================================
+
+void stats_share_close() {
+    if (s_fd < 0) return;
+    close(s_fd);
+    s_fd = -1;
+    s_ifAddr = 0;
+}
+
+bool stats_share_open() {
+    if (WiFi.status() != WL_CONNECTED) {
+        stats_share_close();
+        return false;
+    }
+
+    uint32_t ifAddr = (uint32_t)WiFi.localIP();
+    if (s_fd >= 0 && ifAddr == s_ifAddr) return true;
+    stats_share_close();
+    if (!ifAddr) return false;
+
+    int fd = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (fd < 0) return false;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(STATS_SHARE_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    s_groupAddr = inet_addr(STATS_SHARE_GROUP);
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr.s_addr = s_groupAddr;
+    mreq.imr_interface.s_addr = ifAddr;
+
+    struct in_addr ifIn;
+    ifIn.s_addr = ifAddr;
+    uint8_t ttl = 1;            // Stay on the local segment
+    uint8_t loop = 0;           // Don't hear our own snapshots
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+        Serial.println("[SHARE] Could not join the stats group");
+        close(fd);
+        return false;
+    }
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &ifIn, sizeof(ifIn));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+
+    s_fd = fd;
+    s_ifAddr = ifAddr;
+    Serial.printf("[SHARE] Listening on %s:%d (id %08lx)\n", STATS_SHARE_GROUP, STATS_SHARE_PORT, stats_share_id());
+    return true;
+}
+
+bool stats_share_receive(stats_share_packet_t *pkt) {
+    if (s_fd < 0) return false;
+
+    // Skip anything malformed, stop at the first good packet
+    while (true) {
+        int n = recvfrom(s_fd, pkt, sizeof(*pkt), MSG_DONTWAIT, NULL, NULL);
+        if (n < 0) return false;
+        if (n != (int)sizeof(*pkt)) continue;
+        if (pkt->magic != STATS_SHARE_MAGIC || pkt->version != STATS_SHARE_VERSION) continue;
+        if (pkt->leaderId == 0 || pkt->leaderId == stats_share_id()) continue;
+        return true;
+    }
+}
+
+bool stats_share_send(const stats_share_packet_t *pkt) {
+    if (s_fd < 0) return false;
+
+    struct sockaddr_in dest;
+    memset(&dest, 0, sizeof(dest));
+    dest.sin_family = AF_INET;
+    dest.sin_port = htons(STATS_SHARE_PORT);
+    dest.sin_addr.s_addr = s_groupAddr;
+    return sendto(s_fd, pkt, sizeof(*pkt), 0, (struct sockaddr *)&dest, sizeof(dest)) == (int)sizeof(*pkt);
+}
+
+// ============================================================
+// Snapshot
+// ============================================================
+
+void stats_share_pack(const live_stats_t *stats, uint32_t walletHash, stats_share_packet_t *pkt) {
+    memset(pkt, 0, sizeof(*pkt));
+    pkt->magic = STATS_SHARE_MAGIC;
+    pkt->version = STATS_SHARE_VERSION;
+    pkt->leaderId = stats_share_id();
+    pkt->walletHash = walletHash;
+
+    if (stats->priceValid) {
+        pkt->flags |= STATS_SHARE_PRICE;
+        pkt->btcPriceUsd = stats->btcPriceUsd;
+    }
+    if (stats->blockValid) {
+        pkt->flags |= STATS_SHARE_BLOCK;
+        pkt->blockHeight = stats->blockHeight;
+    }
+    if (stats->networkValid) {
+        pkt->flags |= STATS_SHARE_NETWORK;
+        pkt->networkHashrateRaw = stats->networkHashrateRaw;
+        pkt->difficultyRaw = stats->difficultyRaw;
+        copyField(pkt->networkHashrate, stats->networkHashrate, sizeof(pkt->networkHashrate));
+        copyField(pkt->networkDifficulty, stats->networkDifficulty, sizeof(pkt->networkDifficulty));
+    }
+    // Difficulty adjustment has no flag of its own; zeros mean not fetched yet
+    pkt->difficultyProgress = stats->difficultyProgress;
+    pkt->difficultyChange = stats->difficultyChange;
+    pkt->difficultyRetargetBlocks = stats->difficultyRetargetBlocks;
+
+    if (stats->feesValid) {
+        pkt->flags |= STATS_SHARE_FEES;
+        pkt->fastestFee = stats->fastestFee;
+        pkt->halfHourFee = stats->halfHourFee;
+        pkt->hourFee = stats->hourFee;
+        pkt->economyFee = stats->economyFee;
+        pkt->minimumFee = stats->minimumFee;
+    }
+    if (stats->poolValid) {
+        pkt->flags |= STATS_SHARE_POOL;
+        pkt->poolWorkersCount = stats->poolWorkersCount;
+        pkt->failovers = stats->failovers;
+        copyField(pkt->poolName, stats->poolName, sizeof(pkt->poolName));
+        copyField(pkt->poolTotalHashrate, stats->poolTotalHashrate, sizeof(pkt->poolTotalHashrate));
+        copyField(pkt->workerHashrate, stats->workerHashrate, sizeof(pkt->workerHashrate));
+        copyField(pkt->poolBestDifficulty, stats->poolBestDifficulty, sizeof(pkt->poolBestDifficulty));
+    }
+}
+
+void stats_share_apply(const stats_share_packet_t *pkt, live_stats_t *stats, bool withPool) {
+    uint32_t now = millis();
+
+    if (pkt->flags & STATS_SHARE_PRICE) {
+        stats->btcPriceUsd = pkt->btcPriceUsd;
+        stats->priceTimestamp = now;
+        stats->priceValid = true;
+    }
+    if (pkt->flags & STATS_SHARE_BLOCK) {
+        stats->blockHeight = pkt->blockHeight;
+        stats->blockTimestamp = now;
+        stats->blockValid = true;
+    }
+    if (pkt->flags & STATS_SHARE_NETWORK) {
+        stats->networkHashrateRaw = pkt->networkHashrateRaw;
+        stats->difficultyRaw = pkt->difficultyRaw;
+        copyField(stats->networkHashrate, pkt->networkHashrate, sizeof(stats->networkHashrate));
+        copyField(stats->networkDifficulty, pkt->networkDifficulty, sizeof(stats->networkDifficulty));
+        stats->networkValid = true;
+    }
+    if (pkt->difficultyRetargetBlocks) {
+        stats->difficultyProgress = pkt->difficultyProgress;
+        stats->difficultyChange = pkt->difficultyChange;
+        stats->difficultyRetargetBlocks = pkt->difficultyRetargetBlocks;
+    }
+    if (pkt->flags & STATS_SHARE_FEES) {
+        stats->fastestFee = pkt->fastestFee;
+        stats->halfHourFee = pkt->halfHourFee;
+        stats->hourFee = pkt->hourFee;
+        stats->economyFee = pkt->economyFee;
+        stats->minimumFee = pkt->minimumFee;
+        stats->feesTimestamp = now;
+        stats->feesValid = true;
+    }
+    if (withPool && (pkt->flags & STATS_SHARE_POOL)) {
+        stats->poolWorkersCount = pkt->poolWorkersCount;
+        stats->failovers = pkt->failovers;
+        copyField(stats->poolName, pkt->poolName, sizeof(stats->poolName));
+        copyField(stats->poolTotalHashrate, pkt->poolTotalHashrate, sizeof(stats->poolTotalHashrate));
+        copyField(stats->workerHashrate, pkt->workerHashrate, sizeof(stats->workerHashrate));
+        copyField(stats->poolBestDifficulty, pkt->poolBestDifficulty, sizeof(stats->poolBestDifficulty));
+        stats->poolValid = true;
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * SparkMiner - Fleet Stats Sharing
+ * One board on the LAN fetches the live stats and multicasts a compact
+ * snapshot; the others apply it instead of polling the APIs themselves.
+ *
+ * Leader election is implicit: a board that hears no leader for
+ * STATS_LEADER_TIMEOUT_MS (plus a random boot jitter) fetches on its own
+ * and starts broadcasting. When two leaders hear each other, the higher
+ * id steps down. Pool stats are per wallet, so they are only taken from a
+ * leader mining to the same wallet; other boards keep fetching them.
+ *
+ * Wire format (UDP to STATS_SHARE_GROUP:STATS_SHARE_PORT, TTL 1,
+ * little-endian, packed): stats_share_packet_t below. Any LAN host (e.g.
+ * next to the stats proxy) can act as leader by sending it with a
+ * leaderId below every board's (ids are the low 32 bits of the MAC).
+ */
+
+#ifndef STATS_SHARE_H
+#define STATS_SHARE_H
+
+#include <Arduino.h>
+#include "live_stats.h"
+
+#define STATS_SHARE_MAGIC       0x534b5053  // "SPKS" on the wire
+#define STATS_SHARE_VERSION     1
+
+// Validity bits in stats_share_packet_t.flags
+#define STATS_SHARE_PRICE       0x01
+#define STATS_SHARE_BLOCK       0x02
+#define STATS_SHARE_NETWORK     0x04
+#define STATS_SHARE_FEES        0x08
+#define STATS_SHARE_POOL        0x10
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;                  // STATS_SHARE_* sections that are valid
+    uint16_t reserved;
+    uint32_t leaderId;
+    uint32_t walletHash;            // FNV-1a of the wallet the pool section is for
+
+    float btcPriceUsd;
+    uint32_t blockHeight;
+
+    double networkHashrateRaw;
+    double difficultyRaw;
+    char networkHashrate[24];
+    char networkDifficulty[24];
+    float difficultyProgress;
+    float difficultyChange;
+    uint32_t difficultyRetargetBlocks;
+
+    int32_t fastestFee;
+    int32_t halfHourFee;
+    int32_t hourFee;
+    int32_t economyFee;
+    int32_t minimumFee;
+
+    int32_t poolWorkersCount;
+    int32_t failovers;
+    char poolName[32];
+    char poolTotalHashrate[24];
+    char workerHashrate[24];
+    char poolBestDifficulty[24];
+} stats_share_packet_t;
+
+/**
+ * This board's leader id (low 32 bits of the MAC, never 0)
+ */
+uint32_t stats_share_id();
+
+/**
+ * FNV-1a hash of a wallet address, as carried in walletHash
+ */
+uint32_t stats_share_wallet_hash(const char *wallet);
+
+/**
+ * Join the multicast group on the current WiFi address
+ * Cheap when already joined; reopens after the address changes.
+ * @return true if the socket is ready
+ */
+bool stats_share_open();
+
+/**
+ * Leave the group (e.g. on WiFi loss)
+ */
+void stats_share_close();
+
+/**
+ * Receive one pending snapshot without blocking
+ * @return true if a valid packet from another board was read
+ */
+bool stats_share_receive(stats_share_packet_t *pkt);
+
+/**
+ * Multicast a snapshot
+ */
+bool stats_share_send(const stats_share_packet_t *pkt);
+
+/**
+ * Fill a packet from the given stats (caller holds the stats lock)
+ */
+void stats_share_pack(const live_stats_t *stats, uint32_t walletHash, stats_share_packet_t *pkt);
+
+/**
+ * Copy the valid sections of a packet into stats (caller holds the lock)
+ * @param withPool  Also take the pool section (same wallet)
+ */
+void stats_share_apply(const stats_share_packet_t *pkt, live_stats_t *stats, bool withPool);
+
+#endif // STATS_SHARE_H
@@ -0,0 +1,178 @@
+/*
+ * SparkMiner - Mining Time Series Implementation
+ * See timeseries.h.
+ */
+
+#include <Arduino.h>
+#include "timeseries.h"
+#include "../mining/miner.h"
+#include "mem_budget.h"
+
+#define MINUTE_MS   60000
+#define HOUR_MS     3600000
+
+// Counter deltas over a stretch of time (a second, a minute or an hour)
+typedef struct {
+    uint64_t hashes[2];
+    uint32_t ms;
+    uint32_t accepted;
+    uint32_t rejected;
+    uint32_t jobs;
+} ts_bucket_t;
+
+// Ring of closed buckets; head counts pushes, the newest is at head - 1
+typedef struct {
+    ts_bucket_t *buckets;
+    uint32_t size;
+    uint32_t head;
+} ts_ring_t;
+
+static ts_bucket_t s_secondBuckets[TS_SECONDS];
+static ts_bucket_t s_minuteBuckets[TS_MINUTES];
+static ts_bucket_t s_hourBuckets[TS_HOURS];
+static ts_ring_t s_seconds = {s_secondBuckets, TS_SECONDS, 0};
+static ts_ring_t s_minutes = {s_minuteBuckets, TS_MINUTES, 0};
+static ts_ring_t s_hours = {s_hourBuckets, TS_HOURS, 0};
+
+static ts_bucket_t s_openMinute;    // Seconds since the last closed minute
+static ts_bucket_t s_openHour;      // Closed minutes since the last closed hour
+
+static SemaphoreHandle_t s_mutex = NULL;
+
+// Counters at the previous sample (sampling task only)
+static bool s_haveBase = false;
+static uint32_t s_lastMs = 0;
+static uint64_t s_lastHashes[2] = {0, 0};
+static uint32_t s_lastAccepted = 0;
+static uint32_t s_lastRejected = 0;
+static uint32_t s_lastJobs = 0;
+
+// ============================================================
+// Buckets
+// ============================================================
+
+static void addBucket(ts_bucket_t *dst, const ts_bucket_t *src) {
+    dst->hashes[0] += src->hashes[0];
+    dst->hashes[1] += src->hashes[1];
+    dst->ms += src->ms;
+    dst->accepted += src->accepted;
+    dst->rejected += src->rejected;
+    dst->jobs += src->jobs;
+}
+
+static void pushBucket(ts_ring_t *ring, const ts_bucket_t *bucket) {
+    ring->buckets[ring->head % ring->size] = *bucket;
+    ring->head++;
+}
+
+// Add the newest count closed buckets (fewer until the ring has filled)
+static void sumNewest(const ts_ring_t *ring, uint32_t count, ts_bucket_t *out) {
+    if (count > ring->head) count = ring->head;
+    for (uint32_t i = 1; i <= count; i++) {
+        addBucket(out, &ring->buckets[(ring->head - i) % ring->size]);
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void timeseries_init() {
+    if (s_mutex) return;
+    s_mutex = xSemaphoreCreateMutex();
+    mem_budget_add("stats", "time series", sizeof(s_secondBuckets) + sizeof(s_minuteBuckets) +
+                   sizeof(s_hourBuckets));
+}
+
+void timeseries_sample() {
+    mining_stats_t *mstats = miner_get_stats();
+    uint32_t now = millis();
+
+    if (!s_haveBase) {
+        s_haveBase = true;
+    } else if (now != s_lastMs) {
+        ts_bucket_t sample;
+        sample.hashes[0] = mstats->coreHashes[0] - s_lastHashes[0];
+        sample.hashes[1] = mstats->coreHashes[1] - s_lastHashes[1];
+        sample.ms = now - s_lastMs;
+        sample.accepted = mstats->accepted - s_lastAccepted;
+        sample.rejected = mstats->rejected - s_lastRejected;
+        sample.jobs = mstats->templates - s_lastJobs;
+
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        pushBucket(&s_seconds, &sample);
+        addBucket(&s_openMinute, &sample);
+        if (s_openMinute.ms >= MINUTE_MS) {
+            pushBucket(&s_minutes, &s_openMinute);
+            addBucket(&s_openHour, &s_openMinute);
+            memset(&s_openMinute, 0, sizeof(s_openMinute));
+            if (s_openHour.ms >= HOUR_MS) {
+                pushBucket(&s_hours, &s_openHour);
+                memset(&s_openHour, 0, sizeof(s_openHour));
+            }
+        }
+        xSemaphoreGive(s_mutex);
+    }
+
+    s_lastMs = now;
+    s_lastHashes[0] = mstats->coreHashes[0];
+    s_lastHashes[1] = mstats->coreHashes[1];
+    s_lastAccepted = mstats->accepted;
+    s_lastRejected = mstats->rejected;
+    s_lastJobs = mstats->templates;
+}
+
+bool timeseries_get(ts_window_t window, ts_window_stats_t *out) {
+    ts_bucket_t sum;
+    memset(&sum, 0, sizeof(sum));
+    memset(out, 0, sizeof(*out));
+    if (!s_mutex) return false;
+
+    // Longer windows end with the partly filled minute (and hour), so they
+    // move as soon as a second is sampled
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    switch (window) {
+        case TS_WINDOW_10S:
+            sumNewest(&s_seconds, 10, &sum);
+            break;
+        case TS_WINDOW_1M:
+            sumNewest(&s_seconds, 60, &sum);
+            break;
+        case TS_WINDOW_15M:
+            sumNewest(&s_minutes, 14, &sum);
+            addBucket(&sum, &s_openMinute);
+            break;
+        case TS_WINDOW_1H:
+            sumNewest(&s_minutes, 59, &sum);
+            addBucket(&sum, &s_openMinute);
+            break;
+        case TS_WINDOW_24H:
+            sumNewest(&s_hours, 23, &sum);
+            addBucket(&sum, &s_openHour);
+            addBucket(&sum, &s_openMinute);
+            break;
+        default:
+            break;
+    }
+    xSemaphoreGive(s_mutex);
+
+    if (sum.ms == 0) return false;
+
+    out->seconds = sum.ms / 1000;
+    out->coreHashRate[0] = (double)sum.hashes[0] * 1000.0 / sum.ms;
+    out->coreHashRate[1] = (double)sum.hashes[1] * 1000.0 / sum.ms;
+    out->hashRate = out->coreHashRate[0] + out->coreHashRate[1];
+    out->accepted = sum.accepted;
+    out->rejected = sum.rejected;
+    out->jobSwitches = sum.jobs;
+
+    uint32_t answered = sum.accepted + sum.rejected;
+    out->sharesPerMin = (float)answered * 60000.0f / sum.ms;
+    out->rejectPercent = answered ? (float)sum.rejected * 100.0f / answered : 0.0f;
+    return true;
+}
+
+const char *timeseries_window_name(ts_window_t window) {
+    static const char *names[TS_WINDOW_COUNT] = {"10s", "1m", "15m", "1h", "24h"};
+    return (window < TS_WINDOW_COUNT) ? names[window] : "?";
+}
@@ -0,0 +1,74 @@
+/*
+ * SparkMiner - Mining Time Series
+ * Fixed-memory rings of per-second mining samples, rolled up into
+ * per-minute and per-hour buckets, with averages over sliding windows
+ *
+ * Cumulative counters only move their averages slowly; these windows show
+ * a throttling core or a pool that stops accepting shares within seconds.
+ * One sample per second from the monitor task; the display, the serial
+ * [STATS] lines and any metrics export read the same windows.
+ *
+ * Memory: (TS_SECONDS + TS_MINUTES + TS_HOURS) buckets of 32 bytes, static.
+ */
+
+#ifndef TIMESERIES_H
+#define TIMESERIES_H
+
+#include <Arduino.h>
+
+#define TS_SECONDS      60      // Per-second samples (10s and 1m windows)
+#define TS_MINUTES      60      // Per-minute buckets (15m and 1h windows)
+#define TS_HOURS        24      // Per-hour buckets (24h window)
+
+/**
+ * Averaging windows
+ */
+typedef enum {
+    TS_WINDOW_10S = 0,
+    TS_WINDOW_1M,
+    TS_WINDOW_15M,
+    TS_WINDOW_1H,
+    TS_WINDOW_24H,
+    TS_WINDOW_COUNT
+} ts_window_t;
+
+/**
+ * Averages over one window
+ * Index 0 of the per-core arrays is the Core 0 software miner, index 1 the
+ * hardware kernel (see miner_get_kernel_name()).
+ */
+typedef struct {
+    uint32_t seconds;           // Time covered (shorter than the window until it has filled)
+    double hashRate;            // H/s, both cores
+    double coreHashRate[2];     // H/s per core
+    uint32_t accepted;          // Shares accepted in the window
+    uint32_t rejected;          // Shares rejected in the window
+    uint32_t jobSwitches;       // Jobs started in the window
+    float sharesPerMin;         // Accepted + rejected per minute
+    float rejectPercent;        // Rejected share of answered shares (0 if none)
+} ts_window_stats_t;
+
+/**
+ * Initialize the rings
+ */
+void timeseries_init();
+
+/**
+ * Take a sample from the mining counters
+ * Call about once per second from one task; the sample covers the time
+ * since the previous call, so a late call is weighted, not lost.
+ */
+void timeseries_sample();
+
+/**
+ * Averages over a window (thread-safe)
+ * @return false if no sample covers it yet
+ */
+bool timeseries_get(ts_window_t window, ts_window_stats_t *out);
+
+/**
+ * Short window label ("10s", "1m", "15m", "1h", "24h")
+ */
+const char *timeseries_window_name(ts_window_t window);
+
+#endif // TIMESERIES_H
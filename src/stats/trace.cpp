@@ -0,0 +1,233 @@
+/*
+ * SparkMiner - Hot-Path Tracing Implementation
+ * See trace.h.
+ */
+
+#include <Arduino.h>
+#include "trace.h"
+
+#if HOT_PATH_TRACE
+
+#include <esp_timer.h>
+#include <hal/cpu_hal.h>
+
+#if (TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) != 0
+    #error "TRACE_RING_SIZE must be a power of two"
+#endif
+
+#define TRACE_BUCKETS   24      // Log2 microsecond buckets, the last one open-ended (8 s+)
+#define TRACE_WRAP_MS   4000    // Beyond this apart, compare ticks: 32-bit cycle counts wrap
+
+// Spans reported by the dump: each "to" event is paired with the latest
+// "from" event before it (with the same tag when byTag is set)
+typedef struct {
+    const char *name;
+    trace_point_t from;
+    trace_point_t to;
+    bool byTag;
+} trace_span_t;
+
+static const trace_span_t SPANS[] = {
+    { "rx>decoded",          TRACE_RX,            TRACE_JOB_DECODED,   false },
+    { "decoded>build",       TRACE_JOB_DECODED,   TRACE_JOB_START,     false },  // Includes deferred notifies
+    { "coinbase+merkle",     TRACE_JOB_START,     TRACE_JOB_HASHED,    false },
+    { "hashed>published",    TRACE_JOB_HASHED,    TRACE_JOB_PUBLISHED, false },
+    { "published>pickup",    TRACE_JOB_PUBLISHED, TRACE_JOB_PICKUP,    false },
+    { "pickup>hashing",      TRACE_JOB_PICKUP,    TRACE_HASHING,       true  },
+    { "published>hashing",   TRACE_JOB_PUBLISHED, TRACE_HASHING,       false },
+    { "candidate>verified",  TRACE_CANDIDATE,     TRACE_VERIFIED,      true  },
+    { "verified>tx",         TRACE_VERIFIED,      TRACE_SHARE_TX,      true  },
+    { "tx>result",           TRACE_SHARE_TX,      TRACE_SHARE_RESULT,  true  },
+};
+
+typedef struct {
+    uint32_t cycles;        // Cycle count, shifted onto the shared time base
+    uint32_t tick;          // FreeRTOS tick, to order events the cycles wrapped between
+    uint32_t tag;
+    uint8_t point;
+} trace_event_t;
+
+// Written by every task on one core: slots are claimed with an atomic add,
+// so a preempted writer never shares its slot
+typedef struct {
+    trace_event_t events[TRACE_RING_SIZE];
+    uint32_t head;          // Free running, masked on access
+} trace_ring_t;
+
+static trace_ring_t s_rings[portNUM_PROCESSORS];
+
+// Each core's cycle counter starts at its own boot time; an offset taken
+// against esp_timer at the first record puts both on one time base
+static uint32_t s_offset[portNUM_PROCESSORS];
+static bool s_calibrated[portNUM_PROCESSORS];
+static uint32_t s_mhz = 0;
+
+static volatile bool s_paused = false;
+
+// ============================================================
+// Recording
+// ============================================================
+
+static void calibrate(uint32_t core, uint32_t cycles) {
+    if (!s_mhz) s_mhz = getCpuFrequencyMhz();
+    s_offset[core] = (uint32_t)(esp_timer_get_time() * s_mhz) - cycles;
+    s_calibrated[core] = true;
+}
+
+void trace_record(trace_point_t point, uint32_t tag) {
+    if (s_paused) return;
+
+    uint32_t core = xPortGetCoreID();
+    uint32_t cycles = cpu_hal_get_cycle_count();
+    if (!s_calibrated[core]) calibrate(core, cycles);
+
+    trace_ring_t *ring = &s_rings[core];
+    uint32_t slot = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    trace_event_t *e = &ring->events[slot & (TRACE_RING_SIZE - 1)];
+    e->cycles = cycles + s_offset[core];
+    e->tick = xTaskGetTickCount();
+    e->tag = tag;
+    e->point = point;
+}
+
+// Stop recording and let writers already past the check finish their entry
+static void pauseRecording() {
+    s_paused = true;
+    vTaskDelay(2);
+}
+
+// ============================================================
+// Dump
+// ============================================================
+
+static uint32_t ringCount(const trace_ring_t *ring) {
+    return ring->head < TRACE_RING_SIZE ? ring->head : TRACE_RING_SIZE;
+}
+
+// Cycles from a to b (negative if b came first)
+static int64_t cyclesBetween(const trace_event_t *a, const trace_event_t *b) {
+    int32_t ms = (int32_t)(b->tick - a->tick) * portTICK_PERIOD_MS;
+    if (ms > TRACE_WRAP_MS || ms < -TRACE_WRAP_MS) {
+        return (int64_t)ms * 1000 * s_mhz;
+    }
+    return (int32_t)(b->cycles - a->cycles);
+}
+
+// Latest matching "from" event at or before b, in cycles (-1 if none)
+static int64_t spanCycles(const trace_span_t *span, const trace_event_t *b) {
+    int64_t best = -1;
+    for (uint32_t c = 0; c < portNUM_PROCESSORS; c++) {
+        const trace_ring_t *ring = &s_rings[c];
+        uint32_t n = ringCount(ring);
+        for (uint32_t i = 0; i < n; i++) {
+            const trace_event_t *a = &ring->events[i];
+            if (a->point != span->from || (span->byTag && a->tag != b->tag)) continue;
+            int64_t d = cyclesBetween(a, b);
+            if (d >= 0 && (best < 0 || d < best)) best = d;
+        }
+    }
+    return best;
+}
+
+// Bucket 0 is under 1 us, bucket k covers [2^(k-1), 2^k) us
+static uint32_t bucketOf(uint32_t us) {
+    uint32_t b = us ? 32 - __builtin_clz(us) : 0;
+    return b < TRACE_BUCKETS ? b : TRACE_BUCKETS - 1;
+}
+
+static uint32_t bucketTop(uint32_t b) {
+    return 1u << b;
+}
+
+// Upper bound of the bucket holding the given share of samples
+static uint32_t percentileTop(const uint32_t *hist, uint32_t n, uint32_t percent) {
+    uint32_t want = (n * percent + 99) / 100, seen = 0;
+    for (uint32_t b = 0; b < TRACE_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen >= want) return bucketTop(b);
+    }
+    return bucketTop(TRACE_BUCKETS - 1);
+}
+
+static void dumpSpan(const trace_span_t *span) {
+    uint32_t hist[TRACE_BUCKETS] = {0};
+    uint32_t n = 0, minUs = UINT32_MAX, maxUs = 0;
+
+    for (uint32_t c = 0; c < portNUM_PROCESSORS; c++) {
+        const trace_ring_t *ring = &s_rings[c];
+        uint32_t count = ringCount(ring);
+        for (uint32_t i = 0; i < count; i++) {
+            const trace_event_t *b = &ring->events[i];
+            if (b->point != span->to) continue;
+            int64_t cycles = spanCycles(span, b);
+            if (cycles < 0) continue;
+
+            uint64_t us64 = (uint64_t)cycles / s_mhz;
+            uint32_t us = us64 > UINT32_MAX ? UINT32_MAX : (uint32_t)us64;
+            hist[bucketOf(us)]++;
+            if (us < minUs) minUs = us;
+            if (us > maxUs) maxUs = us;
+            n++;
+        }
+    }
+    if (!n) return;
+
+    Serial.printf("[TRACE] %-18s n=%-4lu min %lu us | p50 <%lu us | p90 <%lu us | max %lu us\n",
+                  span->name, n, minUs, percentileTop(hist, n, 50), percentileTop(hist, n, 90), maxUs);
+
+    char line[256];
+    int len = snprintf(line, sizeof(line), "[TRACE]   ");
+    for (uint32_t b = 0; b < TRACE_BUCKETS && len < (int)sizeof(line); b++) {
+        if (!hist[b]) continue;
+        len += snprintf(line + len, sizeof(line) - len, " %lu-%lu:%lu",
+                        b ? bucketTop(b - 1) : 0, bucketTop(b), hist[b]);
+    }
+    Serial.println(line);
+}
+
+void trace_dump() {
+    pauseRecording();
+
+    uint32_t total = 0;
+    for (uint32_t c = 0; c < portNUM_PROCESSORS; c++) {
+        total += ringCount(&s_rings[c]);
+    }
+    if (!total || !s_mhz) {
+        Serial.println("[TRACE] Nothing recorded yet");
+        s_paused = false;
+        return;
+    }
+
+    Serial.printf("[TRACE] %lu events (%u per core kept) at %lu MHz, buckets in us\n",
+                  total, TRACE_RING_SIZE, s_mhz);
+    for (size_t i = 0; i < sizeof(SPANS) / sizeof(SPANS[0]); i++) {
+        dumpSpan(&SPANS[i]);
+    }
+    s_paused = false;
+}
+
+void trace_clear() {
+    pauseRecording();
+    for (uint32_t c = 0; c < portNUM_PROCESSORS; c++) {
+        s_rings[c].head = 0;
+    }
+    s_paused = false;
+    Serial.println("[TRACE] Cleared");
+}
+
+#else // !HOT_PATH_TRACE
+
+void trace_record(trace_point_t point, uint32_t tag) {
+    (void)point;
+    (void)tag;
+}
+
+void trace_dump() {
+    Serial.println("[TRACE] Not compiled in (build with -DHOT_PATH_TRACE=1)");
+}
+
+void trace_clear() {
+    trace_dump();
+}
+
+#endif // HOT_PATH_TRACE
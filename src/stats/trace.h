@@ -0,0 +1,63 @@
+/*
+ * SparkMiner - Hot-Path Tracing
+ * Cycle-counter timestamps at fixed points of the job and share paths,
+ * recorded into one lock-free ring per core, with latency histograms
+ * dumped over serial ("trace" command)
+ *
+ * Job path:   rx -> job decoded -> build start -> coinbase/merkle hashed
+ *             -> published -> picked up by a core -> hashing
+ * Share path: candidate -> verified -> submit queued for TX -> pool result
+ *
+ * Compiled in only with HOT_PATH_TRACE=1: otherwise TRACE_POINT() is empty
+ * and the dump just says so. A point costs a cycle-counter read and one
+ * 16-byte ring entry.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+/**
+ * Trace points (put in the order they occur)
+ */
+typedef enum {
+    TRACE_RX = 0,           // Stratum line / V2 frame read
+    TRACE_JOB_DECODED,      // Notify decoded into a job slot
+    TRACE_JOB_START,        // miner_start_job() entered
+    TRACE_JOB_HASHED,       // Coinbase and merkle root done
+    TRACE_JOB_PUBLISHED,    // New job sequence visible to the cores
+    TRACE_JOB_PICKUP,       // Mining loop copied the new job (tag: miner slot)
+    TRACE_HASHING,          // Midstate / kernel prepared, hashing (tag: miner slot)
+    TRACE_CANDIDATE,        // Candidate queued for verify (tag: nonce)
+    TRACE_VERIFIED,         // Candidate verified in software (tag: nonce)
+    TRACE_SHARE_TX,         // Share formatted for sending (tag: nonce)
+    TRACE_SHARE_RESULT,     // Pool answered the share (tag: nonce)
+    TRACE_POINT_COUNT
+} trace_point_t;
+
+#if HOT_PATH_TRACE
+    #define TRACE_POINT(point, tag) trace_record((point), (tag))
+#else
+    #define TRACE_POINT(point, tag) (void)0
+#endif
+
+/**
+ * Record a point on the calling core's ring (any task, not from ISRs)
+ * Use TRACE_POINT() so builds without tracing compile it out.
+ */
+void trace_record(trace_point_t point, uint32_t tag);
+
+/**
+ * Print a latency histogram per traced span on serial
+ * Recording pauses for the dump; call from a low-priority task.
+ */
+void trace_dump();
+
+/**
+ * Drop everything recorded so far
+ */
+void trace_clear();
+
+#endif // TRACE_H
@@ -1,6 +1,6 @@
 /*
  * SparkMiner - Stratum Protocol Implementation
- * Stratum v1 client for pool communication
+ * Stratum v1 and v2 client for pool communication
  *
  * Based on BitsyMiner by Justin Williams (GPL v3)
  */
@@ -8,51 +8,129 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <WiFi.h>
-#include <utility>  // For std::swap
+#include <time.h>
+#include <lwip/sockets.h>     // select()
+#include <esp_vfs_eventfd.h>  // Wakeup fd for the stratum task
+#include <esp_system.h>       // esp_fill_random() for the V2 handshake keys
 #include <board_config.h>
 #include "stratum.h"
 #include "../mining/miner.h"
+#include "stratum_parse.h"
+#include "sv2_codec.h"
+#include "stratum_capture.h"
+#include "stratum_tls.h"
+#include "../stats/trace.h"
+#include "../stats/sd_log.h"
+#include "../stats/mem_budget.h"
+#include "../config/wifi_manager.h"
 
 // ============================================================ 
 // Constants
 // ============================================================ 
 #define STRATUM_MSG_BUFFER  512
+#define STRATUM_RX_BUFFER   (STRATUM_MAX_LINE + 512)
+#define STRATUM_RX_WAIT_MS  5000    // Wait for a complete line during the handshake
+#define STRATUM_TX_BUFFER   (STRATUM_MSG_BUFFER * 4)
 #define RESPONSE_TIMEOUT_MS 3000
 #define KEEPALIVE_MS        120000
 #define INACTIVITY_MS       700000
+#define IDLE_WAKE_MS        1000    // Longest sleep between housekeeping passes
+#define SUBMIT_TIMEOUT_MS   30000   // Share response deadline
+#define CONTROL_TIMEOUT_MS  30000   // Keepalive/control response deadline
+#define JOB_REFRESH_MS      30000   // Non-clean notifies wait until the running job is this old
+#define DNS_CACHE_TTL_MS    600000  // Re-resolve pool hosts after 10 minutes
+#define TCP_KEEPIDLE_S      60      // Probe an idle pool socket after 60 s...
+#define TCP_KEEPINTVL_S     10      // ...every 10 s...
+#define TCP_KEEPCNT         3       // ...and drop it after 3 unanswered probes
+#define SOCKET_RCVBUF       (STRATUM_RX_BUFFER * 2)
+#define PROBE_WAIT_MS       3000    // Subscribe response wait when probing a pool
+
+// Pool list slots; the extra endpoints follow the backup
+#define POOL_PRIMARY        0
+#define POOL_BACKUP         1
+#define STRATUM_MAX_POOLS   (2 + MAX_EXTRA_POOLS)
+#define SV2_SCHEME          "stratum2+tcp://"
+#define TLS_SCHEME          "stratum+ssl://"
+#define TLS_SCHEME_ALT      "stratum+tls://"
+#define SV2_FUTURE_JOBS     2       // Future jobs held for the next SetNewPrevHash
+#define SV2_DEFAULT_HASHRATE 500000.0f  // Nominal H/s before anything was measured
+#define SV2_CLOCK_VALID     1600000000  // time() above this came from SNTP
 
 // ============================================================ 
 // Global State
 // ============================================================ 
 static QueueHandle_t s_submitQueue = NULL;
-static submit_entry_t s_pendingResponses[MAX_PENDING_SUBMISSIONS];
-static uint16_t s_pendingIndex = 0;
-
-static pool_config_t s_primaryPool;
-static pool_config_t s_backupPool;
-static bool s_hasBackupPool = false;
+static int s_wakeFd = -1;   // eventfd: a share was queued (-1 = poll instead)
+
+// Requests awaiting a response, indexed by msgId & (STRATUM_PENDING_SLOTS - 1).
+// Ids are sequential, so a slot only comes round again after
+// STRATUM_PENDING_SLOTS more requests; an entry still there by then has
+// outlived its deadline anyway and is counted as timed out.
+typedef enum { PENDING_FREE = 0, PENDING_SHARE, PENDING_CONTROL } pending_kind_t;
+typedef struct {
+    submit_entry_t entry;   // msgId and sentTime set for both kinds
+    uint32_t deadline;      // millis() after which the request has timed out
+    uint8_t kind;           // pending_kind_t
+} pending_t;
+static pending_t s_pending[STRATUM_PENDING_SLOTS];
+
+// Recent share round trips (ms) for the percentile stats
+static uint32_t s_latencies[STRATUM_LATENCY_WINDOW];
+static uint32_t s_latencyCount = 0;
+
+// Pool endpoints. The primary and the extra endpoints (same wallet) are
+// ranked by latency; the backup, which has its own credentials, is only
+// used while none of them is healthy.
+static pool_config_t s_pools[STRATUM_MAX_POOLS];
 
 static volatile bool s_isConnected = false;
+static stratum_counters_t s_counters = {0};
 static volatile bool s_reconnectRequested = false;
 static char s_currentPoolUrl[MAX_POOL_URL_LEN] = {0};
 
-// Stores the fully authorized username (e.g. "wallet.worker") for use in submissions
-static char s_authorizedWorkerName[MAX_WALLET_LEN + 34] = {0};
-
 static uint32_t s_messageId = 1;
-static uint32_t s_lastActivity = 0;
 static uint32_t s_lastSubmit = 0;
 
+// Difficulty suggestion: configured floor and the hashrate measured over
+// STRATUM_HASHRATE_WINDOW_MS
+static double s_configDifficulty = DESIRED_DIFFICULTY;
+static double s_hashRate = 0;       // H/s (0 = not measured yet)
+static uint64_t s_rateHashes = 0;
+static uint32_t s_rateMs = 0;
+
 // WiFi reconnection state (Issue #4 fix)
 static uint32_t s_wifiReconnectAttempts = 0;
 static uint32_t s_lastWifiReconnectAttempt = 0;
-
-// Extra nonce from subscription
-static char s_extraNonce1[32] = {0};
-static int s_extraNonce2Size = 4;
-
-// JSON document for parsing
-static StaticJsonDocument<4096> s_doc;
+static bool s_wifiSeen = false;         // Setup owns the first join (fast boot starts us before it)
+
+// Current WiFi outage, from the link dropping to mining valid work again
+static uint32_t s_outageStartMs = 0;    // 0 = none
+static uint32_t s_outageLinkMs = 0;     // Time to get the link back (0 = still down)
+
+// JSON document for the handshake and rare methods; mining.notify,
+// set_difficulty and share responses go through stratum_parse_line()
+static StaticJsonDocument<1024> s_doc;
+
+// Recently decoded jobs, newest at (s_jobCount - 1) % STRATUM_JOB_RING.
+// The miner copies what it needs from the newest; older entries stay so
+// late shares can still be matched to the job they were found on.
+static mining_job_bin_t s_jobs[STRATUM_JOB_RING];
+static uint32_t s_jobCount = 0;
+
+// Job generations: jobs numbered below s_cleanFrom (the n-th started job is
+// number n - 1) were invalidated by a clean job or a session switch, and
+// shares found on them are dropped instead of sent. A non-clean job can sit
+// decoded in the next ring slot (s_jobDeferred) until the running job has
+// had JOB_REFRESH_MS; a newer one replaces it there.
+static uint32_t s_cleanFrom = 0;
+static uint32_t s_jobStartMs = 0;
+static bool s_jobDeferred = false;
+
+// Replay of a stratum capture (stratum_capture.h) in place of the pool
+static volatile bool s_replayRequested = false;
+static volatile bool s_replayStop = false;
+static volatile uint32_t s_replaySpeed = 1;     // 0 = no waiting
+static bool s_replaying = false;
 
 // ============================================================ 
 // Utility Functions
@@ -81,34 +159,288 @@ static void formatHex8(char *dest, uint32_t value) {
     dest[8] = '\0';
 }
 
-// Bounded read to prevent stack overflow/OOM from malicious packets
-static String readBoundedLine(WiFiClient& client, size_t maxLen = 4096) {
-    String line;
-    line.reserve(256);  // Initial allocation
-    unsigned long start = millis();
-    
-    while (client.connected() && (millis() - start < 5000)) {
-        if (client.available()) {
-            char c = client.read();
-            if (c == '\n') {
-                return line;
-            }
-            if (line.length() < maxLen) {
-                line += c;
-            } else {
-                // Line too long - read until newline and discard
-                while (client.available()) {
-                     if (client.read() == '\n') break;
-                     if (millis() - start > 5000) break;
-                }
+// ============================================================ 
+// Receive Buffer
+// ============================================================ 
+
+// Inbound bytes for one pool socket. Filled with bulk reads; complete lines
+// are handed out in place (NUL written over the '\n'), so a multi-KB notify
+// costs a few read() calls and no String or heap allocation.
+typedef struct {
+    char buf[STRATUM_RX_BUFFER];
+    size_t start;       // First byte of the next line
+    size_t end;         // End of received data
+    size_t scanned;     // Bytes after start already searched for '\n'
+    bool discarding;    // Dropping the rest of an over-long line
+} stratum_rx_t;
+
+static void rxReset(stratum_rx_t *rx) {
+    rx->start = rx->end = rx->scanned = 0;
+    rx->discarding = false;
+}
+
+// Next complete line, or NULL once timeoutMs passes without one (0 = only
+// what is already buffered or readable). The line stays valid until the next
+// call. Lines over STRATUM_MAX_LINE are dropped up to their newline to
+// protect against OOM from malicious packets.
+static char *rxReadLine(stratum_rx_t *rx, WiFiClient &client, uint32_t timeoutMs) {
+    uint32_t startMs = millis();
+
+    while (true) {
+        char *from = rx->buf + rx->start + rx->scanned;
+        char *nl = (char *)memchr(from, '\n', rx->end - rx->start - rx->scanned);
+        if (nl) {
+            char *line = rx->buf + rx->start;
+            bool dropped = rx->discarding;
+            *nl = '\0';
+            if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+            rx->start = nl + 1 - rx->buf;
+            rx->scanned = 0;
+            rx->discarding = false;
+            if (!dropped && line[0]) return line;
+            continue;
+        }
+        rx->scanned = rx->end - rx->start;
+
+        if (rx->scanned >= STRATUM_MAX_LINE) {
+            if (!rx->discarding) {
                 Serial.println("[STRATUM] WARNING: Line exceeded max length, discarded");
-                return "";  // Return empty to signal error
             }
-        } else {
-            vTaskDelay(1 / portTICK_PERIOD_MS);
+            rxReset(rx);
+            rx->discarding = true;
+        } else if (rx->start > 0) {
+            // Move the partial line to the front to make room
+            memmove(rx->buf, rx->buf + rx->start, rx->scanned);
+            rx->start = 0;
+            rx->end = rx->scanned;
+        }
+
+        int avail = client.available();
+        if (avail > 0) {
+            size_t room = sizeof(rx->buf) - rx->end;
+            int n = client.read((uint8_t *)rx->buf + rx->end, (size_t)avail < room ? avail : room);
+            if (n > 0) {
+                rx->end += n;
+                continue;
+            }
+        }
+
+        if (!client.connected() || millis() - startMs >= timeoutMs) return NULL;
+        vTaskDelay(1 / portTICK_PERIOD_MS);
+    }
+}
+
+// Binary protocols: make at least need bytes available at buf + start.
+// False once timeoutMs passes first (0 = only what is already buffered or
+// readable); whatever arrived stays buffered for the next call.
+static bool rxFill(stratum_rx_t *rx, WiFiClient &client, size_t need, uint32_t timeoutMs) {
+    uint32_t startMs = millis();
+
+    if (rx->start == rx->end) rx->start = rx->end = 0;
+    while (rx->end - rx->start < need) {
+        if (rx->start + need > sizeof(rx->buf)) {
+            memmove(rx->buf, rx->buf + rx->start, rx->end - rx->start);
+            rx->end -= rx->start;
+            rx->start = 0;
+        }
+
+        int avail = client.available();
+        if (avail > 0) {
+            size_t room = sizeof(rx->buf) - rx->end;
+            int n = client.read((uint8_t *)rx->buf + rx->end, (size_t)avail < room ? avail : room);
+            if (n > 0) {
+                rx->end += n;
+                continue;
+            }
         }
+
+        if (!client.connected() || millis() - startMs >= timeoutMs) return false;
+        vTaskDelay(1 / portTICK_PERIOD_MS);
+    }
+    return true;
+}
+
+// ============================================================ 
+// Pool Sessions
+// ============================================================ 
+
+// Stratum V2 channel state: transport ciphers, the open standard channel
+// and what header-only jobs are built from
+typedef struct {
+    uint32_t jobId;
+    uint32_t version;
+    uint8_t merkleRoot[32];
+} sv2_future_job_t;
+
+typedef struct {
+    sv2_cipher_t tx;
+    sv2_cipher_t rx;
+    sv2_header_t header;            // Decrypted header of the frame being received
+    bool haveHeader;
+    uint32_t channelId;
+    uint32_t firstSequence;         // First share id sent since activation
+    bool hasPrevHash;
+    uint8_t prevHash[32];           // From SetNewPrevHash, header byte order
+    uint32_t nbits;
+    sv2_future_job_t future[SV2_FUTURE_JOBS];
+    uint32_t futureCount;
+} sv2_state_t;
+
+// How long each step of the last connect attempt took (ms)
+typedef struct {
+    uint32_t startMs;               // millis() when the attempt began
+    uint32_t dnsMs;
+    uint32_t tcpMs;
+    uint32_t subscribeMs;           // configure + subscribe, or the V2 handshake and setup
+    uint32_t authorizeMs;           // authorize, or opening the V2 channel
+    uint32_t tlsMs;                 // TLS handshake (stratum+ssl pools)
+    bool awaitingJob;               // First job not seen yet
+} connect_phases_t;
+
+// One pool connection and what its handshake negotiated. The active session
+// feeds the miner; the other is the failback probe or, with
+// STRATUM_HOT_STANDBY, a hot standby kept subscribed to the other pool.
+typedef struct {
+    StratumTlsClient client;        // Plain TCP unless the pool is stratum+ssl
+    stratum_rx_t rx;
+    int pool;                       // Index into s_pools
+    bool sv2;                       // Speaks Stratum V2 (set from the pool config)
+    sv2_state_t v2;
+    bool subscribed;                // extraNonce1 valid, notifies can be decoded
+    bool resumed;                   // Pool handed back the previous session's extranonce1
+    char extraNonce1[32];           // From mining.subscribe
+    int extraNonce2Size;
+    bool proxyCarved;               // First extranonce2 byte kept for the LAN proxy (local shares use 00)
+    uint32_t versionMask;           // Granted by mining.configure (0 = not negotiated)
+    char authorizedWorkerName[MAX_WALLET_LEN + 34];  // "wallet.worker", used for submissions
+    double difficulty;              // Last mining.set_difficulty (0 = none yet)
+    double suggested;               // Difficulty last suggested (0 = none yet)
+    uint32_t lastActivity;          // millis() of the last notify
+    uint32_t lastKeepalive;         // millis() of the last standby keepalive
+    mining_job_bin_t job;           // Newest job while not active
+    bool hasJob;
+    connect_phases_t phases;
+} pool_session_t;
+
+static pool_session_t s_sessions[2];
+static pool_session_t *s_active = &s_sessions[0];
+static pool_session_t *s_standby = &s_sessions[1];
+
+// Lost session offered for resume on the next subscribe to the same pool
+typedef struct {
+    int pool;
+    char extraNonce1[32];           // As the pool sent it (no carved proxy byte)
+    int extraNonce2Size;
+} session_resume_t;
+static session_resume_t s_resume = { -1, "", 0 };
+
+static void sessionReset(pool_session_t *session) {
+    rxReset(&session->rx);
+    session->subscribed = false;
+    session->resumed = false;
+    session->extraNonce1[0] = '\0';
+    session->extraNonce2Size = 4;
+    session->proxyCarved = false;
+    session->versionMask = 0;
+    session->difficulty = 0;
+    session->suggested = 0;
+    session->lastActivity = session->lastKeepalive = millis();
+    session->hasJob = false;
+    memset(&session->v2, 0, sizeof(session->v2));
+}
+
+static const pool_config_t *sessionPool(const pool_session_t *session) {
+    return &s_pools[session->pool];
+}
+
+// Completes the phase log once the session has decoded its first job
+static void noteFirstJob(pool_session_t *session) {
+    if (!session->phases.awaitingJob) return;
+    session->phases.awaitingJob = false;
+    Serial.printf("[STRATUM] First job %lu ms after connect started\n", millis() - session->phases.startMs);
+}
+
+static stratum_work_hook_t s_workHook = NULL;
+
+// Tell the LAN proxy about the active session's work (job may be NULL)
+static void reportWork(const pool_session_t *session, const mining_job_bin_t *job, bool restart) {
+    if (!s_workHook || session != s_active || s_replaying) return;
+    stratum_work_t work;
+    work.job = (job && !job->headerOnly) ? job : NULL;
+    work.restart = restart;
+    work.carved = session->proxyCarved;
+    work.difficulty = session->difficulty;
+    work.versionMask = session->versionMask;
+    s_workHook(&work);
+}
+
+// ============================================================ 
+// WiFi Outages
+// ============================================================ 
+
+// Keep what a resumed session needs: the miners stay on its job meanwhile
+static bool sessionRemember(const pool_session_t *session) {
+    if (!STRATUM_SESSION_RESUME || session->sv2 || !session->subscribed) return false;
+    s_resume.pool = session->pool;
+    safeStrCpy(s_resume.extraNonce1, session->extraNonce1, sizeof(s_resume.extraNonce1));
+    s_resume.extraNonce2Size = session->extraNonce2Size;
+    if (session->proxyCarved) {
+        s_resume.extraNonce1[strlen(s_resume.extraNonce1) - 2] = '\0';
+        s_resume.extraNonce2Size++;
+    }
+    return true;
+}
+
+static void outageStart() {
+    if (s_outageStartMs) return;
+    s_outageStartMs = millis() | 1;
+    s_outageLinkMs = 0;
+    s_counters.wifiOutages++;
+    Serial.println(s_isConnected ? "[WIFI] Connection lost, mining on the last job while reconnecting"
+                                 : "[WIFI] Connection lost, reconnecting");
+}
+
+// Mining valid work again: the pool connection survived, the pool resumed
+// the session, or a new session started its first job
+static void outageEnd(const char *how) {
+    if (!s_outageStartMs || !s_outageLinkMs) return;
+    uint32_t ms = millis() - s_outageStartMs;
+    s_outageStartMs = 0;
+    s_counters.lastOutageMs = ms;
+    if (ms > s_counters.maxOutageMs) s_counters.maxOutageMs = ms;
+    s_counters.outageMsTotal += ms;
+    Serial.printf("[WIFI] Outage over in %lu ms (link back after %lu ms, %s)\n", ms, s_outageLinkMs, how);
+}
+
+// ============================================================ 
+// Transmit Buffer
+// ============================================================ 
+
+// Outbound lines, each sent with its newline in one write (like NerdMiner).
+// Submits drained from the queue in one pass are formatted back to back and
+// leave together; only submitShare() leaves bytes here between calls, and
+// the stratum loop flushes them before doing anything else.
+static char s_tx[STRATUM_TX_BUFFER];
+static size_t s_txLen = 0;
+static uint32_t s_txShares = 0;     // Submits in s_tx, counted once written
+
+static bool txFlush(WiFiClient &client) {
+    if (s_txLen == 0) return true;
+
+    bool ok = client.connected() && client.write((const uint8_t *)s_tx, s_txLen) == s_txLen;
+    if (ok && s_txShares > 0) {
+        miner_get_stats()->shares += s_txShares;
+        s_lastSubmit = millis();
     }
-    return line;
+    s_txLen = 0;
+    s_txShares = 0;
+    return ok;
+}
+
+// Room for one more message (STRATUM_MSG_BUFFER bytes), flushing first if needed
+static char *txReserve(WiFiClient &client) {
+    if (sizeof(s_tx) - s_txLen < STRATUM_MSG_BUFFER) txFlush(client);
+    return s_tx + s_txLen;
 }
 
 // ============================================================ 
@@ -118,13 +450,14 @@ static String readBoundedLine(WiFiClient& client, size_t maxLen = 4096) {
 static bool sendMessage(WiFiClient &client, const char *msg) {
     if (!client.connected()) return false;
 
-    // Send message with newline as single write (like NerdMiner)
-    // This avoids TCP packet fragmentation issues
-    String fullMsg = String(msg) + "\n";
-    client.print(fullMsg);
+    size_t len = strnlen(msg, STRATUM_MSG_BUFFER - 1);
+    char *out = txReserve(client);
+    memcpy(out, msg, len);
+    out[len] = '\n';
+    s_txLen += len + 1;
 
     dbg("[STRATUM] TX: %s\n", msg);
-    return true;
+    return txFlush(client);
 }
 
 static bool waitForResponse(WiFiClient &client, int timeoutMs) {
@@ -136,12 +469,12 @@ static bool waitForResponse(WiFiClient &client, int timeoutMs) {
     return client.available() > 0;
 }
 
-static bool parseSubscribeResponse(const String &line) {
+static bool parseSubscribeResponse(pool_session_t *session, const char *line) {
     s_doc.clear();
     DeserializationError err = deserializeJson(s_doc, line);
 
     if (err) {
-        Serial.printf("[STRATUM] JSON parse error: %s\nRAW: %s\n", err.c_str(), line.c_str());
+        Serial.printf("[STRATUM] JSON parse error: %s\nRAW: %s\n", err.c_str(), line);
         return false;
     }
 
@@ -156,24 +489,57 @@ static bool parseSubscribeResponse(const String &line) {
         return false;
     }
 
-    // Extract extra nonce
+    // Extract extra nonce (passed to the miner when the session is activated)
     const char *en1 = s_doc["result"][1];
     if (en1) {
-        safeStrCpy(s_extraNonce1, en1, sizeof(s_extraNonce1));
+        safeStrCpy(session->extraNonce1, en1, sizeof(session->extraNonce1));
     }
 
-    s_extraNonce2Size = s_doc["result"][2] | 4;
-
-    // Pass to miner
-    miner_set_extranonce(s_extraNonce1, s_extraNonce2Size);
+    session->extraNonce2Size = s_doc["result"][2] | 4;
+    session->subscribed = true;
+    session->resumed = s_resume.pool == session->pool && s_resume.extraNonce1[0] &&
+                       strcmp(session->extraNonce1, s_resume.extraNonce1) == 0 &&
+                       session->extraNonce2Size == s_resume.extraNonce2Size;
+
+#if USE_STRATUM_PROXY
+    // Split extranonce2: the first byte tells the LAN proxy's miners apart,
+    // 00 stays with this board. Notifies then decode with it in extranonce1.
+    size_t en1Len = strlen(session->extraNonce1);
+    if (session->extraNonce2Size >= STRATUM_PROXY_MIN_EN2 && en1Len + 2 < sizeof(session->extraNonce1)) {
+        memcpy(session->extraNonce1 + en1Len, "00", 3);
+        session->extraNonce2Size--;
+        session->proxyCarved = true;
+    }
+#endif
 
     dbg("[STRATUM] Subscribed: extraNonce1=%s, extraNonce2Size=%d\n",
-        s_extraNonce1, s_extraNonce2Size);
+        session->extraNonce1, session->extraNonce2Size);
 
     return true;
 }
 
-static bool parseAuthorizeResponse(const String &line) {
+static bool parseConfigureResponse(pool_session_t *session, const char *line) {
+    s_doc.clear();
+    DeserializationError err = deserializeJson(s_doc, line);
+
+    if (err) return false;
+
+    if (s_doc.containsKey("error") && !s_doc["error"].isNull()) {
+        const char *errMsg = s_doc["error"][1];
+        Serial.printf("[STRATUM] Configure error: %s\n", errMsg ? errMsg : "unknown");
+        return false;
+    }
+
+    bool granted = s_doc["result"]["version-rolling"] | false;
+    const char *mask = s_doc["result"]["version-rolling.mask"];
+    if (!granted || !mask) return false;
+
+    // Never roll bits outside what we asked for
+    session->versionMask = strtoul(mask, NULL, 16) & VERSION_ROLLING_MASK;
+    return session->versionMask != 0;
+}
+
+static bool parseAuthorizeResponse(const char *line) {
     s_doc.clear();
     DeserializationError err = deserializeJson(s_doc, line);
 
@@ -189,70 +555,310 @@ static bool parseAuthorizeResponse(const String &line) {
     return result;
 }
 
-static void parseMiningNotify(const String &line) {
-    if (!s_doc.containsKey("params")) return;
+// Start an active-session job decoded into the next ring slot
+static void startDecodedJob(mining_job_bin_t *job) {
+    if (job->cleanJobs) s_cleanFrom = s_jobCount;
+    s_jobCount++;
+    s_jobDeferred = false;
+    s_jobStartMs = millis();
+    s_active->lastActivity = millis();
+    miner_start_job(job);
+    outageEnd("new session");
+}
+
+// Clean jobs start at once, as does the first job of a session or one that
+// arrives while the miner is stopped. Others are held until the running job
+// is JOB_REFRESH_MS old: the work it is on stays valid, and a pool sending a
+// fee update every few seconds no longer restarts both cores each time.
+static void publishDecodedJob(mining_job_bin_t *job) {
+    s_active->lastActivity = millis();
+    if (job->cleanJobs || s_jobCount == s_cleanFrom || !miner_is_running() ||
+        millis() - s_jobStartMs >= JOB_REFRESH_MS) {
+        startDecodedJob(job);
+        return;
+    }
+    s_jobDeferred = true;
+    miner_get_stats()->deferredJobs++;
+}
 
-    JsonArray params = s_doc["params"];
+static bool deferredJobDue() {
+    return s_jobDeferred && millis() - s_jobStartMs >= JOB_REFRESH_MS;
+}
 
-    // Use static job to avoid stack allocation of large struct each time
-    static stratum_job_t job;
-    memset(&job, 0, sizeof(job));
+static void startDeferredJob() {
+    if (deferredJobDue()) {
+        startDecodedJob(&s_jobs[s_jobCount % STRATUM_JOB_RING]);
+    }
+}
 
-    // Copy strings to fixed char arrays (no heap allocation!)
-    const char *p0 = params[0];
-    const char *p1 = params[1];
-    const char *p2 = params[2];
-    const char *p3 = params[3];
-    const char *p5 = params[5];
-    const char *p6 = params[6];
-    const char *p7 = params[7];
+// Started jobs still in the ring (a deferred job occupies the oldest slot)
+static uint32_t jobsHeld() {
+    uint32_t held = s_jobCount < STRATUM_JOB_RING ? s_jobCount : STRATUM_JOB_RING;
+    if (s_jobDeferred && held == STRATUM_JOB_RING) held--;
+    return held;
+}
 
-    if (p0) strncpy(job.jobId, p0, STRATUM_JOB_ID_LEN - 1);
-    if (p1) strncpy(job.prevHash, p1, STRATUM_PREVHASH_LEN - 1);
-    if (p2) strncpy(job.coinBase1, p2, STRATUM_COINBASE1_LEN - 1);
-    if (p3) strncpy(job.coinBase2, p3, STRATUM_COINBASE2_LEN - 1);
-    if (p5) strncpy(job.version, p5, STRATUM_FIELD_LEN - 1);
-    if (p6) strncpy(job.nbits, p6, STRATUM_FIELD_LEN - 1);
-    if (p7) strncpy(job.ntime, p7, STRATUM_FIELD_LEN - 1);
+// Whether a share's job predates the newest clean job or session switch.
+// A job that has aged out of the ring is older than every job held, so it
+// is known stale only if the boundary is no older than the ring.
+static bool jobInvalidated(const char *jobId) {
+    uint32_t held = jobsHeld();
+    for (uint32_t i = 1; i <= held; i++) {
+        uint32_t number = s_jobCount - i;
+        if (strcmp(s_jobs[number % STRATUM_JOB_RING].jobId, jobId) == 0) {
+            return (int32_t)(number - s_cleanFrom) < 0;
+        }
+    }
+    return (int32_t)(s_cleanFrom - (s_jobCount - held)) >= 0;
+}
 
-    // Copy merkle branches to fixed array
-    JsonArray merkle = params[4];
-    job.merkleBranchCount = 0;
-    for (size_t i = 0; i < merkle.size() && i < STRATUM_MAX_MERKLE; i++) {
-        const char *branch = merkle[i];
-        if (branch) {
-            strncpy(job.merkleBranches[i], branch, 67);
-            job.merkleBranches[i][67] = '\0';
-            job.merkleBranchCount++;
+static void applyDifficulty(pool_session_t *session, double diff) {
+    if (!isnan(diff) && diff > 0) {
+        session->difficulty = diff;
+        if (session == s_active && s_isConnected) {
+            miner_set_difficulty(diff);
+            reportWork(session, NULL, false);
         }
+        dbg("[STRATUM] Pool difficulty: %.4f\n", diff);
     }
+}
 
-    job.cleanJobs = params[8] | false;
-    strncpy(job.extraNonce1, s_extraNonce1, STRATUM_EXTRANONCE_LEN - 1);
-    job.extraNonce2Size = s_extraNonce2Size;
+// Hand the miner to this session: its extranonce, version mask, difficulty
+// and - if one arrived while it was not active - its newest job, which
+// replaces the running one within one kernel return
+static void sessionActivate(pool_session_t *session) {
+    miner_set_version_mask(session->versionMask);
+    miner_set_extranonce(session->extraNonce1, session->extraNonce2Size);
+    if (session->difficulty > 0) miner_set_difficulty(session->difficulty);
+
+    s_isConnected = true;
+    s_lastSubmit = millis();
+    session->lastActivity = millis();
+    session->v2.firstSequence = s_messageId;  // Older shares were sent on another session
+    safeStrCpy(s_currentPoolUrl, sessionPool(session)->url, MAX_POOL_URL_LEN);
+
+    // Jobs from before this point belong to another connection, unless the
+    // pool resumed the session they were sent on
+    if (!session->resumed) {
+        s_cleanFrom = s_jobCount;
+        s_jobDeferred = false;
+    }
 
-    s_lastActivity = millis();
-    miner_start_job(&job);
+    if (session->hasJob) {
+        mining_job_bin_t *job = &s_jobs[s_jobCount % STRATUM_JOB_RING];
+        memcpy(job, &session->job, sizeof(*job));
+        session->hasJob = false;
+        startDecodedJob(job);
+        reportWork(session, job, true);
+    } else {
+        reportWork(session, NULL, true);
+    }
 }
 
-static void parseSetDifficulty(const String &line) {
-    if (!s_doc.containsKey("params")) return;
+// Make the other session active; the previous one becomes the standby
+static void sessionSwap() {
+    s_counters.poolSwitches++;
+    pool_session_t *previous = s_active;
+    s_active = s_standby;
+    s_standby = previous;
+    sessionActivate(s_active);
+}
 
-    double diff = s_doc["params"][0] | 1.0;
+// ============================================================ 
+// Pending Requests
+// ============================================================ 
 
-    if (!isnan(diff) && diff > 0) {
-        miner_set_difficulty(diff);
-        dbg("[STRATUM] Pool difficulty: %.4f\n", diff);
+static void recordShareLatency(uint32_t latency) {
+    mining_stats_t *stats = miner_get_stats();
+    stats->lastLatency = latency;
+    stats->avgLatency = (stats->avgLatency == 0) ? latency : ((stats->avgLatency * 9 + latency) / 10);
+
+    s_latencies[s_latencyCount++ % STRATUM_LATENCY_WINDOW] = latency;
+
+    // Insertion sort of at most 64 values, once per share response
+    uint32_t sorted[STRATUM_LATENCY_WINDOW];
+    uint32_t n = s_latencyCount < STRATUM_LATENCY_WINDOW ? s_latencyCount : STRATUM_LATENCY_WINDOW;
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t v = s_latencies[i], j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+        sorted[j] = v;
+    }
+    stats->latencyP50 = sorted[(n - 1) / 2];
+    stats->latencyP95 = sorted[(n - 1) * 95 / 100];
+}
+
+static void pendingFinish(pending_t *p, bool accepted, const char *reason) {
+    sd_log_share(&p->entry, accepted, accepted ? NULL : reason, millis() - p->entry.sentTime);
+    if (p->entry.callback) {
+        p->entry.callback(p->entry.sessionId, p->entry.msgId, accepted, accepted ? NULL : reason);
+    }
+    p->kind = PENDING_FREE;
+}
+
+static void pendingExpire(pending_t *p) {
+    mining_stats_t *stats = miner_get_stats();
+    if (p->kind == PENDING_SHARE) {
+        stats->shareTimeouts++;
+        Serial.printf("[STRATUM] Share %lu got no response, counted as timed out\n", p->entry.msgId);
+        pendingFinish(p, false, "timeout");
+    } else {
+        stats->controlTimeouts++;
+        p->kind = PENDING_FREE;
+    }
+}
+
+// Track a request by id; entry may be NULL for control requests
+static void pendingAdd(uint32_t msgId, pending_kind_t kind, const submit_entry_t *entry) {
+    pending_t *p = &s_pending[msgId & (STRATUM_PENDING_SLOTS - 1)];
+    if (p->kind != PENDING_FREE) pendingExpire(p);
+
+    if (entry) {
+        p->entry = *entry;
+    } else {
+        memset(&p->entry, 0, sizeof(p->entry));
+    }
+    p->entry.msgId = msgId;
+    p->entry.sentTime = millis();
+    p->deadline = p->entry.sentTime + (kind == PENDING_SHARE ? SUBMIT_TIMEOUT_MS : CONTROL_TIMEOUT_MS);
+    p->kind = kind;
+    if (kind == PENDING_SHARE) TRACE_POINT(TRACE_SHARE_TX, p->entry.nonce);
+}
+
+// Time out whatever is past its deadline (a slot scan, once per loop pass)
+static void pendingSweep() {
+    uint32_t now = millis();
+    for (int i = 0; i < STRATUM_PENDING_SLOTS; i++) {
+        if (s_pending[i].kind != PENDING_FREE && (int32_t)(now - s_pending[i].deadline) >= 0) {
+            pendingExpire(&s_pending[i]);
+        }
     }
 }
 
-static void handleServerMessage(WiFiClient &client) {
-    String line = readBoundedLine(client);
-    line.trim();
+static void handleResponse(uint32_t msgId, bool accepted, const char *reason) {
+    mining_stats_t *stats = miner_get_stats();
+    pending_t *p = &s_pending[msgId & (STRATUM_PENDING_SLOTS - 1)];
+    if (p->kind == PENDING_FREE || p->entry.msgId != msgId) {
+        stats->lateResponses++;
+        dbg("[STRATUM] Response for id %lu, which is no longer pending\n", msgId);
+        return;
+    }
+
+    uint32_t latency = millis() - p->entry.sentTime;
+    if (p->kind == PENDING_CONTROL) {
+        stats->controlLatency = latency;
+        p->kind = PENDING_FREE;
+        return;
+    }
+
+    TRACE_POINT(TRACE_SHARE_RESULT, p->entry.nonce);
+    recordShareLatency(latency);
+    if (p->entry.flags & SUBMIT_FLAG_PROXY) {
+        // Downstream share: the proxy counts and relays it
+    } else if (accepted) {
+        stats->accepted++;
+        dbg("[STRATUM] Share accepted!\n");
+    } else {
+        stats->rejected++;
+        dbg("[STRATUM] Share rejected: %s\n", reason ? reason : "unknown");
+        Serial.printf("[STRATUM] Share rejected: %s\n", reason ? reason : "unknown");
+    }
+    pendingFinish(p, accepted, reason);
+}
+
+// ============================================================ 
+// Difficulty Suggestion
+// ============================================================ 
+
+static void updateHashRate() {
+    uint32_t now = millis();
+    if (s_rateMs && now - s_rateMs < STRATUM_HASHRATE_WINDOW_MS) return;
+
+    uint64_t hashes = miner_get_stats()->hashes;
+    if (s_rateMs && hashes > s_rateHashes) {
+        s_hashRate = (double)(hashes - s_rateHashes) * 1000.0 / (now - s_rateMs);
+    }
+    s_rateHashes = hashes;
+    s_rateMs = now;
+}
+
+// Difficulty that gives one share per STRATUM_SHARE_INTERVAL_S at the
+// measured hashrate (a difficulty-1 share takes 2^32 hashes on average),
+// never below the configured difficulty
+static double suggestedDifficulty() {
+    double diff = s_configDifficulty;
+    if (STRATUM_SHARE_INTERVAL_S > 0 && s_hashRate > 0) {
+        double adaptive = s_hashRate * STRATUM_SHARE_INTERVAL_S / 4294967296.0;
+        if (adaptive > diff) diff = adaptive;
+    }
+    return diff;
+}
+
+static bool suggestDifficulty(pool_session_t *session) {
+    char msg[STRATUM_MSG_BUFFER];
+    double diff = suggestedDifficulty();
+    uint32_t diffId = getNextId();
+    snprintf(msg, sizeof(msg),
+        "{\"id\":%lu,\"method\":\"mining.suggest_difficulty\",\"params\":[%.10g]}",
+        diffId, diff);
+    if (!sendMessage(session->client, msg)) return false;
+    pendingAdd(diffId, PENDING_CONTROL, NULL);
+    session->suggested = diff;
+    return true;
+}
+
+static void parseSetVersionMask(pool_session_t *session, const char *line) {
+    if (!s_doc.containsKey("params")) return;
+
+    const char *mask = s_doc["params"][0];
+    if (!mask || !session->versionMask) return;
+
+    session->versionMask = strtoul(mask, NULL, 16) & VERSION_ROLLING_MASK;
+    if (session == s_active) miner_set_version_mask(session->versionMask);
+    reportWork(session, NULL, false);
+    dbg("[STRATUM] Version mask: %08x\n", session->versionMask);
+}
 
-    if (line.length() == 0) return;
+static void handleServerMessage(pool_session_t *session, const char *line) {
+    dbg("[STRATUM] RX: %s\n", line);
+    if (session == s_active && !s_replaying) {
+        stratum_capture_line(line, session->extraNonce1, session->extraNonce2Size,
+                             session->versionMask, session->difficulty);
+    }
 
-    dbg("[STRATUM] RX: %s\n", line.c_str());
+    // Fast path: decode straight into the next job slot (no JSON document).
+    // A session that is not active keeps only its newest job.
+    bool active = (session == s_active);
+    stratum_line_t msg;
+    mining_job_bin_t *job = active ? &s_jobs[s_jobCount % STRATUM_JOB_RING] : &session->job;
+    switch (stratum_parse_line(line, &msg, job, session->extraNonce1, session->extraNonce2Size)) {
+        case STRATUM_LINE_NOTIFY:
+            noteFirstJob(session);
+            if (active) {
+                TRACE_POINT(TRACE_JOB_DECODED, 0);
+                reportWork(session, job, false);
+                publishDecodedJob(job);
+            } else {
+                session->hasJob = true;
+                session->lastActivity = millis();
+            }
+            return;
+        case STRATUM_LINE_BAD_NOTIFY:
+            if (active) {
+                s_jobDeferred = false;  // Slot clobbered
+            } else {
+                session->hasJob = false;
+            }
+            Serial.println("[STRATUM] Malformed mining.notify (bad hex, missing fields or oversized coinbase), ignored");
+            return;
+        case STRATUM_LINE_DIFFICULTY:
+            applyDifficulty(session, msg.difficulty);
+            return;
+        case STRATUM_LINE_RESULT:
+            handleResponse(msg.id, msg.result, msg.reason[0] ? msg.reason : NULL);
+            return;
+        default:
+            break;
+    }
 
     s_doc.clear();
     DeserializationError err = deserializeJson(s_doc, line);
@@ -261,55 +867,17 @@ static void handleServerMessage(WiFiClient &client) {
         return;
     }
 
-    // Check for submission responses
+    // Responses with a non-boolean result
     if (s_doc.containsKey("id") && s_doc.containsKey("result")) {
-        uint32_t msgId = s_doc["id"];
-        bool accepted = s_doc["result"] | false;
-
-        // Find matching pending submission
-        for (int i = 0; i < MAX_PENDING_SUBMISSIONS; i++) {
-            if (s_pendingResponses[i].msgId == msgId) {
-                mining_stats_t *stats = miner_get_stats();
-
-                uint32_t latency = millis() - s_pendingResponses[i].sentTime;
-                stats->lastLatency = latency;
-                stats->avgLatency = (stats->avgLatency == 0) ? latency : ((stats->avgLatency * 9 + latency) / 10);
-
-                if (accepted) {
-                    stats->accepted++;
-                    dbg("[STRATUM] Share accepted!\n");
-                } else {
-                    stats->rejected++;
-                    const char *reason = s_doc["error"][1] | "unknown";
-                    dbg("[STRATUM] Share rejected: %s\n", reason);
-                    Serial.printf("[STRATUM] Share rejected: %s\n", reason);
-                }
-
-                // Call callback if set
-                if (s_pendingResponses[i].callback) {
-                    const char *reason = accepted ? NULL : (const char *)s_doc["error"][1];
-                    s_pendingResponses[i].callback(
-                        s_pendingResponses[i].sessionId,
-                        s_pendingResponses[i].msgId,
-                        accepted,
-                        reason
-                    );
-                }
-
-                s_pendingResponses[i].msgId = 0;  // Clear slot
-                break;
-            }
-        }
+        handleResponse(s_doc["id"], s_doc["result"] | false, s_doc["error"][1]);
     }
 
     // Check for method calls
     if (s_doc.containsKey("method")) {
         const char *method = s_doc["method"];
 
-        if (strcmp(method, "mining.notify") == 0) {
-            parseMiningNotify(line);
-        } else if (strcmp(method, "mining.set_difficulty") == 0) {
-            parseSetDifficulty(line);
+        if (strcmp(method, "mining.set_version_mask") == 0) {
+            parseSetVersionMask(session, line);
         } else {
             dbg("[STRATUM] Unknown method: %s\n", method);
         }
@@ -318,14 +886,34 @@ static void handleServerMessage(WiFiClient &client) {
 
 // Helper: Read lines until we get a response with matching ID (or timeout)
 // Handles method calls (set_difficulty, notify) that arrive before the response
-static bool waitForResponseById(WiFiClient &client, uint32_t expectedId, String &outResponse, int maxAttempts = 10) {
+// The returned line lives in session->rx and is valid until the next read.
+static const char *waitForResponseById(pool_session_t *session, uint32_t expectedId, int maxAttempts = 10) {
     for (int attempt = 0; attempt < maxAttempts; attempt++) {
-        String line = readBoundedLine(client);  // Use bounded read to prevent OOM
-        line.trim();
+        const char *line = rxReadLine(&session->rx, session->client, STRATUM_RX_WAIT_MS);
 
-        if (line.length() == 0) {
+        if (!line) {
             Serial.println("[STRATUM] Response timeout");
-            return false;
+            return NULL;
+        }
+
+        // Jobs are kept on the session and only start once it is activated,
+        // so a failback probe or standby never disturbs the running job
+        stratum_line_t msg;
+        stratum_line_kind_t kind = stratum_parse_line(line, &msg, session->subscribed ? &session->job : NULL,
+                                                      session->extraNonce1, session->extraNonce2Size);
+        if (kind == STRATUM_LINE_DIFFICULTY) {
+            applyDifficulty(session, msg.difficulty);
+            continue;
+        }
+        if (kind == STRATUM_LINE_NOTIFY || kind == STRATUM_LINE_BAD_NOTIFY) {
+            session->hasJob = (kind == STRATUM_LINE_NOTIFY) && session->subscribed;
+            if (session->hasJob) noteFirstJob(session);
+            continue;
+        }
+        if (kind == STRATUM_LINE_RESULT) {
+            if (msg.id == expectedId) return line;
+            handleResponse(msg.id, msg.result, msg.reason[0] ? msg.reason : NULL);  // e.g. suggest_difficulty
+            continue;
         }
 
         // Parse to check if this is our response or a method call
@@ -342,10 +930,7 @@ static bool waitForResponseById(WiFiClient &client, uint32_t expectedId, String
 
             // Handle set_difficulty immediately since it's important
             if (strcmp(method, "mining.set_difficulty") == 0) {
-                double diff = s_doc["params"][0] | 1.0;
-                if (!isnan(diff) && diff > 0) {
-                    miner_set_difficulty(diff);
-                }
+                applyDifficulty(session, s_doc["params"][0] | 1.0);
             }
             // Continue reading for our actual response
             continue;
@@ -355,28 +940,67 @@ static bool waitForResponseById(WiFiClient &client, uint32_t expectedId, String
         if (s_doc.containsKey("id")) {
             uint32_t respId = s_doc["id"] | 0;
             if (respId == expectedId) {
-                outResponse = line;
-                return true;
+                return line;
             }
             Serial.printf("[STRATUM] Got response for different id: %lu (expected %lu)\n", respId, expectedId);
         }
     }
 
     Serial.println("[STRATUM] Max attempts reached waiting for response");
-    return false;
+    return NULL;
 }
 
-static bool subscribe(WiFiClient &client, const char *wallet, const char *password, const char *workerName) {
+// "wallet.worker", or just the wallet when no worker name is set
+static void workerUsername(char *out, size_t len, const pool_config_t *pool) {
+    if (pool->workerName[0]) {
+        snprintf(out, len, "%s.%s", pool->wallet, pool->workerName);
+    } else {
+        safeStrCpy(out, pool->wallet, len);
+    }
+}
+
+// Run the handshake on a freshly connected session. Nothing reaches the
+// miner until sessionActivate().
+static bool subscribe(pool_session_t *session) {
     char msg[STRATUM_MSG_BUFFER];
+    WiFiClient &client = session->client;
+    const pool_config_t *pool = sessionPool(session);
+    const char *password = pool->password;
+    sessionReset(session);  // Fresh connection
+    uint32_t startMs = millis();
 
     // Set client timeout for blocking reads
     client.setTimeout(5000);
 
-    // Mining.subscribe
-    uint32_t subId = getNextId();
+    // Mining.configure (BIP310) - must precede subscribe
+    // Pools without version rolling reply with an error; mining continues without it
+    uint32_t cfgId = getNextId();
     snprintf(msg, sizeof(msg),
-        "{\"id\":%lu,\"method\":\"mining.subscribe\",\"params\":[\"%s/%s\"]}",
-        subId, MINER_NAME, AUTO_VERSION);
+        "{\"id\":%lu,\"method\":\"mining.configure\",\"params\":[[\"version-rolling\"],"
+        "{\"version-rolling.mask\":\"%08x\",\"version-rolling.min-bit-count\":%d}]}",
+        cfgId, VERSION_ROLLING_MASK, VERSION_ROLLING_MIN_BITS);
+    if (!sendMessage(client, msg)) return false;
+
+    const char *resp = waitForResponseById(session, cfgId, 3);
+    if (resp && parseConfigureResponse(session, resp)) {
+        Serial.printf("[STRATUM] Version rolling granted, mask=%08x\n", session->versionMask);
+    } else {
+        session->versionMask = 0;
+        Serial.println("[STRATUM] Version rolling not supported by pool");
+    }
+
+    // Mining.subscribe, with the lost session's extranonce1 as the session
+    // id when reconnecting to the same pool
+    uint32_t subId = getNextId();
+    if (STRATUM_SESSION_RESUME && s_resume.pool == session->pool && s_resume.extraNonce1[0]) {
+        snprintf(msg, sizeof(msg),
+            "{\"id\":%lu,\"method\":\"mining.subscribe\",\"params\":[\"%s/%s\",\"%s\"]}",
+            subId, MINER_NAME, AUTO_VERSION, s_resume.extraNonce1);
+    } else {
+        snprintf(msg, sizeof(msg),
+            "{\"id\":%lu,\"method\":\"mining.subscribe\",\"params\":[\"%s/%s\"]}",
+            subId, MINER_NAME, AUTO_VERSION);
+    }
 
     uint32_t startSub = millis();
     if (!sendMessage(client, msg)) return false;
@@ -385,8 +1009,8 @@ static bool subscribe(WiFiClient &client, const char *wallet, const char *passwo
     vTaskDelay(200 / portTICK_PERIOD_MS);
 
     // Wait for subscribe response (handle any method calls that arrive first)
-    String resp;
-    if (!waitForResponseById(client, subId, resp)) {
+    resp = waitForResponseById(session, subId);
+    if (!resp) {
         Serial.println("[STRATUM] No subscribe response");
         return false;
     }
@@ -397,28 +1021,21 @@ static bool subscribe(WiFiClient &client, const char *wallet, const char *passwo
     stats->lastLatency = subLatency;
     stats->avgLatency = (stats->avgLatency == 0) ? subLatency : ((stats->avgLatency * 9 + subLatency) / 10);
 
-    if (!parseSubscribeResponse(resp)) {
+    if (!parseSubscribeResponse(session, resp)) {
         Serial.println("[STRATUM] Subscribe failed");
         return false;
     }
+    session->phases.subscribeMs = millis() - startMs;
 
     // Suggest difficulty
-    uint32_t diffId = getNextId();
-    snprintf(msg, sizeof(msg),
-        "{\"id\":%lu,\"method\":\"mining.suggest_difficulty\",\"params\":[%.10g]}",
-        diffId, DESIRED_DIFFICULTY);
-    sendMessage(client, msg);
+    suggestDifficulty(session);
 
     // Mining.authorize - append worker name if set
     char fullUsername[MAX_WALLET_LEN + 34];
-    if (workerName && workerName[0]) {
-        snprintf(fullUsername, sizeof(fullUsername), "%s.%s", wallet, workerName);
-    } else {
-        safeStrCpy(fullUsername, wallet, sizeof(fullUsername));
-    }
-    
+    workerUsername(fullUsername, sizeof(fullUsername), pool);
+
     // Store authorized worker name for submissions
-    safeStrCpy(s_authorizedWorkerName, fullUsername, sizeof(s_authorizedWorkerName));
+    safeStrCpy(session->authorizedWorkerName, fullUsername, sizeof(session->authorizedWorkerName));
 
     uint32_t authId = getNextId();
     snprintf(msg, sizeof(msg),
@@ -432,7 +1049,8 @@ static bool subscribe(WiFiClient &client, const char *wallet, const char *passwo
     vTaskDelay(200 / portTICK_PERIOD_MS);
 
     // Wait for authorize response (handle set_difficulty/notify that may arrive first)
-    if (!waitForResponseById(client, authId, resp)) {
+    resp = waitForResponseById(session, authId);
+    if (!resp) {
         Serial.println("[STRATUM] No authorize response");
         return false;
     }
@@ -441,6 +1059,7 @@ static bool subscribe(WiFiClient &client, const char *wallet, const char *passwo
     uint32_t authLatency = millis() - startAuth;
     stats->lastLatency = authLatency;
     stats->avgLatency = (stats->avgLatency * 9 + authLatency) / 10;
+    session->phases.authorizeMs = authLatency;
 
     if (!parseAuthorizeResponse(resp)) {
         Serial.println("[STRATUM] Authorization failed");
@@ -451,111 +1070,1163 @@ static bool subscribe(WiFiClient &client, const char *wallet, const char *passwo
     return true;
 }
 
-static void submitShare(WiFiClient &client, const submit_entry_t *entry) {
-    char msg[STRATUM_MSG_BUFFER];
-    char timestamp[9], nonce[9];
-
-    // Format as 8-char hex (value as hex, zero-padded)
-    formatHex8(timestamp, entry->timestamp);
-    formatHex8(nonce, entry->nonce);
-
-    uint32_t msgId = getNextId();
-
-    // Standard Stratum v1 submit (5 params, no version rolling)
-    snprintf(msg, sizeof(msg),
-        "{\"id\":%lu,\"method\":\"mining.submit\",\"params\":[\"%s\",\"%s\",\"%s\",\"%s\",\"%s\"]}",
-        msgId,
-        s_authorizedWorkerName, // Use the full worker name used during authorization
-        entry->jobId,
-        entry->extraNonce2,
-        timestamp,
-        nonce);
-
-    Serial.printf("[STRATUM] Submit: job=%s en2=%s time=%s nonce=%s\n",
-        entry->jobId, entry->extraNonce2, timestamp, nonce);
-
-    if (sendMessage(client, msg)) {
-        // Store in pending responses for latency tracking
-        submit_entry_t pending = *entry;
-        pending.msgId = msgId;
-        pending.sentTime = millis();
-
-        s_pendingResponses[s_pendingIndex] = pending;
-        s_pendingIndex = (s_pendingIndex + 1) % MAX_PENDING_SUBMISSIONS;
-
-        s_lastSubmit = millis();
-        miner_get_stats()->shares++;
-    }
-}
-
 // ============================================================ 
-// Public API
+// Stratum V2
 // ============================================================ 
 
-void stratum_init() {
-    // Create submission queue
-    s_submitQueue = xQueueCreate(MAX_PENDING_SUBMISSIONS, sizeof(submit_entry_t));
-
-    // Initialize pending responses
-    memset(s_pendingResponses, 0, sizeof(s_pendingResponses));
-
-    // Set default pool
-    safeStrCpy(s_primaryPool.url, DEFAULT_POOL_URL, MAX_POOL_URL_LEN);
-    s_primaryPool.port = DEFAULT_POOL_PORT;
-    safeStrCpy(s_primaryPool.password, DEFAULT_POOL_PASS, MAX_PASSWORD_LEN);
-
-    dbg("[STRATUM] Initialized\n");
+static void sv2Random(uint8_t *out, size_t len) {
+    esp_fill_random(out, len);
 }
 
-void stratum_task(void *param) {
-    WiFiClient client;
-    bool usingBackup = false;
-    uint32_t lastConnectAttempt = 0;
-    uint32_t backupConnectTime = 0;
+// Encrypt a plaintext frame into the transmit buffer; the caller flushes
+static bool sv2Queue(pool_session_t *session, const uint8_t *frame, size_t len) {
+    if (len == 0 || sv2_noise_frame_len(len - SV2_HEADER_LEN) > STRATUM_MSG_BUFFER) return false;
+    uint8_t *out = (uint8_t *)txReserve(session->client);
+    s_txLen += sv2_noise_seal(&session->v2.tx, out, frame, len);
+    return true;
+}
 
-    Serial.printf("[STRATUM] Task started on core %d\n", xPortGetCoreID());
+// Next decrypted server message, or false once timeoutMs passes without a
+// complete frame (0 = only what is already buffered or readable). A frame
+// that fails to decrypt ends the connection: the nonces are out of step.
+static bool sv2ReadMessage(pool_session_t *session, uint32_t timeoutMs, sv2_msg_t *msg) {
+    stratum_rx_t *rx = &session->rx;
+    sv2_state_t *v2 = &session->v2;
 
     while (true) {
-        // Wait for WiFi with auto-reconnect (Issue #4 fix)
-        if (WiFi.status() != WL_CONNECTED) {
-            if (s_isConnected) {
-                miner_stop();
-                client.stop();
-                s_isConnected = false;
-                Serial.println("[WIFI] Connection lost, attempting reconnect...");
-            }
-
-            // Calculate exponential backoff: 1s, 2s, 4s, 8s, 16s, 30s max
-            uint32_t backoffMs = 1000 * (1 << min(s_wifiReconnectAttempts, (uint32_t)5));
-            if (backoffMs > 30000) backoffMs = 30000;
-
-            if (millis() - s_lastWifiReconnectAttempt >= backoffMs) {
-                s_wifiReconnectAttempts++;
-                s_lastWifiReconnectAttempt = millis();
-                Serial.printf("[WIFI] Reconnect attempt %lu (backoff: %lums)\n",
-                              s_wifiReconnectAttempts, backoffMs);
-                WiFi.reconnect();
+        if (!v2->haveHeader) {
+            if (!rxFill(rx, session->client, SV2_NOISE_HEADER_LEN, timeoutMs)) return false;
+            uint8_t *hdr = (uint8_t *)rx->buf + rx->start;
+            if (!sv2_noise_open_header(&v2->rx, hdr)) {
+                Serial.println("[STRATUM] V2 frame header failed to decrypt, disconnecting");
+                session->client.stop();
+                return false;
             }
-
-            vTaskDelay(500 / portTICK_PERIOD_MS);
-            continue;
+            sv2_decode_header(hdr, &v2->header);
+            rx->start += SV2_NOISE_HEADER_LEN;
+            v2->haveHeader = true;
         }
 
-        // WiFi connected - reset reconnect counter
-        if (s_wifiReconnectAttempts > 0) {
-            Serial.printf("[WIFI] Reconnected after %lu attempts\n", s_wifiReconnectAttempts);
-            s_wifiReconnectAttempts = 0;
+        size_t frameLen = sv2_noise_frame_len(v2->header.length) - SV2_NOISE_HEADER_LEN;
+        if (frameLen > sizeof(rx->buf)) {
+            Serial.printf("[STRATUM] V2 frame of %lu bytes exceeds the receive buffer, disconnecting\n",
+                          v2->header.length);
+            session->client.stop();
+            return false;
         }
+        if (!rxFill(rx, session->client, frameLen, timeoutMs)) return false;
 
-        // Check pool configuration
-        if (!s_primaryPool.url[0] || !s_primaryPool.port) {
-            dbg("[STRATUM] No pool configured\n");
-            vTaskDelay(5000 / portTICK_PERIOD_MS);
-            continue;
+        uint8_t *payload = (uint8_t *)rx->buf + rx->start;
+        if (!sv2_noise_open_payload(&v2->rx, payload, v2->header.length)) {
+            Serial.println("[STRATUM] V2 frame failed to decrypt, disconnecting");
+            session->client.stop();
+            return false;
         }
+        rx->start += frameLen;
+        v2->haveHeader = false;
 
-        if (!s_primaryPool.wallet[0]) {
-            dbg("[STRATUM] No wallet configured\n");
+        if (v2->header.extension == 0 &&
+            sv2_decode_message(v2->header.type, payload, v2->header.length, msg)) {
+            return true;
+        }
+        dbg("[STRATUM] V2 message type %02x (extension %04x) ignored\n",
+            v2->header.type, v2->header.extension);
+    }
+}
+
+// Turn a header-only job into a miner job: start it on the active
+// session, otherwise keep it for sessionActivate()
+static void sv2PublishJob(pool_session_t *session, uint32_t jobId, uint32_t version,
+                          const uint8_t merkleRoot[32], uint32_t ntime, bool clean) {
+    bool active = (session == s_active) && s_isConnected;
+    mining_job_bin_t *job = active ? &s_jobs[s_jobCount % STRATUM_JOB_RING] : &session->job;
+    sv2_state_t *v2 = &session->v2;
+
+    memset(job, 0, sizeof(*job));
+    snprintf(job->jobId, sizeof(job->jobId), "%lu", jobId);
+    memcpy(job->prevHash, v2->prevHash, 32);
+    memcpy(job->merkleRoot, merkleRoot, 32);
+    job->headerOnly = true;
+    job->version = version;
+    job->nbits = v2->nbits;
+    job->ntime = ntime;
+    job->cleanJobs = clean;
+    noteFirstJob(session);
+
+    if (active) {
+        TRACE_POINT(TRACE_JOB_DECODED, 0);
+        publishDecodedJob(job);
+    } else {
+        session->hasJob = true;
+        session->lastActivity = millis();
+    }
+}
+
+static void handleSv2Message(pool_session_t *session, const sv2_msg_t *msg) {
+    sv2_state_t *v2 = &session->v2;
+
+    switch (msg->type) {
+        case SV2_MSG_NEW_MINING_JOB:
+            if (msg->job.channelId != v2->channelId) break;
+            if (msg->job.future) {
+                // Held until the SetNewPrevHash that names it
+                sv2_future_job_t *f = &v2->future[v2->futureCount++ % SV2_FUTURE_JOBS];
+                f->jobId = msg->job.jobId;
+                f->version = msg->job.version;
+                memcpy(f->merkleRoot, msg->job.merkleRoot, 32);
+            } else if (v2->hasPrevHash) {
+                sv2PublishJob(session, msg->job.jobId, msg->job.version, msg->job.merkleRoot,
+                              msg->job.minNtime, false);
+            }
+            break;
+
+        case SV2_MSG_SET_NEW_PREV_HASH: {
+            if (msg->prevHash.channelId != v2->channelId) break;
+            memcpy(v2->prevHash, msg->prevHash.prevHash, 32);
+            v2->nbits = msg->prevHash.nbits;
+            v2->hasPrevHash = true;
+
+            uint32_t held = v2->futureCount < SV2_FUTURE_JOBS ? v2->futureCount : SV2_FUTURE_JOBS;
+            for (uint32_t i = 0; i < held; i++) {
+                const sv2_future_job_t *f = &v2->future[i];
+                if (f->jobId != msg->prevHash.jobId) continue;
+                sv2PublishJob(session, f->jobId, f->version, f->merkleRoot, msg->prevHash.minNtime, true);
+                break;
+            }
+            v2->futureCount = 0;  // Futures are only valid for the next prevhash
+            break;
+        }
+
+        case SV2_MSG_SET_TARGET:
+            if (msg->target.channelId == v2->channelId) {
+                applyDifficulty(session, sv2_target_to_difficulty(msg->target.target));
+            }
+            break;
+
+        case SV2_MSG_SUBMIT_SHARES_SUCCESS:
+            // Cumulative: everything up to last_sequence sent on this session
+            // since activation was accepted
+            for (int i = 0; i < STRATUM_PENDING_SLOTS; i++) {
+                pending_t *p = &s_pending[i];
+                if (p->kind == PENDING_SHARE &&
+                    (int32_t)(p->entry.msgId - v2->firstSequence) >= 0 &&
+                    (int32_t)(msg->accepted.lastSequence - p->entry.msgId) >= 0) {
+                    handleResponse(p->entry.msgId, true, NULL);
+                }
+            }
+            break;
+
+        case SV2_MSG_SUBMIT_SHARES_ERROR:
+            handleResponse(msg->error.sequence, false, msg->error.code);
+            break;
+
+        case SV2_MSG_CLOSE_CHANNEL:
+            Serial.printf("[STRATUM] V2 pool closed the channel: %s\n", msg->error.code);
+            session->client.stop();
+            break;
+
+        default:
+            dbg("[STRATUM] V2 message type %02x ignored\n", msg->type);
+            break;
+    }
+}
+
+// Read until a success or error message of the given types, handling
+// anything else (jobs, targets) that arrives first. The handshake replies
+// come within one or two frames; ten is plenty.
+static bool sv2WaitFor(pool_session_t *session, uint8_t success, uint8_t error, sv2_msg_t *msg) {
+    for (int attempt = 0; attempt < 10; attempt++) {
+        if (!sv2ReadMessage(session, STRATUM_RX_WAIT_MS, msg)) {
+            Serial.println("[STRATUM] V2 response timeout");
+            return false;
+        }
+        if (msg->type == success) return true;
+        if (msg->type == error) {
+            Serial.printf("[STRATUM] V2 request refused: %s\n", msg->error.code);
+            return false;
+        }
+        handleSv2Message(session, msg);
+    }
+    Serial.println("[STRATUM] Max attempts reached waiting for V2 response");
+    return false;
+}
+
+// Nominal hash rate for the channel: what this device has measured, so the
+// pool picks a target near one share per STRATUM_SHARE_INTERVAL_S
+static float sv2NominalHashRate() {
+    if (s_hashRate > 0) return (float)s_hashRate;
+
+    mining_stats_t *stats = miner_get_stats();
+    uint32_t elapsedMs = millis() - stats->startTime;
+    if (stats->startTime == 0 || elapsedMs < 10000 || stats->hashes == 0) return SV2_DEFAULT_HASHRATE;
+    return (float)((double)stats->hashes * 1000.0 / elapsedMs);
+}
+
+// Noise handshake, SetupConnection and one standard channel on a freshly
+// connected session. Nothing reaches the miner until sessionActivate().
+static bool sv2Handshake(pool_session_t *session) {
+    WiFiClient &client = session->client;
+    const pool_config_t *pool = sessionPool(session);
+    sessionReset(session);  // Fresh connection
+    sv2_state_t *v2 = &session->v2;
+    uint8_t frame[STRATUM_MSG_BUFFER];
+    sv2_msg_t msg;
+
+    client.setTimeout(5000);
+
+    // Noise NX: -> e, then <- e, ee, s, es and the pool certificate
+    sv2_handshake_t hs;
+    uint8_t act1[SV2_NOISE_ACT1_LEN];
+    uint32_t startHs = millis();
+    sv2_noise_start(&hs, act1, sv2Random);
+    if (client.write(act1, sizeof(act1)) != sizeof(act1)) return false;
+    if (!rxFill(&session->rx, client, SV2_NOISE_ACT2_LEN, STRATUM_RX_WAIT_MS)) {
+        Serial.println("[STRATUM] No V2 handshake response");
+        return false;
+    }
+
+    if (!pool->hasAuthorityKey) {
+        Serial.println("[STRATUM] WARNING: No V2 authority key configured, pool identity not verified");
+    }
+    time_t now = time(NULL);
+    sv2_noise_result_t result = sv2_noise_finish(&hs, (const uint8_t *)session->rx.buf + session->rx.start,
+        pool->hasAuthorityKey ? pool->authorityKey : NULL,
+        now > SV2_CLOCK_VALID ? (uint32_t)now : 0, &v2->tx, &v2->rx);
+    session->rx.start += SV2_NOISE_ACT2_LEN;
+    memset(&hs, 0, sizeof(hs));
+    if (result != SV2_NOISE_OK) {
+        Serial.printf("[STRATUM] V2 handshake failed: %s\n",
+            result == SV2_NOISE_BAD_SIGNATURE ? "certificate not signed by the authority key" :
+            result == SV2_NOISE_EXPIRED ? "certificate expired" : "bad message");
+        return false;
+    }
+    miner_get_stats()->lastLatency = millis() - startHs;
+
+    // SetupConnection: header-only jobs
+    sv2_setup_t setup = { pool->url, (uint16_t)pool->port, MINER_NAME, ESP.getChipModel(), AUTO_VERSION, "" };
+    if (!sv2Queue(session, frame, sv2_encode_setup_connection(frame, sizeof(frame), &setup)) ||
+        !txFlush(client)) {
+        return false;
+    }
+    if (!sv2WaitFor(session, SV2_MSG_SETUP_CONNECTION_SUCCESS, SV2_MSG_SETUP_CONNECTION_ERROR, &msg)) {
+        Serial.println("[STRATUM] V2 setup failed");
+        return false;
+    }
+    session->phases.subscribeMs = millis() - startHs;
+    session->versionMask = (msg.setup.flags & SV2_SETUP_REQUIRES_FIXED_VERSION) ? 0 : VERSION_ROLLING_MASK;
+
+    // One standard channel for the configured worker
+    char user[MAX_WALLET_LEN + 34];
+    workerUsername(user, sizeof(user), pool);
+    safeStrCpy(session->authorizedWorkerName, user, sizeof(session->authorizedWorkerName));
+
+    uint32_t reqId = getNextId();
+    uint32_t startOpen = millis();
+    size_t len = sv2_encode_open_standard_channel(frame, sizeof(frame), reqId, user, sv2NominalHashRate());
+    if (!sv2Queue(session, frame, len) || !txFlush(client)) return false;
+    if (!sv2WaitFor(session, SV2_MSG_OPEN_STANDARD_CHANNEL_SUCCESS, SV2_MSG_OPEN_CHANNEL_ERROR, &msg)) {
+        Serial.println("[STRATUM] V2 channel open failed");
+        return false;
+    }
+
+    session->phases.authorizeMs = millis() - startOpen;
+    v2->channelId = msg.channel.channelId;
+    session->subscribed = true;
+    session->suggested = suggestedDifficulty();
+    applyDifficulty(session, sv2_target_to_difficulty(msg.channel.target));
+
+    Serial.printf("[STRATUM] V2 channel %lu open as %s, version rolling %s\n",
+        v2->channelId, user, session->versionMask ? "on" : "off");
+    return true;
+}
+
+// UpdateChannel: the V2 counterpart of a new suggest_difficulty
+static bool sv2UpdateChannel(pool_session_t *session) {
+    uint8_t frame[64];
+    size_t len = sv2_encode_update_channel(frame, sizeof(frame), session->v2.channelId, sv2NominalHashRate());
+    if (!sv2Queue(session, frame, len) || !txFlush(session->client)) return false;
+    session->suggested = suggestedDifficulty();
+    return true;
+}
+
+// Encrypt a share into the transmit buffer; the sequence number doubles as
+// the pending-table id (Shares.Success acknowledges up to a sequence)
+static void sv2SubmitShare(const submit_entry_t *entry) {
+    sv2_submit_t submit;
+    uint8_t frame[64];
+    submit.channelId = s_active->v2.channelId;
+    submit.sequence = getNextId();
+    submit.jobId = strtoul(entry->jobId, NULL, 10);
+    submit.nonce = entry->nonce;
+    submit.ntime = entry->timestamp;
+    submit.version = entry->version;
+
+    Serial.printf("[STRATUM] Submit: job=%s%s time=%08lx nonce=%08lx ver=%08lx\n",
+        entry->jobId, stratum_find_job(entry->jobId) ? "" : " (late)",
+        entry->timestamp, entry->nonce, entry->version);
+
+    if (!sv2Queue(s_active, frame, sv2_encode_submit_standard(frame, sizeof(frame), &submit))) {
+        Serial.println("[STRATUM] Submit does not fit the message buffer, dropped");
+        return;
+    }
+    s_txShares++;
+    pendingAdd(submit.sequence, PENDING_SHARE, entry);
+}
+
+// Format a share into the transmit buffer; the caller flushes once the
+// queue is drained, so a burst of shares goes out as one TCP write
+static void submitShare(WiFiClient &client, const submit_entry_t *entry) {
+    char timestamp[9], nonce[9], versionBits[9];
+
+    // Time from the verify task queueing the share to it being sent
+    mining_stats_t *stats = miner_get_stats();
+    uint32_t queuedUs = micros() - entry->queuedUs;
+    stats->lastSubmitQueueUs = queuedUs;
+    if (queuedUs > stats->maxSubmitQueueUs) {
+        stats->maxSubmitQueueUs = queuedUs;
+    }
+
+    // Found on work a clean job has since replaced: the pool would reject it
+    if (jobInvalidated(entry->jobId)) {
+        stats->staleDropped++;
+        Serial.printf("[STRATUM] Share for job %s dropped, job was invalidated\n", entry->jobId);
+        if (entry->callback) entry->callback(entry->sessionId, 0, false, "stale");
+        return;
+    }
+
+    // Proxied share, but the pool it was found for gave way to one the proxy can't serve
+    if ((entry->flags & SUBMIT_FLAG_PROXY) && !s_active->proxyCarved) {
+        if (entry->callback) entry->callback(entry->sessionId, 0, false, "pool changed");
+        return;
+    }
+
+    if (s_active->sv2) {
+        sv2SubmitShare(entry);
+        return;
+    }
+
+    // Format as 8-char hex (value as hex, zero-padded)
+    formatHex8(timestamp, entry->timestamp);
+    formatHex8(nonce, entry->nonce);
+
+    // Our own extranonce2 goes after the carved 00 byte; proxied ones are complete
+    char extraNonce2[24];
+    if (s_active->proxyCarved && !(entry->flags & SUBMIT_FLAG_PROXY)) {
+        snprintf(extraNonce2, sizeof(extraNonce2), "00%s", entry->extraNonce2);
+    } else {
+        safeStrCpy(extraNonce2, entry->extraNonce2, sizeof(extraNonce2));
+    }
+
+    uint32_t msgId = getNextId();
+    char *out = txReserve(client);
+    int len;
+
+    if (entry->flags & SUBMIT_FLAG_VERSION) {
+        // BIP310 submit: 6th param is the rolled version bits (version & mask)
+        formatHex8(versionBits, entry->versionBits);
+        len = snprintf(out, STRATUM_MSG_BUFFER,
+            "{\"id\":%lu,\"method\":\"mining.submit\",\"params\":[\"%s\",\"%s\",\"%s\",\"%s\",\"%s\",\"%s\"]}\n",
+            msgId,
+            s_active->authorizedWorkerName,
+            entry->jobId,
+            extraNonce2,
+            timestamp,
+            nonce,
+            versionBits);
+    } else {
+        // Standard Stratum v1 submit (5 params, no version rolling)
+        len = snprintf(out, STRATUM_MSG_BUFFER,
+            "{\"id\":%lu,\"method\":\"mining.submit\",\"params\":[\"%s\",\"%s\",\"%s\",\"%s\",\"%s\"]}\n",
+            msgId,
+            s_active->authorizedWorkerName, // Use the full worker name used during authorization
+            entry->jobId,
+            extraNonce2,
+            timestamp,
+            nonce);
+    }
+
+    Serial.printf("[STRATUM] Submit: job=%s%s en2=%s time=%s nonce=%s ver=%08x\n",
+        entry->jobId, stratum_find_job(entry->jobId) ? "" : " (late)",
+        extraNonce2, timestamp, nonce, entry->versionBits);
+
+    if (len <= 0 || len >= STRATUM_MSG_BUFFER) {
+        Serial.println("[STRATUM] Submit does not fit the message buffer, dropped");
+        return;
+    }
+    dbg("[STRATUM] TX: %.*s", len, out);
+    s_txLen += len;
+    s_txShares++;
+
+    // Track until the pool answers or SUBMIT_TIMEOUT_MS passes
+    pendingAdd(msgId, PENDING_SHARE, entry);
+}
+
+// ============================================================ 
+// Event Wait
+// ============================================================ 
+
+static void wakeInit() {
+    esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    esp_err_t err = esp_vfs_eventfd_register(&config);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // INVALID_STATE: already registered
+        Serial.printf("[STRATUM] eventfd unavailable (%d), polling for shares\n", err);
+        return;
+    }
+    s_wakeFd = eventfd(0, 0);
+}
+
+static void wakeTask() {
+    if (s_wakeFd < 0) return;
+    uint64_t one = 1;
+    write(s_wakeFd, &one, sizeof(one));
+}
+
+// Sleep until a pool sends data, a share is queued or timeoutMs passes.
+// Replaces a fixed 100 ms poll, which let both sit for up to a full period.
+static void waitForWork(uint32_t timeoutMs) {
+    if (uxQueueMessagesWaiting(s_submitQueue) > 0) return;
+
+    int sock = s_active->client.fd();
+    if (s_wakeFd < 0 || sock < 0) {
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+        return;
+    }
+
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(sock, &readable);
+    FD_SET(s_wakeFd, &readable);
+    int maxFd = sock > s_wakeFd ? sock : s_wakeFd;
+
+    int standby = s_standby->client.connected() ? s_standby->client.fd() : -1;
+    if (standby >= 0) {
+        FD_SET(standby, &readable);
+        if (standby > maxFd) maxFd = standby;
+    }
+    struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000) };
+
+    // A share queued after the check above has already made the eventfd readable
+    if (select(maxFd + 1, &readable, NULL, NULL, &tv) > 0 &&
+        FD_ISSET(s_wakeFd, &readable)) {
+        uint64_t count;
+        read(s_wakeFd, &count, sizeof(count));
+    }
+}
+
+// ============================================================ 
+// Connection Setup
+// ============================================================ 
+
+// Last TLS session per pool, indexed like s_pools, offered on reconnect
+static stratum_tls_cache_t s_tlsCache[STRATUM_MAX_POOLS];
+
+// Resolved pool addresses, indexed like s_pools. A lookup is reused
+// for DNS_CACHE_TTL_MS; when one fails, the last address a session
+// connected to (or else the last one resolved) is used instead, so flaky
+// DNS does not hold up reconnects.
+typedef struct {
+    char host[MAX_POOL_URL_LEN];
+    IPAddress ip;                   // Last resolved
+    IPAddress good;                 // Last connected to (0.0.0.0 = none)
+    uint32_t resolvedMs;
+    bool valid;                     // ip holds a lookup of host
+    bool fresh;                     // ...and is still within its TTL
+} dns_entry_t;
+
+static dns_entry_t s_dnsCache[STRATUM_MAX_POOLS];
+
+static bool resolvePool(const pool_config_t *pool, dns_entry_t *entry, IPAddress &ip) {
+    if (strcmp(entry->host, pool->url) != 0) {
+        memset(entry, 0, sizeof(*entry));
+        safeStrCpy(entry->host, pool->url, sizeof(entry->host));
+    }
+    if (entry->valid && entry->fresh && millis() - entry->resolvedMs < DNS_CACHE_TTL_MS) {
+        ip = entry->ip;
+        return true;
+    }
+
+    IPAddress resolved;
+    if (WiFi.hostByName(pool->url, resolved) == 1 && resolved != IPAddress((uint32_t)0)) {
+        entry->ip = resolved;
+        entry->resolvedMs = millis();
+        entry->valid = entry->fresh = true;
+        ip = resolved;
+        return true;
+    }
+
+    if (entry->good != IPAddress((uint32_t)0)) {
+        ip = entry->good;
+    } else if (entry->valid) {
+        ip = entry->ip;
+    } else {
+        return false;
+    }
+    Serial.printf("[STRATUM] DNS lookup for %s failed, using last known %s\n", pool->url, ip.toString().c_str());
+    return true;
+}
+
+// TCP keepalive finds a dead pool socket in about 90 s instead of waiting
+// out INACTIVITY_MS, and lone shares must not wait on Nagle (bursts are
+// already coalesced in s_tx). SO_RCVBUF is only honoured when lwIP is built
+// with LWIP_SO_RCVBUF.
+static void tuneSocket(WiFiClient &client) {
+    int fd = client.fd();
+    if (fd < 0) return;
+
+    int one = 1, idle = TCP_KEEPIDLE_S, interval = TCP_KEEPINTVL_S, count = TCP_KEEPCNT;
+    int rcvbuf = SOCKET_RCVBUF;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &one, sizeof(one));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, &idle, sizeof(idle));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, &interval, sizeof(interval));
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, &count, sizeof(count));
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)) != 0) {
+        dbg("[STRATUM] SO_RCVBUF not supported, using the lwIP default\n");
+    }
+}
+
+// ============================================================ 
+// Pool Ranking
+// ============================================================ 
+
+// Per-pool health and latency. rttMs is a TCP connect plus a subscribe
+// round trip, measured by probePool() on a short-lived connection so every
+// pool is timed the same way whether it is active or not.
+typedef struct {
+    uint32_t rttMs;                 // Smoothed (0 = not measured yet)
+    uint32_t failures;              // Consecutive failed connects or probes
+} pool_rank_t;
+
+static pool_rank_t s_rank[STRATUM_MAX_POOLS];
+static uint32_t s_lastProbeMs = 0;
+static int s_probeNext = 0;         // Round-robin cursor
+
+static bool poolUsable(int pool) {
+    const pool_config_t *p = &s_pools[pool];
+    return p->url[0] && p->port > 0 && p->wallet[0];
+}
+
+static bool poolRanked(int pool) {
+    return pool != POOL_BACKUP && poolUsable(pool);
+}
+
+static bool poolHealthy(int pool) {
+    return s_rank[pool].failures < POOL_MAX_FAILURES;
+}
+
+static const char *poolName(int pool) {
+    static char name[20];
+    if (pool == POOL_PRIMARY) return "primary pool";
+    if (pool == POOL_BACKUP) return "backup pool";
+    snprintf(name, sizeof(name), "extra pool %d", pool - POOL_BACKUP);
+    return name;
+}
+
+// Best healthy ranked pool other than except (-1 = none): measured pools by
+// round trip, then unmeasured ones in list order
+static int bestPool(int except) {
+    int best = -1;
+    for (int i = 0; i < STRATUM_MAX_POOLS; i++) {
+        if (i == except || !poolRanked(i) || !poolHealthy(i)) continue;
+        uint32_t rtt = s_rank[i].rttMs ? s_rank[i].rttMs : UINT32_MAX;
+        uint32_t bestRtt = best < 0 ? 0 : (s_rank[best].rttMs ? s_rank[best].rttMs : UINT32_MAX);
+        if (best < 0 || rtt < bestRtt) best = i;
+    }
+    return best;
+}
+
+// Pool for a fresh active connection: the best ranked pool, else the
+// backup; once everything has failed, the counts start over
+static int connectTarget() {
+    int pool = bestPool(-1);
+    if (pool >= 0) return pool;
+    if (poolUsable(POOL_BACKUP) && poolHealthy(POOL_BACKUP)) return POOL_BACKUP;
+
+    Serial.println("[STRATUM] All pools failing, retrying from the top of the list");
+    for (int i = 0; i < STRATUM_MAX_POOLS; i++) s_rank[i].failures = 0;
+    return POOL_PRIMARY;
+}
+
+// A pool worth moving the active session to (-1 = stay): any healthy
+// ranked pool while on the backup, otherwise one faster than the active
+// pool by POOL_SWITCH_MARGIN_MS and 20%, so close scores do not flap
+static int switchTarget() {
+    int active = s_active->pool;
+    int best = bestPool(active);
+    if (best < 0) return -1;
+    if (!poolRanked(active)) return best;
+
+    uint32_t current = s_rank[active].rttMs, candidate = s_rank[best].rttMs;
+    if (!current || !candidate) return -1;
+    return (candidate + POOL_SWITCH_MARGIN_MS < current && candidate * 5 < current * 4) ? best : -1;
+}
+
+static void recordProbe(int pool, uint32_t rtt) {
+    pool_rank_t *rank = &s_rank[pool];
+    rank->rttMs = rank->rttMs ? (rank->rttMs * 3 + rtt) / 4 : rtt;
+    rank->failures = 0;
+    Serial.printf("[STRATUM] %s: %lu ms (smoothed %lu ms)\n", poolName(pool), rtt, rank->rttMs);
+}
+
+// Time one pool: TCP connect, then a mining.subscribe round trip (Stratum V2
+// and TLS pools get the connect only; their first reply needs a key exchange).
+// Blocks the stratum task for at most POOL_STANDBY_CONNECT_MS + PROBE_WAIT_MS.
+static void probePool(int pool) {
+    const pool_config_t *config = &s_pools[pool];
+    WiFiClient client;
+    IPAddress ip;
+    if (!resolvePool(config, &s_dnsCache[pool], ip)) {
+        s_rank[pool].failures++;
+        return;
+    }
+
+    uint32_t start = millis();
+    if (!client.connect(ip, config->port, POOL_STANDBY_CONNECT_MS)) {
+        s_dnsCache[pool].fresh = false;
+        s_rank[pool].failures++;
+        dbg("[STRATUM] Probe of %s failed to connect\n", poolName(pool));
+        return;
+    }
+    uint32_t rtt = millis() - start;
+
+    if (!config->sv2 && !config->tls) {
+        char msg[96];
+        int len = snprintf(msg, sizeof(msg),
+            "{\"id\":1,\"method\":\"mining.subscribe\",\"params\":[\"%s/%s\"]}\n", MINER_NAME, AUTO_VERSION);
+        uint32_t sent = millis();
+        client.setNoDelay(true);
+        client.write((const uint8_t *)msg, len);
+        while (!client.available() && client.connected() && millis() - sent < PROBE_WAIT_MS) {
+            vTaskDelay(1 / portTICK_PERIOD_MS);
+        }
+        if (!client.available()) {
+            client.stop();
+            s_rank[pool].failures++;
+            dbg("[STRATUM] Probe of %s got no subscribe response\n", poolName(pool));
+            return;
+        }
+        rtt += millis() - sent;
+    }
+    client.stop();
+    recordProbe(pool, rtt);
+}
+
+// Probe the next ranked pool every POOL_PROBE_MS (the active one included).
+// Nothing to rank with a single pool, unless that is what the backup is
+// waiting to fail back to.
+// Returns true if a probe ran, so the caller can act on the new ranking.
+static bool rankPools() {
+    if (millis() - s_lastProbeMs < POOL_PROBE_MS) return false;
+
+    int ranked = 0;
+    for (int i = 0; i < STRATUM_MAX_POOLS; i++) {
+        if (poolRanked(i)) ranked++;
+    }
+    if (ranked == 0 || (ranked == 1 && poolRanked(s_active->pool))) return false;
+    s_lastProbeMs = millis();
+
+    for (int n = 0; n < STRATUM_MAX_POOLS; n++) {
+        int pool = (s_probeNext + n) % STRATUM_MAX_POOLS;
+        if (!poolRanked(pool)) continue;
+        s_probeNext = pool + 1;
+        probePool(pool);
+        return true;
+    }
+    return false;
+}
+
+// ============================================================ 
+// Replay
+// ============================================================ 
+
+#define REPLAY_SLEEP_MS     5       // Longest sleep while waiting for a record's time
+#define REPLAY_SETTLE_MS    200     // Wait for the cores to pick up the last job
+
+typedef struct {
+    uint32_t lines;                 // Records replayed
+    uint32_t notifies;
+    uint32_t sessions;
+    uint32_t skipped;               // Replies to requests, lines before any session
+    uint32_t shares;                // Found on replayed work, never submitted
+    uint32_t firstJob;              // s_jobCount when the replay started
+    uint32_t sampledJob;            // s_jobCount at the last latency sample
+    uint32_t switches;              // Jobs a core was seen to pick up
+    uint32_t unpicked;              // Jobs replaced before any core picked them up
+    uint64_t switchUsTotal;
+    uint32_t maxSwitchUs;
+    uint64_t buildUsTotal;
+    uint32_t maxBuildUs;
+    uint32_t hashStartMs;           // First job started (0 = none yet)
+    uint64_t hashStart;             // Hash count then
+} replay_report_t;
+
+// Shares found on replayed work never reach a pool
+static void replayDropShares(replay_report_t *r) {
+    submit_entry_t entry;
+    while (xQueueReceive(s_submitQueue, &entry, 0) == pdTRUE) r->shares++;
+}
+
+// Before anything that may start a job: take the switch latency of the job
+// started last (lastSwitchUs is cleared here, so 0 means no core picked it up)
+static void replayBeforeStart(replay_report_t *r) {
+    mining_stats_t *stats = miner_get_stats();
+    if (r->sampledJob != s_jobCount) {
+        uint32_t us = stats->lastSwitchUs;
+        if (us) {
+            r->switches++;
+            r->switchUsTotal += us;
+            if (us > r->maxSwitchUs) r->maxSwitchUs = us;
+        } else {
+            r->unpicked++;
+        }
+        r->sampledJob = s_jobCount;
+    }
+    stats->lastSwitchUs = 0;
+}
+
+// After it: the build and publish time of a job it started
+static void replayAfterStart(replay_report_t *r, uint32_t jobsBefore) {
+    if (s_jobCount == jobsBefore) return;
+    mining_stats_t *stats = miner_get_stats();
+    uint32_t us = stats->lastBuildUs;
+    r->buildUsTotal += us;
+    if (us > r->maxBuildUs) r->maxBuildUs = us;
+    if (!r->hashStartMs) {
+        r->hashStartMs = millis();
+        r->hashStart = stats->hashes;
+    }
+}
+
+// Housekeeping until dueMs: deferred jobs start on their real-time schedule
+static void replayWait(replay_report_t *r, uint32_t dueMs) {
+    while (!s_replayStop && !s_replayRequested) {
+        replayDropShares(r);
+        if (deferredJobDue()) {
+            uint32_t jobs = s_jobCount;
+            replayBeforeStart(r);
+            startDeferredJob();
+            replayAfterStart(r, jobs);
+        }
+        pendingSweep();
+        updateHashRate();
+
+        int32_t left = (int32_t)(dueMs - millis());
+        if (left <= 0) return;
+        vTaskDelay(pdMS_TO_TICKS(left < REPLAY_SLEEP_MS ? left : REPLAY_SLEEP_MS));
+    }
+}
+
+// The captured session, as if the pool had just handed it out
+static void replaySession(const stratum_capture_session_t *session) {
+    sessionReset(s_active);
+    s_active->pool = POOL_PRIMARY;
+    s_active->subscribed = true;
+    safeStrCpy(s_active->extraNonce1, session->extraNonce1, sizeof(s_active->extraNonce1));
+    s_active->extraNonce2Size = session->extraNonce2Size;
+    s_active->versionMask = session->versionMask;
+    s_active->difficulty = session->difficulty;
+    sessionActivate(s_active);
+}
+
+static void replayReport(const replay_report_t *r, const mining_stats_t *before, double liveRate,
+                         uint32_t elapsedMs) {
+    const mining_stats_t *stats = miner_get_stats();
+    uint32_t started = s_jobCount - r->firstJob;
+    uint32_t held = s_jobDeferred ? 1 : 0;
+    uint32_t superseded = r->notifies > started + held ? r->notifies - started - held : 0;
+
+    Serial.printf("[REPLAY] %lu lines (%lu notifies, %lu sessions, %lu skipped) in %.1f s\n",
+                  r->lines, r->notifies, r->sessions, r->skipped, elapsedMs / 1000.0);
+    Serial.printf("[REPLAY] Jobs: %lu started, %lu held for the refresh interval, %lu superseded or malformed, %lu still held\n",
+                  started, stats->deferredJobs - before->deferredJobs, superseded, held);
+    if (started) {
+        Serial.printf("[REPLAY] Job build: avg %lu us, max %lu us\n",
+                      (uint32_t)(r->buildUsTotal / started), r->maxBuildUs);
+    }
+    if (r->switches) {
+        Serial.printf("[REPLAY] Publish to pickup: avg %lu us, max %lu us (%lu jobs, %lu replaced before pickup)\n",
+                      (uint32_t)(r->switchUsTotal / r->switches), r->maxSwitchUs, r->switches, r->unpicked);
+    }
+
+    // Duty cycle: hashing from the first job on, against the live rate
+    uint32_t hashMs = r->hashStartMs ? millis() - r->hashStartMs : 0;
+    if (hashMs) {
+        double rate = (stats->hashes - r->hashStart) * 1000.0 / hashMs;
+        uint32_t yieldMs = (stats->yieldUs[0] - before->yieldUs[0] + stats->yieldUs[1] - before->yieldUs[1]) / 1000;
+        if (liveRate > 0) {
+            Serial.printf("[REPLAY] Hashing: %.1f kH/s over %.1f s, %.1f%% of the %.1f kH/s live rate; cores yielded %lu ms\n",
+                          rate / 1000.0, hashMs / 1000.0, rate * 100.0 / liveRate, liveRate / 1000.0, yieldMs);
+        } else {
+            Serial.printf("[REPLAY] Hashing: %.1f kH/s over %.1f s (no live rate to compare); cores yielded %lu ms\n",
+                          rate / 1000.0, hashMs / 1000.0, yieldMs);
+        }
+    }
+    if (r->shares) {
+        Serial.printf("[REPLAY] %lu shares found, not submitted\n", r->shares);
+    }
+}
+
+// Play the capture through the same path as pool lines: handleServerMessage
+// decodes each notify into the job ring and publishDecodedJob starts or
+// holds it. Only pool-initiated methods replay; replies answered requests
+// this run never sent. Records come at their captured time divided by
+// speed (0 = no waiting), while deferred jobs keep real time, so a faster
+// replay holds and supersedes more of them.
+static void runReplay(uint32_t speed) {
+    if (!stratum_replay_begin()) {
+        Serial.println("[REPLAY] Not available (needs USE_STRATUM_CAPTURE=1 and an SD slot)");
+        return;
+    }
+
+    miner_stop();
+    s_active->client.stop();
+    s_standby->client.stop();
+    s_isConnected = false;
+    s_replaying = true;
+
+    double liveRate = s_hashRate;
+    mining_stats_t before = *miner_get_stats();
+    replay_report_t r;
+    memset(&r, 0, sizeof(r));
+    r.firstJob = r.sampledJob = s_jobCount;
+    bool haveSession = false;
+    uint32_t startMs = millis(), firstRecordMs = 0, ms;
+    if (speed) {
+        Serial.printf("[REPLAY] Replaying " CAPTURE_PATH " at %lux recorded speed\n", speed);
+    } else {
+        Serial.println("[REPLAY] Replaying " CAPTURE_PATH " without waiting");
+    }
+
+    while (!s_replayStop && !s_replayRequested) {
+        const char *line = NULL;
+        stratum_capture_session_t session;
+        stratum_capture_kind_t kind = stratum_replay_next(&ms, &line, &session);
+        if (kind == CAPTURE_NONE) {
+            replayWait(&r, millis() + 1);     // Card read ahead still on its way
+            continue;
+        }
+        if (kind == CAPTURE_END) break;
+
+        if (!r.lines++) firstRecordMs = ms;
+        if (speed) replayWait(&r, startMs + (ms - firstRecordMs) / speed);
+
+        if (kind == CAPTURE_SESSION) {
+            replaySession(&session);
+            haveSession = true;
+            r.sessions++;
+            continue;
+        }
+        if (!haveSession || !strstr(line, "\"method\"")) {
+            r.skipped++;
+            continue;
+        }
+        if (strstr(line, "mining.notify")) r.notifies++;
+
+        uint32_t jobs = s_jobCount;
+        replayBeforeStart(&r);
+        handleServerMessage(s_active, line);
+        replayAfterStart(&r, jobs);
+    }
+    uint32_t elapsedMs = millis() - startMs;
+
+    replayWait(&r, millis() + REPLAY_SETTLE_MS);
+    replayBeforeStart(&r);
+    replayDropShares(&r);
+    replayReport(&r, &before, liveRate, elapsedMs);
+
+    // Back to the pool: nothing replayed stays valid
+    miner_stop();
+    stratum_replay_end();
+    sessionReset(s_active);
+    s_isConnected = false;
+    s_jobDeferred = false;
+    s_cleanFrom = s_jobCount;
+    s_replaying = false;
+    Serial.println(r.lines ? "[REPLAY] Done, reconnecting to the pool" : "[REPLAY] Nothing replayed");
+}
+
+// ============================================================ 
+// Public API
+// ============================================================ 
+
+void stratum_init() {
+    // Create submission queue
+    s_submitQueue = xQueueCreate(MAX_PENDING_SUBMISSIONS, sizeof(submit_entry_t));
+    wakeInit();
+
+    // Initialize pending responses
+    memset(s_pending, 0, sizeof(s_pending));
+
+    mem_budget_add("stratum", "job ring", sizeof(s_jobs));
+    mem_budget_add("stratum", "sessions", sizeof(s_sessions));
+    mem_budget_add("stratum", "JSON + tx buffer", sizeof(s_doc) + sizeof(s_tx));
+    mem_budget_add("stratum", "pending + pools", sizeof(s_pending) + sizeof(s_pools) +
+                   sizeof(s_tlsCache) + sizeof(s_dnsCache) + sizeof(s_rank));
+
+    // Set default pool
+    pool_config_t *primary = &s_pools[POOL_PRIMARY];
+    safeStrCpy(primary->url, DEFAULT_POOL_URL, MAX_POOL_URL_LEN);
+    primary->port = DEFAULT_POOL_PORT;
+    safeStrCpy(primary->password, DEFAULT_POOL_PASS, MAX_PASSWORD_LEN);
+
+    dbg("[STRATUM] Initialized\n");
+}
+
+// Connect a session to a pool and run the handshake; failures count
+// against the pool's health
+static bool connectSession(pool_session_t *session, int poolIndex, int timeoutMs) {
+    session->pool = poolIndex;
+    const pool_config_t *pool = sessionPool(session);
+    dns_entry_t *dns = &s_dnsCache[poolIndex];
+    connect_phases_t *phases = &session->phases;
+    session->sv2 = pool->sv2;
+    memset(phases, 0, sizeof(*phases));
+    phases->startMs = millis();
+    phases->awaitingJob = true;     // The first notify usually lands mid-handshake
+
+    IPAddress ip;
+    if (!resolvePool(pool, dns, ip)) {
+        Serial.printf("[STRATUM] DNS lookup for %s failed\n", pool->url);
+        s_rank[poolIndex].failures++;
+        s_counters.connectFailures++;
+        return false;
+    }
+    phases->dnsMs = millis() - phases->startMs;
+
+    // STABILITY FIX: Use connect timeout to prevent long blocks
+    uint32_t tcpStart = millis();
+    if (!session->client.connect(ip, pool->port, timeoutMs)) {
+        dns->fresh = false;  // Address may have moved: look it up again next time
+        s_rank[poolIndex].failures++;
+        s_counters.connectFailures++;
+        return false;
+    }
+    phases->tcpMs = millis() - tcpStart;
+    tuneSocket(session->client);
+
+    if (pool->tls) {
+        if (!session->client.startTls(pool->url, &s_tlsCache[poolIndex], timeoutMs)) {
+            s_rank[poolIndex].failures++;
+            s_counters.connectFailures++;
+            return false;
+        }
+        phases->tlsMs = session->client.handshakeMs();
+        Serial.printf("[STRATUM] TLS handshake %lu ms (%s)\n", phases->tlsMs,
+            session->client.resumed() ? "resumed" : "full");
+    }
+
+    if (session->sv2 ? sv2Handshake(session) : subscribe(session)) {
+        dns->good = ip;
+        s_rank[poolIndex].failures = 0;
+        s_counters.connects++;
+        Serial.printf("[STRATUM] Connect phases: dns %lu ms, tcp %lu ms, subscribe %lu ms, authorize %lu ms\n",
+            phases->dnsMs, phases->tcpMs, phases->subscribeMs, phases->authorizeMs);
+        return true;
+    }
+    session->client.stop();
+    s_rank[poolIndex].failures++;
+    s_counters.connectFailures++;
+    return false;
+}
+
+// Handle everything the session has already received
+static void drainSession(pool_session_t *session) {
+    if (session->sv2) {
+        sv2_msg_t msg;
+        while (sv2ReadMessage(session, 0, &msg)) {
+            TRACE_POINT(TRACE_RX, 0);
+            handleSv2Message(session, &msg);
+        }
+        return;
+    }
+
+    const char *line;
+    while ((line = rxReadLine(&session->rx, session->client, 0)) != NULL) {
+        TRACE_POINT(TRACE_RX, 0);
+        handleServerMessage(session, line);
+    }
+}
+
+// Idle keepalive: a request without side effects, since repeating
+// suggest_difficulty restarts vardiff on some pools. Pools that do not
+// know mining.ping answer with an error, which is still a reply.
+static void sendKeepalive(pool_session_t *session) {
+    if (session->sv2) return;  // V2 has no request to spare; TCP keepalive (tuneSocket) covers it
+
+    char msg[STRATUM_MSG_BUFFER];
+    uint32_t keepId = getNextId();
+    snprintf(msg, sizeof(msg), "{\"id\":%lu,\"method\":\"mining.ping\",\"params\":[]}", keepId);
+    if (sendMessage(session->client, msg)) pendingAdd(keepId, PENDING_CONTROL, NULL);
+}
+
+// Suggest again once the measured hashrate has moved the target difficulty
+// by more than STRATUM_RESUGGEST_RATIO either way
+static void resuggestDifficulty(pool_session_t *session) {
+    if (!session->subscribed || session->suggested <= 0) return;
+
+    double diff = suggestedDifficulty();
+    double ratio = diff / session->suggested;
+    if (ratio < STRATUM_RESUGGEST_RATIO && ratio > 1.0 / STRATUM_RESUGGEST_RATIO) return;
+
+    Serial.printf("[STRATUM] Hashrate %.1f KH/s, suggesting difficulty %.6g\n", s_hashRate / 1000.0, diff);
+    if (session->sv2) {
+        sv2UpdateChannel(session);
+    } else {
+        suggestDifficulty(session);
+    }
+}
+
+#if STRATUM_HOT_STANDBY
+// Ready to take over: subscribed, still connected and holding a job
+static bool standbyReady() {
+    return s_standby->client.connected() && s_standby->hasJob;
+}
+
+// Pool the hot standby should hold: the best ranked pool other than the
+// active one, else the backup
+static int standbyTarget() {
+    int pool = bestPool(s_active->pool);
+    if (pool < 0 && s_active->pool != POOL_BACKUP && poolUsable(POOL_BACKUP)) pool = POOL_BACKUP;
+    return pool;
+}
+
+// Keep the standby session subscribed to the next pool in line: reconnect
+// it on a timer (moving it when the ranking changes), drain its messages
+// and keep it alive
+static void maintainStandby() {
+    static uint32_t lastAttempt = 0;
+    pool_session_t *session = s_standby;
+    int target = standbyTarget();
+
+    if (session->client.connected() && session->pool != target) {
+        Serial.printf("[STRATUM] Hot standby leaving %s\n", poolName(session->pool));
+        session->client.stop();
+        session->hasJob = false;
+    }
+
+    if (!session->client.connected()) {
+        if (target < 0) return;
+        if (lastAttempt && millis() - lastAttempt < POOL_STANDBY_RETRY_MS) return;
+        lastAttempt = millis();
+
+        if (connectSession(session, target, POOL_STANDBY_CONNECT_MS)) {
+            Serial.printf("[STRATUM] Hot standby on %s\n", poolName(target));
+        }
+        return;
+    }
+
+    drainSession(session);
+    resuggestDifficulty(session);
+
+    if (millis() - session->lastKeepalive > KEEPALIVE_MS) {
+        sendKeepalive(session);
+        session->lastKeepalive = millis();
+    }
+
+    if (millis() - session->lastActivity > INACTIVITY_MS) {
+        Serial.println("[STRATUM] Hot standby inactive, disconnecting");
+        session->client.stop();
+        session->hasJob = false;
+    }
+}
+#endif
+
+// WiFi events wake the task, so a drop is handled at once and each
+// reconnect attempt follows the previous one's failure
+static void wifiEvent(WiFiEvent_t event) {
+    if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+        wakeTask();
+    }
+}
+
+// Sleep until woken (WiFi event, share queued) or timeoutMs passes
+static void waitForWake(uint32_t timeoutMs) {
+    if (s_wakeFd < 0) {
+        vTaskDelay(pdMS_TO_TICKS(timeoutMs));
+        return;
+    }
+    fd_set readable;
+    FD_ZERO(&readable);
+    FD_SET(s_wakeFd, &readable);
+    struct timeval tv = { (time_t)(timeoutMs / 1000), (suseconds_t)((timeoutMs % 1000) * 1000) };
+    if (select(s_wakeFd + 1, &readable, NULL, NULL, &tv) > 0) {
+        uint64_t count;
+        read(s_wakeFd, &count, sizeof(count));
+    }
+}
+
+void stratum_task(void *param) {
+    Serial.printf("[STRATUM] Task started on core %d\n", xPortGetCoreID());
+
+    WiFi.onEvent(wifiEvent);
+
+    while (true) {
+        // Replay runs without the network, in place of the pool
+        if (s_replayRequested) {
+            s_replayRequested = false;
+            runReplay(s_replaySpeed);
+            continue;
+        }
+
+        // WiFi down: the miners keep the last job for WIFI_OUTAGE_GRACE_MS
+        // while the cached access point (then a full scan) is retried
+        if (WiFi.status() != WL_CONNECTED) {
+            uint32_t now = millis();
+            if (s_wifiSeen) outageStart();
+
+            if (s_isConnected && s_outageStartMs && now - s_outageStartMs >= WIFI_OUTAGE_GRACE_MS) {
+                miner_stop();
+                s_active->client.stop();
+                s_standby->client.stop();
+                s_isConnected = false;
+                s_counters.disconnects++;
+                Serial.printf("[WIFI] Down for %lu s, pool session dropped\n", (now - s_outageStartMs) / 1000);
+            }
+
+            // Calculate exponential backoff: 1s, 2s, 4s, 8s, 16s, 30s max
+            uint32_t backoffMs = 1000 * (1 << min(s_wifiReconnectAttempts, (uint32_t)5));
+            if (backoffMs > 30000) backoffMs = 30000;
+
+            if (s_wifiSeen && (s_wifiReconnectAttempts == 0 || now - s_lastWifiReconnectAttempt >= backoffMs)) {
+                bool scan = s_wifiReconnectAttempts & 1;  // Cached AP first, then alternate
+                s_wifiReconnectAttempts++;
+                s_lastWifiReconnectAttempt = now;
+                Serial.printf("[WIFI] Reconnect attempt %lu (%s, backoff: %lums)\n",
+                              s_wifiReconnectAttempts, scan ? "scan" : "cached AP", backoffMs);
+                wifi_manager_reconnect(scan);
+            }
+
+            waitForWake(500);
+            continue;
+        }
+
+        // WiFi connected - reset reconnect counter. From now on reconnects
+        // are ours: the driver's own retry would rescan every channel.
+        if (!s_wifiSeen) {
+            s_wifiSeen = true;
+            WiFi.setAutoReconnect(false);
+        }
+        if (s_wifiReconnectAttempts > 0) {
+            Serial.printf("[WIFI] Reconnected after %lu attempts\n", s_wifiReconnectAttempts);
+            s_wifiReconnectAttempts = 0;
+        }
+        if (s_outageStartMs && !s_outageLinkMs) {
+            s_outageLinkMs = (millis() - s_outageStartMs) | 1;
+            if (s_isConnected && s_active->client.connected()) {
+                s_counters.sessionsKept++;
+                outageEnd("pool session kept");
+            }
+        }
+
+        // Check pool configuration
+        if (!s_pools[POOL_PRIMARY].url[0] || !s_pools[POOL_PRIMARY].port) {
+            dbg("[STRATUM] No pool configured\n");
+            vTaskDelay(5000 / portTICK_PERIOD_MS);
+            continue;
+        }
+
+        if (!s_pools[POOL_PRIMARY].wallet[0]) {
+            dbg("[STRATUM] No wallet configured\n");
             vTaskDelay(5000 / portTICK_PERIOD_MS);
             continue;
         }
@@ -563,169 +2234,237 @@ void stratum_task(void *param) {
         // Handle reconnect request
         if (s_reconnectRequested) {
             miner_stop();
-            client.stop();
+            s_active->client.stop();
+            s_standby->client.stop();
             s_isConnected = false;
             s_reconnectRequested = false;
             vTaskDelay(100 / portTICK_PERIOD_MS);
             continue;
         }
 
-        // Connect if needed
-        if (!client.connected()) {
+#if STRATUM_HOT_STANDBY
+        // Active pool dropped: mine the standby's job instead of reconnecting
+        if (s_isConnected && !s_active->client.connected() && standbyReady()) {
+            Serial.printf("[STRATUM] %s lost, failing over to hot standby\n", poolName(s_active->pool));
+            sessionSwap();
+        }
+#endif
+
+        // Connect if needed: best ranked pool first, the backup once none is
+        // healthy (POOL_MAX_FAILURES attempts each)
+        if (!s_active->client.connected()) {
+            // A lost session is offered back to the same pool for resume; the
+            // miners stay on its job until the pool has answered
+            bool resuming = s_isConnected && sessionRemember(s_active);
             if (s_isConnected) {
-                miner_stop();
+                if (!resuming) miner_stop();
                 s_isConnected = false;
+                s_counters.disconnects++;
             }
 
-            usingBackup = false;
+            int pool = resuming ? s_active->pool : connectTarget();
+            Serial.printf("[STRATUM] Connecting to %s:%d%s...\n", s_pools[pool].url, s_pools[pool].port,
+                          resuming ? " (resuming session)" : "");
 
-            Serial.printf("[STRATUM] Connecting to %s:%d...\n",
-                s_primaryPool.url, s_primaryPool.port);
+            bool connected = connectSession(s_active, pool, 10000);
+            s_resume.extraNonce1[0] = '\0';
+            if (resuming && !(connected && s_active->resumed)) {
+                miner_stop();   // New extranonce1: the running job is dead
+            }
 
-            // STABILITY FIX: Use connect timeout (10s) to prevent long blocks
-            if (client.connect(s_primaryPool.url, s_primaryPool.port, 10000)) {
-                if (subscribe(client, s_primaryPool.wallet, s_primaryPool.password, s_primaryPool.workerName)) {
-                    s_isConnected = true;
-                    s_lastActivity = millis();
-                    safeStrCpy(s_currentPoolUrl, s_primaryPool.url, MAX_POOL_URL_LEN);
-                    Serial.println("[STRATUM] Connected to primary pool");
-                } else {
-                    client.stop();
+            if (connected) {
+                sessionActivate(s_active);
+                if (s_active->resumed) {
+                    s_counters.sessionsResumed++;
+                    outageEnd("session resumed");
                 }
+                Serial.printf("[STRATUM] Connected to %s%s\n", poolName(pool),
+                              s_active->resumed ? " (session resumed)" : "");
             } else {
                 Serial.println("[STRATUM] Connection failed");
-
-                // Try backup pool after 30s of failures
-                if (s_hasBackupPool && (millis() - lastConnectAttempt > POOL_FAILOVER_MS)) {
-                    Serial.printf("[STRATUM] Trying backup: %s:%d\n",
-                        s_backupPool.url, s_backupPool.port);
-
-                    // STABILITY FIX: Use connect timeout (10s)
-                    if (client.connect(s_backupPool.url, s_backupPool.port, 10000)) {
-                        if (subscribe(client, s_backupPool.wallet, s_backupPool.password, s_backupPool.workerName)) {
-                            s_isConnected = true;
-                            usingBackup = true;
-                            backupConnectTime = millis();
-                            s_lastActivity = millis();
-                            safeStrCpy(s_currentPoolUrl, s_backupPool.url, MAX_POOL_URL_LEN);
-                            Serial.println("[STRATUM] Connected to backup pool");
-                        } else {
-                            client.stop();
-                        }
-                    }
-                }
-            }
-
-            lastConnectAttempt = millis();
-
-            if (!s_isConnected) {
                 vTaskDelay(10000 / portTICK_PERIOD_MS);
                 continue;
             }
         }
 
-        // Try to switch back from backup after 2 minutes
-        if (usingBackup && (millis() - backupConnectTime > 120000)) {
-            // STABILITY FIX: Use connect timeout and avoid shallow copy of WiFiClient
-            // Test connection to primary pool first
-            WiFiClient testClient;
-            if (testClient.connect(s_primaryPool.url, s_primaryPool.port, 10000)) {
-                if (subscribe(testClient, s_primaryPool.wallet, s_primaryPool.password, s_primaryPool.workerName)) {
-                    // Successfully connected to primary - switch over
-                    miner_stop();
-                    client.stop();
-                    // Use swap to safely transfer the connection instead of shallow copy
-                    std::swap(client, testClient);
-                    testClient.stop();  // Clean up the old (now empty) client
-                    usingBackup = false;
-                    safeStrCpy(s_currentPoolUrl, s_primaryPool.url, MAX_POOL_URL_LEN);
-                    Serial.println("[STRATUM] Switched back to primary pool");
-                    continue;
-                } else {
-                    testClient.stop();
-                }
-            }
-            backupConnectTime = millis();  // Try again later
+        bool reranked = rankPools();
+
+#if STRATUM_HOT_STANDBY
+        maintainStandby();
+
+        // Standby holds a better pool with a job: switch the same way,
+        // keeping the previous pool connected as the new standby
+        if (standbyReady() && s_standby->pool == switchTarget()) {
+            Serial.printf("[STRATUM] Switched to %s (hot standby)\n", poolName(s_standby->pool));
+            sessionSwap();
+        }
+#else
+        // A probe found a better pool: connect it on the spare session, whose
+        // handshake leaves the running job alone, then switch over
+        int better = reranked ? switchTarget() : -1;
+        if (better >= 0 && connectSession(s_standby, better, 10000)) {
+            miner_stop();
+            s_active->client.stop();
+            sessionSwap();
+            Serial.printf("[STRATUM] Switched to %s\n", poolName(better));
+            continue;
         }
+#endif
 
         // Handle incoming messages
-        while (client.available() > 0) {
-            handleServerMessage(client);
+        if (s_active->client.available() > 0) {
+            miner_yield_hint();  // Pool is talking - keep the mining cores yielding often
         }
+        drainSession(s_active);
 
         // Process submission queue
         submit_entry_t entry;
         while (xQueueReceive(s_submitQueue, &entry, 0) == pdTRUE) {
-            submitShare(client, &entry);
+            submitShare(s_active->client, &entry);
         }
+        txFlush(s_active->client);
 
         // Send keepalive if idle
         if (millis() - s_lastSubmit > KEEPALIVE_MS) {
-            char msg[STRATUM_MSG_BUFFER];
-            uint32_t keepId = getNextId();
-            snprintf(msg, sizeof(msg),
-                "{\"id\":%lu,\"method\":\"mining.suggest_difficulty\",\"params\":[%.10g]}",
-                keepId, DESIRED_DIFFICULTY);
-            sendMessage(client, msg);
+            sendKeepalive(s_active);
             s_lastSubmit = millis();
         }
 
+        pendingSweep();
+        startDeferredJob();
+        updateHashRate();
+        resuggestDifficulty(s_active);
+
         // Check for inactivity
-        if (millis() - s_lastActivity > INACTIVITY_MS) {
+        if (millis() - s_active->lastActivity > INACTIVITY_MS) {
             Serial.println("[STRATUM] Pool inactive, disconnecting");
+            s_active->client.stop();
+            s_counters.disconnects++;
+#if !STRATUM_HOT_STANDBY
             miner_stop();
-            client.stop();
             s_isConnected = false;
+#endif
+            continue;
         }
 
-        vTaskDelay(100 / portTICK_PERIOD_MS);
+        waitForWork(IDLE_WAKE_MS);
     }
 }
 
 bool stratum_submit_share(const submit_entry_t *entry) {
     if (!s_submitQueue) return false;
-    return xQueueSend(s_submitQueue, entry, pdMS_TO_TICKS(100)) == pdTRUE;
+    submit_entry_t queued = *entry;
+    queued.queuedUs = micros();
+    if (xQueueSend(s_submitQueue, &queued, pdMS_TO_TICKS(100)) != pdTRUE) return false;
+    wakeTask();
+    miner_yield_hint();  // Submission waiting on the stratum task
+    return true;
+}
+
+void stratum_set_work_hook(stratum_work_hook_t hook) {
+    s_workHook = hook;
 }
 
 void stratum_reconnect() {
     s_reconnectRequested = true;
+    wakeTask();
+}
+
+void stratum_replay(uint32_t speed) {
+    s_replaySpeed = speed;
+    s_replayStop = false;
+    s_replayRequested = true;
+    wakeTask();
+}
+
+void stratum_replay_stop() {
+    s_replayStop = true;
 }
 
 bool stratum_is_connected() {
-    return s_isConnected;
+    return s_isConnected && !s_replaying;
 }
 
 bool stratum_is_backup() {
     if (!s_isConnected) return false;
     // Compare current URL with primary URL
-    return strncmp(s_currentPoolUrl, s_primaryPool.url, MAX_POOL_URL_LEN) != 0;
+    return strncmp(s_currentPoolUrl, s_pools[POOL_PRIMARY].url, MAX_POOL_URL_LEN) != 0;
 }
 
 const char* stratum_get_pool() {
     return s_currentPoolUrl;
 }
 
-void stratum_set_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName) {
-    safeStrCpy(s_primaryPool.url, url, MAX_POOL_URL_LEN);
-    s_primaryPool.port = port;
-    safeStrCpy(s_primaryPool.wallet, wallet, MAX_WALLET_LEN);
-    safeStrCpy(s_primaryPool.password, password, MAX_PASSWORD_LEN);
-    if (workerName) {
-        safeStrCpy(s_primaryPool.workerName, workerName, 32);
-    } else {
-        s_primaryPool.workerName[0] = '\0';
+void stratum_get_counters(stratum_counters_t *out) {
+    if (out) *out = s_counters;
+}
+
+const mining_job_bin_t *stratum_find_job(const char *jobId) {
+    uint32_t held = jobsHeld();
+    for (uint32_t i = 1; i <= held; i++) {
+        const mining_job_bin_t *job = &s_jobs[(s_jobCount - i) % STRATUM_JOB_RING];
+        if (strcmp(job->jobId, jobId) == 0) return job;
     }
+    return NULL;
 }
 
-void stratum_set_backup_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName) {
-    safeStrCpy(s_backupPool.url, url, MAX_POOL_URL_LEN);
-    s_backupPool.port = port;
-    safeStrCpy(s_backupPool.wallet, wallet, MAX_WALLET_LEN);
-    safeStrCpy(s_backupPool.password, password, MAX_PASSWORD_LEN);
+// Fill a pool config from the user's settings. "stratum2+tcp://host" selects
+// Stratum V2; its authority key goes after the host ("host/key") or, when
+// the URL has no room for it, in the password field.
+static void setPoolConfig(pool_config_t *pool, const char *url, int port, const char *wallet,
+                          const char *password, const char *workerName) {
+    pool->sv2 = strncmp(url, SV2_SCHEME, strlen(SV2_SCHEME)) == 0;
+    pool->tls = strncmp(url, TLS_SCHEME, strlen(TLS_SCHEME)) == 0 ||
+                strncmp(url, TLS_SCHEME_ALT, strlen(TLS_SCHEME_ALT)) == 0;
+    safeStrCpy(pool->url, (pool->sv2 || pool->tls) ? strstr(url, "://") + 3 : url, MAX_POOL_URL_LEN);
+    pool->port = port;
+    safeStrCpy(pool->wallet, wallet, MAX_WALLET_LEN);
+    safeStrCpy(pool->password, password, MAX_PASSWORD_LEN);
     if (workerName) {
-        safeStrCpy(s_backupPool.workerName, workerName, 32);
+        safeStrCpy(pool->workerName, workerName, 32);
     } else {
-        s_backupPool.workerName[0] = '\0';
+        pool->workerName[0] = '\0';
     }
-    s_hasBackupPool = (url[0] && port > 0 && wallet[0]);
-}
\ No newline at end of file
+
+    pool->hasAuthorityKey = false;
+    if (!pool->sv2) return;
+
+    char *key = strchr(pool->url, '/');
+    if (key) *key++ = '\0';
+    const char *text = (key && key[0]) ? key : pool->password;
+    pool->hasAuthorityKey = text[0] && sv2_decode_authority_key(text, pool->authorityKey);
+    if (key && key[0] && !pool->hasAuthorityKey) {
+        Serial.println("[STRATUM] WARNING: V2 authority key is not valid base58check, ignored");
+    }
+}
+
+void stratum_set_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName) {
+    setPoolConfig(&s_pools[POOL_PRIMARY], url, port, wallet, password, workerName);
+
+    // Extra endpoints mine for the same account
+    for (int i = POOL_BACKUP + 1; i < STRATUM_MAX_POOLS; i++) {
+        pool_config_t *pool = &s_pools[i];
+        if (!pool->url[0]) continue;
+        safeStrCpy(pool->wallet, wallet, MAX_WALLET_LEN);
+        safeStrCpy(pool->password, password, MAX_PASSWORD_LEN);
+        safeStrCpy(pool->workerName, workerName ? workerName : "", sizeof(pool->workerName));
+    }
+}
+
+bool stratum_add_pool(const char *url, int port) {
+    const pool_config_t *primary = &s_pools[POOL_PRIMARY];
+    for (int i = POOL_BACKUP + 1; i < STRATUM_MAX_POOLS; i++) {
+        if (s_pools[i].url[0]) continue;
+        setPoolConfig(&s_pools[i], url, port, primary->wallet, primary->password, primary->workerName);
+        return true;
+    }
+    return false;
+}
+
+void stratum_set_difficulty(double difficulty) {
+    s_configDifficulty = difficulty > 0 ? difficulty : DESIRED_DIFFICULTY;
+}
+
+void stratum_set_backup_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName) {
+    setPoolConfig(&s_pools[POOL_BACKUP], url, port, wallet, password, workerName);
+}
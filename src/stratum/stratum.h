@@ -1,6 +1,6 @@
 /*
  * SparkMiner - Stratum Protocol
- * Stratum v1 client for pool communication
+ * Stratum v1 and v2 client for pool communication
  *
  * Based on BitsyMiner by Justin Williams (GPL v3)
  *
@@ -8,6 +8,8 @@
  * - FreeRTOS queue for async submissions
  * - Callback mechanism for response tracking
  * - Primary/backup pool failover
+ * - Stratum V2 standard channels (Noise-encrypted, header-only jobs)
+ * - Stratum over TLS (stratum+ssl://) with resumed handshakes on reconnect
  */
 
 #ifndef STRATUM_H
@@ -44,6 +46,20 @@ bool stratum_submit_share(const submit_entry_t *entry);
  */
 void stratum_reconnect();
 
+/**
+ * Replay the stratum capture on the SD card (stratum_capture.h) in place of
+ * the pool: the pool is dropped, each recorded line goes through the usual
+ * message handling at its recorded time divided by speed (0 = no waiting),
+ * a job switch and hashing duty cycle report is printed, and the pool is
+ * reconnected. Shares found meanwhile are not submitted.
+ */
+void stratum_replay(uint32_t speed);
+
+/**
+ * End a running replay early (report and reconnect as usual)
+ */
+void stratum_replay_stop();
+
 /**
  * Check if connected to pool
  */
@@ -59,15 +75,82 @@ bool stratum_is_backup();
  */
 const char* stratum_get_pool();
 
+/**
+ * Pool connection counters since boot
+ */
+typedef struct {
+    uint32_t connects;          // Completed pool handshakes (active, standby and switch targets)
+    uint32_t connectFailures;   // Failed DNS lookups, TCP/TLS connects and handshakes
+    uint32_t disconnects;       // Active pool lost (dropped, inactive or WiFi down)
+    uint32_t poolSwitches;      // Session swaps: hot standby failover, failback, faster pool
+    uint32_t wifiOutages;       // WiFi link lost after having been up
+    uint32_t sessionsKept;      // Outages the pool connection survived
+    uint32_t sessionsResumed;   // Reconnects where the pool resumed the session
+    uint32_t lastOutageMs;      // Link lost to mining valid work again, last outage
+    uint32_t maxOutageMs;
+    uint64_t outageMsTotal;
+} stratum_counters_t;
+
+/**
+ * Copy the connection counters (safe from any task)
+ */
+void stratum_get_counters(stratum_counters_t *out);
+
+/**
+ * Look up one of the last STRATUM_JOB_RING decoded jobs by job ID
+ * Stratum task only (the ring is rewritten by each mining.notify)
+ *
+ * @return The job, or NULL if it has aged out of the ring
+ */
+const mining_job_bin_t *stratum_find_job(const char *jobId);
+
+/**
+ * Active-session work, as reported to the LAN stratum proxy (stratum_proxy.h)
+ */
+typedef struct {
+    const mining_job_bin_t *job;    // New job, NULL when only difficulty or mask changed
+    bool restart;                   // Session activated: jobs before this one are void
+    bool carved;                    // Extranonce2 split for downstream miners (USE_STRATUM_PROXY)
+    double difficulty;              // Pool difficulty (0 = none yet)
+    uint32_t versionMask;           // Version rolling mask (0 = none)
+} stratum_work_t;
+
+typedef void (*stratum_work_hook_t)(const stratum_work_t *work);
+
+/**
+ * Register a hook called on the stratum task whenever the active session's
+ * job, difficulty or version mask changes (keep it short: copy and return)
+ */
+void stratum_set_work_hook(stratum_work_hook_t hook);
+
 /**
  * Set pool configuration
+ * @param url        Pool host; "stratum2+tcp://host[/authority-key]" selects
+ *                   Stratum V2 (the key may go in password instead),
+ *                   "stratum+ssl://host" (or "stratum+tls://") Stratum
+ *                   over TLS with session resumption across reconnects
  * @param workerName Optional worker name (appended as wallet.worker)
  */
 void stratum_set_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName = NULL);
 
+/**
+ * Set the configured difficulty: suggested until a hashrate is measured,
+ * then the floor under the hashrate-based suggestion
+ */
+void stratum_set_difficulty(double difficulty);
+
 /**
  * Set backup pool configuration
  */
 void stratum_set_backup_pool(const char *url, int port, const char *wallet, const char *password, const char *workerName = NULL);
 
+/**
+ * Add a pool endpoint for the primary wallet (credentials follow
+ * stratum_set_pool). The primary and the added pools are ranked by
+ * connect + subscribe round trip and the fastest healthy one is mined;
+ * the backup pool only takes over while none of them is reachable.
+ * @return false if all MAX_EXTRA_POOLS slots are taken
+ */
+bool stratum_add_pool(const char *url, int port);
+
 #endif // STRATUM_H
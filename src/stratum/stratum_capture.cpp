@@ -0,0 +1,402 @@
+/*
+ * SparkMiner - Stratum Capture and Replay Implementation
+ * See stratum_capture.h.
+ */
+
+#include <Arduino.h>
+#include <freertos/message_buffer.h>
+#include "stratum_capture.h"
+#include "stratum_types.h"
+#include "../stats/mem_budget.h"
+#include "../config/nvs_config.h"
+
+#if USE_STRATUM_CAPTURE && (defined(USE_SD_MMC) || defined(SD_CS_PIN))
+    #define CAPTURE_HAS_SD 1
+#else
+    #define CAPTURE_HAS_SD 0
+#endif
+
+static stratum_capture_stats_t s_stats = {0};
+
+#if USE_STRATUM_CAPTURE
+
+#define CAPTURE_LINE_MAX    STRATUM_MAX_LINE    // Longest line kept (the stratum task's own limit)
+#define CAPTURE_HEAD        4       // Record prefix: capture time in ms
+#define CAPTURE_REPLAY_ROOM (CAPTURE_LINE_MAX + CAPTURE_HEAD + 8)  // Room for one more replay record
+
+#if CAPTURE_QUEUE_BYTES < 2 * CAPTURE_REPLAY_ROOM
+    #error "CAPTURE_QUEUE_BYTES must hold two of the longest records (raise it with STRATUM_MAX_LINE)"
+#endif
+
+enum {
+    MODE_OFF = 0,
+    MODE_SD,
+    MODE_SERIAL,
+    MODE_REPLAY
+};
+
+static volatile uint8_t s_want = MODE_OFF;     // Requested (any task)
+static volatile uint8_t s_mode = MODE_OFF;     // In force (capture task)
+
+// Records between the stratum task and the capture task: captured lines one
+// way, read-ahead replay records the other (never both at once)
+static uint8_t s_msgStorage[CAPTURE_QUEUE_BYTES + 1];
+static StaticMessageBuffer_t s_msgBuffer;
+static MessageBufferHandle_t s_msg = NULL;
+
+static char s_rec[CAPTURE_HEAD + CAPTURE_LINE_MAX + 1];    // Stratum task side
+static char s_line[CAPTURE_HEAD + CAPTURE_LINE_MAX + 1];   // Capture task side
+
+// Session the last session record described (stratum task)
+static char s_en1[32];
+static int s_en2Size = -1;
+
+#if CAPTURE_HAS_SD
+// Records waiting for the card; during a replay, the line being read back
+static char s_block[CAPTURE_BLOCK + CAPTURE_LINE_MAX + 16] __attribute__((aligned(4)));
+static size_t s_fill = 0;
+static uint32_t s_lastFlush = 0;
+static uint32_t s_replayPos = 0;
+static bool s_replayDone = false;
+#endif
+
+STATIC_TASK(s_captureTask, CAPTURE_STACK);
+
+// ============================================================
+// Stratum Side
+// ============================================================
+
+static void sendRecord(uint32_t ms, size_t len) {
+    memcpy(s_rec, &ms, CAPTURE_HEAD);
+    if (xMessageBufferSend(s_msg, s_rec, CAPTURE_HEAD + len, 0) == CAPTURE_HEAD + len) {
+        s_stats.records++;
+    } else {
+        __atomic_fetch_add(&s_stats.dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+#if CAPTURE_HAS_SD
+static bool parseSession(const char *text, stratum_capture_session_t *session) {
+    unsigned long mask = 0;
+    memset(session, 0, sizeof(*session));
+    if (sscanf(text, "%31s %d %lx %lf", session->extraNonce1, &session->extraNonce2Size,
+               &mask, &session->difficulty) < 3) {
+        return false;
+    }
+    if (strcmp(session->extraNonce1, "-") == 0) session->extraNonce1[0] = '\0';
+    session->versionMask = mask;
+    return true;
+}
+#endif
+
+// ============================================================
+// Card
+// ============================================================
+
+#if CAPTURE_HAS_SD
+
+// Write out everything buffered. A failed write drops it: a card that went
+// away must not back the buffer up.
+static void flushBlock() {
+    if (!s_fill) return;
+
+    fs::FS *sd = nvs_sd_lock();
+    size_t written = 0;
+    if (sd) {
+        File file = sd->open(CAPTURE_PATH, FILE_APPEND);
+        if (file) {
+            written = file.write((const uint8_t *)s_block, s_fill);
+            file.close();
+        }
+        nvs_sd_unlock();
+    }
+
+    s_stats.bytes += written;
+    if (written != s_fill) {
+        s_stats.errors++;
+        __atomic_fetch_add(&s_stats.dropped, 1, __ATOMIC_RELAXED);
+        Serial.printf("[CAPTURE] Write failed, %u bytes dropped\n", (unsigned)s_fill);
+    }
+    s_fill = 0;
+    s_lastFlush = millis();
+}
+
+static void appendRecord(uint32_t ms, const char *text, size_t len) {
+    char head[16];
+    int headLen = snprintf(head, sizeof(head), "%lu\t", ms);
+    if (s_fill + headLen + len + 1 > sizeof(s_block)) flushBlock();
+
+    memcpy(s_block + s_fill, head, headLen);
+    memcpy(s_block + s_fill + headLen, text, len);
+    s_fill += headLen + len;
+    s_block[s_fill++] = '\n';
+
+    if (s_fill >= CAPTURE_BLOCK) flushBlock();
+}
+
+// Replace the previous capture with an empty file
+static bool startFile() {
+    fs::FS *sd = nvs_sd_lock();
+    if (!sd) {
+        Serial.println("[CAPTURE] No SD card");
+        return false;
+    }
+    if (!sd->exists(SD_LOG_DIR)) sd->mkdir(SD_LOG_DIR);
+    File file = sd->open(CAPTURE_PATH, FILE_WRITE);
+    bool ok = file;
+    if (file) file.close();
+    nvs_sd_unlock();
+    if (!ok) {
+        s_stats.errors++;
+        Serial.println("[CAPTURE] Cannot create " CAPTURE_PATH);
+    }
+    s_fill = 0;
+    s_lastFlush = millis();
+    return ok;
+}
+
+static void sendEnd() {
+    uint32_t ms = 0;
+    xMessageBufferSend(s_msg, &ms, CAPTURE_HEAD, 0);
+    s_replayDone = true;
+}
+
+// Read records ahead while the buffer has room for the longest one; the
+// file is reopened each pass, so the card is never held between passes
+static void readAhead() {
+    if (s_replayDone || xMessageBufferSpacesAvailable(s_msg) < CAPTURE_REPLAY_ROOM) return;
+
+    fs::FS *sd = nvs_sd_lock();
+    if (!sd) {
+        Serial.println("[CAPTURE] No SD card");
+        sendEnd();
+        return;
+    }
+    File file = sd->open(CAPTURE_PATH, FILE_READ);
+    if (!file) {
+        nvs_sd_unlock();
+        Serial.println("[CAPTURE] No recording at " CAPTURE_PATH);
+        sendEnd();
+        return;
+    }
+
+    file.seek(s_replayPos);
+    while (xMessageBufferSpacesAvailable(s_msg) >= CAPTURE_REPLAY_ROOM) {
+        if (!file.available()) {
+            sendEnd();
+            break;
+        }
+        size_t n = file.readBytesUntil('\n', s_block, sizeof(s_block) - 1);
+        s_block[n] = '\0';
+        if (n && s_block[n - 1] == '\r') s_block[--n] = '\0';
+
+        // "<ms>\t<line>", as written here or printed over serial
+        const char *p = s_block;
+        if (strncmp(p, "[CAPTURE] ", 10) == 0) p += 10;
+        char *tab;
+        uint32_t ms = strtoul(p, &tab, 10);
+        if (tab == p || *tab != '\t') continue;
+        size_t len = strlen(tab + 1);
+        if (!len || len > CAPTURE_LINE_MAX) continue;
+
+        memcpy(s_line, &ms, CAPTURE_HEAD);
+        memcpy(s_line + CAPTURE_HEAD, tab + 1, len);
+        xMessageBufferSend(s_msg, s_line, CAPTURE_HEAD + len, 0);
+        s_stats.replayed++;
+    }
+    s_replayPos = file.position();
+    file.close();
+    nvs_sd_unlock();
+}
+
+#endif  // CAPTURE_HAS_SD
+
+// ============================================================
+// Task
+// ============================================================
+
+static void drainCapture() {
+    size_t n;
+    while ((n = xMessageBufferReceive(s_msg, s_line, sizeof(s_line) - 1, 0)) > CAPTURE_HEAD) {
+        uint32_t ms;
+        memcpy(&ms, s_line, CAPTURE_HEAD);
+        s_line[n] = '\0';
+        if (s_mode == MODE_SERIAL) {
+            s_stats.bytes += Serial.printf("[CAPTURE] %lu\t%s\n", ms, s_line + CAPTURE_HEAD);
+            continue;
+        }
+#if CAPTURE_HAS_SD
+        appendRecord(ms, s_line + CAPTURE_HEAD, n - CAPTURE_HEAD);
+#endif
+    }
+#if CAPTURE_HAS_SD
+    if (s_mode == MODE_SD && s_fill && millis() - s_lastFlush >= CAPTURE_FLUSH_MS) flushBlock();
+#endif
+}
+
+static void switchMode(uint8_t want) {
+    if (s_mode == MODE_SD || s_mode == MODE_SERIAL) {
+        drainCapture();     // Records sent before the stop
+#if CAPTURE_HAS_SD
+        flushBlock();
+#endif
+        Serial.printf("[CAPTURE] Stopped: %lu records, %lu dropped\n", s_stats.records, s_stats.dropped);
+    }
+
+    // Leftovers from the other direction (the stratum task is not using
+    // the buffer while a replay begins or ends)
+    if (want == MODE_REPLAY || s_mode == MODE_REPLAY) xMessageBufferReset(s_msg);
+
+#if CAPTURE_HAS_SD
+    if (want == MODE_SD && !startFile()) {
+        if (s_want == MODE_SD) s_want = MODE_OFF;
+        want = MODE_OFF;
+    }
+    if (want == MODE_REPLAY) {
+        s_replayPos = 0;
+        s_replayDone = false;
+    }
+#endif
+
+    s_mode = want;
+    s_stats.active = (want == MODE_SD || want == MODE_SERIAL);
+    s_stats.serial = (want == MODE_SERIAL);
+    s_stats.replaying = (want == MODE_REPLAY);
+    if (s_stats.active) {
+        Serial.printf("[CAPTURE] Capturing pool lines to %s\n", want == MODE_SERIAL ? "serial" : CAPTURE_PATH);
+    }
+}
+
+static void capture_task(void *param) {
+    while (true) {
+        uint8_t want = s_want;
+        if (want != s_mode) switchMode(want);
+
+        if (s_mode == MODE_SD || s_mode == MODE_SERIAL) {
+            drainCapture();
+        }
+#if CAPTURE_HAS_SD
+        else if (s_mode == MODE_REPLAY) {
+            readAhead();
+        }
+#endif
+        vTaskDelay(pdMS_TO_TICKS(CAPTURE_POLL_MS));
+    }
+}
+
+#endif  // USE_STRATUM_CAPTURE
+
+// ============================================================
+// Public API
+// ============================================================
+
+bool stratum_capture_init() {
+#if !USE_STRATUM_CAPTURE
+    return false;
+#else
+    if (s_msg) return true;
+
+    s_msg = xMessageBufferCreateStatic(sizeof(s_msgStorage) - 1, s_msgStorage, &s_msgBuffer);
+    mem_budget_add("capture", "message buffer", sizeof(s_msgStorage) + sizeof(s_rec) + sizeof(s_line));
+#if CAPTURE_HAS_SD
+    mem_budget_add("capture", "block buffer", sizeof(s_block));
+#endif
+    mem_task_create(
+        capture_task,
+        "Capture",
+        NULL,
+        CAPTURE_PRIORITY,
+        CAPTURE_CORE,
+        "capture",
+        STATIC_TASK_MEM(s_captureTask)
+    );
+    return true;
+#endif
+}
+
+bool stratum_capture_start(bool toSerial) {
+#if !USE_STRATUM_CAPTURE
+    return false;
+#else
+    if (!s_msg || s_want == MODE_REPLAY) return false;
+    if (!toSerial && !CAPTURE_HAS_SD) return false;
+    s_en2Size = -1;     // Open with a session record
+    s_want = toSerial ? MODE_SERIAL : MODE_SD;
+    return true;
+#endif
+}
+
+void stratum_capture_stop() {
+#if USE_STRATUM_CAPTURE
+    if (s_want != MODE_REPLAY) s_want = MODE_OFF;
+#endif
+}
+
+void stratum_capture_line(const char *line, const char *extraNonce1, int extraNonce2Size,
+                          uint32_t versionMask, double difficulty) {
+#if USE_STRATUM_CAPTURE
+    uint8_t mode = s_mode;
+    if (mode != s_want || (mode != MODE_SD && mode != MODE_SERIAL)) return;
+
+    uint32_t now = millis();
+    if (extraNonce2Size != s_en2Size || strcmp(extraNonce1, s_en1) != 0) {
+        strncpy(s_en1, extraNonce1, sizeof(s_en1) - 1);
+        s_en1[sizeof(s_en1) - 1] = '\0';
+        s_en2Size = extraNonce2Size;
+        int len = snprintf(s_rec + CAPTURE_HEAD, sizeof(s_rec) - CAPTURE_HEAD, "#session %s %d %08lx %.10g",
+                           extraNonce1[0] ? extraNonce1 : "-", extraNonce2Size, versionMask, difficulty);
+        sendRecord(now, len);
+    }
+
+    size_t len = strlen(line);
+    if (len > CAPTURE_LINE_MAX) {
+        __atomic_fetch_add(&s_stats.dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    memcpy(s_rec + CAPTURE_HEAD, line, len);
+    sendRecord(now, len);
+#endif
+}
+
+bool stratum_replay_begin() {
+#if !CAPTURE_HAS_SD
+    return false;
+#else
+    if (!s_msg) return false;
+    s_want = MODE_REPLAY;
+    return true;
+#endif
+}
+
+stratum_capture_kind_t stratum_replay_next(uint32_t *ms, const char **line,
+                                           stratum_capture_session_t *session) {
+#if CAPTURE_HAS_SD
+    while (s_mode == MODE_REPLAY) {
+        size_t n = xMessageBufferReceive(s_msg, s_rec, sizeof(s_rec) - 1, 0);
+        if (n < CAPTURE_HEAD) return CAPTURE_NONE;
+        memcpy(ms, s_rec, CAPTURE_HEAD);
+        if (n == CAPTURE_HEAD) return CAPTURE_END;
+
+        s_rec[n] = '\0';
+        const char *text = s_rec + CAPTURE_HEAD;
+        if (strncmp(text, "#session ", 9) == 0) {
+            if (parseSession(text + 9, session)) return CAPTURE_SESSION;
+            continue;
+        }
+        if (text[0] == '#') continue;   // Comment
+        *line = text;
+        return CAPTURE_LINE;
+    }
+#endif
+    return CAPTURE_NONE;
+}
+
+void stratum_replay_end() {
+#if USE_STRATUM_CAPTURE
+    if (s_want == MODE_REPLAY) s_want = MODE_OFF;
+#endif
+}
+
+void stratum_capture_get_stats(stratum_capture_stats_t *out) {
+    if (out) *out = s_stats;
+}
@@ -0,0 +1,115 @@
+/*
+ * SparkMiner - Stratum Capture and Replay
+ * Records the active pool session's raw inbound lines with their arrival
+ * time, and plays a recording back through the stratum task's own message
+ * handling, so job switching can be benchmarked and regression-tested on
+ * the bench without a pool or a network.
+ *
+ * Capture: the stratum task copies each line into a message buffer and
+ * moves on (a full buffer drops the line, counted); a low-priority Core 0
+ * task prints it over serial or appends it to CAPTURE_PATH on the SD card
+ * in CAPTURE_BLOCK pieces. One record per line:
+ *   <ms>\t<line>
+ * preceded by a session record whenever the extranonce changes:
+ *   <ms>\t#session <extranonce1> <extranonce2 size> <version mask> <difficulty>
+ * Serial captures carry a "[CAPTURE] " prefix; copied onto the card as
+ * CAPTURE_PATH they replay like SD captures.
+ *
+ * Replay (stratum_replay() in stratum.h): the capture task reads the file
+ * ahead into the same message buffer and the stratum task feeds each record
+ * to the miner at its recorded time, or faster.
+ *
+ * Built in with USE_STRATUM_CAPTURE=1; replay needs an SD slot.
+ */
+
+#ifndef STRATUM_CAPTURE_H
+#define STRATUM_CAPTURE_H
+
+#include <Arduino.h>
+#include <board_config.h>
+
+/**
+ * Capture counters since boot
+ */
+typedef struct {
+    bool active;                // Capturing now
+    bool serial;                // To serial rather than the card
+    bool replaying;             // Feeding a replay
+    uint32_t records;           // Lines and session records captured
+    uint32_t dropped;           // Lost to a full buffer or a failed card write
+    uint64_t bytes;             // Written to the card or serial
+    uint32_t errors;            // Failed opens or short writes
+    uint32_t replayed;          // Records read back for replay
+} stratum_capture_stats_t;
+
+/**
+ * Session record: what the lines that follow were decoded against
+ */
+typedef struct {
+    char extraNonce1[32];
+    int extraNonce2Size;
+    uint32_t versionMask;
+    double difficulty;          // 0 = none yet (a set_difficulty line follows)
+} stratum_capture_session_t;
+
+/**
+ * What stratum_replay_next() returned
+ */
+typedef enum {
+    CAPTURE_NONE = 0,           // Nothing read ahead yet
+    CAPTURE_LINE,               // A pool line
+    CAPTURE_SESSION,            // A session record
+    CAPTURE_END                 // End of the recording (or no recording)
+} stratum_capture_kind_t;
+
+/**
+ * Create the capture task (call once from setup)
+ * @return false if the build has no capture support
+ */
+bool stratum_capture_init();
+
+/**
+ * Start a new capture (any task); an SD capture replaces the previous file
+ * @return false if not built in, replaying, or toSerial is false on a board
+ *         without an SD slot
+ */
+bool stratum_capture_start(bool toSerial);
+
+/**
+ * Stop capturing; what is buffered is still written out
+ */
+void stratum_capture_stop();
+
+/**
+ * Record one line of the active session (stratum task only, never blocks)
+ * A session record goes first whenever extraNonce1 or its size changed.
+ */
+void stratum_capture_line(const char *line, const char *extraNonce1, int extraNonce2Size,
+                          uint32_t versionMask, double difficulty);
+
+/**
+ * Stop any capture and start reading CAPTURE_PATH ahead (stratum task)
+ * @return false if not built in or the board has no SD slot
+ */
+bool stratum_replay_begin();
+
+/**
+ * Next record of the replay (stratum task, never blocks)
+ * @param ms      Capture time of the record
+ * @param line    Set for CAPTURE_LINE; valid until the next call
+ * @param session Filled for CAPTURE_SESSION
+ */
+stratum_capture_kind_t stratum_replay_next(uint32_t *ms, const char **line,
+                                           stratum_capture_session_t *session);
+
+/**
+ * Stop reading the recording (stratum task)
+ */
+void stratum_replay_end();
+
+/**
+ * Copy the capture counters
+ */
+void stratum_capture_get_stats(stratum_capture_stats_t *out);
+
+#endif // STRATUM_CAPTURE_H
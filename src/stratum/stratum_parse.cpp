@@ -0,0 +1,430 @@
+/*
+ * SparkMiner - Stratum Line Parser
+ * Single-pass tokenizer for the hot stratum messages
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "stratum_parse.h"
+#include "../mining/miner_work.h"  // swapBytesInWords
+
+// ============================================================
+// Tokens
+// ============================================================
+
+static const char *skipWs(const char *p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+static int hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// String at p (on the opening quote): raw contents in [*start, *start + *len).
+// Returns past the closing quote, or NULL if p is not a terminated string.
+static const char *scanString(const char *p, const char **start, size_t *len, bool *escaped) {
+    if (*p != '"') return NULL;
+    const char *s = ++p;
+    *escaped = false;
+    while (*p != '"') {
+        if (*p == '\0') return NULL;
+        if (*p == '\\') {
+            *escaped = true;
+            if (*++p == '\0') return NULL;
+        }
+        p++;
+    }
+    *start = s;
+    *len = p - s;
+    return p + 1;
+}
+
+// Any value at p; returns past its end, or NULL if it is cut short
+static const char *skipValue(const char *p) {
+    const char *s;
+    size_t len;
+    bool escaped;
+
+    if (*p == '"') return scanString(p, &s, &len, &escaped);
+
+    if (*p == '[' || *p == '{') {
+        int depth = 0;
+        while (*p) {
+            if (*p == '"') {
+                p = scanString(p, &s, &len, &escaped);
+                if (!p) return NULL;
+                continue;
+            }
+            if (*p == '[' || *p == '{') {
+                depth++;
+            } else if (*p == ']' || *p == '}') {
+                if (--depth == 0) return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+
+    // Number or literal
+    s = p;
+    while (*p && *p != ',' && *p != ']' && *p != '}' && *p != ' ') p++;
+    return p > s ? p : NULL;
+}
+
+// After a value: past a ',' (more = true) or past the closing bracket
+static const char *nextElement(const char *p, char close, bool *more) {
+    p = skipWs(p);
+    if (*p == ',') {
+        *more = true;
+        return skipWs(p + 1);
+    }
+    if (*p == close) {
+        *more = false;
+        return p + 1;
+    }
+    return NULL;
+}
+
+// Next array element, which must exist
+static const char *requireElement(const char *p) {
+    bool more;
+    p = nextElement(p, ']', &more);
+    return (p && more) ? p : NULL;
+}
+
+// Hex string at p decoded into out; fails on odd length, bad digits or
+// more than maxBytes
+static const char *scanHex(const char *p, uint8_t *out, size_t maxBytes, size_t *outLen) {
+    if (*p++ != '"') return NULL;
+    size_t n = 0;
+    while (*p != '"') {
+        int hi = hexNibble(p[0]);
+        if (hi < 0) return NULL;
+        int lo = hexNibble(p[1]);       // Closing quote here = odd length
+        if (lo < 0 || n >= maxBytes) return NULL;
+        out[n++] = (hi << 4) | lo;
+        p += 2;
+    }
+    *outLen = n;
+    return p + 1;
+}
+
+// Hex string at p holding one 32-bit word (version, nbits, ntime)
+static const char *scanHex32(const char *p, uint32_t *out) {
+    if (*p++ != '"') return NULL;
+    uint32_t value = 0;
+    int digits = 0;
+    while (*p != '"') {
+        int d = hexNibble(*p++);
+        if (d < 0 || ++digits > 8) return NULL;
+        value = (value << 4) | d;
+    }
+    if (digits == 0) return NULL;
+    *out = value;
+    return p + 1;
+}
+
+static bool matchToken(const char *s, size_t len, const char *token) {
+    return len == strlen(token) && memcmp(s, token, len) == 0;
+}
+
+// ============================================================
+// Message Bodies
+// ============================================================
+
+// params of mining.notify:
+// [jobId, prevHash, coinb1, coinb2, [branches], version, nbits, ntime, clean]
+static const char *parseNotifyParams(const char *p, mining_job_bin_t *job,
+                                     const char *extraNonce1, int extraNonce2Size) {
+    const char *s;
+    size_t len;
+    bool escaped, more;
+
+    if (*p != '[') return NULL;
+    p = skipWs(p + 1);
+    memset(job, 0, sizeof(*job));
+
+    p = scanString(p, &s, &len, &escaped);
+    if (!p || escaped) return NULL;
+    if (len >= STRATUM_JOB_ID_LEN) len = STRATUM_JOB_ID_LEN - 1;
+    memcpy(job->jobId, s, len);
+
+    if (!(p = requireElement(p))) return NULL;
+    p = scanHex(p, job->prevHash, sizeof(job->prevHash), &len);
+    if (!p || len != sizeof(job->prevHash)) return NULL;
+    swapBytesInWords(job->prevHash, 32); // Header order, as decodeJobPrevHash()
+
+    // coinb1 | extranonce1 | zeroed extranonce2 | coinb2
+    if (!(p = requireElement(p))) return NULL;
+    p = scanHex(p, job->coinbase, sizeof(job->coinbase), &len);
+    if (!p) return NULL;
+    size_t cbLen = len;
+
+    size_t en1Len = strlen(extraNonce1);
+    if ((en1Len & 1) || cbLen + en1Len / 2 > sizeof(job->coinbase)) return NULL;
+    for (size_t i = 0; i < en1Len; i += 2) {
+        int hi = hexNibble(extraNonce1[i]);
+        int lo = hexNibble(extraNonce1[i + 1]);
+        if (hi < 0 || lo < 0) return NULL;
+        job->coinbase[cbLen++] = (hi << 4) | lo;
+    }
+
+    if (extraNonce2Size < 0 || extraNonce2Size > 8 ||
+        cbLen + extraNonce2Size > sizeof(job->coinbase)) return NULL;
+    job->extraNonce2Offset = cbLen;
+    job->extraNonce2Size = extraNonce2Size;
+    cbLen += extraNonce2Size;
+
+    if (!(p = requireElement(p))) return NULL;
+    p = scanHex(p, job->coinbase + cbLen, sizeof(job->coinbase) - cbLen, &len);
+    if (!p) return NULL;
+    job->coinbaseLen = cbLen + len;
+
+    if (!(p = requireElement(p)) || *p != '[') return NULL;
+    p = skipWs(p + 1);
+    if (*p == ']') {
+        p++;
+    } else {
+        do {
+            if (job->merkleBranchCount >= STRATUM_MAX_MERKLE) return NULL;
+            p = scanHex(p, job->merkleBranches[job->merkleBranchCount++], 32, &len);
+            if (!p || len != 32) return NULL;
+            if (!(p = nextElement(p, ']', &more))) return NULL;
+        } while (more);
+    }
+
+    if (!(p = requireElement(p)) || !(p = scanHex32(p, &job->version))) return NULL;
+    if (!(p = requireElement(p)) || !(p = scanHex32(p, &job->nbits))) return NULL;
+    if (!(p = requireElement(p)) || !(p = scanHex32(p, &job->ntime))) return NULL;
+
+    // clean_jobs is optional; anything after it is ignored
+    if (!(p = nextElement(p, ']', &more))) return NULL;
+    bool first = true;
+    while (more) {
+        if (first) job->cleanJobs = strncmp(p, "true", 4) == 0;
+        first = false;
+        if (!(p = skipValue(p)) || !(p = nextElement(p, ']', &more))) return NULL;
+    }
+    return p;
+}
+
+// params of mining.set_difficulty: [difficulty]
+static const char *parseDifficultyParams(const char *p, double *difficulty) {
+    if (*p != '[') return NULL;
+    p = skipWs(p + 1);
+    char *end;
+    *difficulty = strtod(p, &end);
+    if (end == p) return NULL;
+    p = skipWs(end);
+    bool more = true;
+    while (more) {
+        if (!(p = nextElement(p, ']', &more))) return NULL;
+        if (more && !(p = skipValue(p))) return NULL;
+    }
+    return p;
+}
+
+// error of a response: null or [code, "message", traceback]
+static const char *parseError(const char *p, stratum_line_t *msg) {
+    const char *end = skipValue(p);
+    if (!end || *p != '[') return end;
+
+    const char *s;
+    size_t len;
+    bool escaped;
+    p = skipWs(p + 1);
+    if (!(p = skipValue(p)) || !(p = requireElement(p))) return end;
+    if (!scanString(p, &s, &len, &escaped)) return end;
+
+    if (len >= sizeof(msg->reason)) len = sizeof(msg->reason) - 1;
+    memcpy(msg->reason, s, len);
+    msg->reason[len] = '\0';
+    return end;
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+typedef enum { METHOD_NONE = 0, METHOD_NOTIFY, METHOD_DIFFICULTY, METHOD_OTHER } line_method_t;
+
+static stratum_line_kind_t parseParams(line_method_t method, const char **pp, stratum_line_t *msg,
+                                       mining_job_bin_t *job, const char *extraNonce1, int extraNonce2Size) {
+    if (method == METHOD_DIFFICULTY) {
+        *pp = parseDifficultyParams(*pp, &msg->difficulty);
+        return *pp ? STRATUM_LINE_DIFFICULTY : STRATUM_LINE_OTHER;
+    }
+    *pp = job ? parseNotifyParams(*pp, job, extraNonce1, extraNonce2Size) : skipValue(*pp);
+    return *pp ? STRATUM_LINE_NOTIFY : STRATUM_LINE_BAD_NOTIFY;
+}
+
+stratum_line_kind_t stratum_parse_line(const char *line, stratum_line_t *msg, mining_job_bin_t *job,
+                                       const char *extraNonce1, int extraNonce2Size) {
+    memset(msg, 0, sizeof(*msg));
+
+    line_method_t method = METHOD_NONE;
+    const char *params = NULL;
+    stratum_line_kind_t kind = STRATUM_LINE_OTHER;
+    bool hasId = false, hasResult = false, parsed = false;
+
+    const char *p = skipWs(line);
+    if (*p != '{') return STRATUM_LINE_OTHER;
+    p = skipWs(p + 1);
+
+    bool more = (*p != '}');
+    while (more) {
+        const char *key;
+        size_t keyLen;
+        bool escaped;
+
+        p = scanString(p, &key, &keyLen, &escaped);
+        if (!p) return STRATUM_LINE_OTHER;
+        p = skipWs(p);
+        if (*p != ':') return STRATUM_LINE_OTHER;
+        p = skipWs(p + 1);
+
+        if (matchToken(key, keyLen, "id")) {
+            if (*p >= '0' && *p <= '9') {
+                char *end;
+                msg->id = strtoul(p, &end, 10);
+                p = end;
+                hasId = true;
+            } else {
+                p = skipValue(p);   // null, or an id we never send
+            }
+        } else if (matchToken(key, keyLen, "method")) {
+            const char *s;
+            size_t len;
+            p = scanString(p, &s, &len, &escaped);
+            if (!p) return STRATUM_LINE_OTHER;
+            if (matchToken(s, len, "mining.notify")) method = METHOD_NOTIFY;
+            else if (matchToken(s, len, "mining.set_difficulty")) method = METHOD_DIFFICULTY;
+            else return STRATUM_LINE_OTHER;
+        } else if (matchToken(key, keyLen, "params")) {
+            if (method == METHOD_NONE) {
+                // Method comes later; come back once it is known
+                params = p;
+                p = skipValue(p);
+            } else {
+                kind = parseParams(method, &p, msg, job, extraNonce1, extraNonce2Size);
+                if (!p) return kind;
+                parsed = true;
+            }
+        } else if (matchToken(key, keyLen, "result")) {
+            if (strncmp(p, "true", 4) == 0) {
+                msg->result = true;
+                p += 4;
+            } else if (strncmp(p, "false", 5) == 0) {
+                p += 5;
+            } else if (strncmp(p, "null", 4) == 0) {
+                p += 4;
+            } else {
+                return STRATUM_LINE_OTHER;  // Handshake results (arrays, objects)
+            }
+            hasResult = true;
+        } else if (matchToken(key, keyLen, "error")) {
+            p = parseError(p, msg);
+        } else {
+            p = skipValue(p);
+        }
+
+        if (!p || !(p = nextElement(p, '}', &more))) return STRATUM_LINE_OTHER;
+    }
+
+    if (method == METHOD_NONE) {
+        return (hasId && hasResult) ? STRATUM_LINE_RESULT : STRATUM_LINE_OTHER;
+    }
+    if (parsed) return kind;
+    if (!params) return method == METHOD_NOTIFY ? STRATUM_LINE_BAD_NOTIFY : STRATUM_LINE_OTHER;
+    return parseParams(method, &params, msg, job, extraNonce1, extraNonce2Size);
+}
+
+// ============================================================
+// Line Formatting
+// ============================================================
+
+// Appends into a fixed buffer; ok turns false on the first overflow
+typedef struct {
+    char *out;
+    size_t room;
+    size_t len;
+    bool ok;
+} line_writer_t;
+
+static void putText(line_writer_t *w, const char *text) {
+    size_t n = strlen(text);
+    if (!w->ok || w->len + n >= w->room) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->out + w->len, text, n + 1);
+    w->len += n;
+}
+
+static void putHexString(line_writer_t *w, const uint8_t *bytes, size_t n) {
+    static const char *tbl = "0123456789abcdef";
+    if (!w->ok || w->len + n * 2 + 2 >= w->room) {
+        w->ok = false;
+        return;
+    }
+    char *p = w->out + w->len;
+    *p++ = '"';
+    for (size_t i = 0; i < n; i++) {
+        *p++ = tbl[bytes[i] >> 4];
+        *p++ = tbl[bytes[i] & 0x0f];
+    }
+    *p++ = '"';
+    *p = '\0';
+    w->len = p - w->out;
+}
+
+static void putHex32(line_writer_t *w, uint32_t value) {
+    char text[12];
+    snprintf(text, sizeof(text), "\"%08lx\"", (unsigned long)value);
+    putText(w, text);
+}
+
+size_t stratum_format_notify(char *out, size_t outLen, const mining_job_bin_t *job,
+                             size_t coinb1Len, bool clean) {
+    size_t coinb2Start = job->extraNonce2Offset + job->extraNonce2Size;
+    if (job->headerOnly || coinb1Len > job->extraNonce2Offset || coinb2Start > job->coinbaseLen) return 0;
+
+    line_writer_t w = { out, outLen, 0, outLen > 0 };
+    if (w.ok) out[0] = '\0';
+
+    putText(&w, "{\"id\":null,\"method\":\"mining.notify\",\"params\":[\"");
+    putText(&w, job->jobId);    // Job ids are taken as sent, and never hold quotes
+    putText(&w, "\",");
+
+    uint8_t prevHash[32];
+    memcpy(prevHash, job->prevHash, sizeof(prevHash));
+    swapBytesInWords(prevHash, sizeof(prevHash));   // Back to stratum word order
+    putHexString(&w, prevHash, sizeof(prevHash));
+    putText(&w, ",");
+    putHexString(&w, job->coinbase, coinb1Len);
+    putText(&w, ",");
+    putHexString(&w, job->coinbase + coinb2Start, job->coinbaseLen - coinb2Start);
+
+    putText(&w, ",[");
+    for (uint8_t i = 0; i < job->merkleBranchCount; i++) {
+        if (i) putText(&w, ",");
+        putHexString(&w, job->merkleBranches[i], 32);
+    }
+    putText(&w, "],");
+
+    putHex32(&w, job->version);
+    putText(&w, ",");
+    putHex32(&w, job->nbits);
+    putText(&w, ",");
+    putHex32(&w, job->ntime);
+    putText(&w, clean ? ",true]}\n" : ",false]}\n");
+
+    return w.ok ? w.len : 0;
+}
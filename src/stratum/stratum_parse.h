@@ -0,0 +1,60 @@
+/*
+ * SparkMiner - Stratum Line Parser
+ * Allocation-free fast path for the messages that arrive while mining:
+ * mining.notify, mining.set_difficulty and share responses. Everything
+ * else is left to ArduinoJson in stratum.cpp.
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ */
+
+#ifndef STRATUM_PARSE_H
+#define STRATUM_PARSE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "stratum_types.h"
+
+#define STRATUM_REASON_LEN      64      // Reject reason kept from a response
+
+/**
+ * What stratum_parse_line() made of a line
+ */
+typedef enum {
+    STRATUM_LINE_OTHER = 0,     // Not a shape the fast path handles; use ArduinoJson
+    STRATUM_LINE_NOTIFY,        // mining.notify, decoded into the job slot
+    STRATUM_LINE_BAD_NOTIFY,    // mining.notify that does not decode (job slot clobbered)
+    STRATUM_LINE_DIFFICULTY,    // mining.set_difficulty, value in difficulty
+    STRATUM_LINE_RESULT         // Response with a true/false/null result
+} stratum_line_kind_t;
+
+/**
+ * Scalar fields picked out of a line
+ */
+typedef struct {
+    uint32_t id;                        // Response id (0 if null or absent)
+    bool result;                        // Response result (null reads as false)
+    double difficulty;                  // set_difficulty value
+    char reason[STRATUM_REASON_LEN];    // error[1] of a response, "" if none
+} stratum_line_t;
+
+/**
+ * Parse one stratum line in a single pass
+ * Notify fields are hex-decoded straight into job while scanning, laid out
+ * as decodeJobCoinbase() does; version, nbits and ntime are filled too.
+ * @param job             Slot to decode a notify into; NULL classifies only
+ * @param extraNonce1     Hex extranonce1 from the subscription
+ * @param extraNonce2Size Extranonce2 length in bytes (at most 8)
+ */
+stratum_line_kind_t stratum_parse_line(const char *line, stratum_line_t *msg, mining_job_bin_t *job,
+                                       const char *extraNonce1, int extraNonce2Size);
+
+/**
+ * Format a decoded job back into a mining.notify line (newline included)
+ * for a downstream miner: coinb1 is the first coinb1Len coinbase bytes, the
+ * downstream extranonce1 stands in for the rest up to extraNonce2Offset.
+ * @return Line length, or 0 if it does not fit (or the job is header-only)
+ */
+size_t stratum_format_notify(char *out, size_t outLen, const mining_job_bin_t *job,
+                             size_t coinb1Len, bool clean);
+
+#endif // STRATUM_PARSE_H
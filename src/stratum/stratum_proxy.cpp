@@ -0,0 +1,652 @@
+/*
+ * SparkMiner - LAN Stratum Proxy Implementation
+ * See stratum_proxy.h.
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <WiFi.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <ctype.h>
+#include <lwip/sockets.h>
+#include <esp_vfs_eventfd.h>  // Wakeup fd: new work or share results
+#include <board_config.h>
+#include "stratum_proxy.h"
+#include "stratum.h"
+#include "stratum_parse.h"
+#include "../mining/miner_work.h"
+#include "../mining/miner_sha256.h"
+#include "../stats/mem_budget.h"
+
+#if USE_STRATUM_PROXY
+
+#if STRATUM_PROXY_CLIENTS < 1 || STRATUM_PROXY_CLIENTS > 255
+    #error "STRATUM_PROXY_CLIENTS must be 1-255 (one extranonce byte each)"
+#endif
+
+#define PROXY_RETRY_MS      5000    // Listen socket setup retry
+#define PROXY_RESULT_QUEUE  16
+
+// One downstream miner. Its slot number + 1 is its extranonce1 byte.
+typedef struct {
+    int fd;                         // -1 = free
+    uint32_t gen;                   // Bumped per connection, so late results find no one
+    bool subscribed;
+    bool authorized;
+    bool versionRolling;            // Asked for it in mining.configure
+    uint8_t extraNonce2Size;        // Given at subscribe
+    uint32_t jobSeq;                // Newest job sent
+    double difficulty;              // Last difficulty sent
+    uint16_t windowShares;          // Shares in the current reject-rate window
+    uint16_t windowRejects;         // Of those, malformed, low or rejected by the pool
+    uint32_t versionMask;           // Last mask sent
+    char rx[PROXY_LINE_MAX];
+    size_t rxLen;
+} proxy_client_t;
+
+// A share on its way to the pool; submit_entry_t.sessionId holds seq
+typedef struct {
+    uint32_t seq;
+    uint8_t client;
+    uint32_t gen;
+    uint32_t requestId;
+} proxy_ticket_t;
+
+typedef struct {
+    uint32_t seq;
+    bool accepted;
+    char reason[32];
+} proxy_result_t;
+
+static proxy_client_t s_clients[STRATUM_PROXY_CLIENTS];
+static proxy_ticket_t s_tickets[PROXY_TICKETS];
+static uint32_t s_ticketSeq = 0;
+static QueueHandle_t s_resultQueue = NULL;
+static int s_wakeFd = -1;
+static stratum_proxy_stats_t s_stats = {0};
+
+// Newest upstream work, written by the stratum task's hook
+static SemaphoreHandle_t s_workMutex = NULL;
+static mining_job_bin_t s_job;
+static bool s_hasJob = false;
+static uint32_t s_jobSeq = 0;       // Bumped per job
+static uint32_t s_cleanSeq = 0;     // s_jobSeq of the newest clean job or session switch
+static double s_difficulty = 0;
+static uint32_t s_versionMask = 0;
+
+// Proxy task's copies of the jobs sent, newest in s_sendJob; shares are
+// checked against them. A clean job clears the older ones.
+static mining_job_bin_t s_sentJobs[PROXY_JOB_RING];
+static mining_job_bin_t *s_sendJob = &s_sentJobs[0];
+static uint32_t s_sentCount = 0;
+static miner_coinbase_t s_checkCb;  // Share check scratch
+static uint32_t s_sendSeq = 0;
+static bool s_sendClean = false;
+static double s_sendDifficulty = 0;
+static uint32_t s_sendMask = 0;
+static bool s_sendReady = false;
+static char s_notify[PROXY_NOTIFY_MAX];
+static size_t s_notifyLen = 0;
+static char s_notifyClean[PROXY_NOTIFY_MAX];    // Same job marked clean, for newly authorized miners
+static size_t s_notifyCleanLen = 0;
+
+static StaticJsonDocument<768> s_doc;
+static char s_out[PROXY_LINE_MAX];
+
+STATIC_TASK(s_proxyTask, PROXY_STACK);
+
+// ============================================================
+// Wakeup
+// ============================================================
+
+static void wakeInit() {
+    esp_vfs_eventfd_config_t config = ESP_VFS_EVENTD_CONFIG_DEFAULT();
+    esp_err_t err = esp_vfs_eventfd_register(&config);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {  // INVALID_STATE: stratum registered it
+        Serial.printf("[PROXY] eventfd unavailable (%d), polling\n", err);
+        return;
+    }
+    s_wakeFd = eventfd(0, 0);
+}
+
+static void wakeTask() {
+    if (s_wakeFd < 0) return;
+    uint64_t one = 1;
+    write(s_wakeFd, &one, sizeof(one));
+}
+
+// ============================================================
+// Upstream Hooks (stratum task)
+// ============================================================
+
+static void onWork(const stratum_work_t *work) {
+    xSemaphoreTake(s_workMutex, portMAX_DELAY);
+    s_difficulty = work->difficulty;
+    s_versionMask = work->versionMask;
+    if (!work->carved) {
+        s_hasJob = false;           // Pool can't be split; refuse miners until it changes
+    } else if (work->job) {
+        memcpy(&s_job, work->job, sizeof(s_job));
+        s_hasJob = true;
+        s_jobSeq++;
+        if (work->job->cleanJobs || work->restart) s_cleanSeq = s_jobSeq;
+    } else if (work->restart) {
+        s_hasJob = false;           // New session, first job still to come
+    }
+    xSemaphoreGive(s_workMutex);
+    wakeTask();
+}
+
+static void onShareResult(uint32_t sessionId, uint32_t msgId, bool accepted, const char *reason) {
+    proxy_result_t result;
+    result.seq = sessionId;
+    result.accepted = accepted;
+    strncpy(result.reason, reason ? reason : "rejected", sizeof(result.reason) - 1);
+    result.reason[sizeof(result.reason) - 1] = '\0';
+    if (xQueueSend(s_resultQueue, &result, 0) == pdTRUE) wakeTask();
+}
+
+// ============================================================
+// Sending
+// ============================================================
+
+static void dropClient(proxy_client_t *c, const char *why) {
+    if (c->fd < 0) return;
+    close(c->fd);
+    c->fd = -1;
+    s_stats.clients--;
+    Serial.printf("[PROXY] Miner %d dropped (%s)\n", (int)(c - s_clients), why);
+}
+
+static bool sendRaw(proxy_client_t *c, const char *data, size_t len) {
+    size_t sent = 0;
+    while (c->fd >= 0 && sent < len) {
+        int n = send(c->fd, data + sent, len - sent, 0);
+        if (n <= 0) {
+            dropClient(c, "send stalled");
+            return false;
+        }
+        sent += n;
+    }
+    return c->fd >= 0;
+}
+
+static bool sendf(proxy_client_t *c, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(s_out, sizeof(s_out), fmt, args);
+    va_end(args);
+    if (len <= 0 || len >= (int)sizeof(s_out)) return false;
+    return sendRaw(c, s_out, len);
+}
+
+static void replyResult(proxy_client_t *c, uint32_t id, bool result) {
+    sendf(c, "{\"id\":%lu,\"result\":%s,\"error\":null}\n", id, result ? "true" : "false");
+}
+
+static void replyError(proxy_client_t *c, uint32_t id, int code, const char *message) {
+    sendf(c, "{\"id\":%lu,\"result\":null,\"error\":[%d,\"%s\",null]}\n", id, code, message);
+}
+
+// Difficulty and mask changes, then the newest job if this miner lacks it
+static void sendWork(proxy_client_t *c, bool forceClean) {
+    if (!c->authorized || !s_sendReady) return;
+
+    if (s_sendJob->extraNonce2Size != c->extraNonce2Size) {
+        dropClient(c, "pool extranonce changed");   // Reconnects and subscribes afresh
+        return;
+    }
+    if (s_sendDifficulty > 0 && s_sendDifficulty != c->difficulty) {
+        if (!sendf(c, "{\"id\":null,\"method\":\"mining.set_difficulty\",\"params\":[%.8g]}\n", s_sendDifficulty)) return;
+        c->difficulty = s_sendDifficulty;
+    }
+    if (c->versionRolling && s_sendMask != c->versionMask) {
+        if (!sendf(c, "{\"id\":null,\"method\":\"mining.set_version_mask\",\"params\":[\"%08lx\"]}\n", s_sendMask)) return;
+        c->versionMask = s_sendMask;
+    }
+    if (c->jobSeq == s_sendSeq) return;
+
+    // A miner that just authorized has nothing to keep mining on
+    bool sent = (forceClean && !s_sendClean) ? sendRaw(c, s_notifyClean, s_notifyCleanLen)
+                                             : sendRaw(c, s_notify, s_notifyLen);
+    if (sent) c->jobSeq = s_sendSeq;
+}
+
+// Take the newest work from the hook and pass it to every miner
+static void distributeWork() {
+    bool newJob = false;
+    xSemaphoreTake(s_workMutex, portMAX_DELAY);
+    s_sendDifficulty = s_difficulty;
+    s_sendMask = s_versionMask;
+    s_sendReady = s_hasJob;
+    if (s_hasJob && s_jobSeq != s_sendSeq) {
+        s_sendJob = &s_sentJobs[++s_sentCount % PROXY_JOB_RING];
+        memcpy(s_sendJob, &s_job, sizeof(*s_sendJob));
+        s_sendClean = (int32_t)(s_cleanSeq - s_sendSeq) > 0;  // Any clean job since the last one sent
+        s_sendSeq = s_jobSeq;
+        newJob = true;
+    }
+    xSemaphoreGive(s_workMutex);
+
+    if (newJob) {
+        // Shares for the jobs a clean one replaced are stale
+        if (s_sendClean) {
+            for (int i = 0; i < PROXY_JOB_RING; i++) {
+                if (&s_sentJobs[i] != s_sendJob) s_sentJobs[i].jobId[0] = '\0';
+            }
+        }
+
+        // coinb1 stops before the carved byte; each miner's extranonce1 fills it
+        uint16_t coinb1Len = s_sendJob->extraNonce2Offset - 1;
+        s_notifyLen = stratum_format_notify(s_notify, sizeof(s_notify), s_sendJob, coinb1Len, s_sendClean);
+        s_notifyCleanLen = stratum_format_notify(s_notifyClean, sizeof(s_notifyClean), s_sendJob, coinb1Len, true);
+        if (!s_notifyLen || !s_notifyCleanLen) {
+            Serial.println("[PROXY] Job does not fit the notify buffer, not forwarded");
+        }
+    }
+    if (!s_notifyLen || !s_notifyCleanLen) s_sendReady = false;
+
+    for (int i = 0; i < STRATUM_PROXY_CLIENTS; i++) {
+        if (s_clients[i].fd >= 0) sendWork(&s_clients[i], false);
+    }
+}
+
+// All miners submit under this board's one pool worker: a miner that keeps
+// sending bad shares is dropped before it gets the worker banned
+static void noteShare(proxy_client_t *c, bool bad) {
+    c->windowShares++;
+    if (bad) c->windowRejects++;
+    if (c->windowShares < PROXY_REJECT_WINDOW) return;
+
+    bool kick = c->windowRejects * 100 >= c->windowShares * PROXY_REJECT_PCT;
+    c->windowShares = 0;
+    c->windowRejects = 0;
+    if (kick) {
+        s_stats.kicked++;
+        dropClient(c, "too many bad shares");
+    }
+}
+
+// Relay the pool's answers to the miners that sent the shares
+static void relayResults() {
+    proxy_result_t result;
+    while (xQueueReceive(s_resultQueue, &result, 0) == pdTRUE) {
+        proxy_ticket_t *t = &s_tickets[result.seq % PROXY_TICKETS];
+        if (t->seq != result.seq) continue;     // Overwritten by newer shares
+        t->seq = 0;
+
+        if (result.accepted) {
+            s_stats.accepted++;
+        } else {
+            s_stats.rejected++;
+        }
+        proxy_client_t *c = &s_clients[t->client];
+        if (c->fd < 0 || c->gen != t->gen) continue;
+        if (result.accepted) {
+            replyResult(c, t->requestId, true);
+        } else {
+            replyError(c, t->requestId, 23, result.reason);
+        }
+        // A share that went stale on the way is not the miner's fault
+        noteShare(c, !result.accepted && strcmp(result.reason, "stale") != 0 &&
+                     strcmp(result.reason, "pool changed") != 0);
+    }
+}
+
+// ============================================================
+// Requests
+// ============================================================
+
+static bool isHex(const char *s, size_t len) {
+    if (!s || strlen(s) != len) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (!isxdigit((unsigned char)s[i])) return false;
+    }
+    return true;
+}
+
+// Newest first, in case a pool reuses a job ID
+static const mining_job_bin_t *findJob(const char *jobId) {
+    for (int i = 0; i < PROXY_JOB_RING; i++) {
+        const mining_job_bin_t *job = &s_sentJobs[(s_sentCount - i) % PROXY_JOB_RING];
+        if (job->jobId[0] && strcmp(job->jobId, jobId) == 0) return job;
+    }
+    return NULL;
+}
+
+// Rebuild the miner's header - its slot byte and extranonce2 in the job's
+// coinbase, then the merkle root - and hash it against its difficulty
+static bool shareMeetsTarget(const proxy_client_t *c, const mining_job_bin_t *job, const char *extraNonce2,
+                             uint32_t ntime, uint32_t nonce, uint32_t versionBits) {
+    buildCoinbase(&s_checkCb, job, 0);
+    s_checkCb.coinbase[job->extraNonce2Offset - 1] = (c - s_clients) + 1;
+    hexToBytes(&s_checkCb.coinbase[job->extraNonce2Offset], extraNonce2, job->extraNonce2Size * 2);
+
+    sha256_hash_t ctx, ctx1;
+    miner_sha256(&ctx, s_checkCb.coinbase, s_checkCb.coinbaseLen);
+    miner_sha256(&ctx1, ctx.bytes, 32);
+
+    block_header_t hb;
+    hb.version = (job->version & ~s_sendMask) | versionBits;
+    memcpy(hb.prev_hash, job->prevHash, 32);
+    calculateMerkleRoot(hb.merkle_root, ctx1.bytes, &s_checkCb);
+    hb.timestamp = ntime;
+    hb.difficulty = job->nbits;
+    hb.nonce = nonce;
+
+    sha256_hash_t midstate;
+    miner_sha256_midstate(&midstate, &hb);
+    if (!miner_sha256_header(&midstate, &ctx, &hb)) return false;  // Not even 16 zero bits
+    return getDifficulty(&ctx) >= (c->difficulty > 0 ? c->difficulty : 1.0);
+}
+
+static void handleConfigure(proxy_client_t *c, uint32_t id) {
+    uint32_t asked = strtoul(s_doc["params"][1]["version-rolling.mask"] | "0", NULL, 16);
+    uint32_t mask = asked & s_sendMask;
+    c->versionRolling = (mask != 0);
+    c->versionMask = mask;
+    if (mask) {
+        sendf(c, "{\"id\":%lu,\"result\":{\"version-rolling\":true,\"version-rolling.mask\":\"%08lx\"},\"error\":null}\n",
+              id, mask);
+    } else {
+        sendf(c, "{\"id\":%lu,\"result\":{\"version-rolling\":false},\"error\":null}\n", id);
+    }
+}
+
+static void handleSubscribe(proxy_client_t *c, uint32_t id) {
+    if (!s_sendReady) {
+        replyError(c, id, 20, "No work from the pool yet");
+        return;
+    }
+    int slot = c - s_clients;
+    c->subscribed = true;
+    c->extraNonce2Size = s_sendJob->extraNonce2Size;
+    sendf(c, "{\"id\":%lu,\"result\":[[[\"mining.set_difficulty\",\"%d\"],[\"mining.notify\",\"%d\"]],\"%02x\",%d],\"error\":null}\n",
+          id, slot, slot, slot + 1, c->extraNonce2Size);
+}
+
+// [worker, jobId, extranonce2, ntime, nonce, (version bits)]
+static void handleSubmit(proxy_client_t *c, uint32_t id) {
+    if (!c->authorized) {
+        replyError(c, id, 24, "Unauthorized worker");
+        return;
+    }
+
+    JsonArray params = s_doc["params"];
+    const char *jobId = params[1];
+    const char *extraNonce2 = params[2];
+    const char *ntime = params[3];
+    const char *nonce = params[4];
+    const char *versionBits = params[5];
+
+    if (!jobId || strlen(jobId) >= MAX_JOB_ID_LEN || !isHex(extraNonce2, c->extraNonce2Size * 2) ||
+        !isHex(ntime, 8) || !isHex(nonce, 8) || (versionBits && !isHex(versionBits, 8))) {
+        s_stats.malformed++;
+        replyError(c, id, 20, "Malformed submit");
+        noteShare(c, true);
+        return;
+    }
+
+    // Checked here: what the pool rejects counts against everyone's worker
+    const mining_job_bin_t *job = findJob(jobId);
+    if (!job || job->headerOnly) {
+        s_stats.stale++;
+        replyError(c, id, 21, "Job not found");
+        return;
+    }
+    uint32_t bits = (versionBits && s_sendMask) ? strtoul(versionBits, NULL, 16) & s_sendMask : 0;
+    if (!shareMeetsTarget(c, job, extraNonce2, strtoul(ntime, NULL, 16), strtoul(nonce, NULL, 16), bits)) {
+        s_stats.lowDifficulty++;
+        replyError(c, id, 23, "Low difficulty share");
+        noteShare(c, true);
+        return;
+    }
+
+    submit_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    strncpy(entry.jobId, jobId, sizeof(entry.jobId) - 1);
+    snprintf(entry.extraNonce2, sizeof(entry.extraNonce2), "%02x%s", (int)(c - s_clients) + 1, extraNonce2);
+    entry.timestamp = strtoul(ntime, NULL, 16);
+    entry.nonce = strtoul(nonce, NULL, 16);
+    entry.flags = SUBMIT_FLAG_PROXY;
+    if (versionBits && s_sendMask) {
+        entry.versionBits = bits;
+        entry.flags |= SUBMIT_FLAG_VERSION;
+    }
+    entry.callback = onShareResult;
+
+    uint32_t seq = ++s_ticketSeq;
+    if (!seq) seq = ++s_ticketSeq;      // 0 never matches a ticket
+    proxy_ticket_t *t = &s_tickets[seq % PROXY_TICKETS];
+    if (t->seq) s_stats.rejected++;     // Unanswered that long: counted as lost
+    t->seq = seq;
+    t->client = c - s_clients;
+    t->gen = c->gen;
+    t->requestId = id;
+    entry.sessionId = seq;
+
+    if (!stratum_submit_share(&entry)) {
+        t->seq = 0;
+        replyError(c, id, 20, "Submit queue full");
+        return;
+    }
+    s_stats.forwarded++;
+}
+
+static void handleLine(proxy_client_t *c, const char *line) {
+    s_doc.clear();
+    if (deserializeJson(s_doc, line)) return;
+
+    const char *method = s_doc["method"];
+    uint32_t id = s_doc["id"] | 0;
+    if (!method) return;
+
+    if (strcmp(method, "mining.submit") == 0) {
+        handleSubmit(c, id);
+    } else if (strcmp(method, "mining.subscribe") == 0) {
+        handleSubscribe(c, id);
+    } else if (strcmp(method, "mining.authorize") == 0) {
+        // All miners share this board's pool worker
+        if (!c->subscribed) {
+            replyError(c, id, 25, "Not subscribed");
+            return;
+        }
+        c->authorized = true;
+        replyResult(c, id, true);
+        sendWork(c, true);
+    } else if (strcmp(method, "mining.configure") == 0) {
+        handleConfigure(c, id);
+    } else if (strcmp(method, "mining.suggest_difficulty") == 0 ||
+               strcmp(method, "mining.extranonce.subscribe") == 0) {
+        replyResult(c, id, true);   // Pool difficulty applies to everyone
+    } else {
+        replyError(c, id, 20, "Unsupported method");
+    }
+}
+
+// Read what arrived and handle each complete line
+static void readClient(proxy_client_t *c) {
+    int n = recv(c->fd, c->rx + c->rxLen, sizeof(c->rx) - 1 - c->rxLen, MSG_DONTWAIT);
+    if (n <= 0) {
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) dropClient(c, "closed");
+        return;
+    }
+    c->rxLen += n;
+    c->rx[c->rxLen] = '\0';
+
+    char *start = c->rx;
+    char *nl;
+    while (c->fd >= 0 && (nl = strchr(start, '\n')) != NULL) {
+        *nl = '\0';
+        if (nl > start) handleLine(c, start);
+        start = nl + 1;
+    }
+    if (c->fd < 0) return;
+
+    c->rxLen = strlen(start);
+    memmove(c->rx, start, c->rxLen + 1);
+    if (c->rxLen >= sizeof(c->rx) - 1) dropClient(c, "line too long");
+}
+
+// ============================================================
+// Server
+// ============================================================
+
+static int openListener() {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
+
+    int yes = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(STRATUM_PROXY_PORT);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 4) != 0) {
+        close(fd);
+        return -1;
+    }
+    IPAddress ip = WiFi.localIP();
+    Serial.printf("[PROXY] Serving stratum+tcp://%u.%u.%u.%u:%d for up to %d miners\n",
+                  ip[0], ip[1], ip[2], ip[3], STRATUM_PROXY_PORT, STRATUM_PROXY_CLIENTS);
+    return fd;
+}
+
+static void acceptClient(int listenFd) {
+    int fd = accept(listenFd, NULL, NULL);
+    if (fd < 0) return;
+
+    proxy_client_t *c = NULL;
+    for (int i = 0; i < STRATUM_PROXY_CLIENTS && !c; i++) {
+        if (s_clients[i].fd < 0) c = &s_clients[i];
+    }
+    if (!c) {
+        close(fd);
+        Serial.println("[PROXY] Miner refused, all slots taken");
+        return;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = PROXY_IO_MS / 1000;
+    tv.tv_usec = (PROXY_IO_MS % 1000) * 1000;
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int yes = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+    uint32_t gen = c->gen + 1;
+    memset(c, 0, sizeof(*c));
+    c->fd = fd;
+    c->gen = gen;
+    s_stats.clients++;
+    s_stats.connects++;
+    Serial.printf("[PROXY] Miner %d connected\n", (int)(c - s_clients));
+}
+
+static void dropAll(const char *why) {
+    for (int i = 0; i < STRATUM_PROXY_CLIENTS; i++) {
+        dropClient(&s_clients[i], why);
+    }
+}
+
+static void proxy_task(void *param) {
+    int listenFd = -1;
+
+    while (true) {
+        if (WiFi.status() != WL_CONNECTED) {
+            if (listenFd >= 0) {
+                dropAll("WiFi lost");
+                close(listenFd);
+                listenFd = -1;
+            }
+            vTaskDelay(1000 / portTICK_PERIOD_MS);
+            continue;
+        }
+        if (listenFd < 0) {
+            listenFd = openListener();
+            if (listenFd < 0) {
+                Serial.println("[PROXY] Could not open the listen socket, retrying");
+                vTaskDelay(PROXY_RETRY_MS / portTICK_PERIOD_MS);
+                continue;
+            }
+        }
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listenFd, &readable);
+        int maxFd = listenFd;
+        if (s_wakeFd >= 0) {
+            FD_SET(s_wakeFd, &readable);
+            if (s_wakeFd > maxFd) maxFd = s_wakeFd;
+        }
+        for (int i = 0; i < STRATUM_PROXY_CLIENTS; i++) {
+            int fd = s_clients[i].fd;
+            if (fd < 0) continue;
+            FD_SET(fd, &readable);
+            if (fd > maxFd) maxFd = fd;
+        }
+
+        // Without the eventfd, poll often enough that jobs still go out promptly
+        uint32_t waitMs = s_wakeFd >= 0 ? PROXY_IDLE_MS : 20;
+        struct timeval tv = { (time_t)(waitMs / 1000), (suseconds_t)((waitMs % 1000) * 1000) };
+        int ready = select(maxFd + 1, &readable, NULL, NULL, &tv);
+
+        if (ready > 0 && s_wakeFd >= 0 && FD_ISSET(s_wakeFd, &readable)) {
+            uint64_t count;
+            read(s_wakeFd, &count, sizeof(count));
+        }
+
+        // Work first: a new job should not wait behind share traffic
+        distributeWork();
+        relayResults();
+
+        if (ready <= 0) continue;
+        for (int i = 0; i < STRATUM_PROXY_CLIENTS; i++) {
+            if (s_clients[i].fd >= 0 && FD_ISSET(s_clients[i].fd, &readable)) readClient(&s_clients[i]);
+        }
+        if (FD_ISSET(listenFd, &readable)) acceptClient(listenFd);
+    }
+}
+
+// ============================================================
+// Public API
+// ============================================================
+
+void stratum_proxy_init() {
+    for (int i = 0; i < STRATUM_PROXY_CLIENTS; i++) {
+        s_clients[i].fd = -1;
+    }
+    s_workMutex = xSemaphoreCreateMutex();
+    s_resultQueue = xQueueCreate(PROXY_RESULT_QUEUE, sizeof(proxy_result_t));
+    wakeInit();
+    stratum_set_work_hook(onWork);
+
+    mem_budget_add("proxy", "clients", sizeof(s_clients) + sizeof(s_tickets));
+    mem_budget_add("proxy", "job ring + share check", sizeof(s_sentJobs) + sizeof(s_checkCb));
+    mem_budget_add("proxy", "notify, line, JSON", sizeof(s_notify) + sizeof(s_notifyClean) + sizeof(s_out) + sizeof(s_doc));
+    mem_task_create(
+        proxy_task,
+        "Proxy",
+        NULL,
+        PROXY_PRIORITY,
+        PROXY_CORE,
+        "proxy",
+        STATIC_TASK_MEM(s_proxyTask)
+    );
+}
+
+void stratum_proxy_get_stats(stratum_proxy_stats_t *out) {
+    *out = s_stats;
+}
+
+#else // !USE_STRATUM_PROXY
+
+void stratum_proxy_init() {}
+
+void stratum_proxy_get_stats(stratum_proxy_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+#endif // USE_STRATUM_PROXY
@@ -0,0 +1,66 @@
+/*
+ * SparkMiner - LAN Stratum Proxy
+ * Lets one board hold the pool connection for the miners around it: they
+ * point their pool at this board (port STRATUM_PROXY_PORT) and speak plain
+ * Stratum V1 to it, and the pool sees a single worker.
+ *
+ * Work split: the stratum client keeps the first byte of the pool's
+ * extranonce2 back (00 for this board's own shares). Each downstream miner
+ * gets its slot number as extranonce1 and the remaining extranonce2 bytes,
+ * so every miner searches its own range. Notifies are re-encoded from the
+ * decoded job, so downstream miners get them as soon as the pool sends one.
+ *
+ * Shares are checked before they reach the pool: the header is rebuilt
+ * from the job (the last PROXY_JOB_RING sent) and the miner's extranonce,
+ * and only hashes meeting the difficulty the miner was sent are rewritten
+ * with its prefix and go through the normal submit queue, which sends
+ * whatever is queued in one TCP write; the pool's answer is relayed back
+ * to the miner. All miners share one pool worker, so a miner whose shares
+ * keep failing (PROXY_REJECT_PCT of a PROXY_REJECT_WINDOW) is dropped.
+ *
+ * Built in only with USE_STRATUM_PROXY=1. Stratum V2 pools, and pools
+ * with fewer than STRATUM_PROXY_MIN_EN2 extranonce2 bytes, can't be split:
+ * downstream miners are refused until the board is on a pool that can.
+ */
+
+#ifndef STRATUM_PROXY_H
+#define STRATUM_PROXY_H
+
+#include <Arduino.h>
+
+#define PROXY_LINE_MAX      512     // Longest downstream request kept
+#define PROXY_NOTIFY_MAX    2560    // Formatted mining.notify (largest coinbase and branch set)
+#define PROXY_IO_MS         1000    // Send timeout before a stalled miner is dropped
+#define PROXY_TICKETS       64      // Shares awaiting the pool's answer
+#define PROXY_IDLE_MS       1000    // Longest sleep between housekeeping passes
+#define PROXY_JOB_RING      4       // Jobs sent downstream that shares are checked against
+#define PROXY_REJECT_WINDOW 32      // Shares per reject-rate check
+#define PROXY_REJECT_PCT    50      // A miner failing this share of a window is dropped
+
+/**
+ * Proxy counters since boot
+ */
+typedef struct {
+    uint32_t clients;           // Miners connected now
+    uint32_t connects;          // Miners accepted since boot
+    uint32_t forwarded;         // Shares queued to the pool
+    uint32_t accepted;
+    uint32_t rejected;          // Rejected, stale or timed out
+    uint32_t malformed;         // Submits that failed the shape check
+    uint32_t stale;             // For a job no longer held (not forwarded)
+    uint32_t lowDifficulty;     // Hash above the miner's target (not forwarded)
+    uint32_t kicked;            // Miners dropped for their reject rate
+} stratum_proxy_stats_t;
+
+/**
+ * Hook the proxy into the stratum client and start its task
+ * Call after stratum_init().
+ */
+void stratum_proxy_init();
+
+/**
+ * Copy the proxy counters (safe from any task)
+ */
+void stratum_proxy_get_stats(stratum_proxy_stats_t *out);
+
+#endif // STRATUM_PROXY_H
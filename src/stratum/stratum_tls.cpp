@@ -0,0 +1,217 @@
+/*
+ * SparkMiner - Stratum over TLS
+ * See stratum_tls.h.
+ */
+
+#include <errno.h>
+#include <lwip/sockets.h>
+#include <esp_system.h>       // esp_fill_random()
+#include <esp_heap_caps.h>
+#include <mbedtls/net_sockets.h>
+#include "stratum_tls.h"
+
+#define TLS_WRITE_MS        5000    // Give up on a write the pool stops reading
+
+// ============================================================
+// Shared Configuration
+// ============================================================
+
+// One client configuration for every connection (read-only once set up);
+// each connection only owns its mbedtls_ssl_context and record buffers
+static mbedtls_ssl_config s_conf;
+static bool s_confReady = false;
+
+// Hardware RNG (true random once WiFi is up), instead of a CTR-DRBG and
+// entropy context kept in heap for the life of the firmware
+static int tlsRandom(void *ctx, unsigned char *out, size_t len) {
+    esp_fill_random(out, len);
+    return 0;
+}
+
+static bool confInit() {
+    if (s_confReady) return true;
+
+    mbedtls_ssl_config_init(&s_conf);
+    int ret = mbedtls_ssl_config_defaults(&s_conf, MBEDTLS_SSL_IS_CLIENT,
+                                          MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        Serial.printf("[TLS] Config setup failed: -0x%04x\n", -ret);
+        mbedtls_ssl_config_free(&s_conf);
+        return false;
+    }
+    mbedtls_ssl_conf_authmode(&s_conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&s_conf, tlsRandom, NULL);
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&s_conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    s_confReady = true;
+    return true;
+}
+
+// ============================================================
+// Socket Callbacks
+// ============================================================
+
+int StratumTlsClient::sendRaw(void *ctx, const unsigned char *buf, size_t len) {
+    StratumTlsClient *client = (StratumTlsClient *)ctx;
+    int n = send(client->fd(), buf, len, 0);
+    if (n >= 0) return n;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+}
+
+// Never blocks: the stratum task polls, and select() wakes it for new records
+int StratumTlsClient::recvRaw(void *ctx, unsigned char *buf, size_t len) {
+    StratumTlsClient *client = (StratumTlsClient *)ctx;
+    int n = recv(client->fd(), buf, len, MSG_DONTWAIT);
+    if (n > 0) return n;
+    if (n == 0) return MBEDTLS_ERR_NET_CONN_RESET;
+    return (errno == EAGAIN || errno == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_READ : MBEDTLS_ERR_NET_RECV_FAILED;
+}
+
+// ============================================================
+// Client
+// ============================================================
+
+StratumTlsClient::StratumTlsClient() : _active(false), _resumed(false), _handshakeMs(0) {
+    mbedtls_ssl_init(&_ssl);
+}
+
+StratumTlsClient::~StratumTlsClient() {
+    mbedtls_ssl_free(&_ssl);
+}
+
+void StratumTlsClient::resetTls() {
+    _active = false;
+    mbedtls_ssl_free(&_ssl);                        // Releases the record buffers
+    mbedtls_ssl_init(&_ssl);
+}
+
+int StratumTlsClient::connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+    resetTls();
+    return WiFiClient::connect(ip, port, timeoutMs);
+}
+
+bool StratumTlsClient::startTls(const char *host, stratum_tls_cache_t *cache, uint32_t timeoutMs) {
+    uint32_t start = millis();
+    resetTls();
+    _resumed = false;
+
+    // Record buffers (MBEDTLS_SSL_IN/OUT_CONTENT_LEN) plus handshake state
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    if (largest < STRATUM_TLS_MIN_HEAP) {
+        Serial.printf("[TLS] Not enough heap for a handshake (largest block %u bytes)\n", (unsigned)largest);
+        WiFiClient::stop();
+        return false;
+    }
+
+    if (!confInit() || mbedtls_ssl_setup(&_ssl, &s_conf) != 0 || mbedtls_ssl_set_hostname(&_ssl, host) != 0) {
+        Serial.println("[TLS] Context setup failed");
+        stop();
+        return false;
+    }
+    mbedtls_ssl_set_bio(&_ssl, this, sendRaw, recvRaw, NULL);
+
+    // Offer the last session with this host; the server echoes its ID when it
+    // accepts (for tickets too: the client then picks a random ID)
+    unsigned char offeredId[32];
+    size_t offeredLen = 0;
+    bool offered = cache && cache->valid && strncmp(cache->host, host, sizeof(cache->host)) == 0;
+    if (offered && mbedtls_ssl_set_session(&_ssl, &cache->session) == 0) {
+        offeredLen = cache->session.id_len;
+        memcpy(offeredId, cache->session.id, offeredLen);
+    }
+
+    int ret;
+    while ((ret = mbedtls_ssl_handshake(&_ssl)) != 0) {
+        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            Serial.printf("[TLS] Handshake with %s failed: -0x%04x\n", host, -ret);
+            if (cache) cache->valid = false;
+            stop();
+            return false;
+        }
+        if (millis() - start >= timeoutMs) {
+            Serial.printf("[TLS] Handshake with %s timed out\n", host);
+            stop();
+            return false;
+        }
+        vTaskDelay(1 / portTICK_PERIOD_MS);
+    }
+
+    _active = true;
+    _handshakeMs = millis() - start;
+    _resumed = offeredLen && _ssl.session->id_len == offeredLen &&
+               memcmp(_ssl.session->id, offeredId, offeredLen) == 0;
+
+    if (cache) {
+        mbedtls_ssl_session_free(&cache->session);
+        mbedtls_ssl_session_init(&cache->session);
+        cache->valid = mbedtls_ssl_get_session(&_ssl, &cache->session) == 0;
+        strncpy(cache->host, host, sizeof(cache->host) - 1);
+        cache->host[sizeof(cache->host) - 1] = '\0';
+    }
+    return true;
+}
+
+int StratumTlsClient::available() {
+    if (!_active) return WiFiClient::available();
+
+    int pending = mbedtls_ssl_get_bytes_avail(&_ssl);
+    if (pending > 0) return pending;
+
+    // Decrypt a record if one has arrived; its plaintext stays buffered
+    int ret = mbedtls_ssl_read(&_ssl, NULL, 0);
+    if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        if (ret != MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            Serial.printf("[TLS] Read failed: -0x%04x\n", -ret);
+        }
+        stop();
+        return 0;
+    }
+    return mbedtls_ssl_get_bytes_avail(&_ssl);
+}
+
+int StratumTlsClient::read(uint8_t *buf, size_t size) {
+    if (!_active) return WiFiClient::read(buf, size);
+
+    int ret = mbedtls_ssl_read(&_ssl, buf, size);
+    if (ret > 0) return ret;
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) stop();
+    return -1;
+}
+
+int StratumTlsClient::read() {
+    uint8_t data;
+    return read(&data, 1) == 1 ? data : -1;
+}
+
+size_t StratumTlsClient::write(const uint8_t *buf, size_t size) {
+    if (!_active) return WiFiClient::write(buf, size);
+
+    uint32_t start = millis();
+    size_t written = 0;
+    while (written < size) {
+        int ret = mbedtls_ssl_write(&_ssl, buf + written, size - written);
+        if (ret > 0) {
+            written += ret;
+        } else if ((ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_WANT_READ) ||
+                   millis() - start >= TLS_WRITE_MS) {
+            Serial.printf("[TLS] Write failed: -0x%04x\n", -ret);
+            stop();
+            break;
+        } else {
+            vTaskDelay(1 / portTICK_PERIOD_MS);
+        }
+    }
+    return written;
+}
+
+size_t StratumTlsClient::write(uint8_t data) {
+    return write(&data, 1);
+}
+
+void StratumTlsClient::stop() {
+    if (_active) mbedtls_ssl_close_notify(&_ssl);  // Best effort, the socket closes next
+    resetTls();
+    WiFiClient::stop();
+}
@@ -0,0 +1,76 @@
+/*
+ * SparkMiner - Stratum over TLS
+ * WiFiClient that can switch an already connected socket to TLS, so pool
+ * sessions keep their DNS cache, socket tuning and select() wakeups and
+ * the rest of stratum.cpp reads and writes as before.
+ *
+ * The session (ID and ticket) of the last handshake with each pool is
+ * kept, and offered on the next connect: a resumed handshake skips the
+ * certificate and key exchange, which on the ESP32 costs several hundred
+ * ms of Core 0 time.
+ */
+
+#ifndef STRATUM_TLS_H
+#define STRATUM_TLS_H
+
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <mbedtls/ssl.h>
+#include <board_config.h>
+
+/**
+ * Resumable session for one pool
+ */
+typedef struct {
+    char host[MAX_POOL_URL_LEN];    // Host the session was negotiated with
+    bool valid;
+    mbedtls_ssl_session session;
+} stratum_tls_cache_t;
+
+class StratumTlsClient : public WiFiClient {
+public:
+    StratumTlsClient();
+    ~StratumTlsClient();
+
+    /**
+     * Plain TCP connect; drops any TLS state left by the previous connection
+     */
+    int connect(IPAddress ip, uint16_t port, int32_t timeoutMs);
+    using WiFiClient::connect;
+
+    /**
+     * Run a TLS handshake over the connected socket
+     * The pool certificate is not verified (same as the HTTPS stats
+     * fetch); TLS here is for pools that refuse plaintext.
+     * @param host      SNI host name
+     * @param cache     Session to offer, refreshed after the handshake (may be NULL)
+     * @param timeoutMs Handshake deadline
+     * @return false on failure or too little heap (the socket is closed)
+     */
+    bool startTls(const char *host, stratum_tls_cache_t *cache, uint32_t timeoutMs);
+
+    bool tlsActive() const { return _active; }
+    bool resumed() const { return _resumed; }       // Last handshake reused a cached session
+    uint32_t handshakeMs() const { return _handshakeMs; }
+
+    // Plaintext I/O: through TLS once started, otherwise the plain socket
+    int available() override;
+    int read() override;
+    int read(uint8_t *buf, size_t size) override;
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *buf, size_t size) override;
+    void stop() override;
+    using Print::write;
+
+private:
+    static int sendRaw(void *ctx, const unsigned char *buf, size_t len);
+    static int recvRaw(void *ctx, unsigned char *buf, size_t len);
+    void resetTls();
+
+    mbedtls_ssl_context _ssl;
+    bool _active;
+    bool _resumed;
+    uint32_t _handshakeMs;
+};
+
+#endif // STRATUM_TLS_H
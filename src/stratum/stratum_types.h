@@ -8,7 +8,9 @@
 #ifndef STRATUM_TYPES_H
 #define STRATUM_TYPES_H
 
+#ifdef ARDUINO
 #include <Arduino.h>
+#endif
 #include <ArduinoJson.h>
 #include <board_config.h>
 
@@ -16,41 +18,60 @@
 #define DESIRED_DIFFICULTY      0.0014
 #define STRATUM_MSG_SIZE        512
 #define MAX_PENDING_SUBMISSIONS 30
+#define STRATUM_PENDING_SLOTS   32      // Requests awaiting a response; power of two, indexed by id
+#define STRATUM_LATENCY_WINDOW  64      // Share round trips kept for percentiles
+
+// BIP310 version rolling - mask requested in mining.configure
+#define VERSION_ROLLING_MASK    0x1fffe000
+#define VERSION_ROLLING_MIN_BITS 2
 
 // Submission flags
 #define SUBMIT_FLAG_32BIT       0x02    // 32-bit share (difficulty >= 2^32)
 #define SUBMIT_FLAG_BLOCK       0x04    // Full block solution
+#define SUBMIT_FLAG_VERSION     0x08    // Submit with version bits (6th param)
+#define SUBMIT_FLAG_PROXY       0x10    // From a LAN proxy miner: extraNonce2 is complete
 
 // Callback for submission response
 typedef void (*SubmitCallback)(uint32_t sessionId, uint32_t msgId, bool accepted, const char* reason);
 
-// Fixed sizes for stratum job fields (avoid heap fragmentation from String)
+// Fixed sizes for decoded job fields (avoid heap fragmentation from String)
 #define STRATUM_JOB_ID_LEN      16      // Job ID (usually 4-8 hex chars)
-#define STRATUM_PREVHASH_LEN    68      // Previous block hash (64 hex + null)
-#define STRATUM_COINBASE1_LEN   512     // Coinbase part 1 (variable, can be large)
-#define STRATUM_COINBASE2_LEN   256     // Coinbase part 2
-#define STRATUM_EXTRANONCE_LEN  32      // Extra nonce (usually 8-16 hex)
-#define STRATUM_FIELD_LEN       12      // Version/nbits/ntime (8 hex + null)
+// Decoded coinbase: coinb1 + extranonce1 + extranonce2 + coinb2. A notify
+// with a longer one is rejected as malformed. The defaults fit typical pool
+// coinbases; a 3 KB coinbase (a notify line of about 7 KB) needs
+// -D STRATUM_COINBASE_LEN=4096 -D STRATUM_MAX_LINE=10240, at the cost of
+// about ten coinbase copies (job ring, sessions, LAN proxy, miner) and two
+// larger RX buffers. Each coinbase hash copies it onto the mining or stratum
+// task's stack, so those stacks need raising by as much.
+#ifndef STRATUM_COINBASE_LEN
+    #define STRATUM_COINBASE_LEN 512
+#endif
+#ifndef STRATUM_MAX_LINE
+    #define STRATUM_MAX_LINE    4096    // Longer inbound lines are discarded (and not captured)
+#endif
 #define STRATUM_MAX_MERKLE      16      // Max merkle branches (usually < 10)
+#define STRATUM_JOB_RING        4       // Recent decoded jobs kept for late shares
 
 /**
- * Stratum job from pool (mining.notify)
- * Uses fixed char arrays to avoid heap fragmentation
+ * Stratum job from pool (mining.notify), decoded to binary once at parse
+ * time so the miner never touches hex on the job-switch path
  */
 typedef struct {
     char jobId[STRATUM_JOB_ID_LEN];         // Unique job identifier
-    char prevHash[STRATUM_PREVHASH_LEN];    // Previous block hash (256-bit hex)
-    char coinBase1[STRATUM_COINBASE1_LEN];  // Coinbase transaction part 1
-    char coinBase2[STRATUM_COINBASE2_LEN];  // Coinbase transaction part 2
-    char extraNonce1[STRATUM_EXTRANONCE_LEN]; // Pool-provided extra nonce
-    int extraNonce2Size;                    // Size of extraNonce2 in bytes
-    char merkleBranches[STRATUM_MAX_MERKLE][68]; // Merkle branches (64 hex + null each)
-    int merkleBranchCount;                  // Number of merkle branches
-    char version[STRATUM_FIELD_LEN];        // Block version (4 bytes hex)
-    char nbits[STRATUM_FIELD_LEN];          // Difficulty target (4 bytes hex)
-    char ntime[STRATUM_FIELD_LEN];          // Block timestamp (4 bytes hex)
+    uint8_t prevHash[32];                   // Previous block hash, header byte order
+    uint8_t coinbase[STRATUM_COINBASE_LEN]; // coinb1 | extranonce1 | zeroed extranonce2 | coinb2
+    uint16_t coinbaseLen;                   // Coinbase length in bytes
+    uint16_t extraNonce2Offset;             // Where extranonce2 sits in coinbase[]
+    uint8_t extraNonce2Size;                // Extranonce2 length in bytes
+    uint8_t merkleBranchCount;              // Number of merkle branches
+    uint8_t merkleBranches[STRATUM_MAX_MERKLE][32]; // Merkle branches, raw bytes
+    uint32_t version;                       // Block version (native endian)
+    uint32_t nbits;                         // Difficulty target (compact, native endian)
+    uint32_t ntime;                         // Block timestamp (native endian)
     bool cleanJobs;                         // Clear pending jobs
-} stratum_job_t;
+    bool headerOnly;                        // Stratum V2 standard job: merkleRoot given, no coinbase
+    uint8_t merkleRoot[32];                 // Header-only jobs: merkle root, header byte order
+} mining_job_bin_t;
 
 /**
  * Share submission queue entry
@@ -59,12 +80,14 @@ typedef struct {
 typedef struct {
     char jobId[MAX_JOB_ID_LEN];     // Job ID this share belongs to
     char extraNonce2[20];           // ExtraNonce2 value
-    uint32_t timestamp;             // Block timestamp
+    uint32_t timestamp;             // Block timestamp (rolled ntime if rolling)
     uint32_t nonce;                 // Winning nonce
     uint32_t msgId;                 // Stratum message ID
     uint32_t sessionId;             // Session ID for tracking
     uint32_t sentTime;              // Timestamp when sent to pool (ms)
+    uint32_t queuedUs;              // micros() when queued by stratum_submit_share()
     uint32_t versionBits;           // Version rolling bits (ASICBoost)
+    uint32_t version;               // Full block version as hashed (Stratum V2 submits all of it)
     uint32_t flags;                 // SUBMIT_FLAG_* values
     double difficulty;              // Share difficulty
     SubmitCallback callback;        // Response callback
@@ -74,7 +97,8 @@ typedef struct {
  * Mining statistics
  */
 typedef struct {
-    volatile uint64_t hashes;       // Total hashes computed
+    volatile uint64_t hashes;       // Total hashes computed (summed by miner_get_stats)
+    uint64_t coreHashes[2];         // Per-core hash counts (snapshot from miner_get_stats)
     volatile uint32_t shares;       // Shares submitted
     volatile uint32_t accepted;     // Shares accepted by pool
     volatile uint32_t rejected;     // Shares rejected by pool
@@ -83,9 +107,32 @@ typedef struct {
     volatile uint32_t matches16;    // 16-bit matches (for stats)
     volatile uint32_t lastLatency;  // Last round-trip latency in ms
     volatile uint32_t avgLatency;   // Moving average latency in ms (EMA)
+    volatile uint32_t latencyP50;   // Median share round trip over the last STRATUM_LATENCY_WINDOW (ms)
+    volatile uint32_t latencyP95;   // 95th percentile share round trip, same window (ms)
+    volatile uint32_t shareTimeouts;    // Shares with no response before their deadline
+    volatile uint32_t lateResponses;    // Responses to ids no longer pending (timed out or unknown)
+    volatile uint32_t controlLatency;   // Last keepalive/control round trip (ms)
+    volatile uint32_t controlTimeouts;  // Keepalive/control requests never answered
+    volatile uint32_t staleDropped;     // Shares for invalidated jobs dropped before sending
+    volatile uint32_t deferredJobs;     // Non-clean notifies held instead of switching jobs at once
     double bestDifficulty;          // Best difficulty found
     uint32_t startTime;             // Mining start timestamp
     uint32_t templates;             // Jobs received from pool
+    volatile uint32_t lastBuildUs;  // Time to build + publish last job (us)
+    volatile uint32_t lastSwitchUs; // Publish-to-pickup latency of last job switch (us)
+    volatile uint32_t maxSwitchUs;  // Worst publish-to-pickup latency seen (us)
+    volatile uint32_t extraNonceRolls; // Nonce ranges extended by rolling extranonce2
+    volatile uint32_t rollStalls;   // Rolls built inline because none was prepared
+    volatile uint32_t versionRolls; // Nonce ranges extended by rolling version bits
+    volatile uint32_t ntimeRolls;   // Nonce ranges extended by rolling ntime
+    volatile uint32_t yieldUs[2];   // Time each mining core spent yielding (us, cumulative)
+    volatile uint32_t yieldInterval[2]; // Current yield interval per core (C0 hashes, C1 kernel returns)
+    uint32_t candidateDrops;        // Candidates lost to a full verify ring (snapshot from miner_get_stats)
+    volatile uint32_t invalidCandidates; // Candidates the software check rejected (kernel or ASIC result errors)
+    volatile uint32_t lastSubmitQueueUs; // Time the last share waited in the submit queue (us)
+    volatile uint32_t maxSubmitQueueUs;  // Worst submit queue wait seen (us)
+    volatile uint32_t firstJobMs;   // Boot to first job published (ms, 0 = none yet)
+    volatile uint32_t firstHashMs;  // Boot to first job picked up by a core (ms, 0 = none yet)
 } mining_stats_t;
 
 /**
@@ -104,11 +151,15 @@ typedef enum {
  * Pool configuration
  */
 typedef struct {
-    char url[MAX_POOL_URL_LEN];
+    char url[MAX_POOL_URL_LEN];     // Host, without any scheme prefix
     int port;
     char wallet[MAX_WALLET_LEN];
     char password[MAX_PASSWORD_LEN];
     char workerName[32];
+    bool sv2;                       // Stratum V2 ("stratum2+tcp://" URL)
+    bool tls;                       // Stratum over TLS ("stratum+ssl://" or "stratum+tls://" URL)
+    bool hasAuthorityKey;           // Stratum V2: verify the pool certificate
+    uint8_t authorityKey[32];       // Stratum V2: x-only pool authority key
 } pool_config_t;
 
 #endif // STRATUM_TYPES_H
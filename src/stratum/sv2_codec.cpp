@@ -0,0 +1,295 @@
+/*
+ * SparkMiner - Stratum V2 Message Codec
+ * See sv2_codec.h.
+ */
+
+#include <string.h>
+#include <math.h>
+#include "sv2_codec.h"
+
+// ============================================================
+// Writer / Reader
+// ============================================================
+
+// Bounded little-endian writer; ok goes false on the first overflow
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    bool ok;
+} sv2_writer_t;
+
+static void putBytes(sv2_writer_t *w, const void *data, size_t len) {
+    if (!w->ok || w->len + len > w->cap) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void putU8(sv2_writer_t *w, uint8_t v) {
+    putBytes(w, &v, 1);
+}
+
+static void putU16(sv2_writer_t *w, uint16_t v) {
+    uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    putBytes(w, b, 2);
+}
+
+static void putU32(sv2_writer_t *w, uint32_t v) {
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    putBytes(w, b, 4);
+}
+
+// STR0_255: one length byte, then the bytes (longer strings are cut)
+static void putStr(sv2_writer_t *w, const char *s) {
+    size_t len = s ? strlen(s) : 0;
+    if (len > SV2_MAX_STR) len = SV2_MAX_STR;
+    putU8(w, (uint8_t)len);
+    putBytes(w, s, len);
+}
+
+// Reserve the frame header; frameFinish() fills it once the payload is known
+static void frameBegin(sv2_writer_t *w, uint8_t *out, size_t cap) {
+    w->buf = out;
+    w->cap = cap;
+    w->len = 0;
+    w->ok = cap >= SV2_HEADER_LEN;
+    if (w->ok) w->len = SV2_HEADER_LEN;
+}
+
+static size_t frameFinish(sv2_writer_t *w, uint16_t extension, uint8_t type) {
+    if (!w->ok) return 0;
+    uint32_t length = w->len - SV2_HEADER_LEN;
+    w->buf[0] = (uint8_t)extension;
+    w->buf[1] = (uint8_t)(extension >> 8);
+    w->buf[2] = type;
+    w->buf[3] = (uint8_t)length;
+    w->buf[4] = (uint8_t)(length >> 8);
+    w->buf[5] = (uint8_t)(length >> 16);
+    return w->len;
+}
+
+// Bounded little-endian reader; ok goes false on the first short read
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+    bool ok;
+} sv2_reader_t;
+
+static const uint8_t *getBytes(sv2_reader_t *r, size_t len) {
+    if (!r->ok || r->pos + len > r->len) {
+        r->ok = false;
+        return NULL;
+    }
+    const uint8_t *p = r->buf + r->pos;
+    r->pos += len;
+    return p;
+}
+
+static uint8_t getU8(sv2_reader_t *r) {
+    const uint8_t *p = getBytes(r, 1);
+    return p ? p[0] : 0;
+}
+
+static uint16_t getU16(sv2_reader_t *r) {
+    const uint8_t *p = getBytes(r, 2);
+    return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+static uint32_t getU32(sv2_reader_t *r) {
+    const uint8_t *p = getBytes(r, 4);
+    return p ? ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) : 0;
+}
+
+static void getFixed(sv2_reader_t *r, uint8_t *out, size_t len) {
+    const uint8_t *p = getBytes(r, len);
+    if (p) memcpy(out, p, len);
+}
+
+// STR0_255 into a NUL-terminated buffer, cut to fit
+static void getStr(sv2_reader_t *r, char *out, size_t cap) {
+    uint8_t len = getU8(r);
+    const uint8_t *p = getBytes(r, len);
+    size_t n = (p && len < cap) ? len : (p ? cap - 1 : 0);
+    if (p) memcpy(out, p, n);
+    out[n] = '\0';
+}
+
+// ============================================================
+// Client Messages
+// ============================================================
+
+size_t sv2_encode_setup_connection(uint8_t *out, size_t cap, const sv2_setup_t *setup) {
+    sv2_writer_t w;
+    frameBegin(&w, out, cap);
+    putU8(&w, 0);                       // Mining Protocol
+    putU16(&w, 2);                      // min_version
+    putU16(&w, 2);                      // max_version
+    putU32(&w, SV2_SETUP_REQUIRES_STANDARD_JOBS);
+    putStr(&w, setup->host);
+    putU16(&w, setup->port);
+    putStr(&w, setup->vendor);
+    putStr(&w, setup->hardware);
+    putStr(&w, setup->firmware);
+    putStr(&w, setup->deviceId);
+    return frameFinish(&w, 0, SV2_MSG_SETUP_CONNECTION);
+}
+
+// nominal_hash_rate (f32) and maximum_target (whatever the pool picks)
+static void putHashRate(sv2_writer_t *w, float hashRate) {
+    uint32_t rateBits;
+    uint8_t maxTarget[32];
+    memcpy(&rateBits, &hashRate, sizeof(rateBits));
+    memset(maxTarget, 0xff, sizeof(maxTarget));
+    putU32(w, rateBits);
+    putBytes(w, maxTarget, sizeof(maxTarget));
+}
+
+size_t sv2_encode_open_standard_channel(uint8_t *out, size_t cap, uint32_t requestId,
+                                        const char *user, float hashRate) {
+    sv2_writer_t w;
+    frameBegin(&w, out, cap);
+    putU32(&w, requestId);
+    putStr(&w, user);
+    putHashRate(&w, hashRate);
+    return frameFinish(&w, 0, SV2_MSG_OPEN_STANDARD_CHANNEL);
+}
+
+size_t sv2_encode_update_channel(uint8_t *out, size_t cap, uint32_t channelId, float hashRate) {
+    sv2_writer_t w;
+    frameBegin(&w, out, cap);
+    putU32(&w, channelId);
+    putHashRate(&w, hashRate);
+    return frameFinish(&w, SV2_CHANNEL_MSG_BIT, SV2_MSG_UPDATE_CHANNEL);
+}
+
+size_t sv2_encode_submit_standard(uint8_t *out, size_t cap, const sv2_submit_t *submit) {
+    sv2_writer_t w;
+    frameBegin(&w, out, cap);
+    putU32(&w, submit->channelId);
+    putU32(&w, submit->sequence);
+    putU32(&w, submit->jobId);
+    putU32(&w, submit->nonce);
+    putU32(&w, submit->ntime);
+    putU32(&w, submit->version);
+    return frameFinish(&w, SV2_CHANNEL_MSG_BIT, SV2_MSG_SUBMIT_SHARES_STANDARD);
+}
+
+// ============================================================
+// Server Messages
+// ============================================================
+
+void sv2_decode_header(const uint8_t *in, sv2_header_t *header) {
+    header->extension = (uint16_t)(in[0] | (in[1] << 8)) & ~SV2_CHANNEL_MSG_BIT;
+    header->type = in[2];
+    header->length = (uint32_t)in[3] | ((uint32_t)in[4] << 8) | ((uint32_t)in[5] << 16);
+}
+
+bool sv2_decode_message(uint8_t type, const uint8_t *payload, size_t len, sv2_msg_t *msg) {
+    sv2_reader_t r = { payload, len, 0, true };
+    memset(msg, 0, sizeof(*msg));
+    msg->type = type;
+
+    switch (type) {
+        case SV2_MSG_SETUP_CONNECTION_SUCCESS:
+            msg->setup.usedVersion = getU16(&r);
+            msg->setup.flags = getU32(&r);
+            break;
+        case SV2_MSG_SETUP_CONNECTION_ERROR:
+        case SV2_MSG_OPEN_CHANNEL_ERROR:
+            msg->error.id = getU32(&r);         // flags / request_id
+            getStr(&r, msg->error.code, sizeof(msg->error.code));
+            break;
+        case SV2_MSG_CLOSE_CHANNEL:
+            msg->error.id = getU32(&r);         // channel_id
+            getStr(&r, msg->error.code, sizeof(msg->error.code));
+            break;
+        case SV2_MSG_OPEN_STANDARD_CHANNEL_SUCCESS: {
+            msg->channel.requestId = getU32(&r);
+            msg->channel.channelId = getU32(&r);
+            getFixed(&r, msg->channel.target, 32);
+            uint8_t prefixLen = getU8(&r);      // extranonce_prefix (B0_32), unused
+            if (prefixLen > 32) return false;
+            getBytes(&r, prefixLen);
+            msg->channel.groupChannelId = getU32(&r);
+            break;
+        }
+        case SV2_MSG_NEW_MINING_JOB:
+            msg->job.channelId = getU32(&r);
+            msg->job.jobId = getU32(&r);
+            msg->job.future = getU8(&r) == 0;   // OPTION[u32]: 0 = none, 1 = value follows
+            if (!msg->job.future) msg->job.minNtime = getU32(&r);
+            msg->job.version = getU32(&r);
+            getFixed(&r, msg->job.merkleRoot, 32);
+            break;
+        case SV2_MSG_SET_NEW_PREV_HASH:
+            msg->prevHash.channelId = getU32(&r);
+            msg->prevHash.jobId = getU32(&r);
+            getFixed(&r, msg->prevHash.prevHash, 32);
+            msg->prevHash.minNtime = getU32(&r);
+            msg->prevHash.nbits = getU32(&r);
+            break;
+        case SV2_MSG_SET_TARGET:
+            msg->target.channelId = getU32(&r);
+            getFixed(&r, msg->target.target, 32);
+            break;
+        case SV2_MSG_SUBMIT_SHARES_SUCCESS: {
+            msg->accepted.channelId = getU32(&r);
+            msg->accepted.lastSequence = getU32(&r);
+            msg->accepted.acceptedCount = getU32(&r);
+            uint32_t lo = getU32(&r);
+            uint32_t hi = getU32(&r);
+            msg->accepted.sharesSum = ((uint64_t)hi << 32) | lo;
+            break;
+        }
+        case SV2_MSG_SUBMIT_SHARES_ERROR:
+            msg->error.id = getU32(&r);         // channel_id
+            msg->error.sequence = getU32(&r);
+            getStr(&r, msg->error.code, sizeof(msg->error.code));
+            break;
+        default:
+            return false;
+    }
+    return r.ok;
+}
+
+bool sv2_decode_authority_key(const char *text, uint8_t key[32]) {
+    static const char *ALPHABET = "123456789ABCDEFGHJKLMNPQRSTUVWXYZabcdefghijkmnopqrstuvwxyz";
+    uint8_t raw[2 + 32 + 4];    // version, key, checksum
+    memset(raw, 0, sizeof(raw));
+
+    // Big-endian base conversion: raw = raw * 58 + digit
+    size_t len = strlen(text);
+    if (len == 0 || len > 60) return false;
+    for (size_t i = 0; i < len; i++) {
+        const char *digit = strchr(ALPHABET, text[i]);
+        if (!digit) return false;
+        uint32_t carry = digit - ALPHABET;
+        for (int j = sizeof(raw) - 1; j >= 0; j--) {
+            carry += (uint32_t)raw[j] * 58;
+            raw[j] = (uint8_t)carry;
+            carry >>= 8;
+        }
+        if (carry) return false;    // Longer than a key
+    }
+
+    uint8_t check[32];
+    sv2_sha256(check, raw, 34, NULL, 0);
+    sv2_sha256(check, check, 32, NULL, 0);
+    if (memcmp(check, raw + 34, 4) != 0) return false;
+    if (raw[0] != 1 || raw[1] != 0) return false;
+
+    memcpy(key, raw + 2, 32);
+    return true;
+}
+
+double sv2_target_to_difficulty(const uint8_t target[32]) {
+    // Difficulty 1 is 0xffff * 2^208
+    double t = 0;
+    for (int i = 31; i >= 0; i--) t = t * 256.0 + target[i];
+    if (t <= 0) return 0;
+    return ldexp(65535.0, 208) / t;
+}
@@ -0,0 +1,157 @@
+/*
+ * SparkMiner - Stratum V2 Message Codec
+ * Binary framing and the Mining Protocol messages a standard channel
+ * (header-only mining) uses. Frames are built and parsed in caller
+ * buffers: every field is fixed-width little-endian, so there is no text,
+ * hex or JSON anywhere on this path.
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ */
+
+#ifndef SV2_CODEC_H
+#define SV2_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sv2_noise.h"
+
+// Message types (Common and Mining Protocol)
+#define SV2_MSG_SETUP_CONNECTION            0x00
+#define SV2_MSG_SETUP_CONNECTION_SUCCESS    0x01
+#define SV2_MSG_SETUP_CONNECTION_ERROR      0x02
+#define SV2_MSG_OPEN_STANDARD_CHANNEL       0x10
+#define SV2_MSG_OPEN_STANDARD_CHANNEL_SUCCESS 0x11
+#define SV2_MSG_OPEN_CHANNEL_ERROR          0x12
+#define SV2_MSG_UPDATE_CHANNEL              0x16
+#define SV2_MSG_CLOSE_CHANNEL               0x18
+#define SV2_MSG_SUBMIT_SHARES_STANDARD      0x1a
+#define SV2_MSG_SUBMIT_SHARES_SUCCESS       0x1c
+#define SV2_MSG_SUBMIT_SHARES_ERROR         0x1d
+#define SV2_MSG_NEW_MINING_JOB              0x1e
+#define SV2_MSG_SET_NEW_PREV_HASH           0x20
+#define SV2_MSG_SET_TARGET                  0x21
+
+#define SV2_CHANNEL_MSG_BIT     0x8000  // extension_type flag: payload starts with channel_id
+
+// SetupConnection flags (Mining Protocol)
+#define SV2_SETUP_REQUIRES_STANDARD_JOBS    0x01    // Client: header-only jobs only
+#define SV2_SETUP_REQUIRES_FIXED_VERSION    0x01    // Server: version bits must not be rolled
+
+#define SV2_ERROR_LEN           64      // Error code kept from an error message
+#define SV2_MAX_STR             255     // STR0_255
+
+/**
+ * Decoded frame header
+ */
+typedef struct {
+    uint16_t extension;     // extension_type without SV2_CHANNEL_MSG_BIT
+    uint8_t type;           // msg_type
+    uint32_t length;        // msg_length (payload bytes)
+} sv2_header_t;
+
+/**
+ * Device description sent in SetupConnection
+ */
+typedef struct {
+    const char *host;       // Pool host as dialled
+    uint16_t port;
+    const char *vendor;
+    const char *hardware;
+    const char *firmware;
+    const char *deviceId;
+} sv2_setup_t;
+
+/**
+ * SubmitSharesStandard
+ */
+typedef struct {
+    uint32_t channelId;
+    uint32_t sequence;
+    uint32_t jobId;
+    uint32_t nonce;
+    uint32_t ntime;
+    uint32_t version;       // Full block version, rolled bits included
+} sv2_submit_t;
+
+/**
+ * A decoded server message; which member is valid follows type
+ */
+typedef struct {
+    uint8_t type;
+    union {
+        struct {                        // SetupConnection.Success
+            uint16_t usedVersion;
+            uint32_t flags;
+        } setup;
+        struct {                        // OpenStandardMiningChannel.Success
+            uint32_t requestId;
+            uint32_t channelId;
+            uint8_t target[32];         // Little-endian 256-bit
+            uint32_t groupChannelId;
+        } channel;
+        struct {                        // NewMiningJob
+            uint32_t channelId;
+            uint32_t jobId;
+            bool future;                // No min_ntime: wait for SetNewPrevHash
+            uint32_t minNtime;
+            uint32_t version;
+            uint8_t merkleRoot[32];     // Header byte order
+        } job;
+        struct {                        // SetNewPrevHash
+            uint32_t channelId;
+            uint32_t jobId;
+            uint8_t prevHash[32];       // Header byte order
+            uint32_t minNtime;
+            uint32_t nbits;
+        } prevHash;
+        struct {                        // SetTarget
+            uint32_t channelId;
+            uint8_t target[32];
+        } target;
+        struct {                        // SubmitShares.Success
+            uint32_t channelId;
+            uint32_t lastSequence;
+            uint32_t acceptedCount;
+            uint64_t sharesSum;
+        } accepted;
+        struct {                        // SetupConnection.Error, OpenChannel.Error,
+            uint32_t id;                // CloseChannel, SubmitShares.Error: flags,
+            uint32_t sequence;          // request_id or channel_id; sequence for submits
+            char code[SV2_ERROR_LEN];
+        } error;
+    };
+} sv2_msg_t;
+
+/**
+ * Frame builders: write header + payload into out
+ * @return Frame length, or 0 if it does not fit in cap
+ */
+size_t sv2_encode_setup_connection(uint8_t *out, size_t cap, const sv2_setup_t *setup);
+size_t sv2_encode_open_standard_channel(uint8_t *out, size_t cap, uint32_t requestId,
+                                        const char *user, float hashRate);
+size_t sv2_encode_update_channel(uint8_t *out, size_t cap, uint32_t channelId, float hashRate);
+size_t sv2_encode_submit_standard(uint8_t *out, size_t cap, const sv2_submit_t *submit);
+
+/**
+ * Parse a plaintext 6-byte frame header
+ */
+void sv2_decode_header(const uint8_t *in, sv2_header_t *header);
+
+/**
+ * Decode a server message payload
+ * @return false for truncated payloads and message types not listed above
+ */
+bool sv2_decode_message(uint8_t type, const uint8_t *payload, size_t len, sv2_msg_t *msg);
+
+/**
+ * Parse a pool authority key as pools publish it: base58check of a
+ * 2-byte version (1, little-endian) and the 32-byte x-only key
+ */
+bool sv2_decode_authority_key(const char *text, uint8_t key[32]);
+
+/**
+ * Pool difficulty equivalent to a 256-bit little-endian target
+ */
+double sv2_target_to_difficulty(const uint8_t target[32]);
+
+#endif // SV2_CODEC_H
@@ -0,0 +1,785 @@
+/*
+ * SparkMiner - Stratum V2 Crypto Primitives
+ * See sv2_crypto.h. Field and scalar values are 8 little-endian 32-bit
+ * limbs, always kept fully reduced.
+ */
+
+#include <string.h>
+#include "sv2_crypto.h"
+#include "../mining/miner_sha256.h"
+
+// ============================================================
+// SHA-256 / HMAC / HKDF
+// ============================================================
+
+void sv2_sha256(uint8_t out[32], const uint8_t *a, size_t aLen, const uint8_t *b, size_t bLen) {
+    uint8_t buf[512];
+    if (aLen + bLen > sizeof(buf)) {
+        memset(out, 0, 32);
+        return;
+    }
+    if (aLen) memcpy(buf, a, aLen);
+    if (bLen) memcpy(buf + aLen, b, bLen);
+
+    sha256_hash_t ctx;
+    miner_sha256(&ctx, buf, aLen + bLen);
+    memcpy(out, ctx.bytes, 32);
+}
+
+void sv2_hmac_sha256(uint8_t out[32], const uint8_t key[32], const uint8_t *data, size_t len) {
+    uint8_t pad[64];
+    uint8_t inner[32];
+
+    memset(pad, 0x36, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    sv2_sha256(inner, pad, sizeof(pad), data, len);
+
+    memset(pad, 0x5c, sizeof(pad));
+    for (int i = 0; i < 32; i++) pad[i] ^= key[i];
+    sv2_sha256(out, pad, sizeof(pad), inner, sizeof(inner));
+}
+
+void sv2_hkdf2(uint8_t out1[32], uint8_t out2[32], const uint8_t chainingKey[32],
+               const uint8_t *ikm, size_t ikmLen) {
+    uint8_t tempKey[32];
+    uint8_t buf[33];
+
+    sv2_hmac_sha256(tempKey, chainingKey, ikm, ikmLen);
+    buf[0] = 0x01;
+    sv2_hmac_sha256(buf, tempKey, buf, 1);
+    memcpy(out1, buf, 32);
+    buf[32] = 0x02;
+    sv2_hmac_sha256(out2, tempKey, buf, 33);
+}
+
+// ============================================================
+// ChaCha20-Poly1305
+// ============================================================
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putLe32(uint8_t *p, uint32_t v) {
+    p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+#define QUARTER(a, b, c, d) \
+    a += b; d ^= a; d = ROTL32(d, 16); \
+    c += d; b ^= c; b = ROTL32(b, 12); \
+    a += b; d ^= a; d = ROTL32(d, 8);  \
+    c += d; b ^= c; b = ROTL32(b, 7);
+
+static void chachaBlock(uint8_t out[64], const uint8_t key[32], uint32_t counter, const uint8_t nonce[12]) {
+    uint32_t in[16], x[16];
+    in[0] = 0x61707865; in[1] = 0x3320646e; in[2] = 0x79622d32; in[3] = 0x6b206574;
+    for (int i = 0; i < 8; i++) in[4 + i] = le32(key + 4 * i);
+    in[12] = counter;
+    for (int i = 0; i < 3; i++) in[13 + i] = le32(nonce + 4 * i);
+
+    memcpy(x, in, sizeof(x));
+    for (int i = 0; i < 10; i++) {
+        QUARTER(x[0], x[4], x[8],  x[12]);
+        QUARTER(x[1], x[5], x[9],  x[13]);
+        QUARTER(x[2], x[6], x[10], x[14]);
+        QUARTER(x[3], x[7], x[11], x[15]);
+        QUARTER(x[0], x[5], x[10], x[15]);
+        QUARTER(x[1], x[6], x[11], x[12]);
+        QUARTER(x[2], x[7], x[8],  x[13]);
+        QUARTER(x[3], x[4], x[9],  x[14]);
+    }
+    for (int i = 0; i < 16; i++) putLe32(out + 4 * i, x[i] + in[i]);
+}
+
+static void chachaXor(const uint8_t key[32], const uint8_t nonce[12], uint8_t *buf, size_t len) {
+    uint8_t block[64];
+    for (uint32_t counter = 1; len > 0; counter++) {
+        chachaBlock(block, key, counter, nonce);
+        size_t n = len < 64 ? len : 64;
+        for (size_t i = 0; i < n; i++) buf[i] ^= block[i];
+        buf += n;
+        len -= n;
+    }
+}
+
+// Poly1305 in 26-bit limbs (poly1305-donna layout)
+typedef struct {
+    uint32_t r[5], s[4], h[5];
+} poly1305_t;
+
+static void polyInit(poly1305_t *p, const uint8_t key[32]) {
+    p->r[0] = le32(key + 0) & 0x3ffffff;
+    p->r[1] = (le32(key + 3) >> 2) & 0x3ffff03;
+    p->r[2] = (le32(key + 6) >> 4) & 0x3ffc0ff;
+    p->r[3] = (le32(key + 9) >> 6) & 0x3f03fff;
+    p->r[4] = (le32(key + 12) >> 8) & 0x00fffff;
+    for (int i = 0; i < 4; i++) p->s[i] = le32(key + 16 + 4 * i);
+    memset(p->h, 0, sizeof(p->h));
+}
+
+static void polyBlock(poly1305_t *p, const uint8_t m[16], uint32_t hibit) {
+    const uint32_t *r = p->r;
+    uint32_t *h = p->h;
+    uint32_t s1 = r[1] * 5, s2 = r[2] * 5, s3 = r[3] * 5, s4 = r[4] * 5;
+
+    h[0] += le32(m + 0) & 0x3ffffff;
+    h[1] += (le32(m + 3) >> 2) & 0x3ffffff;
+    h[2] += (le32(m + 6) >> 4) & 0x3ffffff;
+    h[3] += (le32(m + 9) >> 6) & 0x3ffffff;
+    h[4] += (le32(m + 12) >> 8) | hibit;
+
+    uint64_t d0 = (uint64_t)h[0] * r[0] + (uint64_t)h[1] * s4 + (uint64_t)h[2] * s3 + (uint64_t)h[3] * s2 + (uint64_t)h[4] * s1;
+    uint64_t d1 = (uint64_t)h[0] * r[1] + (uint64_t)h[1] * r[0] + (uint64_t)h[2] * s4 + (uint64_t)h[3] * s3 + (uint64_t)h[4] * s2;
+    uint64_t d2 = (uint64_t)h[0] * r[2] + (uint64_t)h[1] * r[1] + (uint64_t)h[2] * r[0] + (uint64_t)h[3] * s4 + (uint64_t)h[4] * s3;
+    uint64_t d3 = (uint64_t)h[0] * r[3] + (uint64_t)h[1] * r[2] + (uint64_t)h[2] * r[1] + (uint64_t)h[3] * r[0] + (uint64_t)h[4] * s4;
+    uint64_t d4 = (uint64_t)h[0] * r[4] + (uint64_t)h[1] * r[3] + (uint64_t)h[2] * r[2] + (uint64_t)h[3] * r[1] + (uint64_t)h[4] * r[0];
+
+    uint32_t c;
+    c = d0 >> 26; h[0] = d0 & 0x3ffffff; d1 += c;
+    c = d1 >> 26; h[1] = d1 & 0x3ffffff; d2 += c;
+    c = d2 >> 26; h[2] = d2 & 0x3ffffff; d3 += c;
+    c = d3 >> 26; h[3] = d3 & 0x3ffffff; d4 += c;
+    c = d4 >> 26; h[4] = d4 & 0x3ffffff;
+    h[0] += c * 5;
+    c = h[0] >> 26; h[0] &= 0x3ffffff; h[1] += c;
+}
+
+// Absorb data zero-padded to a 16-byte boundary (the AEAD layout)
+static void polyPadded(poly1305_t *p, const uint8_t *data, size_t len) {
+    while (len >= 16) {
+        polyBlock(p, data, 1 << 24);
+        data += 16;
+        len -= 16;
+    }
+    if (len) {
+        uint8_t last[16] = {0};
+        memcpy(last, data, len);
+        polyBlock(p, last, 1 << 24);
+    }
+}
+
+static void polyFinish(poly1305_t *p, uint8_t tag[16]) {
+    uint32_t *h = p->h;
+    uint32_t c, g[5];
+
+    c = h[1] >> 26; h[1] &= 0x3ffffff; h[2] += c;
+    c = h[2] >> 26; h[2] &= 0x3ffffff; h[3] += c;
+    c = h[3] >> 26; h[3] &= 0x3ffffff; h[4] += c;
+    c = h[4] >> 26; h[4] &= 0x3ffffff; h[0] += c * 5;
+    c = h[0] >> 26; h[0] &= 0x3ffffff; h[1] += c;
+
+    // h - p, kept if it did not go negative
+    g[0] = h[0] + 5; c = g[0] >> 26; g[0] &= 0x3ffffff;
+    g[1] = h[1] + c; c = g[1] >> 26; g[1] &= 0x3ffffff;
+    g[2] = h[2] + c; c = g[2] >> 26; g[2] &= 0x3ffffff;
+    g[3] = h[3] + c; c = g[3] >> 26; g[3] &= 0x3ffffff;
+    g[4] = h[4] + c - (1 << 26);
+    uint32_t mask = (g[4] >> 31) - 1;
+    for (int i = 0; i < 5; i++) h[i] = (h[i] & ~mask) | (g[i] & mask);
+
+    uint32_t w[4];
+    w[0] = h[0] | (h[1] << 26);
+    w[1] = (h[1] >> 6) | (h[2] << 20);
+    w[2] = (h[2] >> 12) | (h[3] << 14);
+    w[3] = (h[3] >> 18) | (h[4] << 8);
+
+    uint64_t f = 0;
+    for (int i = 0; i < 4; i++) {
+        f += (uint64_t)w[i] + p->s[i];
+        putLe32(tag + 4 * i, (uint32_t)f);
+        f >>= 32;
+    }
+}
+
+static void aeadTag(uint8_t tag[16], const uint8_t key[32], const uint8_t nonce[12],
+                    const uint8_t *ad, size_t adLen, const uint8_t *ct, size_t len) {
+    uint8_t block[64];
+    poly1305_t p;
+    chachaBlock(block, key, 0, nonce);
+    polyInit(&p, block);
+
+    polyPadded(&p, ad, adLen);
+    polyPadded(&p, ct, len);
+    uint8_t lengths[16];
+    putLe32(lengths, adLen);
+    putLe32(lengths + 4, 0);
+    putLe32(lengths + 8, len);
+    putLe32(lengths + 12, 0);
+    polyBlock(&p, lengths, 1 << 24);
+    polyFinish(&p, tag);
+}
+
+void sv2_aead_encrypt(const uint8_t key[32], const uint8_t nonce[12], const uint8_t *ad, size_t adLen,
+                      uint8_t *buf, size_t len) {
+    chachaXor(key, nonce, buf, len);
+    aeadTag(buf + len, key, nonce, ad, adLen, buf, len);
+}
+
+bool sv2_aead_decrypt(const uint8_t key[32], const uint8_t nonce[12], const uint8_t *ad, size_t adLen,
+                      uint8_t *buf, size_t len) {
+    if (len < SV2_MAC_LEN) return false;
+    len -= SV2_MAC_LEN;
+
+    uint8_t tag[16];
+    aeadTag(tag, key, nonce, ad, adLen, buf, len);
+    uint8_t diff = 0;
+    for (int i = 0; i < 16; i++) diff |= tag[i] ^ buf[len + i];
+    if (diff) return false;
+
+    chachaXor(key, nonce, buf, len);
+    return true;
+}
+
+// ============================================================
+// secp256k1 Field Arithmetic (mod p = 2^256 - 2^32 - 977)
+// ============================================================
+
+typedef struct { uint32_t v[8]; } fe_t;
+
+static const fe_t FE_P = {{ 0xFFFFFC2F, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF,
+                            0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF }};
+static const fe_t FE_N = {{ 0xD0364141, 0xBFD25E8C, 0xAF48A03B, 0xBAAEDCE6,
+                            0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF }};
+static const fe_t FE_GX = {{ 0x16F81798, 0x59F2815B, 0x2DCE28D9, 0x029BFCDB,
+                             0xCE870B07, 0x55A06295, 0xF9DCBBAC, 0x79BE667E }};
+static const fe_t FE_GY = {{ 0xFB10D4B8, 0x9C47D08F, 0xA6855419, 0xFD17B448,
+                             0x0E1108A8, 0x5DA4FBFC, 0x26A3C465, 0x483ADA77 }};
+
+// Exponents: p - 2 (inverse) and (p + 1) / 4 (square root)
+static const fe_t EXP_INV = {{ 0xFFFFFC2D, 0xFFFFFFFE, 0xFFFFFFFF, 0xFFFFFFFF,
+                               0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF }};
+static const fe_t EXP_SQRT = {{ 0xBFFFFF0C, 0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF,
+                                0xFFFFFFFF, 0xFFFFFFFF, 0xFFFFFFFF, 0x3FFFFFFF }};
+
+static void feSet(fe_t *r, uint32_t v) {
+    memset(r, 0, sizeof(*r));
+    r->v[0] = v;
+}
+
+static bool feIsZero(const fe_t *a) {
+    uint32_t acc = 0;
+    for (int i = 0; i < 8; i++) acc |= a->v[i];
+    return acc == 0;
+}
+
+static bool feEqual(const fe_t *a, const fe_t *b) {
+    return memcmp(a->v, b->v, sizeof(a->v)) == 0;
+}
+
+// Unsigned compare of two 256-bit values: -1, 0, 1
+static int u256Cmp(const fe_t *a, const fe_t *b) {
+    for (int i = 7; i >= 0; i--) {
+        if (a->v[i] != b->v[i]) return a->v[i] < b->v[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+// r = a - b, returns the borrow
+static uint32_t u256Sub(fe_t *r, const fe_t *a, const fe_t *b) {
+    int64_t borrow = 0;
+    for (int i = 0; i < 8; i++) {
+        int64_t d = (int64_t)a->v[i] - b->v[i] - borrow;
+        r->v[i] = (uint32_t)d;
+        borrow = d < 0;
+    }
+    return (uint32_t)borrow;
+}
+
+static void u256FromBytes(fe_t *r, const uint8_t in[32]) {
+    for (int i = 0; i < 8; i++) {
+        const uint8_t *p = in + 28 - 4 * i;
+        r->v[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+    }
+}
+
+static void u256ToBytes(uint8_t out[32], const fe_t *a) {
+    for (int i = 0; i < 8; i++) {
+        uint8_t *p = out + 28 - 4 * i;
+        p[0] = a->v[i] >> 24; p[1] = a->v[i] >> 16; p[2] = a->v[i] >> 8; p[3] = a->v[i];
+    }
+}
+
+// Big-endian bytes taken mod p (ElligatorSwift inputs may exceed p)
+static void feFromBytes(fe_t *r, const uint8_t in[32]) {
+    u256FromBytes(r, in);
+    if (u256Cmp(r, &FE_P) >= 0) u256Sub(r, r, &FE_P);
+}
+
+// Fold k * 2^256 into r (2^256 = 2^32 + 977 mod p), then reduce below p
+static void feFold(fe_t *r, uint64_t k) {
+    while (k) {
+        uint64_t c = (uint64_t)r->v[0] + (k & 0xFFFFFFFF) * 977;
+        r->v[0] = (uint32_t)c; c >>= 32;
+        c += (uint64_t)r->v[1] + (k >> 32) * 977 + (k & 0xFFFFFFFF);
+        r->v[1] = (uint32_t)c; c >>= 32;
+        c += (uint64_t)r->v[2] + (k >> 32);
+        r->v[2] = (uint32_t)c; c >>= 32;
+        for (int i = 3; i < 8; i++) {
+            c += r->v[i];
+            r->v[i] = (uint32_t)c;
+            c >>= 32;
+        }
+        k = c;
+    }
+    if (u256Cmp(r, &FE_P) >= 0) u256Sub(r, r, &FE_P);
+}
+
+static void feAdd(fe_t *r, const fe_t *a, const fe_t *b) {
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (uint64_t)a->v[i] + b->v[i];
+        r->v[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    feFold(r, c);
+}
+
+static void feSub(fe_t *r, const fe_t *a, const fe_t *b) {
+    if (u256Sub(r, a, b)) {
+        uint64_t c = 0;
+        for (int i = 0; i < 8; i++) {
+            c += (uint64_t)r->v[i] + FE_P.v[i];
+            r->v[i] = (uint32_t)c;
+            c >>= 32;
+        }
+    }
+}
+
+static void feNeg(fe_t *r, const fe_t *a) {
+    fe_t zero;
+    feSet(&zero, 0);
+    feSub(r, &zero, a);
+}
+
+static void feMul(fe_t *r, const fe_t *a, const fe_t *b) {
+    uint32_t t[16] = {0};
+    for (int i = 0; i < 8; i++) {
+        uint64_t c = 0;
+        for (int j = 0; j < 8; j++) {
+            c += (uint64_t)a->v[i] * b->v[j] + t[i + j];
+            t[i + j] = (uint32_t)c;
+            c >>= 32;
+        }
+        t[i + 8] = (uint32_t)c;
+    }
+
+    // low + high * (2^32 + 977)
+    uint64_t c = 0;
+    for (int i = 0; i < 8; i++) {
+        c += (uint64_t)t[i] + (uint64_t)t[8 + i] * 977 + (i ? t[7 + i] : 0);
+        r->v[i] = (uint32_t)c;
+        c >>= 32;
+    }
+    feFold(r, c + t[15]);
+}
+
+static void feSqr(fe_t *r, const fe_t *a) {
+    feMul(r, a, a);
+}
+
+static void feMulSmall(fe_t *r, const fe_t *a, uint32_t k) {
+    fe_t s;
+    feSet(&s, k);
+    feMul(r, a, &s);
+}
+
+static void fePow(fe_t *r, const fe_t *a, const fe_t *e) {
+    fe_t acc;
+    feSet(&acc, 1);
+    for (int i = 255; i >= 0; i--) {
+        feSqr(&acc, &acc);
+        if ((e->v[i / 32] >> (i % 32)) & 1) feMul(&acc, &acc, a);
+    }
+    *r = acc;
+}
+
+static void feInv(fe_t *r, const fe_t *a) {
+    fePow(r, a, &EXP_INV);
+}
+
+// Square root if a is a square
+static bool feSqrt(fe_t *r, const fe_t *a) {
+    fe_t root, check;
+    fePow(&root, a, &EXP_SQRT);
+    feSqr(&check, &root);
+    if (!feEqual(&check, a)) return false;
+    *r = root;
+    return true;
+}
+
+// x^3 + 7
+static void feCurve(fe_t *r, const fe_t *x) {
+    fe_t seven;
+    feSet(&seven, 7);
+    feSqr(r, x);
+    feMul(r, r, x);
+    feAdd(r, r, &seven);
+}
+
+static bool feIsValidX(const fe_t *x) {
+    fe_t y2, y;
+    feCurve(&y2, x);
+    return feSqrt(&y, &y2);
+}
+
+// ============================================================
+// secp256k1 Group (Jacobian coordinates)
+// ============================================================
+
+typedef struct {
+    fe_t x, y, z;   // z == 0 is the point at infinity
+} gej_t;
+
+static void gejSetAffine(gej_t *r, const fe_t *x, const fe_t *y) {
+    r->x = *x;
+    r->y = *y;
+    feSet(&r->z, 1);
+}
+
+static void gejDouble(gej_t *r, const gej_t *a) {
+    if (feIsZero(&a->z) || feIsZero(&a->y)) {
+        feSet(&r->z, 0);
+        return;
+    }
+    fe_t y2, s, m, t, y4;
+    feSqr(&y2, &a->y);
+    feMul(&s, &a->x, &y2);
+    feMulSmall(&s, &s, 4);          // S = 4 X Y^2
+    feSqr(&m, &a->x);
+    feMulSmall(&m, &m, 3);          // M = 3 X^2
+    feSqr(&y4, &y2);
+    feMulSmall(&y4, &y4, 8);        // 8 Y^4
+
+    fe_t z;
+    feMul(&z, &a->y, &a->z);
+    feAdd(&r->z, &z, &z);           // Z3 = 2 Y Z
+    feSqr(&t, &m);
+    feSub(&t, &t, &s);
+    feSub(&r->x, &t, &s);           // X3 = M^2 - 2 S
+    feSub(&t, &s, &r->x);
+    feMul(&t, &m, &t);
+    feSub(&r->y, &t, &y4);          // Y3 = M (S - X3) - 8 Y^4
+}
+
+static void gejAdd(gej_t *r, const gej_t *a, const gej_t *b) {
+    if (feIsZero(&a->z)) { *r = *b; return; }
+    if (feIsZero(&b->z)) { *r = *a; return; }
+
+    fe_t z1z1, z2z2, u1, u2, s1, s2, h, rr;
+    feSqr(&z1z1, &a->z);
+    feSqr(&z2z2, &b->z);
+    feMul(&u1, &a->x, &z2z2);
+    feMul(&u2, &b->x, &z1z1);
+    feMul(&s1, &a->y, &b->z);
+    feMul(&s1, &s1, &z2z2);
+    feMul(&s2, &b->y, &a->z);
+    feMul(&s2, &s2, &z1z1);
+    feSub(&h, &u2, &u1);
+    feSub(&rr, &s2, &s1);
+
+    if (feIsZero(&h)) {
+        if (feIsZero(&rr)) {
+            gejDouble(r, a);
+        } else {
+            feSet(&r->z, 0);
+        }
+        return;
+    }
+
+    fe_t h2, h3, u1h2, t;
+    feSqr(&h2, &h);
+    feMul(&h3, &h2, &h);
+    feMul(&u1h2, &u1, &h2);
+
+    fe_t z;
+    feMul(&z, &a->z, &b->z);
+    feMul(&r->z, &z, &h);           // Z3 = H Z1 Z2
+    feSqr(&t, &rr);
+    feSub(&t, &t, &h3);
+    feSub(&t, &t, &u1h2);
+    feSub(&r->x, &t, &u1h2);        // X3 = R^2 - H^3 - 2 U1 H^2
+    feSub(&t, &u1h2, &r->x);
+    feMul(&t, &rr, &t);
+    feMul(&s1, &s1, &h3);
+    feSub(&r->y, &t, &s1);          // Y3 = R (U1 H^2 - X3) - S1 H^3
+}
+
+// k * P (double-and-add, not constant time)
+static void gejMul(gej_t *r, const gej_t *p, const fe_t *k) {
+    gej_t acc;
+    feSet(&acc.z, 0);
+    for (int i = 255; i >= 0; i--) {
+        gejDouble(&acc, &acc);
+        if ((k->v[i / 32] >> (i % 32)) & 1) gejAdd(&acc, &acc, p);
+    }
+    *r = acc;
+}
+
+static bool gejAffine(fe_t *x, fe_t *y, const gej_t *a) {
+    if (feIsZero(&a->z)) return false;
+    fe_t zi, zi2;
+    feInv(&zi, &a->z);
+    feSqr(&zi2, &zi);
+    feMul(x, &a->x, &zi2);
+    if (y) {
+        feMul(&zi2, &zi2, &zi);
+        feMul(y, &a->y, &zi2);
+    }
+    return true;
+}
+
+// Point with this x and an even y (BIP340 lift_x)
+static bool liftX(gej_t *r, const fe_t *x) {
+    fe_t y2, y;
+    feCurve(&y2, x);
+    if (!feSqrt(&y, &y2)) return false;
+    if (y.v[0] & 1) feNeg(&y, &y);
+    gejSetAffine(r, x, &y);
+    return true;
+}
+
+static bool scalarValid(const fe_t *k) {
+    return !feIsZero(k) && u256Cmp(k, &FE_N) < 0;
+}
+
+bool sv2_xonly_pubkey(uint8_t pub[32], const uint8_t priv[32]) {
+    fe_t k, x;
+    u256FromBytes(&k, priv);
+    if (!scalarValid(&k)) return false;
+
+    gej_t g, p;
+    gejSetAffine(&g, &FE_GX, &FE_GY);
+    gejMul(&p, &g, &k);
+    if (!gejAffine(&x, NULL, &p)) return false;
+    u256ToBytes(pub, &x);
+    return true;
+}
+
+// ============================================================
+// BIP340 Verification
+// ============================================================
+
+static void taggedHash(uint8_t out[32], const char *tag, const uint8_t *msg, size_t len) {
+    uint8_t tagHash[32];
+    uint8_t prefix[64];
+    sv2_sha256(tagHash, (const uint8_t *)tag, strlen(tag), NULL, 0);
+    memcpy(prefix, tagHash, 32);
+    memcpy(prefix + 32, tagHash, 32);
+    sv2_sha256(out, prefix, sizeof(prefix), msg, len);
+}
+
+bool sv2_schnorr_verify(const uint8_t sig[SV2_SIG_LEN], const uint8_t msg[32], const uint8_t pub[32]) {
+    fe_t px, r, s, e;
+    gej_t p;
+
+    u256FromBytes(&px, pub);
+    if (u256Cmp(&px, &FE_P) >= 0 || !liftX(&p, &px)) return false;
+    u256FromBytes(&r, sig);
+    u256FromBytes(&s, sig + 32);
+    if (u256Cmp(&r, &FE_P) >= 0 || u256Cmp(&s, &FE_N) >= 0) return false;
+
+    // e = H(r || P || m) mod n
+    uint8_t buf[96];
+    uint8_t hash[32];
+    memcpy(buf, sig, 32);
+    memcpy(buf + 32, pub, 32);
+    memcpy(buf + 64, msg, 32);
+    taggedHash(hash, "BIP0340/challenge", buf, sizeof(buf));
+    u256FromBytes(&e, hash);
+    if (u256Cmp(&e, &FE_N) >= 0) u256Sub(&e, &e, &FE_N);
+
+    // R = s G - e P, computed as s G + (n - e) P
+    gej_t g, sg, ep, big;
+    gejSetAffine(&g, &FE_GX, &FE_GY);
+    gejMul(&sg, &g, &s);
+    if (!feIsZero(&e)) u256Sub(&e, &FE_N, &e);
+    gejMul(&ep, &p, &e);
+    gejAdd(&big, &sg, &ep);
+
+    fe_t rx, ry;
+    if (!gejAffine(&rx, &ry, &big)) return false;
+    return !(ry.v[0] & 1) && feEqual(&rx, &r);
+}
+
+// ============================================================
+// ElligatorSwift (BIP324)
+// ============================================================
+
+// sqrt(-3), as the BIP324 reference computes it
+static void feMinus3Sqrt(fe_t *r) {
+    fe_t three, m3;
+    feSet(&three, 3);
+    feNeg(&m3, &three);
+    feSqrt(r, &m3);
+}
+
+static void feHalf(fe_t *r, const fe_t *a) {
+    fe_t two, inv;
+    feSet(&two, 2);
+    feInv(&inv, &two);
+    feMul(r, a, &inv);
+}
+
+// x coordinate encoded by (u, t)
+static void xswiftec(fe_t *x, fe_t u, fe_t t) {
+    fe_t c, u3, t2, num, den, bigX, bigY, tmp;
+
+    if (feIsZero(&u)) feSet(&u, 1);
+    if (feIsZero(&t)) feSet(&t, 1);
+
+    feCurve(&u3, &u);                   // u^3 + 7
+    feSqr(&t2, &t);
+    feAdd(&tmp, &u3, &t2);
+    if (feIsZero(&tmp)) {
+        feAdd(&t, &t, &t);
+        feSqr(&t2, &t);
+    }
+
+    // X = (u^3 + 7 - t^2) / (2t), Y = (X + t) / (sqrt(-3) u)
+    feSub(&num, &u3, &t2);
+    feAdd(&den, &t, &t);
+    feInv(&den, &den);
+    feMul(&bigX, &num, &den);
+    feMinus3Sqrt(&c);
+    feMul(&den, &c, &u);
+    feInv(&den, &den);
+    feAdd(&tmp, &bigX, &t);
+    feMul(&bigY, &tmp, &den);
+
+    // u + 4 Y^2
+    feSqr(&tmp, &bigY);
+    feMulSmall(&tmp, &tmp, 4);
+    feAdd(x, &u, &tmp);
+    if (feIsValidX(x)) return;
+
+    // (-X / Y - u) / 2, then (X / Y - u) / 2
+    fe_t xy;
+    feInv(&tmp, &bigY);
+    feMul(&xy, &bigX, &tmp);
+    feNeg(&tmp, &xy);
+    feSub(&tmp, &tmp, &u);
+    feHalf(x, &tmp);
+    if (feIsValidX(x)) return;
+
+    feSub(&tmp, &xy, &u);
+    feHalf(x, &tmp);
+}
+
+// A t with xswiftec(u, t) == x for this case (0-7), if there is one
+static bool xswiftecInv(fe_t *t, const fe_t *x, const fe_t *u, int branch) {
+    fe_t u2, u3, s, v, tmp, tmp2;
+    feSqr(&u2, u);
+    feCurve(&u3, u);                    // u^3 + 7
+
+    if ((branch & 2) == 0) {
+        // Reject if -x - u is on the curve (it would decode first)
+        feNeg(&tmp, x);
+        feSub(&tmp, &tmp, u);
+        if (feIsValidX(&tmp)) return false;
+        v = *x;
+        // s = -(u^3 + 7) / (u^2 + u v + v^2)
+        feMul(&tmp, u, &v);
+        feAdd(&tmp, &tmp, &u2);
+        feSqr(&tmp2, &v);
+        feAdd(&tmp, &tmp, &tmp2);
+        if (feIsZero(&tmp)) return false;
+        feInv(&tmp, &tmp);
+        feMul(&s, &u3, &tmp);
+        feNeg(&s, &s);
+    } else {
+        feSub(&s, x, u);
+        if (feIsZero(&s)) return false;
+        // r = sqrt(-s (4 (u^3 + 7) + 3 s u^2))
+        fe_t r;
+        feMulSmall(&tmp, &u3, 4);
+        feMul(&tmp2, &s, &u2);
+        feMulSmall(&tmp2, &tmp2, 3);
+        feAdd(&tmp, &tmp, &tmp2);
+        feMul(&tmp, &tmp, &s);
+        feNeg(&tmp, &tmp);
+        if (!feSqrt(&r, &tmp)) return false;
+        if ((branch & 1) && feIsZero(&r)) return false;
+        // v = (r / s - u) / 2
+        feInv(&tmp, &s);
+        feMul(&tmp, &r, &tmp);
+        feSub(&tmp, &tmp, u);
+        feHalf(&v, &tmp);
+    }
+
+    fe_t w;
+    if (!feSqrt(&w, &s)) return false;
+
+    // t = +-w (u (1 -+ sqrt(-3)) / 2 + v)
+    fe_t c, one;
+    feMinus3Sqrt(&c);
+    feSet(&one, 1);
+    if (branch & 1) {
+        feAdd(&tmp, &one, &c);
+    } else {
+        feSub(&tmp, &one, &c);
+    }
+    feMul(&tmp, u, &tmp);
+    feHalf(&tmp, &tmp);
+    feAdd(&tmp, &tmp, &v);
+    feMul(t, &w, &tmp);
+
+    int sign = branch & 5;
+    if (sign == 0 || sign == 5) feNeg(t, t);
+    return true;
+}
+
+void sv2_ellswift_create(uint8_t priv[32], uint8_t pub[SV2_ELLSWIFT_LEN], sv2_rng_fn rng) {
+    fe_t k;
+    do {
+        rng(priv, 32);
+        u256FromBytes(&k, priv);
+    } while (!scalarValid(&k));
+
+    uint8_t xBytes[32];
+    fe_t x, u, t;
+    sv2_xonly_pubkey(xBytes, priv);
+    u256FromBytes(&x, xBytes);
+
+    // Random u and case until one has a preimage (a few tries on average)
+    while (true) {
+        uint8_t r[33];
+        rng(r, sizeof(r));
+        feFromBytes(&u, r);
+        if (feIsZero(&u)) continue;
+        if (xswiftecInv(&t, &x, &u, r[32] & 7)) break;
+    }
+    u256ToBytes(pub, &u);
+    u256ToBytes(pub + 32, &t);
+}
+
+void sv2_ellswift_decode(uint8_t x[32], const uint8_t pub[SV2_ELLSWIFT_LEN]) {
+    fe_t u, t, fx;
+    feFromBytes(&u, pub);
+    feFromBytes(&t, pub + 32);
+    xswiftec(&fx, u, t);
+    u256ToBytes(x, &fx);
+}
+
+bool sv2_ellswift_ecdh(uint8_t secret[32], const uint8_t priv[32], const uint8_t *theirPub,
+                       const uint8_t initiatorPub[SV2_ELLSWIFT_LEN], const uint8_t responderPub[SV2_ELLSWIFT_LEN]) {
+    uint8_t xBytes[32];
+    fe_t x, k;
+    gej_t p, shared;
+
+    sv2_ellswift_decode(xBytes, theirPub);
+    u256FromBytes(&x, xBytes);
+    u256FromBytes(&k, priv);
+    if (!scalarValid(&k) || !liftX(&p, &x)) return false;
+
+    // x-only: the sign of y does not change the shared x
+    gejMul(&shared, &p, &k);
+    if (!gejAffine(&x, NULL, &shared)) return false;
+
+    uint8_t buf[SV2_ELLSWIFT_LEN * 2 + 32];
+    memcpy(buf, initiatorPub, SV2_ELLSWIFT_LEN);
+    memcpy(buf + SV2_ELLSWIFT_LEN, responderPub, SV2_ELLSWIFT_LEN);
+    u256ToBytes(buf + SV2_ELLSWIFT_LEN * 2, &x);
+    taggedHash(secret, "bip324_ellswift_xonly_ecdh", buf, sizeof(buf));
+    return true;
+}
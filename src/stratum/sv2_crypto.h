@@ -0,0 +1,87 @@
+/*
+ * SparkMiner - Stratum V2 Crypto Primitives
+ * What the Noise NX handshake of the Stratum V2 transport needs:
+ * ChaCha20-Poly1305 (RFC 8439), HMAC-SHA256/HKDF, and secp256k1 with
+ * ElligatorSwift encoding (BIP324) and BIP340 signature verification.
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ * Sized for a handful of operations per connection, not for throughput:
+ * scalar multiplication is plain double-and-add and not constant time,
+ * which is acceptable for the single-use ephemeral key it is used with.
+ */
+
+#ifndef SV2_CRYPTO_H
+#define SV2_CRYPTO_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SV2_KEY_LEN         32      // ChaCha20 key, private keys, x coordinates
+#define SV2_MAC_LEN         16      // Poly1305 tag
+#define SV2_ELLSWIFT_LEN    64      // ElligatorSwift-encoded public key (u || t)
+#define SV2_SIG_LEN         64      // BIP340 Schnorr signature
+
+/**
+ * Source of random bytes (esp_random() on the device)
+ */
+typedef void (*sv2_rng_fn)(uint8_t *buf, size_t len);
+
+/**
+ * Plain SHA-256 digest of a || b (either may be empty)
+ * Total input must stay under 512 bytes.
+ */
+void sv2_sha256(uint8_t out[32], const uint8_t *a, size_t aLen, const uint8_t *b, size_t bLen);
+
+/**
+ * HMAC-SHA256 (RFC 2104); data at most 256 bytes
+ */
+void sv2_hmac_sha256(uint8_t out[32], const uint8_t key[32], const uint8_t *data, size_t len);
+
+/**
+ * Noise HKDF: two 32-byte outputs keyed by chainingKey
+ */
+void sv2_hkdf2(uint8_t out1[32], uint8_t out2[32], const uint8_t chainingKey[32],
+               const uint8_t *ikm, size_t ikmLen);
+
+/**
+ * ChaCha20-Poly1305 AEAD (RFC 8439), in place
+ * Encrypt writes the tag to buf[len..len+15]; decrypt takes len including
+ * the tag and returns false (buffer unchanged) if it does not verify.
+ */
+void sv2_aead_encrypt(const uint8_t key[32], const uint8_t nonce[12], const uint8_t *ad, size_t adLen,
+                      uint8_t *buf, size_t len);
+bool sv2_aead_decrypt(const uint8_t key[32], const uint8_t nonce[12], const uint8_t *ad, size_t adLen,
+                      uint8_t *buf, size_t len);
+
+/**
+ * New secp256k1 key pair: private key and ElligatorSwift-encoded public key
+ */
+void sv2_ellswift_create(uint8_t priv[32], uint8_t pub[SV2_ELLSWIFT_LEN], sv2_rng_fn rng);
+
+/**
+ * x coordinate of an ElligatorSwift-encoded public key (every 64-byte
+ * string decodes to a valid point)
+ */
+void sv2_ellswift_decode(uint8_t x[32], const uint8_t pub[SV2_ELLSWIFT_LEN]);
+
+/**
+ * BIP324 x-only ECDH: tagged hash of both encodings and the shared x
+ * @param initiatorPub Encoding of the initiator's key (ell_a64)
+ * @param responderPub Encoding of the responder's key (ell_b64)
+ * @param theirPub     Which of the two belongs to the other side
+ * @return false if the result is the point at infinity
+ */
+bool sv2_ellswift_ecdh(uint8_t secret[32], const uint8_t priv[32], const uint8_t *theirPub,
+                       const uint8_t initiatorPub[SV2_ELLSWIFT_LEN], const uint8_t responderPub[SV2_ELLSWIFT_LEN]);
+
+/**
+ * x-only public key (BIP340) of a private key
+ */
+bool sv2_xonly_pubkey(uint8_t pub[32], const uint8_t priv[32]);
+
+/**
+ * Verify a BIP340 Schnorr signature over a 32-byte message
+ */
+bool sv2_schnorr_verify(const uint8_t sig[SV2_SIG_LEN], const uint8_t msg[32], const uint8_t pub[32]);
+
+#endif // SV2_CRYPTO_H
@@ -0,0 +1,166 @@
+/*
+ * SparkMiner - Stratum V2 Noise Transport
+ * See sv2_noise.h. Symmetric state functions follow the names in the
+ * Noise specification (MixHash, MixKey, DecryptAndHash, Split).
+ */
+
+#include <string.h>
+#include "sv2_noise.h"
+
+static const char *PROTOCOL_NAME = "Noise_NX_Secp256k1+EllSwift_ChaChaPoly_SHA256";
+
+#define SV2_NOISE_CHUNK_DATA (SV2_NOISE_CHUNK - SV2_MAC_LEN)
+
+// ============================================================
+// Symmetric State
+// ============================================================
+
+// ChaChaPoly nonce: 32 zero bits, then the counter little-endian
+static void makeNonce(uint8_t nonce[12], uint64_t n) {
+    memset(nonce, 0, 4);
+    for (int i = 0; i < 8; i++) nonce[4 + i] = (uint8_t)(n >> (8 * i));
+}
+
+static void mixHash(sv2_handshake_t *hs, const uint8_t *data, size_t len) {
+    sv2_sha256(hs->h, hs->h, sizeof(hs->h), data, len);
+}
+
+static void mixKey(sv2_handshake_t *hs, const uint8_t ikm[32]) {
+    sv2_hkdf2(hs->ck, hs->k, hs->ck, ikm, 32);
+    hs->n = 0;
+}
+
+// Decrypt with h as associated data, then hash the ciphertext
+static bool decryptAndHash(sv2_handshake_t *hs, uint8_t *buf, size_t len) {
+    uint8_t nonce[12];
+    uint8_t ad[32];
+    memcpy(ad, hs->h, sizeof(ad));
+    mixHash(hs, buf, len);
+
+    makeNonce(nonce, hs->n++);
+    return sv2_aead_decrypt(hs->k, nonce, ad, sizeof(ad), buf, len);
+}
+
+// ============================================================
+// Handshake
+// ============================================================
+
+void sv2_noise_start(sv2_handshake_t *hs, uint8_t act1[SV2_NOISE_ACT1_LEN], sv2_rng_fn rng) {
+    // Name is over 32 bytes, so h starts as its hash; empty prologue
+    sv2_sha256(hs->h, (const uint8_t *)PROTOCOL_NAME, strlen(PROTOCOL_NAME), NULL, 0);
+    memcpy(hs->ck, hs->h, sizeof(hs->ck));
+    mixHash(hs, NULL, 0);
+    memset(hs->k, 0, sizeof(hs->k));
+    hs->n = 0;
+
+    // -> e, with an empty (unencrypted) payload
+    sv2_ellswift_create(hs->ePriv, hs->ePub, rng);
+    mixHash(hs, hs->ePub, SV2_ELLSWIFT_LEN);
+    mixHash(hs, NULL, 0);
+    memcpy(act1, hs->ePub, SV2_NOISE_ACT1_LEN);
+}
+
+static uint32_t readLe32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+sv2_noise_result_t sv2_noise_finish(sv2_handshake_t *hs, const uint8_t act2[SV2_NOISE_ACT2_LEN],
+                                    const uint8_t *authorityKey, uint32_t now,
+                                    sv2_cipher_t *tx, sv2_cipher_t *rx) {
+    uint8_t msg[SV2_NOISE_ACT2_LEN];
+    uint8_t secret[32];
+    memcpy(msg, act2, sizeof(msg));
+    const uint8_t *re = msg;
+    uint8_t *rs = msg + SV2_ELLSWIFT_LEN;
+    uint8_t *cert = rs + SV2_ELLSWIFT_LEN + SV2_MAC_LEN;
+
+    // <- e, ee
+    mixHash(hs, re, SV2_ELLSWIFT_LEN);
+    if (!sv2_ellswift_ecdh(secret, hs->ePriv, re, hs->ePub, re)) return SV2_NOISE_BAD_MESSAGE;
+    mixKey(hs, secret);
+
+    // s, es
+    if (!decryptAndHash(hs, rs, SV2_ELLSWIFT_LEN + SV2_MAC_LEN)) return SV2_NOISE_BAD_MESSAGE;
+    if (!sv2_ellswift_ecdh(secret, hs->ePriv, rs, hs->ePub, rs)) return SV2_NOISE_BAD_MESSAGE;
+    mixKey(hs, secret);
+
+    // Certificate payload: the authority signs version, validity and the static key
+    if (!decryptAndHash(hs, cert, SV2_CERT_LEN + SV2_MAC_LEN)) return SV2_NOISE_BAD_MESSAGE;
+    if (authorityKey) {
+        uint8_t certMsg[10 + 32];
+        uint8_t digest[32];
+        memcpy(certMsg, cert, 10);
+        sv2_ellswift_decode(certMsg + 10, rs);
+        sv2_sha256(digest, certMsg, sizeof(certMsg), NULL, 0);
+        if (!sv2_schnorr_verify(cert + 10, digest, authorityKey)) return SV2_NOISE_BAD_SIGNATURE;
+    }
+    if (now) {
+        uint32_t validFrom = readLe32(cert + 2);
+        uint32_t notValidAfter = readLe32(cert + 6);
+        if (now < validFrom || now > notValidAfter) return SV2_NOISE_EXPIRED;
+    }
+
+    // Split: initiator sends with the first key
+    sv2_hkdf2(tx->key, rx->key, hs->ck, NULL, 0);
+    tx->nonce = 0;
+    rx->nonce = 0;
+    memset(hs->ePriv, 0, sizeof(hs->ePriv));
+    return SV2_NOISE_OK;
+}
+
+// ============================================================
+// Transport Frames
+// ============================================================
+
+size_t sv2_noise_frame_len(size_t payloadLen) {
+    size_t chunks = (payloadLen + SV2_NOISE_CHUNK_DATA - 1) / SV2_NOISE_CHUNK_DATA;
+    return SV2_NOISE_HEADER_LEN + payloadLen + chunks * SV2_MAC_LEN;
+}
+
+static void encryptChunk(sv2_cipher_t *c, uint8_t *buf, size_t len) {
+    uint8_t nonce[12];
+    makeNonce(nonce, c->nonce++);
+    sv2_aead_encrypt(c->key, nonce, NULL, 0, buf, len);
+}
+
+static bool decryptChunk(sv2_cipher_t *c, uint8_t *buf, size_t len) {
+    uint8_t nonce[12];
+    makeNonce(nonce, c->nonce++);
+    return sv2_aead_decrypt(c->key, nonce, NULL, 0, buf, len);
+}
+
+size_t sv2_noise_seal(sv2_cipher_t *tx, uint8_t *out, const uint8_t *frame, size_t len) {
+    memcpy(out, frame, SV2_HEADER_LEN);
+    encryptChunk(tx, out, SV2_HEADER_LEN);
+    size_t written = SV2_NOISE_HEADER_LEN;
+
+    const uint8_t *payload = frame + SV2_HEADER_LEN;
+    size_t remaining = len - SV2_HEADER_LEN;
+    while (remaining > 0) {
+        size_t n = remaining < SV2_NOISE_CHUNK_DATA ? remaining : SV2_NOISE_CHUNK_DATA;
+        memcpy(out + written, payload, n);
+        encryptChunk(tx, out + written, n);
+        written += n + SV2_MAC_LEN;
+        payload += n;
+        remaining -= n;
+    }
+    return written;
+}
+
+bool sv2_noise_open_header(sv2_cipher_t *rx, uint8_t header[SV2_NOISE_HEADER_LEN]) {
+    return decryptChunk(rx, header, SV2_NOISE_HEADER_LEN);
+}
+
+bool sv2_noise_open_payload(sv2_cipher_t *rx, uint8_t *buf, size_t payloadLen) {
+    uint8_t *in = buf;
+    uint8_t *out = buf;
+    while (payloadLen > 0) {
+        size_t n = payloadLen < SV2_NOISE_CHUNK_DATA ? payloadLen : SV2_NOISE_CHUNK_DATA;
+        if (!decryptChunk(rx, in, n + SV2_MAC_LEN)) return false;
+        memmove(out, in, n);
+        in += n + SV2_MAC_LEN;
+        out += n;
+        payloadLen -= n;
+    }
+    return true;
+}
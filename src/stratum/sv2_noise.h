@@ -0,0 +1,94 @@
+/*
+ * SparkMiner - Stratum V2 Noise Transport
+ * Initiator side of Noise_NX_Secp256k1+EllSwift_ChaChaPoly_SHA256, the
+ * handshake and frame encryption the Stratum V2 spec puts in front of
+ * every connection, plus the pool certificate check (a BIP340 signature
+ * by the pool's authority key over the static key it presents).
+ *
+ * Pure C (no Arduino or ESP-IDF calls) so the native test build can run it.
+ */
+
+#ifndef SV2_NOISE_H
+#define SV2_NOISE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "sv2_crypto.h"
+
+#define SV2_NOISE_ACT1_LEN  SV2_ELLSWIFT_LEN                        // -> e
+#define SV2_CERT_LEN        74                                      // version, valid_from, not_valid_after, signature
+#define SV2_NOISE_ACT2_LEN  (SV2_ELLSWIFT_LEN * 2 + SV2_CERT_LEN + SV2_MAC_LEN * 2)  // <- e, ee, s, es, cert
+#define SV2_HEADER_LEN      6                                       // extension_type, msg_type, msg_length
+#define SV2_NOISE_HEADER_LEN (SV2_HEADER_LEN + SV2_MAC_LEN)         // Encrypted frame header
+#define SV2_NOISE_CHUNK     65535                                   // Largest encrypted payload chunk (with MAC)
+
+/**
+ * One direction of the transport: key from the handshake split and the
+ * per-message nonce
+ */
+typedef struct {
+    uint8_t key[32];
+    uint64_t nonce;
+} sv2_cipher_t;
+
+/**
+ * Handshake state between the two acts
+ */
+typedef struct {
+    uint8_t ck[32];                     // Chaining key
+    uint8_t h[32];                      // Handshake hash
+    uint8_t k[32];                      // Current handshake key (after the first MixKey)
+    uint64_t n;
+    uint8_t ePriv[32];                  // Ephemeral key
+    uint8_t ePub[SV2_ELLSWIFT_LEN];
+} sv2_handshake_t;
+
+typedef enum {
+    SV2_NOISE_OK = 0,
+    SV2_NOISE_BAD_MESSAGE,              // MAC mismatch or invalid key
+    SV2_NOISE_BAD_SIGNATURE,            // Static key not signed by the authority key
+    SV2_NOISE_EXPIRED                   // Certificate outside its validity window
+} sv2_noise_result_t;
+
+/**
+ * Start a handshake: new ephemeral key, first message to send
+ */
+void sv2_noise_start(sv2_handshake_t *hs, uint8_t act1[SV2_NOISE_ACT1_LEN], sv2_rng_fn rng);
+
+/**
+ * Process the responder's reply and derive the transport keys
+ * @param authorityKey x-only pool authority key; NULL skips the signature check
+ * @param now          Unix time for the validity window; 0 skips it
+ * @param tx, rx       Ciphers for sending and receiving (untouched on failure)
+ */
+sv2_noise_result_t sv2_noise_finish(sv2_handshake_t *hs, const uint8_t act2[SV2_NOISE_ACT2_LEN],
+                                    const uint8_t *authorityKey, uint32_t now,
+                                    sv2_cipher_t *tx, sv2_cipher_t *rx);
+
+/**
+ * Encrypted size of a frame whose payload is payloadLen bytes
+ * (header chunk plus payload chunks, each with its MAC)
+ */
+size_t sv2_noise_frame_len(size_t payloadLen);
+
+/**
+ * Encrypt a plaintext frame (6-byte header + payload) into out
+ * @param out Room for sv2_noise_frame_len(len - SV2_HEADER_LEN) bytes
+ * @return Bytes written
+ */
+size_t sv2_noise_seal(sv2_cipher_t *tx, uint8_t *out, const uint8_t *frame, size_t len);
+
+/**
+ * Decrypt an encrypted frame header in place; the plaintext header is
+ * left in the first SV2_HEADER_LEN bytes
+ */
+bool sv2_noise_open_header(sv2_cipher_t *rx, uint8_t header[SV2_NOISE_HEADER_LEN]);
+
+/**
+ * Decrypt a frame payload in place; plaintext is compacted to the front
+ * @param buf        sv2_noise_frame_len(payloadLen) - SV2_NOISE_HEADER_LEN encrypted bytes
+ * @param payloadLen msg_length from the decrypted header
+ */
+bool sv2_noise_open_payload(sv2_cipher_t *rx, uint8_t *buf, size_t payloadLen);
+
+#endif // SV2_NOISE_H
@@ -0,0 +1,160 @@
+/*
+ * SparkMiner - Host Micro-Benchmarks
+ * Runs on the host: pio test -e native-bench
+ *
+ * Times the software hashing paths and job building on the build machine.
+ * Numbers are only comparable between runs on the same host; use them to
+ * spot regressions in miner_sha256.cpp / miner_work.cpp before flashing.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "mining/miner_sha256.h"
+#include "mining/miner_work.h"
+
+#define BENCH_HASHES    2000000     // Nonces per hashing benchmark
+#define BENCH_JOBS      20000       // Job builds per job benchmark
+#define BENCH_BRANCHES  12          // Merkle depth of a busy mainnet block
+
+static const char *BENCH_HEADER =
+    "01000000" "81cd02ab7e569e8bcd9317e2fe99f2de44d49ab2b8851ba4a308000000000000"
+    "e320b6c2fffc8d750423db8b1eb942ae710e951ed797f7affc8892b0f1fc122b"
+    "c7f5d74d" "f2b9441a" "42a14695";
+
+static block_header_t s_header;
+static sha256_hash_t s_midstate;
+static miner_sha256_bake_t s_bake;
+
+// Defeats dead-code elimination of the hash loops
+static volatile uint32_t s_sink;
+
+typedef std::chrono::steady_clock bench_clock_t;
+
+static double elapsedUs(bench_clock_t::time_point start) {
+    return std::chrono::duration<double, std::micro>(bench_clock_t::now() - start).count();
+}
+
+static void reportRate(const char *name, double hashes, double us) {
+    printf("[BENCH] %-16s %10.1f kH/s\n", name, hashes * 1000.0 / us);
+}
+
+static void reportCost(const char *name, double runs, double us) {
+    printf("[BENCH] %-16s %10.3f us\n", name, us / runs);
+}
+
+void setUp() {
+    hexToBytes((uint8_t *)&s_header, BENCH_HEADER, 160);
+    miner_sha256_midstate(&s_midstate, &s_header);
+    miner_sha256_bake(&s_bake, &s_midstate, &s_header);
+}
+
+void tearDown() {}
+
+static void bench_header() {
+    sha256_hash_t ctx;
+    uint32_t hits = 0;
+    auto start = bench_clock_t::now();
+    for (uint32_t n = 0; n < BENCH_HASHES; n++) {
+        s_header.nonce = n;
+        hits += miner_sha256_header(&s_midstate, &ctx, &s_header);
+    }
+    reportRate("header", BENCH_HASHES, elapsedUs(start));
+    s_sink = hits;
+}
+
+static void bench_header_baked() {
+    sha256_hash_t ctx;
+    uint32_t hits = 0;
+    auto start = bench_clock_t::now();
+    for (uint32_t n = 0; n < BENCH_HASHES; n++) {
+        hits += miner_sha256_header_baked(&s_bake, &ctx, n);
+    }
+    reportRate("header_baked", BENCH_HASHES, elapsedUs(start));
+    s_sink = hits;
+}
+
+static void bench_header_fast() {
+    sha256_hash_t ctx;
+    uint32_t hits = 0;
+    auto start = bench_clock_t::now();
+    for (uint32_t n = 0; n < BENCH_HASHES; n++) {
+        hits += miner_sha256_header_fast(&s_bake, &ctx, n);
+    }
+    reportRate("header_fast", BENCH_HASHES, elapsedUs(start));
+    s_sink = hits;
+}
+
+static void bench_header_batch() {
+    uint32_t hits = 0;
+    auto start = bench_clock_t::now();
+    for (uint32_t n = 0; n < BENCH_HASHES; n += MINER_SHA256_BATCH_MAX) {
+        hits |= miner_sha256_header_batch(&s_bake, n, MINER_SHA256_BATCH_MAX);
+    }
+    reportRate("header_batch", BENCH_HASHES, elapsedUs(start));
+    s_sink = hits;
+}
+
+static void bench_midstate_bake() {
+    sha256_hash_t midstate;
+    miner_sha256_bake_t bake;
+    auto start = bench_clock_t::now();
+    for (uint32_t i = 0; i < BENCH_JOBS; i++) {
+        s_header.version = i;
+        miner_sha256_midstate(&midstate, &s_header);
+        miner_sha256_bake(&bake, &midstate, &s_header);
+    }
+    reportCost("midstate+bake", BENCH_JOBS, elapsedUs(start));
+    s_sink = bake.state[0];
+}
+
+static void bench_job_build() {
+    // Typical pool coinbase sizes: ~110 byte coinb1, ~200 byte coinb2
+    static char coinb1[221], coinb2[401], branch[65];
+    memset(coinb1, 'a', 220);
+    memset(coinb2, 'b', 400);
+
+    static mining_job_bin_t job;
+    miner_coinbase_t cb;
+    uint8_t hash[32], root[32];
+
+    // Once per notify, in the stratum parser
+    auto start = bench_clock_t::now();
+    for (uint32_t i = 0; i < BENCH_JOBS; i++) {
+        memset(&job, 0, sizeof(job));
+        decodeJobCoinbase(&job, coinb1, "0badf00d", 4, coinb2);
+        for (int b = 0; b < BENCH_BRANCHES; b++) {
+            memset(branch, '0' + (b % 10), 64);
+            decodeJobBranch(&job, branch);
+        }
+    }
+    reportCost("notify_decode", BENCH_JOBS, elapsedUs(start));
+
+    // Once per job, in miner_start_job()
+    start = bench_clock_t::now();
+    for (uint32_t i = 0; i < BENCH_JOBS; i++) {
+        buildCoinbase(&cb, &job, i);
+    }
+    reportCost("coinbase_copy", BENCH_JOBS, elapsedUs(start));
+
+    // Per-roll cost: what rolling extranonce2 pays for a fresh merkle root
+    start = bench_clock_t::now();
+    for (uint32_t i = 0; i < BENCH_JOBS; i++) {
+        createCoinbaseHash(hash, &cb, i);
+        calculateMerkleRoot(root, hash, &cb);
+    }
+    reportCost("merkle_root", BENCH_JOBS, elapsedUs(start));
+    s_sink = root[0];
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(bench_header);
+    RUN_TEST(bench_header_baked);
+    RUN_TEST(bench_header_fast);
+    RUN_TEST(bench_header_batch);
+    RUN_TEST(bench_midstate_bake);
+    RUN_TEST(bench_job_build);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+/*
+ * SparkMiner - Software SHA-256 Known-Answer Tests
+ * Runs on the host: pio test -e native
+ *
+ * Headers are real mainnet blocks; expected hashes are the block hashes
+ * as shown by block explorers (byte-reversed digest).
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "mining/miner_sha256.h"
+#include "mining/miner_work.h"
+
+// Genesis block (height 0)
+static const char *GENESIS_HEADER =
+    "01000000" "0000000000000000000000000000000000000000000000000000000000000000"
+    "3ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a"
+    "29ab5f49" "ffff001d" "1dac2b7c";
+static const char *GENESIS_HASH = "000000000019d6689c085ae165831e934ff763ae46a2a6c172b3f1b60a8ce26f";
+
+// Block 125552
+static const char *B125552_HEADER =
+    "01000000" "81cd02ab7e569e8bcd9317e2fe99f2de44d49ab2b8851ba4a308000000000000"
+    "e320b6c2fffc8d750423db8b1eb942ae710e951ed797f7affc8892b0f1fc122b"
+    "c7f5d74d" "f2b9441a" "42a14695";
+static const char *B125552_HASH = "00000000000000001e8d6829a8a21adc5d38d0a473b144b6765798e61f98bd1d";
+
+static void loadHeader(block_header_t *hb, const char *hex) {
+    hexToBytes((uint8_t *)hb, hex, 160);
+}
+
+// Explorer hashes are the digest read as a big-endian number
+static void assertBlockHash(const char *expectedHex, const sha256_hash_t *ctx) {
+    uint8_t expected[32];
+    hexToBytes(expected, expectedHex, 64);
+    for (int i = 0; i < 32; i++) {
+        TEST_ASSERT_EQUAL_HEX8_MESSAGE(expected[31 - i], ctx->bytes[i], "block hash byte");
+    }
+}
+
+// SHA message-word nonce, as counted by the mining kernels
+static uint32_t shaNonce(const block_header_t *hb) {
+    return __builtin_bswap32(hb->nonce);
+}
+
+void setUp() {}
+void tearDown() {}
+
+static void test_sha256_nist_abc() {
+    // FIPS 180-2 example: SHA-256("abc")
+    static const char *expectedHex = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+    uint8_t msg[3] = {'a', 'b', 'c'};
+    uint8_t expected[32];
+    sha256_hash_t ctx;
+    miner_sha256(&ctx, msg, sizeof(msg));
+    hexToBytes(expected, expectedHex, 64);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, ctx.bytes, 32);
+}
+
+static void test_sha256_double_genesis() {
+    block_header_t hb;
+    sha256_hash_t first, second;
+    loadHeader(&hb, GENESIS_HEADER);
+    miner_sha256(&first, (uint8_t *)&hb, 80);
+    miner_sha256(&second, first.bytes, 32);
+    assertBlockHash(GENESIS_HASH, &second);
+}
+
+static void test_header_genesis() {
+    block_header_t hb;
+    sha256_hash_t midstate, ctx;
+    loadHeader(&hb, GENESIS_HEADER);
+    miner_sha256_midstate(&midstate, &hb);
+    TEST_ASSERT_TRUE(miner_sha256_header(&midstate, &ctx, &hb));
+    assertBlockHash(GENESIS_HASH, &ctx);
+}
+
+static void test_header_block_125552() {
+    block_header_t hb;
+    sha256_hash_t midstate, ctx;
+    loadHeader(&hb, B125552_HEADER);
+    miner_sha256_midstate(&midstate, &hb);
+    TEST_ASSERT_TRUE(miner_sha256_header(&midstate, &ctx, &hb));
+    assertBlockHash(B125552_HASH, &ctx);
+}
+
+static void test_header_rejects_neighbour() {
+    block_header_t hb;
+    sha256_hash_t midstate, ctx;
+    loadHeader(&hb, GENESIS_HEADER);
+    miner_sha256_midstate(&midstate, &hb);
+    hb.nonce = __builtin_bswap32(shaNonce(&hb) + 1);
+    TEST_ASSERT_FALSE(miner_sha256_header(&midstate, &ctx, &hb));
+}
+
+static void test_baked_and_fast_match_reference() {
+    block_header_t hb;
+    sha256_hash_t midstate, ref, baked, fast;
+    miner_sha256_bake_t bake;
+    loadHeader(&hb, B125552_HEADER);
+    miner_sha256_midstate(&midstate, &hb);
+    miner_sha256_bake(&bake, &midstate, &hb);
+
+    uint32_t start = shaNonce(&hb) - 50000;
+    for (uint32_t n = start; n != start + 100000; n++) {
+        hb.nonce = __builtin_bswap32(n);
+        bool refHit = miner_sha256_header(&midstate, &ref, &hb);
+        TEST_ASSERT_EQUAL(refHit, miner_sha256_header_baked(&bake, &baked, n));
+        TEST_ASSERT_EQUAL(refHit, miner_sha256_header_fast(&bake, &fast, n));
+        // Digests are only complete past the early 16-bit reject
+        if (refHit) {
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(ref.bytes, baked.bytes, 32);
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(ref.bytes, fast.bytes, 32);
+        }
+    }
+}
+
+static void test_batch_finds_genesis_nonce() {
+    block_header_t hb;
+    sha256_hash_t midstate;
+    miner_sha256_bake_t bake;
+    loadHeader(&hb, GENESIS_HEADER);
+    miner_sha256_midstate(&midstate, &hb);
+    miner_sha256_bake(&bake, &midstate, &hb);
+
+    // Nearest candidates are far apart, so only the block's own nonce hits
+    uint32_t nonce = shaNonce(&hb);
+    TEST_ASSERT_EQUAL_HEX32(1u << 5, miner_sha256_header_batch(&bake, nonce - 5, MINER_SHA256_BATCH_MAX));
+    TEST_ASSERT_EQUAL_HEX32(1u, miner_sha256_header_batch(&bake, nonce, 1));
+    TEST_ASSERT_EQUAL_HEX32(0, miner_sha256_header_batch(&bake, nonce + 1, MINER_SHA256_BATCH_MAX));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_sha256_nist_abc);
+    RUN_TEST(test_sha256_double_genesis);
+    RUN_TEST(test_header_genesis);
+    RUN_TEST(test_header_block_125552);
+    RUN_TEST(test_header_rejects_neighbour);
+    RUN_TEST(test_baked_and_fast_match_reference);
+    RUN_TEST(test_batch_finds_genesis_nonce);
+    return UNITY_END();
+}
@@ -0,0 +1,224 @@
+/*
+ * SparkMiner - Stratum Line Parser Tests
+ * Runs on the host: pio test -e native
+ *
+ * Decoded notifies are checked field by field against the reference
+ * decoders in miner_work.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "mining/miner_work.h"
+#include "stratum/stratum_parse.h"
+
+// Genesis coinbase split around the extranonce, as in test_work
+static const char *COINB1 =
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4d04ffff001d01"
+    "04455468652054696d65732030332f4a616e2f3230";
+static const char *EXTRANONCE1 = "30392043";
+static const char *COINB2 =
+    "656c6c6f72206f6e206272696e6b206f66207365636f6e64206261696c6f757420666f722062616e6b73ffffffff0100"
+    "f2052a01000000434104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6bc3f4cef"
+    "38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac00000000";
+static const char *PREVHASH = "876dd0a3ef4a2816ffd1c12ab649825a958b0ff3bb3d6f3e1250f13ddbf0148c";
+static const char *BRANCH0 = "c40297f730dd7b5a99567eb8d27b78758f607507c52292d02d4031895b52f2ff";
+static const char *BRANCH1 = "49aef42d78e3e9999c9e6ec9e1dddd6cb880bf3b076a03be1318ca789089308e";
+
+static char s_line[2048];
+static mining_job_bin_t s_job;
+static mining_job_bin_t s_ref;
+
+void setUp() {}
+void tearDown() {}
+
+static const char *notifyLine(const char *prefix, const char *coinb1, const char *branches, const char *tail) {
+    snprintf(s_line, sizeof(s_line),
+        "{%s\"params\":[\"1f3a\",\"%s\",\"%s\",\"%s\",[%s],\"20000000\",\"1d00ffff\",\"495fab29\"%s]%s}",
+        prefix, PREVHASH, coinb1, COINB2, branches, tail,
+        prefix[0] ? "" : ",\"id\":null,\"method\":\"mining.notify\"");
+    return s_line;
+}
+
+static void assertMatchesReference(const mining_job_bin_t *job, bool clean) {
+    memset(&s_ref, 0, sizeof(s_ref));
+    strcpy(s_ref.jobId, "1f3a");
+    TEST_ASSERT_TRUE(decodeJobPrevHash(&s_ref, PREVHASH));
+    TEST_ASSERT_TRUE(decodeJobCoinbase(&s_ref, COINB1, EXTRANONCE1, 4, COINB2));
+    TEST_ASSERT_TRUE(decodeJobBranch(&s_ref, BRANCH0));
+    TEST_ASSERT_TRUE(decodeJobBranch(&s_ref, BRANCH1));
+    s_ref.version = 0x20000000;
+    s_ref.nbits = 0x1d00ffff;
+    s_ref.ntime = 0x495fab29;
+    s_ref.cleanJobs = clean;
+
+    TEST_ASSERT_EQUAL_STRING(s_ref.jobId, job->jobId);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.prevHash, job->prevHash, 32);
+    TEST_ASSERT_EQUAL(s_ref.coinbaseLen, job->coinbaseLen);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.coinbase, job->coinbase, s_ref.coinbaseLen);
+    TEST_ASSERT_EQUAL(s_ref.extraNonce2Offset, job->extraNonce2Offset);
+    TEST_ASSERT_EQUAL(s_ref.extraNonce2Size, job->extraNonce2Size);
+    TEST_ASSERT_EQUAL(s_ref.merkleBranchCount, job->merkleBranchCount);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.merkleBranches, job->merkleBranches, 2 * 32);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.version, job->version);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.nbits, job->nbits);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.ntime, job->ntime);
+    TEST_ASSERT_EQUAL(s_ref.cleanJobs, job->cleanJobs);
+}
+
+static stratum_line_kind_t parse(const char *line, stratum_line_t *msg) {
+    return stratum_parse_line(line, msg, &s_job, EXTRANONCE1, 4);
+}
+
+static void test_notify_decodes_like_reference() {
+    stratum_line_t msg;
+    char branches[160];
+    snprintf(branches, sizeof(branches), "\"%s\",\"%s\"", BRANCH0, BRANCH1);
+
+    // Method first, as most pools send it
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY,
+        parse(notifyLine("\"id\":null,\"method\":\"mining.notify\",", COINB1, branches, ",true"), &msg));
+    assertMatchesReference(&s_job, true);
+
+    // Params before method, no clean_jobs
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY, parse(notifyLine("", COINB1, branches, ""), &msg));
+    assertMatchesReference(&s_job, false);
+
+    // Whitespace between tokens
+    snprintf(branches, sizeof(branches), " \"%s\" , \"%s\" ", BRANCH0, BRANCH1);
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY,
+        parse(notifyLine(" \"method\" : \"mining.notify\" , ", COINB1, branches, ", false, 7"), &msg));
+    assertMatchesReference(&s_job, false);
+}
+
+static void test_notify_rejects_bad_fields() {
+    stratum_line_t msg;
+    char branches[1200] = "";
+    const char *head = "\"method\":\"mining.notify\",";
+
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(notifyLine(head, "abc", "", ""), &msg));  // Odd hex
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(notifyLine(head, "zz", "", ""), &msg));   // Not hex
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(notifyLine(head, COINB1, "\"00\"", ""), &msg));
+
+    // One branch over STRATUM_MAX_MERKLE
+    for (int i = 0; i <= STRATUM_MAX_MERKLE; i++) {
+        if (i) strcat(branches, ",");
+        strcat(branches, "\"");
+        strcat(branches, BRANCH0);
+        strcat(branches, "\"");
+    }
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(notifyLine(head, COINB1, branches, ""), &msg));
+
+    // Oversized coinbase
+    static char big[STRATUM_COINBASE_LEN * 2 + 1];
+    memset(big, 'a', STRATUM_COINBASE_LEN * 2);
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(notifyLine(head, big, "", ""), &msg));
+
+    // Missing ntime, missing params
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse(
+        "{\"method\":\"mining.notify\",\"params\":[\"1\",\"00\"]}", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_BAD_NOTIFY, parse("{\"id\":null,\"method\":\"mining.notify\"}", &msg));
+
+    // Classify-only never touches the job slot
+    memset(&s_job, 0x5a, sizeof(s_job));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY,
+        stratum_parse_line(notifyLine(head, COINB1, "", ""), &msg, NULL, EXTRANONCE1, 4));
+    TEST_ASSERT_EQUAL_HEX8(0x5a, s_job.jobId[0]);
+}
+
+static void test_notify_formats_for_downstream() {
+    stratum_line_t msg;
+    char branches[160];
+    snprintf(branches, sizeof(branches), "\"%s\",\"%s\"", BRANCH0, BRANCH1);
+
+    // Upstream job with the proxy's carved 00 byte after extranonce1
+    char en1[16];
+    snprintf(en1, sizeof(en1), "%s00", EXTRANONCE1);
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY, stratum_parse_line(
+        notifyLine("\"method\":\"mining.notify\",", COINB1, branches, ",false"), &msg, &s_ref, en1, 3));
+
+    // Downstream miner 07: coinb1 stops before the carved byte, its extranonce1 fills it
+    static char out[2048];
+    size_t len = stratum_format_notify(out, sizeof(out), &s_ref, s_ref.extraNonce2Offset - 1, true);
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_EQUAL(strlen(out), len);
+    TEST_ASSERT_EQUAL('\n', out[len - 1]);
+
+    TEST_ASSERT_EQUAL(STRATUM_LINE_NOTIFY, stratum_parse_line(out, &msg, &s_job, "07", 3));
+    TEST_ASSERT_EQUAL_STRING(s_ref.jobId, s_job.jobId);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.prevHash, s_job.prevHash, 32);
+    TEST_ASSERT_EQUAL(s_ref.coinbaseLen, s_job.coinbaseLen);
+    TEST_ASSERT_EQUAL(s_ref.extraNonce2Offset, s_job.extraNonce2Offset);
+    TEST_ASSERT_EQUAL_HEX8(0x07, s_job.coinbase[s_job.extraNonce2Offset - 1]);
+    s_job.coinbase[s_job.extraNonce2Offset - 1] = 0x00;
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.coinbase, s_job.coinbase, s_ref.coinbaseLen);
+    TEST_ASSERT_EQUAL(2, s_job.merkleBranchCount);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(s_ref.merkleBranches, s_job.merkleBranches, 2 * 32);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.version, s_job.version);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.nbits, s_job.nbits);
+    TEST_ASSERT_EQUAL_HEX32(s_ref.ntime, s_job.ntime);
+    TEST_ASSERT_TRUE(s_job.cleanJobs);
+
+    // Too small a buffer, or a coinb1 reaching past extranonce1
+    TEST_ASSERT_EQUAL(0, stratum_format_notify(out, 64, &s_ref, s_ref.extraNonce2Offset - 1, true));
+    TEST_ASSERT_EQUAL(0, stratum_format_notify(out, sizeof(out), &s_ref, s_ref.extraNonce2Offset + 1, true));
+}
+
+static void test_set_difficulty() {
+    stratum_line_t msg;
+    TEST_ASSERT_EQUAL(STRATUM_LINE_DIFFICULTY,
+        parse("{\"id\":null,\"method\":\"mining.set_difficulty\",\"params\":[512]}", &msg));
+    TEST_ASSERT_EQUAL_DOUBLE(512.0, msg.difficulty);
+
+    TEST_ASSERT_EQUAL(STRATUM_LINE_DIFFICULTY,
+        parse("{\"params\": [ 1.4e-3 ], \"method\": \"mining.set_difficulty\"}", &msg));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0014, msg.difficulty);
+
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER,
+        parse("{\"method\":\"mining.set_difficulty\",\"params\":[\"x\"]}", &msg));
+}
+
+static void test_share_responses() {
+    stratum_line_t msg;
+    TEST_ASSERT_EQUAL(STRATUM_LINE_RESULT, parse("{\"id\":12,\"result\":true,\"error\":null}", &msg));
+    TEST_ASSERT_EQUAL_HEX32(12, msg.id);
+    TEST_ASSERT_TRUE(msg.result);
+    TEST_ASSERT_EQUAL_STRING("", msg.reason);
+
+    TEST_ASSERT_EQUAL(STRATUM_LINE_RESULT,
+        parse("{\"error\":[23,\"Low difficulty share\",null],\"id\":4000000000,\"result\":null}", &msg));
+    TEST_ASSERT_EQUAL_HEX32(4000000000u, msg.id);
+    TEST_ASSERT_FALSE(msg.result);
+    TEST_ASSERT_EQUAL_STRING("Low difficulty share", msg.reason);
+
+    // Reasons are cut to fit
+    char line[256];
+    snprintf(line, sizeof(line), "{\"id\":5,\"result\":false,\"error\":[21,\"%0100d\",null]}", 0);
+    TEST_ASSERT_EQUAL(STRATUM_LINE_RESULT, parse(line, &msg));
+    TEST_ASSERT_EQUAL(STRATUM_REASON_LEN - 1, strlen(msg.reason));
+}
+
+static void test_other_lines_fall_back() {
+    stratum_line_t msg;
+    // Handshake results, other methods, no id, broken JSON
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER,
+        parse("{\"id\":1,\"result\":[[[\"mining.notify\",\"ae6812eb\"]],\"08000002\",4],\"error\":null}", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER,
+        parse("{\"id\":null,\"method\":\"mining.set_version_mask\",\"params\":[\"1fffe000\"]}", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER, parse("{\"id\":null,\"result\":true}", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER, parse("{\"id\":3,\"result\":tr", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER, parse("{\"id\":3,\"result\":true", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER, parse("[1,2]", &msg));
+    TEST_ASSERT_EQUAL(STRATUM_LINE_OTHER, parse("", &msg));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_notify_decodes_like_reference);
+    RUN_TEST(test_notify_rejects_bad_fields);
+    RUN_TEST(test_notify_formats_for_downstream);
+    RUN_TEST(test_set_difficulty);
+    RUN_TEST(test_share_responses);
+    RUN_TEST(test_other_lines_fall_back);
+    return UNITY_END();
+}
@@ -0,0 +1,371 @@
+/*
+ * SparkMiner - Stratum V2 Tests
+ * Runs on the host: pio test -e native
+ *
+ * Crypto primitives against published vectors (RFC 4231, RFC 8439,
+ * BIP340), the message codec, and a complete Noise handshake against a
+ * responder assembled here from the same primitives.
+ */
+
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "stratum/sv2_crypto.h"
+#include "stratum/sv2_noise.h"
+#include "stratum/sv2_codec.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void unhex(uint8_t *out, const char *hex) {
+    for (size_t i = 0; hex[2 * i]; i++) {
+        unsigned v;
+        sscanf(hex + 2 * i, "%2x", &v);
+        out[i] = (uint8_t)v;
+    }
+}
+
+// Deterministic "random" bytes so failures reproduce
+static uint32_t s_seed = 1;
+static void testRng(uint8_t *buf, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        s_seed = s_seed * 1103515245 + 12345;
+        buf[i] = (uint8_t)(s_seed >> 16);
+    }
+}
+
+// ============================================================
+// Crypto
+// ============================================================
+
+static void test_hmac_rfc4231() {
+    // Case 2: a short key is zero-padded, so "Jefe" in 32 bytes is the same key
+    uint8_t key[32] = { 'J', 'e', 'f', 'e' };
+    const char *data = "what do ya want for nothing?";
+    uint8_t mac[32], expected[32];
+    unhex(expected, "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843");
+    sv2_hmac_sha256(mac, key, (const uint8_t *)data, strlen(data));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, mac, 32);
+}
+
+static void test_aead_rfc8439() {
+    // Section 2.8.2
+    const char *plain = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip "
+                        "for the future, sunscreen would be it.";
+    size_t len = strlen(plain);
+    uint8_t key[32], nonce[12], ad[12], buf[160], expected[16];
+    for (int i = 0; i < 32; i++) key[i] = 0x80 + i;
+    unhex(nonce, "070000004041424344454647");
+    unhex(ad, "50515253c0c1c2c3c4c5c6c7");
+    memcpy(buf, plain, len);
+
+    sv2_aead_encrypt(key, nonce, ad, sizeof(ad), buf, len);
+    unhex(expected, "d31a8d34648e60db7b86afbc53ef7ec2");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf, 16);
+    unhex(expected, "1ae10b594f09e26a7e902ecbd0600691");
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, buf + len, 16);
+
+    TEST_ASSERT_TRUE(sv2_aead_decrypt(key, nonce, ad, sizeof(ad), buf, len + SV2_MAC_LEN));
+    TEST_ASSERT_EQUAL_MEMORY(plain, buf, len);
+
+    // Any flipped bit fails the tag and leaves the buffer alone
+    sv2_aead_encrypt(key, nonce, ad, sizeof(ad), buf, len);
+    buf[3] ^= 1;
+    TEST_ASSERT_FALSE(sv2_aead_decrypt(key, nonce, ad, sizeof(ad), buf, len + SV2_MAC_LEN));
+}
+
+static void test_schnorr_bip340() {
+    uint8_t pub[32], msg[32], sig[64];
+
+    // Vector 0
+    unhex(pub, "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9");
+    memset(msg, 0, sizeof(msg));
+    unhex(sig, "e907831f80848d1069a5371b402410364bdf1c5f8307b0084c55f1ce2dca8215"
+               "25f66a4a85ea8b71e482a74f382d2ce5ebeee8fdb2172f477df4900d310536c0");
+    TEST_ASSERT_TRUE(sv2_schnorr_verify(sig, msg, pub));
+    sig[63] ^= 1;
+    TEST_ASSERT_FALSE(sv2_schnorr_verify(sig, msg, pub));
+
+    // Vector 1
+    unhex(pub, "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659");
+    unhex(msg, "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89");
+    unhex(sig, "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de3341"
+               "8906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a");
+    TEST_ASSERT_TRUE(sv2_schnorr_verify(sig, msg, pub));
+    msg[0] ^= 1;
+    TEST_ASSERT_FALSE(sv2_schnorr_verify(sig, msg, pub));
+}
+
+static void test_ellswift_roundtrip() {
+    for (int i = 0; i < 4; i++) {
+        uint8_t priv[32], pub[SV2_ELLSWIFT_LEN], x[32], expected[32];
+        sv2_ellswift_create(priv, pub, testRng);
+        sv2_ellswift_decode(x, pub);
+        TEST_ASSERT_TRUE(sv2_xonly_pubkey(expected, priv));
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, x, 32);
+    }
+
+    // Private key 2: x of 2G
+    uint8_t priv[32] = { 0 }, x[32], expected[32];
+    priv[31] = 2;
+    unhex(expected, "c6047f9441ed7d6d3045406e95c07cd85c778e4b8cef3ca7abac09b95c709ee5");
+    TEST_ASSERT_TRUE(sv2_xonly_pubkey(x, priv));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, x, 32);
+}
+
+// ============================================================
+// Codec
+// ============================================================
+
+static uint32_t le32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void test_encode_frames() {
+    uint8_t frame[256];
+    sv2_header_t header;
+
+    sv2_submit_t submit = { 7, 42, 3, 0xdeadbeef, 0x495fab29, 0x20002000 };
+    size_t len = sv2_encode_submit_standard(frame, sizeof(frame), &submit);
+    TEST_ASSERT_EQUAL(SV2_HEADER_LEN + 24, len);
+    TEST_ASSERT_EQUAL_HEX8(0x80, frame[1]);     // Channel message bit
+    sv2_decode_header(frame, &header);
+    TEST_ASSERT_EQUAL(0, header.extension);
+    TEST_ASSERT_EQUAL_HEX8(SV2_MSG_SUBMIT_SHARES_STANDARD, header.type);
+    TEST_ASSERT_EQUAL(24, header.length);
+    TEST_ASSERT_EQUAL_HEX32(7, le32(frame + 6));
+    TEST_ASSERT_EQUAL_HEX32(42, le32(frame + 10));
+    TEST_ASSERT_EQUAL_HEX32(0xdeadbeef, le32(frame + 18));
+    TEST_ASSERT_EQUAL_HEX32(0x20002000, le32(frame + 26));
+    TEST_ASSERT_EQUAL(0, sv2_encode_submit_standard(frame, 20, &submit));
+
+    // nominal_hash_rate and max_target follow the user string
+    len = sv2_encode_open_standard_channel(frame, sizeof(frame), 9, "bc1qtest.esp", 1000.0f);
+    TEST_ASSERT_EQUAL(SV2_HEADER_LEN + 4 + 1 + 12 + 4 + 32, len);
+    TEST_ASSERT_EQUAL(12, frame[10]);
+    TEST_ASSERT_EQUAL_MEMORY("bc1qtest.esp", frame + 11, 12);
+    TEST_ASSERT_EQUAL_HEX32(0x447a0000, le32(frame + 23));
+
+    len = sv2_encode_update_channel(frame, sizeof(frame), 7, 1000.0f);
+    TEST_ASSERT_EQUAL(SV2_HEADER_LEN + 4 + 4 + 32, len);
+    sv2_decode_header(frame, &header);
+    TEST_ASSERT_EQUAL_HEX8(SV2_MSG_UPDATE_CHANNEL, header.type);
+    TEST_ASSERT_EQUAL_HEX8(0x80, frame[1]);
+    TEST_ASSERT_EQUAL_HEX32(0x447a0000, le32(frame + 10));
+
+    sv2_setup_t setup = { "pool.example", 3336, "SparkMiner", "ESP32", "1.0", "" };
+    len = sv2_encode_setup_connection(frame, sizeof(frame), &setup);
+    sv2_decode_header(frame, &header);
+    TEST_ASSERT_EQUAL(len - SV2_HEADER_LEN, header.length);
+    TEST_ASSERT_EQUAL(0, frame[6]);             // Mining Protocol
+    TEST_ASSERT_EQUAL_HEX32(SV2_SETUP_REQUIRES_STANDARD_JOBS, le32(frame + 11));
+}
+
+static void test_decode_messages() {
+    sv2_msg_t msg;
+    uint8_t p[128];
+
+    // NewMiningJob with min_ntime, then as a future job
+    memset(p, 0, sizeof(p));
+    p[0] = 5;                                   // channel_id
+    p[4] = 11;                                  // job_id
+    p[8] = 1;                                   // min_ntime present
+    p[9] = 0x29; p[10] = 0xab; p[11] = 0x5f; p[12] = 0x49;
+    p[16] = 0x20;                               // version 0x20000000
+    p[17] = 0xaa;                               // merkle_root[0]
+    TEST_ASSERT_TRUE(sv2_decode_message(SV2_MSG_NEW_MINING_JOB, p, 49, &msg));
+    TEST_ASSERT_EQUAL(5, msg.job.channelId);
+    TEST_ASSERT_EQUAL(11, msg.job.jobId);
+    TEST_ASSERT_FALSE(msg.job.future);
+    TEST_ASSERT_EQUAL_HEX32(0x495fab29, msg.job.minNtime);
+    TEST_ASSERT_EQUAL_HEX32(0x20000000, msg.job.version);
+    TEST_ASSERT_EQUAL_HEX8(0xaa, msg.job.merkleRoot[0]);
+    TEST_ASSERT_FALSE(sv2_decode_message(SV2_MSG_NEW_MINING_JOB, p, 48, &msg));
+
+    memmove(p + 9, p + 13, 36);
+    p[8] = 0;
+    TEST_ASSERT_TRUE(sv2_decode_message(SV2_MSG_NEW_MINING_JOB, p, 45, &msg));
+    TEST_ASSERT_TRUE(msg.job.future);
+    TEST_ASSERT_EQUAL_HEX32(0x20000000, msg.job.version);
+    TEST_ASSERT_EQUAL_HEX8(0xaa, msg.job.merkleRoot[0]);
+
+    // SubmitShares.Error: STR0_255 error code is cut to fit
+    memset(p, 0, sizeof(p));
+    p[0] = 5;
+    p[4] = 42;
+    p[8] = 9;
+    memcpy(p + 9, "stale-job", 9);
+    TEST_ASSERT_TRUE(sv2_decode_message(SV2_MSG_SUBMIT_SHARES_ERROR, p, 18, &msg));
+    TEST_ASSERT_EQUAL(42, msg.error.sequence);
+    TEST_ASSERT_EQUAL_STRING("stale-job", msg.error.code);
+    TEST_ASSERT_FALSE(sv2_decode_message(SV2_MSG_SUBMIT_SHARES_ERROR, p, 15, &msg));
+
+    // SubmitShares.Success
+    memset(p, 0, sizeof(p));
+    p[4] = 40;
+    p[8] = 3;
+    p[16] = 1;                                  // shares_sum high word
+    TEST_ASSERT_TRUE(sv2_decode_message(SV2_MSG_SUBMIT_SHARES_SUCCESS, p, 20, &msg));
+    TEST_ASSERT_EQUAL(40, msg.accepted.lastSequence);
+    TEST_ASSERT_EQUAL(3, msg.accepted.acceptedCount);
+    TEST_ASSERT_TRUE(msg.accepted.sharesSum == 0x100000000ULL);
+
+    TEST_ASSERT_FALSE(sv2_decode_message(0x7f, p, 20, &msg));
+}
+
+static void test_authority_key_and_target() {
+    uint8_t key[32], expected[32];
+    unhex(expected, "4df78c3f49302eef4ec3ef2daf5fa337bb63c59a2f1844664776277e9470118c");
+    TEST_ASSERT_TRUE(sv2_decode_authority_key("9bDuixKmZqAJnrmP746n8zU1wyAQRrus7th9dxnkPg6RzQvCnan", key));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, key, 32);
+    TEST_ASSERT_FALSE(sv2_decode_authority_key("9bDuixKmZqAJnrmP746n8zU1wyAQRrus7th9dxnkPg6RzQvCnam", key));
+    TEST_ASSERT_FALSE(sv2_decode_authority_key("x", key));
+    TEST_ASSERT_FALSE(sv2_decode_authority_key("", key));
+
+    // Difficulty 1 target: 0xffff << 208
+    uint8_t target[32];
+    memset(target, 0, sizeof(target));
+    target[26] = 0xff;
+    target[27] = 0xff;
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.0, sv2_target_to_difficulty(target));
+    target[26] = 0;
+    target[27] = 0;
+    target[24] = 0xff;
+    target[25] = 0xff;
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, 65536.0, sv2_target_to_difficulty(target));
+}
+
+// ============================================================
+// Noise Handshake
+// ============================================================
+
+// Responder side of Noise NX, built from the primitives
+typedef struct {
+    uint8_t ck[32];
+    uint8_t h[32];
+    uint8_t k[32];
+    uint64_t n;
+} responder_t;
+
+static void mixHash(responder_t *r, const uint8_t *data, size_t len) {
+    sv2_sha256(r->h, r->h, 32, data, len);
+}
+
+static void encryptAndHash(responder_t *r, uint8_t *buf, size_t len) {
+    uint8_t nonce[12] = { 0 };
+    for (int i = 0; i < 8; i++) nonce[4 + i] = (uint8_t)(r->n >> (8 * i));
+    r->n++;
+    sv2_aead_encrypt(r->k, nonce, r->h, 32, buf, len);
+    mixHash(r, buf, len + SV2_MAC_LEN);
+}
+
+static void respond(const uint8_t act1[SV2_NOISE_ACT1_LEN], uint8_t act2[SV2_NOISE_ACT2_LEN],
+                    sv2_cipher_t *tx, sv2_cipher_t *rx) {
+    const char *name = "Noise_NX_Secp256k1+EllSwift_ChaChaPoly_SHA256";
+    responder_t r;
+    uint8_t ePriv[32], sPriv[32], sPub[SV2_ELLSWIFT_LEN], secret[32];
+    sv2_sha256(r.h, (const uint8_t *)name, strlen(name), NULL, 0);
+    memcpy(r.ck, r.h, 32);
+    mixHash(&r, NULL, 0);
+    mixHash(&r, act1, SV2_ELLSWIFT_LEN);
+    mixHash(&r, NULL, 0);
+
+    // e, ee
+    uint8_t *e = act2;
+    sv2_ellswift_create(ePriv, e, testRng);
+    mixHash(&r, e, SV2_ELLSWIFT_LEN);
+    TEST_ASSERT_TRUE(sv2_ellswift_ecdh(secret, ePriv, act1, act1, e));
+    sv2_hkdf2(r.ck, r.k, r.ck, secret, 32);
+    r.n = 0;
+
+    // s, es
+    uint8_t *s = act2 + SV2_ELLSWIFT_LEN;
+    sv2_ellswift_create(sPriv, sPub, testRng);
+    memcpy(s, sPub, SV2_ELLSWIFT_LEN);
+    encryptAndHash(&r, s, SV2_ELLSWIFT_LEN);
+    TEST_ASSERT_TRUE(sv2_ellswift_ecdh(secret, sPriv, act1, act1, sPub));
+    sv2_hkdf2(r.ck, r.k, r.ck, secret, 32);
+    r.n = 0;
+
+    // Certificate: version 0, valid_from 1000, not_valid_after 2000, no real signature
+    uint8_t *cert = s + SV2_ELLSWIFT_LEN + SV2_MAC_LEN;
+    memset(cert, 0, SV2_CERT_LEN);
+    cert[2] = 0xe8; cert[3] = 0x03;
+    cert[6] = 0xd0; cert[7] = 0x07;
+    encryptAndHash(&r, cert, SV2_CERT_LEN);
+
+    sv2_hkdf2(rx->key, tx->key, r.ck, NULL, 0);
+    tx->nonce = rx->nonce = 0;
+}
+
+static void test_noise_handshake_and_transport() {
+    sv2_handshake_t hs;
+    sv2_cipher_t tx, rx, poolTx, poolRx;
+    uint8_t act1[SV2_NOISE_ACT1_LEN], act2[SV2_NOISE_ACT2_LEN], bad[SV2_NOISE_ACT2_LEN];
+
+    sv2_noise_start(&hs, act1, testRng);
+    respond(act1, act2, &poolTx, &poolRx);
+
+    // A corrupted reply or a certificate outside its window is refused
+    sv2_handshake_t copy = hs;
+    memcpy(bad, act2, sizeof(bad));
+    bad[SV2_NOISE_ACT2_LEN - 1] ^= 1;
+    TEST_ASSERT_EQUAL(SV2_NOISE_BAD_MESSAGE, sv2_noise_finish(&copy, bad, NULL, 0, &tx, &rx));
+    copy = hs;
+    TEST_ASSERT_EQUAL(SV2_NOISE_EXPIRED, sv2_noise_finish(&copy, act2, NULL, 2001, &tx, &rx));
+
+    TEST_ASSERT_EQUAL(SV2_NOISE_OK, sv2_noise_finish(&hs, act2, NULL, 1500, &tx, &rx));
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(poolRx.key, tx.key, 32);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(poolTx.key, rx.key, 32);
+
+    // Client -> pool: two submits, opened in order
+    uint8_t frame[64], wire[128];
+    sv2_header_t header;
+    for (uint32_t seq = 1; seq <= 2; seq++) {
+        sv2_submit_t submit = { 1, seq, 3, 0x12345678, 0x495fab29, 0x20000000 };
+        size_t len = sv2_encode_submit_standard(frame, sizeof(frame), &submit);
+        size_t sealed = sv2_noise_seal(&tx, wire, frame, len);
+        TEST_ASSERT_EQUAL(sv2_noise_frame_len(len - SV2_HEADER_LEN), sealed);
+
+        TEST_ASSERT_TRUE(sv2_noise_open_header(&poolRx, wire));
+        sv2_decode_header(wire, &header);
+        TEST_ASSERT_EQUAL(24, header.length);
+        TEST_ASSERT_TRUE(sv2_noise_open_payload(&poolRx, wire + SV2_NOISE_HEADER_LEN, header.length));
+        TEST_ASSERT_EQUAL_MEMORY(frame + SV2_HEADER_LEN, wire + SV2_NOISE_HEADER_LEN, 24);
+    }
+
+    // Pool -> client: SetTarget; a replayed frame fails on the next nonce
+    uint8_t payload[36] = { 1 };
+    payload[4 + 27] = 0xff;
+    frame[0] = 0x00; frame[1] = 0x80; frame[2] = SV2_MSG_SET_TARGET;
+    frame[3] = sizeof(payload); frame[4] = 0; frame[5] = 0;
+    memcpy(frame + SV2_HEADER_LEN, payload, sizeof(payload));
+    size_t sealed = sv2_noise_seal(&poolTx, wire, frame, SV2_HEADER_LEN + sizeof(payload));
+    uint8_t replay[128];
+    memcpy(replay, wire, sealed);
+
+    TEST_ASSERT_TRUE(sv2_noise_open_header(&rx, wire));
+    sv2_decode_header(wire, &header);
+    TEST_ASSERT_EQUAL_HEX8(SV2_MSG_SET_TARGET, header.type);
+    TEST_ASSERT_TRUE(sv2_noise_open_payload(&rx, wire + SV2_NOISE_HEADER_LEN, header.length));
+
+    sv2_msg_t msg;
+    TEST_ASSERT_TRUE(sv2_decode_message(header.type, wire + SV2_NOISE_HEADER_LEN, header.length, &msg));
+    TEST_ASSERT_EQUAL(1, msg.target.channelId);
+    TEST_ASSERT_EQUAL_HEX8(0xff, msg.target.target[27]);
+
+    TEST_ASSERT_FALSE(sv2_noise_open_header(&rx, replay));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hmac_rfc4231);
+    RUN_TEST(test_aead_rfc8439);
+    RUN_TEST(test_schnorr_bip340);
+    RUN_TEST(test_ellswift_roundtrip);
+    RUN_TEST(test_encode_frames);
+    RUN_TEST(test_decode_messages);
+    RUN_TEST(test_authority_key_and_target);
+    RUN_TEST(test_noise_handshake_and_transport);
+    return UNITY_END();
+}
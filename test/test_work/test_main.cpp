@@ -0,0 +1,232 @@
+/*
+ * SparkMiner - Job Building and Target Math Tests
+ * Runs on the host: pio test -e native
+ */
+
+#include <unity.h>
+#include <string.h>
+#include "mining/miner_sha256.h"
+#include "mining/miner_work.h"
+
+// Genesis coinbase transaction, split stratum-style around an 8-byte extranonce
+// (split inside the scriptSig)
+static const char *GENESIS_COINB1 =
+    "01000000010000000000000000000000000000000000000000000000000000000000000000ffffffff4d04ffff001d01"
+    "04455468652054696d65732030332f4a616e2f3230";
+static const char *GENESIS_EXTRANONCE1 = "30392043";
+static const uint32_t GENESIS_EXTRANONCE2 = 0x68616e63;
+static const char *GENESIS_COINB2 =
+    "656c6c6f72206f6e206272696e6b206f66207365636f6e64206261696c6f757420666f722062616e6b73ffffffff0100"
+    "f2052a01000000434104678afdb0fe5548271967f1a67130b7105cd6a828e03909a67962e0ea1f61deb649f6bc3f4cef"
+    "38c4f35504e51ec112de5c384df7ba0b8d578a4c702b6bf11d5fac00000000";
+// Genesis merkle root (= coinbase txid), internal byte order as in the header
+static const char *GENESIS_MERKLE = "3ba3edfd7a7b12b27ac72c3e67768f617fc81bc3888a51323a9fb8aa4b1e5e4a";
+
+// Block 100000: coinbase txid and its two merkle branches, internal byte order
+static const char *B100000_COINBASE = "876dd0a3ef4a2816ffd1c12ab649825a958b0ff3bb3d6f3e1250f13ddbf0148c";
+static const char *B100000_BRANCH0 = "c40297f730dd7b5a99567eb8d27b78758f607507c52292d02d4031895b52f2ff";
+static const char *B100000_BRANCH1 = "49aef42d78e3e9999c9e6ec9e1dddd6cb880bf3b076a03be1318ca789089308e";
+static const char *B100000_MERKLE = "6657a9252aacd5c0b2940996ecff952228c3067cc38d4885efb5a4ac4247e9f3";
+
+// Genesis block hash, little-endian (as the miners hold it)
+static const char *GENESIS_HASH_LE = "6fe28c0ab6f1b372c1a6a246ae63f74f931e8365e15a089c68d6190000000000";
+
+void setUp() {}
+void tearDown() {}
+
+static void test_hex_helpers() {
+    uint8_t bytes[4];
+    hexToBytes(bytes, "a1B2c3D4", 8);
+    TEST_ASSERT_EQUAL_HEX8(0xa1, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xb2, bytes[1]);
+    TEST_ASSERT_EQUAL_HEX8(0xc3, bytes[2]);
+    TEST_ASSERT_EQUAL_HEX8(0xd4, bytes[3]);
+
+    swapBytesInWords(bytes, 4);
+    TEST_ASSERT_EQUAL_HEX8(0xd4, bytes[0]);
+    TEST_ASSERT_EQUAL_HEX8(0xa1, bytes[3]);
+
+    char en2[9];
+    encodeExtraNonce(en2, 4, 0x0000abcd);
+    TEST_ASSERT_EQUAL_STRING("0000ABCD", en2);
+    encodeExtraNonce(en2, 2, 0x12345678);  // Truncated to its size
+    TEST_ASSERT_EQUAL_STRING("5678", en2);
+}
+
+static void test_bits_to_target_difficulty_one() {
+    uint8_t target[32];
+    uint8_t expected[32] = {0};
+    expected[26] = 0xff;
+    expected[27] = 0xff;
+    bits_to_target(0x1d00ffff, target);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, target, 32);
+}
+
+static void test_bits_to_target_block_125552() {
+    // 0x1a44b9f2 -> 0x44b9f2 << (8 * 23)
+    uint8_t target[32];
+    uint8_t expected[32] = {0};
+    expected[23] = 0xf2;
+    expected[24] = 0xb9;
+    expected[25] = 0x44;
+    bits_to_target(0x1a44b9f2, target);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, target, 32);
+}
+
+static void test_adjust_target_for_difficulty() {
+    uint8_t base[32], target[32];
+    bits_to_target(0x1d00ffff, base);
+
+    adjust_target_for_difficulty(target, base, 1.0);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(base, target, 32);
+
+    // Difficulty 2: 0xffff << 208 halves to 0x7fff8 << 204
+    uint8_t expected[32] = {0};
+    expected[25] = 0x80;
+    expected[26] = 0xff;
+    expected[27] = 0x7f;
+    adjust_target_for_difficulty(target, base, 2.0);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, target, 32);
+
+    // Fractional pool difficulty raises the target
+    adjust_target_for_difficulty(target, base, 0.0014);
+    TEST_ASSERT_EQUAL(0, check_target(target, base));
+}
+
+static void test_check_target() {
+    sha256_hash_t hash;
+    uint8_t target[32];
+    hexToBytes(hash.bytes, GENESIS_HASH_LE, 64);
+
+    bits_to_target(0x1d00ffff, target);
+    TEST_ASSERT_EQUAL(1, check_target(hash.bytes, target));
+    TEST_ASSERT_EQUAL(1, check_target(target, target));  // Equal counts as valid
+
+    bits_to_target(0x1a44b9f2, target);
+    TEST_ASSERT_EQUAL(0, check_target(hash.bytes, target));
+}
+
+static void test_get_difficulty() {
+    sha256_hash_t hash;
+    hexToBytes(hash.bytes, GENESIS_HASH_LE, 64);
+    TEST_ASSERT_DOUBLE_WITHIN(0.001, 2536.426298, getDifficulty(&hash));
+
+    uint8_t target[32];
+    bits_to_target(0x1d00ffff, target);
+    memcpy(hash.bytes, target, 32);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.0, getDifficulty(&hash));
+
+    memset(hash.bytes, 0, 32);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, getDifficulty(&hash));
+}
+
+static void test_genesis_coinbase_and_merkle() {
+    static mining_job_bin_t job;
+    memset(&job, 0, sizeof(job));
+    TEST_ASSERT_TRUE(decodeJobCoinbase(&job, GENESIS_COINB1, GENESIS_EXTRANONCE1, 4, GENESIS_COINB2));
+
+    miner_coinbase_t cb;
+    buildCoinbase(&cb, &job, GENESIS_EXTRANONCE2);
+    TEST_ASSERT_EQUAL(204, cb.coinbaseLen);
+    TEST_ASSERT_EQUAL(69 + 4, cb.extraNonce2Offset);
+
+    uint8_t hash[32], root[32], expected[32];
+    createCoinbaseHash(hash, &cb, GENESIS_EXTRANONCE2);
+    calculateMerkleRoot(root, hash, &cb);
+    hexToBytes(expected, GENESIS_MERKLE, 64);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, root, 32);
+
+    // A different extranonce2 must change the root
+    createCoinbaseHash(hash, &cb, GENESIS_EXTRANONCE2 + 1);
+    calculateMerkleRoot(root, hash, &cb);
+    TEST_ASSERT_TRUE(memcmp(expected, root, 32) != 0);
+}
+
+static void test_pad_coinbase() {
+    static mining_job_bin_t job;
+    memset(&job, 0, sizeof(job));
+    TEST_ASSERT_TRUE(decodeJobCoinbase(&job, GENESIS_COINB1, GENESIS_EXTRANONCE1, 4, GENESIS_COINB2));
+
+    miner_coinbase_t cb;
+    buildCoinbase(&cb, &job, GENESIS_EXTRANONCE2);
+    TEST_ASSERT_EQUAL(256, padCoinbase(&cb, GENESIS_EXTRANONCE2));
+
+    // Extranonce2 in place, then 0x80, zeros and the 1632-bit length
+    static const uint8_t en2[4] = {0x68, 0x61, 0x6e, 0x63};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(en2, &cb.coinbase[cb.extraNonce2Offset], 4);
+    TEST_ASSERT_EQUAL_HEX8(0x80, cb.coinbase[204]);
+    for (int i = 205; i < 254; i++) {
+        TEST_ASSERT_EQUAL_HEX8(0, cb.coinbase[i]);
+    }
+    TEST_ASSERT_EQUAL_HEX8(0x06, cb.coinbase[254]);
+    TEST_ASSERT_EQUAL_HEX8(0x60, cb.coinbase[255]);
+
+    // Rolls still hash the unpadded coinbase
+    uint8_t hash[32], root[32], expected[32];
+    createCoinbaseHash(hash, &cb, GENESIS_EXTRANONCE2);
+    calculateMerkleRoot(root, hash, &cb);
+    hexToBytes(expected, GENESIS_MERKLE, 64);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, root, 32);
+
+    // No room for the padding
+    cb.coinbaseLen = sizeof(cb.coinbase) - 8;
+    TEST_ASSERT_EQUAL(0, padCoinbase(&cb, 0));
+}
+
+static void test_merkle_block_100000() {
+    static mining_job_bin_t job;
+    memset(&job, 0, sizeof(job));
+    TEST_ASSERT_TRUE(decodeJobBranch(&job, B100000_BRANCH0));
+    TEST_ASSERT_TRUE(decodeJobBranch(&job, B100000_BRANCH1));
+    TEST_ASSERT_EQUAL(2, job.merkleBranchCount);
+
+    miner_coinbase_t cb;
+    buildCoinbase(&cb, &job, 0);
+
+    uint8_t coinbaseHash[32], root[32], expected[32];
+    hexToBytes(coinbaseHash, B100000_COINBASE, 64);
+    calculateMerkleRoot(root, coinbaseHash, &cb);
+    hexToBytes(expected, B100000_MERKLE, 64);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, root, 32);
+}
+
+static void test_decode_rejects_bad_notify() {
+    static mining_job_bin_t job;
+    memset(&job, 0, sizeof(job));
+
+    // Odd-length hex, extranonce2 too wide for submission, oversized coinbase
+    TEST_ASSERT_FALSE(decodeJobCoinbase(&job, "abc", "", 4, ""));
+    TEST_ASSERT_FALSE(decodeJobCoinbase(&job, "", "", 9, ""));
+    static char big[STRATUM_COINBASE_LEN * 2 + 1];
+    memset(big, 'a', STRATUM_COINBASE_LEN * 2);
+    TEST_ASSERT_TRUE(decodeJobCoinbase(&job, big, "", 0, ""));
+    TEST_ASSERT_FALSE(decodeJobCoinbase(&job, big, "00", 0, ""));
+
+    // Branches: exactly 64 hex chars, at most STRATUM_MAX_MERKLE
+    TEST_ASSERT_FALSE(decodeJobBranch(&job, "00"));
+    for (int i = 0; i < STRATUM_MAX_MERKLE; i++) {
+        TEST_ASSERT_TRUE(decodeJobBranch(&job, B100000_BRANCH0));
+    }
+    TEST_ASSERT_FALSE(decodeJobBranch(&job, B100000_BRANCH0));
+
+    // Previous hash lands in header order (bytes swapped within each word)
+    TEST_ASSERT_FALSE(decodeJobPrevHash(&job, "00"));
+    TEST_ASSERT_TRUE(decodeJobPrevHash(&job, B100000_COINBASE));
+    static const uint8_t firstWord[4] = {0xa3, 0xd0, 0x6d, 0x87};
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(firstWord, job.prevHash, 4);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_hex_helpers);
+    RUN_TEST(test_bits_to_target_difficulty_one);
+    RUN_TEST(test_bits_to_target_block_125552);
+    RUN_TEST(test_adjust_target_for_difficulty);
+    RUN_TEST(test_check_target);
+    RUN_TEST(test_get_difficulty);
+    RUN_TEST(test_genesis_coinbase_and_merkle);
+    RUN_TEST(test_pad_coinbase);
+    RUN_TEST(test_merkle_block_100000);
+    RUN_TEST(test_decode_rejects_bad_notify);
+    return UNITY_END();
+}